@@ -165,3 +165,126 @@ LOCAL_MODULE:= codec
 
 include $(BUILD_EXECUTABLE)
 
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        looperbench.cpp         \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_foundation liblog libutils
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= looperbench
+
+include $(BUILD_EXECUTABLE)
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        metadatabench.cpp       \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright libstagefright_foundation liblog libutils
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= metadatabench
+
+include $(BUILD_EXECUTABLE)
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        yuvbench.cpp            \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_yuv libstagefright_foundation liblog libutils
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= yuvbench
+
+include $(BUILD_EXECUTABLE)
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        writerbench.cpp         \
+
+LOCAL_C_INCLUDES:= \
+	$(TOP)/frameworks/av/libvideoeditor/osal/inc \
+	$(TOP)/frameworks/av/libvideoeditor/vss/3gpwriter/inc \
+	$(TOP)/frameworks/av/libvideoeditor/vss/common/inc
+
+LOCAL_STATIC_LIBRARIES := \
+	libvideoeditor_3gpwriter
+
+LOCAL_SHARED_LIBRARIES := \
+	libvideoeditor_osal libstagefright_foundation liblog libutils
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= writerbench
+
+include $(BUILD_EXECUTABLE)
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        audiocodecbench.cpp     \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright liblog libutils libbinder libstagefright_foundation \
+        libmedia libgui
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= audiocodecbench
+
+include $(BUILD_EXECUTABLE)
+
+################################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=               \
+        transcode.cpp           \
+        Transcoder.cpp          \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright liblog libutils libbinder libstagefright_foundation \
+        libmedia libgui
+
+LOCAL_C_INCLUDES:= \
+	frameworks/av/media/libstagefright \
+	$(TOP)/frameworks/native/include/media/openmax
+
+LOCAL_CFLAGS += -Wno-multichar
+
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_MODULE:= transcode
+
+include $(BUILD_EXECUTABLE)
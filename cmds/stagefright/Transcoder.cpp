@@ -0,0 +1,1207 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Transcoder"
+#include <utils/Log.h>
+
+#include "Transcoder.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <OMX_Audio.h>
+#include <OMX_IVCommon.h>
+
+#include <gui/SurfaceTextureClient.h>
+#include <media/ICrypto.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaCodec.h>
+#include <media/stagefright/MediaCodecList.h>
+#include <media/stagefright/MediaCodecPool.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/MediaSource.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/MPEG4Writer.h>
+#include <media/stagefright/NuMediaExtractor.h>
+
+namespace android {
+
+// Every codec notifies the session when it has buffers for it, the timeouts
+// only bound the wait should a notification get lost.
+static const int64_t kActivityTimeoutUs = 100000ll;
+static const int64_t kEOSReadTimeoutUs = 100000ll;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Hands the encoded buffers of one track to MPEG4Writer, which pulls them
+// from its own track thread.
+struct EncodedSource : public MediaSource {
+    EncodedSource(const sp<MetaData> &format)
+        : mFormat(format),
+          mFinalResult(OK),
+          mStopped(false),
+          mEOSRead(false) {
+    }
+
+    virtual status_t start(MetaData *params) {
+        return OK;
+    }
+
+    virtual status_t stop() {
+        Mutex::Autolock autoLock(mLock);
+        mStopped = true;
+        clearQueue_l();
+        mCondition.broadcast();
+        return OK;
+    }
+
+    virtual sp<MetaData> getFormat() {
+        return mFormat;
+    }
+
+    virtual status_t read(
+            MediaBuffer **buffer, const ReadOptions *options) {
+        *buffer = NULL;
+
+        Mutex::Autolock autoLock(mLock);
+        while (mQueue.empty() && mFinalResult == OK && !mStopped) {
+            mCondition.wait(mLock);
+        }
+
+        if (mQueue.empty()) {
+            mEOSRead = true;
+            mCondition.broadcast();
+            return mStopped ? ERROR_END_OF_STREAM : mFinalResult;
+        }
+
+        *buffer = *mQueue.begin();
+        mQueue.erase(mQueue.begin());
+        mCondition.broadcast();
+
+        return OK;
+    }
+
+    // Waits while "maxQueued" buffers are queued, 0 means no limit. Returns
+    // the time spent waiting.
+    int64_t queueBuffer(MediaBuffer *buffer, size_t maxQueued) {
+        int64_t waitedUs = 0;
+
+        Mutex::Autolock autoLock(mLock);
+        if (maxQueued > 0 && mQueue.size() >= maxQueued && !mStopped) {
+            int64_t startUs = ALooper::GetNowUs();
+            do {
+                mCondition.wait(mLock);
+            } while (mQueue.size() >= maxQueued && !mStopped);
+            waitedUs = ALooper::GetNowUs() - startUs;
+        }
+
+        if (mStopped) {
+            buffer->release();
+        } else {
+            mQueue.push_back(buffer);
+            mCondition.broadcast();
+        }
+
+        return waitedUs;
+    }
+
+    void signalEOS(status_t err) {
+        Mutex::Autolock autoLock(mLock);
+        mFinalResult = err;
+        mCondition.broadcast();
+    }
+
+    // Returns true once the reader has seen the end of the stream, false
+    // after "timeoutUs" without.
+    bool waitForEOSRead(int64_t timeoutUs) {
+        Mutex::Autolock autoLock(mLock);
+        if (!mEOSRead) {
+            mCondition.waitRelative(mLock, timeoutUs * 1000ll);
+        }
+        return mEOSRead;
+    }
+
+protected:
+    virtual ~EncodedSource() {
+        clearQueue_l();
+    }
+
+private:
+    sp<MetaData> mFormat;
+
+    Mutex mLock;
+    Condition mCondition;
+    List<MediaBuffer *> mQueue;
+    status_t mFinalResult;
+    bool mStopped;
+    bool mEOSRead;
+
+    void clearQueue_l() {
+        while (!mQueue.empty()) {
+            (*mQueue.begin())->release();
+            mQueue.erase(mQueue.begin());
+        }
+    }
+
+    DISALLOW_EVIL_CONSTRUCTORS(EncodedSource);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Bilinear scaling of one 8 bit plane, "srcStep" is 2 for the interleaved
+// chroma of semi-planar frames.
+static void scalePlane(
+        const uint8_t *src, size_t srcStride, size_t srcStep,
+        int32_t srcWidth, int32_t srcHeight,
+        uint8_t *dst, int32_t dstWidth, int32_t dstHeight) {
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (int32_t y = 0; y < dstHeight; ++y) {
+            if (srcStep == 1) {
+                memcpy(dst, src, dstWidth);
+            } else {
+                for (int32_t x = 0; x < dstWidth; ++x) {
+                    dst[x] = src[x * srcStep];
+                }
+            }
+            src += srcStride;
+            dst += dstWidth;
+        }
+        return;
+    }
+
+    // 16.16 fixed point positions, the corners map onto each other.
+    int32_t xStep = dstWidth > 1 ? ((srcWidth - 1) << 16) / (dstWidth - 1) : 0;
+    int32_t yStep = dstHeight > 1 ? ((srcHeight - 1) << 16) / (dstHeight - 1) : 0;
+
+    for (int32_t y = 0; y < dstHeight; ++y) {
+        int32_t ys = y * yStep;
+        int32_t y0 = ys >> 16;
+        int32_t y1 = y0 + 1 < srcHeight ? y0 + 1 : y0;
+        int32_t fy = (ys >> 8) & 0xff;
+
+        const uint8_t *row0 = src + y0 * srcStride;
+        const uint8_t *row1 = src + y1 * srcStride;
+
+        for (int32_t x = 0; x < dstWidth; ++x) {
+            int32_t xs = x * xStep;
+            int32_t x0 = xs >> 16;
+            int32_t x1 = x0 + 1 < srcWidth ? x0 + 1 : x0;
+            int32_t fx = (xs >> 8) & 0xff;
+
+            int32_t top = row0[x0 * srcStep] * (256 - fx) + row0[x1 * srcStep] * fx;
+            int32_t bottom = row1[x0 * srcStep] * (256 - fx) + row1[x1 * srcStep] * fx;
+
+            dst[x] = (top * (256 - fy) + bottom * fy + 32768) >> 16;
+        }
+
+        dst += dstWidth;
+    }
+}
+
+static int64_t elapsedSinceUs(int64_t startUs) {
+    return ALooper::GetNowUs() - startUs;
+}
+
+// Bit of a codec in the masks of Transcoder::ActivityHandler.
+static uint32_t codecBit(size_t trackIndex, bool encoder) {
+    return 1u << (2 * trackIndex + (encoder ? 1 : 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Target of the activity notifications of the codecs of one session, which
+// wake up the session thread.
+struct Transcoder::ActivityHandler : public AHandler {
+    ActivityHandler()
+        : mCodecs(0) {
+    }
+
+    sp<AMessage> newNotify(uint32_t codec) {
+        sp<AMessage> notify = new AMessage(kWhatActivity, id());
+        notify->setInt32("codec", codec);
+        return notify;
+    }
+
+    // Returns the codecs that notified since the last call, waits up to
+    // "timeoutUs" if there are none yet.
+    uint32_t waitForActivity(int64_t timeoutUs) {
+        Mutex::Autolock autoLock(mLock);
+        if (mCodecs == 0) {
+            mCondition.waitRelative(mLock, timeoutUs * 1000ll);
+        }
+
+        uint32_t codecs = mCodecs;
+        mCodecs = 0;
+
+        return codecs;
+    }
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        CHECK_EQ(msg->what(), (uint32_t)kWhatActivity);
+
+        int32_t codec;
+        CHECK(msg->findInt32("codec", &codec));
+
+        Mutex::Autolock autoLock(mLock);
+        mCodecs |= (uint32_t)codec;
+        mCondition.signal();
+    }
+
+private:
+    enum {
+        kWhatActivity = 'actv',
+    };
+
+    Mutex mLock;
+    Condition mCondition;
+    uint32_t mCodecs;
+
+    DISALLOW_EVIL_CONSTRUCTORS(ActivityHandler);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+TranscoderOptions::TranscoderOptions()
+    : mUseAudio(true),
+      mUseVideo(true),
+      mSoftwareOnly(true),
+      mVideoMime(MEDIA_MIMETYPE_VIDEO_AVC),
+      mAudioMime(MEDIA_MIMETYPE_AUDIO_AAC),
+      mWidth(0),
+      mHeight(0),
+      mVideoBitrate(2000000),
+      mAudioBitrate(128000),
+      mIFrameIntervalSec(1),
+      mMaxQueuedBuffers(16) {
+}
+
+TranscoderStats::TranscoderStats()
+    : mSamplesRead(0),
+      mBytesRead(0),
+      mExtractTimeUs(0),
+      mFramesDecoded(0),
+      mAudioBytesDecoded(0),
+      mFramesConverted(0),
+      mConvertTimeUs(0),
+      mFramesEncoded(0),
+      mBytesEncoded(0),
+      mWriterStallUs(0),
+      mElapsedUs(0) {
+}
+
+void TranscoderStats::add(const TranscoderStats &other) {
+    mSamplesRead += other.mSamplesRead;
+    mBytesRead += other.mBytesRead;
+    mExtractTimeUs += other.mExtractTimeUs;
+    mFramesDecoded += other.mFramesDecoded;
+    mAudioBytesDecoded += other.mAudioBytesDecoded;
+    mFramesConverted += other.mFramesConverted;
+    mConvertTimeUs += other.mConvertTimeUs;
+    mFramesEncoded += other.mFramesEncoded;
+    mBytesEncoded += other.mBytesEncoded;
+    mWriterStallUs += other.mWriterStallUs;
+    mElapsedUs += other.mElapsedUs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Transcoder::Transcoder(
+        const sp<ALooper> &looper,
+        const char *inputPath,
+        const char *outputPath,
+        const TranscoderOptions &options)
+    : mLooper(looper),
+      mInputPath(inputPath),
+      mOutputPath(outputPath),
+      mOptions(options),
+      mWriterStarted(false) {
+}
+
+Transcoder::~Transcoder() {
+    release();
+}
+
+status_t Transcoder::run() {
+    int64_t startUs = ALooper::GetNowUs();
+
+    status_t err = setup();
+
+    while (err == OK) {
+        bool progress = false;
+
+        err = feedDecoders(&progress);
+
+        for (size_t i = 0; err == OK && i < mTracks.size(); ++i) {
+            TrackState *state = &mTracks.editValueAt(i);
+
+            err = drainDecoder(state, &progress);
+            if (err == OK) {
+                err = feedEncoder(state, &progress);
+            }
+            if (err == OK) {
+                err = drainEncoder(state, &progress);
+            }
+        }
+
+        bool done = true;
+        for (size_t i = 0; i < mTracks.size(); ++i) {
+            if (!mTracks.valueAt(i).mSawEncoderEOS) {
+                done = false;
+                break;
+            }
+        }
+
+        if (done) {
+            break;
+        }
+
+        if (!progress) {
+            waitForActivity();
+        }
+    }
+
+    if (err == OK && mWriterStarted) {
+        // The writer drops what its track threads have not read when it
+        // stops. A track thread that gave up early counts as at EOS.
+        for (size_t i = 0; i < mTracks.size(); ++i) {
+            const sp<EncodedSource> &output = mTracks.valueAt(i).mOutput;
+            while (!output->waitForEOSRead(kEOSReadTimeoutUs)
+                    && !mWriter->reachedEOS()) {
+            }
+        }
+    }
+
+    if (err != OK) {
+        // The writer joins its track threads before it stops their sources,
+        // they have to see the end of their stream first.
+        for (size_t i = 0; i < mTracks.size(); ++i) {
+            const TrackState &state = mTracks.valueAt(i);
+            if (state.mOutput != NULL) {
+                state.mOutput->signalEOS(err);
+            }
+        }
+    }
+
+    if (mWriterStarted) {
+        status_t writerErr = mWriter->stop();
+        if (err == OK) {
+            err = writerErr;
+        }
+        mWriterStarted = false;
+    }
+
+    mStats.mElapsedUs = elapsedSinceUs(startUs);
+
+    release();
+
+    if (err != OK) {
+        ALOGE("transcoding '%s' failed (%d)", mInputPath.c_str(), err);
+    }
+
+    return err;
+}
+
+status_t Transcoder::setup() {
+    mActivityHandler = new ActivityHandler;
+    mLooper->registerHandler(mActivityHandler);
+
+    mExtractor = new NuMediaExtractor;
+
+    status_t err = mExtractor->setDataSource(mInputPath.c_str());
+    if (err != OK) {
+        ALOGE("unable to instantiate extractor for '%s'", mInputPath.c_str());
+        return err;
+    }
+
+    bool haveAudio = false;
+    bool haveVideo = false;
+    for (size_t i = 0; i < mExtractor->countTracks(); ++i) {
+        sp<AMessage> format;
+        err = mExtractor->getTrackFormat(i, &format);
+        if (err != OK) {
+            return err;
+        }
+
+        AString mime;
+        CHECK(format->findString("mime", &mime));
+
+        bool isAudio = !strncasecmp(mime.c_str(), "audio/", 6);
+        bool isVideo = !strncasecmp(mime.c_str(), "video/", 6);
+
+        if (mOptions.mUseAudio && !haveAudio && isAudio) {
+            haveAudio = true;
+        } else if (mOptions.mUseVideo && !haveVideo && isVideo) {
+            haveVideo = true;
+        } else {
+            continue;
+        }
+
+        err = mExtractor->selectTrack(i);
+        if (err != OK) {
+            return err;
+        }
+
+        TrackState *state = &mTracks.editValueAt(mTracks.add(i, TrackState()));
+        state->mIsAudio = isAudio;
+        state->mSourceFormat = format;
+        state->mSignalledInputEOS = false;
+        state->mSawDecoderEOS = false;
+        state->mSignalledEncoderEOS = false;
+        state->mSawEncoderEOS = false;
+        state->mDecoderNotifyPending = false;
+        state->mEncoderNotifyPending = false;
+
+        state->mDecoder = createCodec(mime.c_str(), false /* encoder */);
+        if (state->mDecoder == NULL) {
+            ALOGE("no decoder for '%s'", mime.c_str());
+            return ERROR_UNSUPPORTED;
+        }
+
+        err = state->mDecoder->configure(
+                format, NULL /* surface */, NULL /* crypto */, 0 /* flags */);
+        if (err == OK) {
+            err = state->mDecoder->start();
+        }
+        if (err == OK) {
+            err = state->mDecoder->getInputBuffers(&state->mDecoderInBuffers);
+        }
+        if (err == OK) {
+            err = state->mDecoder->getOutputBuffers(&state->mDecoderOutBuffers);
+        }
+        if (err != OK) {
+            return err;
+        }
+    }
+
+    if (mTracks.isEmpty()) {
+        ALOGE("no track to transcode in '%s'", mInputPath.c_str());
+        return ERROR_UNSUPPORTED;
+    }
+
+    int fd = open(mOutputPath.c_str(), O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        ALOGE("unable to create '%s'", mOutputPath.c_str());
+        return -errno;
+    }
+
+    mWriter = new MPEG4Writer(fd);
+    close(fd);
+
+    return OK;
+}
+
+sp<MediaCodec> Transcoder::createCodec(const char *mime, bool encoder) {
+    if (!mOptions.mSoftwareOnly) {
+        return MediaCodecPool::CreateByType(mLooper, mime, encoder);
+    }
+
+    const MediaCodecList *list = MediaCodecList::getInstance();
+
+    ssize_t index = -1;
+    while ((index = list->findCodecByType(mime, encoder, index + 1)) >= 0) {
+        const char *name = list->getCodecName(index);
+
+        if (!strncmp(name, "OMX.google.", 11)) {
+            return MediaCodecPool::CreateByComponentName(mLooper, name);
+        }
+    }
+
+    return NULL;
+}
+
+status_t Transcoder::configureEncoder(
+        TrackState *state, const sp<AMessage> &format) {
+    sp<AMessage> encoderFormat = new AMessage;
+    sp<MetaData> meta = new MetaData;
+
+    if (state->mIsAudio) {
+        if (!format->findInt32("sample-rate", &state->mSampleRate)
+                || !format->findInt32("channel-count", &state->mChannelCount)) {
+            return ERROR_MALFORMED;
+        }
+
+        encoderFormat->setString("mime", mOptions.mAudioMime.c_str());
+        encoderFormat->setInt32("sample-rate", state->mSampleRate);
+        encoderFormat->setInt32("channel-count", state->mChannelCount);
+        encoderFormat->setInt32("bitrate", mOptions.mAudioBitrate);
+        if (!strcasecmp(mOptions.mAudioMime.c_str(), MEDIA_MIMETYPE_AUDIO_AAC)) {
+            encoderFormat->setInt32("aac-profile", OMX_AUDIO_AACObjectLC);
+        }
+
+        meta->setCString(kKeyMIMEType, mOptions.mAudioMime.c_str());
+        meta->setInt32(kKeySampleRate, state->mSampleRate);
+        meta->setInt32(kKeyChannelCount, state->mChannelCount);
+        meta->setInt32(kKeyBitRate, mOptions.mAudioBitrate);
+    } else {
+        if (!format->findInt32("color-format", &state->mColorFormat)
+                || !format->findInt32("width", &state->mWidth)
+                || !format->findInt32("height", &state->mHeight)) {
+            return ERROR_MALFORMED;
+        }
+
+        if (state->mColorFormat != OMX_COLOR_FormatYUV420Planar
+                && state->mColorFormat != OMX_COLOR_FormatYUV420SemiPlanar) {
+            ALOGE("unsupported decoder color format %d", state->mColorFormat);
+            return ERROR_UNSUPPORTED;
+        }
+
+        if (!format->findInt32("stride", &state->mStride)
+                || state->mStride < state->mWidth) {
+            state->mStride = state->mWidth;
+        }
+        if (!format->findInt32("slice-height", &state->mSliceHeight)
+                || state->mSliceHeight < state->mHeight) {
+            state->mSliceHeight = state->mHeight;
+        }
+
+        state->mOutWidth = (mOptions.mWidth > 0 ? mOptions.mWidth : state->mWidth) & ~1;
+        state->mOutHeight = (mOptions.mHeight > 0 ? mOptions.mHeight : state->mHeight) & ~1;
+
+        int32_t frameRate;
+        if (!state->mSourceFormat->findInt32("frame-rate", &frameRate)) {
+            frameRate = 30;
+        }
+
+        encoderFormat->setString("mime", mOptions.mVideoMime.c_str());
+        encoderFormat->setInt32("width", state->mOutWidth);
+        encoderFormat->setInt32("height", state->mOutHeight);
+        encoderFormat->setInt32("color-format", OMX_COLOR_FormatYUV420Planar);
+        encoderFormat->setInt32("bitrate", mOptions.mVideoBitrate);
+        encoderFormat->setInt32("frame-rate", frameRate);
+        encoderFormat->setInt32("i-frame-interval", mOptions.mIFrameIntervalSec);
+
+        meta->setCString(kKeyMIMEType, mOptions.mVideoMime.c_str());
+        meta->setInt32(kKeyWidth, state->mOutWidth);
+        meta->setInt32(kKeyHeight, state->mOutHeight);
+        meta->setInt32(kKeyFrameRate, frameRate);
+        meta->setInt32(kKeyBitRate, mOptions.mVideoBitrate);
+    }
+
+    AString mime;
+    CHECK(encoderFormat->findString("mime", &mime));
+
+    state->mEncoder = createCodec(mime.c_str(), true /* encoder */);
+    if (state->mEncoder == NULL) {
+        ALOGE("no encoder for '%s'", mime.c_str());
+        return ERROR_UNSUPPORTED;
+    }
+
+    status_t err = state->mEncoder->configure(
+            encoderFormat, NULL /* surface */, NULL /* crypto */,
+            MediaCodec::CONFIGURE_FLAG_ENCODE);
+    if (err == OK) {
+        err = state->mEncoder->start();
+    }
+    if (err == OK) {
+        err = state->mEncoder->getInputBuffers(&state->mEncoderInBuffers);
+    }
+    if (err == OK) {
+        err = state->mEncoder->getOutputBuffers(&state->mEncoderOutBuffers);
+    }
+    if (err != OK) {
+        return err;
+    }
+
+    state->mOutput = new EncodedSource(meta);
+
+    err = mWriter->addSource(state->mOutput);
+    if (err != OK) {
+        return err;
+    }
+
+    return startWriterIfReady();
+}
+
+// MPEG4Writer needs all of its tracks before it starts, which is once every
+// decoder has reported its output format.
+status_t Transcoder::startWriterIfReady() {
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        if (mTracks.valueAt(i).mOutput == NULL) {
+            return OK;
+        }
+    }
+
+    sp<MetaData> params = new MetaData;
+    params->setInt32(kKeyNotRealTime, true);
+
+    status_t err = mWriter->start(params.get());
+    if (err == OK) {
+        mWriterStarted = true;
+    }
+
+    return err;
+}
+
+status_t Transcoder::dequeueInputBuffers(
+        const sp<MediaCodec> &codec, List<size_t> *indices) {
+    for (;;) {
+        size_t index;
+        status_t err = codec->dequeueInputBuffer(&index);
+        if (err == -EAGAIN) {
+            return OK;
+        } else if (err != OK) {
+            return err;
+        }
+
+        indices->push_back(index);
+    }
+}
+
+status_t Transcoder::feedDecoders(bool *progress) {
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        TrackState *state = &mTracks.editValueAt(i);
+
+        // Also after the input EOS, the decoder keeps notifying as long as
+        // it has input buffers available.
+        if (!state->mSawDecoderEOS) {
+            status_t err = dequeueInputBuffers(
+                    state->mDecoder, &state->mDecoderInIndices);
+            if (err != OK) {
+                return err;
+            }
+        }
+    }
+
+    for (;;) {
+        size_t trackIndex;
+        status_t err = mExtractor->getSampleTrackIndex(&trackIndex);
+
+        if (err != OK) {
+            for (size_t i = 0; i < mTracks.size(); ++i) {
+                TrackState *state = &mTracks.editValueAt(i);
+
+                if (state->mSignalledInputEOS
+                        || state->mDecoderInIndices.empty()) {
+                    continue;
+                }
+
+                size_t index = *state->mDecoderInIndices.begin();
+                state->mDecoderInIndices.erase(state->mDecoderInIndices.begin());
+
+                err = state->mDecoder->queueInputBuffer(
+                        index, 0 /* offset */, 0 /* size */, 0ll /* timeUs */,
+                        MediaCodec::BUFFER_FLAG_EOS);
+                if (err != OK) {
+                    return err;
+                }
+
+                state->mSignalledInputEOS = true;
+                *progress = true;
+            }
+
+            return OK;
+        }
+
+        TrackState *state = &mTracks.editValueFor(trackIndex);
+
+        if (state->mDecoderInIndices.empty()) {
+            return OK;
+        }
+
+        size_t index = *state->mDecoderInIndices.begin();
+        state->mDecoderInIndices.erase(state->mDecoderInIndices.begin());
+
+        const sp<ABuffer> &buffer = state->mDecoderInBuffers.itemAt(index);
+
+        int64_t startUs = ALooper::GetNowUs();
+
+        int64_t timeUs;
+        err = mExtractor->readSampleData(buffer);
+        if (err == OK) {
+            err = mExtractor->getSampleTime(&timeUs);
+        }
+        if (err != OK) {
+            return err;
+        }
+
+        ++mStats.mSamplesRead;
+        mStats.mBytesRead += buffer->size();
+
+        err = state->mDecoder->queueInputBuffer(
+                index, 0 /* offset */, buffer->size(), timeUs, 0 /* flags */);
+        if (err != OK) {
+            return err;
+        }
+
+        mExtractor->advance();
+
+        mStats.mExtractTimeUs += elapsedSinceUs(startUs);
+        *progress = true;
+    }
+}
+
+status_t Transcoder::drainDecoder(TrackState *state, bool *progress) {
+    while (!state->mSawDecoderEOS) {
+        DecodedBuffer decoded;
+        status_t err = state->mDecoder->dequeueOutputBuffer(
+                &decoded.mIndex, &decoded.mOffset, &decoded.mSize,
+                &decoded.mTimeUs, &decoded.mFlags);
+
+        if (err == -EAGAIN) {
+            return OK;
+        } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            // Only happens once all buffers of the old set were released.
+            err = state->mDecoder->getOutputBuffers(&state->mDecoderOutBuffers);
+        } else if (err == INFO_FORMAT_CHANGED) {
+            sp<AMessage> format;
+            err = state->mDecoder->getOutputFormat(&format);
+
+            if (err == OK && state->mEncoder == NULL) {
+                err = configureEncoder(state, format);
+            } else if (err == OK && !state->mIsAudio) {
+                // Applies to the buffers decoded after it.
+                decoded.mFormat = format;
+                state->mDecodedBuffers.push_back(decoded);
+            }
+        } else if (err == OK) {
+            if (decoded.mFlags & MediaCodec::BUFFER_FLAG_EOS) {
+                state->mSawDecoderEOS = true;
+            }
+
+            if (decoded.mSize > 0) {
+                if (state->mIsAudio) {
+                    mStats.mAudioBytesDecoded += decoded.mSize;
+                } else {
+                    ++mStats.mFramesDecoded;
+                }
+            }
+
+            if (state->mEncoder == NULL) {
+                // Nothing was decoded at all.
+                err = state->mDecoder->releaseOutputBuffer(decoded.mIndex);
+                state->mSawEncoderEOS = true;
+            } else {
+                state->mDecodedBuffers.push_back(decoded);
+            }
+        }
+
+        if (err != OK) {
+            return err;
+        }
+
+        *progress = true;
+    }
+
+    return OK;
+}
+
+// Later size changes are scaled to the initial output size.
+void Transcoder::setDecodedFormat(
+        TrackState *state, const sp<AMessage> &format) {
+    format->findInt32("width", &state->mWidth);
+    format->findInt32("height", &state->mHeight);
+    if (!format->findInt32("stride", &state->mStride)
+            || state->mStride < state->mWidth) {
+        state->mStride = state->mWidth;
+    }
+    if (!format->findInt32("slice-height", &state->mSliceHeight)
+            || state->mSliceHeight < state->mHeight) {
+        state->mSliceHeight = state->mHeight;
+    }
+}
+
+status_t Transcoder::feedEncoder(TrackState *state, bool *progress) {
+    if (state->mEncoder == NULL || state->mSawEncoderEOS) {
+        return OK;
+    }
+
+    status_t err = dequeueInputBuffers(
+            state->mEncoder, &state->mEncoderInIndices);
+    if (err != OK) {
+        return err;
+    }
+
+    while (!state->mDecodedBuffers.empty()) {
+        DecodedBuffer *decoded = &*state->mDecodedBuffers.begin();
+
+        if (decoded->mFormat != NULL) {
+            setDecodedFormat(state, decoded->mFormat);
+            state->mDecodedBuffers.erase(state->mDecodedBuffers.begin());
+            *progress = true;
+            continue;
+        }
+
+        if (state->mEncoderInIndices.empty()) {
+            return OK;
+        }
+
+        size_t index = *state->mEncoderInIndices.begin();
+        state->mEncoderInIndices.erase(state->mEncoderInIndices.begin());
+
+        const sp<ABuffer> &src = state->mDecoderOutBuffers.itemAt(decoded->mIndex);
+        const sp<ABuffer> &dst = state->mEncoderInBuffers.itemAt(index);
+
+        size_t size = 0;
+        int64_t timeUs = decoded->mTimeUs;
+        bool last = true;
+
+        if (decoded->mSize == 0) {
+            // An empty buffer, only the EOS flag is passed on.
+        } else if (state->mIsAudio) {
+            size = decoded->mSize;
+            if (size > dst->capacity()) {
+                size_t frameSize = state->mChannelCount * sizeof(int16_t);
+                size = (dst->capacity() / frameSize) * frameSize;
+                last = false;
+            }
+
+            memcpy(dst->base(), src->base() + decoded->mOffset, size);
+
+            decoded->mOffset += size;
+            decoded->mSize -= size;
+            decoded->mTimeUs +=
+                (size / (state->mChannelCount * sizeof(int16_t))) * 1000000ll
+                    / state->mSampleRate;
+        } else {
+            int64_t startUs = ALooper::GetNowUs();
+
+            src->setRange(decoded->mOffset, decoded->mSize);
+            convertFrame(state, src, dst);
+            size = dst->size();
+
+            mStats.mConvertTimeUs += elapsedSinceUs(startUs);
+            ++mStats.mFramesConverted;
+        }
+
+        uint32_t flags = 0;
+        if (last && (decoded->mFlags & MediaCodec::BUFFER_FLAG_EOS)) {
+            flags |= MediaCodec::BUFFER_FLAG_EOS;
+            state->mSignalledEncoderEOS = true;
+        }
+
+        err = state->mEncoder->queueInputBuffer(
+                index, 0 /* offset */, size, timeUs, flags);
+        if (err != OK) {
+            return err;
+        }
+
+        if (last) {
+            err = state->mDecoder->releaseOutputBuffer(decoded->mIndex);
+            state->mDecodedBuffers.erase(state->mDecodedBuffers.begin());
+            if (err != OK) {
+                return err;
+            }
+        }
+
+        *progress = true;
+    }
+
+    return OK;
+}
+
+status_t Transcoder::drainEncoder(TrackState *state, bool *progress) {
+    while (state->mEncoder != NULL && !state->mSawEncoderEOS) {
+        size_t index;
+        size_t offset;
+        size_t size;
+        int64_t timeUs;
+        uint32_t flags;
+        status_t err = state->mEncoder->dequeueOutputBuffer(
+                &index, &offset, &size, &timeUs, &flags);
+
+        if (err == -EAGAIN) {
+            return OK;
+        } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            err = state->mEncoder->getOutputBuffers(&state->mEncoderOutBuffers);
+        } else if (err == INFO_FORMAT_CHANGED) {
+            // The codec specific data also arrives as a buffer.
+        } else if (err == OK) {
+            if (size > 0) {
+                const sp<ABuffer> &buffer = state->mEncoderOutBuffers.itemAt(index);
+                const uint8_t *data = buffer->base() + offset;
+
+                // The software AVC encoder emits frames as bare NAL units,
+                // which the writer would store as if they were already
+                // length prefixed. Give them the start code it expects.
+                static const uint8_t kStartCode[4] = { 0x00, 0x00, 0x00, 0x01 };
+                size_t prefixSize = 0;
+                if (!state->mIsAudio
+                        && !strcasecmp(mOptions.mVideoMime.c_str(),
+                                       MEDIA_MIMETYPE_VIDEO_AVC)
+                        && (size < 4 || memcmp(data, kStartCode, 4))) {
+                    prefixSize = sizeof(kStartCode);
+                }
+
+                MediaBuffer *mbuf = new MediaBuffer(prefixSize + size);
+                memcpy(mbuf->data(), kStartCode, prefixSize);
+                memcpy((uint8_t *)mbuf->data() + prefixSize, data, size);
+
+                sp<MetaData> meta = mbuf->meta_data();
+                meta->setInt64(kKeyTime, timeUs);
+                if (!state->mIsAudio) {
+                    // The encoders are configured without B frames, so
+                    // buffers come out in presentation order.
+                    meta->setInt64(kKeyDecodingTime, timeUs);
+                }
+                if (flags & MediaCodec::BUFFER_FLAG_SYNCFRAME) {
+                    meta->setInt32(kKeyIsSyncFrame, true);
+                }
+                if (flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) {
+                    meta->setInt32(kKeyIsCodecConfig, true);
+                } else {
+                    ++mStats.mFramesEncoded;
+                    mStats.mBytesEncoded += size;
+                }
+
+                // Before the writer runs, the buffers of the track that
+                // reported its format first have to wait for the others.
+                mStats.mWriterStallUs += state->mOutput->queueBuffer(
+                        mbuf, mWriterStarted ? mOptions.mMaxQueuedBuffers : 0);
+            }
+
+            err = state->mEncoder->releaseOutputBuffer(index);
+
+            if (flags & MediaCodec::BUFFER_FLAG_EOS) {
+                state->mSawEncoderEOS = true;
+                state->mOutput->signalEOS(ERROR_END_OF_STREAM);
+            }
+        }
+
+        if (err != OK) {
+            return err;
+        }
+
+        *progress = true;
+    }
+
+    return OK;
+}
+
+// Crops, scales and converts a decoded YUV420 planar or semi-planar frame to
+// the planar frame the encoder expects.
+void Transcoder::convertFrame(
+        TrackState *state, const sp<ABuffer> &src, const sp<ABuffer> &dst) {
+    int32_t outWidth = state->mOutWidth;
+    int32_t outHeight = state->mOutHeight;
+    size_t lumaSize = outWidth * outHeight;
+    size_t chromaSize = (outWidth / 2) * (outHeight / 2);
+
+    CHECK_LE(lumaSize + 2 * chromaSize, dst->capacity());
+
+    const uint8_t *srcY = src->data();
+    const uint8_t *srcU;
+    const uint8_t *srcV;
+    size_t chromaStride;
+    size_t chromaStep;
+
+    if (state->mColorFormat == OMX_COLOR_FormatYUV420Planar) {
+        srcU = srcY + state->mStride * state->mSliceHeight;
+        srcV = srcU + (state->mStride / 2) * (state->mSliceHeight / 2);
+        chromaStride = state->mStride / 2;
+        chromaStep = 1;
+    } else {
+        srcU = srcY + state->mStride * state->mSliceHeight;
+        srcV = srcU + 1;
+        chromaStride = state->mStride;
+        chromaStep = 2;
+    }
+
+    uint8_t *dstY = dst->base();
+    uint8_t *dstU = dstY + lumaSize;
+    uint8_t *dstV = dstU + chromaSize;
+
+    scalePlane(srcY, state->mStride, 1, state->mWidth, state->mHeight,
+               dstY, outWidth, outHeight);
+    scalePlane(srcU, chromaStride, chromaStep, state->mWidth / 2, state->mHeight / 2,
+               dstU, outWidth / 2, outHeight / 2);
+    scalePlane(srcV, chromaStride, chromaStep, state->mWidth / 2, state->mHeight / 2,
+               dstV, outWidth / 2, outHeight / 2);
+
+    dst->setRange(0, lumaSize + 2 * chromaSize);
+}
+
+// Asks every codec that still has work for the session to notify it once
+// it has buffers for it, and waits for the first one that does.
+void Transcoder::waitForActivity() {
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        TrackState *state = &mTracks.editValueAt(i);
+
+        if (!state->mSawDecoderEOS && !state->mDecoderNotifyPending) {
+            state->mDecoder->requestActivityNotification(
+                    mActivityHandler->newNotify(codecBit(i, false)));
+            state->mDecoderNotifyPending = true;
+        }
+
+        if (state->mEncoder != NULL && !state->mSawEncoderEOS
+                && !state->mEncoderNotifyPending) {
+            state->mEncoder->requestActivityNotification(
+                    mActivityHandler->newNotify(codecBit(i, true)));
+            state->mEncoderNotifyPending = true;
+        }
+    }
+
+    uint32_t codecs = mActivityHandler->waitForActivity(kActivityTimeoutUs);
+
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        TrackState *state = &mTracks.editValueAt(i);
+
+        if (codecs & codecBit(i, false)) {
+            state->mDecoderNotifyPending = false;
+        }
+        if (codecs & codecBit(i, true)) {
+            state->mEncoderNotifyPending = false;
+        }
+    }
+}
+
+void Transcoder::release() {
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        TrackState *state = &mTracks.editValueAt(i);
+
+        // The codecs are kept for the next file, which saves allocating
+        // the components again.
+        if (state->mDecoder != NULL) {
+            MediaCodecPool::Recycle(state->mDecoder);
+            state->mDecoder.clear();
+        }
+
+        if (state->mEncoder != NULL) {
+            MediaCodecPool::Recycle(state->mEncoder);
+            state->mEncoder.clear();
+        }
+
+        if (state->mOutput != NULL) {
+            state->mOutput->signalEOS(ERROR_END_OF_STREAM);
+        }
+    }
+
+    mTracks.clear();
+    mExtractor.clear();
+    mWriter.clear();
+
+    // Stopping the codecs dropped the notifications still requested, one
+    // already posted is dropped by the looper.
+    if (mActivityHandler != NULL) {
+        mLooper->unregisterHandler(mActivityHandler->id());
+        mActivityHandler.clear();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct TranscodeEngine::Worker : public Thread {
+    Worker(TranscodeEngine *engine, const sp<ALooper> &looper)
+        : Thread(false /* canCallJava */),
+          mEngine(engine),
+          mLooper(looper) {
+    }
+
+protected:
+    virtual bool threadLoop() {
+        Job job;
+        if (!mEngine->dequeueJob(&job)) {
+            return false;
+        }
+
+        sp<Transcoder> transcoder = new Transcoder(
+                mLooper,
+                job.mInputPath.c_str(),
+                job.mOutputPath.c_str(),
+                mEngine->mOptions);
+
+        Result result;
+        result.mInputPath = job.mInputPath;
+        result.mOutputPath = job.mOutputPath;
+        result.mStatus = transcoder->run();
+        result.mStats = transcoder->stats();
+
+        mEngine->addResult(result);
+
+        return true;
+    }
+
+private:
+    TranscodeEngine *mEngine;
+    sp<ALooper> mLooper;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Worker);
+};
+
+TranscodeEngine::TranscodeEngine(
+        size_t numWorkers, const TranscoderOptions &options)
+    : mNumWorkers(numWorkers > 0 ? numWorkers : 1),
+      mOptions(options) {
+}
+
+TranscodeEngine::~TranscodeEngine() {
+    for (size_t i = 0; i < mLoopers.size(); ++i) {
+        mLoopers.editItemAt(i)->stop();
+    }
+}
+
+void TranscodeEngine::addJob(const char *inputPath, const char *outputPath) {
+    Job job;
+    job.mInputPath = inputPath;
+    job.mOutputPath = outputPath;
+
+    Mutex::Autolock autoLock(mLock);
+    mJobs.push_back(job);
+}
+
+void TranscodeEngine::run() {
+    size_t numWorkers;
+    {
+        Mutex::Autolock autoLock(mLock);
+        numWorkers = mJobs.size() < mNumWorkers ? mJobs.size() : mNumWorkers;
+    }
+
+    while (mLoopers.size() < numWorkers) {
+        sp<ALooper> looper = new ALooper;
+        looper->setName("transcode");
+        looper->start();
+        mLoopers.push(looper);
+    }
+
+    Vector<sp<Worker> > workers;
+    for (size_t i = 0; i < numWorkers; ++i) {
+        sp<Worker> worker = new Worker(this, mLoopers.itemAt(i));
+        worker->run("TranscodeWorker");
+        workers.push(worker);
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers.editItemAt(i)->join();
+    }
+}
+
+bool TranscodeEngine::dequeueJob(Job *job) {
+    Mutex::Autolock autoLock(mLock);
+    if (mJobs.empty()) {
+        return false;
+    }
+
+    *job = *mJobs.begin();
+    mJobs.erase(mJobs.begin());
+
+    return true;
+}
+
+void TranscodeEngine::addResult(const Result &result) {
+    Mutex::Autolock autoLock(mLock);
+    mResults.push(result);
+}
+
+}  // namespace android
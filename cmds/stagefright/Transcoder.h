@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRANSCODER_H_
+
+#define TRANSCODER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/KeyedVector.h>
+#include <utils/List.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+struct ABuffer;
+struct ALooper;
+struct AMessage;
+struct EncodedSource;
+struct MediaCodec;
+class MPEG4Writer;
+struct NuMediaExtractor;
+
+struct TranscoderOptions {
+    TranscoderOptions();
+
+    bool mUseAudio;
+    bool mUseVideo;
+
+    // Only use the OMX.google.* software components.
+    bool mSoftwareOnly;
+
+    AString mVideoMime;
+    AString mAudioMime;
+
+    // Output size, 0 keeps the size of the decoded video.
+    int32_t mWidth;
+    int32_t mHeight;
+
+    int32_t mVideoBitrate;
+    int32_t mAudioBitrate;
+    int32_t mIFrameIntervalSec;
+
+    // Encoded buffers that may wait for the writer per track.
+    size_t mMaxQueuedBuffers;
+};
+
+// Throughput of one transcoding session, times are in microseconds.
+struct TranscoderStats {
+    TranscoderStats();
+
+    int64_t mSamplesRead;
+    int64_t mBytesRead;
+    int64_t mExtractTimeUs;
+
+    int64_t mFramesDecoded;
+    int64_t mAudioBytesDecoded;
+
+    int64_t mFramesConverted;
+    int64_t mConvertTimeUs;
+
+    int64_t mFramesEncoded;
+    int64_t mBytesEncoded;
+
+    // Time the session thread waited for the writer to catch up.
+    int64_t mWriterStallUs;
+
+    int64_t mElapsedUs;
+
+    void add(const TranscoderStats &other);
+};
+
+// Transcodes one file: extractor -> MediaCodec decoder -> scaling and color
+// conversion -> MediaCodec encoder -> MPEG4Writer. run() drives all codecs
+// synchronously on the calling thread, "looper" runs the codecs' handlers and
+// should not be shared with other sessions.
+struct Transcoder : public RefBase {
+    Transcoder(
+            const sp<ALooper> &looper,
+            const char *inputPath,
+            const char *outputPath,
+            const TranscoderOptions &options);
+
+    status_t run();
+
+    const AString &inputPath() const { return mInputPath; }
+    const AString &outputPath() const { return mOutputPath; }
+    const TranscoderStats &stats() const { return mStats; }
+
+protected:
+    virtual ~Transcoder();
+
+private:
+    struct ActivityHandler;
+
+    // Output buffer of a decoder, or a change of its output format, not yet
+    // (completely) passed to the encoder.
+    struct DecodedBuffer {
+        size_t mIndex;
+        size_t mOffset;
+        size_t mSize;
+        int64_t mTimeUs;
+        uint32_t mFlags;
+
+        // Set for a format change, which comes without a buffer.
+        sp<AMessage> mFormat;
+    };
+
+    // The session dequeues every buffer a codec makes available as soon as
+    // it can, so that an activity notification of the codec always means
+    // there is something new to do.
+    struct TrackState {
+        bool mIsAudio;
+        sp<AMessage> mSourceFormat;
+
+        sp<MediaCodec> mDecoder;
+        Vector<sp<ABuffer> > mDecoderInBuffers;
+        Vector<sp<ABuffer> > mDecoderOutBuffers;
+        List<size_t> mDecoderInIndices;
+        List<DecodedBuffer> mDecodedBuffers;
+        bool mSignalledInputEOS;
+        bool mSawDecoderEOS;
+
+        sp<MediaCodec> mEncoder;
+        Vector<sp<ABuffer> > mEncoderInBuffers;
+        Vector<sp<ABuffer> > mEncoderOutBuffers;
+        List<size_t> mEncoderInIndices;
+        bool mSignalledEncoderEOS;
+        bool mSawEncoderEOS;
+
+        // An activity notification was requested and has not arrived yet.
+        bool mDecoderNotifyPending;
+        bool mEncoderNotifyPending;
+
+        // Layout of the decoded video.
+        int32_t mColorFormat;
+        int32_t mWidth;
+        int32_t mHeight;
+        int32_t mStride;
+        int32_t mSliceHeight;
+
+        // Encoded video size or audio format.
+        int32_t mOutWidth;
+        int32_t mOutHeight;
+        int32_t mSampleRate;
+        int32_t mChannelCount;
+
+        sp<EncodedSource> mOutput;
+    };
+
+    sp<ALooper> mLooper;
+    AString mInputPath;
+    AString mOutputPath;
+    TranscoderOptions mOptions;
+
+    sp<ActivityHandler> mActivityHandler;
+
+    sp<NuMediaExtractor> mExtractor;
+    KeyedVector<size_t, TrackState> mTracks;
+    sp<MPEG4Writer> mWriter;
+    bool mWriterStarted;
+
+    TranscoderStats mStats;
+
+    status_t setup();
+    sp<MediaCodec> createCodec(const char *mime, bool encoder);
+    status_t configureEncoder(TrackState *state, const sp<AMessage> &format);
+    status_t startWriterIfReady();
+
+    status_t dequeueInputBuffers(
+            const sp<MediaCodec> &codec, List<size_t> *indices);
+
+    status_t feedDecoders(bool *progress);
+    status_t drainDecoder(TrackState *state, bool *progress);
+    status_t feedEncoder(TrackState *state, bool *progress);
+    status_t drainEncoder(TrackState *state, bool *progress);
+
+    void convertFrame(
+            TrackState *state, const sp<ABuffer> &src,
+            const sp<ABuffer> &dst);
+
+    void setDecodedFormat(TrackState *state, const sp<AMessage> &format);
+
+    void waitForActivity();
+
+    void release();
+
+    DISALLOW_EVIL_CONSTRUCTORS(Transcoder);
+};
+
+// Runs queued transcoding jobs on a fixed number of worker threads, which
+// bounds the number of codecs and buffers in use at any time.
+struct TranscodeEngine : public RefBase {
+    TranscodeEngine(size_t numWorkers, const TranscoderOptions &options);
+
+    void addJob(const char *inputPath, const char *outputPath);
+
+    // Runs all jobs added so far and returns when they have completed.
+    void run();
+
+    struct Result {
+        AString mInputPath;
+        AString mOutputPath;
+        status_t mStatus;
+        TranscoderStats mStats;
+    };
+
+    const Vector<Result> &results() const { return mResults; }
+
+protected:
+    virtual ~TranscodeEngine();
+
+private:
+    struct Worker;
+
+    struct Job {
+        AString mInputPath;
+        AString mOutputPath;
+    };
+
+    size_t mNumWorkers;
+    TranscoderOptions mOptions;
+
+    // One per worker, which runs one session at a time. The codecs a
+    // session leaves in MediaCodecPool are reused by the next session of
+    // the same worker, so the loopers live as long as the engine.
+    Vector<sp<ALooper> > mLoopers;
+
+    Mutex mLock;
+    List<Job> mJobs;
+    Vector<Result> mResults;
+
+    bool dequeueJob(Job *job);
+    void addResult(const Result &result);
+
+    DISALLOW_EVIL_CONSTRUCTORS(TranscodeEngine);
+};
+
+}  // namespace android
+
+#endif  // TRANSCODER_H_
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "audiocodecbench"
+#include <utils/Log.h>
+
+#include <binder/ProcessState.h>
+#include <gui/SurfaceTextureClient.h>
+#include <media/ICrypto.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MediaCodec.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MediaErrors.h>
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-n number of buffers]\n"
+                    "\t\t[-s input buffer size in bytes]\n",
+                    me);
+
+    exit(1);
+}
+
+static void reportRate(const char *what, int32_t count, int64_t elapsedUs) {
+    printf("%s: %d in %lld us (%.1f us each)\n",
+           what,
+           count,
+           (long long)elapsedUs,
+           (double)elapsedUs / count);
+}
+
+namespace android {
+
+// Pushes "count" buffers of "size" bytes of 16 bit stereo PCM through the
+// raw audio decoder. The decoder does next to no work per buffer, what is
+// measured is the cost of moving a buffer through MediaCodec, ACodec and
+// OMX in both directions, which dominates for codecs with small frames.
+static void benchmarkRoundTrip(
+        const sp<ALooper> &looper, int32_t count, int32_t size) {
+    static const int64_t kTimeoutUs = 10000ll;
+
+    sp<MediaCodec> codec = MediaCodec::CreateByType(
+            looper, MEDIA_MIMETYPE_AUDIO_RAW, false /* encoder */);
+    CHECK(codec != NULL);
+
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", MEDIA_MIMETYPE_AUDIO_RAW);
+    format->setInt32("channel-count", 2);
+    format->setInt32("sample-rate", 44100);
+    format->setInt32("max-input-size", size);
+
+    CHECK_EQ(codec->configure(
+                format, NULL /* surface */, NULL /* crypto */, 0 /* flags */),
+             (status_t)OK);
+
+    CHECK_EQ(codec->start(), (status_t)OK);
+
+    Vector<sp<ABuffer> > inBuffers;
+    CHECK_EQ(codec->getInputBuffers(&inBuffers), (status_t)OK);
+
+    int32_t numQueued = 0;
+    int32_t numDrained = 0;
+    int64_t numBytesDrained = 0;
+    bool sawOutputEOS = false;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    while (!sawOutputEOS) {
+        size_t index;
+        while (numQueued <= count
+                && codec->dequeueInputBuffer(&index, 0ll) == OK) {
+            const sp<ABuffer> &buffer = inBuffers.itemAt(index);
+            CHECK_LE((size_t)size, buffer->capacity());
+
+            uint32_t flags = 0;
+            size_t bufferSize = size;
+            if (numQueued == count) {
+                flags = MediaCodec::BUFFER_FLAG_EOS;
+                bufferSize = 0;
+            } else {
+                memset(buffer->data(), numQueued & 0xff, size);
+            }
+
+            // Every buffer holds size / 4 stereo samples.
+            int64_t timeUs = numQueued * (size / 4) * 1000000ll / 44100;
+
+            CHECK_EQ(codec->queueInputBuffer(
+                        index, 0 /* offset */, bufferSize, timeUs, flags),
+                     (status_t)OK);
+
+            ++numQueued;
+        }
+
+        size_t offset;
+        size_t outSize;
+        int64_t presentationTimeUs;
+        uint32_t flags;
+        status_t err = codec->dequeueOutputBuffer(
+                &index, &offset, &outSize, &presentationTimeUs, &flags,
+                kTimeoutUs);
+
+        if (err == OK) {
+            if (outSize > 0) {
+                ++numDrained;
+                numBytesDrained += outSize;
+            }
+
+            CHECK_EQ(codec->releaseOutputBuffer(index), (status_t)OK);
+
+            if (flags & MediaCodec::BUFFER_FLAG_EOS) {
+                sawOutputEOS = true;
+            }
+        } else if (err != INFO_OUTPUT_BUFFERS_CHANGED
+                && err != INFO_FORMAT_CHANGED) {
+            CHECK_EQ(err, -EAGAIN);
+        }
+    }
+
+    int64_t elapsedUs = ALooper::GetNowUs() - startUs;
+
+    CHECK_EQ(codec->release(), (status_t)OK);
+
+    CHECK_EQ(numDrained, count);
+    CHECK_EQ(numBytesDrained, (int64_t)count * size);
+
+    AString what = "round trip of ";
+    what.append(size);
+    what.append(" byte buffers");
+    reportRate(what.c_str(), count, elapsedUs);
+}
+
+}  // namespace android
+
+int main(int argc, char **argv) {
+    using namespace android;
+
+    const char *me = argv[0];
+
+    int32_t count = 20000;
+    int32_t size = 256;
+
+    int res;
+    while ((res = getopt(argc, argv, "hn:s:")) >= 0) {
+        switch (res) {
+            case 'n':
+            {
+                count = atoi(optarg);
+                break;
+            }
+
+            case 's':
+            {
+                size = atoi(optarg);
+                break;
+            }
+
+            case '?':
+            case 'h':
+            default:
+            {
+                usage(me);
+            }
+        }
+    }
+
+    if (count <= 0 || size <= 0 || (size % 4) != 0) {
+        usage(me);
+    }
+
+    ProcessState::self()->startThreadPool();
+
+    sp<ALooper> looper = new ALooper;
+    looper->start();
+
+    benchmarkRoundTrip(looper, count, size);
+
+    looper->stop();
+
+    return 0;
+}
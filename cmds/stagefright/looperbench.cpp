@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "looperbench"
+#include <utils/Log.h>
+
+#include <sys/resource.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/ALooperPool.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-n number of messages]\n"
+                    "\t\t[-H number of handlers]\n"
+                    "\t\t[-p] share pooled loopers between handlers\n",
+                    me);
+
+    exit(1);
+}
+
+namespace android {
+
+// Bounces a message between itself and the looper until "count" messages
+// have been delivered, every round-trip creates a fresh message similar to
+// the ones exchanged by ACodec and NuPlayer.
+struct PingHandler : public AHandler {
+    PingHandler(int32_t count)
+        : mCount(count),
+          mNumReceived(0),
+          mDone(false) {
+    }
+
+    void waitForCompletion() {
+        Mutex::Autolock autoLock(mLock);
+        while (!mDone) {
+            mCondition.wait(mLock);
+        }
+    }
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        int32_t seq;
+        CHECK(msg->findInt32("seq", &seq));
+
+        AString mime;
+        CHECK(msg->findString("mime", &mime));
+
+        if (++mNumReceived == mCount) {
+            Mutex::Autolock autoLock(mLock);
+            mDone = true;
+            mCondition.signal();
+            return;
+        }
+
+        sp<AMessage> next = new AMessage(msg->what(), id());
+        next->setInt32("seq", seq + 1);
+        next->setInt64("timeUs", seq * 1000ll);
+        next->setString("mime", mime.c_str());
+        next->post();
+    }
+
+private:
+    Mutex mLock;
+    Condition mCondition;
+    int32_t mCount;
+    int32_t mNumReceived;
+    bool mDone;
+
+    DISALLOW_EVIL_CONSTRUCTORS(PingHandler);
+};
+
+// Swallows messages, used to build up deep looper queues.
+struct NullHandler : public AHandler {
+    NullHandler() {}
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {}
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(NullHandler);
+};
+
+}  // namespace android
+
+static void reportRate(const char *what, int32_t count, int64_t elapsedUs) {
+    printf("%s: %d in %lld us (%.2f us each, %.0f per sec)\n",
+           what,
+           count,
+           elapsedUs,
+           (double)elapsedUs / count,
+           count * 1E6 / elapsedUs);
+}
+
+// Threads, memory and context switches of the whole process, the latter
+// summed over all of its threads.
+struct ResourceUsage {
+    ResourceUsage()
+        : mNumThreads(0),
+          mVmSizeKb(0),
+          mVmRSSKb(0),
+          mNumContextSwitches(0) {
+        FILE *file = fopen("/proc/self/status", "r");
+        if (file != NULL) {
+            char line[128];
+            while (fgets(line, sizeof(line), file) != NULL) {
+                sscanf(line, "Threads: %d", &mNumThreads);
+                sscanf(line, "VmSize: %ld", &mVmSizeKb);
+                sscanf(line, "VmRSS: %ld", &mVmRSSKb);
+            }
+            fclose(file);
+        }
+
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            mNumContextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+        }
+    }
+
+    int32_t mNumThreads;
+    long mVmSizeKb;
+    long mVmRSSKb;
+    long mNumContextSwitches;
+};
+
+// Memory is counted from before the loopers were started, context switches
+// only while the messages were exchanged.
+static void reportResources(
+        const ResourceUsage &beforeSetup,
+        const ResourceUsage &beforeRun,
+        const ResourceUsage &afterRun) {
+    printf("  %d threads, %+ld kB virtual, %+ld kB resident, "
+           "%ld context switches\n",
+           afterRun.mNumThreads,
+           afterRun.mVmSizeKb - beforeSetup.mVmSizeKb,
+           afterRun.mVmRSSKb - beforeSetup.mVmRSSKb,
+           afterRun.mNumContextSwitches - beforeRun.mNumContextSwitches);
+}
+
+static void benchmarkMessages(int32_t count) {
+    using namespace android;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (int32_t i = 0; i < count; ++i) {
+        sp<AMessage> msg = new AMessage('test');
+        msg->setInt32("index", i);
+        msg->setInt64("timeUs", i * 1000ll);
+        msg->setString("mime", "audio/mp4a-latm");
+
+        int32_t index;
+        int64_t timeUs;
+        AString mime;
+        CHECK(msg->findInt32("index", &index));
+        CHECK(msg->findInt64("timeUs", &timeUs));
+        CHECK(msg->findString("mime", &mime));
+    }
+
+    reportRate("create/set/find", count, ALooper::GetNowUs() - startUs);
+}
+
+static void benchmarkPostAndDeliver(int32_t count) {
+    using namespace android;
+
+    sp<ALooper> looper = new ALooper;
+    looper->setName("looperbench");
+    looper->start();
+
+    sp<PingHandler> handler = new PingHandler(count);
+    looper->registerHandler(handler);
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    sp<AMessage> msg = new AMessage('ping', handler->id());
+    msg->setInt32("seq", 0);
+    msg->setString("mime", "audio/mp4a-latm");
+    msg->post();
+
+    handler->waitForCompletion();
+
+    reportRate("post/deliver", count, ALooper::GetNowUs() - startUs);
+
+    looper->unregisterHandler(handler->id());
+    looper->stop();
+}
+
+// Posts "count" messages with delays spread over the next ten seconds,
+// i.e. in random order with respect to their delivery time.
+static void benchmarkDeepQueue(int32_t count) {
+    using namespace android;
+
+    sp<ALooper> looper = new ALooper;
+    looper->setName("looperbench");
+    looper->start();
+
+    sp<NullHandler> handler = new NullHandler;
+    looper->registerHandler(handler);
+
+    srand(1);
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (int32_t i = 0; i < count; ++i) {
+        int64_t delayUs = 1000000ll + (rand() % 10000) * 1000ll;
+        (new AMessage('null', handler->id()))->post(delayUs);
+    }
+
+    reportRate("post (deep queue)", count, ALooper::GetNowUs() - startUs);
+
+    looper->unregisterHandler(handler->id());
+    looper->stop();
+}
+
+// Runs a ping-pong between "numHandlers" handlers and their loopers, either
+// with one looper per handler or with all handlers sharing the ALooperPool.
+static void benchmarkManyHandlers(
+        int32_t count, int32_t numHandlers, bool usePool) {
+    using namespace android;
+
+    Vector<sp<ALooper> > loopers;
+    Vector<sp<PingHandler> > handlers;
+
+    ResourceUsage beforeSetup;
+
+    int32_t countPerHandler = count / numHandlers;
+    if (countPerHandler < 1) {
+        countPerHandler = 1;
+    }
+
+    for (int32_t i = 0; i < numHandlers; ++i) {
+        sp<PingHandler> handler = new PingHandler(countPerHandler);
+
+        if (usePool) {
+            ALooperPool::RegisterHandler(handler);
+        } else {
+            sp<ALooper> looper = new ALooper;
+            looper->setName("looperbench");
+
+            // Same priority as the shared loopers.
+            looper->start(
+                    false /* runOnCallingThread */,
+                    false /* canCallJava */,
+                    ANDROID_PRIORITY_FOREGROUND);
+            looper->registerHandler(handler);
+            loopers.push(looper);
+        }
+
+        handlers.push(handler);
+    }
+
+    ResourceUsage beforeRun;
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (size_t i = 0; i < handlers.size(); ++i) {
+        sp<AMessage> msg = new AMessage('ping', handlers[i]->id());
+        msg->setInt32("seq", 0);
+        msg->setString("mime", "audio/mp4a-latm");
+        msg->post();
+    }
+
+    for (size_t i = 0; i < handlers.size(); ++i) {
+        handlers[i]->waitForCompletion();
+    }
+
+    int64_t elapsedUs = ALooper::GetNowUs() - startUs;
+    ResourceUsage afterRun;
+
+    AString what = StringPrintf(
+            "post/deliver (%d handlers, %s)",
+            numHandlers, usePool ? "pooled loopers" : "one looper each");
+
+    reportRate(what.c_str(), countPerHandler * numHandlers, elapsedUs);
+    reportResources(beforeSetup, beforeRun, afterRun);
+
+    for (size_t i = 0; i < handlers.size(); ++i) {
+        if (usePool) {
+            ALooperPool::UnregisterHandler(handlers[i]->id());
+        } else {
+            loopers[i]->unregisterHandler(handlers[i]->id());
+            loopers[i]->stop();
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *me = argv[0];
+
+    int32_t count = 100000;
+    int32_t numHandlers = 0;
+    bool usePool = false;
+
+    int res;
+    while ((res = getopt(argc, argv, "hn:H:p")) >= 0) {
+        switch (res) {
+            case 'n':
+            {
+                count = atoi(optarg);
+                break;
+            }
+
+            case 'H':
+            {
+                numHandlers = atoi(optarg);
+                break;
+            }
+
+            case 'p':
+            {
+                usePool = true;
+                break;
+            }
+
+            case '?':
+            case 'h':
+            default:
+            {
+                usage(me);
+            }
+        }
+    }
+
+    if (count <= 0 || numHandlers < 0) {
+        usage(me);
+    }
+
+    if (numHandlers > 0) {
+        benchmarkManyHandlers(count, numHandlers, usePool);
+        return 0;
+    }
+
+    benchmarkMessages(count);
+    benchmarkPostAndDeliver(count);
+    benchmarkDeepQueue(count);
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "metadatabench"
+#include <utils/Log.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MetaData.h>
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-n number of iterations]\n", me);
+
+    exit(1);
+}
+
+static void reportRate(const char *what, int32_t count, int64_t elapsedUs) {
+    printf("%s: %d in %lld us (%.1f ns each)\n",
+           what,
+           count,
+           (long long)elapsedUs,
+           elapsedUs * 1E3 / count);
+}
+
+// What MPEG4Source::read does to the metadata of the MediaBuffer it hands
+// out for every sample, followed by what a decoder looks up on it. The
+// MetaData object is reused like the one of a recycled MediaBuffer.
+static void benchmarkPerFrame(int32_t count) {
+    using namespace android;
+
+    sp<MetaData> meta = new MetaData;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (int32_t i = 0; i < count; ++i) {
+        meta->clear();
+        meta->setInt64(kKeyTime, i * 33333ll);
+        if ((i % 30) == 0) {
+            meta->setInt32(kKeyIsSyncFrame, 1);
+        }
+
+        int64_t timeUs;
+        int32_t isSync;
+        CHECK(meta->findInt64(kKeyTime, &timeUs));
+        if (!meta->findInt32(kKeyIsSyncFrame, &isSync)) {
+            isSync = 0;
+        }
+        CHECK_EQ(isSync, (i % 30) == 0 ? 1 : 0);
+    }
+
+    reportRate("per-frame clear/set/find", count, ALooper::GetNowUs() - startUs);
+}
+
+// The same sequence with the seek target and fake sync keys a seek into a
+// file without a sync sample table adds.
+static void benchmarkPerFrameAfterSeek(int32_t count) {
+    using namespace android;
+
+    sp<MetaData> meta = new MetaData;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (int32_t i = 0; i < count; ++i) {
+        meta->clear();
+        meta->setInt64(kKeyTime, i * 33333ll);
+        meta->setInt64(kKeyTargetTime, 1000000ll);
+        meta->setInt32(kKeyIsSyncFrame, 1);
+        meta->setInt32(kKeyIsFakeSync, 1);
+
+        int64_t timeUs, targetTimeUs;
+        int32_t isSync;
+        CHECK(meta->findInt64(kKeyTime, &timeUs));
+        CHECK(meta->findInt64(kKeyTargetTime, &targetTimeUs));
+        CHECK(meta->findInt32(kKeyIsSyncFrame, &isSync));
+    }
+
+    reportRate("per-frame clear/set/find (after seek)",
+               count, ALooper::GetNowUs() - startUs);
+}
+
+// A track format as built by an extractor, created, queried and destroyed.
+static void benchmarkTrackFormat(int32_t count) {
+    using namespace android;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (int32_t i = 0; i < count; ++i) {
+        sp<MetaData> meta = new MetaData;
+        meta->setCString(kKeyMIMEType, MEDIA_MIMETYPE_VIDEO_AVC);
+        meta->setInt32(kKeyWidth, 1280);
+        meta->setInt32(kKeyHeight, 720);
+        meta->setInt64(kKeyDuration, 60000000ll);
+        meta->setInt32(kKeyMaxInputSize, 65536);
+        meta->setRect(kKeyCropRect, 0, 0, 1279, 719);
+
+        const char *mime;
+        int32_t width, height;
+        CHECK(meta->findCString(kKeyMIMEType, &mime));
+        CHECK(meta->findInt32(kKeyWidth, &width));
+        CHECK(meta->findInt32(kKeyHeight, &height));
+    }
+
+    reportRate("track format create/set/find", count, ALooper::GetNowUs() - startUs);
+}
+
+int main(int argc, char **argv) {
+    const char *me = argv[0];
+
+    int32_t count = 5000000;
+
+    int res;
+    while ((res = getopt(argc, argv, "hn:")) >= 0) {
+        switch (res) {
+            case 'n':
+            {
+                count = atoi(optarg);
+                break;
+            }
+
+            case '?':
+            case 'h':
+            default:
+            {
+                usage(me);
+            }
+        }
+    }
+
+    if (count <= 0) {
+        usage(me);
+    }
+
+    benchmarkPerFrame(count);
+    benchmarkPerFrameAfterSeek(count);
+    benchmarkTrackFormat(count / 10 > 0 ? count / 10 : 1);
+
+    return 0;
+}
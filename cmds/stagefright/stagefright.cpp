@@ -598,6 +598,7 @@ static void usage(const char *me) {
     fprintf(stderr, "       -b bug to reproduce\n");
     fprintf(stderr, "       -p(rofiles) dump decoder profiles supported\n");
     fprintf(stderr, "       -t(humbnail) extract video thumbnail or album art\n");
+    fprintf(stderr, "       -z max-thumbnail-size in pixels (with -t)\n");
     fprintf(stderr, "       -s(oftware) prefer software codec\n");
     fprintf(stderr, "       -r(hardware) force to use hardware codec\n");
     fprintf(stderr, "       -o playback audio\n");
@@ -662,6 +663,7 @@ int main(int argc, char **argv) {
     bool listComponents = false;
     bool dumpProfiles = false;
     bool extractThumbnail = false;
+    int32_t maxThumbnailSize = 0;
     bool seekTest = false;
     bool useSurfaceAlloc = false;
     bool useSurfaceTexAlloc = false;
@@ -681,7 +683,7 @@ int main(int argc, char **argv) {
     sp<LiveSession> liveSession;
 
     int res;
-    while ((res = getopt(argc, argv, "han:lm:b:ptsrow:kxSTd:D:")) >= 0) {
+    while ((res = getopt(argc, argv, "han:lm:b:ptz:srow:kxSTd:D:")) >= 0) {
         switch (res) {
             case 'a':
             {
@@ -713,6 +715,7 @@ int main(int argc, char **argv) {
             case 'm':
             case 'n':
             case 'b':
+            case 'z':
             {
                 char *end;
                 long x = strtol(optarg, &end, 10);
@@ -725,6 +728,8 @@ int main(int argc, char **argv) {
                     gNumRepetitions = x;
                 } else if (res == 'm') {
                     gMaxNumFrames = x;
+                } else if (res == 'z') {
+                    maxThumbnailSize = x;
                 } else {
                     CHECK_EQ(res, 'b');
                     gReproduceBug = x;
@@ -841,9 +846,15 @@ int main(int argc, char **argv) {
             close(fd);
             fd = -1;
 
-            sp<IMemory> mem =
-                    retriever->getFrameAtTime(-1,
-                                    MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC);
+            sp<IMemory> mem;
+            if (maxThumbnailSize > 0) {
+                mem = retriever->getScaledFrameAtTime(
+                        -1, MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC,
+                        maxThumbnailSize, maxThumbnailSize);
+            } else {
+                mem = retriever->getFrameAtTime(
+                        -1, MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC);
+            }
 
             if (mem != NULL) {
                 failed = false;
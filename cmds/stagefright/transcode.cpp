@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "transcode"
+#include <utils/Log.h>
+
+#include "Transcoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <binder/ProcessState.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/DataSource.h>
+#include <media/stagefright/MediaCodecPool.h>
+#include <media/stagefright/MediaDefs.h>
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-a] use audio\n"
+                    "\t\t[-v] use video\n"
+                    "\t\t[-H] allow hardware codecs\n"
+                    "\t\t[-j jobs] number of parallel sessions\n"
+                    "\t\t[-w width] [-e height] output video size\n"
+                    "\t\t[-b bitrate] video bitrate\n"
+                    "\t\t[-B bitrate] audio bitrate\n"
+                    "\t\t[-q count] encoded buffers queued per track\n"
+                    "\t\t[-o dir] output directory\n"
+                    "\t\tfile ...\n",
+                    me);
+
+    exit(1);
+}
+
+static void printStats(
+        const char *name, const android::TranscoderStats &stats) {
+    double elapsedSecs = stats.mElapsedUs / 1E6;
+    if (elapsedSecs <= 0.0) {
+        elapsedSecs = 1E-6;
+    }
+
+    printf("%s: %.2f secs\n", name, elapsedSecs);
+
+    printf("  extract: %lld samples, %.2f KB/sec, %.2f secs\n",
+           (long long)stats.mSamplesRead,
+           stats.mBytesRead / 1024.0 / elapsedSecs,
+           stats.mExtractTimeUs / 1E6);
+
+    printf("  decode:  %lld frames (%.2f fps), %lld bytes of pcm\n",
+           (long long)stats.mFramesDecoded,
+           stats.mFramesDecoded / elapsedSecs,
+           (long long)stats.mAudioBytesDecoded);
+
+    printf("  convert: %lld frames, %.2f secs\n",
+           (long long)stats.mFramesConverted,
+           stats.mConvertTimeUs / 1E6);
+
+    printf("  encode:  %lld buffers (%.2f/sec), %.2f KB/sec\n",
+           (long long)stats.mFramesEncoded,
+           stats.mFramesEncoded / elapsedSecs,
+           stats.mBytesEncoded / 1024.0 / elapsedSecs);
+
+    printf("  writer stalls: %.2f secs\n", stats.mWriterStallUs / 1E6);
+}
+
+int main(int argc, char **argv) {
+    using namespace android;
+
+    const char *me = argv[0];
+
+    TranscoderOptions options;
+    bool useAudio = false;
+    bool useVideo = false;
+    long numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *outputDir = ".";
+
+    int res;
+    while ((res = getopt(argc, argv, "havHj:w:e:b:B:q:o:")) >= 0) {
+        switch (res) {
+            case 'a':
+            {
+                useAudio = true;
+                break;
+            }
+
+            case 'v':
+            {
+                useVideo = true;
+                break;
+            }
+
+            case 'H':
+            {
+                options.mSoftwareOnly = false;
+                break;
+            }
+
+            case 'j':
+            {
+                numWorkers = atol(optarg);
+                break;
+            }
+
+            case 'w':
+            {
+                options.mWidth = atoi(optarg);
+                break;
+            }
+
+            case 'e':
+            {
+                options.mHeight = atoi(optarg);
+                break;
+            }
+
+            case 'b':
+            {
+                options.mVideoBitrate = atoi(optarg);
+                break;
+            }
+
+            case 'B':
+            {
+                options.mAudioBitrate = atoi(optarg);
+                break;
+            }
+
+            case 'q':
+            {
+                options.mMaxQueuedBuffers = atoi(optarg);
+                break;
+            }
+
+            case 'o':
+            {
+                outputDir = optarg;
+                break;
+            }
+
+            case '?':
+            case 'h':
+            default:
+            {
+                usage(me);
+            }
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 1 || numWorkers < 1) {
+        usage(me);
+    }
+
+    if (useAudio || useVideo) {
+        options.mUseAudio = useAudio;
+        options.mUseVideo = useVideo;
+    }
+
+    ProcessState::self()->startThreadPool();
+
+    DataSource::RegisterDefaultSniffers();
+
+    sp<TranscodeEngine> engine = new TranscodeEngine(numWorkers, options);
+
+    for (int i = 0; i < argc; ++i) {
+        const char *name = strrchr(argv[i], '/');
+        name = (name != NULL) ? name + 1 : argv[i];
+
+        const char *extension = strrchr(name, '.');
+        size_t nameLength = (extension != NULL) ? extension - name : strlen(name);
+
+        AString outputPath = outputDir;
+        outputPath.append("/");
+        outputPath.append(name, nameLength);
+        outputPath.append(".mp4");
+
+        engine->addJob(argv[i], outputPath.c_str());
+    }
+
+    int64_t startUs = ALooper::GetNowUs();
+    engine->run();
+    int64_t elapsedUs = ALooper::GetNowUs() - startUs;
+
+    MediaCodecPool::Clear();
+
+    TranscoderStats total;
+    int numFailed = 0;
+
+    const Vector<TranscodeEngine::Result> &results = engine->results();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TranscodeEngine::Result &result = results.itemAt(i);
+
+        if (result.mStatus != OK) {
+            fprintf(stderr, "%s: failed (%d)\n",
+                    result.mInputPath.c_str(), result.mStatus);
+            ++numFailed;
+            continue;
+        }
+
+        printStats(result.mOutputPath.c_str(), result.mStats);
+        total.add(result.mStats);
+    }
+
+    // The sessions overlap, the totals are rates over the wall clock time.
+    total.mElapsedUs = elapsedUs;
+    printf("\n");
+    printStats("total", total);
+    // The engine does not start more sessions than there are files.
+    long numSessions = numWorkers < argc ? numWorkers : argc;
+    printf("%d of %d files transcoded with %ld sessions\n",
+           (int)results.size() - numFailed, (int)results.size(), numSessions);
+
+    return numFailed > 0 ? 1 : 0;
+}
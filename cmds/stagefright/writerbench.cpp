@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "writerbench"
+#include <utils/Log.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+
+#include "M4OSA_FileReader.h"
+#include "M4OSA_FileWriter.h"
+#include "M4MP4W_Writer.h"
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-d minutes] [-f fps] [-b bytes per frame]\n"
+                    "\t\t[-o output] [-s spill prefix]\n"
+                    "\t\t-s moves the sample tables to temporary files\n",
+                    me);
+
+    exit(1);
+}
+
+namespace android {
+
+static M4OSA_FileWriterPointer sFileWriter = {
+    M4OSA_fileWriteOpen,
+    M4OSA_fileWriteData,
+    M4OSA_fileWriteSeek,
+    M4OSA_fileWriteFlush,
+    M4OSA_fileWriteClose,
+    M4OSA_fileWriteSetOption,
+    M4OSA_fileWriteGetOption,
+};
+
+static M4OSA_FileReadPointer sFileReader = {
+    M4OSA_fileReadOpen,
+    M4OSA_fileReadData,
+    M4OSA_fileReadSeek,
+    M4OSA_fileReadClose,
+    M4OSA_fileReadSetOption,
+    M4OSA_fileReadGetOption,
+};
+
+// Peak resident size of the process in kB, the writer allocates nothing else.
+static long peakResidentKb() {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[128];
+    long kb = -1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (!strncmp(line, "VmHWM:", 6)) {
+            kb = strtol(line + 6, NULL, 10);
+            break;
+        }
+    }
+    fclose(file);
+
+    return kb;
+}
+
+static M4OSA_ERR writeAU(
+        M4OSA_Context writer, M4SYS_StreamID streamID,
+        M4OSA_Time cts, M4OSA_UInt32 size, bool sync) {
+    M4SYS_AccessUnit au;
+    memset(&au, 0, sizeof(au));
+
+    M4OSA_ERR err = M4MP4W_startAU(writer, streamID, &au);
+    if (err != M4NO_ERROR) {
+        return err;
+    }
+
+    // The contents do not matter, only the sizes end up in the tables.
+    memset(au.dataAddress, 0, size);
+    au.size = size;
+    au.CTS = cts;
+    au.DTS = cts;
+    au.attribute = sync ? AU_RAP : AU_P_Frame;
+
+    return M4MP4W_processAU(writer, streamID, &au);
+}
+
+// Records an H.263 + AMR-NB file of the given duration. The frame sizes vary
+// so that every table grows with the duration like a real export does.
+static status_t run(const char *output, const char *spillPath,
+        int32_t minutes, int32_t fps, int32_t frameBytes) {
+    M4OSA_Context writer;
+    M4OSA_ERR err = M4MP4W_openWrite(
+            &writer, (void *)output, &sFileWriter, NULL, &sFileReader);
+    CHECK_EQ(err, (M4OSA_ERR)M4NO_ERROR);
+
+    M4SYS_StreamDescription video;
+    memset(&video, 0, sizeof(video));
+    video.streamID = VideoStreamID;
+    video.streamType = M4SYS_kH263;
+    video.timeScale = 1000;
+    video.averageBitrate = -1;
+    video.maxBitrate = -1;
+    CHECK_EQ(M4MP4W_addStream(writer, &video), (M4OSA_ERR)M4NO_ERROR);
+
+    M4SYS_StreamDescription audio;
+    memset(&audio, 0, sizeof(audio));
+    audio.streamID = AudioStreamID;
+    audio.streamType = M4SYS_kAMR;
+    audio.timeScale = 8000;
+    audio.averageBitrate = 12200;
+    audio.maxBitrate = 12200;
+    CHECK_EQ(M4MP4W_addStream(writer, &audio), (M4OSA_ERR)M4NO_ERROR);
+
+    M4SYS_StreamIDValue maxAUSize;
+    maxAUSize.streamID = VideoStreamID;
+    maxAUSize.value = 4 * frameBytes;
+    CHECK_EQ(M4MP4W_setOption(writer, M4MP4W_maxAUsize, &maxAUSize),
+             (M4OSA_ERR)M4NO_ERROR);
+
+    if (spillPath != NULL) {
+        CHECK_EQ(M4MP4W_setOption(
+                    writer, M4MP4W_tableSpillPath, (M4OSA_DataOption)spillPath),
+                 (M4OSA_ERR)M4NO_ERROR);
+    }
+
+    CHECK_EQ(M4MP4W_startWriting(writer), (M4OSA_ERR)M4NO_ERROR);
+
+    // 20 ms AMR frames, 32 bytes, 6 bytes SID frames every so often.
+    const int64_t durationMs = minutes * 60000ll;
+    int64_t videoMs = 0;
+    int64_t audioMs = 0;
+    int32_t frame = 0;
+    int32_t audioFrame = 0;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    while (videoMs < durationMs) {
+        while (audioMs <= videoMs) {
+            err = writeAU(writer, AudioStreamID, audioMs * 8,
+                          (audioFrame % 50) < 45 ? 32 : 6, true);
+            CHECK_EQ(err, (M4OSA_ERR)M4NO_ERROR);
+            audioMs += 20;
+            ++audioFrame;
+        }
+
+        bool sync = (frame % fps) == 0;
+        M4OSA_UInt32 size = sync
+                ? 3 * frameBytes
+                : frameBytes / 2 + ((int64_t)frame * 7919) % frameBytes;
+        err = writeAU(writer, VideoStreamID, videoMs, size, sync);
+        CHECK_EQ(err, (M4OSA_ERR)M4NO_ERROR);
+
+        ++frame;
+        videoMs = (int64_t)frame * 1000 / fps;
+    }
+
+    int64_t processUs = ALooper::GetNowUs() - startUs;
+
+    startUs = ALooper::GetNowUs();
+    err = M4MP4W_closeWrite(writer);
+    int64_t closeUs = ALooper::GetNowUs() - startUs;
+
+    if (err != M4NO_ERROR) {
+        fprintf(stderr, "closeWrite returned 0x%x\n", err);
+        return UNKNOWN_ERROR;
+    }
+
+    printf("%d min, %d video and %d audio samples, tables %s\n",
+           minutes, frame, audioFrame,
+           spillPath != NULL ? "spilled" : "in memory");
+    printf("  write %8lld ms\n", (long long)(processUs / 1000));
+    printf("  close %8lld ms\n", (long long)(closeUs / 1000));
+    printf("  peak resident %ld kB\n", peakResidentKb());
+
+    return OK;
+}
+
+}  // namespace android
+
+int main(int argc, char **argv) {
+    using namespace android;
+
+    const char *output = "/sdcard/writerbench.3gp";
+    const char *spillPath = NULL;
+    int32_t minutes = 180;
+    int32_t fps = 30;
+    int32_t frameBytes = 2000;
+
+    int res;
+    while ((res = getopt(argc, argv, "d:f:b:o:s:")) >= 0) {
+        switch (res) {
+            case 'd':
+            case 'f':
+            case 'b':
+            {
+                char *end;
+                long x = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || end == optarg || x <= 0) {
+                    usage(argv[0]);
+                }
+
+                if (res == 'd') {
+                    minutes = x;
+                } else if (res == 'f') {
+                    fps = x;
+                } else {
+                    frameBytes = x;
+                }
+                break;
+            }
+
+            case 'o':
+            {
+                output = optarg;
+                break;
+            }
+
+            case 's':
+            {
+                spillPath = optarg;
+                break;
+            }
+
+            default:
+            {
+                usage(argv[0]);
+                break;
+            }
+        }
+    }
+
+    return run(output, spillPath, minutes, fps, frameBytes) == OK ? 0 : 1;
+}
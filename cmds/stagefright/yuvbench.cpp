@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "yuvbench"
+#include <utils/Log.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/YUVCanvas.h>
+#include <media/stagefright/YUVImage.h>
+#include <ui/Rect.h>
+
+static void usage(const char *me) {
+    fprintf(stderr, "usage: %s [-w width] [-h height] [-n iterations]\n"
+                    "\t\t[-p] also time the per pixel loops\n",
+                    me);
+
+    exit(1);
+}
+
+namespace android {
+
+static const char *formatName(YUVImage::YUVFormat format) {
+    return format == YUVImage::YUV420Planar ? "planar" : "semiplanar";
+}
+
+// Returns the average time of one run of the operation in microseconds.
+template<typename Op>
+static int64_t timeIt(int32_t iterations, Op op) {
+    int64_t startUs = ALooper::GetNowUs();
+    for (int32_t i = 0; i < iterations; ++i) {
+        op();
+    }
+    return (ALooper::GetNowUs() - startUs) / iterations;
+}
+
+struct FillOp {
+    FillOp(YUVCanvas *canvas) : mCanvas(canvas) {}
+    void operator()() { mCanvas->FillYUV(16, 128, 128); }
+    YUVCanvas *mCanvas;
+};
+
+struct CopyOp {
+    CopyOp(const Rect &rect, const YUVImage *src, YUVCanvas *canvas)
+        : mRect(rect), mSrc(src), mCanvas(canvas) {}
+    void operator()() { mCanvas->CopyImageRect(mRect, 0, 0, *mSrc); }
+    Rect mRect;
+    const YUVImage *mSrc;
+    YUVCanvas *mCanvas;
+};
+
+struct BlendOp {
+    BlendOp(const Rect &rect, const YUVImage *src, YUVCanvas *canvas)
+        : mRect(rect), mSrc(src), mCanvas(canvas) {}
+    void operator()() { mCanvas->BlendImageRect(mRect, 0, 0, *mSrc, 96); }
+    Rect mRect;
+    const YUVImage *mSrc;
+    YUVCanvas *mCanvas;
+};
+
+// The setPixelValue() loops YUVCanvas used before.
+struct PerPixelFillOp {
+    PerPixelFillOp(YUVImage *image) : mImage(image) {}
+    void operator()() {
+        for (int32_t y = 0; y < mImage->height(); ++y) {
+            for (int32_t x = 0; x < mImage->width(); ++x) {
+                mImage->setPixelValue(x, y, 16, 128, 128);
+            }
+        }
+    }
+    YUVImage *mImage;
+};
+
+struct PerPixelCopyOp {
+    PerPixelCopyOp(const YUVImage *src, YUVImage *dest)
+        : mSrc(src), mDest(dest) {}
+    void operator()() {
+        for (int32_t y = 0; y < mSrc->height(); ++y) {
+            for (int32_t x = 0; x < mSrc->width(); ++x) {
+                uint8_t yValue, uValue, vValue;
+                mSrc->getPixelValue(x, y, &yValue, &uValue, &vValue);
+                mDest->setPixelValue(x, y, yValue, uValue, vValue);
+            }
+        }
+    }
+    const YUVImage *mSrc;
+    YUVImage *mDest;
+};
+
+static void run(int32_t width, int32_t height, int32_t iterations,
+        bool perPixel) {
+    static const YUVImage::YUVFormat kFormats[] = {
+        YUVImage::YUV420Planar, YUVImage::YUV420SemiPlanar
+    };
+
+    Rect rect(width, height);
+
+    for (size_t s = 0; s < 2; ++s) {
+        YUVImage src(kFormats[s], width, height);
+        YUVCanvas(src).FillYUV(100, 50, 200);
+
+        for (size_t d = 0; d < 2; ++d) {
+            YUVImage dest(kFormats[d], width, height);
+            YUVCanvas canvas(dest);
+
+            printf("%s -> %s, %dx%d:\n",
+                   formatName(kFormats[s]), formatName(kFormats[d]),
+                   width, height);
+
+            if (s == d) {
+                printf("  fill  %6lld us\n",
+                       timeIt(iterations, FillOp(&canvas)));
+                printf("  blend %6lld us\n",
+                       timeIt(iterations, BlendOp(rect, &src, &canvas)));
+            }
+            printf("  copy  %6lld us\n",
+                   timeIt(iterations, CopyOp(rect, &src, &canvas)));
+
+            if (perPixel) {
+                if (s == d) {
+                    printf("  per pixel fill %6lld us\n",
+                           timeIt(iterations, PerPixelFillOp(&dest)));
+                }
+                printf("  per pixel copy %6lld us\n",
+                       timeIt(iterations, PerPixelCopyOp(&src, &dest)));
+            }
+        }
+    }
+}
+
+}  // namespace android
+
+int main(int argc, char **argv) {
+    using namespace android;
+
+    int32_t width = 1920;
+    int32_t height = 1080;
+    int32_t iterations = 100;
+    bool perPixel = false;
+
+    int res;
+    while ((res = getopt(argc, argv, "w:h:n:p")) >= 0) {
+        switch (res) {
+            case 'w':
+            case 'h':
+            case 'n':
+            {
+                char *end;
+                long x = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || end == optarg || x <= 0) {
+                    usage(argv[0]);
+                }
+
+                if (res == 'w') {
+                    width = x & ~1;
+                } else if (res == 'h') {
+                    height = x & ~1;
+                } else {
+                    iterations = x;
+                }
+                break;
+            }
+
+            case 'p':
+            {
+                perPixel = true;
+                break;
+            }
+
+            default:
+            {
+                usage(argv[0]);
+                break;
+            }
+        }
+    }
+
+    run(width, height, iterations, perPixel);
+
+    return 0;
+}
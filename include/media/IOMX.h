@@ -22,6 +22,7 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/List.h>
 #include <utils/String8.h>
+#include <utils/Vector.h>
 
 #include <OMX_Core.h>
 #include <OMX_Video.h>
@@ -167,6 +168,11 @@ public:
     DECLARE_META_INTERFACE(OMXObserver);
 
     virtual void onMessage(const omx_message &msg) = 0;
+
+    // Delivers several messages of one node at once, in order. Remote
+    // observers receive them in a single transaction, the default
+    // implementation calls onMessage() for each of them.
+    virtual void onMessages(const Vector<omx_message> &messages);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -37,6 +37,13 @@ public:
 
     virtual status_t    setDataSource(int fd, int64_t offset, int64_t length) = 0;
     virtual VideoFrame* getFrameAtTime(int64_t timeUs, int option) = 0;
+    // Like getFrameAtTime(), but the frame is scaled down to fit within
+    // maxWidth x maxHeight, keeping its display aspect ratio. Retrievers
+    // that cannot scale return the frame at its full size, which
+    // MetadataRetrieverClient scales.
+    virtual VideoFrame* getScaledFrameAtTime(
+            int64_t timeUs, int option,
+            int32_t maxWidth, int32_t maxHeight) = 0;
     virtual MediaAlbumArt* extractAlbumArt() = 0;
     virtual const char* extractMetadata(int keyCode) = 0;
 };
@@ -49,6 +56,11 @@ public:
 
     virtual             ~MediaMetadataRetrieverInterface() {}
     virtual VideoFrame* getFrameAtTime(int64_t timeUs, int option) { return NULL; }
+    virtual VideoFrame* getScaledFrameAtTime(
+            int64_t timeUs, int option,
+            int32_t maxWidth, int32_t maxHeight) {
+        return getFrameAtTime(timeUs, option);
+    }
     virtual MediaAlbumArt* extractAlbumArt() { return NULL; }
     virtual const char* extractMetadata(int keyCode) { return NULL; }
 };
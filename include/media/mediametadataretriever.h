@@ -73,6 +73,8 @@ public:
 
     status_t setDataSource(int fd, int64_t offset, int64_t length);
     sp<IMemory> getFrameAtTime(int64_t timeUs, int option);
+    sp<IMemory> getScaledFrameAtTime(
+            int64_t timeUs, int option, int32_t maxWidth, int32_t maxHeight);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
 
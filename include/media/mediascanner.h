@@ -29,6 +29,7 @@ namespace android {
 
 class MediaScannerClient;
 class StringArray;
+class VideoFrame;
 
 enum MediaScanResult {
     // This file or directory was scanned successfully.
@@ -51,6 +52,15 @@ struct MediaScanner {
     virtual MediaScanResult processDirectory(
             const char *path, MediaScannerClient &client);
 
+    // Scans a list of files and reports each of them to the client on the
+    // calling thread, in order, as processFile() does. Implementations may
+    // retrieve several files in parallel. Files that cannot be parsed are
+    // skipped, the scan stops at the first MEDIA_SCAN_RESULT_ERROR, which
+    // is returned when the client fails.
+    virtual MediaScanResult processFiles(
+            const char *const *paths, size_t numPaths,
+            MediaScannerClient &client);
+
     void setLocale(const char *locale);
 
     // extracts album art as a block of data
@@ -92,6 +102,10 @@ public:
             long long fileSize, bool isDirectory, bool noMedia) = 0;
     virtual status_t handleStringTag(const char* name, const char* value) = 0;
     virtual status_t setMimeType(const char* mimeType) = 0;
+    // Called with a thumbnail of the current file by scanners that extract
+    // them. The RGB565 pixels follow the VideoFrame in memory, and are only
+    // valid during the call.
+    virtual status_t handleThumbnail(const VideoFrame* frame);
 
 protected:
     void convertValues(uint32_t encoding);
@@ -242,6 +242,7 @@ private:
     status_t setupMPEG4EncoderParameters(const sp<AMessage> &msg);
     status_t setupH263EncoderParameters(const sp<AMessage> &msg);
     status_t setupAVCEncoderParameters(const sp<AMessage> &msg);
+    status_t setupRateControlLookahead(const sp<AMessage> &msg);
 
     status_t verifySupportForProfileAndLevel(int32_t profile, int32_t level);
 
@@ -261,6 +262,15 @@ private:
 
     size_t countBuffersOwnedByComponent(OMX_U32 portIndex) const;
 
+    // Name of the current state and when it was entered, to log how long
+    // each state lasted, e.g. how long allocating buffers in Loaded->Idle
+    // took. The states waiting for the component are logged at info level.
+    const char *mStateName;
+    bool mStateWaitsForComponent;
+    int64_t mStateEnteredTimeUs;
+
+    void noteStateEntered(const char *stateName, bool waitsForComponent);
+
     void deferMessage(const sp<AMessage> &msg);
     void processDeferredMessages();
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BATCH_METADATA_RETRIEVER_H_
+
+#define BATCH_METADATA_RETRIEVER_H_
+
+#include <binder/IMemory.h>
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/KeyedVector.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class MediaMetadataRetriever;
+
+// Retrieves the metadata, and optionally a thumbnail and the album art, of a
+// list of files on a fixed number of worker threads. Every worker owns a
+// MediaMetadataRetriever, so the media server parses and decodes that many
+// files in parallel. Results are returned in the order the files were
+// added, and the workers never run more than mMaxPendingResults files ahead
+// of the consumer, which bounds the memory held by finished results.
+struct BatchMetadataRetriever : public RefBase {
+    struct Options {
+        Options();
+
+        // 0 runs one worker per online CPU.
+        size_t mNumWorkers;
+
+        // 0 allows 4 results per worker.
+        size_t mMaxPendingResults;
+
+        // Thumbnails of files with video are scaled to fit within
+        // mMaxThumbnailSize x mMaxThumbnailSize, none are extracted if it
+        // is <= 0.
+        int32_t mMaxThumbnailSize;
+
+        bool mExtractAlbumArt;
+
+        // The METADATA_KEY_* to extract, every key the retriever knows if
+        // empty. Each key costs a call into the media server.
+        Vector<int> mMetadataKeys;
+    };
+
+    // Times are in microseconds.
+    struct Result : public RefBase {
+        Result();
+
+        AString mPath;
+        status_t mStatus;
+
+        // METADATA_KEY_* -> value, for the keys the file provides.
+        KeyedVector<int, AString> mMetadata;
+
+        // Hold a VideoFrame and a MediaAlbumArt respectively.
+        sp<IMemory> mThumbnail;
+        sp<IMemory> mAlbumArt;
+
+        int64_t mOpenTimeUs;
+        int64_t mMetadataTimeUs;
+        int64_t mThumbnailTimeUs;
+        int64_t mAlbumArtTimeUs;
+
+        const char *getMetadata(int key) const;
+
+    protected:
+        virtual ~Result();
+
+    private:
+        DISALLOW_EVIL_CONSTRUCTORS(Result);
+    };
+
+    BatchMetadataRetriever(const Options &options);
+
+    // Files must be added before start().
+    void addFile(const char *path);
+
+    // If no worker thread can be started, every file fails with the error.
+    void start();
+
+    // Blocks until the result of the next file in order is available,
+    // returns NULL once all files have been returned or after stop().
+    sp<Result> dequeueResult();
+
+    // Abandons the files not yet started and waits for the workers.
+    void stop();
+
+    // Retrieves a single file on the calling thread.
+    static sp<Result> Retrieve(
+            const sp<MediaMetadataRetriever> &retriever,
+            const char *path, const Options &options);
+
+protected:
+    virtual ~BatchMetadataRetriever();
+
+private:
+    struct Worker;
+
+    Options mOptions;
+    Vector<sp<Worker> > mWorkers;
+
+    Mutex mLock;
+    Condition mCondition;
+    Vector<AString> mPaths;
+    Vector<sp<Result> > mResults;
+    size_t mNextFile;
+    size_t mNextResult;
+    bool mStarted;
+    bool mStopping;
+
+    int64_t mStartTimeUs;
+    int64_t mTotalOpenTimeUs;
+    int64_t mTotalMetadataTimeUs;
+    int64_t mTotalThumbnailTimeUs;
+    size_t mNumFailed;
+
+    // Returns false once there is no file left for a worker to retrieve.
+    bool dequeueFile(size_t *index, AString *path);
+    void addResult(size_t index, const sp<Result> &result);
+
+    DISALLOW_EVIL_CONSTRUCTORS(BatchMetadataRetriever);
+};
+
+}  // namespace android
+
+#endif  // BATCH_METADATA_RETRIEVER_H_
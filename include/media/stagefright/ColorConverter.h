@@ -18,21 +18,38 @@
 
 #define COLOR_CONVERTER_H_
 
+#include <pthread.h>
 #include <sys/types.h>
 
 #include <stdint.h>
 #include <utils/Errors.h>
+#include <utils/threads.h>
 
 #include <OMX_Video.h>
 
 namespace android {
 
+// R, G, B and A bytes in this order in memory, i.e. the layout of
+// SkBitmap::kARGB_8888_Config. Not an OMX color format, only ColorConverter
+// and FrameScaler accept it.
+enum {
+    kColorFormatRGBA8888_Internal = 0x7F00A000,
+};
+
+// Converts YUV frames to OMX_COLOR_Format16bitRGB565 or
+// kColorFormatRGBA8888_Internal.
 struct ColorConverter {
     ColorConverter(OMX_COLOR_FORMATTYPE from, OMX_COLOR_FORMATTYPE to);
     ~ColorConverter();
 
     bool isValid() const;
 
+    // Large enough frames are split into up to "numThreads" bands of rows.
+    // The first band is converted on the calling thread, the others by
+    // worker threads the converter keeps until it is destroyed. The default
+    // of 1 converts on the calling thread only.
+    void setNumThreads(size_t numThreads);
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight,
@@ -59,51 +76,102 @@ private:
         size_t mCropLeft, mCropTop, mCropRight, mCropBottom;
     };
 
-    OMX_COLOR_FORMATTYPE mSrcFormat, mDstFormat;
-    uint8_t *mClip;
-
-    uint8_t *initClip();
+    // Pointers to the luma and chroma samples of one row of the source
+    // crop rectangle, the chroma samples of pixels 2 * i and 2 * i + 1 are
+    // mU[i * mChromaStep] and mV[i * mChromaStep].
+    struct SrcRow {
+        const uint8_t *mY;
+        const uint8_t *mU;
+        const uint8_t *mV;
+        size_t mChromaStep;
+    };
 
-    status_t convertCbYCrY(
-            const BitmapParams &src, const BitmapParams &dst);
+    typedef void (*GetSrcRowFunc)(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
 
-    status_t convertYUV420Planar(
-            const BitmapParams &src, const BitmapParams &dst);
+    typedef void (*ConvertRowFunc)(
+            const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+            size_t chromaStep, size_t width, bool swapRB, void *dst);
 
-    status_t convertQCOMYUV420SemiPlanar(
-            const BitmapParams &src, const BitmapParams &dst);
+    struct Conversion;
+    struct Band;
 
-    status_t convertYUV420SemiPlanar(
-            const BitmapParams &src, const BitmapParams &dst);
+    typedef void (ColorConverter::*ConvertRowsFunc)(
+            const BitmapParams &src, const BitmapParams &dst,
+            size_t firstRow, size_t lastRow);
 
-    status_t convertTIYUV420PackedSemiPlanar(
-            const BitmapParams &src, const BitmapParams &dst);
+    static const Conversion kConversions[];
 
-    status_t convertNV12Tile(
-        size_t width, size_t height,
-        const void *srcBits, size_t srcSkip,
-        void *dstBits, size_t dstSkip);
+    OMX_COLOR_FORMATTYPE mSrcFormat, mDstFormat;
+    const Conversion *mConversion;
+    ConvertRowFunc mConvertRow;
+
+    // The bands of the conversion in progress that are not converted by
+    // the calling thread, and the workers taking them, all protected by
+    // mLock.
+    Mutex mLock;
+    Condition mBandsQueued;
+    Condition mBandsDone;
+    pthread_t *mWorkers;
+    size_t mNumWorkers;
+    Band *mBands;
+    size_t mNumBands;
+    size_t mNextBand;
+    size_t mNumBandsDone;
+    bool mExiting;
+
+    static void GetYUV420PlanarRow(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
+
+    static void GetCbYCrYRow(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
+
+    static void GetSemiPlanarRow(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
+
+    static void GetSemiPlanarVURow(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
+
+    static void GetTIPackedSemiPlanarRow(
+            const BitmapParams &src, size_t row, uint8_t *scratch,
+            SrcRow *out);
+
+    static void *WorkerWrapper(void *me);
+    void workerLoop();
+
+    void startWorkers(size_t numWorkers);
+    void stopWorkers();
+
+    status_t runBands(
+            ConvertRowsFunc func,
+            const BitmapParams &src, const BitmapParams &dst,
+            size_t numRows, size_t pixelsPerRow,
+            size_t rowAlignment, size_t minRowsPerBand);
+
+    void runNextBand_l();
+
+    void convertRows(
+            const BitmapParams &src, const BitmapParams &dst,
+            size_t firstRow, size_t lastRow);
+
+    void convertNV12TileRows(
+            const BitmapParams &src, const BitmapParams &dst,
+            size_t firstBlockRow, size_t lastBlockRow);
 
     size_t nv12TileGetTiledMemBlockNum(
         size_t bx, size_t by,
         size_t nbx, size_t nby);
 
-    void nv12TileComputeRGB(
-        uint8_t **dstPtr,const uint8_t *blockUV,
-        const uint8_t *blockY, size_t blockWidth,
-        size_t dstSkip);
-
     void nv12TileTraverseBlock(
         uint8_t **dstPtr, const uint8_t *blockY,
         const uint8_t *blockUV, size_t blockWidth,
         size_t blockHeight, size_t dstSkip);
 
-    void convertYUV420SemiPlanar32Aligned(
-            size_t width, size_t height,
-            const void *srcBits, size_t srcSkip,
-            void *dstBits, size_t dstSkip,
-            size_t alignedWidth);
-
     ColorConverter(const ColorConverter &);
     ColorConverter &operator=(const ColorConverter &);
 };
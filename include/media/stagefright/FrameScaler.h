@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_SCALER_H_
+
+#define FRAME_SCALER_H_
+
+#include <sys/types.h>
+
+#include <stdint.h>
+#include <utils/Errors.h>
+
+#include <OMX_Video.h>
+
+namespace android {
+
+// Resizes kColorFormatRGBA8888_Internal bitmaps with a separable filter,
+// writing kColorFormatRGBA8888_Internal or OMX_COLOR_Format16bitRGB565.
+// When shrinking, the filters are widened by the scale factor so that every
+// source pixel contributes to the result.
+struct FrameScaler {
+    enum Filter {
+        // Average of the source pixels covered by a destination pixel.
+        FILTER_BOX,
+        // Triangle filter, plain bilinear interpolation when enlarging.
+        FILTER_BILINEAR,
+        // Lanczos windowed sinc with 3 lobes, sharpest but slowest.
+        FILTER_LANCZOS3,
+    };
+
+    FrameScaler(Filter filter, OMX_COLOR_FORMATTYPE dstFormat);
+    ~FrameScaler();
+
+    bool isValid() const;
+
+    // Fits a frame of displayWidth x displayHeight within maxWidth x
+    // maxHeight, keeping its aspect ratio and never enlarging it. The bounds
+    // apply to the frame as shown, i.e. after a rotation by rotationAngle
+    // degrees. A bound <= 0 leaves that dimension free.
+    static void ComputeScaledSize(
+            int32_t displayWidth, int32_t displayHeight,
+            int32_t maxWidth, int32_t maxHeight, int32_t rotationAngle,
+            int32_t *width, int32_t *height);
+
+    // Strides are in bytes.
+    status_t scale(
+            const void *srcBits,
+            size_t srcWidth, size_t srcHeight, size_t srcStride,
+            void *dstBits,
+            size_t dstWidth, size_t dstHeight, size_t dstStride);
+
+private:
+    // Destination pixel i is the sum of the mNumTaps source pixels starting
+    // at mStart[i], weighted by mWeights[i * mNumTaps ...] in units of
+    // 1 / 16384.
+    struct Taps {
+        Taps();
+        ~Taps();
+
+        size_t mSrcSize;
+        size_t mDstSize;
+        size_t mNumTaps;
+        int32_t *mStart;
+        int16_t *mWeights;
+
+        void clear();
+    };
+
+    Filter mFilter;
+    OMX_COLOR_FORMATTYPE mDstFormat;
+
+    Taps mHorizontal;
+    Taps mVertical;
+
+    // Horizontally scaled source rows, and one vertically scaled row for
+    // RGB565 output.
+    uint8_t *mTmp;
+    size_t mTmpSize;
+    uint8_t *mRow;
+    size_t mRowSize;
+
+    void computeTaps(size_t srcSize, size_t dstSize, Taps *taps);
+
+    static void ScaleRowHorizontally(
+            const Taps &taps, const uint8_t *src, uint8_t *dst);
+
+    static void ScaleColumns(
+            const Taps &taps, size_t y,
+            const uint8_t *src, size_t srcStride, size_t numBytes,
+            uint8_t *dst);
+
+    FrameScaler(const FrameScaler &);
+    FrameScaler &operator=(const FrameScaler &);
+};
+
+}  // namespace android
+
+#endif  // FRAME_SCALER_H_
@@ -102,6 +102,9 @@ private:
     MediaBuffer *mNextBuffer;
     int mRefCount;
 
+    // Owned by MediaBufferGroup, true while the buffer is counted as in use.
+    bool mInUse;
+
     void *mData;
     size_t mSize, mRangeOffset, mRangeLength;
     sp<GraphicBuffer> mGraphicBuffer;
@@ -20,6 +20,7 @@
 
 #include <media/stagefright/MediaBuffer.h>
 #include <utils/Errors.h>
+#include <utils/Vector.h>
 #include <utils/threads.h>
 
 namespace android {
@@ -36,7 +37,32 @@ public:
 
     // Blocks until a buffer is available and returns it to the caller,
     // the returned buffer will have a reference count of 1.
-    status_t acquire_buffer(MediaBuffer **buffer);
+    // If nonBlocking is true and no buffer is currently available,
+    // returns WOULD_BLOCK instead of waiting.
+    status_t acquire_buffer(MediaBuffer **buffer, bool nonBlocking = false);
+
+    struct Stats {
+        Stats()
+            : mNumAcquired(0),
+              mNumWaits(0),
+              mTotalWaitUs(0),
+              mMaxWaitUs(0),
+              mHighWatermark(0) {
+        }
+
+        int64_t mNumAcquired;
+
+        // Number of acquire_buffer calls that had to block, and for how
+        // long in total.
+        int64_t mNumWaits;
+        int64_t mTotalWaitUs;
+        int64_t mMaxWaitUs;
+
+        // Largest number of buffers simultaneously handed out.
+        size_t mHighWatermark;
+    };
+
+    void getStats(Stats *stats);
 
 protected:
     virtual void signalBufferReturned(MediaBuffer *buffer);
@@ -48,6 +74,19 @@ private:
     Condition mCondition;
 
     MediaBuffer *mFirstBuffer, *mLastBuffer;
+    size_t mNumBuffers;
+
+    // Buffers handed out by acquire_buffer and not returned yet.
+    size_t mNumInUse;
+
+    // Buffers known to have been returned, most recently returned last.
+    // acquire_buffer takes buffers from here instead of walking the list
+    // of all buffers.
+    Vector<MediaBuffer *> mFreeBuffers;
+
+    Stats mStats;
+
+    MediaBuffer *acquireFreeBuffer_l();
 
     MediaBufferGroup(const MediaBufferGroup &);
     MediaBufferGroup &operator=(const MediaBufferGroup &);
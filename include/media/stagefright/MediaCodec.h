@@ -21,6 +21,7 @@
 #include <gui/ISurfaceTexture.h>
 #include <media/hardware/CryptoAPI.h>
 #include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/AString.h>
 #include <utils/Vector.h>
 
 namespace android {
@@ -28,7 +29,6 @@ namespace android {
 struct ABuffer;
 struct ACodec;
 struct AMessage;
-struct AString;
 struct ICrypto;
 struct SoftwareRenderer;
 struct SurfaceTextureClient;
@@ -108,6 +108,9 @@ struct MediaCodec : public AHandler {
 
     status_t requestIDRFrame();
 
+    // Name of the OMX component instantiated for this codec.
+    status_t getName(AString *name) const;
+
     // Notification will be posted once there "is something to do", i.e.
     // an input/output buffer has become available, a format change is
     // pending, an error is pending.
@@ -154,6 +157,7 @@ private:
         kWhatCodecNotify                    = 'codc',
         kWhatRequestIDRFrame                = 'ridr',
         kWhatRequestActivityNotification    = 'racN',
+        kWhatGetName                        = 'getN',
     };
 
     enum {
@@ -178,6 +182,7 @@ private:
     sp<ALooper> mLooper;
     sp<ALooper> mCodecLooper;
     sp<ACodec> mCodec;
+    AString mComponentName;
     uint32_t mReplyID;
     uint32_t mFlags;
     sp<SurfaceTextureClient> mNativeWindow;
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEDIA_CODEC_POOL_H_
+
+#define MEDIA_CODEC_POOL_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/KeyedVector.h>
+#include <utils/List.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+
+namespace android {
+
+struct ALooper;
+struct MediaCodec;
+
+// Keeps stopped MediaCodec instances around, their components still
+// allocated, so that creating another codec of the same kind on the same
+// looper skips looking up, loading and allocating the OMX component.
+struct MediaCodecPool {
+    // Return an idle codec matching the arguments if there is one, otherwise
+    // a new one as MediaCodec::CreateByType/CreateByComponentName would.
+    static sp<MediaCodec> CreateByType(
+            const sp<ALooper> &looper, const char *mime, bool encoder);
+
+    static sp<MediaCodec> CreateByComponentName(
+            const sp<ALooper> &looper, const char *name);
+
+    // Takes the place of MediaCodec::release() for codecs obtained from the
+    // pool: stops "codec" and keeps it for reuse, or releases it if its
+    // component does not support being started again, it cannot be stopped,
+    // did not come from the pool or the pool is full.
+    static void Recycle(const sp<MediaCodec> &codec);
+
+    // Releases all idle codecs. Idle codecs are never released implicitly,
+    // processes using the pool should call this before they exit.
+    static void Clear();
+
+private:
+    enum {
+        kMaxIdleCodecs = 8,
+    };
+
+    struct Key {
+        sp<ALooper> mLooper;
+        AString mName;
+        bool mNameIsType;
+        bool mEncoder;
+
+        bool matches(const Key &other) const;
+    };
+
+    struct IdleCodec {
+        Key mKey;
+        sp<MediaCodec> mCodec;
+    };
+
+    static MediaCodecPool *gCodecPool;
+
+    static void Init();
+    static MediaCodecPool *Get();
+
+    Mutex mLock;
+
+    // Most recently recycled codecs first.
+    List<IdleCodec> mIdleCodecs;
+
+    // The keys of the codecs handed out by the pool.
+    KeyedVector<wp<MediaCodec>, Key> mActiveCodecs;
+
+    MediaCodecPool();
+
+    sp<MediaCodec> acquire(const Key &key);
+    void recycle(const sp<MediaCodec> &codec);
+    void clear();
+
+    DISALLOW_EVIL_CONSTRUCTORS(MediaCodecPool);
+};
+
+}  // namespace android
+
+#endif  // MEDIA_CODEC_POOL_H_
@@ -238,11 +238,13 @@ private:
 
     private:
         uint32_t mType;
-        size_t mSize;
+        uint32_t mSize;
 
+        // Values of up to 8 bytes, i.e. int32s, int64 timestamps, floats
+        // and pointers, are stored inline. Rects and strings are not.
         union {
             void *ext_data;
-            float reservoir;
+            int64_t reservoir;
         } u;
 
         bool usesReservoir() const {
@@ -265,9 +267,33 @@ private:
         int32_t mLeft, mTop, mRight, mBottom;
     };
 
-    KeyedVector<uint32_t, typed_data> mItems;
+    struct item {
+        uint32_t mKey;
+        typed_data mData;
+    };
+
+    enum {
+        // Enough for the per-buffer metadata set by MPEG4Source::read, time
+        // and sync flag plus target time and fake sync flag after a seek,
+        // to never touch the heap. Each item takes 24 bytes.
+        kNumInlineItems = 4
+    };
 
-    // MetaData &operator=(const MetaData &);
+    // Items sorted by key in a flat array, which is "mInlineItems" until
+    // it grows beyond kNumInlineItems entries. Items are relocated with
+    // memmove, typed_data doesn't point into itself. The array's capacity
+    // is retained across clear() so that metadata objects recycled with
+    // their MediaBuffers don't reallocate.
+    item *mItems;
+    size_t mNumItems;
+    size_t mCapacity;
+    uint8_t mInlineItems[kNumInlineItems * sizeof(item)]
+        __attribute__((aligned(8)));
+
+    ssize_t indexOfKey(uint32_t key) const;
+    size_t insertionIndexFor(uint32_t key) const;
+
+    MetaData &operator=(const MetaData &);
 };
 
 }  // namespace android
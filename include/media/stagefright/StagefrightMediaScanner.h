@@ -19,6 +19,7 @@
 #define STAGEFRIGHT_MEDIA_SCANNER_H_
 
 #include <media/mediascanner.h>
+#include <media/stagefright/BatchMetadataRetriever.h>
 
 namespace android {
 
@@ -30,15 +31,31 @@ struct StagefrightMediaScanner : public MediaScanner {
             const char *path, const char *mimeType,
             MediaScannerClient &client);
 
+    // Retrieves up to one file per CPU in parallel.
+    virtual MediaScanResult processFiles(
+            const char *const *paths, size_t numPaths,
+            MediaScannerClient &client);
+
     virtual char *extractAlbumArt(int fd);
 
+    // Makes processFile() and processFiles() pass a thumbnail of files with
+    // video, scaled to fit within maxSize x maxSize, to
+    // MediaScannerClient::handleThumbnail(). 0 disables thumbnails.
+    void setMaxThumbnailSize(int32_t maxSize);
+
 private:
+    int32_t mMaxThumbnailSize;
+
     StagefrightMediaScanner(const StagefrightMediaScanner &);
     StagefrightMediaScanner &operator=(const StagefrightMediaScanner &);
 
     MediaScanResult processFileInternal(
             const char *path, const char *mimeType,
             MediaScannerClient &client);
+
+    MediaScanResult processRetrievedFile(
+            const sp<BatchMetadataRetriever::Result> &result,
+            MediaScannerClient &client);
 };
 
 }  // namespace android
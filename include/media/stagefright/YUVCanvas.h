@@ -55,6 +55,16 @@ public:
             int32_t destStartX, int32_t destStartY,
             const YUVImage &srcImage);
 
+    // Blends the region [startX,endX]x[startY,endY] from srcImage over the
+    // canvas' target image (mYUVImage) starting at
+    // (destinationStartX,destinationStartY), with alpha from 0 (keep the
+    // target) to 255 (copy the source). srcImage must have the same format
+    // as the target image.
+    void BlendImageRect(
+            const Rect& srcRect,
+            int32_t destStartX, int32_t destStartY,
+            const YUVImage &srcImage, uint8_t alpha);
+
     // Downsamples the srcImage into the canvas' target image (mYUVImage)
     // The downsampling copies pixels from the source image starting at
     // (srcOffsetX, srcOffsetY) to the target image, starting at (0, 0).
@@ -105,6 +105,32 @@ public:
             int32_t destStartX, int32_t destStartY,
             const YUVImage &srcImage, YUVImage &destImage);
 
+    // The operations below work a data row at a time, with NEON or SSE2
+    // where available. Like setPixelValue(), a pixel at odd coordinates
+    // shares the U/V values of its neighbours to the left and above.
+
+    // Sets all pixels in rect to the given YUV value.
+    void fillRectangle(const Rect& rect,
+            uint8_t yValue, uint8_t uValue, uint8_t vValue);
+
+    // Copies srcRect from srcImage into destImage starting at
+    // (destStartX, destStartY), converting between the planar and
+    // semi planar layouts if the formats differ.
+    static void copyRectangle(
+            const Rect& srcRect,
+            int32_t destStartX, int32_t destStartY,
+            const YUVImage &srcImage, YUVImage &destImage);
+
+    // Blends srcRect from srcImage over destImage starting at
+    // (destStartX, destStartY), every channel becomes
+    // (src * alpha + dest * (255 - alpha)) / 255, rounded.
+    // Returns false if the images have different formats.
+    static bool blendRectangle(
+            const Rect& srcRect,
+            int32_t destStartX, int32_t destStartY,
+            const YUVImage &srcImage, YUVImage &destImage,
+            uint8_t alpha);
+
     // Convert the given YUV value to RGB.
     void yuv2rgb(uint8_t yValue, uint8_t uValue, uint8_t vValue,
         uint8_t *r, uint8_t *g, uint8_t *b) const;
@@ -168,6 +194,19 @@ private:
     bool getYUVAddresses(int32_t x, int32_t y,
         uint8_t **yAddr, uint8_t **uAddr, uint8_t **vAddr) const;
 
+    // Returns the number of U/V data rows and columns covering the pixels
+    // [x, x + width - 1] x [y, y + height - 1].
+    static void getChromaExtent(int32_t x, int32_t y,
+        int32_t width, int32_t height,
+        int32_t *chromaWidth, int32_t *chromaHeight);
+
+    // Returns the source U/V column (or row), relative to the one of
+    // srcStart, whose value a pixel by pixel copy of length pixels leaves in
+    // the destination U/V column chromaIndex, relative to the one of
+    // destStart.
+    static int32_t getSourceChromaIndex(int32_t srcStart, int32_t destStart,
+        int32_t length, int32_t chromaIndex);
+
     // Disallow implicit casting and copying.
     YUVImage(const YUVImage &);
     YUVImage &operator=(const YUVImage &);
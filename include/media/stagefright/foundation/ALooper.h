@@ -24,6 +24,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/List.h>
 #include <utils/RefBase.h>
+#include <utils/Vector.h>
 #include <utils/threads.h>
 
 namespace android {
@@ -61,6 +62,7 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        uint32_t mSeqNo;
         sp<AMessage> mMessage;
     };
 
@@ -69,7 +71,11 @@ private:
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // Binary min-heap ordered by (mWhenUs, mSeqNo), the sequence number
+    // keeps events scheduled for the same time in the order they were
+    // posted.
+    Vector<Event> mEventQueue;
+    uint32_t mNextSeqNo;
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -78,6 +84,10 @@ private:
     void post(const sp<AMessage> &msg, int64_t delayUs);
     bool loop();
 
+    static bool IsEarlier(const Event &a, const Event &b);
+    void pushEvent_l(const Event &event);
+    void popEvent_l(Event *event);
+
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
 };
 
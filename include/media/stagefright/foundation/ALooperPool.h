@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_LOOPER_POOL_H_
+
+#define A_LOOPER_POOL_H_
+
+#include <pthread.h>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <utils/KeyedVector.h>
+#include <utils/Vector.h>
+#include <utils/threads.h>
+
+namespace android {
+
+struct AHandler;
+
+// A process-wide set of loopers, one per CPU core, shared by handlers that
+// do not need a thread of their own. Messages to any one handler are still
+// delivered in order on a single thread, but a handler blocking in
+// onMessageReceived will delay all other handlers sharing its looper.
+// The shared loopers run at ANDROID_PRIORITY_FOREGROUND.
+struct ALooperPool {
+    // Registers "handler" on the shared looper currently serving the fewest
+    // handlers and returns that looper, the loopers are started on first use.
+    static sp<ALooper> RegisterHandler(const sp<AHandler> &handler);
+
+    static void UnregisterHandler(ALooper::handler_id handlerID);
+
+    // Like UnregisterHandler, but also waits until the shared looper has
+    // finished delivering any message to the handler that was in progress.
+    // Must not be called from one of the shared loopers.
+    static void UnregisterHandlerAndWait(ALooper::handler_id handlerID);
+
+private:
+    struct BarrierHandler;
+
+    struct LooperInfo {
+        sp<ALooper> mLooper;
+        sp<BarrierHandler> mBarrier;
+        size_t mNumHandlers;
+    };
+
+    // Created on first use and never destroyed.
+    static pthread_once_t gLooperPoolOnce;
+    static ALooperPool *gLooperPool;
+
+    static void InitLooperPool();
+    static ALooperPool *Get();
+
+    Mutex mLock;
+    Vector<LooperInfo> mLoopers;
+
+    // Maps registered handlers to their index in "mLoopers".
+    KeyedVector<ALooper::handler_id, size_t> mHandlers;
+
+    ALooperPool();
+
+    sp<ALooper> registerHandler(const sp<AHandler> &handler);
+    void unregisterHandler(ALooper::handler_id handlerID, bool wait);
+
+    DISALLOW_EVIL_CONSTRUCTORS(ALooperPool);
+};
+
+}  // namespace android
+
+#endif  // A_LOOPER_POOL_H_
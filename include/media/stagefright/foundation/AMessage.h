@@ -110,6 +110,12 @@ struct AMessage : public RefBase {
     size_t countEntries() const;
     const char *getEntryNameAt(size_t index, Type *type) const;
 
+    // AMessage objects are created and destroyed at a very high rate by
+    // every looper round-trip, their storage is therefore recycled through
+    // a small process-wide pool instead of going back to the heap.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
 protected:
     virtual ~AMessage();
 
@@ -121,6 +127,13 @@ private:
         int32_t mLeft, mTop, mRight, mBottom;
     };
 
+    enum {
+        // Strings up to this length (excluding the terminating NUL) are
+        // stored inside the item itself instead of in a heap allocated
+        // AString.
+        kMaxInlineStringLength = 15
+    };
+
     struct Item {
         union {
             int32_t int32Value;
@@ -132,9 +145,11 @@ private:
             RefBase *refValue;
             AString *stringValue;
             Rect rectValue;
+            char inlineStringValue[kMaxInlineStringLength + 1];
         } u;
         const char *mName;
         Type mType;
+        bool mIsInlineString;
     };
 
     enum {
@@ -146,6 +161,8 @@ private:
     Item *allocateItem(const char *name);
     void freeItem(Item *item);
     const Item *findItem(const char *name, Type type) const;
+    ssize_t findItemIndex(const char *name) const;
+    static const char *StringValue(const Item &item);
 
     void setObjectInternal(
             const char *name, const sp<RefBase> &obj, Type type);
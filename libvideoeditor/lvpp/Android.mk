@@ -31,10 +31,12 @@ LOCAL_SRC_FILES:=          \
     VideoEditorAudioPlayer.cpp \
     VideoEditorPreviewController.cpp \
     VideoEditorSRC.cpp \
+    VideoReadAheadSource.cpp \
     DummyAudioSource.cpp \
     DummyVideoSource.cpp \
     VideoEditorBGAudioProcessing.cpp \
     PreviewRenderer.cpp \
+    RenderedFrameCache.cpp \
     I420ColorConverter.cpp \
     NativeWindowRenderer.cpp
 
@@ -63,6 +65,7 @@ LOCAL_SHARED_LIBRARIES :=     \
     libui                     \
     libutils                  \
     libvideoeditor_osal       \
+    libvideoeditor_videofilters \
 
 
 LOCAL_C_INCLUDES += \
@@ -38,6 +38,7 @@
 #include "DummyAudioSource.h"
 #include "DummyVideoSource.h"
 #include "VideoEditorSRC.h"
+#include "VideoReadAheadSource.h"
 #include "PreviewPlayer.h"
 
 namespace android {
@@ -753,12 +754,17 @@ status_t PreviewPlayer::initVideoDecoder_l(uint32_t flags) {
         return UNKNOWN_ERROR;
     }
 
-    mVideoSource = OMXCodec::Create(
+    sp<MediaSource> decoder = OMXCodec::Create(
             mClient.interface(), mVideoTrack->getFormat(),
             false,
             mVideoTrack,
             NULL, flags, mVideoRenderer->getTargetWindow());
 
+    if (decoder != NULL) {
+        // Keep a few frames decoded ahead of onVideoEvent
+        mVideoSource = new VideoReadAheadSource(decoder);
+    }
+
     if (mVideoSource != NULL) {
         int64_t durationUs;
         if (mVideoTrack->getFormat()->findInt64(kKeyDuration, &durationUs)) {
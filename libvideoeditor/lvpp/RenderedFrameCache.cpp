@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "RenderedFrameCache"
+#include <utils/Log.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "RenderedFrameCache.h"
+
+namespace android {
+
+RenderedFrameCache::RenderedFrameCache()
+    : mUseCount(0) {
+    memset(mFrames, 0, sizeof(mFrames));
+}
+
+RenderedFrameCache::~RenderedFrameCache() {
+    clear();
+}
+
+// Key only holds uint32_t fields, so there is no padding to compare.
+bool RenderedFrameCache::sameKey(const Key &a, const Key &b) {
+    return !memcmp(&a, &b, sizeof(Key));
+}
+
+uint8_t *RenderedFrameCache::lookup(const Key &key) {
+    for (int i = 0; i < kNumFrames; i++) {
+        Frame *frame = &mFrames[i];
+        if (frame->valid && sameKey(frame->key, key)) {
+            frame->lastUse = ++mUseCount;
+            ALOGV("hit at %d ms", key.timeMs);
+            return frame->data;
+        }
+    }
+    return NULL;
+}
+
+uint8_t *RenderedFrameCache::reserve(const Key &key, size_t size) {
+    Frame *victim = &mFrames[0];
+    for (int i = 0; i < kNumFrames; i++) {
+        Frame *frame = &mFrames[i];
+        if (frame->data == NULL || !frame->valid) {
+            victim = frame;
+            break;
+        }
+        if (frame->lastUse < victim->lastUse) {
+            victim = frame;
+        }
+    }
+
+    victim->valid = false;
+    if (victim->size != size) {
+        free(victim->data);
+        victim->data = (uint8_t *)malloc(size);
+        victim->size = (victim->data != NULL) ? size : 0;
+    }
+    if (victim->data == NULL) {
+        ALOGW("cannot allocate %d bytes, frame not cached", (int)size);
+        return NULL;
+    }
+
+    victim->key = key;
+    victim->lastUse = ++mUseCount;
+    return victim->data;
+}
+
+void RenderedFrameCache::commit(const Key &key) {
+    for (int i = 0; i < kNumFrames; i++) {
+        Frame *frame = &mFrames[i];
+        if (frame->data != NULL && sameKey(frame->key, key)) {
+            frame->valid = true;
+            return;
+        }
+    }
+}
+
+void RenderedFrameCache::clear() {
+    for (int i = 0; i < kNumFrames; i++) {
+        free(mFrames[i].data);
+    }
+    memset(mFrames, 0, sizeof(mFrames));
+}
+
+uint32_t RenderedFrameCache::checksum(const uint8_t *data, size_t size) {
+    uint32_t sum = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum = ((sum << 5) | (sum >> 27)) ^ word;
+    }
+    for (; i < size; i++) {
+        sum = ((sum << 5) | (sum >> 27)) ^ data[i];
+    }
+    return sum;
+}
+
+}  // namespace android
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RENDERED_FRAME_CACHE_H_
+#define RENDERED_FRAME_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// Keeps the last few preview frames after rotation, effects and rendering
+// mode, so scrubbing back over the same storyboard position only copies the
+// result into the window buffer. Frames are stored as YV12 with a stride of
+// stride(width) so they do not depend on the window buffer layout.
+// Not thread safe, the preview controller calls it under its own lock.
+class RenderedFrameCache {
+public:
+    // Everything the rendered frame depends on. The checksum of the decoded
+    // frame protects against a storyboard edit that reuses the same time.
+    struct Key {
+        uint32_t timeMs;
+        uint32_t clipBeginCutTime;
+        uint32_t clipEndCutTime;
+        uint32_t frameWidth;
+        uint32_t frameHeight;
+        uint32_t rotationDegree;
+        uint32_t applyEffect;
+        uint32_t videoEffect;
+        uint32_t renderingMode;
+        uint32_t outputWidth;
+        uint32_t outputHeight;
+        uint32_t frameChecksum;
+    };
+
+    RenderedFrameCache();
+    ~RenderedFrameCache();
+
+    // Returns the cached frame for key, or NULL.
+    uint8_t *lookup(const Key &key);
+
+    // Returns a buffer of size bytes to render the frame for key into,
+    // evicting the least recently used frame. The frame is only returned
+    // by lookup() once commit() has been called for it.
+    uint8_t *reserve(const Key &key, size_t size);
+    void commit(const Key &key);
+
+    void clear();
+
+    static size_t stride(uint32_t width) {
+        return (width + 31) & ~31;
+    }
+
+    static uint32_t checksum(const uint8_t *data, size_t size);
+
+private:
+    enum {
+        kNumFrames = 4,
+    };
+
+    struct Frame {
+        Key key;
+        bool valid;
+        uint32_t lastUse;
+        uint8_t *data;
+        size_t size;
+    };
+
+    Frame mFrames[kNumFrames];
+    uint32_t mUseCount;
+
+    static bool sameKey(const Key &a, const Key &b);
+
+    RenderedFrameCache(const RenderedFrameCache &);
+    RenderedFrameCache &operator=(const RenderedFrameCache &);
+};
+
+}  // namespace android
+
+#endif  // RENDERED_FRAME_CACHE_H_
@@ -30,6 +30,8 @@
 #include <system/audio.h>
 
 #include "PreviewPlayer.h"
+#include "M4PCM_Mix.h"
+
 namespace android {
 
 VideoEditorAudioPlayer::VideoEditorAudioPlayer(
@@ -885,10 +887,7 @@ void VideoEditorAudioPlayer::setAudioMixStoryBoardSkimTimeStamp(
 void VideoEditorAudioPlayer::setPrimaryTrackVolume(
     M4OSA_Int16 *data, M4OSA_UInt32 size, M4OSA_Float volLevel) {
 
-    while(size-- > 0) {
-        *data = (M4OSA_Int16)((*data)*volLevel);
-        data++;
-    }
+    M4PCM_scale(data, data, size, volLevel);
 }
 
 }
@@ -18,6 +18,7 @@
 #define LOG_TAG "VideoEditorBGAudioProcessing"
 #include <utils/Log.h>
 #include "VideoEditorBGAudioProcessing.h"
+#include "M4PCM_Mix.h"
 
 namespace android {
 
@@ -61,37 +62,15 @@ M4OSA_Int32 VideoEditorBGAudioProcessing::mixAndDuck(
     // Output size if same as PT size
     pMixedOutBuffer->m_bufferSize = pPrimaryTrack->m_bufferSize;
 
-    // Before mixing, we need to have only PT as out buffer
-    memcpy((void *)pMixedOutBuffer->m_dataAddress,
-        (void *)pPrimaryTrack->m_dataAddress, pMixedOutBuffer->m_bufferSize);
-
-    // Initialize ducking variables
-    // Initially contains the input primary track
-    M4OSA_Int16 *pPTMdata2 = (M4OSA_Int16*)pMixedOutBuffer->m_dataAddress;
-
-    // Contains BG track processed data(like channel conversion etc..
-    M4OSA_Int16 *pBTMdata1 = (M4OSA_Int16*) pBackgroundTrack->m_dataAddress;
+    M4OSA_Int16 *pPTMdata = (M4OSA_Int16*)pPrimaryTrack->m_dataAddress;
+    M4OSA_Int16 *pBTMdata = (M4OSA_Int16*)pBackgroundTrack->m_dataAddress;
 
     // Since we need to give sample count and not buffer size
     M4OSA_UInt32 uiPCMsize = pMixedOutBuffer->m_bufferSize / 2 ;
 
     if ((mDucking_enable) && (mPTVolLevel != 0.0)) {
-        M4OSA_Int32 peakDbValue = 0;
-        M4OSA_Int32 previousDbValue = 0;
-        M4OSA_Int16 *pPCM16Sample = (M4OSA_Int16*)pPrimaryTrack->m_dataAddress;
-        const size_t n = pPrimaryTrack->m_bufferSize / sizeof(M4OSA_Int16);
-
-        for (size_t loopIndex = 0; loopIndex < n; ++loopIndex) {
-            if (pPCM16Sample[loopIndex] >= 0) {
-                peakDbValue = previousDbValue > pPCM16Sample[loopIndex] ?
-                        previousDbValue : pPCM16Sample[loopIndex];
-                previousDbValue = peakDbValue;
-            } else {
-                peakDbValue = previousDbValue > -pPCM16Sample[loopIndex] ?
-                        previousDbValue: -pPCM16Sample[loopIndex];
-                previousDbValue = peakDbValue;
-            }
-        }
+        M4OSA_Int32 peakDbValue = M4PCM_peak(pPTMdata,
+                pPrimaryTrack->m_bufferSize / sizeof(M4OSA_Int16));
 
         mAudioVolumeArray[mAudVolArrIndex] = getDecibelSound(peakDbValue);
 
@@ -138,54 +117,12 @@ M4OSA_Int32 VideoEditorBGAudioProcessing::mixAndDuck(
     } // end if - mDucking_enable
 
 
-    // Mixing logic
+    // Mixing logic, the mix is written straight to the out buffer
     ALOGV("Out of Ducking analysis uiPCMsize %d %f %f",
             mDoDucking, mDuckingFactor, mBTVolLevel);
-    while (uiPCMsize-- > 0) {
-
-        // Set vol factor for BT and PT
-        *pBTMdata1 = (M4OSA_Int16)(*pBTMdata1*mBTVolLevel);
-        *pPTMdata2 = (M4OSA_Int16)(*pPTMdata2*mPTVolLevel);
-
-        // Mix the two samples
-        if (mDoDucking) {
-
-            // Duck the BG track to ducking factor value before mixing
-            *pBTMdata1 = (M4OSA_Int16)((*pBTMdata1)*(mDuckingFactor));
-
-            // mix as normal case
-            *pBTMdata1 = (M4OSA_Int16)(*pBTMdata1 /2 + *pPTMdata2 /2);
-        } else {
-
-            *pBTMdata1 = (M4OSA_Int16)((*pBTMdata1)*(mDuckingFactor));
-            *pBTMdata1 = (M4OSA_Int16)(*pBTMdata1 /2 + *pPTMdata2 /2);
-        }
-
-        M4OSA_Int32 temp;
-        if (*pBTMdata1 < 0) {
-            temp = -(*pBTMdata1) * 2; // bring to original Amplitude level
-
-            if (temp > 32767) {
-                *pBTMdata1 = -32766; // less then max allowed value
-            } else {
-                *pBTMdata1 = (M4OSA_Int16)(-temp);
-            }
-        } else {
-            temp = (*pBTMdata1) * 2; // bring to original Amplitude level
-            if ( temp > 32768) {
-                *pBTMdata1 = 32767; // less than max allowed value
-            } else {
-                *pBTMdata1 = (M4OSA_Int16)temp;
-            }
-        }
-
-        pBTMdata1++;
-        pPTMdata2++;
-    }
-
-    memcpy((void *)pMixedOutBuffer->m_dataAddress,
-        (void *)pBackgroundTrack->m_dataAddress,
-        pBackgroundTrack->m_bufferSize);
+    M4PCM_mixAndDuck((M4OSA_Int16*)pMixedOutBuffer->m_dataAddress,
+            pPTMdata, pBTMdata, uiPCMsize,
+            mPTVolLevel, mBTVolLevel, mDuckingFactor);
 
     ALOGV("mixAndDuck: X");
     return M4NO_ERROR;
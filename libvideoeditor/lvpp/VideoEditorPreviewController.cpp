@@ -168,6 +168,9 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
     // Clean up any previous Edit settings before loading new ones
     mCurrentVideoEffect = VIDEO_EFFECT_NONE;
 
+    // The rendered frames used the previous effects
+    mFrameCache.clear();
+
     if(mAudioMixPCMFileHandle) {
         err = M4OSA_fileReadClose (mAudioMixPCMFileHandle);
         mAudioMixPCMFileHandle = M4OSA_NULL;
@@ -798,7 +801,6 @@ M4OSA_ERR VideoEditorPreviewController::renderPreviewFrame(
     M4OSA_ERR err = M4NO_ERROR;
     M4OSA_UInt32 i = 0, iIncrementedDuration = 0, tnTimeMs=0, framesize =0;
     VideoEditor_renderPreviewFrameStr* pFrameStr = pFrameInfo;
-    M4VIFI_UInt8 *pixelArray = NULL;
     Mutex::Autolock autoLock(mLock);
 
     if (pCurrEditInfo != NULL) {
@@ -830,29 +832,8 @@ M4OSA_ERR VideoEditorPreviewController::renderPreviewFrame(
         }
     }
 
-    pixelArray = NULL;
-
-    // Apply rotation if required
-    if (pFrameStr->videoRotationDegree != 0) {
-        err = applyVideoRotation((M4OSA_Void *)pFrameStr->pBuffer,
-                  pFrameStr->uiFrameWidth, pFrameStr->uiFrameHeight,
-                  pFrameStr->videoRotationDegree);
-        if (M4NO_ERROR != err) {
-            ALOGE("renderPreviewFrame: cannot rotate video, err 0x%x", (unsigned int)err);
-            delete mTarget;
-            mTarget = NULL;
-            return err;
-        } else {
-           // Video rotation done.
-           // Swap width and height if 90 or 270 degrees
-           if (pFrameStr->videoRotationDegree != 180) {
-               int32_t temp = pFrameStr->uiFrameWidth;
-               pFrameStr->uiFrameWidth = pFrameStr->uiFrameHeight;
-               pFrameStr->uiFrameHeight = temp;
-           }
-        }
-    }
-    // Postprocessing (apply video effect)
+    // Find the effects active at this time, they only depend on the
+    // storyboard position and not on the frame content.
     if(pFrameStr->bApplyEffect == M4OSA_TRUE) {
 
         for(i=0;i<mNumberEffects;i++) {
@@ -897,59 +878,153 @@ M4OSA_ERR VideoEditorPreviewController::renderPreviewFrame(
                 ALOGV("No framing effects found");
             }
         }
+    }
+
+    // Set the output YUV420 plane to be compatible with YV12 format
+    //In YV12 format, sizes must be even
+    M4OSA_UInt32 yv12PlaneWidth = ((mOutputVideoWidth +1)>>1)<<1;
+    M4OSA_UInt32 yv12PlaneHeight = ((mOutputVideoHeight+1)>>1)<<1;
+
+    // Scrubbing over the same position renders the same frame again, reuse
+    // it when nothing it depends on has changed. The fifties effect is
+    // random so it is always rendered.
+    RenderedFrameCache::Key key;
+    M4OSA_Bool bUseCache = !(mCurrentVideoEffect & VIDEO_EFFECT_FIFTIES);
+    uint8_t *cachedFrame = NULL;
+
+    if (bUseCache) {
+        memset(&key, 0, sizeof(key));
+        key.timeMs = pFrameStr->timeMs;
+        key.clipBeginCutTime = pFrameStr->clipBeginCutTime;
+        key.clipEndCutTime = pFrameStr->clipEndCutTime;
+        key.frameWidth = pFrameStr->uiFrameWidth;
+        key.frameHeight = pFrameStr->uiFrameHeight;
+        key.rotationDegree = pFrameStr->videoRotationDegree;
+        key.applyEffect = pFrameStr->bApplyEffect;
+        key.videoEffect = mCurrentVideoEffect;
+        key.renderingMode = mRenderingMode;
+        key.outputWidth = yv12PlaneWidth;
+        key.outputHeight = yv12PlaneHeight;
+        key.frameChecksum = RenderedFrameCache::checksum(
+                (const uint8_t *)pFrameStr->pBuffer,
+                (pFrameStr->uiFrameWidth * pFrameStr->uiFrameHeight * 3) >> 1);
+
+        cachedFrame = mFrameCache.lookup(key);
+    }
+
+    if (cachedFrame != NULL) {
+        if(pFrameStr->bApplyEffect == M4OSA_TRUE) {
+            mCurrentVideoEffect = VIDEO_EFFECT_NONE;
+        }
+        copyCachedFrame(cachedFrame, yv12PlaneWidth, yv12PlaneHeight);
+        mTarget->renderYV12();
+        return err;
+    }
 
-        if(mCurrentVideoEffect != VIDEO_EFFECT_NONE) {
-            err = applyVideoEffect((M4OSA_Void *)pFrameStr->pBuffer,
-             OMX_COLOR_FormatYUV420Planar, pFrameStr->uiFrameWidth,
-             pFrameStr->uiFrameHeight, pFrameStr->timeMs,
-             (M4OSA_Void *)pixelArray);
-
-            if(err != M4NO_ERROR) {
-                ALOGE("renderPreviewFrame: applyVideoEffect error 0x%x", (unsigned int)err);
-                delete mTarget;
-                mTarget = NULL;
-                free(pixelArray);
-                pixelArray = NULL;
-                return err;
+    // Apply rotation if required
+    if (pFrameStr->videoRotationDegree != 0) {
+        err = applyVideoRotation((M4OSA_Void *)pFrameStr->pBuffer,
+                  pFrameStr->uiFrameWidth, pFrameStr->uiFrameHeight,
+                  pFrameStr->videoRotationDegree);
+        if (M4NO_ERROR != err) {
+            ALOGE("renderPreviewFrame: cannot rotate video, err 0x%x", (unsigned int)err);
+            delete mTarget;
+            mTarget = NULL;
+            return err;
+        } else {
+           // Video rotation done.
+           // Swap width and height if 90 or 270 degrees
+           if (pFrameStr->videoRotationDegree != 180) {
+               int32_t temp = pFrameStr->uiFrameWidth;
+               pFrameStr->uiFrameWidth = pFrameStr->uiFrameHeight;
+               pFrameStr->uiFrameHeight = temp;
            }
-           mCurrentVideoEffect = VIDEO_EFFECT_NONE;
         }
-        else {
-            // Apply the rendering mode
-            err = doImageRenderingMode((M4OSA_Void *)pFrameStr->pBuffer,
-             OMX_COLOR_FormatYUV420Planar, pFrameStr->uiFrameWidth,
-             pFrameStr->uiFrameHeight, (M4OSA_Void *)pixelArray);
-
-            if(err != M4NO_ERROR) {
-                ALOGE("renderPreviewFrame:doImageRenderingMode error 0x%x", (unsigned int)err);
-                delete mTarget;
-                mTarget = NULL;
-                free(pixelArray);
-                pixelArray = NULL;
-                return err;
-            }
+    }
+
+    // Render into the cache when possible, the result is copied to the
+    // surface afterwards. Otherwise render straight into the surface.
+    uint8_t *outBuffer = NULL;
+    size_t outBufferStride = 0;
+
+    if (bUseCache) {
+        outBufferStride = RenderedFrameCache::stride(yv12PlaneWidth);
+        cachedFrame = mFrameCache.reserve(key,
+                (outBufferStride * yv12PlaneHeight * 3) >> 1);
+        outBuffer = cachedFrame;
+    }
+    if (outBuffer == NULL) {
+        ALOGV("renderPreviewFrame CALL getBuffer()");
+        mTarget->getBufferYV12(&outBuffer, &outBufferStride);
+    }
+
+    // Postprocessing (apply video effect)
+    if((pFrameStr->bApplyEffect == M4OSA_TRUE) &&
+       (mCurrentVideoEffect != VIDEO_EFFECT_NONE)) {
+        err = applyVideoEffect((M4OSA_Void *)pFrameStr->pBuffer,
+         OMX_COLOR_FormatYUV420Planar, pFrameStr->uiFrameWidth,
+         pFrameStr->uiFrameHeight, pFrameStr->timeMs,
+         outBuffer, outBufferStride);
+
+        if(err != M4NO_ERROR) {
+            ALOGE("renderPreviewFrame: applyVideoEffect error 0x%x", (unsigned int)err);
+            delete mTarget;
+            mTarget = NULL;
+            return err;
         }
+        mCurrentVideoEffect = VIDEO_EFFECT_NONE;
     }
     else {
         // Apply the rendering mode
         err = doImageRenderingMode((M4OSA_Void *)pFrameStr->pBuffer,
          OMX_COLOR_FormatYUV420Planar, pFrameStr->uiFrameWidth,
-         pFrameStr->uiFrameHeight, (M4OSA_Void *)pixelArray);
+         pFrameStr->uiFrameHeight, outBuffer, outBufferStride);
 
         if(err != M4NO_ERROR) {
             ALOGE("renderPreviewFrame: doImageRenderingMode error 0x%x", (unsigned int)err);
             delete mTarget;
             mTarget = NULL;
-            free(pixelArray);
-            pixelArray = NULL;
             return err;
         }
     }
 
+    if (cachedFrame != NULL) {
+        mFrameCache.commit(key);
+        copyCachedFrame(cachedFrame, yv12PlaneWidth, yv12PlaneHeight);
+    }
+
     mTarget->renderYV12();
     return err;
 }
 
+void VideoEditorPreviewController::copyCachedFrame(
+    const uint8_t *frame, M4OSA_UInt32 width, M4OSA_UInt32 height) {
+
+    M4VIFI_ImagePlane planeIn[3], planeOut[3];
+    uint8_t* outBuffer = NULL;
+    size_t outBufferStride = 0;
+
+    mTarget->getBufferYV12(&outBuffer, &outBufferStride);
+    if (outBuffer == NULL) {
+        return;
+    }
+
+    prepareYV12ImagePlane(planeIn, width, height,
+     (M4OSA_UInt32)RenderedFrameCache::stride(width), (M4VIFI_UInt8 *)frame);
+    prepareYV12ImagePlane(planeOut, width, height,
+     (M4OSA_UInt32)outBufferStride, (M4VIFI_UInt8 *)outBuffer);
+
+    for (int plane = 0; plane < 3; plane++) {
+        const M4VIFI_UInt8 *src = planeIn[plane].pac_data;
+        M4VIFI_UInt8 *dst = planeOut[plane].pac_data;
+        for (M4OSA_UInt32 y = 0; y < planeOut[plane].u_height; y++) {
+            memcpy(dst, src, planeOut[plane].u_width);
+            src += planeIn[plane].u_stride;
+            dst += planeOut[plane].u_stride;
+        }
+    }
+}
+
 M4OSA_Void VideoEditorPreviewController::setJniCallback(void* cookie,
     jni_progress_callback_fct callbackFct) {
     //ALOGV("setJniCallback");
@@ -1376,7 +1451,8 @@ void VideoEditorPreviewController::setVideoEffectType(
 
 M4OSA_ERR VideoEditorPreviewController::applyVideoEffect(
     M4OSA_Void * dataPtr, M4OSA_UInt32 colorFormat, M4OSA_UInt32 videoWidth,
-    M4OSA_UInt32 videoHeight, M4OSA_UInt32 timeMs, M4OSA_Void* outPtr) {
+    M4OSA_UInt32 videoHeight, M4OSA_UInt32 timeMs,
+    uint8_t* outBuffer, size_t outBufferStride) {
 
     M4OSA_ERR err = M4NO_ERROR;
     vePostProcessParams postProcessParams;
@@ -1403,7 +1479,8 @@ M4OSA_ERR VideoEditorPreviewController::applyVideoEffect(
     postProcessParams.overlayFrameRGBBuffer = NULL;
     postProcessParams.overlayFrameYUVBuffer = NULL;
 
-    mTarget->getBufferYV12(&(postProcessParams.pOutBuffer), &(postProcessParams.outBufferStride));
+    postProcessParams.pOutBuffer = outBuffer;
+    postProcessParams.outBufferStride = outBufferStride;
 
     err = applyEffectsAndRenderingMode(&postProcessParams, videoWidth, videoHeight);
     return err;
@@ -1425,7 +1502,7 @@ status_t VideoEditorPreviewController::setPreviewFrameRenderingMode(
 
 M4OSA_ERR VideoEditorPreviewController::doImageRenderingMode(
     M4OSA_Void * dataPtr, M4OSA_UInt32 colorFormat, M4OSA_UInt32 videoWidth,
-    M4OSA_UInt32 videoHeight, M4OSA_Void* outPtr) {
+    M4OSA_UInt32 videoHeight, uint8_t* outBuffer, size_t outBufferStride) {
 
     M4OSA_ERR err = M4NO_ERROR;
     M4VIFI_ImagePlane planeIn[3], planeOut[3];
@@ -1442,18 +1519,12 @@ M4OSA_ERR VideoEditorPreviewController::doImageRenderingMode(
     outputBufferWidth = mOutputVideoWidth;
     outputBufferHeight = mOutputVideoHeight;
 
-    // Out plane
-    uint8_t* outBuffer;
-    size_t outBufferStride = 0;
-
-    ALOGV("doMediaRendering CALL getBuffer()");
-    mTarget->getBufferYV12(&outBuffer, &outBufferStride);
-
     // Set the output YUV420 plane to be compatible with YV12 format
     //In YV12 format, sizes must be even
     M4OSA_UInt32 yv12PlaneWidth = ((mOutputVideoWidth +1)>>1)<<1;
     M4OSA_UInt32 yv12PlaneHeight = ((mOutputVideoHeight+1)>>1)<<1;
 
+    // Out plane
     prepareYV12ImagePlane(planeOut, yv12PlaneWidth, yv12PlaneHeight,
      (M4OSA_UInt32)outBufferStride, (M4VIFI_UInt8 *)outBuffer);
 
@@ -19,6 +19,7 @@
 
 #include "VideoEditorPlayer.h"
 #include "VideoEditorTools.h"
+#include "RenderedFrameCache.h"
 
 namespace android {
 
@@ -129,6 +130,9 @@ private:
     M4VIFI_UInt8*  mFrameYUVBuffer;
     mutable Mutex mLockSem;
 
+    // Frames rendered by renderPreviewFrame, protected by mLock
+    RenderedFrameCache mFrameCache;
+
 
     static M4OSA_ERR preparePlayer(void* param, int playerInstance, int index);
     static M4OSA_ERR threadProc(M4OSA_Void* param);
@@ -139,12 +143,17 @@ private:
     M4OSA_ERR applyVideoEffect(
             M4OSA_Void * dataPtr, M4OSA_UInt32 colorFormat,
             M4OSA_UInt32 videoWidth, M4OSA_UInt32 videoHeight,
-            M4OSA_UInt32 timeMs, M4OSA_Void* outPtr);
+            M4OSA_UInt32 timeMs,
+            uint8_t* outBuffer, size_t outBufferStride);
 
     M4OSA_ERR doImageRenderingMode(
             M4OSA_Void * dataPtr,
             M4OSA_UInt32 colorFormat, M4OSA_UInt32 videoWidth,
-            M4OSA_UInt32 videoHeight, M4OSA_Void* outPtr);
+            M4OSA_UInt32 videoHeight,
+            uint8_t* outBuffer, size_t outBufferStride);
+
+    void copyCachedFrame(
+            const uint8_t *frame, M4OSA_UInt32 width, M4OSA_UInt32 height);
 
     // Don't call me!
     VideoEditorPreviewController(const VideoEditorPreviewController &);
@@ -46,6 +46,9 @@ VideoEditorSRC::VideoEditorSRC(const sp<MediaSource> &source) {
     mFormatChanged = false;
     mStopPending = false;
     mSeekMode = ReadOptions::SEEK_PREVIOUS_SYNC;
+    mResampleBuffer = NULL;
+    mInputBuffer = NULL;
+    mInputBufferSize = 0;
 
     // Input Source validation
     sp<MetaData> format = mSource->getFormat();
@@ -63,6 +66,8 @@ VideoEditorSRC::VideoEditorSRC(const sp<MediaSource> &source) {
 VideoEditorSRC::~VideoEditorSRC() {
     ALOGV("~VideoEditorSRC %p(%p)", this, mSource.get());
     stop();
+    free(mResampleBuffer);
+    free(mInputBuffer);
 }
 
 status_t VideoEditorSRC::start(MetaData *params) {
@@ -132,14 +137,18 @@ status_t VideoEditorSRC::read(
         // resampler output is always 2 channels and 32 bits
         const size_t kOutputFrameCount = 1024;
         const size_t kBytes = kOutputFrameCount * 2 * sizeof(int32_t);
-        int32_t *pTmpBuffer = (int32_t *)calloc(1, kBytes);
-        if (!pTmpBuffer) {
-            ALOGE("calloc failed to allocate memory: %d bytes", kBytes);
-            return NO_MEMORY;
+        if (mResampleBuffer == NULL) {
+            mResampleBuffer = (int32_t *)malloc(kBytes);
+            if (!mResampleBuffer) {
+                ALOGE("malloc failed to allocate memory: %d bytes", kBytes);
+                return NO_MEMORY;
+            }
         }
+        // The resampler accumulates into the buffer
+        memset(mResampleBuffer, 0, kBytes);
 
         // Resample to target quality
-        mResampler->resample(pTmpBuffer, kOutputFrameCount, this);
+        mResampler->resample(mResampleBuffer, kOutputFrameCount, this);
 
         if (mStopPending) {
             stop();
@@ -150,7 +159,6 @@ status_t VideoEditorSRC::read(
         if (mFormatChanged) {
             mFormatChanged = false;
             checkAndSetResampler();
-            free(pTmpBuffer);
             return read(buffer_out, NULL);
         }
 
@@ -161,8 +169,7 @@ status_t VideoEditorSRC::read(
         // Convert back to 2 channels and 16 bits
         ditherAndClamp(
                 (int32_t *)((uint8_t*)outBuffer->data() + outBuffer->range_offset()),
-                pTmpBuffer, kOutputFrameCount);
-        free(pTmpBuffer);
+                mResampleBuffer, kOutputFrameCount);
 
         // Compute and set the new timestamp
         sp<MetaData> to = outBuffer->meta_data();
@@ -202,7 +209,22 @@ status_t VideoEditorSRC::getNextBuffer(AudioBufferProvider::Buffer *pBuffer, int
     ALOGV("getNextBuffer %d, chan = %d", pBuffer->frameCount, mChannelCnt);
     uint32_t done = 0;
     uint32_t want = pBuffer->frameCount * mChannelCnt * 2;
-    pBuffer->raw = malloc(want);
+
+    // The resampler holds at most one buffer at a time, so the same
+    // memory is handed out on every call
+    if (want > mInputBufferSize) {
+        free(mInputBuffer);
+        mInputBuffer = (uint8_t *)malloc(want);
+        if (mInputBuffer == NULL) {
+            ALOGE("malloc failed to allocate memory: %d bytes", want);
+            mInputBufferSize = 0;
+            pBuffer->raw = NULL;
+            pBuffer->frameCount = 0;
+            return NO_MEMORY;
+        }
+        mInputBufferSize = want;
+    }
+    pBuffer->raw = mInputBuffer;
 
     while (mStarted && want > 0) {
         // If we don't have any data left, read a new buffer.
@@ -221,7 +243,6 @@ status_t VideoEditorSRC::getNextBuffer(AudioBufferProvider::Buffer *pBuffer, int
             status_t err = mSource->read(&mBuffer, &options);
 
             if (err != OK) {
-                free(pBuffer->raw);
                 pBuffer->raw = NULL;
                 pBuffer->frameCount = 0;
             }
@@ -285,7 +306,7 @@ status_t VideoEditorSRC::getNextBuffer(AudioBufferProvider::Buffer *pBuffer, int
 
 void VideoEditorSRC::releaseBuffer(AudioBufferProvider::Buffer *pBuffer) {
     ALOGV("releaseBuffer: %p", pBuffers);
-    free(pBuffer->raw);
+    // mInputBuffer is reused by the next getNextBuffer()
     pBuffer->raw = NULL;
     pBuffer->frameCount = 0;
 }
@@ -299,14 +320,10 @@ void VideoEditorSRC::checkAndSetResampler() {
     CHECK(format->findCString(kKeyMIMEType, &mime));
     CHECK(!strcasecmp(mime, MEDIA_MIMETYPE_AUDIO_RAW));
 
-    CHECK(format->findInt32(kKeySampleRate, &mSampleRate));
-    CHECK(format->findInt32(kKeyChannelCount, &mChannelCnt));
-
-    // If a resampler exists, delete it first
-    if (mResampler != NULL) {
-        delete mResampler;
-        mResampler = NULL;
-    }
+    int32_t sampleRate;
+    int32_t channelCnt;
+    CHECK(format->findInt32(kKeySampleRate, &sampleRate));
+    CHECK(format->findInt32(kKeyChannelCount, &channelCnt));
 
     // Clear previous buffer
     if (mBuffer) {
@@ -314,6 +331,23 @@ void VideoEditorSRC::checkAndSetResampler() {
         mBuffer = NULL;
     }
 
+    // A format change that keeps the rate and the channel count does not
+    // need a new resampler, the current one keeps its filter state
+    if (mResampler != NULL
+            && sampleRate == mSampleRate && channelCnt == mChannelCnt) {
+        ALOGV("Keeping the resampler (%d Hz, # channels = %d)",
+            mSampleRate, mChannelCnt);
+        return;
+    }
+    mSampleRate = sampleRate;
+    mChannelCnt = channelCnt;
+
+    // If a resampler exists, delete it first
+    if (mResampler != NULL) {
+        delete mResampler;
+        mResampler = NULL;
+    }
+
     if (mSampleRate != mOutputSampleRate || mChannelCnt != 2) {
         ALOGV("Resampling required (%d => %d Hz, # channels = %d)",
             mSampleRate, mOutputSampleRate, mChannelCnt);
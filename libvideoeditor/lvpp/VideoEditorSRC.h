@@ -74,6 +74,11 @@ private:
     int64_t mSeekTimeUs;
     ReadOptions::SeekMode mSeekMode;
 
+    // Resampler output and input buffers, kept for the life of the source
+    int32_t *mResampleBuffer;
+    uint8_t *mInputBuffer;
+    size_t mInputBufferSize;
+
     VideoEditorSRC();
     void checkAndSetResampler();
 
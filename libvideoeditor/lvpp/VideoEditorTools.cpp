@@ -15,6 +15,7 @@
  */
 
 #include "VideoEditorTools.h"
+#include "M4VIFI_RowFilters.h"
 #include "PreviewRenderer.h"
 /*+ Handle the image files here */
 #include <utils/Log.h>
@@ -353,7 +354,7 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
             M4VSS3GPP_ExternalProgress *pProgress, M4OSA_UInt32 uiEffectKind) {
 
     M4VIFI_Int32 plane_number;
-    M4VIFI_UInt32 i,j;
+    M4VIFI_UInt32 i;
     M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
     M4xVSS_ColorStruct* ColorContext = (M4xVSS_ColorStruct*)pFunctionContext;
 
@@ -471,10 +472,8 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
                 switch (ColorContext->colorEffectType)
                 {
                 case M4xVSS_kVideoEffectType_Negative:
-                    for(j=0;j<PlaneOut[plane_number].u_width;j++)
-                    {
-                            p_buf_dest[j] = 255 - p_buf_src[j];
-                    }
+                    M4VIFI_InvertRow(p_buf_dest, p_buf_src,
+                     PlaneOut[plane_number].u_width);
                     break;
                 default:
                     memcpy((void *)p_buf_dest,
@@ -849,57 +848,50 @@ unsigned char M4VFL_modifyLumaWithScale(M4ViComImagePlane *plane_in,
     u_stride_out = plane_out[1].u_stride;
     p_cdest_line = (unsigned char *) &plane_out[1].pac_data[plane_out[1].u_topleft];
     p_csrc_line = (unsigned char *) &plane_in[1].pac_data[plane_in[1].u_topleft];
+    p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
+    p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
 
-    if (lum_factor > 256)
+    for (j = u_height; j != 0; j--)
     {
-        p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        /* copy chroma */
-        for (j = u_height; j != 0; j--)
+        if (lum_factor > 256)
         {
-            for (i = u_width; i != 0; i--)
-            {
-                memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
-                memcpy((void *)p_cdest, (void *)p_csrc, u_width);
-            }
-            p_cdest_line += u_stride_out;
-            p_cdest += u_stride_out;
-            p_csrc_line += u_stride;
-            p_csrc += u_stride;
+            /* copy chroma */
+            memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
+            memcpy((void *)p_cdest, (void *)p_csrc, u_width);
         }
+        else
+        {
+            /* filter chroma */
+            M4VIFI_ScaleChromaRow(p_cdest_line, p_csrc_line, u_width, lum_factor);
+            M4VIFI_ScaleChromaRow(p_cdest, p_csrc, u_width, lum_factor);
+        }
+        p_cdest_line += u_stride_out;
+        p_cdest += u_stride_out;
+        p_csrc_line += u_stride;
+        p_csrc += u_stride;
     }
-    else
+
+    /* apply luma factor */
+    u_width = plane_in[0].u_width;
+    u_height = plane_in[0].u_height;
+
+    if (lum_factor <= (1 << LUM_FACTOR_MAX))
     {
-        /* filter chroma */
-        pix = (1024 - lum_factor) << 7;
+        u_stride = plane_in[0].u_stride;
+        u_stride_out = plane_out[0].u_stride;
+        p_cdest_line = (unsigned char *) &plane_out[0].pac_data[plane_out[0].u_topleft];
+        p_csrc_line = (unsigned char *) &plane_in[0].pac_data[plane_in[0].u_topleft];
+
         for (j = u_height; j != 0; j--)
         {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc++ & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
-        }
-        p_cdest_line = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc_line = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        for (j = u_height; j != 0; j--)
-        {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
+            /* pixels are processed by pairs */
+            M4VIFI_ScaleLumaRow(p_cdest_line, p_csrc_line, u_width & ~1, lum_factor);
             p_cdest_line += u_stride_out;
             p_csrc_line += u_stride;
         }
+        return 0;
     }
-    /* apply luma factor */
-    u_width = plane_in[0].u_width;
-    u_height = plane_in[0].u_height;
+
     u_stride = (plane_in[0].u_stride >> 1);
     u_stride_out = (plane_out[0].u_stride >> 1);
     p_dest = (unsigned short *) &plane_out[0].pac_data[plane_out[0].u_topleft];
@@ -1430,6 +1422,9 @@ M4VIFI_UInt8 M4VIFI_YUV420toYUV420(void *user_data, M4VIFI_ImagePlane PlaneIn[3]
  *          Each estimated pixel in the output image is a weighted
  *          combination of its four neighbours. The ratio of compression
  *          or dilatation is estimated using input and output sizes.
+ *          The planes are interpolated by M4VIFI_BilinearPlane, which
+ *          interpolates every input row horizontally once and blends the
+ *          rows with NEON or SSE2.
  * @param   pUserData: (IN) User Data
  * @param   pPlaneIn: (IN) Pointer to YUV420 (Planar) plane buffer
  * @param   pPlaneOut: (OUT) Pointer to YUV420 (Planar) plane
@@ -1447,13 +1442,7 @@ M4VIFI_UInt8    M4VIFI_ResizeBilinearYUV420toYUV420(void *pUserData,
     M4VIFI_UInt32   u32_width_in, u32_width_out, u32_height_in, u32_height_out;
     M4VIFI_UInt32   u32_stride_in, u32_stride_out;
     M4VIFI_UInt32   u32_x_inc, u32_y_inc;
-    M4VIFI_UInt32   u32_x_accum, u32_y_accum, u32_x_accum_start;
-    M4VIFI_UInt32   u32_width, u32_height;
-    M4VIFI_UInt32   u32_y_frac;
-    M4VIFI_UInt32   u32_x_frac;
-    M4VIFI_UInt32   u32_temp_value;
-    M4VIFI_UInt8    *pu8_src_top;
-    M4VIFI_UInt8    *pu8_src_bottom;
+    M4VIFI_UInt32   u32_y_accum, u32_x_accum_start;
 
     M4VIFI_UInt8    u8Wflag = 0;
     M4VIFI_UInt8    u8Hflag = 0;
@@ -1588,8 +1577,6 @@ M4VIFI_UInt8    M4VIFI_ResizeBilinearYUV420toYUV420(void *pUserData,
             u32_x_accum_start = 0;
         }
 
-        u32_height = u32_height_out;
-
         /*
         Bilinear interpolation linearly interpolates along each row, and
         then uses that result in a linear interpolation donw each column.
@@ -1600,53 +1587,22 @@ M4VIFI_UInt8    M4VIFI_ResizeBilinearYUV420toYUV420(void *pUserData,
         0 =< x =< 1 and a (resp. b)weighting coefficient is the distance
         from the nearest neighbor in the p (resp. q) direction
         */
+        M4VIFI_BilinearPlane(&pu8_data_in, u32_stride_in, pu8_data_out,
+            u32_stride_out, u32_width_out, u32_height_out, u32_x_accum_start,
+            u32_x_inc, &u32_y_accum, u32_y_inc);
 
-        do { /* Scan all the row */
-
-            /* Vertical weight factor */
-            u32_y_frac = (u32_y_accum>>12)&15;
-
-            /* Reinit accumulator */
-            u32_x_accum = u32_x_accum_start;
-
-            u32_width = u32_width_out;
-
-            do { /* Scan along each row */
-                pu8_src_top = pu8_data_in + (u32_x_accum >> 16);
-                pu8_src_bottom = pu8_src_top + u32_stride_in;
-                u32_x_frac = (u32_x_accum >> 12)&15; /* Horizontal weight factor */
-
-                /* Weighted combination */
-                u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
-                                                 pu8_src_top[1]*u32_x_frac)*(16-u32_y_frac) +
-                                                (pu8_src_bottom[0]*(16-u32_x_frac) +
-                                                 pu8_src_bottom[1]*u32_x_frac)*u32_y_frac )>>8);
-
-                *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
-
-                /* Update horizontal accumulator */
-                u32_x_accum += u32_x_inc;
-            } while(--u32_width);
-
-            /*
-               This u8Wflag flag gets in to effect if input and output
-               width is same, and height may be different. So previous
-               pixel is replicated here
-            */
-            if (u8Wflag) {
-                *pu8_data_out = (M4VIFI_UInt8)u32_temp_value;
-            }
-
-            pu8dum = (pu8_data_out-u32_width_out);
-            pu8_data_out = pu8_data_out + u32_stride_out - u32_width_out;
-
-            /* Update vertical accumulator */
-            u32_y_accum += u32_y_inc;
-            if (u32_y_accum>>16) {
-                pu8_data_in = pu8_data_in + (u32_y_accum >> 16) * u32_stride_in;
-                u32_y_accum &= 0xffff;
+        /*
+           This u8Wflag flag gets in to effect if input and output
+           width is same, and height may be different. So previous
+           pixel is replicated here
+        */
+        if (u8Wflag) {
+            pu8dum = pu8_data_out + u32_width_out;
+            for (loop = 0; loop < u32_height_out; loop++) {
+                pu8dum[0] = pu8dum[-1];
+                pu8dum += u32_stride_out;
             }
-        } while(--u32_height);
+        }
 
         /*
         This u8Hflag flag gets in to effect if input and output height
@@ -1654,9 +1610,9 @@ M4VIFI_UInt8    M4VIFI_ResizeBilinearYUV420toYUV420(void *pUserData,
         replicated here
         */
         if (u8Hflag) {
-            for(loop =0; loop < (u32_width_out+u8Wflag); loop++) {
-                *pu8_data_out++ = (M4VIFI_UInt8)*pu8dum++;
-            }
+            pu8dum = pu8_data_out + (u32_height_out - 1) * u32_stride_out;
+            memcpy((void *)(pu8dum + u32_stride_out), (void *)pu8dum,
+                u32_width_out + u8Wflag);
         }
     }
 
@@ -2322,6 +2278,7 @@ M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_Image
         M4OSA_UInt8    *pu8_src_bottom;
     M4OSA_UInt32    u32_temp_value;
     M4OSA_Int32 i32_tmp_offset;
+    M4VIFI_UInt32    u32_plane_y_accum;
     M4OSA_UInt32    nb_planes;
 
 
@@ -2481,7 +2438,17 @@ M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_Image
         if(3 != i)  /**< other than alpha plane */
         {
             /**No +-90° rotation */
-            if(M4OSA_FALSE == pC->m_bRevertXY)
+            if((M4OSA_FALSE == pC->m_bRevertXY) && (M4OSA_FALSE == pC->m_bFlipX))
+            {
+                /**< Interpolate the whole plane at once, see M4VIFI_BilinearPlane */
+                u32_plane_y_accum = pC->u32_y_accum[i];
+                M4VIFI_BilinearPlane(&pu8_data_in, i32_tmp_offset, pu8_data_out,
+                    pOut[i].u_stride, pOut[i].u_width, pOut[i].u_height,
+                    pC->u32_x_accum_start[i], pC->u32_x_inc[i], &u32_plane_y_accum,
+                    pC->u32_y_inc[i]);
+                pC->u32_y_accum[i] = u32_plane_y_accum;
+            }
+            else if(M4OSA_FALSE == pC->m_bRevertXY)
             {
 
                 /**< Loop on each row */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "VideoReadAheadSource"
+#include <utils/Log.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/MetaData.h>
+
+#include "VideoReadAheadSource.h"
+
+namespace android {
+
+VideoReadAheadSource::VideoReadAheadSource(const sp<MediaSource> &source)
+    : mSource(source),
+      mStarted(false),
+      mStopping(false),
+      mFinalStatus(OK),
+      mSeekPending(false),
+      mSeekTimeUs(0),
+      mSeekMode(MediaSource::ReadOptions::SEEK_CLOSEST_SYNC),
+      mGeneration(0) {
+    ALOGV("VideoReadAheadSource");
+}
+
+VideoReadAheadSource::~VideoReadAheadSource() {
+    ALOGV("~VideoReadAheadSource");
+    if (mStarted) {
+        stop();
+    }
+}
+
+status_t VideoReadAheadSource::start(MetaData *params) {
+    ALOGV("start");
+    CHECK(!mStarted);
+
+    status_t err = mSource->start(params);
+    if (err != OK) {
+        return err;
+    }
+
+    mStopping = false;
+    mFinalStatus = OK;
+    mSeekPending = false;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    int res = pthread_create(&mThread, &attr, ThreadWrapper, this);
+    pthread_attr_destroy(&attr);
+
+    if (res != 0) {
+        ALOGE("cannot create the read ahead thread: %d", res);
+        mSource->stop();
+        return UNKNOWN_ERROR;
+    }
+
+    mStarted = true;
+    return OK;
+}
+
+status_t VideoReadAheadSource::stop() {
+    ALOGV("stop");
+    if (!mStarted) {
+        return OK;
+    }
+
+    {
+        Mutex::Autolock autoLock(mLock);
+        mStopping = true;
+
+        // Give the decoder its buffers back in case it waits for one.
+        flushQueue_l();
+        mQueueChanged.broadcast();
+    }
+
+    pthread_join(mThread, NULL);
+    mStarted = false;
+
+    return mSource->stop();
+}
+
+sp<MetaData> VideoReadAheadSource::getFormat() {
+    return mSource->getFormat();
+}
+
+status_t VideoReadAheadSource::read(
+        MediaBuffer **buffer, const MediaSource::ReadOptions *options) {
+    Mutex::Autolock autoLock(mLock);
+    CHECK(mStarted);
+
+    *buffer = NULL;
+
+    int64_t seekTimeUs;
+    MediaSource::ReadOptions::SeekMode mode;
+    if (options != NULL && options->getSeekTo(&seekTimeUs, &mode)) {
+        ALOGV("seek to %lld us, dropping %d frames", seekTimeUs, (int)mQueue.size());
+        flushQueue_l();
+        mSeekPending = true;
+        mSeekTimeUs = seekTimeUs;
+        mSeekMode = mode;
+        mFinalStatus = OK;
+        ++mGeneration;
+        mQueueChanged.broadcast();
+    }
+
+    while (mQueue.empty()) {
+        if (mFinalStatus != OK) {
+            return mFinalStatus;
+        }
+        mQueueChanged.wait(mLock);
+    }
+
+    Frame frame = *mQueue.begin();
+    mQueue.erase(mQueue.begin());
+    mQueueChanged.broadcast();
+
+    *buffer = frame.mBuffer;
+    return frame.mStatus;
+}
+
+// static
+void *VideoReadAheadSource::ThreadWrapper(void *me) {
+    static_cast<VideoReadAheadSource *>(me)->threadEntry();
+    return NULL;
+}
+
+void VideoReadAheadSource::threadEntry() {
+    Mutex::Autolock autoLock(mLock);
+
+    while (!mStopping) {
+        if (mQueue.size() >= kMaxQueuedFrames
+                || (mFinalStatus != OK && !mSeekPending)) {
+            mQueueChanged.wait(mLock);
+            continue;
+        }
+
+        MediaSource::ReadOptions options;
+        if (mSeekPending) {
+            options.setSeekTo(mSeekTimeUs, mSeekMode);
+            mSeekPending = false;
+        }
+        uint32_t generation = mGeneration;
+
+        // The decoder may block, let read() and seeks go on meanwhile.
+        MediaBuffer *buffer = NULL;
+        mLock.unlock();
+        status_t err = mSource->read(&buffer, &options);
+        mLock.lock();
+
+        if (mStopping || generation != mGeneration) {
+            // Stopped or seeked while decoding, this frame is stale.
+            if (buffer != NULL) {
+                buffer->release();
+            }
+            continue;
+        }
+
+        Frame frame;
+        frame.mStatus = err;
+        frame.mBuffer = buffer;
+        mQueue.push_back(frame);
+
+        if (err != OK && err != INFO_FORMAT_CHANGED) {
+            ALOGV("decoding stopped: %d", err);
+            mFinalStatus = err;
+        }
+        mQueueChanged.broadcast();
+    }
+}
+
+void VideoReadAheadSource::flushQueue_l() {
+    while (!mQueue.empty()) {
+        Frame &frame = *mQueue.begin();
+        if (frame.mBuffer != NULL) {
+            frame.mBuffer->release();
+        }
+        mQueue.erase(mQueue.begin());
+    }
+}
+
+}  // namespace android
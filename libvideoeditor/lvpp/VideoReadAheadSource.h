@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VIDEO_READ_AHEAD_SOURCE_H_
+#define VIDEO_READ_AHEAD_SOURCE_H_
+
+#include <pthread.h>
+
+#include <media/stagefright/MediaSource.h>
+#include <utils/List.h>
+#include <utils/threads.h>
+
+namespace android {
+
+class MediaBuffer;
+class MetaData;
+
+// Decodes a few frames ahead of the preview player in its own thread, so
+// the video event only waits for the decoder when it falls behind. A seek
+// drops the decoded frames and restarts decoding from the new position.
+struct VideoReadAheadSource : public MediaSource {
+
+public:
+    VideoReadAheadSource(const sp<MediaSource> &source);
+
+    virtual status_t start(MetaData *params = NULL);
+    virtual status_t stop();
+    virtual sp<MetaData> getFormat();
+
+    virtual status_t read(
+                MediaBuffer **buffer,
+                const MediaSource::ReadOptions *options = NULL);
+
+protected:
+    virtual ~VideoReadAheadSource();
+
+private:
+    enum {
+        // Each queued frame holds a decoder output buffer, so keep this
+        // below the number of buffers the decoder can work without.
+        kMaxQueuedFrames = 2,
+    };
+
+    struct Frame {
+        status_t mStatus;
+        MediaBuffer *mBuffer;
+    };
+
+    sp<MediaSource> mSource;
+    bool mStarted;
+
+    Mutex mLock;
+    Condition mQueueChanged;
+    pthread_t mThread;
+    bool mStopping;
+
+    List<Frame> mQueue;
+    status_t mFinalStatus;  // error that stopped the decoding, until a seek
+
+    // Seek requested by read() and not passed to the decoder yet
+    bool mSeekPending;
+    int64_t mSeekTimeUs;
+    MediaSource::ReadOptions::SeekMode mSeekMode;
+
+    // Incremented on each seek, a frame decoded for an older
+    // generation is dropped.
+    uint32_t mGeneration;
+
+    static void *ThreadWrapper(void *me);
+    void threadEntry();
+    void flushQueue_l();
+
+    // Don't call me
+    VideoReadAheadSource(const VideoReadAheadSource &);
+    VideoReadAheadSource &operator=(const VideoReadAheadSource &);
+};
+
+}  // namespace android
+
+#endif  // VIDEO_READ_AHEAD_SOURCE_H_
@@ -130,6 +130,8 @@ typedef enum
     /* H.264 trimming */
     M4MP4W_MUL_PPS_SPS          = 0xC160,
     /* H.264 trimming */
+    M4MP4W_tableSpillPath       = 0xC161, /*prefix of the temporary files receiving the full
+                                           STSZ and STSS blocks, see M4MP4W_TableSpill*/
 } M4MP4W_OptionID;
 
 /**
@@ -165,6 +167,27 @@ typedef struct
     M4OSA_UInt16    width;
 } M4MP4W_StreamIDsize;
 
+/**
+ ******************************************************************************
+ * structure    M4MP4W_TableSpill
+ * @brief       Temporary file holding the first entries of a sample table
+ * @note        When M4MP4W_tableSpillPath is set, a sample table block that is
+ *              full is written in BE to this file and reused for the next
+ *              entries instead of being reallocated. closeWrite copies the file
+ *              back in front of the entries still in memory.
+ *              Only STSZ and STSS are spilled. STTS (8 bytes per change of sample
+ *              duration) and the chunk tables (16 bytes per chunk, i.e. about
+ *              160 bytes per MB of media data) stay in memory, so the memory
+ *              used still grows with the duration, only much more slowly.
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_Char*         url;            /* M4OSA_NULL until the first block is spilled*/
+    M4OSA_Context       fileContext;    /* open for writing while recording*/
+    M4OSA_UInt32        entryNb;        /* nb of entries already in the file*/
+} M4MP4W_TableSpill;
+
 /**
  ******************************************************************************
  * structure    M4MP4W_TrackData
@@ -214,6 +237,7 @@ typedef struct
     /* So sampleSize should be tested to know weither or not there is a TABLE_STSZ. */
     M4OSA_UInt32*           TABLE_STSZ; /* table size is 4K*/
     M4OSA_UInt32            nbOfAllocatedStszBlocks;
+    M4MP4W_TableSpill       stszSpill;  /* TABLE_STSZ[0] is entry stszSpill.entryNb*/
     M4OSA_UInt32*           TABLE_STTS;
     M4OSA_UInt32            nbOfAllocatedSttsBlocks;
     M4OSA_UInt32            maxBitrate;     /*not used in amr case*/
@@ -257,8 +281,10 @@ typedef struct
     M4OSA_UInt32*           TABLE_STSZ;              /* table size is 4K*/
 #endif
     M4OSA_UInt32            nbOfAllocatedStszBlocks;
+    M4MP4W_TableSpill       stszSpill;               /* TABLE_STSZ[0] is entry stszSpill.entryNb*/
     M4OSA_UInt32*           TABLE_STSS;              /* table size is N*/
     M4OSA_UInt32            nbOfAllocatedStssBlocks;
+    M4MP4W_TableSpill       stssSpill;               /* TABLE_STSS[0] is entry stssSpill.entryNb*/
 #ifdef _M4MP4W_OPTIMIZE_FOR_PHONE
     M4OSA_UInt32            MaxAUperChunk;           /*Init to 0, i.e. not used*/
 #endif
@@ -317,6 +343,7 @@ typedef struct
     M4OSA_Bool                        cleanSafetyFile;
 #endif /* _M4MP4W_RESERVED_MOOV_DISK_SPACE */
     M4OSA_Bool                               bMULPPSSPS;
+    M4OSA_Char*                   tableSpillPath;     /* Init to NULL, i.e. tables stay in memory*/
 } M4MP4W_Mp4FileData;
 
 #endif /* _M4MP4W_USE_CST_MEMORY_WRITER */
@@ -35,6 +35,8 @@ extern "C" {
 /* includes */
 #include "M4OSA_Types.h"
 #include "M4OSA_FileWriter.h"
+#include "M4OSA_FileReader.h"
+#include "M4MP4W_Types.h"
 
 
 /**
@@ -89,6 +91,36 @@ void* M4MP4W_realloc(M4OSA_MemAddr32 ptr, M4OSA_UInt32 oldSize, M4OSA_UInt32 new
  */
 M4OSA_ERR M4MP4W_freeContext(M4OSA_Context context);
 
+/**
+ ******************************************************************************
+ * Append the 'nb' entries of 'tab' to the spill file, in BE.
+ * The file is created as 'prefix' followed by 'suffix' on the first call.
+ * 'tab' is converted in place and can be reused once this returns.
+ ******************************************************************************
+ */
+M4OSA_ERR M4MP4W_spillTable(M4MP4W_TableSpill* spill, M4OSA_UInt32* tab, M4OSA_UInt32 nb,
+                            const M4OSA_Char* prefix, const M4OSA_Char* suffix,
+                            M4OSA_FileWriterPointer* fileFunction);
+
+/**
+ ******************************************************************************
+ * Close the spill file and copy its entries into the specified file, reading
+ * them through 'buffer'. Does nothing if no entry was spilled.
+ ******************************************************************************
+ */
+M4OSA_ERR M4MP4W_putSpilledTable(M4MP4W_TableSpill* spill, M4OSA_UChar* buffer,
+                                 M4OSA_UInt32 bufferSize,
+                                 M4OSA_FileWriterPointer* fileFunction,
+                                 M4OSA_FileReadPointer* fileReaderFunction,
+                                 M4OSA_Context context);
+
+/**
+ ******************************************************************************
+ * Close and remove the spill file if any
+ ******************************************************************************
+ */
+void M4MP4W_cleanTableSpill(M4MP4W_TableSpill* spill, M4OSA_FileWriterPointer* fileFunction);
+
 
 #ifdef _M4MP4W_OPTIMIZE_FOR_PHONE
 /**
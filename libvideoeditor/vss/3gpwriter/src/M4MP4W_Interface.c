@@ -560,6 +560,19 @@ M4OSA_ERR M4WRITER_3GP_setOption(
             break;
         /*- H.264 Trimming  */
 
+        /**
+         *    Move the full sample table blocks to temporary files */
+        case M4WRITER_kTableSpillPath:
+            M4OSA_TRACE2_0("setting M4WRITER_kTableSpillPath option");
+            err = M4MP4W_setOption(
+                apContext->pMP4Context, M4MP4W_tableSpillPath, optionValue);
+            if (M4OSA_ERR_IS_ERROR(err))
+            {
+                M4OSA_TRACE1_1("M4MP4W_setOption(M4MP4W_tableSpillPath)\
+                     returns error 0x%x", err);
+            }
+            break;
+
         /**
          *    Unknown option */
         default:
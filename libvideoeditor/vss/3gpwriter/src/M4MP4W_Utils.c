@@ -128,6 +128,114 @@ void* M4MP4W_realloc(M4OSA_MemAddr32 ptr, M4OSA_UInt32 oldSize, M4OSA_UInt32 new
     return ptr2;
 }
 
+/*******************************************************************************/
+M4OSA_ERR M4MP4W_spillTable(M4MP4W_TableSpill* spill, M4OSA_UInt32* tab, M4OSA_UInt32 nb,
+                            const M4OSA_Char* prefix, const M4OSA_Char* suffix,
+                            M4OSA_FileWriterPointer* fileFunction)
+/*******************************************************************************/
+{
+    M4OSA_ERR err;
+    M4OSA_UInt32 prefixSize, suffixSize;
+
+    if (M4OSA_NULL == spill->url)
+    {
+        prefixSize = strlen((const char*)prefix);
+        suffixSize = strlen((const char*)suffix);
+        spill->url = (M4OSA_Char*)M4OSA_32bitAlignedMalloc(prefixSize + suffixSize + 1,
+            M4MP4_WRITER, (M4OSA_Char *)"spill->url");
+        ERR_CHECK(spill->url != M4OSA_NULL, M4ERR_ALLOC);
+        memcpy((void *)spill->url, (void *)prefix, prefixSize);
+        memcpy((void *)(spill->url + prefixSize), (void *)suffix, suffixSize + 1);
+
+        err = fileFunction->openWrite(&spill->fileContext, spill->url,
+            M4OSA_kFileWrite | M4OSA_kFileCreate);
+        ERR_CHECK(err == M4NO_ERROR, err);
+    }
+
+    M4MP4W_table32ToBE(tab, nb);
+    err = fileFunction->writeData(spill->fileContext, (M4OSA_MemAddr8)tab, nb * 4);
+    ERR_CHECK(err == M4NO_ERROR, err);
+    spill->entryNb += nb;
+
+    return M4NO_ERROR;
+}
+
+/*******************************************************************************/
+M4OSA_ERR M4MP4W_putSpilledTable(M4MP4W_TableSpill* spill, M4OSA_UChar* buffer,
+                                 M4OSA_UInt32 bufferSize,
+                                 M4OSA_FileWriterPointer* fileFunction,
+                                 M4OSA_FileReadPointer* fileReaderFunction,
+                                 M4OSA_Context context)
+/*******************************************************************************/
+{
+    M4OSA_ERR err, err2;
+    M4OSA_Context readContext = M4OSA_NULL;
+    M4OSA_UInt32 remaining = spill->entryNb * 4;
+    M4OSA_UInt32 size;
+
+    if (0 == spill->entryNb)
+    {
+        return M4NO_ERROR;
+    }
+
+    /* the blocks must be on disk before they can be read back */
+    err = fileFunction->closeWrite(spill->fileContext);
+    spill->fileContext = M4OSA_NULL;
+    ERR_CHECK(err == M4NO_ERROR, err);
+
+    err = fileReaderFunction->openRead(&readContext, spill->url, M4OSA_kFileRead);
+    ERR_CHECK(err == M4NO_ERROR, err);
+
+    while (remaining > 0)
+    {
+        size = (remaining < bufferSize) ? remaining : bufferSize;
+        err = fileReaderFunction->readData(readContext, (M4OSA_MemAddr8)buffer, &size);
+
+        if (M4NO_ERROR != err)
+        {
+            /* M4WAR_NO_DATA_YET: the file is shorter than what was spilled */
+            if (!M4OSA_ERR_IS_ERROR(err))
+            {
+                err = M4ERR_FILE_INVALID_POSITION;
+            }
+            break;
+        }
+
+        err = M4MP4W_putBlock(buffer, size, fileFunction, context);
+        if (M4NO_ERROR != err)
+        {
+            break;
+        }
+        remaining -= size;
+    }
+
+    err2 = fileReaderFunction->closeRead(readContext);
+    if (M4NO_ERROR == err)
+    {
+        err = err2;
+    }
+
+    return err;
+}
+
+/*******************************************************************************/
+void M4MP4W_cleanTableSpill(M4MP4W_TableSpill* spill, M4OSA_FileWriterPointer* fileFunction)
+/*******************************************************************************/
+{
+    if (M4OSA_NULL != spill->fileContext)
+    {
+        fileFunction->closeWrite(spill->fileContext);
+        spill->fileContext = M4OSA_NULL;
+    }
+    if (M4OSA_NULL != spill->url)
+    {
+        remove((const char *)spill->url);
+        free(spill->url);
+        spill->url = M4OSA_NULL;
+    }
+    spill->entryNb = 0;
+}
+
 /*******************************************************************************/
 M4OSA_ERR M4MP4W_freeContext(M4OSA_Context context)
 /*******************************************************************************/
@@ -191,6 +299,8 @@ M4OSA_ERR M4MP4W_freeContext(M4OSA_Context context)
         {
             free(mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ);
         }
+        M4MP4W_cleanTableSpill(&mMp4FileDataPtr->audioTrackPtr->stszSpill,
+            mMp4FileDataPtr->fileWriterFunctions);
 
         if (mMp4FileDataPtr->audioTrackPtr->DSI != M4OSA_NULL)
         {
@@ -260,6 +370,10 @@ M4OSA_ERR M4MP4W_freeContext(M4OSA_Context context)
         {
             free(mMp4FileDataPtr->videoTrackPtr->TABLE_STSS);
         }
+        M4MP4W_cleanTableSpill(&mMp4FileDataPtr->videoTrackPtr->stszSpill,
+            mMp4FileDataPtr->fileWriterFunctions);
+        M4MP4W_cleanTableSpill(&mMp4FileDataPtr->videoTrackPtr->stssSpill,
+            mMp4FileDataPtr->fileWriterFunctions);
 
         free(mMp4FileDataPtr->videoTrackPtr);
         mMp4FileDataPtr->videoTrackPtr = M4OSA_NULL;
@@ -271,6 +385,12 @@ M4OSA_ERR M4MP4W_freeContext(M4OSA_Context context)
         mMp4FileDataPtr->embeddedString = M4OSA_NULL;
     }
 
+    if (mMp4FileDataPtr->tableSpillPath != M4OSA_NULL)
+    {
+        free(mMp4FileDataPtr->tableSpillPath);
+        mMp4FileDataPtr->tableSpillPath = M4OSA_NULL;
+    }
+
     free(mMp4FileDataPtr);
 
     return M4NO_ERROR;
@@ -577,6 +577,9 @@ M4OSA_ERR M4MP4W_openWrite(M4OSA_Context *contextPtr,
     mMp4FileDataPtr->MaxFileDuration = 0; /*default = 0, i.e. not used*/
 
     mMp4FileDataPtr->fileWriterFunctions = fileWriterFunction;
+    mMp4FileDataPtr->fileReaderFunctions = fileReaderFunction; /*only used to read back
+                                                                 the spilled tables*/
+    mMp4FileDataPtr->tableSpillPath = M4OSA_NULL; /*default, tables stay in memory*/
     mMp4FileDataPtr->hasAudio = M4OSA_FALSE;
     mMp4FileDataPtr->hasVideo = M4OSA_FALSE;
     mMp4FileDataPtr->state = M4MP4W_opened;
@@ -670,6 +673,8 @@ M4OSA_ERR M4MP4W_addStream(M4OSA_Context context,
                 mMp4FileDataPtr->audioTrackPtr->TABLE_STTS = M4OSA_NULL;
                 mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ = M4OSA_NULL;
                 mMp4FileDataPtr->audioTrackPtr->DSI = M4OSA_NULL;
+                memset((void *)&mMp4FileDataPtr->audioTrackPtr->stszSpill, 0,
+                    sizeof(M4MP4W_TableSpill));
 
                 /*now dynamic*/
 
@@ -898,6 +903,10 @@ M4OSA_ERR M4MP4W_addStream(M4OSA_Context context,
                 mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ = M4OSA_NULL;
                 mMp4FileDataPtr->videoTrackPtr->TABLE_STSS = M4OSA_NULL;
                 mMp4FileDataPtr->videoTrackPtr->DSI = M4OSA_NULL;
+                memset((void *)&mMp4FileDataPtr->videoTrackPtr->stszSpill, 0,
+                    sizeof(M4MP4W_TableSpill));
+                memset((void *)&mMp4FileDataPtr->videoTrackPtr->stssSpill, 0,
+                    sizeof(M4MP4W_TableSpill));
 
                 /*now dynamic*/
 
@@ -2234,6 +2243,12 @@ M4OSA_ERR M4MP4W_processAU( M4OSA_Context context, M4SYS_StreamID streamID,
                         1 + mMp4FileDataPtr->audioTrackPtr->
                         CommonData.sampleNb
                         * 4 / M4MP4W_STSZ_AUDIO_ALLOC_SIZE;
+
+                    if (M4OSA_NULL != mMp4FileDataPtr->tableSpillPath)
+                    {
+                        /*the previous sizes are spilled while filling a single block*/
+                        mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks = 1;
+                    }
                     mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ =
                         (M4OSA_UInt32 *)M4OSA_32bitAlignedMalloc(
                         mMp4FileDataPtr->audioTrackPtr->
@@ -2247,13 +2262,46 @@ M4OSA_ERR M4MP4W_processAU( M4OSA_Context context, M4SYS_StreamID streamID,
                         i < mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb;
                         i++ )
                     {
-                        mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ[i] =
+                        /*only reached when spilling, the table holds all the sizes otherwise*/
+                        if (4 *(i - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb)
+                            >= mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks
+                            *M4MP4W_STSZ_AUDIO_ALLOC_SIZE)
+                        {
+                            err = M4MP4W_spillTable(
+                                &mMp4FileDataPtr->audioTrackPtr->stszSpill,
+                                mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ,
+                                i - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb,
+                                mMp4FileDataPtr->tableSpillPath,
+                                (const M4OSA_Char *)"_audio.stsz",
+                                mMp4FileDataPtr->fileWriterFunctions);
+                            ERR_CHECK(M4NO_ERROR == err, err);
+                        }
+                        mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ[i
+                            - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb] =
                             mMp4FileDataPtr->audioTrackPtr->
                             CommonData.sampleSize;
                     }
+
+                    if (4 *(mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                        - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb)
+                        >= mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks
+                        *M4MP4W_STSZ_AUDIO_ALLOC_SIZE)
+                    {
+                        err = M4MP4W_spillTable(
+                            &mMp4FileDataPtr->audioTrackPtr->stszSpill,
+                            mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ,
+                            mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                            - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb,
+                            mMp4FileDataPtr->tableSpillPath,
+                            (const M4OSA_Char *)"_audio.stsz",
+                            mMp4FileDataPtr->fileWriterFunctions);
+                        ERR_CHECK(M4NO_ERROR == err, err);
+                    }
                     mMp4FileDataPtr->audioTrackPtr->
                         TABLE_STSZ[mMp4FileDataPtr->audioTrackPtr->
-                        CommonData.sampleNb] = auPtr->size;
+                        CommonData.sampleNb
+                        - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb] =
+                        auPtr->size;
                     mMp4FileDataPtr->audioTrackPtr->CommonData.sampleSize =
                         0; /*used as a flag in that case*/
                     /*more bytes in the file in that case:*/
@@ -2279,30 +2327,49 @@ M4OSA_ERR M4MP4W_processAU( M4OSA_Context context, M4SYS_StreamID streamID,
 
 #else
 
-                if (4 *mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                if (4 *(mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                    - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb)
                     >= mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks
                     *M4MP4W_STSZ_AUDIO_ALLOC_SIZE)
                 {
-                    mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks +=
-                        1;
-                    mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ =
-                        (M4OSA_UInt32 *)M4MP4W_realloc(
-                        (M4OSA_MemAddr32)mMp4FileDataPtr->audioTrackPtr->
-                        TABLE_STSZ, ( mMp4FileDataPtr->audioTrackPtr->
-                        nbOfAllocatedStszBlocks - 1)
-                        * M4MP4W_STSZ_AUDIO_ALLOC_SIZE,
-                        mMp4FileDataPtr->audioTrackPtr->
-                        nbOfAllocatedStszBlocks
-                        * M4MP4W_STSZ_AUDIO_ALLOC_SIZE);
-                    ERR_CHECK(mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ
-                        != M4OSA_NULL, M4ERR_ALLOC);
+                    if (M4OSA_NULL != mMp4FileDataPtr->tableSpillPath)
+                    {
+                        /*move the full table to the spill file and reuse it*/
+                        err = M4MP4W_spillTable(
+                            &mMp4FileDataPtr->audioTrackPtr->stszSpill,
+                            mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ,
+                            mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                            - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb,
+                            mMp4FileDataPtr->tableSpillPath,
+                            (const M4OSA_Char *)"_audio.stsz",
+                            mMp4FileDataPtr->fileWriterFunctions);
+                        ERR_CHECK(M4NO_ERROR == err, err);
+                    }
+                    else
+                    {
+                        mMp4FileDataPtr->audioTrackPtr->nbOfAllocatedStszBlocks +=
+                            1;
+                        mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ =
+                            (M4OSA_UInt32 *)M4MP4W_realloc(
+                            (M4OSA_MemAddr32)mMp4FileDataPtr->audioTrackPtr->
+                            TABLE_STSZ, ( mMp4FileDataPtr->audioTrackPtr->
+                            nbOfAllocatedStszBlocks - 1)
+                            * M4MP4W_STSZ_AUDIO_ALLOC_SIZE,
+                            mMp4FileDataPtr->audioTrackPtr->
+                            nbOfAllocatedStszBlocks
+                            * M4MP4W_STSZ_AUDIO_ALLOC_SIZE);
+                        ERR_CHECK(mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ
+                            != M4OSA_NULL, M4ERR_ALLOC);
+                    }
                 }
 
 #endif /*_M4MP4W_OPTIMIZE_FOR_PHONE*/
 
                 mMp4FileDataPtr->audioTrackPtr->
                     TABLE_STSZ[mMp4FileDataPtr->audioTrackPtr->
-                    CommonData.sampleNb] = auPtr->size;
+                    CommonData.sampleNb
+                    - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb] =
+                    auPtr->size;
 
                 if (mMp4FileDataPtr->estimateAudioSize == M4OSA_FALSE)
                     mMp4FileDataPtr->filesize += 4;
@@ -2512,27 +2579,44 @@ M4OSA_ERR M4MP4W_processAU( M4OSA_Context context, M4SYS_StreamID streamID,
 
 #else
 
-        if (4 *mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+        if (4 *(mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+            - mMp4FileDataPtr->videoTrackPtr->stszSpill.entryNb)
             >= mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStszBlocks
             *M4MP4W_STSZ_ALLOC_SIZE)
         {
-            mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStszBlocks += 1;
+            if (M4OSA_NULL != mMp4FileDataPtr->tableSpillPath)
+            {
+                /*move the full table to the spill file and reuse it*/
+                err = M4MP4W_spillTable(&mMp4FileDataPtr->videoTrackPtr->stszSpill,
+                    mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ,
+                    mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+                    - mMp4FileDataPtr->videoTrackPtr->stszSpill.entryNb,
+                    mMp4FileDataPtr->tableSpillPath,
+                    (const M4OSA_Char *)"_video.stsz",
+                    mMp4FileDataPtr->fileWriterFunctions);
+                ERR_CHECK(M4NO_ERROR == err, err);
+            }
+            else
+            {
+                mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStszBlocks += 1;
 
-            mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ =
-                (M4OSA_UInt32 *)M4MP4W_realloc(
-                (M4OSA_MemAddr32)mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ,
-                ( mMp4FileDataPtr->videoTrackPtr->
-                nbOfAllocatedStszBlocks
-                - 1) * M4MP4W_STSZ_ALLOC_SIZE,
-                mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStszBlocks
-                * M4MP4W_STSZ_ALLOC_SIZE);
-
-            ERR_CHECK(mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ != M4OSA_NULL,
-                M4ERR_ALLOC);
+                mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ =
+                    (M4OSA_UInt32 *)M4MP4W_realloc(
+                    (M4OSA_MemAddr32)mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ,
+                    ( mMp4FileDataPtr->videoTrackPtr->
+                    nbOfAllocatedStszBlocks
+                    - 1) * M4MP4W_STSZ_ALLOC_SIZE,
+                    mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStszBlocks
+                    * M4MP4W_STSZ_ALLOC_SIZE);
+
+                ERR_CHECK(mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ != M4OSA_NULL,
+                    M4ERR_ALLOC);
+            }
         }
 
         mMp4FileDataPtr->videoTrackPtr->
-            TABLE_STSZ[mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb] =
+            TABLE_STSZ[mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+            - mMp4FileDataPtr->videoTrackPtr->stszSpill.entryNb] =
             auPtr->size;
         mMp4FileDataPtr->filesize += 4;
 
@@ -2689,28 +2773,46 @@ M4OSA_ERR M4MP4W_processAU( M4OSA_Context context, M4SYS_StreamID streamID,
 
 #else
 
-            if (4 *mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+            if (4 *(mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+                - mMp4FileDataPtr->videoTrackPtr->stssSpill.entryNb)
                 >= mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStssBlocks
                 *M4MP4W_STSS_ALLOC_SIZE)
             {
-                mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStssBlocks += 1;
-                mMp4FileDataPtr->videoTrackPtr->TABLE_STSS =
-                    (M4OSA_UInt32 *)M4MP4W_realloc(
-                    (M4OSA_MemAddr32)mMp4FileDataPtr->videoTrackPtr->
-                    TABLE_STSS, ( mMp4FileDataPtr->videoTrackPtr->
-                    nbOfAllocatedStssBlocks
-                    - 1) * M4MP4W_STSS_ALLOC_SIZE,
-                    mMp4FileDataPtr->videoTrackPtr->
-                    nbOfAllocatedStssBlocks
-                    * M4MP4W_STSS_ALLOC_SIZE);
-                ERR_CHECK(mMp4FileDataPtr->videoTrackPtr->TABLE_STSS
-                    != M4OSA_NULL, M4ERR_ALLOC);
+                if (M4OSA_NULL != mMp4FileDataPtr->tableSpillPath)
+                {
+                    /*move the full table to the spill file and reuse it*/
+                    err = M4MP4W_spillTable(
+                        &mMp4FileDataPtr->videoTrackPtr->stssSpill,
+                        mMp4FileDataPtr->videoTrackPtr->TABLE_STSS,
+                        mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+                        - mMp4FileDataPtr->videoTrackPtr->stssSpill.entryNb,
+                        mMp4FileDataPtr->tableSpillPath,
+                        (const M4OSA_Char *)"_video.stss",
+                        mMp4FileDataPtr->fileWriterFunctions);
+                    ERR_CHECK(M4NO_ERROR == err, err);
+                }
+                else
+                {
+                    mMp4FileDataPtr->videoTrackPtr->nbOfAllocatedStssBlocks += 1;
+                    mMp4FileDataPtr->videoTrackPtr->TABLE_STSS =
+                        (M4OSA_UInt32 *)M4MP4W_realloc(
+                        (M4OSA_MemAddr32)mMp4FileDataPtr->videoTrackPtr->
+                        TABLE_STSS, ( mMp4FileDataPtr->videoTrackPtr->
+                        nbOfAllocatedStssBlocks
+                        - 1) * M4MP4W_STSS_ALLOC_SIZE,
+                        mMp4FileDataPtr->videoTrackPtr->
+                        nbOfAllocatedStssBlocks
+                        * M4MP4W_STSS_ALLOC_SIZE);
+                    ERR_CHECK(mMp4FileDataPtr->videoTrackPtr->TABLE_STSS
+                        != M4OSA_NULL, M4ERR_ALLOC);
+                }
             }
 
 #endif /*_M4MP4W_OPTIMIZE_FOR_PHONE*/
 
             mMp4FileDataPtr->videoTrackPtr->
-                TABLE_STSS[mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb] =
+                TABLE_STSS[mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+                - mMp4FileDataPtr->videoTrackPtr->stssSpill.entryNb] =
                 mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb;
             mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb += 1;
             mMp4FileDataPtr->filesize += 4;
@@ -3114,15 +3216,18 @@ M4OSA_ERR M4MP4W_closeWrite( M4OSA_Context context )
         /*Convert integers in the table from LE into BE*/
 #ifndef _M4MP4W_OPTIMIZE_FOR_PHONE
 
+        /*the spilled entries are already in BE*/
         M4MP4W_table32ToBE(mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ,
-            mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb);
+            mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+            - mMp4FileDataPtr->videoTrackPtr->stszSpill.entryNb);
         M4MP4W_table32ToBE(mMp4FileDataPtr->videoTrackPtr->TABLE_STTS,
             2 * (mMp4FileDataPtr->videoTrackPtr->CommonData.sttsTableEntryNb));
 
 #endif
 
         M4MP4W_table32ToBE(mMp4FileDataPtr->videoTrackPtr->TABLE_STSS,
-            mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb);
+            mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+            - mMp4FileDataPtr->videoTrackPtr->stssSpill.entryNb);
 
         if (mMp4FileDataPtr->videoTrackPtr->CommonData.trackType
             == M4SYS_kH263)
@@ -3323,7 +3428,8 @@ M4OSA_ERR M4MP4W_closeWrite( M4OSA_Context context )
             }
             /*Convert integers in the table from LE into BE*/
             M4MP4W_table32ToBE(mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ,
-                mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb);
+                mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb);
             a_stszSize +=
                 4 * mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb;
             a_stblSize +=
@@ -3887,9 +3993,17 @@ M4OSA_ERR M4MP4W_closeWrite( M4OSA_Context context )
         /*0 value for samplesize means not constant AU size*/
         if (mMp4FileDataPtr->audioTrackPtr->CommonData.sampleSize == 0)
         {
+            /*the chunk buffer is free once the last chunk is flushed*/
+            CLEANUPonERR(M4MP4W_putSpilledTable(
+                &mMp4FileDataPtr->audioTrackPtr->stszSpill,
+                mMp4FileDataPtr->audioTrackPtr->Chunk[0],
+                mMp4FileDataPtr->audioTrackPtr->MaxChunkSize,
+                mMp4FileDataPtr->fileWriterFunctions,
+                mMp4FileDataPtr->fileReaderFunctions, fileWriterContext));
             CLEANUPonERR(M4MP4W_putBlock((const M4OSA_UChar
                 *)mMp4FileDataPtr->audioTrackPtr->TABLE_STSZ,
-                mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb * 4,
+                (mMp4FileDataPtr->audioTrackPtr->CommonData.sampleNb
+                - mMp4FileDataPtr->audioTrackPtr->stszSpill.entryNb) * 4,
                 mMp4FileDataPtr->fileWriterFunctions, fileWriterContext));
         }
 
@@ -4290,9 +4404,17 @@ M4OSA_ERR M4MP4W_closeWrite( M4OSA_Context context )
 
 #else
 
+        /*the chunk buffer is free once the last chunk is flushed*/
+        CLEANUPonERR(M4MP4W_putSpilledTable(
+            &mMp4FileDataPtr->videoTrackPtr->stszSpill,
+            mMp4FileDataPtr->videoTrackPtr->Chunk[0],
+            mMp4FileDataPtr->videoTrackPtr->MaxChunkSize,
+            mMp4FileDataPtr->fileWriterFunctions,
+            mMp4FileDataPtr->fileReaderFunctions, fileWriterContext)); /*video*/
         CLEANUPonERR(M4MP4W_putBlock((const M4OSA_UChar
             *)mMp4FileDataPtr->videoTrackPtr->TABLE_STSZ,
-            mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb * 4,
+            (mMp4FileDataPtr->videoTrackPtr->CommonData.sampleNb
+            - mMp4FileDataPtr->videoTrackPtr->stszSpill.entryNb) * 4,
             mMp4FileDataPtr->fileWriterFunctions, fileWriterContext)); /*video*/
 
 #endif
@@ -4381,9 +4503,16 @@ M4OSA_ERR M4MP4W_closeWrite( M4OSA_Context context )
             M4MP4W_putBE32(mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb,
             mMp4FileDataPtr->fileWriterFunctions,
             fileWriterContext)); /*video*/
+        CLEANUPonERR(M4MP4W_putSpilledTable(
+            &mMp4FileDataPtr->videoTrackPtr->stssSpill,
+            mMp4FileDataPtr->videoTrackPtr->Chunk[0],
+            mMp4FileDataPtr->videoTrackPtr->MaxChunkSize,
+            mMp4FileDataPtr->fileWriterFunctions,
+            mMp4FileDataPtr->fileReaderFunctions, fileWriterContext)); /*video*/
         CLEANUPonERR(M4MP4W_putBlock((const M4OSA_UChar
             *)mMp4FileDataPtr->videoTrackPtr->TABLE_STSS,
-            mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb * 4,
+            (mMp4FileDataPtr->videoTrackPtr->stssTableEntryNb
+            - mMp4FileDataPtr->videoTrackPtr->stssSpill.entryNb) * 4,
             mMp4FileDataPtr->fileWriterFunctions, fileWriterContext)); /*video*/
         CLEANUPonERR(M4MP4W_putBlock(VideoBlock5, sizeof(VideoBlock5),
             mMp4FileDataPtr->fileWriterFunctions, fileWriterContext)); /*video*/
@@ -5118,6 +5247,37 @@ M4OSA_ERR M4MP4W_setOption( M4OSA_Context context, M4OSA_OptionID option,
             mMp4FileDataPtr->MaxFileDuration = *(M4OSA_UInt32 *)value;
             break;
 
+        case (M4MP4W_tableSpillPath):
+#if defined(_M4MP4W_OPTIMIZE_FOR_PHONE) || defined(_M4MP4W_MOOV_FIRST)
+
+            return M4ERR_NOT_IMPLEMENTED;
+
+#else
+            {
+                M4OSA_UInt32 size;
+
+                ERR_CHECK(M4OSA_NULL != value, M4ERR_PARAMETER);
+                /* the spilled tables are read back when closing */
+                ERR_CHECK(M4OSA_NULL != mMp4FileDataPtr->fileReaderFunctions,
+                    M4ERR_PARAMETER);
+
+                if (mMp4FileDataPtr->tableSpillPath != M4OSA_NULL)
+                {
+                    free(mMp4FileDataPtr->tableSpillPath);
+                }
+                size = strlen((const char *)value) + 1;
+                mMp4FileDataPtr->tableSpillPath =
+                    (M4OSA_Char *)M4OSA_32bitAlignedMalloc(size, M4MP4_WRITER,
+                    (M4OSA_Char *)"tableSpillPath");
+                ERR_CHECK(mMp4FileDataPtr->tableSpillPath != M4OSA_NULL,
+                    M4ERR_ALLOC);
+                memcpy((void *)mMp4FileDataPtr->tableSpillPath, (void *)value,
+                    size);
+            }
+            break;
+
+#endif /*_M4MP4W_OPTIMIZE_FOR_PHONE || _M4MP4W_MOOV_FIRST*/
+
         case (M4MP4W_setFtypBox):
             {
                 M4OSA_UInt32 size;
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4PCM_Mix.h
+ * @brief       16 bits PCM mixing kernels shared by the preview player and
+ *              the VSS audio mixing
+ * @note        The kernels have NEON and SSE2 versions, SSE2 is only used when
+ *              the CPU supports it. Volumes are applied in single precision
+ *              and truncated towards zero like the scalar loops, so all
+ *              versions give the same output.
+ ******************************************************************************
+*/
+
+#ifndef _M4PCM_MIX_H_
+#define _M4PCM_MIX_H_
+
+#include "M4OSA_Types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4PCM_peak(const M4OSA_Int16 *pSamples, M4OSA_UInt32 uiNbSamples)
+ * @brief   Returns the largest absolute sample value, 32768 included.
+ ******************************************************************************
+*/
+M4OSA_UInt32 M4PCM_peak(const M4OSA_Int16 *pSamples, M4OSA_UInt32 uiNbSamples);
+
+/**
+ ******************************************************************************
+ * void M4PCM_scale(M4OSA_Int16 *pOut, const M4OSA_Int16 *pIn,
+ *                  M4OSA_UInt32 uiNbSamples, M4OSA_Float fVolume)
+ * @brief   pOut[i] = (M4OSA_Int16)(pIn[i] * fVolume), pOut may be pIn.
+ ******************************************************************************
+*/
+void M4PCM_scale(M4OSA_Int16 *pOut, const M4OSA_Int16 *pIn,
+                 M4OSA_UInt32 uiNbSamples, M4OSA_Float fVolume);
+
+/**
+ ******************************************************************************
+ * void M4PCM_mixAndDuck(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+ *                       const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+ *                       M4OSA_Float fPTVolume, M4OSA_Float fBTVolume,
+ *                       M4OSA_Float fDuckingFactor)
+ * @brief   Mixes the background track ducked by fDuckingFactor with the
+ *          primary track.
+ * @note    Each track is scaled by its volume, the background one then by
+ *          the ducking factor, and the halves of both are added. The sum is
+ *          doubled back to the original level and saturated to
+ *          [-32766, 32767]. pOut may be either input.
+ ******************************************************************************
+*/
+void M4PCM_mixAndDuck(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+                      const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+                      M4OSA_Float fPTVolume, M4OSA_Float fBTVolume,
+                      M4OSA_Float fDuckingFactor);
+
+/**
+ ******************************************************************************
+ * void M4PCM_mixWeighted(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+ *                        const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+ *                        M4OSA_Float fPTFactor, M4OSA_Float fPTVolume,
+ *                        M4OSA_Float fBTFactor, M4OSA_Float fBTVolume)
+ * @brief   pOut[i] = (M4OSA_Int16)(pPrimary[i] * fPTFactor * fPTVolume
+ *                                  + pBackground[i] * fBTFactor * fBTVolume)
+ * @note    pOut may be either input.
+ ******************************************************************************
+*/
+void M4PCM_mixWeighted(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+                       const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+                       M4OSA_Float fPTFactor, M4OSA_Float fPTVolume,
+                       M4OSA_Float fBTFactor, M4OSA_Float fBTVolume);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _M4PCM_MIX_H_ */
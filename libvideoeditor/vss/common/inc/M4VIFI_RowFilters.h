@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4VIFI_RowFilters.h
+ * @brief       Row kernels shared by the YUV420 resize, AIR and effect filters
+ * @note        The kernels have NEON and SSE2 versions, SSE2 is only used when
+ *              the CPU supports it. All versions give the same output as the
+ *              scalar loops they replace.
+ ******************************************************************************
+*/
+
+#ifndef _M4VIFI_ROWFILTERS_H_
+#define _M4VIFI_ROWFILTERS_H_
+
+#include "M4VIFI_FiltersAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ ******************************************************************************
+ * void M4VIFI_BilinearPlane(M4VIFI_UInt8 **ppu8_data_in, M4VIFI_Int32 i32_stride_in,
+ *                           M4VIFI_UInt8 *pu8_data_out, M4VIFI_UInt32 u32_stride_out,
+ *                           M4VIFI_UInt32 u32_width_out, M4VIFI_UInt32 u32_height_out,
+ *                           M4VIFI_UInt32 u32_x_accum_start, M4VIFI_UInt32 u32_x_inc,
+ *                           M4VIFI_UInt32 *pu32_y_accum, M4VIFI_UInt32 u32_y_inc)
+ * @brief   Bilinear interpolation of one plane with 16.16 accumulators.
+ * @note    Output pixel (x, y) is
+ *              ((top[0]*(16-xf) + top[1]*xf)*(16-yf) +
+ *               (bottom[0]*(16-xf) + bottom[1]*xf)*yf) >> 8
+ *          with xf and yf the bits 12 to 15 of the accumulators, as in
+ *          M4VIFI_ResizeBilinearYUV420toYUV420. Rows are first interpolated
+ *          horizontally into a cache, so an input row shared by consecutive
+ *          output rows is only interpolated once, then the two cached rows
+ *          are blended with the vector kernel.
+ * @param   ppu8_data_in:      (IN/OUT) First input row, updated past the rows used
+ * @param   i32_stride_in:     (IN) Offset to the next input row, negative when flipped
+ * @param   pu8_data_out:      (OUT) First output row
+ * @param   u32_stride_out:    (IN) Output stride
+ * @param   u32_width_out:     (IN) Output width
+ * @param   u32_height_out:    (IN) Output height
+ * @param   u32_x_accum_start: (IN) Horizontal accumulator at the start of a row
+ * @param   u32_x_inc:         (IN) Horizontal increment
+ * @param   pu32_y_accum:      (IN/OUT) Vertical accumulator
+ * @param   u32_y_inc:         (IN) Vertical increment
+ ******************************************************************************
+*/
+void M4VIFI_BilinearPlane(M4VIFI_UInt8 **ppu8_data_in, M4VIFI_Int32 i32_stride_in,
+                          M4VIFI_UInt8 *pu8_data_out, M4VIFI_UInt32 u32_stride_out,
+                          M4VIFI_UInt32 u32_width_out, M4VIFI_UInt32 u32_height_out,
+                          M4VIFI_UInt32 u32_x_accum_start, M4VIFI_UInt32 u32_x_inc,
+                          M4VIFI_UInt32 *pu32_y_accum, M4VIFI_UInt32 u32_y_inc);
+
+/**
+ ******************************************************************************
+ * void M4VIFI_ScaleLumaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+ *                          M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor)
+ * @brief   pu8_out[i] = (pu8_in[i] * u32_lum_factor) >> 10
+ * @note    u32_lum_factor must be <= 1024. pu8_out may be pu8_in.
+ ******************************************************************************
+*/
+void M4VIFI_ScaleLumaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                         M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor);
+
+/**
+ ******************************************************************************
+ * void M4VIFI_ScaleChromaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+ *                            M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor)
+ * @brief   pu8_out[i] = (((1024 - u32_lum_factor) << 7) + pu8_in[i] * u32_lum_factor) >> 10
+ * @note    Moves the chroma towards 128, u32_lum_factor must be <= 256.
+ *          pu8_out may be pu8_in.
+ ******************************************************************************
+*/
+void M4VIFI_ScaleChromaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                           M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor);
+
+/**
+ ******************************************************************************
+ * void M4VIFI_InvertRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+ *                       M4VIFI_UInt32 u32_width)
+ * @brief   pu8_out[i] = 255 - pu8_in[i], pu8_out may be pu8_in.
+ ******************************************************************************
+*/
+void M4VIFI_InvertRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                      M4VIFI_UInt32 u32_width);
+
+#if defined(VIDEO_FILTERS_SSE2)
+/**
+ ******************************************************************************
+ * M4VIFI_UInt8 M4VIFI_cpuHasSSE2(void)
+ * @brief   Returns 1 when the CPU supports SSE2, checked once per process.
+ ******************************************************************************
+*/
+M4VIFI_UInt8 M4VIFI_cpuHasSSE2(void);
+#endif /* VIDEO_FILTERS_SSE2 */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _M4VIFI_ROWFILTERS_H_ */
@@ -102,8 +102,12 @@ typedef enum {
     M4WRITER_kJpegSetFPData     = M4OSA_OPTION_ID_CREATE (M4_WRITE        , \
         M4WRITER_COMMON, 0x0E),    /**< Write Fast Processing Data in the file*/
     /* + CRLV6775 -H.264 trimming */
-    M4WRITER_kMUL_PPS_SPS       = M4OSA_OPTION_ID_CREATE (M4_WRITE        , M4WRITER_COMMON, 0x0F)
+    M4WRITER_kMUL_PPS_SPS       = M4OSA_OPTION_ID_CREATE (M4_WRITE        , M4WRITER_COMMON, 0x0F),
     /* - CRLV6775 -H.264 trimming */
+    M4WRITER_kTableSpillPath    = M4OSA_OPTION_ID_CREATE (M4_WRITE        ,\
+         M4WRITER_COMMON, 0x10)     /**< Prefix (M4OSA_Char*) of the temporary files the STSZ
+                                         and STSS tables are moved to while recording. STTS
+                                         and the chunk tables stay in memory */
 } M4WRITER_OptionID;
 
 
@@ -643,6 +643,90 @@ M4OSA_ERR  M4VSS3GPP_intProcessAU(M4WRITER_Context pContext, M4SYS_StreamID stre
 M4OSA_ERR  M4VSS3GPP_intVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
                              M4VIFI_ImagePlane* pPlaneOut);
 
+/**
+ ******************************************************************************
+ * M4OSA_Time M4VSS3GPP_intGetTimeUs()
+ * @brief    Monotonic time used for the stage timings
+ * @return    Time in microseconds
+ ******************************************************************************
+*/
+M4OSA_Time M4VSS3GPP_intGetTimeUs(M4OSA_Void);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intOpenDecodeWorker()
+ * @brief    Start the thread decoding the clip2 video during the transitions
+ *           and the next frames ahead of time
+ * @note    Does nothing if the edition has no video. If the thread cannot be
+ *           started, everything is decoded on the edit thread.
+ * @param   pC    (IN/OUT) Internal edit context
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+*/
+M4OSA_ERR M4VSS3GPP_intOpenDecodeWorker(M4VSS3GPP_InternalEditContext *pC);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intCloseDecodeWorker()
+ * @brief    Stop the decode thread, if any
+ * @param   pC    (IN/OUT) Internal edit context
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+*/
+M4OSA_ERR M4VSS3GPP_intCloseDecodeWorker(M4VSS3GPP_InternalEditContext *pC);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intDecodeClipsUpToCts()
+ * @brief    Decode the clip1 and/or clip2 video up to the target time
+ * @note    When both clips must be decoded and the decode thread is running,
+ *           the clip2 is decoded on it while the clip1 is decoded on the
+ *           calling thread.
+ * @param   pC            (IN/OUT) Internal edit context
+ * @param   bDecodeC1    (IN) Decode the clip1
+ * @param   bDecodeC2    (IN) Decode the clip2
+ * @param   iCts        (IN) Target time (output time base)
+ * @return    M4NO_ERROR:    No error
+ * @return    Error of M4VSS3GPP_intClipDecodeVideoUpToCts, the clip1 one first
+ ******************************************************************************
+*/
+M4OSA_ERR M4VSS3GPP_intDecodeClipsUpToCts(M4VSS3GPP_InternalEditContext *pC,
+                                               M4OSA_Bool bDecodeC1, M4OSA_Bool bDecodeC2,
+                                               M4OSA_Int32 iCts);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intStartDecodeAhead()
+ * @brief    Start decoding the next clip1 frame on the decode thread
+ * @note    To be called once the current frame is decoded, before it is
+ *           rendered and encoded. Does nothing unless the clip1 is decoded
+ *           up to its end and the next frame belongs to it.
+ * @param   pC    (IN/OUT) Internal edit context
+ ******************************************************************************
+*/
+M4OSA_Void M4VSS3GPP_intStartDecodeAhead(M4VSS3GPP_InternalEditContext *pC);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intWaitDecodeAhead()
+ * @brief    Wait for the decode ahead started by M4VSS3GPP_intStartDecodeAhead
+ * @note    Must be called before the clip1 is used again by the edit thread.
+ *           Does nothing if no decode ahead was started.
+ * @param   pC    (IN/OUT) Internal edit context
+ ******************************************************************************
+*/
+M4OSA_Void M4VSS3GPP_intWaitDecodeAhead(M4VSS3GPP_InternalEditContext *pC);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intReportStageStats()
+ * @brief    Trace the utilization of each stage: its busy time over the
+ *           edition time
+ * @param   pC    (IN) Internal edit context
+ ******************************************************************************
+*/
+M4OSA_Void M4VSS3GPP_intReportStageStats(M4VSS3GPP_InternalEditContext *pC);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,7 @@
 #include "M4DECODER_Common.h"        /**< Decoder common interface */
 #include "M4ENCODER_common.h"        /**< Encoder common interface */
 #include "M4VIFI_FiltersAPI.h"        /**< Image planes definition */
+#include "M4OSA_Time.h"                /**< Stage timings */
 #include "M4READER_3gpCom.h"        /**< Read 3GPP file     */
 #include "M4AD_Common.h"            /**< Decoder audio   */
 #include "M4ENCODER_AudioCommon.h"  /**< Encode audio    */
@@ -511,6 +512,61 @@ typedef struct
 } M4VSS3GPP_EncodeWriteContext;
 
 
+/**
+ ******************************************************************************
+ * structure    M4VSS3GPP_DecodeWorker
+ * @brief        Thread decoding the clip2 video of a transition while the edit
+ *               thread decodes the clip1 video, or the next clip1 frame while
+ *               the edit thread renders and encodes the current one
+ * @note        The two clips have their own reader and decoder, so their
+ *               decodings are independent. The rendering, which shares the AIR
+ *               context and the effect state of the edit context, stays on the
+ *               edit thread. A decode ahead only fills the decoder queue, which
+ *               the decoder shell protects against the concurrent rendering.
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_Context               pThread;        /**< OSAL thread running the decodings */
+    M4OSA_Context               semJob;         /**< Posted when a decoding is requested */
+    M4OSA_Context               semDone;        /**< Posted when the decoding is finished */
+    M4VSS3GPP_ClipContext       *pClipCtxt;     /**< Clip to decode */
+    M4OSA_Int32                 iCts;           /**< Target time of the decoding, in the
+                                                     clip time base for a decode ahead */
+    M4OSA_Bool                  bDecodeAhead;   /**< The request is a decode ahead */
+    M4OSA_Bool                  bPending;       /**< A decode ahead has not been waited for */
+    M4OSA_ERR                   err;            /**< Result of the decoding */
+    M4OSA_Bool                  bQuit;          /**< Set to stop the thread */
+} M4VSS3GPP_DecodeWorker;
+
+/**
+ ******************************************************************************
+ * structure    M4VSS3GPP_StageStats
+ * @brief        Time spent in each stage of the edition, in microseconds
+ * @note        Reported as a share of the edition time when the edition is
+ *               closed. The stages of the edit thread do not overlap. The decode
+ *               worker runs the clip2 decoding in parallel with the clip1
+ *               decoding, and the decode ahead in parallel with the rendering
+ *               and the encoding.
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_Time                  tStart;         /**< Time of the editOpen */
+    M4OSA_Time                  tDecode;        /**< Video decoding on the edit thread */
+    M4OSA_Time                  tDecodeWorker;  /**< Clip2 video decoding on the worker */
+    M4OSA_Time                  tDecodeAhead;   /**< Next frame decoding on the worker */
+    M4OSA_Time                  tDecodeAheadWait; /**< Edit thread waiting for the
+                                                     decode ahead */
+    M4OSA_Time                  tRender;        /**< Rendering, effects and transitions */
+    M4OSA_Time                  tEncode;        /**< Video encoding and writing, without
+                                                     the rendering */
+    M4OSA_Time                  tAudio;         /**< Audio decoding, mixing, encoding and
+                                                     writing */
+    M4OSA_UInt32                uiFrames;       /**< Number of rendered frames */
+} M4VSS3GPP_StageStats;
+
+
 /**
  ******************************************************************************
  * structure    M4VSS3GPP_InternalEditContext
@@ -610,6 +666,10 @@ typedef struct
 
     M4OSA_Bool bClip1ActiveFramingEffect; /**< Overlay flag for clip1 */
     M4OSA_Bool bClip2ActiveFramingEffect; /**< Overlay flag for clip2, used in transition */
+
+    M4VSS3GPP_DecodeWorker*     pDecodeWorker;  /**< Transition decoding thread, M4OSA_NULL
+                                                     when decoding sequentially */
+    M4VSS3GPP_StageStats        stats;          /**< Per stage timings */
 } M4VSS3GPP_InternalEditContext;
 
 
@@ -85,6 +85,8 @@ FILE *file_pcm_encoder = NULL;
  */
 
 static M4OSA_ERR M4MCS_intStepSet( M4MCS_InternalContext *pC );
+static M4OSA_Bool M4MCS_intIsVideoCopyPossible(
+                                    M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intPrepareVideoDecoder(
                                     M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intPrepareVideoEncoder(
@@ -5357,6 +5359,15 @@ M4OSA_ERR M4MCS_checkParamsAndStart( M4MCS_Context pContext )
         return M4MCS_ERR_VIDEOBITRATE_TOO_LOW;
     }
 
+    /* Re-encoding would not change the video stream: copy it instead */
+    if( M4OSA_TRUE == M4MCS_intIsVideoCopyPossible(pC) )
+    {
+        M4OSA_TRACE2_0(
+            "M4MCS_checkParamsAndStart : output video matches input, null encoding");
+        pC->EncodingVideoFormat = M4ENCODER_kNULL;
+        pC->encodingVideoProfile = pC->InputFileProperties.uiVideoProfile;
+    }
+
     /* Set end cut time if necessary (not an error) */
     if( pC->uiEndCutTime == 0 )
     {
@@ -5416,6 +5427,77 @@ M4OSA_ERR M4MCS_checkParamsAndStart( M4MCS_Context pContext )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4MCS_intIsVideoCopyPossible(M4MCS_InternalContext* pC)
+ * @brief    Tell if the requested video transcoding would only re-encode the
+ *           input video with the same codec, frame size and profile.
+ * @note     The requested bitrate and frame rate must not be lower than the
+ *           input ones, the requested timescale (if any) must be the input one
+ *           and the frames must be neither rotated nor rendered again,
+ *           otherwise the transcoding is really needed.
+ * @param    pC          (IN) MCS private context
+ * @return   M4OSA_TRUE if the input video stream can be copied
+ ******************************************************************************
+ */
+static M4OSA_Bool M4MCS_intIsVideoCopyPossible( M4MCS_InternalContext *pC )
+{
+    /* Frame rates of M4ENCODER_k5_FPS to M4ENCODER_k30_FPS */
+    static const M4OSA_Float fEncodingFrameRates[] =
+    {
+        5.0F, 7.5F, 10.0F, 12.5F, 15.0F, 20.0F, 25.0F, 30.0F
+    };
+    M4VIDEOEDITING_VideoFormat OutputVideoFormat;
+
+    if( ( pC->novideo == M4OSA_TRUE)
+        || (pC->EncodingVideoFormat == M4ENCODER_kNULL) )
+        return M4OSA_FALSE;
+
+    switch( pC->EncodingVideoFormat )
+    {
+        case M4ENCODER_kH263:
+            OutputVideoFormat = M4VIDEOEDITING_kH263;
+            break;
+
+        case M4ENCODER_kMPEG4:
+            OutputVideoFormat = M4VIDEOEDITING_kMPEG4;
+            break;
+
+        case M4ENCODER_kH264:
+            OutputVideoFormat = M4VIDEOEDITING_kH264;
+            break;
+
+        default:
+            return M4OSA_FALSE;
+    }
+
+    if( ( OutputVideoFormat != pC->InputFileProperties.VideoStreamType)
+        || (pC->EncodingWidth != pC->InputFileProperties.uiVideoWidth)
+        || (pC->EncodingHeight != pC->InputFileProperties.uiVideoHeight)
+        || (pC->encodingVideoProfile != pC->InputFileProperties.uiVideoProfile)
+        || (pC->encodingVideoLevel < pC->InputFileProperties.uiVideoLevel) )
+        return M4OSA_FALSE;
+
+    if( ( pC->uiVideoBitrate == M4VIDEOEDITING_kUndefinedBitrate)
+        || (pC->uiVideoBitrate < pC->InputFileProperties.uiVideoBitrate) )
+        return M4OSA_FALSE;
+
+    if( ( pC->EncodingVideoFramerate > M4ENCODER_k30_FPS)
+        || (fEncodingFrameRates[pC->EncodingVideoFramerate]
+        < pC->InputFileProperties.fAverageFrameRate) )
+        return M4OSA_FALSE;
+
+    if( ( pC->outputVideoTimescale != 0)
+        && (pC->outputVideoTimescale != pC->InputFileProperties.uiVideoTimeScale) )
+        return M4OSA_FALSE;
+
+    if( ( pC->InputFileProperties.videoRotationDegrees != 0)
+        || (pC->MediaRendering != M4MCS_kResizing) )
+        return M4OSA_FALSE;
+
+    return M4OSA_TRUE;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_intStepSet(M4MCS_InternalContext* pC)
@@ -35,6 +35,7 @@ LOCAL_SRC_FILES:=          \
       M4VSS3GPP_Codecs.c \
       M4VSS3GPP_Edit.c \
       M4VSS3GPP_EditAudio.c \
+      M4VSS3GPP_EditStages.c \
       M4VSS3GPP_EditVideo.c \
       M4VSS3GPP_MediaAndCodecSubscription.c \
       M4ChannelConverter.c \
@@ -47,6 +47,7 @@
 #include "M4OSA_Mutex.h"
 #include "M4OSA_Memory.h"
 #include "M4VIFI_FiltersAPI.h"
+#include "M4VIFI_RowFilters.h"
 #include "M4AIR_API.h"
 
 /************************ M4AIR INTERNAL TYPES DEFINITIONS ***********************/
@@ -440,6 +441,7 @@ M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_Image
         M4OSA_UInt8    *pu8_src_bottom;
     M4OSA_UInt32    u32_temp_value;
     M4OSA_Int32    i32_tmp_offset;
+    M4VIFI_UInt32    u32_plane_y_accum;
     M4OSA_UInt32    nb_planes;
 
 
@@ -602,7 +604,17 @@ M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_Image
         if(3 != i)    /**< other than alpha plane */
         {
             /**No +-90 rotation */
-            if(M4OSA_FALSE == pC->m_bRevertXY)
+            if((M4OSA_FALSE == pC->m_bRevertXY) && (M4OSA_FALSE == pC->m_bFlipX))
+            {
+                /**< Interpolate the whole plane at once, see M4VIFI_BilinearPlane */
+                u32_plane_y_accum = pC->u32_y_accum[i];
+                M4VIFI_BilinearPlane(&pu8_data_in, i32_tmp_offset, pu8_data_out,
+                    pOut[i].u_stride, pOut[i].u_width, pOut[i].u_height,
+                    pC->u32_x_accum_start[i], pC->u32_x_inc[i], &u32_plane_y_accum,
+                    pC->u32_y_inc[i]);
+                pC->u32_y_accum[i] = u32_plane_y_accum;
+            }
+            else if(M4OSA_FALSE == pC->m_bRevertXY)
             {
 
                 /**< Loop on each row */
@@ -44,6 +44,7 @@
 
 
 #include "VideoEditorResampler.h"
+#include "M4PCM_Mix.h"
 /**
  ******************************************************************************
  * @brief    Static functions
@@ -3336,10 +3337,7 @@ static M4OSA_ERR M4VSS3GPP_intAudioMixingDoMixing(
         frameTimeDelta; /**< Duration of the encoded (then written) data */
     M4OSA_MemAddr8 tempPosBuffer;
     /* ducking variable */
-    M4OSA_UInt16 loopIndex = 0;
-    M4OSA_Int16 *pPCM16Sample = M4OSA_NULL;
     M4OSA_Int32 peakDbValue = 0;
-    M4OSA_Int32 previousDbValue = 0;
     M4OSA_UInt32 i;
 
     /**
@@ -3428,32 +3426,10 @@ static M4OSA_ERR M4VSS3GPP_intAudioMixingDoMixing(
 
     if( pC->b_DuckingNeedeed )
     {
-        loopIndex = 0;
-        peakDbValue = 0;
-        previousDbValue = peakDbValue;
-
-        pPCM16Sample = (M4OSA_Int16 *)pC->pInputClipCtxt->
-            AudioDecBufferOut.m_dataAddress;
-
         //Calculate the peak value
-         while( loopIndex
-             < pC->pInputClipCtxt->AudioDecBufferOut.m_bufferSize
-            / sizeof(M4OSA_Int16) )
-        {
-            if( pPCM16Sample[loopIndex] >= 0 )
-            {
-                peakDbValue = previousDbValue > pPCM16Sample[loopIndex]
-                ? previousDbValue : pPCM16Sample[loopIndex];
-                previousDbValue = peakDbValue;
-            }
-            else
-            {
-                peakDbValue = previousDbValue > -pPCM16Sample[loopIndex]
-                ? previousDbValue : -pPCM16Sample[loopIndex];
-                previousDbValue = peakDbValue;
-            }
-            loopIndex++;
-        }
+        peakDbValue = M4PCM_peak((M4OSA_Int16 *)pC->pInputClipCtxt->
+            AudioDecBufferOut.m_dataAddress,
+            pC->pInputClipCtxt->AudioDecBufferOut.m_bufferSize / sizeof(M4OSA_Int16));
 
         pC->audioVolumeArray[pC->audVolArrIndex] =
             M4VSS3GPP_getDecibelSound(peakDbValue);
@@ -3514,65 +3490,14 @@ static M4OSA_ERR M4VSS3GPP_intAudioMixingDoMixing(
 
         /* Mixing Logic */
 
-        while( uiPCMsize-- > 0 )
-        {
-            M4OSA_Int32 temp;
-
-           /* set vol factor for BT and PT */
-            *pPCMdata2 = (M4OSA_Int16)(*pPCMdata2 * pC->fBTVolLevel);
-
-            *pPCMdata1 = (M4OSA_Int16)(*pPCMdata1 * pC->fPTVolLevel);
-
-            /* mix the two samples */
-
-            *pPCMdata2 = (M4OSA_Int16)(( *pPCMdata2) * (pC->duckingFactor));
-            *pPCMdata1 = (M4OSA_Int16)(*pPCMdata2 / 2 + *pPCMdata1 / 2);
-
-
-            if( *pPCMdata1 < 0 )
-            {
-                temp = -( *pPCMdata1)
-                    * 2; // bring to same Amplitude level as it was original
-
-                if( temp > 32767 )
-                {
-                    *pPCMdata1 = -32766; // less then max allowed value
-                }
-                else
-                {
-                    *pPCMdata1 = (M4OSA_Int16)(-temp);
-               }
-        }
-        else
-        {
-            temp = ( *pPCMdata1)
-                * 2; // bring to same Amplitude level as it was original
-
-            if( temp > 32768 )
-            {
-                *pPCMdata1 = 32767; // less than max allowed value
-            }
-            else
-            {
-                *pPCMdata1 = (M4OSA_Int16)temp;
-            }
-        }
-
-            pPCMdata2++;
-            pPCMdata1++;
-        }
+        M4PCM_mixAndDuck(pPCMdata1, pPCMdata1, pPCMdata2, uiPCMsize,
+            pC->fPTVolLevel, pC->fBTVolLevel, pC->duckingFactor);
     }
     else
     {
-        while( uiPCMsize-- > 0 )
-       {
         /* mix the two samples */
-            *pPCMdata1 = (M4OSA_Int16)(*pPCMdata1 * pC->fOrigFactor * pC->fPTVolLevel
-               + *pPCMdata2 * pC->fAddedFactor * pC->fBTVolLevel );
-
-            pPCMdata1++;
-            pPCMdata2++;
-        }
+        M4PCM_mixWeighted(pPCMdata1, pPCMdata1, pPCMdata2, uiPCMsize,
+            pC->fOrigFactor, pC->fPTVolLevel, pC->fAddedFactor, pC->fBTVolLevel);
     }
 
     /* Update pC->pSsrcBufferOut buffer */
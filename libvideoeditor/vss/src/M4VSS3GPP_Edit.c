@@ -245,6 +245,8 @@ M4OSA_ERR M4VSS3GPP_editInit( M4VSS3GPP_EditContext *pContext,
     pC->nbActiveEffects1 = 0;
     pC->bIssecondClip = M4OSA_FALSE;
     pC->m_air_context = M4OSA_NULL;
+    pC->pDecodeWorker = M4OSA_NULL;
+    memset((void *) &pC->stats, 0, sizeof(M4VSS3GPP_StageStats));
     /**
     * Return with no error */
     M4OSA_TRACE3_0("M4VSS3GPP_editInit(): returning M4NO_ERROR");
@@ -1332,6 +1334,21 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
     pC->Vstate = M4VSS3GPP_kEditVideoState_READ_WRITE;
     pC->Astate = M4VSS3GPP_kEditAudioState_READ_WRITE;
 
+    /**
+    * Start the thread decoding the second clip of the transitions and the
+    * next frames */
+    err = M4VSS3GPP_intOpenDecodeWorker(pC);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_editOpen: M4VSS3GPP_intOpenDecodeWorker returns 0x%x!",
+            err);
+        return err;
+    }
+
+    pC->stats.tStart = M4VSS3GPP_intGetTimeUs();
+
     /**
     * Return with no error */
     M4OSA_TRACE3_0("M4VSS3GPP_editOpen(): returning M4NO_ERROR");
@@ -1359,6 +1376,7 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
     M4VSS3GPP_InternalEditContext *pC =
         (M4VSS3GPP_InternalEditContext *)pContext;
     M4OSA_UInt32 uiProgressAudio, uiProgressVideo, uiProgress;
+    M4OSA_Time tStart;
     M4OSA_ERR err;
 
     M4OSA_TRACE3_1("M4VSS3GPP_editStep called with pContext=0x%x", pContext);
@@ -1379,15 +1397,21 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
             break;
 
         case M4VSS3GPP_kEditState_AUDIO:
+            tStart = M4VSS3GPP_intGetTimeUs();
             err = M4VSS3GPP_intEditStepAudio(pC);
+            pC->stats.tAudio += M4VSS3GPP_intGetTimeUs() - tStart;
             break;
 
         case M4VSS3GPP_kEditState_MP3:
+            tStart = M4VSS3GPP_intGetTimeUs();
             err = M4VSS3GPP_intEditStepMP3(pC);
+            pC->stats.tAudio += M4VSS3GPP_intGetTimeUs() - tStart;
             break;
 
         case M4VSS3GPP_kEditState_MP3_JUMP:
+            tStart = M4VSS3GPP_intGetTimeUs();
             err = M4VSS3GPP_intEditJumpMP3(pC);
+            pC->stats.tAudio += M4VSS3GPP_intGetTimeUs() - tStart;
             break;
 
         default:
@@ -1467,6 +1491,12 @@ M4OSA_ERR M4VSS3GPP_editClose( M4VSS3GPP_EditContext pContext )
         return M4ERR_STATE;
     }
 
+    /**
+    * Stop the transition decode thread before the clips are closed */
+    M4VSS3GPP_intCloseDecodeWorker(pC);
+
+    M4VSS3GPP_intReportStageStats(pC);
+
     /**
     * There may be an encoder to destroy */
     err = M4VSS3GPP_intDestroyVideoEncoder(pC);
@@ -2306,6 +2336,26 @@ M4VSS3GPP_intCreate3GPPOutputFile( M4VSS3GPP_EncodeWriteContext *pC_ewc,
         }
     }
 
+    /**
+    * Move the sample size and sync sample tables to files next to the temporary
+    file while writing, they are the ones growing with every sample of long exports */
+    if( M4OSA_NULL != pTempFile )
+    {
+        err = pC_ShellAPI->pWriterGlobalFcts->pFctSetOption(
+            pC_ewc->p3gpWriterContext,
+            M4WRITER_kTableSpillPath, (M4OSA_DataOption)pTempFile);
+
+        if( ( M4NO_ERROR != err) && (((M4OSA_UInt32)M4ERR_BAD_OPTION_ID) != err)
+            && (((M4OSA_UInt32)M4ERR_NOT_IMPLEMENTED) != err) )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intCreate3GPPOutputFile:\
+                writer set option M4WRITER_kTableSpillPath returns 0x%x",
+                err);
+            return err;
+        }
+    }
+
     /**
     * Set the version option of the writer */
     uiVersion =
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file    M4VSS3GPP_EditStages.c
+ * @brief    Parallel video decoding and per stage utilization of the edition
+ * @note    The video encoder already runs asynchronously (the encoder shell
+ *          queues a bounded number of frames to the codec and pulls the
+ *          encoded ones on its own thread). What remains on the edit thread
+ *          is the decoding, the rendering and the audio. A second thread
+ *          decodes the clip2 during the transitions, and otherwise the next
+ *          clip1 frame while the current one is rendered and encoded. At most
+ *          one frame is decoded ahead.
+ ******************************************************************************
+ */
+
+/****************/
+/*** Includes ***/
+/****************/
+
+#include "NXPSW_CompilerSwitches.h"
+/**
+ *    Our headers */
+#include "M4VSS3GPP_API.h"
+#include "M4VSS3GPP_ErrorCodes.h"
+#include "M4VSS3GPP_InternalTypes.h"
+#include "M4VSS3GPP_InternalFunctions.h"
+
+/**
+ *    OSAL headers */
+#include "M4OSA_Memory.h"    /**< OSAL memory management */
+#include "M4OSA_Debug.h"     /**< OSAL debug management */
+#include "M4OSA_Thread.h"    /**< OSAL thread management */
+#include "M4OSA_Semaphore.h" /**< OSAL semaphore management */
+
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ ******************************************************************************
+ * M4OSA_Time M4VSS3GPP_intGetTimeUs()
+ * @brief    Monotonic time used for the stage timings
+ * @return    Time in microseconds
+ ******************************************************************************
+ */
+M4OSA_Time M4VSS3GPP_intGetTimeUs( M4OSA_Void )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (M4OSA_Time)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intDecodeWorkerStep()
+ * @brief    Body of the decode thread, called in loop by the OSAL thread
+ * @note    Waits for a decoding request, does it and signals its end.
+ * @param   pParam    (IN) Internal edit context
+ * @return    M4NO_ERROR:    Keep running
+ * @return    M4ERR_STATE:  The worker is being closed, the thread ends
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intDecodeWorkerStep( M4OSA_Void *pParam )
+{
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pParam;
+    M4VSS3GPP_DecodeWorker *pWorker = pC->pDecodeWorker;
+    M4OSA_Time tStart;
+
+    M4OSA_semaphoreWait(pWorker->semJob, M4OSA_WAIT_FOREVER);
+
+    if( pWorker->bQuit )
+    {
+        /**
+        * Any other value than M4NO_ERROR stops the OSAL thread loop */
+        return M4ERR_STATE;
+    }
+
+    tStart = M4VSS3GPP_intGetTimeUs();
+
+    if( pWorker->bDecodeAhead )
+    {
+        /**
+        * Only fill the decoder queue: the clip state belongs to the edit
+        * thread, whose decoding of the frame then finds it already done */
+        M4_MediaTime dDecodeTime = (M4_MediaTime)pWorker->iCts;
+
+        pWorker->err =
+            pWorker->pClipCtxt->ShellAPI.m_pVideoDecoder->m_pFctDecode(
+            pWorker->pClipCtxt->pViDecCtxt, &dDecodeTime, M4OSA_FALSE, 0);
+        pC->stats.tDecodeAhead += M4VSS3GPP_intGetTimeUs() - tStart;
+    }
+    else
+    {
+        pWorker->err = M4VSS3GPP_intClipDecodeVideoUpToCts(pWorker->pClipCtxt,
+            pWorker->iCts);
+        pC->stats.tDecodeWorker += M4VSS3GPP_intGetTimeUs() - tStart;
+    }
+
+    M4OSA_semaphorePost(pWorker->semDone);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intFreeDecodeWorker()
+ * @brief    Free the decode worker resources, the thread must not be running
+ * @param   pWorker    (IN) Decode worker
+ ******************************************************************************
+ */
+static M4OSA_Void M4VSS3GPP_intFreeDecodeWorker( M4VSS3GPP_DecodeWorker *pWorker )
+{
+    if( M4OSA_NULL != pWorker->pThread )
+    {
+        M4OSA_threadSyncClose(pWorker->pThread);
+    }
+
+    if( M4OSA_NULL != pWorker->semJob )
+    {
+        M4OSA_semaphoreClose(pWorker->semJob);
+    }
+
+    if( M4OSA_NULL != pWorker->semDone )
+    {
+        M4OSA_semaphoreClose(pWorker->semDone);
+    }
+
+    free(pWorker);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intOpenDecodeWorker()
+ * @brief    Start the thread decoding the clip2 video during the transitions
+ *           and the next frames ahead of time
+ * @note    Does nothing if the edition has no video. If the thread cannot be
+ *           started, everything is decoded on the edit thread.
+ * @param   pC    (IN/OUT) Internal edit context
+ * @return    M4NO_ERROR:    No error
+ * @return    M4ERR_ALLOC:   Allocation error
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intOpenDecodeWorker( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_DecodeWorker *pWorker;
+    M4OSA_ERR err;
+
+    if( M4SYS_kVideoUnknown == pC->ewc.VideoStreamType )
+    {
+        return M4NO_ERROR;
+    }
+
+    pWorker = (M4VSS3GPP_DecodeWorker *)M4OSA_32bitAlignedMalloc(
+        sizeof(M4VSS3GPP_DecodeWorker), M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_DecodeWorker");
+
+    if( M4OSA_NULL == pWorker )
+    {
+        M4OSA_TRACE1_0(
+            "M4VSS3GPP_intOpenDecodeWorker: unable to allocate the worker,\
+            returning M4ERR_ALLOC");
+        return M4ERR_ALLOC;
+    }
+
+    pWorker->pThread = M4OSA_NULL;
+    pWorker->semJob = M4OSA_NULL;
+    pWorker->semDone = M4OSA_NULL;
+    pWorker->pClipCtxt = M4OSA_NULL;
+    pWorker->iCts = 0;
+    pWorker->bDecodeAhead = M4OSA_FALSE;
+    pWorker->bPending = M4OSA_FALSE;
+    pWorker->err = M4NO_ERROR;
+    pWorker->bQuit = M4OSA_FALSE;
+
+    err = M4OSA_semaphoreOpen(&pWorker->semJob, 0);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4OSA_semaphoreOpen(&pWorker->semDone, 0);
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4OSA_threadSyncOpen(&pWorker->pThread,
+            M4VSS3GPP_intDecodeWorkerStep);
+    }
+
+    /**
+    * The thread reads its context from pC, set it before starting */
+    pC->pDecodeWorker = pWorker;
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4OSA_threadSyncStart(pWorker->pThread, (M4OSA_Void *)pC);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intOpenDecodeWorker: cannot start the thread (0x%x),\
+            the video will be decoded on the edit thread", err);
+        pC->pDecodeWorker = M4OSA_NULL;
+        M4VSS3GPP_intFreeDecodeWorker(pWorker);
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intCloseDecodeWorker()
+ * @brief    Stop the decode thread, if any
+ * @param   pC    (IN/OUT) Internal edit context
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intCloseDecodeWorker( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_DecodeWorker *pWorker = pC->pDecodeWorker;
+
+    if( M4OSA_NULL == pWorker )
+    {
+        return M4NO_ERROR;
+    }
+
+    /**
+    * The worker is idle between two requests: wake it up so that it leaves
+    * its loop. M4OSA_threadSyncStop() returns M4ERR_STATE if the thread has
+    * already left it, which is expected. */
+    pWorker->bQuit = M4OSA_TRUE;
+    M4OSA_semaphorePost(pWorker->semJob);
+    M4OSA_threadSyncStop(pWorker->pThread);
+
+    M4VSS3GPP_intFreeDecodeWorker(pWorker);
+    pC->pDecodeWorker = M4OSA_NULL;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intDecodeClipsUpToCts()
+ * @brief    Decode the clip1 and/or clip2 video up to the target time
+ * @note    When both clips must be decoded and the decode thread is running,
+ *           the clip2 is decoded on it while the clip1 is decoded on the
+ *           calling thread.
+ * @param   pC            (IN/OUT) Internal edit context
+ * @param   bDecodeC1    (IN) Decode the clip1
+ * @param   bDecodeC2    (IN) Decode the clip2
+ * @param   iCts        (IN) Target time (output time base)
+ * @return    M4NO_ERROR:    No error
+ * @return    Error of M4VSS3GPP_intClipDecodeVideoUpToCts, the clip1 one first
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intDecodeClipsUpToCts( M4VSS3GPP_InternalEditContext *pC,
+                                                M4OSA_Bool bDecodeC1,
+                                                M4OSA_Bool bDecodeC2,
+                                                M4OSA_Int32 iCts )
+{
+    M4VSS3GPP_DecodeWorker *pWorker = pC->pDecodeWorker;
+    M4OSA_Time tStart = M4VSS3GPP_intGetTimeUs();
+    M4OSA_ERR errC1 = M4NO_ERROR;
+    M4OSA_ERR errC2 = M4NO_ERROR;
+
+    if( bDecodeC1 && bDecodeC2 && (M4OSA_NULL != pWorker) )
+    {
+        pWorker->pClipCtxt = pC->pC2;
+        pWorker->iCts = iCts;
+        pWorker->bDecodeAhead = M4OSA_FALSE;
+        M4OSA_semaphorePost(pWorker->semJob);
+
+        errC1 = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1, iCts);
+
+        /**
+        * Always wait for the clip2, even if the clip1 failed: the caller may
+        * close the clips as soon as we return */
+        M4OSA_semaphoreWait(pWorker->semDone, M4OSA_WAIT_FOREVER);
+        errC2 = pWorker->err;
+    }
+    else
+    {
+        if( bDecodeC1 )
+        {
+            errC1 = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1, iCts);
+        }
+
+        if( bDecodeC2 && (M4NO_ERROR == errC1) )
+        {
+            errC2 = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC2, iCts);
+        }
+    }
+
+    pC->stats.tDecode += M4VSS3GPP_intGetTimeUs() - tStart;
+
+    if( M4NO_ERROR != errC1 )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intDecodeClipsUpToCts: decoding of C1 returns 0x%x",
+            errC1);
+        return errC1;
+    }
+
+    if( M4NO_ERROR != errC2 )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intDecodeClipsUpToCts: decoding of C2 returns 0x%x",
+            errC2);
+    }
+
+    return errC2;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intStartDecodeAhead()
+ * @brief    Start decoding the next clip1 frame on the decode thread
+ * @note    The decode ahead reads the clip1 video access units before the
+ *           next edit step, so the clip1 must not switch to read/write mode,
+ *           where they are copied from the reader: only clips that are
+ *           decoded up to their end are decoded ahead.
+ * @note    The render of the current frame may run after the decode ahead,
+ *           and the decoder shell drops its oldest frames when its pool is
+ *           full. A clip with more input frames than output frames would
+ *           push the frame to render out of the pool, so only one input frame
+ *           is decoded ahead; the next edit step decodes the others.
+ * @param   pC    (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+M4OSA_Void M4VSS3GPP_intStartDecodeAhead( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_DecodeWorker *pWorker = pC->pDecodeWorker;
+    M4VSS3GPP_ClipContext *pClip = pC->pC1;
+    M4OSA_Float fFrameRate;
+    M4OSA_Int32 iNextCts;
+    M4OSA_Int32 iAheadCts;
+
+    if( ( M4OSA_NULL == pWorker)
+        || (M4VSS3GPP_kEditVideoState_DECODE_ENCODE != pC->Vstate)
+        || (M4VSS3GPP_kClipStatus_DECODE != pClip->Vstatus)
+        || (M4VIDEOEDITING_kFileType_ARGB8888 == pClip->pSettings->FileType) )
+    {
+        return;
+    }
+
+    if( ( M4OSA_FALSE == pClip->pSettings->bTranscodingRequired)
+        && (M4OSA_FALSE == pC->bEncodeTillEoF) )
+    {
+        return;
+    }
+
+    /**
+    * Same end of clip test as M4VSS3GPP_intEditStepVideo() */
+    iNextCts = (M4OSA_Int32)(pC->ewc.dInputVidCts + pC->dOutputFrameDuration);
+
+    if( ( iNextCts - pClip->iVoffset + pC->iInOutTimeOffset) >= pClip->iEndTime )
+    {
+        return;
+    }
+
+    /**
+    * One input frame ahead at most */
+    iAheadCts = iNextCts;
+    fFrameRate = pClip->pSettings->ClipProperties.fAverageFrameRate;
+
+    if( fFrameRate > 0 )
+    {
+        iAheadCts = (M4OSA_Int32)(pC->ewc.dInputVidCts + 1000.0 / fFrameRate);
+
+        if( iAheadCts > iNextCts )
+        {
+            iAheadCts = iNextCts;
+        }
+    }
+
+    pWorker->pClipCtxt = pClip;
+    pWorker->iCts = iAheadCts - pClip->iVoffset;
+    pWorker->bDecodeAhead = M4OSA_TRUE;
+    pWorker->bPending = M4OSA_TRUE;
+    M4OSA_semaphorePost(pWorker->semJob);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intWaitDecodeAhead()
+ * @brief    Wait for the decode ahead started by M4VSS3GPP_intStartDecodeAhead
+ * @note    A decode ahead error is only traced: the frame is decoded again by
+ *           the next edit step, which reports it.
+ * @param   pC    (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+M4OSA_Void M4VSS3GPP_intWaitDecodeAhead( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_DecodeWorker *pWorker = pC->pDecodeWorker;
+    M4OSA_Time tStart;
+
+    if( ( M4OSA_NULL == pWorker) || (M4OSA_FALSE == pWorker->bPending) )
+    {
+        return;
+    }
+
+    tStart = M4VSS3GPP_intGetTimeUs();
+    M4OSA_semaphoreWait(pWorker->semDone, M4OSA_WAIT_FOREVER);
+    pC->stats.tDecodeAheadWait += M4VSS3GPP_intGetTimeUs() - tStart;
+
+    pWorker->bPending = M4OSA_FALSE;
+    pWorker->bDecodeAhead = M4OSA_FALSE;
+
+    if( ( M4NO_ERROR != pWorker->err) && (M4WAR_NO_MORE_AU != pWorker->err) )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intWaitDecodeAhead: decoding ahead returns 0x%x",
+            pWorker->err);
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4VSS3GPP_intPerMille()
+ * @brief    Utilization of a stage, in per mille of the edition time
+ ******************************************************************************
+ */
+static M4OSA_UInt32 M4VSS3GPP_intPerMille( M4OSA_Time tBusy, M4OSA_Time tTotal )
+{
+    return (M4OSA_UInt32)(tBusy * 1000 / tTotal);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intReportStageStats()
+ * @brief    Trace the utilization of each stage: its busy time over the
+ *           edition time
+ * @note    The stage with the highest utilization bounds the edition speed.
+ *           The edit thread and the decode worker run in parallel, so their
+ *           stages add up to 100% per thread at most.
+ * @param   pC    (IN) Internal edit context
+ ******************************************************************************
+ */
+M4OSA_Void M4VSS3GPP_intReportStageStats( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_StageStats *pStats = &pC->stats;
+    M4OSA_Time tTotal, tEditThread, tWorker;
+    M4OSA_UInt32 u;
+
+    if( 0 == pStats->tStart )
+    {
+        /**
+        * The edition has not been opened */
+        return;
+    }
+
+    tTotal = M4VSS3GPP_intGetTimeUs() - pStats->tStart;
+
+    if( tTotal <= 0 )
+    {
+        tTotal = 1;
+    }
+
+    tEditThread = pStats->tDecode + pStats->tRender + pStats->tEncode
+        + pStats->tAudio;
+    tWorker = pStats->tDecodeWorker + pStats->tDecodeAhead;
+
+    M4OSA_TRACE1_3("M4VSS3GPP edition: %lu frames in %lu ms (%lu fps)",
+        (M4OSA_UInt32)pStats->uiFrames, (M4OSA_UInt32)(tTotal / 1000),
+        (M4OSA_UInt32)((M4OSA_Time)pStats->uiFrames * 1000000 / tTotal));
+
+    u = M4VSS3GPP_intPerMille(tEditThread, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization: edit thread %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tDecode, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   decode %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tRender, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   render %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tEncode, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   encode %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tAudio, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   audio %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tDecodeAheadWait, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   idle on decode ahead %lu.%lu%%",
+        u / 10, u % 10);
+
+    u = M4VSS3GPP_intPerMille(tWorker, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization: decode worker %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tDecodeAhead, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   decode ahead %lu.%lu%%", u / 10, u % 10);
+    u = M4VSS3GPP_intPerMille(pStats->tDecodeWorker, tTotal);
+    M4OSA_TRACE1_2("M4VSS3GPP utilization:   transition decode %lu.%lu%%",
+        u / 10, u % 10);
+}
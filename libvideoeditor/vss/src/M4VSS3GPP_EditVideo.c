@@ -118,6 +118,12 @@ static M4OSA_ERR M4VSS3GPP_intApplyVideoOverlay (
                                       M4VIFI_ImagePlane *pPlaneIn,
                                       M4VIFI_ImagePlane *pPlaneOut);
 
+static M4OSA_ERR M4VSS3GPP_intRenderFrame(M4VSS3GPP_InternalEditContext *pC,
+                                      M4VIFI_ImagePlane *pPlaneOut);
+
+static M4OSA_ERR M4VSS3GPP_intEncodeFrame(M4VSS3GPP_InternalEditContext *pC,
+                                      M4ENCODER_FrameMode FrameMode);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intEditStepVideo()
@@ -131,6 +137,7 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
     M4OSA_Int32 iCts, iNextCts;
     M4ENCODER_FrameMode FrameMode;
     M4OSA_Bool bSkipFrame;
+    M4OSA_Bool bDecodeC1, bDecodeC2;
     M4OSA_UInt16 offset;
 
     /**
@@ -440,7 +447,8 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 * Decode the video up to the target time
                 (will jump to the previous RAP if needed ) */
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
-                err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1, (M4OSA_Int32)pC->ewc.dInputVidCts);
+                err = M4VSS3GPP_intDecodeClipsUpToCts(pC, M4OSA_TRUE, M4OSA_FALSE,
+                    (M4OSA_Int32)pC->ewc.dInputVidCts);
                 if( M4NO_ERROR != err )
                 {
                     M4OSA_TRACE1_1(
@@ -470,9 +478,15 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 else
                     FrameMode = M4ENCODER_kNormalFrame;
 
+                /**
+                * Decode the next frame while this one is rendered and encoded */
+                M4VSS3GPP_intStartDecodeAhead(pC);
+
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
-                err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctEncode(pC->ewc.pEncContext, M4OSA_NULL,
-                pC->ewc.dInputVidCts, FrameMode);
+                err = M4VSS3GPP_intEncodeFrame(pC, FrameMode);
+
+                M4VSS3GPP_intWaitDecodeAhead(pC);
+
                 /**
                 * Check if we had a VPP error... */
                 if( M4NO_ERROR != pC->ewc.VppError )
@@ -544,82 +558,62 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 M4OSA_TRACE3_0("M4VSS3GPP_intEditStepVideo TRANSITION");
 
                 /* Don't decode more than needed */
-                if( !(( M4VSS3GPP_kClipStatus_DECODE_UP_TO != pC->pC1->Vstatus)
-                    && (M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC2->Vstatus)) )
-                {
-                    /**
-                    * Decode the clip1 video up to the target time
-                    (will jump to the previous RAP if needed */
-                    if ((pC->pC1->pSettings->FileType ==
+                bDecodeC1 = !(( M4VSS3GPP_kClipStatus_DECODE_UP_TO != pC->pC1->Vstatus)
+                    && (M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC2->Vstatus));
+                bDecodeC2 = !(( M4VSS3GPP_kClipStatus_DECODE_UP_TO != pC->pC2->Vstatus)
+                    && (M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC1->Vstatus));
+
+                if( bDecodeC1
+                    && (pC->pC1->pSettings->FileType ==
                           M4VIDEOEDITING_kFileType_ARGB8888) &&
                         (M4OSA_FALSE ==
                          pC->pC1->pSettings->ClipProperties.bSetImageData)) {
 
-                        err = M4VSS3GPP_intSetYuv420PlaneFromARGB888(pC, pC->pC1);
-                        if( M4NO_ERROR != err ) {
-                            M4OSA_TRACE1_1(
-                                "M4VSS3GPP_intEditStepVideo: TRANSITION:\
-                                M4VSS3GPP_intSetYuv420PlaneFromARGB888 err=%x", err);
-                            return err;
-                        }
-                    }
-                    // Decorrelate input and output encoding timestamp to handle encoder prefetch
-                    err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1,
-                         (M4OSA_Int32)pC->ewc.dInputVidCts);
-                    if( M4NO_ERROR != err )
-                    {
+                    err = M4VSS3GPP_intSetYuv420PlaneFromARGB888(pC, pC->pC1);
+                    if( M4NO_ERROR != err ) {
                         M4OSA_TRACE1_1(
                             "M4VSS3GPP_intEditStepVideo: TRANSITION:\
-                            M4VSS3GPP_intDecodeVideoUpToCts(C1) returns err=0x%x",
-                            err);
+                            M4VSS3GPP_intSetYuv420PlaneFromARGB888 err=%x", err);
                         return err;
                     }
-
-                    /* If the decoding is not completed, do one more step with time frozen */
-                    if( M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC1->Vstatus )
-                    {
-                        return M4NO_ERROR;
-                    }
                 }
 
-                /* Don't decode more than needed */
-                if( !(( M4VSS3GPP_kClipStatus_DECODE_UP_TO != pC->pC2->Vstatus)
-                    && (M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC1->Vstatus)) )
-                {
-                    /**
-                    * Decode the clip2 video up to the target time
-                        (will jump to the previous RAP if needed) */
-                    if ((pC->pC2->pSettings->FileType ==
+                if( bDecodeC2
+                    && (pC->pC2->pSettings->FileType ==
                           M4VIDEOEDITING_kFileType_ARGB8888) &&
                         (M4OSA_FALSE ==
                           pC->pC2->pSettings->ClipProperties.bSetImageData)) {
 
-                        err = M4VSS3GPP_intSetYuv420PlaneFromARGB888(pC, pC->pC2);
-                        if( M4NO_ERROR != err ) {
-                            M4OSA_TRACE1_1(
-                                "M4VSS3GPP_intEditStepVideo: TRANSITION:\
-                                M4VSS3GPP_intSetYuv420PlaneFromARGB888 err=%x", err);
-                            return err;
-                        }
-                    }
-
-                    // Decorrelate input and output encoding timestamp to handle encoder prefetch
-                    err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC2,
-                         (M4OSA_Int32)pC->ewc.dInputVidCts);
-                    if( M4NO_ERROR != err )
-                    {
+                    err = M4VSS3GPP_intSetYuv420PlaneFromARGB888(pC, pC->pC2);
+                    if( M4NO_ERROR != err ) {
                         M4OSA_TRACE1_1(
                             "M4VSS3GPP_intEditStepVideo: TRANSITION:\
-                            M4VSS3GPP_intDecodeVideoUpToCts(C2) returns err=0x%x",
-                            err);
+                            M4VSS3GPP_intSetYuv420PlaneFromARGB888 err=%x", err);
                         return err;
                     }
+                }
 
-                    /* If the decoding is not completed, do one more step with time frozen */
-                    if( M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC2->Vstatus )
-                    {
-                        return M4NO_ERROR;
-                    }
+                /**
+                * Decode the clip1 and clip2 videos up to the target time
+                (will jump to the previous RAP if needed). The two clips are
+                decoded in parallel when the decode thread is running. */
+                // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                err = M4VSS3GPP_intDecodeClipsUpToCts(pC, bDecodeC1, bDecodeC2,
+                     (M4OSA_Int32)pC->ewc.dInputVidCts);
+                if( M4NO_ERROR != err )
+                {
+                    M4OSA_TRACE1_1(
+                        "M4VSS3GPP_intEditStepVideo: TRANSITION:\
+                        M4VSS3GPP_intDecodeClipsUpToCts returns err=0x%x",
+                        err);
+                    return err;
+                }
+
+                /* If the decoding is not completed, do one more step with time frozen */
+                if( ( M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC1->Vstatus)
+                    || (M4VSS3GPP_kClipStatus_DECODE_UP_TO == pC->pC2->Vstatus) )
+                {
+                    return M4NO_ERROR;
                 }
 
                 /**
@@ -632,8 +626,7 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 * Encode the frame (rendering, filtering and writing will be done
                 in encoder callbacks */
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
-                err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctEncode(pC->ewc.pEncContext, M4OSA_NULL,
-                    pC->ewc.dInputVidCts, M4ENCODER_kNormalFrame);
+                err = M4VSS3GPP_intEncodeFrame(pC, M4ENCODER_kNormalFrame);
 
                 /**
                 * If encode returns a process frame error, it is likely to be a VPP error */
@@ -713,6 +706,34 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intEncodeFrame()
+ * @brief    Encode the frame at the current input time
+ * @note    The rendering is done by the encoder through M4VSS3GPP_intVPP(), its
+ *           time is not counted in the encoding time.
+ * @param   pC            (IN/OUT) Internal edit context
+ * @param   FrameMode    (IN) Normal frame or I-frame
+ * @return    Error of pFctEncode
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intEncodeFrame( M4VSS3GPP_InternalEditContext *pC,
+                                          M4ENCODER_FrameMode FrameMode )
+{
+    M4OSA_Time tStart = M4VSS3GPP_intGetTimeUs();
+    M4OSA_Time tRender = pC->stats.tRender;
+    M4OSA_ERR err;
+
+    // Decorrelate input and output encoding timestamp to handle encoder prefetch
+    err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctEncode(pC->ewc.pEncContext, M4OSA_NULL,
+        pC->ewc.dInputVidCts, FrameMode);
+
+    pC->stats.tEncode += M4VSS3GPP_intGetTimeUs() - tStart
+        - (pC->stats.tRender - tRender);
+
+    return err;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intCheckVideoMode()
@@ -1061,6 +1082,34 @@ M4OSA_ERR M4VSS3GPP_intProcessAU( M4WRITER_Context pContext,
  */
 M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
                            M4VIFI_ImagePlane *pPlaneOut )
+{
+    /**
+    * VPP context is actually the VSS3GPP context */
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pContext;
+    M4OSA_Time tStart = M4VSS3GPP_intGetTimeUs();
+    M4OSA_ERR err;
+
+    err = M4VSS3GPP_intRenderFrame(pC, pPlaneOut);
+
+    pC->stats.tRender += M4VSS3GPP_intGetTimeUs() - tStart;
+    pC->stats.uiFrames++;
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intRenderFrame()
+ * @brief    Render the current frame with its effects or its transition
+ * @param    pC            (IN/OUT) Internal edit context
+ * @param    pPlaneOut    (IN/OUT) Pointer to an array of 3 planes that will contain the output
+ *                                  YUV420 image
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intRenderFrame( M4VSS3GPP_InternalEditContext *pC,
+                                          M4VIFI_ImagePlane *pPlaneOut )
 {
     M4OSA_ERR err = M4NO_ERROR;
     M4_MediaTime ts;
@@ -1071,10 +1120,6 @@ M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
     M4VIFI_ImagePlane pTempPlaneClip1[3],pTempPlaneClip2[3];
     M4OSA_UInt32  i = 0, yuvFrameWidth = 0, yuvFrameHeight = 0;
     M4OSA_Bool bSkipFrameEffect = M4OSA_FALSE;
-    /**
-    * VPP context is actually the VSS3GPP context */
-    M4VSS3GPP_InternalEditContext *pC =
-        (M4VSS3GPP_InternalEditContext *)pContext;
 
     memset((void *)pTemp1, 0, 3*sizeof(M4VIFI_ImagePlane));
     memset((void *)pTemp2, 0, 3*sizeof(M4VIFI_ImagePlane));
@@ -3550,11 +3595,8 @@ M4OSA_ERR M4VSS3GPP_intRenderFrameWithEffect(M4VSS3GPP_InternalEditContext *pC,
     M4VIFI_ImagePlane *pDecoderRenderFrame = M4OSA_NULL;
     M4OSA_UInt32 yuvFrameWidth = 0, yuvFrameHeight = 0;
     M4VIFI_ImagePlane* pTmp = M4OSA_NULL;
-    M4VIFI_ImagePlane pTemp[3];
-    M4OSA_UInt8 i = 0;
     M4OSA_Bool bSkipFramingEffect = M4OSA_FALSE;
 
-    memset((void *)pTemp, 0, 3*sizeof(M4VIFI_ImagePlane));
     /* Resize or rotate case */
     if (M4OSA_NULL != pClipCtxt->m_pPreResizeFrame) {
         /**
@@ -3653,88 +3695,40 @@ M4OSA_ERR M4VSS3GPP_intRenderFrameWithEffect(M4VSS3GPP_InternalEditContext *pC,
         if ((pClipCtxt->bGetYuvDataFromDecoder == M4OSA_TRUE) ||
             (pClipCtxt->pSettings->FileType !=
              M4VIDEOEDITING_kFileType_ARGB8888)) {
+            /* The overlay is applied in place on the rendered frame,
+             * the framing effect reads every sample before writing it.
+             * The resize and the other effects stay separate passes, the
+             * external effect functions work on whole planes */
             if (bIsClip1 == M4OSA_TRUE) {
-                if (pC->bClip1ActiveFramingEffect == M4OSA_TRUE) {
-                    err = M4VSS3GPP_intAllocateYUV420(pTemp,
-                            pPlaneOut[0].u_width, pPlaneOut[0].u_height);
-                    if (M4NO_ERROR != err) {
-                        M4OSA_TRACE1_1("M4VSS3GPP_intVPP: \
-                            M4VSS3GPP_intAllocateYUV420 error 0x%x", err);
-                        pC->ewc.VppError = err;
-                        return M4NO_ERROR;
-                    }
-                    pTmp = pTemp;
-                } else {
-                    pTmp = pC->yuv1;
-                }
-                err = M4VSS3GPP_intApplyRenderingMode (pC,
-                        pClipCtxt->pSettings->xVSS.MediaRendering,
-                        pDecoderRenderFrame,pTmp);
+                pTmp = pC->yuv1;
             } else {
-                if (pC->bClip2ActiveFramingEffect == M4OSA_TRUE) {
-                    err = M4VSS3GPP_intAllocateYUV420(pTemp,
-                            pPlaneOut[0].u_width, pPlaneOut[0].u_height);
-                    if (M4NO_ERROR != err) {
-                        M4OSA_TRACE1_1("M4VSS3GPP_intVPP: \
-                            M4VSS3GPP_intAllocateYUV420 error 0x%x", err);
-                        pC->ewc.VppError = err;
-                        return M4NO_ERROR;
-                    }
-                    pTmp = pTemp;
-                } else {
-                    pTmp = pC->yuv2;
-                }
-                err = M4VSS3GPP_intApplyRenderingMode (pC,
-                        pClipCtxt->pSettings->xVSS.MediaRendering,
-                        pDecoderRenderFrame,pTmp);
+                pTmp = pC->yuv2;
             }
+            err = M4VSS3GPP_intApplyRenderingMode (pC,
+                    pClipCtxt->pSettings->xVSS.MediaRendering,
+                    pDecoderRenderFrame,pTmp);
             if (M4NO_ERROR != err) {
                 M4OSA_TRACE1_1("M4VSS3GPP_intRenderFrameWithEffect: \
                     M4VSS3GPP_intApplyRenderingMode error 0x%x ", err);
-                for (i=0; i<3; i++) {
-                    if (pTemp[i].pac_data != M4OSA_NULL) {
-                        free(pTemp[i].pac_data);
-                        pTemp[i].pac_data = M4OSA_NULL;
-                    }
-                }
                 return err;
             }
             /* Apply overlay if overlay exist*/
-            if (bIsClip1 == M4OSA_TRUE) {
-                if (pC->bClip1ActiveFramingEffect == M4OSA_TRUE) {
-                    err = M4VSS3GPP_intApplyVideoOverlay(pC,
-                        pTemp, pC->yuv1);
-                }
-                pClipCtxt->lastDecodedPlane = pC->yuv1;
-            } else {
-                if (pC->bClip2ActiveFramingEffect == M4OSA_TRUE) {
-                    err = M4VSS3GPP_intApplyVideoOverlay(pC,
-                        pTemp, pC->yuv2);
-                }
-                pClipCtxt->lastDecodedPlane = pC->yuv2;
-            }
-            if (M4NO_ERROR != err) {
-                M4OSA_TRACE1_1("M4VSS3GPP_intVPP: \
-                    M4VSS3GPP_intApplyVideoOverlay) error 0x%x ", err);
-                pC->ewc.VppError = err;
-                for (i=0; i<3; i++) {
-                    if (pTemp[i].pac_data != M4OSA_NULL) {
-                        free(pTemp[i].pac_data);
-                        pTemp[i].pac_data = M4OSA_NULL;
-                    }
+            if (((bIsClip1 == M4OSA_TRUE) &&
+                 (pC->bClip1ActiveFramingEffect == M4OSA_TRUE)) ||
+                ((bIsClip1 == M4OSA_FALSE) &&
+                 (pC->bClip2ActiveFramingEffect == M4OSA_TRUE))) {
+                err = M4VSS3GPP_intApplyVideoOverlay(pC, pTmp, pTmp);
+                if (M4NO_ERROR != err) {
+                    M4OSA_TRACE1_1("M4VSS3GPP_intVPP: \
+                        M4VSS3GPP_intApplyVideoOverlay) error 0x%x ", err);
+                    pC->ewc.VppError = err;
+                    return M4NO_ERROR;
                 }
-                return M4NO_ERROR;
             }
+            pClipCtxt->lastDecodedPlane = pTmp;
         } else {
             pClipCtxt->lastDecodedPlane = pClipCtxt->pPlaneYuvWithEffect;
         }
-        // free the temp buffer
-        for (i=0; i<3; i++) {
-            if (pTemp[i].pac_data != M4OSA_NULL) {
-                free(pTemp[i].pac_data);
-                pTemp[i].pac_data = M4OSA_NULL;
-            }
-        }
 
         if ((pClipCtxt->pSettings->FileType ==
                  M4VIDEOEDITING_kFileType_ARGB8888) &&
@@ -38,6 +38,7 @@
 /**
  * component includes */
 #include "M4VFL_transition.h"            /**< video effects */
+#include "M4VIFI_RowFilters.h"
 
 /* Internal header file of VSS is included because of MMS use case */
 #include "M4VSS3GPP_InternalTypes.h"
@@ -3654,7 +3655,7 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
                                              M4OSA_UInt32 uiEffectKind)
 {
     M4VIFI_Int32 plane_number;
-    M4VIFI_UInt32 i,j;
+    M4VIFI_UInt32 i;
     M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
     M4xVSS_ColorStruct* ColorContext = (M4xVSS_ColorStruct*)pFunctionContext;
 
@@ -3771,10 +3772,8 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
                 switch (ColorContext->colorEffectType)
                 {
                 case M4xVSS_kVideoEffectType_Negative:
-                    for(j=0;j<PlaneOut[plane_number].u_width;j++)
-                    {
-                            p_buf_dest[j] = 255 - p_buf_src[j];
-                    }
+                    M4VIFI_InvertRow(p_buf_dest, p_buf_src,
+                     PlaneOut[plane_number].u_width);
                     break;
                 default:
                     memcpy((void *)p_buf_dest,
@@ -3816,18 +3815,23 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFraming( M4OSA_Void *userData,
                                                 M4OSA_UInt32 uiEffectKind )
 {
     M4VIFI_UInt32 x,y;
+    M4VIFI_UInt32 u32_width, u32_height, u32_framing_width;
+    M4VIFI_UInt32 u32_row_start, u32_row_end, u32_col_start, u32_col_end;
+    M4VIFI_UInt32 u32_plane;
+    M4VIFI_UInt8 *pu8_in, *pu8_out, *pu8_framing, *pu8_rgb;
+    M4VIFI_UInt8 u8_value;
+    M4OSA_Float alphaBlending = 1;
+    M4xVSS_internalEffectsAlphaBlending* alphaBlendingStruct =
+     (M4xVSS_internalEffectsAlphaBlending*)
+        ((M4xVSS_FramingContext*)userData)->alphaBlendingStruct;
 
     M4VIFI_UInt8 *p_in_Y = PlaneIn[0].pac_data;
-    M4VIFI_UInt8 *p_in_U = PlaneIn[1].pac_data;
-    M4VIFI_UInt8 *p_in_V = PlaneIn[2].pac_data;
 
     M4xVSS_FramingStruct* Framing = M4OSA_NULL;
     M4xVSS_FramingStruct* currentFraming = M4OSA_NULL;
     M4VIFI_UInt8 *FramingRGB = M4OSA_NULL;
 
     M4VIFI_UInt8 *p_out0;
-    M4VIFI_UInt8 *p_out1;
-    M4VIFI_UInt8 *p_out2;
 
     M4VIFI_UInt32 topleft[2];
 
@@ -3852,12 +3856,8 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFraming( M4OSA_Void *userData,
     /**
      * Initialize input / output plane pointers */
     p_in_Y += PlaneIn[0].u_topleft;
-    p_in_U += PlaneIn[1].u_topleft;
-    p_in_V += PlaneIn[2].u_topleft;
 
     p_out0 = PlaneOut[0].pac_data;
-    p_out1 = PlaneOut[1].pac_data;
-    p_out2 = PlaneOut[2].pac_data;
 
     /**
      * Depending on time, initialize Framing frame to use */
@@ -3875,112 +3875,163 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFraming( M4OSA_Void *userData,
     topleft[0] = currentFraming->topleft_x;
     topleft[1] = currentFraming->topleft_y;
 
-    for( x=0 ;x < PlaneIn[0].u_height ; x++)
+    /*Alpha blending support, the factor only depends on the progress*/
+    if(alphaBlendingStruct != M4OSA_NULL)
     {
-        for( y=0 ;y < PlaneIn[0].u_width ; y++)
+        if(pProgress->uiProgress \
+        < (M4OSA_UInt32)(alphaBlendingStruct->m_fadeInTime*10))
         {
-            /**
-             * To handle framing with input size != output size
-             * Framing is applyed if coordinates matches between framing/topleft and input plane */
-            if( y < (topleft[0] + currentFraming->FramingYuv[0].u_width)  &&
-                y >= topleft[0] &&
-                x < (topleft[1] + currentFraming->FramingYuv[0].u_height) &&
-                x >= topleft[1])
+            if(alphaBlendingStruct->m_fadeInTime == 0) {
+                alphaBlending = alphaBlendingStruct->m_start / 100;
+            } else {
+                alphaBlending = ((M4OSA_Float)(alphaBlendingStruct->m_middle\
+                 - alphaBlendingStruct->m_start)\
+                    *pProgress->uiProgress/(alphaBlendingStruct->m_fadeInTime*10));
+                alphaBlending += alphaBlendingStruct->m_start;
+                alphaBlending /= 100;
+            }
+        }
+        else if(pProgress->uiProgress >= (M4OSA_UInt32)(alphaBlendingStruct->\
+        m_fadeInTime*10) && pProgress->uiProgress < 1000\
+         - (M4OSA_UInt32)(alphaBlendingStruct->m_fadeOutTime*10))
+        {
+            alphaBlending = (M4OSA_Float)\
+            ((M4OSA_Float)alphaBlendingStruct->m_middle/100);
+        }
+        else if(pProgress->uiProgress >= 1000 - (M4OSA_UInt32)\
+        (alphaBlendingStruct->m_fadeOutTime*10))
+        {
+            if(alphaBlendingStruct->m_fadeOutTime == 0) {
+                alphaBlending = alphaBlendingStruct->m_end / 100;
+            } else {
+                alphaBlending = ((M4OSA_Float)(alphaBlendingStruct->m_middle \
+                - alphaBlendingStruct->m_end))*(1000 - pProgress->uiProgress)\
+                /(alphaBlendingStruct->m_fadeOutTime*10);
+                alphaBlending += alphaBlendingStruct->m_end;
+                alphaBlending /= 100;
+            }
+        }
+    }
+
+    /**
+     * To handle framing with input size != output size
+     * Framing is applyed if coordinates matches between framing/topleft and input plane.
+     * The RGB565 framing rows are u32_framing_width pixels apart, even when the
+     * framing is cut by the right edge of the plane */
+    u32_width = PlaneIn[0].u_width;
+    u32_height = PlaneIn[0].u_height;
+    u32_framing_width = currentFraming->FramingYuv[0].u_width;
+
+    u32_col_start = (topleft[0] < u32_width) ? topleft[0] : u32_width;
+    u32_col_end = topleft[0] + u32_framing_width;
+    if (u32_col_end > u32_width)
+    {
+        u32_col_end = u32_width;
+    }
+    u32_row_start = (topleft[1] < u32_height) ? topleft[1] : u32_height;
+    u32_row_end = topleft[1] + currentFraming->FramingYuv[0].u_height;
+    if (u32_row_end > u32_height)
+    {
+        u32_row_end = u32_height;
+    }
+
+    /**
+     * The planes are processed row by row, PlaneOut may be PlaneIn as every
+     * sample is read before it is written. Pixels outside of the framing or
+     * transparent are copied from the input plane */
+    for( x=0 ;x < u32_height ; x++)
+    {
+        pu8_in = p_in_Y + x*PlaneIn[0].u_stride;
+        pu8_out = p_out0 + x*PlaneOut[0].u_stride;
+
+        if (pu8_out != pu8_in)
+        {
+            memcpy((void *)pu8_out, (void *)pu8_in, u32_width);
+        }
+
+        if (x < u32_row_start || x >= u32_row_end)
+        {
+            continue;
+        }
+
+        pu8_rgb = FramingRGB + 2*(x-topleft[1])*u32_framing_width;
+        pu8_framing = currentFraming->FramingYuv[0].pac_data
+            + (x-topleft[1])*currentFraming->FramingYuv[0].u_stride;
+
+        for( y=u32_col_start ;y < u32_col_end ; y++, pu8_rgb += 2)
+        {
+            if((*(pu8_rgb)==transparent1) && (*(pu8_rgb+1)==transparent2))
+            {
+                continue;
+            }
+            if (alphaBlending == 1)
             {
-                /*Alpha blending support*/
-                M4OSA_Float alphaBlending = 1;
-                M4xVSS_internalEffectsAlphaBlending*  alphaBlendingStruct =\
-                 (M4xVSS_internalEffectsAlphaBlending*)\
-                    ((M4xVSS_FramingContext*)userData)->alphaBlendingStruct;
+                pu8_out[y] = pu8_framing[y-topleft[0]];
+            }
+            else
+            {
+                u8_value = pu8_framing[y-topleft[0]]*alphaBlending;
+                u8_value += pu8_in[y]*(1-alphaBlending);
+                pu8_out[y] = u8_value;
+            }
+        }
+    }
+
+    /**
+     * A chroma sample is shared by up to 4 pixels, it is taken from the last
+     * of them in scan order, i.e. the bottom right one */
+    for (u32_plane = 1; u32_plane < 3; u32_plane++)
+    {
+        for( x=0 ;x < (u32_height+1)>>1 ; x++)
+        {
+            M4VIFI_UInt32 u32_luma_row = (2*x+1 < u32_height) ? 2*x+1 : u32_height-1;
+
+            pu8_in = PlaneIn[u32_plane].pac_data + PlaneIn[u32_plane].u_topleft
+                + x*PlaneIn[u32_plane].u_stride;
+            pu8_out = PlaneOut[u32_plane].pac_data + x*PlaneOut[u32_plane].u_stride;
+
+            if (pu8_out != pu8_in)
+            {
+                memcpy((void *)pu8_out, (void *)pu8_in, (u32_width+1)>>1);
+            }
+
+            if (u32_luma_row < u32_row_start || u32_luma_row >= u32_row_end)
+            {
+                continue;
+            }
+
+            pu8_rgb = FramingRGB + 2*(u32_luma_row-topleft[1])*u32_framing_width;
+            pu8_framing = currentFraming->FramingYuv[u32_plane].pac_data
+                + ((u32_luma_row-topleft[1])>>1)*currentFraming->FramingYuv[u32_plane].u_stride;
 
-                if(alphaBlendingStruct != M4OSA_NULL)
+            for( y=u32_col_start>>1 ;y < (u32_width+1)>>1 ; y++)
+            {
+                M4VIFI_UInt32 u32_luma_col = (2*y+1 < u32_width) ? 2*y+1 : u32_width-1;
+
+                if (u32_luma_col >= u32_col_end)
                 {
-                    if(pProgress->uiProgress \
-                    < (M4OSA_UInt32)(alphaBlendingStruct->m_fadeInTime*10))
-                    {
-                        if(alphaBlendingStruct->m_fadeInTime == 0) {
-                            alphaBlending = alphaBlendingStruct->m_start / 100;
-                        } else {
-                            alphaBlending = ((M4OSA_Float)(alphaBlendingStruct->m_middle\
-                             - alphaBlendingStruct->m_start)\
-                                *pProgress->uiProgress/(alphaBlendingStruct->m_fadeInTime*10));
-                            alphaBlending += alphaBlendingStruct->m_start;
-                            alphaBlending /= 100;
-                        }
-                    }
-                    else if(pProgress->uiProgress >= (M4OSA_UInt32)(alphaBlendingStruct->\
-                    m_fadeInTime*10) && pProgress->uiProgress < 1000\
-                     - (M4OSA_UInt32)(alphaBlendingStruct->m_fadeOutTime*10))
-                    {
-                        alphaBlending = (M4OSA_Float)\
-                        ((M4OSA_Float)alphaBlendingStruct->m_middle/100);
-                    }
-                    else if(pProgress->uiProgress >= 1000 - (M4OSA_UInt32)\
-                    (alphaBlendingStruct->m_fadeOutTime*10))
-                    {
-                        if(alphaBlendingStruct->m_fadeOutTime == 0) {
-                            alphaBlending = alphaBlendingStruct->m_end / 100;
-                        } else {
-                            alphaBlending = ((M4OSA_Float)(alphaBlendingStruct->m_middle \
-                            - alphaBlendingStruct->m_end))*(1000 - pProgress->uiProgress)\
-                            /(alphaBlendingStruct->m_fadeOutTime*10);
-                            alphaBlending += alphaBlendingStruct->m_end;
-                            alphaBlending /= 100;
-                        }
-                    }
+                    break;
                 }
-                /**/
-
-                if((*(FramingRGB)==transparent1) && (*(FramingRGB+1)==transparent2))
+                if (u32_luma_col < u32_col_start)
                 {
-                    *( p_out0+y+x*PlaneOut[0].u_stride)=(*(p_in_Y+y+x*PlaneIn[0].u_stride));
-                    *( p_out1+(y>>1)+(x>>1)*PlaneOut[1].u_stride)=
-                        (*(p_in_U+(y>>1)+(x>>1)*PlaneIn[1].u_stride));
-                    *( p_out2+(y>>1)+(x>>1)*PlaneOut[2].u_stride)=
-                        (*(p_in_V+(y>>1)+(x>>1)*PlaneIn[2].u_stride));
+                    continue;
                 }
-                else
+                if((pu8_rgb[2*(u32_luma_col-topleft[0])]==transparent1) &&
+                   (pu8_rgb[2*(u32_luma_col-topleft[0])+1]==transparent2))
                 {
-                    *( p_out0+y+x*PlaneOut[0].u_stride)=
-                        (*(currentFraming->FramingYuv[0].pac_data+(y-topleft[0])\
-                            +(x-topleft[1])*currentFraming->FramingYuv[0].u_stride))*alphaBlending;
-                    *( p_out0+y+x*PlaneOut[0].u_stride)+=
-                        (*(p_in_Y+y+x*PlaneIn[0].u_stride))*(1-alphaBlending);
-                    *( p_out1+(y>>1)+(x>>1)*PlaneOut[1].u_stride)=
-                        (*(currentFraming->FramingYuv[1].pac_data+((y-topleft[0])>>1)\
-                            +((x-topleft[1])>>1)*currentFraming->FramingYuv[1].u_stride))\
-                                *alphaBlending;
-                    *( p_out1+(y>>1)+(x>>1)*PlaneOut[1].u_stride)+=
-                        (*(p_in_U+(y>>1)+(x>>1)*PlaneIn[1].u_stride))*(1-alphaBlending);
-                    *( p_out2+(y>>1)+(x>>1)*PlaneOut[2].u_stride)=
-                        (*(currentFraming->FramingYuv[2].pac_data+((y-topleft[0])>>1)\
-                            +((x-topleft[1])>>1)*currentFraming->FramingYuv[2].u_stride))\
-                                *alphaBlending;
-                    *( p_out2+(y>>1)+(x>>1)*PlaneOut[2].u_stride)+=
-                        (*(p_in_V+(y>>1)+(x>>1)*PlaneIn[2].u_stride))*(1-alphaBlending);
+                    continue;
                 }
-                if( PlaneIn[0].u_width < (topleft[0] + currentFraming->FramingYuv[0].u_width) &&
-                    y == PlaneIn[0].u_width-1)
+                if (alphaBlending == 1)
                 {
-                    FramingRGB = FramingRGB + 2 \
-                        * (topleft[0] + currentFraming->FramingYuv[0].u_width \
-                            - PlaneIn[0].u_width + 1);
+                    pu8_out[y] = pu8_framing[(u32_luma_col-topleft[0])>>1];
                 }
                 else
                 {
-                    FramingRGB = FramingRGB + 2;
+                    u8_value = pu8_framing[(u32_luma_col-topleft[0])>>1]*alphaBlending;
+                    u8_value += pu8_in[y]*(1-alphaBlending);
+                    pu8_out[y] = u8_value;
                 }
             }
-            /**
-             * Just copy input plane to output plane */
-            else
-            {
-                *( p_out0+y+x*PlaneOut[0].u_stride)=*(p_in_Y+y+x*PlaneIn[0].u_stride);
-                *( p_out1+(y>>1)+(x>>1)*PlaneOut[1].u_stride)=
-                    *(p_in_U+(y>>1)+(x>>1)*PlaneIn[1].u_stride);
-                *( p_out2+(y>>1)+(x>>1)*PlaneOut[2].u_stride)=
-                    *(p_in_V+(y>>1)+(x>>1)*PlaneIn[2].u_stride);
-            }
         }
     }
 
@@ -48,7 +48,12 @@ struct VideoEditorResampler : public AudioBufferProvider {
     M4OSA_Int32 outSamplingRate;
     M4OSA_Int32 inSamplingRate;
 
+    // Kept between calls and only grown, the resampler asks for a buffer
+    // and converts every few ms of audio
     int16_t *mTmpInBuffer;
+    size_t mTmpInBufferSize;
+    int32_t *mTmpOutBuffer;
+    size_t mTmpOutBufferSize;
 };
 
 #define MAX_SAMPLEDURATION_FOR_CONVERTION 40 //ms
@@ -56,7 +61,19 @@ struct VideoEditorResampler : public AudioBufferProvider {
 status_t VideoEditorResampler::getNextBuffer(AudioBufferProvider::Buffer *pBuffer, int64_t pts) {
 
     uint32_t dataSize = pBuffer->frameCount * this->nbChannels * sizeof(int16_t);
-    mTmpInBuffer = (int16_t*)malloc(dataSize);
+    if (dataSize > mTmpInBufferSize) {
+        free(mTmpInBuffer);
+        mTmpInBuffer = (int16_t*)malloc(dataSize);
+        if (mTmpInBuffer == NULL) {
+            mTmpInBufferSize = 0;
+            pBuffer->raw = NULL;
+            pBuffer->frameCount = 0;
+            return NO_MEMORY;
+        }
+        mTmpInBufferSize = dataSize;
+    }
+    // The resampler may keep the buffer across calls, so it gets a copy
+    // of mInput which is overwritten by the next conversion
     memcpy(mTmpInBuffer, this->mInput, dataSize);
     pBuffer->raw = (void*)mTmpInBuffer;
 
@@ -65,11 +82,8 @@ status_t VideoEditorResampler::getNextBuffer(AudioBufferProvider::Buffer *pBuffe
 
 void VideoEditorResampler::releaseBuffer(AudioBufferProvider::Buffer *pBuffer) {
 
-    if(pBuffer->raw != NULL) {
-        free(pBuffer->raw);
-        pBuffer->raw = NULL;
-        mTmpInBuffer = NULL;
-    }
+    // mTmpInBuffer is reused by the next getNextBuffer()
+    pBuffer->raw = NULL;
     pBuffer->frameCount = 0;
 }
 
@@ -90,6 +104,9 @@ M4OSA_Context  LVAudioResamplerCreate(M4OSA_Int32 bitDepth, M4OSA_Int32 inChanne
     context->outSamplingRate = sampleRate;
     context->mInput = NULL;
     context->mTmpInBuffer = NULL;
+    context->mTmpInBufferSize = 0;
+    context->mTmpOutBuffer = NULL;
+    context->mTmpOutBufferSize = 0;
 
     return ((M4OSA_Context )context);
 }
@@ -106,6 +123,7 @@ void LVAudiosetSampleRate(M4OSA_Context resamplerContext, M4OSA_Int32 inSampleRa
      */
     context->inSamplingRate = inSampleRate;
     // Allocate buffer for maximum allowed number of samples.
+    free(context->mInput);
     context->mInput = (int16_t*)malloc( (inSampleRate * MAX_SAMPLEDURATION_FOR_CONVERTION *
                                    context->nbChannels * sizeof(int16_t)) / 1000);
 }
@@ -127,6 +145,11 @@ void LVDestroy(M4OSA_Context resamplerContext) {
         context->mTmpInBuffer = NULL;
     }
 
+    if (context->mTmpOutBuffer != NULL) {
+        free(context->mTmpOutBuffer);
+        context->mTmpOutBuffer = NULL;
+    }
+
     if (context->mInput != NULL) {
         free(context->mInput);
         context->mInput = NULL;
@@ -148,7 +171,7 @@ void LVAudioresample_LowQuality(M4OSA_Int16* out, M4OSA_Int16* input,
 
     VideoEditorResampler *context =
       (VideoEditorResampler *)resamplerContext;
-    int32_t *pTmpBuffer = NULL;
+    size_t tmpBufferSize = outFrameCount * 2 * sizeof(int32_t);
 
     context->nbSamples = (context->inSamplingRate * outFrameCount) / context->outSamplingRate;
     memcpy(context->mInput,input,(context->nbSamples * context->nbChannels * sizeof(int16_t)));
@@ -156,15 +179,25 @@ void LVAudioresample_LowQuality(M4OSA_Int16* out, M4OSA_Int16* input,
     /*
      SRC module always gives stereo output, hence 2 for stereo audio
     */
-    pTmpBuffer = (int32_t*)malloc(outFrameCount * 2 * sizeof(int32_t));
-    memset(pTmpBuffer, 0x00, outFrameCount * 2 * sizeof(int32_t));
+    if (tmpBufferSize > context->mTmpOutBufferSize) {
+        free(context->mTmpOutBuffer);
+        context->mTmpOutBuffer = (int32_t*)malloc(tmpBufferSize);
+        if (context->mTmpOutBuffer == NULL) {
+            ALOGE("LVAudioresample_LowQuality: cannot allocate %d bytes",
+                (int)tmpBufferSize);
+            context->mTmpOutBufferSize = 0;
+            memset(out, 0x00, outFrameCount * 2 * sizeof(int16_t));
+            return;
+        }
+        context->mTmpOutBufferSize = tmpBufferSize;
+    }
+    // The resampler accumulates into the buffer
+    memset(context->mTmpOutBuffer, 0x00, tmpBufferSize);
 
-    context->mResampler->resample((int32_t *)pTmpBuffer,
+    context->mResampler->resample(context->mTmpOutBuffer,
        (size_t)outFrameCount, (VideoEditorResampler *)resamplerContext);
     // Convert back to 16 bits
-    ditherAndClamp((int32_t*)out, pTmpBuffer, outFrameCount);
-    free(pTmpBuffer);
-    pTmpBuffer = NULL;
+    ditherAndClamp((int32_t*)out, context->mTmpOutBuffer, outFrameCount);
 }
 
 }
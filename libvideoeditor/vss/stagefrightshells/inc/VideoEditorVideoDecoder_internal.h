@@ -33,6 +33,7 @@
 #include "M4TOOL_VersionInfo.h"
 #include "M4DECODER_Common.h"
 #include "M4OSA_Semaphore.h"
+#include "M4OSA_Mutex.h"
 #include "VideoEditorBuffer.h"
 #include "M4VD_Tools.h"
 #include "I420ColorConverter.h"
@@ -99,6 +100,9 @@ typedef struct {
     M4DECODER_VideoSize     m_VideoSize;
     M4DECODER_MPEG4_DecoderConfigInfo m_Dci; /**< Decoder Config info */
     VIDEOEDITOR_BUFFER_Pool *m_pDecBufferPool; /**< Decoded buffer pool */
+    M4OSA_Context           mPoolLock; /**< Protects the pool, the VSS may
+                                            decode ahead on another thread
+                                            while a frame is rendered */
     OMX_COLOR_FORMATTYPE    decOuputColorFormat;
 
     M4OSA_UInt32            mNbInputFrames;
@@ -910,6 +910,10 @@ M4OSA_ERR VideoEditorVideoDecoder_destroy(M4OSA_Context pContext) {
         VIDEOEDITOR_BUFFER_freePool(pDecShellContext->m_pDecBufferPool);
         pDecShellContext->m_pDecBufferPool = M4OSA_NULL;
     }
+    if( pDecShellContext->mPoolLock != M4OSA_NULL ) {
+        M4OSA_mutexClose(pDecShellContext->mPoolLock);
+        pDecShellContext->mPoolLock = M4OSA_NULL;
+    }
     SAFE_FREE(pDecShellContext);
     pContext = NULL;
 
@@ -953,6 +957,8 @@ M4OSA_ERR VideoEditorVideoDecoder_create(M4OSA_Context *pContext,
     pDecShellContext->m_pReader = pReaderDataInterface;
     pDecShellContext->m_lastDecodedCTS = -1;
     pDecShellContext->m_lastRenderCts = -1;
+    err = M4OSA_mutexOpen(&pDecShellContext->mPoolLock);
+    VIDEOEDITOR_CHECK(M4NO_ERROR == err, err);
     switch( pStreamHandler->m_streamType ) {
         case M4DA_StreamTypeVideoH263:
             pDecShellContext->mDecoderType = VIDEOEDITOR_kH263VideoDec;
@@ -1120,6 +1126,8 @@ M4OSA_ERR VideoEditorVideoSoftwareDecoder_create(M4OSA_Context *pContext,
     pDecShellContext->m_pReader = pReaderDataInterface;
     pDecShellContext->m_lastDecodedCTS = -1;
     pDecShellContext->m_lastRenderCts = -1;
+    err = M4OSA_mutexOpen(&pDecShellContext->mPoolLock);
+    VIDEOEDITOR_CHECK(M4NO_ERROR == err, err);
     switch( pStreamHandler->m_streamType ) {
         case M4DA_StreamTypeVideoH263:
             pDecShellContext->mDecoderType = VIDEOEDITOR_kH263VideoDec;
@@ -1398,9 +1406,12 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
             goto VIDEOEDITOR_VideoDecode_cleanUP;
         } else if (INFO_FORMAT_CHANGED == errStatus) {
             ALOGV("VideoDecoder_decode : source returns INFO_FORMAT_CHANGED");
+            // The pool is reallocated
+            M4OSA_mutexLock(pDecShellContext->mPoolLock, M4OSA_WAIT_FOREVER);
             lerr = VideoEditorVideoDecoder_configureFromMetadata(
                 pDecShellContext,
                 pDecShellContext->mVideoDecoder->getFormat().get());
+            M4OSA_mutexUnlock(pDecShellContext->mPoolLock);
             if( M4NO_ERROR != lerr ) {
                 ALOGV("!!! VideoEditorVideoDecoder_decode ERROR : "
                     "VideoDecoder_configureFromMetadata returns 0x%X", lerr);
@@ -1484,6 +1495,8 @@ static M4OSA_ERR copyBufferToQueue(
     M4OSA_ERR lerr = M4NO_ERROR;
     VIDEOEDITOR_BUFFER_Buffer* tmpDecBuffer;
 
+    M4OSA_mutexLock(pDecShellContext->mPoolLock, M4OSA_WAIT_FOREVER);
+
     // Get a buffer from the queue
     lerr = VIDEOEDITOR_BUFFER_getBuffer(pDecShellContext->m_pDecBufferPool,
         VIDEOEDITOR_BUFFER_kEmpty, &tmpDecBuffer);
@@ -1495,7 +1508,10 @@ static M4OSA_ERR copyBufferToQueue(
         lerr = M4NO_ERROR;
     }
 
-    if (lerr != M4NO_ERROR) return lerr;
+    if (lerr != M4NO_ERROR) {
+        M4OSA_mutexUnlock(pDecShellContext->mPoolLock);
+        return lerr;
+    }
 
     // Color convert or copy from the given MediaBuffer to our buffer
     if (pDecShellContext->mI420ColorConverter) {
@@ -1569,6 +1585,8 @@ static M4OSA_ERR copyBufferToQueue(
     tmpDecBuffer->state = VIDEOEDITOR_BUFFER_kFilled;
     tmpDecBuffer->size = pDecoderBuffer->size();
 
+    M4OSA_mutexUnlock(pDecShellContext->mPoolLock);
+
     return lerr;
 }
 
@@ -1585,6 +1603,7 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
                                                                   = M4OSA_NULL;
     M4_MediaTime candidateTimeStamp = -1;
     M4OSA_Bool bFound = M4OSA_FALSE;
+    M4OSA_Bool bLocked = M4OSA_FALSE;
 
     ALOGV("VideoEditorVideoDecoder_render begin");
     // Input parameters check
@@ -1592,6 +1611,10 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
     VIDEOEDITOR_CHECK(M4OSA_NULL != pTime, M4ERR_PARAMETER);
     VIDEOEDITOR_CHECK(M4OSA_NULL != pOutputPlane, M4ERR_PARAMETER);
 
+    // Hold the pool until the frame is copied, decode() may be filling it
+    M4OSA_mutexLock(pDecShellContext->mPoolLock, M4OSA_WAIT_FOREVER);
+    bLocked = M4OSA_TRUE;
+
     // The output buffer is already allocated, just copy the data
     if ( (*pTime <= pDecShellContext->m_lastRenderCts) &&
             (M4OSA_FALSE == bForceRender) ) {
@@ -1691,6 +1714,9 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
     pDecShellContext->mLastRenderedCts = *pTime;
 
 cleanUp:
+    if( bLocked ) {
+        M4OSA_mutexUnlock(pDecShellContext->mPoolLock);
+    }
     if( M4NO_ERROR == err ) {
         *pTime = pDecShellContext->m_lastRenderCts;
         ALOGV("VideoEditorVideoDecoder_render no error");
@@ -32,6 +32,8 @@ LOCAL_SRC_FILES:=          \
       M4VIFI_ResizeYUVtoBGR565.c \
       M4VIFI_RGB888toYUV420.c \
       M4VIFI_RGB565toYUV420.c \
+      M4VIFI_RowFilters.c \
+      M4PCM_Mix.c \
       M4VFL_transition.c
 
 LOCAL_MODULE_TAGS := optional
@@ -53,5 +55,14 @@ LOCAL_LDLIBS := \
 
 LOCAL_CFLAGS += -Wno-multichar
 
+# NEON and SSE2 row kernels, SSE2 is used when the CPU supports it
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+    LOCAL_ARM_NEON := true
+    LOCAL_CFLAGS += -DVIDEO_FILTERS_NEON
+endif
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DVIDEO_FILTERS_SSE2
+endif
+
 include $(BUILD_SHARED_LIBRARY)
 
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4PCM_Mix.c
+ * @brief       16 bits PCM mixing kernels
+ * @note        Every vector loop is followed by a scalar loop for the last
+ *              samples, both compute exactly the same values. A float is
+ *              converted to a sample by truncating it to 32 bits and keeping
+ *              the low 16 bits, which is what the (M4OSA_Int16) cast of the
+ *              scalar loops compiles to.
+ ******************************************************************************
+*/
+
+#include "M4OSA_Types.h"
+
+#include "M4PCM_Mix.h"
+#include "M4VIFI_RowFilters.h"
+
+#if defined(VIDEO_FILTERS_NEON)
+#include <arm_neon.h>
+#elif defined(VIDEO_FILTERS_SSE2)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Doubles the sum of the halves of both tracks back to the original level.
+ * Negative values are clamped to -32766 as the mixing always did */
+static M4OSA_Int16 M4PCM_doubleSample(M4OSA_Int16 i16_mix)
+{
+    M4OSA_Int32 i32_temp = i16_mix * 2;
+
+    if (i32_temp < -32766)
+    {
+        return -32766;
+    }
+    if (i32_temp > 32767)
+    {
+        return 32767;
+    }
+    return (M4OSA_Int16)i32_temp;
+}
+
+#if defined(VIDEO_FILTERS_NEON)
+/** Multiplies 8 samples by f32_vol */
+static int16x8_t M4PCM_scale8(int16x8_t samples, float32x4_t f32_vol)
+{
+    float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples)));
+    float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples)));
+
+    return vcombine_s16(vmovn_s32(vcvtq_s32_f32(vmulq_f32(lo, f32_vol))),
+                        vmovn_s32(vcvtq_s32_f32(vmulq_f32(hi, f32_vol))));
+}
+
+/** Halves 8 samples rounding towards zero, like the C division */
+static int16x8_t M4PCM_half8(int16x8_t samples)
+{
+    uint16x8_t sign = vshrq_n_u16(vreinterpretq_u16_s16(samples), 15);
+
+    return vshrq_n_s16(vaddq_s16(samples, vreinterpretq_s16_u16(sign)), 1);
+}
+#elif defined(VIDEO_FILTERS_SSE2)
+/** Converts 4 floats to samples, see the file note */
+static __m128i M4PCM_toSample4(__m128 f32_values)
+{
+    __m128i i32_values = _mm_cvttps_epi32(f32_values);
+
+    return _mm_srai_epi32(_mm_slli_epi32(i32_values, 16), 16);
+}
+
+/** Multiplies 8 samples by f32_vol */
+static __m128i M4PCM_scale8(__m128i samples, __m128 f32_vol)
+{
+    __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+    __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+
+    return _mm_packs_epi32(M4PCM_toSample4(_mm_mul_ps(lo, f32_vol)),
+                           M4PCM_toSample4(_mm_mul_ps(hi, f32_vol)));
+}
+
+/** Halves 8 samples rounding towards zero, like the C division */
+static __m128i M4PCM_half8(__m128i samples)
+{
+    return _mm_srai_epi16(_mm_add_epi16(samples, _mm_srli_epi16(samples, 15)), 1);
+}
+#endif
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4PCM_peak(const M4OSA_Int16 *pSamples, M4OSA_UInt32 uiNbSamples)
+ ******************************************************************************
+*/
+M4OSA_UInt32 M4PCM_peak(const M4OSA_Int16 *pSamples, M4OSA_UInt32 uiNbSamples)
+{
+    M4OSA_UInt32 i = 0;
+    M4OSA_Int32 i32_max = 0;
+    M4OSA_Int32 i32_min = 0;
+
+#if defined(VIDEO_FILTERS_NEON)
+    if (uiNbSamples >= 8)
+    {
+        int16x8_t max8 = vdupq_n_s16(0);
+        int16x8_t min8 = vdupq_n_s16(0);
+        int16x4_t max4, min4;
+
+        for (; i + 8 <= uiNbSamples; i += 8)
+        {
+            int16x8_t samples = vld1q_s16(pSamples + i);
+
+            max8 = vmaxq_s16(max8, samples);
+            min8 = vminq_s16(min8, samples);
+        }
+
+        max4 = vpmax_s16(vget_low_s16(max8), vget_high_s16(max8));
+        max4 = vpmax_s16(max4, max4);
+        max4 = vpmax_s16(max4, max4);
+        min4 = vpmin_s16(vget_low_s16(min8), vget_high_s16(min8));
+        min4 = vpmin_s16(min4, min4);
+        min4 = vpmin_s16(min4, min4);
+
+        i32_max = vget_lane_s16(max4, 0);
+        i32_min = vget_lane_s16(min4, 0);
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (uiNbSamples >= 8 && M4VIFI_cpuHasSSE2())
+    {
+        __m128i max8 = _mm_setzero_si128();
+        __m128i min8 = _mm_setzero_si128();
+
+        for (; i + 8 <= uiNbSamples; i += 8)
+        {
+            __m128i samples = _mm_loadu_si128((const __m128i *)(pSamples + i));
+
+            max8 = _mm_max_epi16(max8, samples);
+            min8 = _mm_min_epi16(min8, samples);
+        }
+
+        max8 = _mm_max_epi16(max8, _mm_srli_si128(max8, 8));
+        max8 = _mm_max_epi16(max8, _mm_srli_si128(max8, 4));
+        max8 = _mm_max_epi16(max8, _mm_srli_si128(max8, 2));
+        min8 = _mm_min_epi16(min8, _mm_srli_si128(min8, 8));
+        min8 = _mm_min_epi16(min8, _mm_srli_si128(min8, 4));
+        min8 = _mm_min_epi16(min8, _mm_srli_si128(min8, 2));
+
+        i32_max = (M4OSA_Int16)_mm_cvtsi128_si32(max8);
+        i32_min = (M4OSA_Int16)_mm_cvtsi128_si32(min8);
+    }
+#endif
+
+    for (; i < uiNbSamples; i++)
+    {
+        if (pSamples[i] > i32_max)
+        {
+            i32_max = pSamples[i];
+        }
+        else if (pSamples[i] < i32_min)
+        {
+            i32_min = pSamples[i];
+        }
+    }
+
+    return (M4OSA_UInt32)((-i32_min > i32_max) ? -i32_min : i32_max);
+}
+
+/**
+ ******************************************************************************
+ * void M4PCM_scale(M4OSA_Int16 *pOut, const M4OSA_Int16 *pIn,
+ *                  M4OSA_UInt32 uiNbSamples, M4OSA_Float fVolume)
+ ******************************************************************************
+*/
+void M4PCM_scale(M4OSA_Int16 *pOut, const M4OSA_Int16 *pIn,
+                 M4OSA_UInt32 uiNbSamples, M4OSA_Float fVolume)
+{
+    M4OSA_UInt32 i = 0;
+
+#if defined(VIDEO_FILTERS_NEON)
+    float32x4_t f32_vol = vdupq_n_f32(fVolume);
+
+    for (; i + 8 <= uiNbSamples; i += 8)
+    {
+        vst1q_s16(pOut + i, M4PCM_scale8(vld1q_s16(pIn + i), f32_vol));
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128 f32_vol = _mm_set1_ps(fVolume);
+
+        for (; i + 8 <= uiNbSamples; i += 8)
+        {
+            _mm_storeu_si128((__m128i *)(pOut + i),
+                M4PCM_scale8(_mm_loadu_si128((const __m128i *)(pIn + i)), f32_vol));
+        }
+    }
+#endif
+
+    for (; i < uiNbSamples; i++)
+    {
+        pOut[i] = (M4OSA_Int16)(pIn[i] * fVolume);
+    }
+}
+
+/**
+ ******************************************************************************
+ * void M4PCM_mixAndDuck(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+ *                       const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+ *                       M4OSA_Float fPTVolume, M4OSA_Float fBTVolume,
+ *                       M4OSA_Float fDuckingFactor)
+ ******************************************************************************
+*/
+void M4PCM_mixAndDuck(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+                      const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+                      M4OSA_Float fPTVolume, M4OSA_Float fBTVolume,
+                      M4OSA_Float fDuckingFactor)
+{
+    M4OSA_UInt32 i = 0;
+
+#if defined(VIDEO_FILTERS_NEON)
+    float32x4_t f32_pt_vol = vdupq_n_f32(fPTVolume);
+    float32x4_t f32_bt_vol = vdupq_n_f32(fBTVolume);
+    float32x4_t f32_ducking = vdupq_n_f32(fDuckingFactor);
+    int16x8_t floor8 = vdupq_n_s16(-32766);
+
+    for (; i + 8 <= uiNbSamples; i += 8)
+    {
+        int16x8_t pt = M4PCM_scale8(vld1q_s16(pPrimary + i), f32_pt_vol);
+        int16x8_t bt = M4PCM_scale8(vld1q_s16(pBackground + i), f32_bt_vol);
+        int16x8_t mix;
+
+        bt = M4PCM_scale8(bt, f32_ducking);
+        mix = vaddq_s16(M4PCM_half8(bt), M4PCM_half8(pt));
+        vst1q_s16(pOut + i, vmaxq_s16(vqaddq_s16(mix, mix), floor8));
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128 f32_pt_vol = _mm_set1_ps(fPTVolume);
+        __m128 f32_bt_vol = _mm_set1_ps(fBTVolume);
+        __m128 f32_ducking = _mm_set1_ps(fDuckingFactor);
+        __m128i floor8 = _mm_set1_epi16(-32766);
+
+        for (; i + 8 <= uiNbSamples; i += 8)
+        {
+            __m128i pt = M4PCM_scale8(_mm_loadu_si128((const __m128i *)(pPrimary + i)),
+                                      f32_pt_vol);
+            __m128i bt = M4PCM_scale8(_mm_loadu_si128((const __m128i *)(pBackground + i)),
+                                      f32_bt_vol);
+            __m128i mix;
+
+            bt = M4PCM_scale8(bt, f32_ducking);
+            mix = _mm_add_epi16(M4PCM_half8(bt), M4PCM_half8(pt));
+            _mm_storeu_si128((__m128i *)(pOut + i),
+                             _mm_max_epi16(_mm_adds_epi16(mix, mix), floor8));
+        }
+    }
+#endif
+
+    for (; i < uiNbSamples; i++)
+    {
+        M4OSA_Int16 i16_pt = (M4OSA_Int16)(pPrimary[i] * fPTVolume);
+        M4OSA_Int16 i16_bt = (M4OSA_Int16)(pBackground[i] * fBTVolume);
+
+        i16_bt = (M4OSA_Int16)(i16_bt * fDuckingFactor);
+        pOut[i] = M4PCM_doubleSample((M4OSA_Int16)(i16_bt / 2 + i16_pt / 2));
+    }
+}
+
+/**
+ ******************************************************************************
+ * void M4PCM_mixWeighted(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+ *                        const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+ *                        M4OSA_Float fPTFactor, M4OSA_Float fPTVolume,
+ *                        M4OSA_Float fBTFactor, M4OSA_Float fBTVolume)
+ ******************************************************************************
+*/
+void M4PCM_mixWeighted(M4OSA_Int16 *pOut, const M4OSA_Int16 *pPrimary,
+                       const M4OSA_Int16 *pBackground, M4OSA_UInt32 uiNbSamples,
+                       M4OSA_Float fPTFactor, M4OSA_Float fPTVolume,
+                       M4OSA_Float fBTFactor, M4OSA_Float fBTVolume)
+{
+    M4OSA_UInt32 i = 0;
+
+    /* The factors are applied one after the other, folding them into a
+     * single weight would round differently from the scalar loop */
+#if defined(VIDEO_FILTERS_NEON)
+    float32x4_t f32_pt_factor = vdupq_n_f32(fPTFactor);
+    float32x4_t f32_pt_vol = vdupq_n_f32(fPTVolume);
+    float32x4_t f32_bt_factor = vdupq_n_f32(fBTFactor);
+    float32x4_t f32_bt_vol = vdupq_n_f32(fBTVolume);
+
+    for (; i + 4 <= uiNbSamples; i += 4)
+    {
+        float32x4_t pt = vcvtq_f32_s32(vmovl_s16(vld1_s16(pPrimary + i)));
+        float32x4_t bt = vcvtq_f32_s32(vmovl_s16(vld1_s16(pBackground + i)));
+
+        pt = vmulq_f32(vmulq_f32(pt, f32_pt_factor), f32_pt_vol);
+        bt = vmulq_f32(vmulq_f32(bt, f32_bt_factor), f32_bt_vol);
+        vst1_s16(pOut + i, vmovn_s32(vcvtq_s32_f32(vaddq_f32(pt, bt))));
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128 f32_pt_factor = _mm_set1_ps(fPTFactor);
+        __m128 f32_pt_vol = _mm_set1_ps(fPTVolume);
+        __m128 f32_bt_factor = _mm_set1_ps(fBTFactor);
+        __m128 f32_bt_vol = _mm_set1_ps(fBTVolume);
+
+        for (; i + 8 <= uiNbSamples; i += 8)
+        {
+            __m128i pt = _mm_loadu_si128((const __m128i *)(pPrimary + i));
+            __m128i bt = _mm_loadu_si128((const __m128i *)(pBackground + i));
+            __m128 pt_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(pt, pt), 16));
+            __m128 pt_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(pt, pt), 16));
+            __m128 bt_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(bt, bt), 16));
+            __m128 bt_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(bt, bt), 16));
+
+            pt_lo = _mm_mul_ps(_mm_mul_ps(pt_lo, f32_pt_factor), f32_pt_vol);
+            pt_hi = _mm_mul_ps(_mm_mul_ps(pt_hi, f32_pt_factor), f32_pt_vol);
+            bt_lo = _mm_mul_ps(_mm_mul_ps(bt_lo, f32_bt_factor), f32_bt_vol);
+            bt_hi = _mm_mul_ps(_mm_mul_ps(bt_hi, f32_bt_factor), f32_bt_vol);
+
+            _mm_storeu_si128((__m128i *)(pOut + i),
+                _mm_packs_epi32(M4PCM_toSample4(_mm_add_ps(pt_lo, bt_lo)),
+                                M4PCM_toSample4(_mm_add_ps(pt_hi, bt_hi))));
+        }
+    }
+#endif
+
+    for (; i < uiNbSamples; i++)
+    {
+        pOut[i] = (M4OSA_Int16)(pPrimary[i] * fPTFactor * fPTVolume
+            + pBackground[i] * fBTFactor * fBTVolume);
+    }
+}
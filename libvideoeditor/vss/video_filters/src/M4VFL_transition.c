@@ -26,6 +26,8 @@
 
 #include "M4VFL_transition.h"
 
+#include "M4VIFI_RowFilters.h"
+
 #include <string.h>
 
 #ifdef LITTLE_ENDIAN
@@ -142,57 +144,50 @@ unsigned char M4VFL_modifyLumaWithScale(M4ViComImagePlane *plane_in,
     u_stride_out = plane_out[1].u_stride;
     p_cdest_line = (unsigned char *) &plane_out[1].pac_data[plane_out[1].u_topleft];
     p_csrc_line = (unsigned char *) &plane_in[1].pac_data[plane_in[1].u_topleft];
+    p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
+    p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
 
-    if (lum_factor > 256)
+    for (j = u_height; j != 0; j--)
     {
-        p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        /* copy chroma */
-        for (j = u_height; j != 0; j--)
+        if (lum_factor > 256)
         {
-            for (i = u_width; i != 0; i--)
-            {
-                memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
-                memcpy((void *)p_cdest,(void *) p_csrc, u_width);
-            }
-            p_cdest_line += u_stride_out;
-            p_cdest += u_stride_out;
-            p_csrc_line += u_stride;
-            p_csrc += u_stride;
+            /* copy chroma */
+            memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
+            memcpy((void *)p_cdest, (void *)p_csrc, u_width);
         }
-    }
-    else
-    {
-        /* filter chroma */
-        pix = (1024 - lum_factor) << 7;
-        for (j = u_height; j != 0; j--)
+        else
         {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc++ & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
+            /* filter chroma */
+            M4VIFI_ScaleChromaRow(p_cdest_line, p_csrc_line, u_width, lum_factor);
+            M4VIFI_ScaleChromaRow(p_cdest, p_csrc, u_width, lum_factor);
         }
-        p_cdest_line = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc_line = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
+        p_cdest_line += u_stride_out;
+        p_cdest += u_stride_out;
+        p_csrc_line += u_stride;
+        p_csrc += u_stride;
+    }
+
+    /* apply luma factor */
+    u_width = plane_in[0].u_width;
+    u_height = plane_in[0].u_height;
+
+    if (lum_factor <= (1 << LUM_FACTOR_MAX))
+    {
+        u_stride = plane_in[0].u_stride;
+        u_stride_out = plane_out[0].u_stride;
+        p_cdest_line = (unsigned char *) &plane_out[0].pac_data[plane_out[0].u_topleft];
+        p_csrc_line = (unsigned char *) &plane_in[0].pac_data[plane_in[0].u_topleft];
+
         for (j = u_height; j != 0; j--)
         {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
+            /* pixels are processed by pairs */
+            M4VIFI_ScaleLumaRow(p_cdest_line, p_csrc_line, u_width & ~1, lum_factor);
             p_cdest_line += u_stride_out;
             p_csrc_line += u_stride;
         }
+        return 0;
     }
-    /* apply luma factor */
-    u_width = plane_in[0].u_width;
-    u_height = plane_in[0].u_height;
+
     u_stride = (plane_in[0].u_stride >> 1);
     u_stride_out = (plane_out[0].u_stride >> 1);
     p_dest = (unsigned short *) &plane_out[0].pac_data[plane_out[0].u_topleft];
@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4VIFI_RowFilters.c
+ * @brief       Row kernels shared by the YUV420 resize, AIR and effect filters
+ * @note        Every vector loop is followed by a scalar loop for the last
+ *              pixels of the row, both compute exactly the same values.
+ ******************************************************************************
+*/
+
+#include "M4OSA_Types.h"
+
+#include "M4VIFI_RowFilters.h"
+
+#include <string.h>
+
+#if defined(VIDEO_FILTERS_NEON)
+#include <arm_neon.h>
+#elif defined(VIDEO_FILTERS_SSE2)
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <pthread.h>
+#endif
+
+/** Number of output pixels interpolated at once by M4VIFI_BilinearPlane */
+#define M4VIFI_ROW_STRIP    512
+
+#if defined(VIDEO_FILTERS_SSE2)
+static M4VIFI_UInt8 gCpuHasSSE2 = 0;
+static pthread_once_t gCpuFeaturesOnce = PTHREAD_ONCE_INIT;
+
+static void M4VIFI_detectCpuFeatures(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        gCpuHasSSE2 = (edx & bit_SSE2) != 0;
+    }
+}
+
+M4VIFI_UInt8 M4VIFI_cpuHasSSE2(void)
+{
+    pthread_once(&gCpuFeaturesOnce, M4VIFI_detectCpuFeatures);
+    return gCpuHasSSE2;
+}
+#endif /* VIDEO_FILTERS_SSE2 */
+
+/**
+ * Horizontal pass of the bilinear interpolation, the result is 16 times the
+ * interpolated value */
+static void M4VIFI_interpolateRow(M4VIFI_UInt16 *pu16_out, const M4VIFI_UInt8 *pu8_in,
+                                  M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_x_accum,
+                                  M4VIFI_UInt32 u32_x_inc)
+{
+    const M4VIFI_UInt8 *pu8_src;
+    M4VIFI_UInt32 u32_x_frac;
+
+    while (u32_width--)
+    {
+        pu8_src = pu8_in + (u32_x_accum >> 16);
+        u32_x_frac = (u32_x_accum >> 12) & 15;
+
+        *pu16_out++ = (M4VIFI_UInt16)(pu8_src[0] * (16 - u32_x_frac) +
+                                      pu8_src[1] * u32_x_frac);
+
+        u32_x_accum += u32_x_inc;
+    }
+}
+
+/**
+ * Vertical pass of the bilinear interpolation. top and bottom are at most
+ * 16 * 255, so the weighted sum fits in 16 bits */
+static void M4VIFI_blendRows(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt16 *pu16_top,
+                             const M4VIFI_UInt16 *pu16_bottom, M4VIFI_UInt32 u32_width,
+                             M4VIFI_UInt32 u32_y_frac)
+{
+    M4VIFI_UInt32 i = 0;
+    M4VIFI_UInt16 u16_top_weight = (M4VIFI_UInt16)(16 - u32_y_frac);
+    M4VIFI_UInt16 u16_bottom_weight = (M4VIFI_UInt16)u32_y_frac;
+
+#if defined(VIDEO_FILTERS_NEON)
+    for (; i + 16 <= u32_width; i += 16)
+    {
+        uint16x8_t sum0 = vmulq_n_u16(vld1q_u16(pu16_top + i), u16_top_weight);
+        uint16x8_t sum1 = vmulq_n_u16(vld1q_u16(pu16_top + i + 8), u16_top_weight);
+
+        sum0 = vmlaq_n_u16(sum0, vld1q_u16(pu16_bottom + i), u16_bottom_weight);
+        sum1 = vmlaq_n_u16(sum1, vld1q_u16(pu16_bottom + i + 8), u16_bottom_weight);
+
+        vst1q_u8(pu8_out + i, vcombine_u8(vshrn_n_u16(sum0, 8), vshrn_n_u16(sum1, 8)));
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128i top_weight = _mm_set1_epi16(u16_top_weight);
+        __m128i bottom_weight = _mm_set1_epi16(u16_bottom_weight);
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            __m128i sum0 = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(pu16_top + i)),
+                                top_weight),
+                _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(pu16_bottom + i)),
+                                bottom_weight));
+            __m128i sum1 = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(pu16_top + i + 8)),
+                                top_weight),
+                _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(pu16_bottom + i + 8)),
+                                bottom_weight));
+
+            _mm_storeu_si128((__m128i *)(pu8_out + i),
+                             _mm_packus_epi16(_mm_srli_epi16(sum0, 8),
+                                              _mm_srli_epi16(sum1, 8)));
+        }
+    }
+#endif
+
+    for (; i < u32_width; i++)
+    {
+        pu8_out[i] = (M4VIFI_UInt8)((pu16_top[i] * u16_top_weight +
+                                     pu16_bottom[i] * u16_bottom_weight) >> 8);
+    }
+}
+
+void M4VIFI_BilinearPlane(M4VIFI_UInt8 **ppu8_data_in, M4VIFI_Int32 i32_stride_in,
+                          M4VIFI_UInt8 *pu8_data_out, M4VIFI_UInt32 u32_stride_out,
+                          M4VIFI_UInt32 u32_width_out, M4VIFI_UInt32 u32_height_out,
+                          M4VIFI_UInt32 u32_x_accum_start, M4VIFI_UInt32 u32_x_inc,
+                          M4VIFI_UInt32 *pu32_y_accum, M4VIFI_UInt32 u32_y_inc)
+{
+    M4VIFI_UInt16 au16_rows[2][M4VIFI_ROW_STRIP];
+    const M4VIFI_UInt8 *apu8_cached[2];
+    M4VIFI_UInt8 *pu8_data_in = *ppu8_data_in;
+    M4VIFI_UInt8 *pu8_out;
+    M4VIFI_UInt8 *pu8_src_bottom;
+    M4VIFI_UInt32 u32_y_accum = *pu32_y_accum;
+    M4VIFI_UInt32 u32_y_frac, u32_x_accum;
+    M4VIFI_UInt32 u32_col = 0, u32_row, u32_width;
+    M4VIFI_UInt32 u32_top, u32_bottom;
+
+    /**
+     * Work on strips of columns so that the row cache fits on the stack. The
+     * rows are scanned once per strip, the accumulators left after the last
+     * strip are returned */
+    do
+    {
+        u32_width = u32_width_out - u32_col;
+        if (u32_width > M4VIFI_ROW_STRIP)
+        {
+            u32_width = M4VIFI_ROW_STRIP;
+        }
+
+        u32_x_accum = u32_x_accum_start + u32_col * u32_x_inc;
+
+        pu8_data_in = *ppu8_data_in;
+        u32_y_accum = *pu32_y_accum;
+        pu8_out = pu8_data_out + u32_col;
+        apu8_cached[0] = M4OSA_NULL;
+        apu8_cached[1] = M4OSA_NULL;
+
+        for (u32_row = 0; u32_row < u32_height_out; u32_row++)
+        {
+            /* Vertical weight factor */
+            u32_y_frac = (u32_y_accum >> 12) & 15;
+            pu8_src_bottom = pu8_data_in + i32_stride_in;
+
+            /* Interpolate the top row unless it is cached, keeping the bottom one */
+            if (apu8_cached[0] == pu8_data_in)
+            {
+                u32_top = 0;
+            }
+            else if (apu8_cached[1] == pu8_data_in)
+            {
+                u32_top = 1;
+            }
+            else
+            {
+                u32_top = (apu8_cached[0] == pu8_src_bottom) ? 1 : 0;
+                M4VIFI_interpolateRow(au16_rows[u32_top], pu8_data_in, u32_width,
+                                      u32_x_accum, u32_x_inc);
+                apu8_cached[u32_top] = pu8_data_in;
+            }
+
+            /* The bottom row has no weight when the fraction is 0 */
+            if (0 == u32_y_frac)
+            {
+                u32_bottom = u32_top;
+            }
+            else
+            {
+                u32_bottom = 1 - u32_top;
+                if (apu8_cached[u32_bottom] != pu8_src_bottom)
+                {
+                    M4VIFI_interpolateRow(au16_rows[u32_bottom], pu8_src_bottom, u32_width,
+                                          u32_x_accum, u32_x_inc);
+                    apu8_cached[u32_bottom] = pu8_src_bottom;
+                }
+            }
+
+            M4VIFI_blendRows(pu8_out, au16_rows[u32_top], au16_rows[u32_bottom],
+                             u32_width, u32_y_frac);
+
+            pu8_out += u32_stride_out;
+
+            /* Update vertical accumulator */
+            u32_y_accum += u32_y_inc;
+            if (u32_y_accum >> 16)
+            {
+                pu8_data_in += (M4VIFI_Int32)(u32_y_accum >> 16) * i32_stride_in;
+                u32_y_accum &= 0xffff;
+            }
+        }
+
+        u32_col += u32_width;
+    } while (u32_col < u32_width_out);
+
+    *ppu8_data_in = pu8_data_in;
+    *pu32_y_accum = u32_y_accum;
+}
+
+void M4VIFI_ScaleLumaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                         M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor)
+{
+    M4VIFI_UInt32 i = 0;
+
+    if (u32_lum_factor >= 1024)
+    {
+        if (pu8_out != pu8_in)
+        {
+            memcpy((void *)pu8_out, (void *)pu8_in, u32_width);
+        }
+        return;
+    }
+
+    /**
+     * (x * lum_factor) >> 10 is the high half of x * (lum_factor << 6) */
+#if defined(VIDEO_FILTERS_NEON)
+    {
+        /* vqdmulh doubles the product */
+        int16_t i16_factor = (int16_t)(u32_lum_factor << 5);
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            uint8x16_t in = vld1q_u8(pu8_in + i);
+            int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(in)));
+            int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(in)));
+
+            lo = vqdmulhq_n_s16(lo, i16_factor);
+            hi = vqdmulhq_n_s16(hi, i16_factor);
+
+            vst1q_u8(pu8_out + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+        }
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128i factor = _mm_set1_epi16((short)(u32_lum_factor << 6));
+        __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i *)(pu8_in + i));
+            __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(in, zero), factor);
+            __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(in, zero), factor);
+
+            _mm_storeu_si128((__m128i *)(pu8_out + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+
+    for (; i < u32_width; i++)
+    {
+        pu8_out[i] = (M4VIFI_UInt8)((pu8_in[i] * u32_lum_factor) >> 10);
+    }
+}
+
+void M4VIFI_ScaleChromaRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                           M4VIFI_UInt32 u32_width, M4VIFI_UInt32 u32_lum_factor)
+{
+    M4VIFI_UInt32 i = 0;
+    M4VIFI_UInt32 u32_offset = (1024 - u32_lum_factor) << 7;
+
+    /**
+     * The result is 128 + (((x - 128) * lum_factor) >> 10), with an arithmetic
+     * shift, which is the high half of (x - 128) * (lum_factor << 6) */
+#if defined(VIDEO_FILTERS_NEON)
+    {
+        int16_t i16_factor = (int16_t)(u32_lum_factor << 5);
+        int16x8_t center = vdupq_n_s16(128);
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            uint8x16_t in = vld1q_u8(pu8_in + i);
+            int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(in)));
+            int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(in)));
+
+            lo = vaddq_s16(vqdmulhq_n_s16(vsubq_s16(lo, center), i16_factor), center);
+            hi = vaddq_s16(vqdmulhq_n_s16(vsubq_s16(hi, center), i16_factor), center);
+
+            vst1q_u8(pu8_out + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+        }
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128i factor = _mm_set1_epi16((short)(u32_lum_factor << 6));
+        __m128i center = _mm_set1_epi16(128);
+        __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i *)(pu8_in + i));
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(in, zero), center);
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(in, zero), center);
+
+            lo = _mm_add_epi16(_mm_mulhi_epi16(lo, factor), center);
+            hi = _mm_add_epi16(_mm_mulhi_epi16(hi, factor), center);
+
+            _mm_storeu_si128((__m128i *)(pu8_out + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+
+    for (; i < u32_width; i++)
+    {
+        pu8_out[i] = (M4VIFI_UInt8)((u32_offset + pu8_in[i] * u32_lum_factor) >> 10);
+    }
+}
+
+void M4VIFI_InvertRow(M4VIFI_UInt8 *pu8_out, const M4VIFI_UInt8 *pu8_in,
+                      M4VIFI_UInt32 u32_width)
+{
+    M4VIFI_UInt32 i = 0;
+
+#if defined(VIDEO_FILTERS_NEON)
+    for (; i + 16 <= u32_width; i += 16)
+    {
+        vst1q_u8(pu8_out + i, vmvnq_u8(vld1q_u8(pu8_in + i)));
+    }
+#elif defined(VIDEO_FILTERS_SSE2)
+    if (M4VIFI_cpuHasSSE2())
+    {
+        __m128i ones = _mm_set1_epi8((char)0xff);
+
+        for (; i + 16 <= u32_width; i += 16)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i *)(pu8_in + i));
+            _mm_storeu_si128((__m128i *)(pu8_out + i), _mm_xor_si128(in, ones));
+        }
+    }
+#endif
+
+    for (; i < u32_width; i++)
+    {
+        pu8_out[i] = 255 - pu8_in[i];
+    }
+}
@@ -0,0 +1,46 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ================================================================
+# Compares the M4VIFI row kernels with the scalar loops they replaced
+# ================================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := M4VIFI_RowFilters_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := M4VIFI_RowFilters_test.cpp
+
+LOCAL_C_INCLUDES := \
+    $(TOP)/frameworks/av/libvideoeditor/osal/inc \
+    $(TOP)/frameworks/av/libvideoeditor/vss/common/inc
+
+LOCAL_SHARED_LIBRARIES := \
+    libvideoeditor_videofilters
+
+include $(BUILD_NATIVE_TEST)
+
+# ================================================================
+# The same check on the host, built with the SSE2 kernels on x86
+# ================================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := M4VIFI_RowFilters_host_test
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := \
+    M4VIFI_RowFilters_test.cpp \
+    ../src/M4VIFI_RowFilters.c
+
+LOCAL_C_INCLUDES := \
+    $(TOP)/frameworks/av/libvideoeditor/osal/inc \
+    $(TOP)/frameworks/av/libvideoeditor/vss/common/inc
+
+ifeq ($(HOST_ARCH),x86)
+    LOCAL_CFLAGS += -DVIDEO_FILTERS_SSE2
+endif
+
+LOCAL_LDLIBS := -lpthread
+
+include $(BUILD_HOST_NATIVE_TEST)
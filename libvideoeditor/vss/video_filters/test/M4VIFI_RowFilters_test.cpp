@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "M4OSA_Types.h"
+#include "M4VIFI_RowFilters.h"
+
+// Compares the row kernels, whichever of the NEON, SSE2 or scalar versions
+// is built, with the scalar loops they replaced.
+
+namespace {
+
+// Lengths around the 16 pixel vector loops and above the bilinear strip.
+static const M4VIFI_UInt32 kWidths[] = { 1, 2, 15, 16, 17, 33, 176, 1100 };
+
+static void randomize(M4VIFI_UInt8 *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = rand();
+    }
+}
+
+// The per pixel loop of the previous M4VIFI_ResizeBilinearYUV420toYUV420.
+static void referenceBilinear(const M4VIFI_UInt8 *in, M4VIFI_Int32 strideIn,
+        M4VIFI_UInt8 *out, M4VIFI_UInt32 strideOut,
+        M4VIFI_UInt32 widthOut, M4VIFI_UInt32 heightOut,
+        M4VIFI_UInt32 xAccumStart, M4VIFI_UInt32 xInc,
+        M4VIFI_UInt32 yAccum, M4VIFI_UInt32 yInc) {
+    for (M4VIFI_UInt32 y = 0; y < heightOut; ++y) {
+        M4VIFI_UInt32 yFrac = (yAccum >> 12) & 15;
+        M4VIFI_UInt32 xAccum = xAccumStart;
+
+        for (M4VIFI_UInt32 x = 0; x < widthOut; ++x) {
+            const M4VIFI_UInt8 *top = in + (xAccum >> 16);
+            const M4VIFI_UInt8 *bottom = top + strideIn;
+            M4VIFI_UInt32 xFrac = (xAccum >> 12) & 15;
+
+            out[x] = (M4VIFI_UInt8)(((top[0] * (16 - xFrac)
+                    + top[1] * xFrac) * (16 - yFrac)
+                    + (bottom[0] * (16 - xFrac)
+                    + bottom[1] * xFrac) * yFrac) >> 8);
+
+            xAccum += xInc;
+        }
+        out += strideOut;
+
+        yAccum += yInc;
+        if (yAccum >> 16) {
+            in += (M4VIFI_Int32)(yAccum >> 16) * strideIn;
+            yAccum &= 0xffff;
+        }
+    }
+}
+
+struct BilinearCase {
+    M4VIFI_UInt32 widthIn;
+    M4VIFI_UInt32 heightIn;
+    M4VIFI_UInt32 widthOut;
+    M4VIFI_UInt32 heightOut;
+};
+
+static const BilinearCase kBilinearCases[] = {
+    { 176, 144, 352, 288 },
+    { 352, 288, 176, 144 },
+    { 320, 240, 321, 239 },
+    { 1280, 720, 1920, 1080 },
+    { 1920, 1080, 1280, 720 },
+    { 17, 5, 33, 9 },
+};
+
+// Runs the kernel, split in two calls of heightOut / 3 and the remaining
+// rows when split is true, as M4AIR_get does with stripes.
+static void checkBilinear(const BilinearCase &c, bool flipped, bool split) {
+    // The input planes have a spare row and column, the reference reads the
+    // bottom and right neighbours even when their weight is 0.
+    M4VIFI_Int32 stride = c.widthIn + 1;
+    size_t size = stride * (c.heightIn + 1);
+    M4VIFI_UInt8 *in = new M4VIFI_UInt8[size];
+    randomize(in, size);
+
+    M4VIFI_UInt8 *expected = new M4VIFI_UInt8[c.widthOut * c.heightOut];
+    M4VIFI_UInt8 *out = new M4VIFI_UInt8[c.widthOut * c.heightOut];
+    memset(out, 0, c.widthOut * c.heightOut);
+
+    // Steps of the previous resize, the accumulators start at 0.
+    M4VIFI_UInt32 xInc = ((c.widthIn - 1) << 16) / c.widthOut;
+    M4VIFI_UInt32 yInc = ((c.heightIn - 1) << 16) / c.heightOut;
+
+    const M4VIFI_UInt8 *first = in;
+    M4VIFI_Int32 strideIn = stride;
+    if (flipped) {
+        first = in + stride * (c.heightIn - 1) + stride;
+        strideIn = -stride;
+    }
+
+    referenceBilinear(first, strideIn, expected, c.widthOut,
+            c.widthOut, c.heightOut, 0, xInc, 0, yInc);
+
+    M4VIFI_UInt8 *dataIn = (M4VIFI_UInt8 *)first;
+    M4VIFI_UInt32 yAccum = 0;
+    M4VIFI_UInt32 rows = split ? c.heightOut / 3 : c.heightOut;
+    M4VIFI_BilinearPlane(&dataIn, strideIn, out, c.widthOut,
+            c.widthOut, rows, 0, xInc, &yAccum, yInc);
+    if (rows < c.heightOut) {
+        M4VIFI_BilinearPlane(&dataIn, strideIn, out + rows * c.widthOut,
+                c.widthOut, c.widthOut, c.heightOut - rows, 0, xInc,
+                &yAccum, yInc);
+    }
+
+    for (M4VIFI_UInt32 y = 0; y < c.heightOut; ++y) {
+        for (M4VIFI_UInt32 x = 0; x < c.widthOut; ++x) {
+            ASSERT_EQ(expected[y * c.widthOut + x], out[y * c.widthOut + x])
+                << c.widthIn << "x" << c.heightIn << " to "
+                << c.widthOut << "x" << c.heightOut
+                << " at " << x << ", " << y;
+        }
+    }
+
+    delete[] out;
+    delete[] expected;
+    delete[] in;
+}
+
+}  // namespace
+
+TEST(M4VIFIRowFiltersTest, BilinearPlaneMatchesPerPixelLoop) {
+    for (size_t i = 0; i < sizeof(kBilinearCases) / sizeof(kBilinearCases[0]);
+            ++i) {
+        checkBilinear(kBilinearCases[i], false, false);
+        checkBilinear(kBilinearCases[i], true, false);
+        checkBilinear(kBilinearCases[i], false, true);
+    }
+}
+
+TEST(M4VIFIRowFiltersTest, ScaleLumaRowMatchesScalarLoop) {
+    static const M4VIFI_UInt32 kFactors[] = { 0, 1, 255, 512, 1000, 1023, 1024 };
+
+    for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); ++w) {
+        M4VIFI_UInt32 width = kWidths[w];
+        M4VIFI_UInt8 *in = new M4VIFI_UInt8[width];
+        M4VIFI_UInt8 *out = new M4VIFI_UInt8[width];
+
+        for (size_t f = 0; f < sizeof(kFactors) / sizeof(kFactors[0]); ++f) {
+            randomize(in, width);
+            M4VIFI_ScaleLumaRow(out, in, width, kFactors[f]);
+            for (M4VIFI_UInt32 i = 0; i < width; ++i) {
+                ASSERT_EQ((in[i] * kFactors[f]) >> 10, out[i])
+                    << "factor " << kFactors[f] << " at " << i;
+            }
+
+            // In place.
+            memcpy(out, in, width);
+            M4VIFI_ScaleLumaRow(out, out, width, kFactors[f]);
+            for (M4VIFI_UInt32 i = 0; i < width; ++i) {
+                ASSERT_EQ((in[i] * kFactors[f]) >> 10, out[i])
+                    << "factor " << kFactors[f] << " at " << i;
+            }
+        }
+
+        delete[] out;
+        delete[] in;
+    }
+}
+
+TEST(M4VIFIRowFiltersTest, ScaleChromaRowMatchesScalarLoop) {
+    static const M4VIFI_UInt32 kFactors[] = { 0, 1, 100, 128, 255, 256 };
+
+    for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); ++w) {
+        M4VIFI_UInt32 width = kWidths[w];
+        M4VIFI_UInt8 *in = new M4VIFI_UInt8[width];
+        M4VIFI_UInt8 *out = new M4VIFI_UInt8[width];
+
+        for (size_t f = 0; f < sizeof(kFactors) / sizeof(kFactors[0]); ++f) {
+            M4VIFI_UInt32 factor = kFactors[f];
+            M4VIFI_UInt32 offset = (1024 - factor) << 7;
+
+            randomize(in, width);
+            M4VIFI_ScaleChromaRow(out, in, width, factor);
+            for (M4VIFI_UInt32 i = 0; i < width; ++i) {
+                ASSERT_EQ((offset + in[i] * factor) >> 10, out[i])
+                    << "factor " << factor << " at " << i;
+            }
+
+            // In place.
+            memcpy(out, in, width);
+            M4VIFI_ScaleChromaRow(out, out, width, factor);
+            for (M4VIFI_UInt32 i = 0; i < width; ++i) {
+                ASSERT_EQ((offset + in[i] * factor) >> 10, out[i])
+                    << "factor " << factor << " at " << i;
+            }
+        }
+
+        delete[] out;
+        delete[] in;
+    }
+}
+
+TEST(M4VIFIRowFiltersTest, InvertRowMatchesScalarLoop) {
+    for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); ++w) {
+        M4VIFI_UInt32 width = kWidths[w];
+        M4VIFI_UInt8 *in = new M4VIFI_UInt8[width];
+        M4VIFI_UInt8 *out = new M4VIFI_UInt8[width];
+
+        randomize(in, width);
+        M4VIFI_InvertRow(out, in, width);
+        for (M4VIFI_UInt32 i = 0; i < width; ++i) {
+            ASSERT_EQ(255 - in[i], out[i]) << "at " << i;
+        }
+
+        M4VIFI_InvertRow(out, out, width);
+        ASSERT_EQ(0, memcmp(in, out, width));
+
+        delete[] out;
+        delete[] in;
+    }
+}
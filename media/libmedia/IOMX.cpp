@@ -49,6 +49,7 @@ enum {
     GET_EXTENSION_INDEX,
     OBSERVER_ON_MSG,
     GET_GRAPHIC_BUFFER_USAGE,
+    OBSERVER_ON_MSGS,
 };
 
 class BpOMX : public BpInterface<IOMX> {
@@ -760,10 +761,25 @@ public:
 
         remote()->transact(OBSERVER_ON_MSG, data, &reply, IBinder::FLAG_ONEWAY);
     }
+
+    virtual void onMessages(const Vector<omx_message> &messages) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IOMXObserver::getInterfaceDescriptor());
+        data.writeInt32(messages.size());
+        data.write(messages.array(), messages.size() * sizeof(omx_message));
+
+        remote()->transact(OBSERVER_ON_MSGS, data, &reply, IBinder::FLAG_ONEWAY);
+    }
 };
 
 IMPLEMENT_META_INTERFACE(OMXObserver, "android.hardware.IOMXObserver");
 
+void IOMXObserver::onMessages(const Vector<omx_message> &messages) {
+    for (size_t i = 0; i < messages.size(); ++i) {
+        onMessage(messages.itemAt(i));
+    }
+}
+
 status_t BnOMXObserver::onTransact(
     uint32_t code, const Parcel &data, Parcel *reply, uint32_t flags) {
     switch (code) {
@@ -780,6 +796,24 @@ status_t BnOMXObserver::onTransact(
             return NO_ERROR;
         }
 
+        case OBSERVER_ON_MSGS:
+        {
+            CHECK_INTERFACE(IOMXObserver, data, reply);
+
+            int32_t count = data.readInt32();
+            if (count < 0 || (size_t)count > data.dataAvail() / sizeof(omx_message)) {
+                return BAD_VALUE;
+            }
+
+            Vector<omx_message> messages;
+            messages.insertAt(0, count);
+            data.read(messages.editArray(), count * sizeof(omx_message));
+
+            onMessages(messages);
+
+            return NO_ERROR;
+        }
+
         default:
             return BBinder::onTransact(code, data, reply, flags);
     }
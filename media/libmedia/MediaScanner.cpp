@@ -78,6 +78,18 @@ void MediaScanner::loadSkipList() {
     }
 }
 
+MediaScanResult MediaScanner::processFiles(
+        const char *const *paths, size_t numPaths,
+        MediaScannerClient &client) {
+    for (size_t i = 0; i < numPaths; ++i) {
+        MediaScanResult result = processFile(paths[i], NULL, client);
+        if (result == MEDIA_SCAN_RESULT_ERROR) {
+            return result;
+        }
+    }
+    return MEDIA_SCAN_RESULT_OK;
+}
+
 MediaScanResult MediaScanner::processDirectory(
         const char *path, MediaScannerClient &client) {
     int pathLength = strlen(path);
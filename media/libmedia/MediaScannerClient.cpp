@@ -197,6 +197,11 @@ void MediaScannerClient::convertValues(uint32_t encoding)
     }
 }
 
+status_t MediaScannerClient::handleThumbnail(const VideoFrame* frame)
+{
+    return OK;
+}
+
 void MediaScannerClient::endFile()
 {
     if (mLocaleEncoding != kEncodingNone) {
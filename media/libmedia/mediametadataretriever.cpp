@@ -135,6 +135,20 @@ sp<IMemory> MediaMetadataRetriever::getFrameAtTime(int64_t timeUs, int option)
     return mRetriever->getFrameAtTime(timeUs, option);
 }
 
+sp<IMemory> MediaMetadataRetriever::getScaledFrameAtTime(
+        int64_t timeUs, int option, int32_t maxWidth, int32_t maxHeight)
+{
+    ALOGV("getScaledFrameAtTime: time(%lld us) option(%d) max %dx%d",
+            timeUs, option, maxWidth, maxHeight);
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return NULL;
+    }
+    return mRetriever->getScaledFrameAtTime(
+            timeUs, option, maxWidth, maxHeight);
+}
+
 const char* MediaMetadataRetriever::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata(%d)", keyCode);
@@ -33,6 +33,7 @@
 #include <binder/IServiceManager.h>
 #include <media/MediaMetadataRetrieverInterface.h>
 #include <media/MediaPlayerInterface.h>
+#include <media/stagefright/FrameScaler.h>
 #include <private/media/VideoFrame.h>
 #include "MidiMetadataRetriever.h"
 #include "MetadataRetrieverClient.h"
@@ -41,6 +42,67 @@
 
 namespace android {
 
+// Scales down an RGB565 frame that does not fit within maxWidth x maxHeight,
+// as returned by the retrievers that cannot scale frames themselves.
+static VideoFrame *fitFrame(
+        VideoFrame *frame, int32_t maxWidth, int32_t maxHeight)
+{
+    if (frame == NULL || (maxWidth <= 0 && maxHeight <= 0)) {
+        return frame;
+    }
+
+    int32_t width, height;
+    FrameScaler::ComputeScaledSize(
+            frame->mDisplayWidth, frame->mDisplayHeight,
+            maxWidth, maxHeight, frame->mRotationAngle, &width, &height);
+
+    if ((uint32_t)width == frame->mWidth
+            && (uint32_t)height == frame->mHeight) {
+        return frame;
+    }
+
+    // The scaler filters RGBA pixels.
+    size_t numPixels = frame->mWidth * frame->mHeight;
+    uint8_t *rgba = new uint8_t[numPixels * 4];
+    const uint16_t *src = (const uint16_t *)frame->mData;
+    for (size_t i = 0; i < numPixels; ++i) {
+        uint32_t r = (src[i] >> 11) & 0x1f;
+        uint32_t g = (src[i] >> 5) & 0x3f;
+        uint32_t b = src[i] & 0x1f;
+        rgba[4 * i] = (r << 3) | (r >> 2);
+        rgba[4 * i + 1] = (g << 2) | (g >> 4);
+        rgba[4 * i + 2] = (b << 3) | (b >> 2);
+        rgba[4 * i + 3] = 0xff;
+    }
+
+    VideoFrame *scaled = new VideoFrame;
+    scaled->mWidth = width;
+    scaled->mHeight = height;
+    scaled->mDisplayWidth = width;
+    scaled->mDisplayHeight = height;
+    scaled->mSize = width * height * 2;
+    scaled->mData = new uint8_t[scaled->mSize];
+    scaled->mRotationAngle = frame->mRotationAngle;
+
+    FrameScaler scaler(
+            FrameScaler::FILTER_LANCZOS3, OMX_COLOR_Format16bitRGB565);
+    status_t err = scaler.scale(
+            rgba, frame->mWidth, frame->mHeight, frame->mWidth * 4,
+            scaled->mData, width, height, width * 2);
+
+    delete[] rgba;
+
+    if (err != OK) {
+        ALOGW("failed to scale a %ux%u frame, returning it unscaled",
+                frame->mWidth, frame->mHeight);
+        delete scaled;
+        return frame;
+    }
+
+    delete frame;
+    return scaled;
+}
+
 MetadataRetrieverClient::MetadataRetrieverClient(pid_t pid)
 {
     ALOGV("MetadataRetrieverClient constructor pid(%d)", pid);
@@ -184,7 +246,28 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtTime(int64_t timeUs, int option)
         ALOGE("retriever is not initialized");
         return NULL;
     }
-    VideoFrame *frame = mRetriever->getFrameAtTime(timeUs, option);
+    return setThumbnail_l(mRetriever->getFrameAtTime(timeUs, option));
+}
+
+sp<IMemory> MetadataRetrieverClient::getScaledFrameAtTime(
+        int64_t timeUs, int option, int32_t maxWidth, int32_t maxHeight)
+{
+    ALOGV("getScaledFrameAtTime: time(%lld us) option(%d) max %dx%d",
+            timeUs, option, maxWidth, maxHeight);
+    Mutex::Autolock lock(mLock);
+    mThumbnail.clear();
+    if (mRetriever == NULL) {
+        ALOGE("retriever is not initialized");
+        return NULL;
+    }
+    return setThumbnail_l(fitFrame(
+                mRetriever->getScaledFrameAtTime(
+                    timeUs, option, maxWidth, maxHeight),
+                maxWidth, maxHeight));
+}
+
+sp<IMemory> MetadataRetrieverClient::setThumbnail_l(VideoFrame *frame)
+{
     if (frame == NULL) {
         ALOGE("failed to capture a video frame");
         return NULL;
@@ -37,6 +37,7 @@
 #include <OMX_Component.h>
 
 #include "include/avc_utils.h"
+#include "include/RateControlLookahead.h"
 
 namespace android {
 
@@ -49,6 +50,19 @@ static void InitOMXParams(T *params) {
     params->nVersion.s.nStep = 0;
 }
 
+// The messages of one batch delivered by IOMXObserver::onMessages.
+struct OMXMessageList : public RefBase {
+    OMXMessageList() {}
+
+    List<sp<AMessage> > mMessages;
+
+protected:
+    virtual ~OMXMessageList() {}
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(OMXMessageList);
+};
+
 struct CodecObserver : public BnOMXObserver {
     CodecObserver() {}
 
@@ -58,6 +72,29 @@ struct CodecObserver : public BnOMXObserver {
 
     // from IOMXObserver
     virtual void onMessage(const omx_message &omx_msg) {
+        makeMessage(omx_msg)->post();
+    }
+
+    // Posts a single message carrying the whole batch, which ACodec then
+    // handles one by one, so that the codec's looper is woken up only once.
+    virtual void onMessages(const Vector<omx_message> &messages) {
+        sp<OMXMessageList> list = new OMXMessageList;
+        for (size_t i = 0; i < messages.size(); ++i) {
+            list->mMessages.push_back(makeMessage(messages.itemAt(i)));
+        }
+
+        sp<AMessage> msg = mNotify->dup();
+        msg->setObject("messages", list);
+        msg->post();
+    }
+
+protected:
+    virtual ~CodecObserver() {}
+
+private:
+    sp<AMessage> mNotify;
+
+    sp<AMessage> makeMessage(const omx_message &omx_msg) {
         sp<AMessage> msg = mNotify->dup();
 
         msg->setInt32("type", omx_msg.type);
@@ -108,15 +145,9 @@ struct CodecObserver : public BnOMXObserver {
                 break;
         }
 
-        msg->post();
+        return msg;
     }
 
-protected:
-    virtual ~CodecObserver() {}
-
-private:
-    sp<AMessage> mNotify;
-
     DISALLOW_EVIL_CONSTRUCTORS(CodecObserver);
 };
 
@@ -342,7 +373,10 @@ ACodec::ACodec()
       mEncoderDelay(0),
       mEncoderPadding(0),
       mChannelMaskPresent(false),
-      mChannelMask(0) {
+      mChannelMask(0),
+      mStateName(NULL),
+      mStateWaitsForComponent(false),
+      mStateEnteredTimeUs(0ll) {
     mUninitializedState = new UninitializedState(this);
     mLoadedState = new LoadedState(this);
     mLoadedToIdleState = new LoadedToIdleState(this);
@@ -1976,7 +2010,65 @@ status_t ACodec::setupAVCEncoderParameters(const sp<AMessage> &msg) {
         return err;
     }
 
-    return configureBitrate(bitrate, bitrateMode);
+    err = configureBitrate(bitrate, bitrateMode);
+
+    if (err != OK) {
+        return err;
+    }
+
+    return setupRateControlLookahead(msg);
+}
+
+status_t ACodec::setupRateControlLookahead(const sp<AMessage> &msg) {
+    int32_t lookaheadFrames;
+    if (!msg->findInt32("rc-lookahead", &lookaheadFrames)) {
+        return OK;
+    }
+
+    int32_t vbvSizeMs;
+    if (!msg->findInt32("vbv-size-ms", &vbvSizeMs)) {
+        vbvSizeMs = 0;
+    }
+
+    int32_t adaptiveQuant;
+    if (!msg->findInt32("adaptive-quant", &adaptiveQuant)) {
+        adaptiveQuant = 0;
+    }
+
+    if (lookaheadFrames < 0 || vbvSizeMs < 0) {
+        return BAD_VALUE;
+    }
+
+    OMX_INDEXTYPE index;
+    status_t err = mOMX->getExtensionIndex(
+            mNode,
+            "OMX.google.android.index.rateControlLookahead",
+            &index);
+
+    if (err != OK) {
+        // Optional feature, the encoder keeps its own rate control.
+        ALOGW("[%s] does not support rate control lookahead",
+              mComponentName.c_str());
+
+        return OK;
+    }
+
+    RateControlLookaheadParams params;
+    InitOMXParams(&params);
+    params.nPortIndex = kPortIndexOutput;
+    params.bEnable = OMX_TRUE;
+    params.nLookaheadFrames = lookaheadFrames;
+    params.nVBVSizeMs = vbvSizeMs;
+    params.bAdaptiveQuantization = adaptiveQuant ? OMX_TRUE : OMX_FALSE;
+
+    err = mOMX->setParameter(mNode, index, &params, sizeof(params));
+
+    if (err != OK) {
+        ALOGE("[%s] could not configure rate control lookahead of %d frames "
+              "(err %d)", mComponentName.c_str(), lookaheadFrames, err);
+    }
+
+    return err;
 }
 
 status_t ACodec::verifySupportForProfileAndLevel(
@@ -2152,6 +2244,24 @@ bool ACodec::allYourBuffersAreBelongToUs() {
         && allYourBuffersAreBelongToUs(kPortIndexOutput);
 }
 
+void ACodec::noteStateEntered(const char *stateName, bool waitsForComponent) {
+    int64_t nowUs = ALooper::GetNowUs();
+
+    if (mStateName != NULL && mStateWaitsForComponent) {
+        ALOGI("[%s] %s -> %s after %lld us",
+             mComponentName.c_str(), mStateName, stateName,
+             (long long)(nowUs - mStateEnteredTimeUs));
+    } else if (mStateName != NULL) {
+        ALOGV("[%s] %s -> %s after %lld us",
+             mComponentName.c_str(), mStateName, stateName,
+             (long long)(nowUs - mStateEnteredTimeUs));
+    }
+
+    mStateName = stateName;
+    mStateWaitsForComponent = waitsForComponent;
+    mStateEnteredTimeUs = nowUs;
+}
+
 void ACodec::deferMessage(const sp<AMessage> &msg) {
     bool wasEmptyBefore = mDeferredQueue.empty();
     mDeferredQueue.push_back(msg);
@@ -2494,6 +2604,19 @@ bool ACodec::BaseState::onMessageReceived(const sp<AMessage> &msg) {
 
         case ACodec::kWhatOMXMessage:
         {
+            sp<RefBase> obj;
+            if (msg->findObject("messages", &obj)) {
+                // Each message goes through the state machine on its own,
+                // as it may change the state for the ones that follow.
+                sp<OMXMessageList> list = static_cast<OMXMessageList *>(obj.get());
+
+                List<sp<AMessage> >::iterator it = list->mMessages.begin();
+                while (it != list->mMessages.end()) {
+                    mCodec->onMessageReceived(*it++);
+                }
+                break;
+            }
+
             return onOMXMessage(msg);
         }
 
@@ -3076,6 +3199,8 @@ ACodec::UninitializedState::UninitializedState(ACodec *codec)
 }
 
 void ACodec::UninitializedState::stateEntered() {
+    mCodec->noteStateEntered("Uninitialized", false /* waitsForComponent */);
+
     ALOGV("Now uninitialized");
 }
 
@@ -3250,8 +3375,17 @@ ACodec::LoadedState::LoadedState(ACodec *codec)
 }
 
 void ACodec::LoadedState::stateEntered() {
+    mCodec->noteStateEntered("Loaded", false /* waitsForComponent */);
+
     ALOGV("[%s] Now Loaded", mCodec->mComponentName.c_str());
 
+    // A component kept allocated across a stop is started again from
+    // here, it must not remember the EOS of the previous session.
+    mCodec->mPortEOS[kPortIndexInput] =
+        mCodec->mPortEOS[kPortIndexOutput] = false;
+
+    mCodec->mInputEOSResult = OK;
+
     if (mCodec->mShutdownInProgress) {
         bool keepComponentAllocated = mCodec->mKeepComponentAllocated;
 
@@ -3389,6 +3523,8 @@ ACodec::LoadedToIdleState::LoadedToIdleState(ACodec *codec)
 }
 
 void ACodec::LoadedToIdleState::stateEntered() {
+    mCodec->noteStateEntered("Loaded->Idle", true /* waitsForComponent */);
+
     ALOGV("[%s] Now Loaded->Idle", mCodec->mComponentName.c_str());
 
     status_t err;
@@ -3460,6 +3596,8 @@ ACodec::IdleToExecutingState::IdleToExecutingState(ACodec *codec)
 }
 
 void ACodec::IdleToExecutingState::stateEntered() {
+    mCodec->noteStateEntered("Idle->Executing", true /* waitsForComponent */);
+
     ALOGV("[%s] Now Idle->Executing", mCodec->mComponentName.c_str());
 }
 
@@ -3556,6 +3694,8 @@ void ACodec::ExecutingState::resume() {
 }
 
 void ACodec::ExecutingState::stateEntered() {
+    mCodec->noteStateEntered("Executing", false /* waitsForComponent */);
+
     ALOGV("[%s] Now Executing", mCodec->mComponentName.c_str());
 
     mCodec->processDeferredMessages();
@@ -3716,6 +3856,9 @@ bool ACodec::OutputPortSettingsChangedState::onMessageReceived(
 }
 
 void ACodec::OutputPortSettingsChangedState::stateEntered() {
+    mCodec->noteStateEntered(
+            "OutputPortSettingsChanged", true /* waitsForComponent */);
+
     ALOGV("[%s] Now handling output port settings change",
          mCodec->mComponentName.c_str());
 }
@@ -3819,6 +3962,8 @@ bool ACodec::ExecutingToIdleState::onMessageReceived(const sp<AMessage> &msg) {
 }
 
 void ACodec::ExecutingToIdleState::stateEntered() {
+    mCodec->noteStateEntered("Executing->Idle", true /* waitsForComponent */);
+
     ALOGV("[%s] Now Executing->Idle", mCodec->mComponentName.c_str());
 
     mComponentNowIdle = false;
@@ -3922,6 +4067,8 @@ bool ACodec::IdleToLoadedState::onMessageReceived(const sp<AMessage> &msg) {
 }
 
 void ACodec::IdleToLoadedState::stateEntered() {
+    mCodec->noteStateEntered("Idle->Loaded", true /* waitsForComponent */);
+
     ALOGV("[%s] Now Idle->Loaded", mCodec->mComponentName.c_str());
 }
 
@@ -3950,6 +4097,8 @@ ACodec::FlushingState::FlushingState(ACodec *codec)
 }
 
 void ACodec::FlushingState::stateEntered() {
+    mCodec->noteStateEntered("Flushing", true /* waitsForComponent */);
+
     ALOGV("[%s] Now Flushing", mCodec->mComponentName.c_str());
 
     mFlushComplete[kPortIndexInput] = mFlushComplete[kPortIndexOutput] = false;
@@ -19,6 +19,7 @@ LOCAL_SRC_FILES:=                         \
         AudioSource.cpp                   \
         AVIExtractor.cpp                  \
         AwesomePlayer.cpp                 \
+        BatchMetadataRetriever.cpp        \
         CameraSource.cpp                  \
         CameraSourceTimeLapse.cpp         \
         DataSource.cpp                    \
@@ -37,6 +38,7 @@ LOCAL_SRC_FILES:=                         \
         MediaBufferGroup.cpp              \
         MediaCodec.cpp                    \
         MediaCodecList.cpp                \
+        MediaCodecPool.cpp                \
         MediaDefs.cpp                     \
         MediaExtractor.cpp                \
         MediaSource.cpp                   \
@@ -3445,6 +3445,24 @@ bool AwesomePlayer::isStreamingHTTP() const {
     return mCachedSource != NULL || mWVMExtractor != NULL;
 }
 
+static void dumpLatencyStats(
+        FILE *out, const char *name,
+        const TimedEventQueue::LatencyStats &stats) {
+    fprintf(out, "  %s: fired(%lld)", name, stats.mNumFired);
+
+    if (stats.mNumFired > 0) {
+        fprintf(out,
+                ", latency avg(%lld us), min(%lld us), max(%lld us), "
+                "late(%lld)",
+                stats.mTotalLatencyUs / stats.mNumFired,
+                stats.mMinLatencyUs,
+                stats.mMaxLatencyUs,
+                stats.mNumLate);
+    }
+
+    fprintf(out, "\n");
+}
+
 status_t AwesomePlayer::dump(int fd, const Vector<String16> &args) const {
     Mutex::Autolock autoLock(mStatsLock);
 
@@ -3489,6 +3507,15 @@ status_t AwesomePlayer::dump(int fd, const Vector<String16> &args) const {
         }
     }
 
+    // How late (or early) queued events fired relative to their scheduled
+    // time, the video event's numbers reflect frame scheduling jitter.
+    TimedEventQueue::LatencyStats latencyStats;
+    mQueue.getLatencyStats(mVideoEvent, &latencyStats);
+    dumpLatencyStats(out, "videoEvent", latencyStats);
+
+    mQueue.getLatencyStats(&latencyStats);
+    dumpLatencyStats(out, "allEvents", latencyStats);
+
     fclose(out);
     out = NULL;
 
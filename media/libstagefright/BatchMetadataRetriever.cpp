@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "BatchMetadataRetriever"
+#include <utils/Log.h>
+
+#include <media/stagefright/BatchMetadataRetriever.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <media/mediametadataretriever.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/MediaSource.h>
+
+namespace android {
+
+// Every worker keeps a media server binder thread busy, leave some of them
+// to other clients.
+static const size_t kMaxWorkers = 8;
+
+static const int kMetadataKeys[] = {
+    METADATA_KEY_CD_TRACK_NUMBER,
+    METADATA_KEY_ALBUM,
+    METADATA_KEY_ARTIST,
+    METADATA_KEY_AUTHOR,
+    METADATA_KEY_COMPOSER,
+    METADATA_KEY_DATE,
+    METADATA_KEY_GENRE,
+    METADATA_KEY_TITLE,
+    METADATA_KEY_YEAR,
+    METADATA_KEY_DURATION,
+    METADATA_KEY_NUM_TRACKS,
+    METADATA_KEY_WRITER,
+    METADATA_KEY_MIMETYPE,
+    METADATA_KEY_ALBUMARTIST,
+    METADATA_KEY_DISC_NUMBER,
+    METADATA_KEY_COMPILATION,
+    METADATA_KEY_HAS_AUDIO,
+    METADATA_KEY_HAS_VIDEO,
+    METADATA_KEY_VIDEO_WIDTH,
+    METADATA_KEY_VIDEO_HEIGHT,
+    METADATA_KEY_BITRATE,
+    METADATA_KEY_TIMED_TEXT_LANGUAGES,
+    METADATA_KEY_IS_DRM,
+    METADATA_KEY_LOCATION,
+    METADATA_KEY_VIDEO_ROTATION,
+};
+
+BatchMetadataRetriever::Options::Options()
+    : mNumWorkers(0),
+      mMaxPendingResults(0),
+      mMaxThumbnailSize(0),
+      mExtractAlbumArt(false) {
+}
+
+BatchMetadataRetriever::Result::Result()
+    : mStatus(OK),
+      mOpenTimeUs(0),
+      mMetadataTimeUs(0),
+      mThumbnailTimeUs(0),
+      mAlbumArtTimeUs(0) {
+}
+
+BatchMetadataRetriever::Result::~Result() {
+}
+
+const char *BatchMetadataRetriever::Result::getMetadata(int key) const {
+    ssize_t index = mMetadata.indexOfKey(key);
+    return index < 0 ? NULL : mMetadata.valueAt(index).c_str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct BatchMetadataRetriever::Worker : public Thread {
+    Worker(BatchMetadataRetriever *owner)
+        : Thread(false /* canCallJava */),
+          mOwner(owner) {
+    }
+
+protected:
+    virtual bool threadLoop() {
+        size_t index;
+        AString path;
+        if (!mOwner->dequeueFile(&index, &path)) {
+            return false;
+        }
+
+        if (mRetriever == NULL) {
+            mRetriever = new MediaMetadataRetriever;
+        }
+
+        mOwner->addResult(
+                index, Retrieve(mRetriever, path.c_str(), mOwner->mOptions));
+
+        return true;
+    }
+
+private:
+    BatchMetadataRetriever *mOwner;
+    sp<MediaMetadataRetriever> mRetriever;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Worker);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BatchMetadataRetriever::BatchMetadataRetriever(const Options &options)
+    : mOptions(options),
+      mNextFile(0),
+      mNextResult(0),
+      mStarted(false),
+      mStopping(false),
+      mStartTimeUs(0),
+      mTotalOpenTimeUs(0),
+      mTotalMetadataTimeUs(0),
+      mTotalThumbnailTimeUs(0),
+      mNumFailed(0) {
+    if (mOptions.mNumWorkers == 0) {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        mOptions.mNumWorkers = numCpus > 0 ? numCpus : 1;
+    }
+    if (mOptions.mNumWorkers > kMaxWorkers) {
+        mOptions.mNumWorkers = kMaxWorkers;
+    }
+    if (mOptions.mMaxPendingResults == 0) {
+        mOptions.mMaxPendingResults = 4 * mOptions.mNumWorkers;
+    } else if (mOptions.mMaxPendingResults < mOptions.mNumWorkers) {
+        mOptions.mMaxPendingResults = mOptions.mNumWorkers;
+    }
+}
+
+BatchMetadataRetriever::~BatchMetadataRetriever() {
+    stop();
+}
+
+void BatchMetadataRetriever::addFile(const char *path) {
+    Mutex::Autolock autoLock(mLock);
+    CHECK(!mStarted);
+
+    mPaths.push(AString(path));
+    mResults.push(sp<Result>());
+}
+
+void BatchMetadataRetriever::start() {
+    size_t numWorkers;
+    {
+        Mutex::Autolock autoLock(mLock);
+        CHECK(!mStarted);
+        mStarted = true;
+        mStartTimeUs = ALooper::GetNowUs();
+
+        numWorkers = mPaths.size() < mOptions.mNumWorkers
+            ? mPaths.size() : mOptions.mNumWorkers;
+    }
+
+    ALOGV("retrieving %d files on %d workers", mPaths.size(), numWorkers);
+
+    status_t err = OK;
+    for (size_t i = 0; i < numWorkers; ++i) {
+        sp<Worker> worker = new Worker(this);
+        err = worker->run("MetadataWorker");
+        if (err != OK) {
+            ALOGE("unable to start a metadata worker (%d)", err);
+            continue;
+        }
+        mWorkers.push(worker);
+    }
+
+    if (numWorkers == 0 || !mWorkers.isEmpty()) {
+        return;
+    }
+
+    // Nobody would ever retrieve the files, dequeueResult() would block.
+    Mutex::Autolock autoLock(mLock);
+    while (mNextFile < mPaths.size()) {
+        sp<Result> result = new Result;
+        result->mPath = mPaths.itemAt(mNextFile);
+        result->mStatus = err;
+
+        mResults.editItemAt(mNextFile++) = result;
+        ++mNumFailed;
+    }
+    mCondition.broadcast();
+}
+
+sp<BatchMetadataRetriever::Result> BatchMetadataRetriever::dequeueResult() {
+    Mutex::Autolock autoLock(mLock);
+    CHECK(mStarted);
+
+    if (mNextResult == mPaths.size()) {
+        return NULL;
+    }
+
+    while (!mStopping && mResults.itemAt(mNextResult) == NULL) {
+        mCondition.wait(mLock);
+    }
+
+    if (mStopping) {
+        return NULL;
+    }
+
+    sp<Result> result = mResults.itemAt(mNextResult);
+    mResults.editItemAt(mNextResult).clear();
+    ++mNextResult;
+
+    // A worker may be waiting for the window of pending results to move.
+    mCondition.broadcast();
+
+    if (mNextResult == mPaths.size()) {
+        int64_t elapsedUs = ALooper::GetNowUs() - mStartTimeUs;
+
+        ALOGI("retrieved %d files (%d failed) in %lld ms on %d workers, "
+              "open %lld ms, metadata %lld ms, thumbnails %lld ms",
+              mPaths.size(), mNumFailed, elapsedUs / 1000,
+              mWorkers.size(), mTotalOpenTimeUs / 1000,
+              mTotalMetadataTimeUs / 1000, mTotalThumbnailTimeUs / 1000);
+    }
+
+    return result;
+}
+
+void BatchMetadataRetriever::stop() {
+    {
+        Mutex::Autolock autoLock(mLock);
+        mStopping = true;
+        mCondition.broadcast();
+    }
+
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        mWorkers.editItemAt(i)->requestExitAndWait();
+    }
+    mWorkers.clear();
+}
+
+bool BatchMetadataRetriever::dequeueFile(size_t *index, AString *path) {
+    Mutex::Autolock autoLock(mLock);
+
+    while (!mStopping && mNextFile < mPaths.size()
+            && mNextFile >= mNextResult + mOptions.mMaxPendingResults) {
+        mCondition.wait(mLock);
+    }
+
+    if (mStopping || mNextFile == mPaths.size()) {
+        return false;
+    }
+
+    *index = mNextFile++;
+    *path = mPaths.itemAt(*index);
+
+    return true;
+}
+
+void BatchMetadataRetriever::addResult(
+        size_t index, const sp<Result> &result) {
+    ALOGV("%s: status %d, open %lld us, metadata %lld us, thumbnail %lld us",
+          result->mPath.c_str(), result->mStatus, result->mOpenTimeUs,
+          result->mMetadataTimeUs, result->mThumbnailTimeUs);
+
+    Mutex::Autolock autoLock(mLock);
+
+    mTotalOpenTimeUs += result->mOpenTimeUs;
+    mTotalMetadataTimeUs += result->mMetadataTimeUs;
+    mTotalThumbnailTimeUs += result->mThumbnailTimeUs;
+    if (result->mStatus != OK) {
+        ++mNumFailed;
+    }
+
+    mResults.editItemAt(index) = result;
+    mCondition.broadcast();
+}
+
+// static
+sp<BatchMetadataRetriever::Result> BatchMetadataRetriever::Retrieve(
+        const sp<MediaMetadataRetriever> &retriever,
+        const char *path, const Options &options) {
+    sp<Result> result = new Result;
+    result->mPath = path;
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    int fd = open(path, O_RDONLY | O_LARGEFILE);
+    if (fd < 0) {
+        // couldn't open it locally, maybe the media server can?
+        result->mStatus = retriever->setDataSource(path);
+    } else {
+        result->mStatus = retriever->setDataSource(fd, 0, 0x7ffffffffffffffL);
+        close(fd);
+        fd = -1;
+    }
+
+    int64_t nowUs = ALooper::GetNowUs();
+    result->mOpenTimeUs = nowUs - startUs;
+    startUs = nowUs;
+
+    if (result->mStatus != OK) {
+        return result;
+    }
+
+    const int *keys = kMetadataKeys;
+    size_t numKeys = sizeof(kMetadataKeys) / sizeof(kMetadataKeys[0]);
+    if (!options.mMetadataKeys.isEmpty()) {
+        keys = options.mMetadataKeys.array();
+        numKeys = options.mMetadataKeys.size();
+    }
+
+    // Whether to extract a thumbnail depends on METADATA_KEY_HAS_VIDEO.
+    bool haveHasVideo = options.mMaxThumbnailSize <= 0;
+    for (size_t i = 0; i < numKeys || !haveHasVideo; ++i) {
+        int key = (i < numKeys) ? keys[i] : METADATA_KEY_HAS_VIDEO;
+        if (key == METADATA_KEY_HAS_VIDEO) {
+            haveHasVideo = true;
+        }
+
+        const char *value = retriever->extractMetadata(key);
+        if (value != NULL) {
+            result->mMetadata.add(key, AString(value));
+        }
+    }
+
+    nowUs = ALooper::GetNowUs();
+    result->mMetadataTimeUs = nowUs - startUs;
+    startUs = nowUs;
+
+    const char *hasVideo = result->getMetadata(METADATA_KEY_HAS_VIDEO);
+    if (options.mMaxThumbnailSize > 0
+            && hasVideo != NULL && !strcmp(hasVideo, "yes")) {
+        result->mThumbnail = retriever->getScaledFrameAtTime(
+                -1, MediaSource::ReadOptions::SEEK_CLOSEST_SYNC,
+                options.mMaxThumbnailSize, options.mMaxThumbnailSize);
+
+        nowUs = ALooper::GetNowUs();
+        result->mThumbnailTimeUs = nowUs - startUs;
+        startUs = nowUs;
+    }
+
+    if (options.mExtractAlbumArt) {
+        result->mAlbumArt = retriever->extractAlbumArt();
+
+        nowUs = ALooper::GetNowUs();
+        result->mAlbumArtTimeUs = nowUs - startUs;
+    }
+
+    return result;
+}
+
+}  // namespace android
@@ -35,6 +35,7 @@ MediaBuffer::MediaBuffer(void *data, size_t size)
     : mObserver(NULL),
       mNextBuffer(NULL),
       mRefCount(0),
+      mInUse(false),
       mData(data),
       mSize(size),
       mRangeOffset(0),
@@ -48,6 +49,7 @@ MediaBuffer::MediaBuffer(size_t size)
     : mObserver(NULL),
       mNextBuffer(NULL),
       mRefCount(0),
+      mInUse(false),
       mData(malloc(size)),
       mSize(size),
       mRangeOffset(0),
@@ -61,6 +63,7 @@ MediaBuffer::MediaBuffer(const sp<GraphicBuffer>& graphicBuffer)
     : mObserver(NULL),
       mNextBuffer(NULL),
       mRefCount(0),
+      mInUse(false),
       mData(NULL),
       mSize(1),
       mRangeOffset(0),
@@ -75,6 +78,7 @@ MediaBuffer::MediaBuffer(const sp<ABuffer> &buffer)
     : mObserver(NULL),
       mNextBuffer(NULL),
       mRefCount(0),
+      mInUse(false),
       mData(buffer->data()),
       mSize(buffer->size()),
       mRangeOffset(0),
@@ -18,6 +18,7 @@
 #include <utils/Log.h>
 
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaBufferGroup.h>
 
@@ -25,10 +26,17 @@ namespace android {
 
 MediaBufferGroup::MediaBufferGroup()
     : mFirstBuffer(NULL),
-      mLastBuffer(NULL) {
+      mLastBuffer(NULL),
+      mNumBuffers(0),
+      mNumInUse(0) {
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
+    ALOGV("%lld buffers acquired, %lld waits (%lld us total, %lld us max), "
+          "at most %d of %d buffers in use",
+          mStats.mNumAcquired, mStats.mNumWaits, mStats.mTotalWaitUs,
+          mStats.mMaxWaitUs, (int)mStats.mHighWatermark, (int)mNumBuffers);
+
     MediaBuffer *next;
     for (MediaBuffer *buffer = mFirstBuffer; buffer != NULL;
          buffer = next) {
@@ -53,33 +61,107 @@ void MediaBufferGroup::add_buffer(MediaBuffer *buffer) {
     }
 
     mLastBuffer = buffer;
+    ++mNumBuffers;
+
+    if (buffer->refcount() == 0) {
+        mFreeBuffers.push(buffer);
+    } else {
+        // Comes back through signalBufferReturned like an acquired one.
+        buffer->mInUse = true;
+        ++mNumInUse;
+    }
 }
 
-status_t MediaBufferGroup::acquire_buffer(MediaBuffer **out) {
+MediaBuffer *MediaBufferGroup::acquireFreeBuffer_l() {
+    while (!mFreeBuffers.isEmpty()) {
+        MediaBuffer *buffer = mFreeBuffers.top();
+        mFreeBuffers.pop();
+
+        if (buffer->refcount() == 0) {
+            return buffer;
+        }
+    }
+
+    // Buffers may also become free without being returned through
+    // signalBufferReturned (see MediaBuffer::claim), fall back to looking
+    // at all of them. Such a buffer is still counted as in use, and stays
+    // counted once it is handed out again.
+    for (MediaBuffer *buffer = mFirstBuffer;
+         buffer != NULL; buffer = buffer->nextBuffer()) {
+        if (buffer->refcount() == 0) {
+            return buffer;
+        }
+    }
+
+    return NULL;
+}
+
+status_t MediaBufferGroup::acquire_buffer(
+        MediaBuffer **out, bool nonBlocking) {
     Mutex::Autolock autoLock(mLock);
 
-    for (;;) {
-        for (MediaBuffer *buffer = mFirstBuffer;
-             buffer != NULL; buffer = buffer->nextBuffer()) {
-            if (buffer->refcount() == 0) {
-                buffer->add_ref();
-                buffer->reset();
+    MediaBuffer *buffer = acquireFreeBuffer_l();
 
-                *out = buffer;
-                goto exit;
-            }
+    if (buffer == NULL) {
+        if (nonBlocking) {
+            *out = NULL;
+            return WOULD_BLOCK;
         }
 
+        int64_t startUs = ALooper::GetNowUs();
+
         // All buffers are in use. Block until one of them is returned to us.
-        mCondition.wait(mLock);
+        do {
+            mCondition.wait(mLock);
+        } while ((buffer = acquireFreeBuffer_l()) == NULL);
+
+        int64_t waitUs = ALooper::GetNowUs() - startUs;
+
+        ++mStats.mNumWaits;
+        mStats.mTotalWaitUs += waitUs;
+        if (waitUs > mStats.mMaxWaitUs) {
+            mStats.mMaxWaitUs = waitUs;
+        }
+    }
+
+    buffer->add_ref();
+    buffer->reset();
+
+    ++mStats.mNumAcquired;
+
+    if (!buffer->mInUse) {
+        buffer->mInUse = true;
+        ++mNumInUse;
+    }
+    CHECK_LE(mNumInUse, mNumBuffers);
+
+    if (mNumInUse > mStats.mHighWatermark) {
+        mStats.mHighWatermark = mNumInUse;
     }
 
-exit:
+    *out = buffer;
+
     return OK;
 }
 
-void MediaBufferGroup::signalBufferReturned(MediaBuffer *) {
+void MediaBufferGroup::getStats(Stats *stats) {
+    Mutex::Autolock autoLock(mLock);
+    *stats = mStats;
+}
+
+void MediaBufferGroup::signalBufferReturned(MediaBuffer *buffer) {
     Mutex::Autolock autoLock(mLock);
+
+    // A buffer that was never handed out, e.g. one added with a zero
+    // refcount and referenced by its owner, is returned without having
+    // been counted.
+    if (buffer->mInUse) {
+        CHECK_GT(mNumInUse, 0u);
+        buffer->mInUse = false;
+        --mNumInUse;
+    }
+
+    mFreeBuffers.push(buffer);
     mCondition.signal();
 }
 
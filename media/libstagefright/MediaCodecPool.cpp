@@ -0,0 +1,232 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MediaCodecPool"
+#include <utils/Log.h>
+
+#include <media/stagefright/MediaCodecPool.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/MediaCodec.h>
+
+namespace android {
+
+static pthread_once_t gCodecPoolOnce = PTHREAD_ONCE_INIT;
+
+// Components that return to the state they were allocated in when they are
+// stopped. Others keep decoder state or the EOS and error flags of their
+// last stream, see SimpleSoftOMXComponent::onReset().
+static const char *kReusableComponents[] = {
+    "OMX.google.h264.decoder",
+    "OMX.google.h264.encoder",
+    "OMX.google.aac.encoder",
+};
+
+static bool isReusable(const AString &componentName) {
+    for (size_t i = 0;
+         i < sizeof(kReusableComponents) / sizeof(kReusableComponents[0]);
+         ++i) {
+        if (!strcmp(componentName.c_str(), kReusableComponents[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// static
+MediaCodecPool *MediaCodecPool::gCodecPool;
+
+// static
+void MediaCodecPool::Init() {
+    // Deliberately never destroyed, codecs need to be released rather than
+    // just destructed.
+    gCodecPool = new MediaCodecPool;
+}
+
+// static
+MediaCodecPool *MediaCodecPool::Get() {
+    pthread_once(&gCodecPoolOnce, Init);
+    return gCodecPool;
+}
+
+// static
+sp<MediaCodec> MediaCodecPool::CreateByType(
+        const sp<ALooper> &looper, const char *mime, bool encoder) {
+    Key key;
+    key.mLooper = looper;
+    key.mName = mime;
+    key.mNameIsType = true;
+    key.mEncoder = encoder;
+
+    return Get()->acquire(key);
+}
+
+// static
+sp<MediaCodec> MediaCodecPool::CreateByComponentName(
+        const sp<ALooper> &looper, const char *name) {
+    Key key;
+    key.mLooper = looper;
+    key.mName = name;
+    key.mNameIsType = false;
+    key.mEncoder = false;
+
+    return Get()->acquire(key);
+}
+
+// static
+void MediaCodecPool::Recycle(const sp<MediaCodec> &codec) {
+    Get()->recycle(codec);
+}
+
+// static
+void MediaCodecPool::Clear() {
+    Get()->clear();
+}
+
+bool MediaCodecPool::Key::matches(const Key &other) const {
+    if (mLooper != other.mLooper || mNameIsType != other.mNameIsType) {
+        return false;
+    }
+
+    if (mNameIsType) {
+        return mEncoder == other.mEncoder
+            && !strcasecmp(mName.c_str(), other.mName.c_str());
+    }
+
+    return mName == other.mName;
+}
+
+MediaCodecPool::MediaCodecPool() {
+}
+
+sp<MediaCodec> MediaCodecPool::acquire(const Key &key) {
+    sp<MediaCodec> codec;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        // Forget about codecs that were released instead of recycled.
+        for (size_t i = mActiveCodecs.size(); i-- > 0;) {
+            if (mActiveCodecs.keyAt(i).promote() == NULL) {
+                mActiveCodecs.removeItemsAt(i);
+            }
+        }
+
+        List<IdleCodec>::iterator it = mIdleCodecs.begin();
+        while (it != mIdleCodecs.end()) {
+            if ((*it).mKey.matches(key)) {
+                codec = (*it).mCodec;
+                mIdleCodecs.erase(it);
+                break;
+            }
+            ++it;
+        }
+    }
+
+    if (codec != NULL) {
+        ALOGV("reusing idle codec for '%s'", key.mName.c_str());
+    } else {
+        int64_t startUs = ALooper::GetNowUs();
+
+        codec = key.mNameIsType
+            ? MediaCodec::CreateByType(
+                    key.mLooper, key.mName.c_str(), key.mEncoder)
+            : MediaCodec::CreateByComponentName(
+                    key.mLooper, key.mName.c_str());
+
+        if (codec == NULL) {
+            return NULL;
+        }
+
+        ALOGV("created codec for '%s' in %lld us",
+             key.mName.c_str(), ALooper::GetNowUs() - startUs);
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    mActiveCodecs.add(codec, key);
+
+    return codec;
+}
+
+void MediaCodecPool::recycle(const sp<MediaCodec> &codec) {
+    Key key;
+    bool known = false;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        ssize_t index = mActiveCodecs.indexOfKey(codec);
+        if (index >= 0) {
+            key = mActiveCodecs.valueAt(index);
+            mActiveCodecs.removeItemsAt(index);
+            known = true;
+        }
+    }
+
+    AString componentName;
+    bool reusable = known
+        && codec->getName(&componentName) == OK
+        && isReusable(componentName);
+
+    // Stopping returns the codec to the state it was in right after it
+    // was created, with the component allocated but unconfigured.
+    if (!reusable || codec->stop() != OK) {
+        ALOGV("releasing codec '%s'", componentName.c_str());
+        codec->release();
+        return;
+    }
+
+    sp<MediaCodec> evicted;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        IdleCodec idle;
+        idle.mKey = key;
+        idle.mCodec = codec;
+        mIdleCodecs.push_front(idle);
+
+        if (mIdleCodecs.size() > kMaxIdleCodecs) {
+            List<IdleCodec>::iterator it = --mIdleCodecs.end();
+            evicted = (*it).mCodec;
+            mIdleCodecs.erase(it);
+        }
+    }
+
+    if (evicted != NULL) {
+        evicted->release();
+    }
+}
+
+void MediaCodecPool::clear() {
+    List<IdleCodec> idleCodecs;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+        idleCodecs = mIdleCodecs;
+        mIdleCodecs.clear();
+    }
+
+    for (List<IdleCodec>::iterator it = idleCodecs.begin();
+         it != idleCodecs.end(); ++it) {
+        (*it).mCodec->release();
+    }
+}
+
+}  // namespace android
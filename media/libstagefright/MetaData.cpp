@@ -18,6 +18,7 @@
 #define LOG_TAG "MetaData"
 #include <utils/Log.h>
 
+#include <new>
 #include <stdlib.h>
 #include <string.h>
 
@@ -28,34 +29,93 @@
 
 namespace android {
 
-MetaData::MetaData() {
+MetaData::MetaData()
+    : mItems(reinterpret_cast<item *>(mInlineItems)),
+      mNumItems(0),
+      mCapacity(kNumInlineItems) {
 }
 
 MetaData::MetaData(const MetaData &from)
     : RefBase(),
-      mItems(from.mItems) {
+      mItems(reinterpret_cast<item *>(mInlineItems)),
+      mNumItems(0),
+      mCapacity(kNumInlineItems) {
+    if (from.mNumItems > mCapacity) {
+        mItems = (item *)malloc(from.mNumItems * sizeof(item));
+        CHECK(mItems != NULL);
+
+        mCapacity = from.mNumItems;
+    }
+
+    for (size_t i = 0; i < from.mNumItems; ++i) {
+        new (&mItems[i]) item(from.mItems[i]);
+    }
+
+    mNumItems = from.mNumItems;
 }
 
 MetaData::~MetaData() {
     clear();
+
+    if (mItems != reinterpret_cast<item *>(mInlineItems)) {
+        free(mItems);
+        mItems = NULL;
+    }
 }
 
 void MetaData::clear() {
-    mItems.clear();
+    for (size_t i = 0; i < mNumItems; ++i) {
+        mItems[i].~item();
+    }
+
+    mNumItems = 0;
 }
 
 bool MetaData::remove(uint32_t key) {
-    ssize_t i = mItems.indexOfKey(key);
+    ssize_t i = indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    mItems.removeItemsAt(i);
+    mItems[i].~item();
+
+    memmove((void *)&mItems[i],
+            (const void *)&mItems[i + 1],
+            (mNumItems - i - 1) * sizeof(item));
+
+    --mNumItems;
 
     return true;
 }
 
+size_t MetaData::insertionIndexFor(uint32_t key) const {
+    size_t lo = 0;
+    size_t hi = mNumItems;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (mItems[mid].mKey < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+ssize_t MetaData::indexOfKey(uint32_t key) const {
+    size_t i = insertionIndexFor(key);
+
+    if (i < mNumItems && mItems[i].mKey == key) {
+        return i;
+    }
+
+    return -1;
+}
+
 bool MetaData::setCString(uint32_t key, const char *value) {
     return setData(key, TYPE_C_STRING, value, strlen(value) + 1);
 }
@@ -188,32 +248,53 @@ bool MetaData::setData(
         uint32_t key, uint32_t type, const void *data, size_t size) {
     bool overwrote_existing = true;
 
-    ssize_t i = mItems.indexOfKey(key);
+    ssize_t i = indexOfKey(key);
     if (i < 0) {
-        typed_data item;
-        i = mItems.add(key, item);
+        if (mNumItems == mCapacity) {
+            size_t newCapacity = mCapacity * 2;
+
+            item *newItems = (item *)malloc(newCapacity * sizeof(item));
+            CHECK(newItems != NULL);
+
+            memcpy((void *)newItems,
+                   (const void *)mItems,
+                   mNumItems * sizeof(item));
+
+            if (mItems != reinterpret_cast<item *>(mInlineItems)) {
+                free(mItems);
+            }
+
+            mItems = newItems;
+            mCapacity = newCapacity;
+        }
+
+        i = insertionIndexFor(key);
+
+        memmove((void *)&mItems[i + 1],
+                (const void *)&mItems[i],
+                (mNumItems - i) * sizeof(item));
+
+        new (&mItems[i]) item;
+        mItems[i].mKey = key;
+        ++mNumItems;
 
         overwrote_existing = false;
     }
 
-    typed_data &item = mItems.editValueAt(i);
-
-    item.setData(type, data, size);
+    mItems[i].mData.setData(type, data, size);
 
     return overwrote_existing;
 }
 
 bool MetaData::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
-    ssize_t i = mItems.indexOfKey(key);
+    ssize_t i = indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    const typed_data &item = mItems.valueAt(i);
-
-    item.getData(type, data, size);
+    mItems[i].mData.getData(type, data, size);
 
     return true;
 }
@@ -340,12 +421,12 @@ static void MakeFourCCString(uint32_t x, char *s) {
 }
 
 void MetaData::dumpToLog() const {
-    for (int i = mItems.size(); --i >= 0;) {
-        int32_t key = mItems.keyAt(i);
+    for (int i = mNumItems; --i >= 0;) {
+        int32_t key = mItems[i].mKey;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mItems.valueAt(i);
-        ALOGI("%s: %s", cc, item.asString().string());
+        const typed_data &data = mItems[i].mData;
+        ALOGI("%s: %s", cc, data.asString().string());
     }
 }
 
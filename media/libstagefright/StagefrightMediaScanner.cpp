@@ -25,6 +25,8 @@
 #include <media/stagefright/StagefrightMediaScanner.h>
 
 #include <media/mediametadataretriever.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <private/media/VideoFrame.h>
 
 // Sonivox includes
@@ -32,7 +34,9 @@
 
 namespace android {
 
-StagefrightMediaScanner::StagefrightMediaScanner() {}
+StagefrightMediaScanner::StagefrightMediaScanner()
+    : mMaxThumbnailSize(0) {
+}
 
 StagefrightMediaScanner::~StagefrightMediaScanner() {}
 
@@ -59,6 +63,67 @@ static bool FileHasAcceptableExtension(const char *extension) {
     return false;
 }
 
+static bool FileHasMIDIExtension(const char *extension) {
+    static const char *kMIDIExtensions[] = {
+        ".mid", ".smf", ".imy", ".midi", ".xmf", ".rtttl", ".rtx", ".ota",
+        ".mxmf"
+    };
+    static const size_t kNumMIDIExtensions =
+        sizeof(kMIDIExtensions) / sizeof(kMIDIExtensions[0]);
+
+    for (size_t i = 0; i < kNumMIDIExtensions; ++i) {
+        if (!strcasecmp(extension, kMIDIExtensions[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Whether the file is handled by MediaMetadataRetriever rather than being
+// skipped or parsed by the MIDI engine.
+static bool FileNeedsRetriever(const char *path) {
+    const char *extension = strrchr(path, '.');
+
+    return extension != NULL
+        && FileHasAcceptableExtension(extension)
+        && !FileHasMIDIExtension(extension);
+}
+
+struct KeyMap {
+    const char *tag;
+    int key;
+};
+static const KeyMap kKeyMap[] = {
+    { "tracknumber", METADATA_KEY_CD_TRACK_NUMBER },
+    { "discnumber", METADATA_KEY_DISC_NUMBER },
+    { "album", METADATA_KEY_ALBUM },
+    { "artist", METADATA_KEY_ARTIST },
+    { "albumartist", METADATA_KEY_ALBUMARTIST },
+    { "composer", METADATA_KEY_COMPOSER },
+    { "genre", METADATA_KEY_GENRE },
+    { "title", METADATA_KEY_TITLE },
+    { "year", METADATA_KEY_YEAR },
+    { "duration", METADATA_KEY_DURATION },
+    { "writer", METADATA_KEY_WRITER },
+    { "compilation", METADATA_KEY_COMPILATION },
+    { "isdrm", METADATA_KEY_IS_DRM },
+    { "width", METADATA_KEY_VIDEO_WIDTH },
+    { "height", METADATA_KEY_VIDEO_HEIGHT },
+};
+static const size_t kNumEntries = sizeof(kKeyMap) / sizeof(kKeyMap[0]);
+
+// Only the keys that are passed on to the client are worth extracting.
+static void GetRetrieverOptions(
+        int32_t maxThumbnailSize, BatchMetadataRetriever::Options *options) {
+    options->mMaxThumbnailSize = maxThumbnailSize;
+
+    options->mMetadataKeys.push(METADATA_KEY_MIMETYPE);
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        options->mMetadataKeys.push(kKeyMap[i].key);
+    }
+}
+
 static MediaScanResult HandleMIDI(
         const char *filename, MediaScannerClient *client) {
     // get the library configuration and do sanity check
@@ -132,69 +197,93 @@ MediaScanResult StagefrightMediaScanner::processFileInternal(
         return MEDIA_SCAN_RESULT_SKIPPED;
     }
 
-    if (!strcasecmp(extension, ".mid")
-            || !strcasecmp(extension, ".smf")
-            || !strcasecmp(extension, ".imy")
-            || !strcasecmp(extension, ".midi")
-            || !strcasecmp(extension, ".xmf")
-            || !strcasecmp(extension, ".rtttl")
-            || !strcasecmp(extension, ".rtx")
-            || !strcasecmp(extension, ".ota")
-            || !strcasecmp(extension, ".mxmf")) {
+    if (FileHasMIDIExtension(extension)) {
         return HandleMIDI(path, &client);
     }
 
-    sp<MediaMetadataRetriever> mRetriever(new MediaMetadataRetriever);
+    BatchMetadataRetriever::Options options;
+    GetRetrieverOptions(mMaxThumbnailSize, &options);
 
-    int fd = open(path, O_RDONLY | O_LARGEFILE);
-    status_t status;
-    if (fd < 0) {
-        // couldn't open it locally, maybe the media server can?
-        status = mRetriever->setDataSource(path);
-    } else {
-        status = mRetriever->setDataSource(fd, 0, 0x7ffffffffffffffL);
-        close(fd);
+    return processRetrievedFile(
+            BatchMetadataRetriever::Retrieve(
+                new MediaMetadataRetriever, path, options),
+            client);
+}
+
+MediaScanResult StagefrightMediaScanner::processFiles(
+        const char *const *paths, size_t numPaths,
+        MediaScannerClient &client) {
+    ALOGV("processFiles (%d files).", numPaths);
+
+    BatchMetadataRetriever::Options options;
+    GetRetrieverOptions(mMaxThumbnailSize, &options);
+
+    sp<BatchMetadataRetriever> retriever = new BatchMetadataRetriever(options);
+    for (size_t i = 0; i < numPaths; ++i) {
+        if (FileNeedsRetriever(paths[i])) {
+            retriever->addFile(paths[i]);
+        }
     }
+    retriever->start();
+
+    int64_t startUs = ALooper::GetNowUs();
+
+    // The retriever returns its files in the order they were added, the
+    // others are handled here as they come up.
+    MediaScanResult result = MEDIA_SCAN_RESULT_OK;
+    for (size_t i = 0; i < numPaths; ++i) {
+        client.setLocale(locale());
+        client.beginFile();
+
+        MediaScanResult fileResult;
+        if (FileNeedsRetriever(paths[i])) {
+            sp<BatchMetadataRetriever::Result> retrieved =
+                retriever->dequeueResult();
+            CHECK(retrieved != NULL);
+
+            fileResult = processRetrievedFile(retrieved, client);
+        } else {
+            fileResult = processFileInternal(paths[i], NULL, client);
+        }
 
-    if (status) {
-        return MEDIA_SCAN_RESULT_ERROR;
+        client.endFile();
+
+        if (fileResult == MEDIA_SCAN_RESULT_ERROR) {
+            result = MEDIA_SCAN_RESULT_ERROR;
+            break;
+        }
+    }
+
+    retriever->stop();
+
+    ALOGV("processFiles took %lld us.", ALooper::GetNowUs() - startUs);
+
+    return result;
+}
+
+MediaScanResult StagefrightMediaScanner::processRetrievedFile(
+        const sp<BatchMetadataRetriever::Result> &result,
+        MediaScannerClient &client) {
+    // A file that cannot be opened or parsed only affects itself, the scan
+    // is aborted when the client fails.
+    if (result->mStatus != OK) {
+        ALOGV("Could not retrieve the metadata of '%s' (%d).",
+              result->mPath.c_str(), result->mStatus);
+        return MEDIA_SCAN_RESULT_SKIPPED;
     }
 
+    status_t status;
     const char *value;
-    if ((value = mRetriever->extractMetadata(
-                    METADATA_KEY_MIMETYPE)) != NULL) {
+    if ((value = result->getMetadata(METADATA_KEY_MIMETYPE)) != NULL) {
         status = client.setMimeType(value);
         if (status) {
             return MEDIA_SCAN_RESULT_ERROR;
         }
     }
 
-    struct KeyMap {
-        const char *tag;
-        int key;
-    };
-    static const KeyMap kKeyMap[] = {
-        { "tracknumber", METADATA_KEY_CD_TRACK_NUMBER },
-        { "discnumber", METADATA_KEY_DISC_NUMBER },
-        { "album", METADATA_KEY_ALBUM },
-        { "artist", METADATA_KEY_ARTIST },
-        { "albumartist", METADATA_KEY_ALBUMARTIST },
-        { "composer", METADATA_KEY_COMPOSER },
-        { "genre", METADATA_KEY_GENRE },
-        { "title", METADATA_KEY_TITLE },
-        { "year", METADATA_KEY_YEAR },
-        { "duration", METADATA_KEY_DURATION },
-        { "writer", METADATA_KEY_WRITER },
-        { "compilation", METADATA_KEY_COMPILATION },
-        { "isdrm", METADATA_KEY_IS_DRM },
-        { "width", METADATA_KEY_VIDEO_WIDTH },
-        { "height", METADATA_KEY_VIDEO_HEIGHT },
-    };
-    static const size_t kNumEntries = sizeof(kKeyMap) / sizeof(kKeyMap[0]);
-
     for (size_t i = 0; i < kNumEntries; ++i) {
         const char *value;
-        if ((value = mRetriever->extractMetadata(kKeyMap[i].key)) != NULL) {
+        if ((value = result->getMetadata(kKeyMap[i].key)) != NULL) {
             status = client.addStringTag(kKeyMap[i].tag, value);
             if (status != OK) {
                 return MEDIA_SCAN_RESULT_ERROR;
@@ -202,9 +291,21 @@ MediaScanResult StagefrightMediaScanner::processFileInternal(
         }
     }
 
+    if (result->mThumbnail != NULL) {
+        status = client.handleThumbnail(
+                static_cast<const VideoFrame *>(result->mThumbnail->pointer()));
+        if (status != OK) {
+            return MEDIA_SCAN_RESULT_ERROR;
+        }
+    }
+
     return MEDIA_SCAN_RESULT_OK;
 }
 
+void StagefrightMediaScanner::setMaxThumbnailSize(int32_t maxSize) {
+    mMaxThumbnailSize = maxSize;
+}
+
 char *StagefrightMediaScanner::extractAlbumArt(int fd) {
     ALOGV("extractAlbumArt %d", fd);
 
@@ -20,10 +20,13 @@
 
 #include "include/StagefrightMetadataRetriever.h"
 
+#include <unistd.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/ColorConverter.h>
 #include <media/stagefright/DataSource.h>
 #include <media/stagefright/FileSource.h>
+#include <media/stagefright/FrameScaler.h>
 #include <media/stagefright/MediaExtractor.h>
 #include <media/stagefright/MetaData.h>
 #include <media/stagefright/OMXCodec.h>
@@ -141,7 +144,9 @@ static VideoFrame *extractVideoFrameWithCodecFlags(
         const sp<MediaSource> &source,
         uint32_t flags,
         int64_t frameTimeUs,
-        int seekMode) {
+        int seekMode,
+        int32_t maxWidth,
+        int32_t maxHeight) {
 
     sp<MetaData> format = source->getFormat();
 
@@ -263,38 +268,87 @@ static VideoFrame *extractVideoFrameWithCodecFlags(
         rotationAngle = 0;  // By default, no rotation
     }
 
-    VideoFrame *frame = new VideoFrame;
-    frame->mWidth = crop_right - crop_left + 1;
-    frame->mHeight = crop_bottom - crop_top + 1;
-    frame->mDisplayWidth = frame->mWidth;
-    frame->mDisplayHeight = frame->mHeight;
-    frame->mSize = frame->mWidth * frame->mHeight * 2;
-    frame->mData = new uint8_t[frame->mSize];
-    frame->mRotationAngle = rotationAngle;
+    int32_t cropWidth = crop_right - crop_left + 1;
+    int32_t cropHeight = crop_bottom - crop_top + 1;
 
     int32_t displayWidth, displayHeight;
-    if (meta->findInt32(kKeyDisplayWidth, &displayWidth)) {
-        frame->mDisplayWidth = displayWidth;
+    if (!meta->findInt32(kKeyDisplayWidth, &displayWidth)) {
+        displayWidth = cropWidth;
     }
-    if (meta->findInt32(kKeyDisplayHeight, &displayHeight)) {
-        frame->mDisplayHeight = displayHeight;
+    if (!meta->findInt32(kKeyDisplayHeight, &displayHeight)) {
+        displayHeight = cropHeight;
     }
 
+    // The scaled frame already has the display aspect ratio applied, it is
+    // still rotated by the client.
+    int32_t scaledWidth, scaledHeight;
+    FrameScaler::ComputeScaledSize(
+            displayWidth, displayHeight, maxWidth, maxHeight, rotationAngle,
+            &scaledWidth, &scaledHeight);
+
+    bool scaled = (maxWidth > 0 || maxHeight > 0)
+        && (scaledWidth != cropWidth || scaledHeight != cropHeight);
+
+    VideoFrame *frame = new VideoFrame;
+    frame->mWidth = scaled ? scaledWidth : cropWidth;
+    frame->mHeight = scaled ? scaledHeight : cropHeight;
+    frame->mDisplayWidth = scaled ? scaledWidth : displayWidth;
+    frame->mDisplayHeight = scaled ? scaledHeight : displayHeight;
+    frame->mSize = frame->mWidth * frame->mHeight * 2;
+    frame->mData = new uint8_t[frame->mSize];
+    frame->mRotationAngle = rotationAngle;
+
     int32_t srcFormat;
     CHECK(meta->findInt32(kKeyColorFormat, &srcFormat));
 
+    // A scaled frame is converted to RGBA first so that the scaler filters
+    // full precision pixels, it packs the result to RGB565.
     ColorConverter converter(
-            (OMX_COLOR_FORMATTYPE)srcFormat, OMX_COLOR_Format16bitRGB565);
+            (OMX_COLOR_FORMATTYPE)srcFormat,
+            scaled ? (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal
+                   : OMX_COLOR_Format16bitRGB565);
 
     if (converter.isValid()) {
-        err = converter.convert(
-                (const uint8_t *)buffer->data() + buffer->range_offset(),
-                width, height,
-                crop_left, crop_top, crop_right, crop_bottom,
-                frame->mData,
-                frame->mWidth,
-                frame->mHeight,
-                0, 0, frame->mWidth - 1, frame->mHeight - 1);
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (numCpus > 1) {
+            converter.setNumThreads(numCpus);
+        }
+
+        if (!scaled) {
+            err = converter.convert(
+                    (const uint8_t *)buffer->data() + buffer->range_offset(),
+                    width, height,
+                    crop_left, crop_top, crop_right, crop_bottom,
+                    frame->mData,
+                    frame->mWidth,
+                    frame->mHeight,
+                    0, 0, frame->mWidth - 1, frame->mHeight - 1);
+        } else {
+            uint8_t *rgba = new uint8_t[cropWidth * cropHeight * 4];
+
+            err = converter.convert(
+                    (const uint8_t *)buffer->data() + buffer->range_offset(),
+                    width, height,
+                    crop_left, crop_top, crop_right, crop_bottom,
+                    rgba,
+                    cropWidth,
+                    cropHeight,
+                    0, 0, cropWidth - 1, cropHeight - 1);
+
+            if (err == OK) {
+                FrameScaler scaler(
+                        FrameScaler::FILTER_LANCZOS3,
+                        OMX_COLOR_Format16bitRGB565);
+
+                err = scaler.scale(
+                        rgba, cropWidth, cropHeight, cropWidth * 4,
+                        frame->mData, frame->mWidth, frame->mHeight,
+                        frame->mWidth * 2);
+            }
+
+            delete[] rgba;
+            rgba = NULL;
+        }
     } else {
         ALOGE("Unable to instantiate color conversion from format 0x%08x to "
               "RGB565",
@@ -323,6 +377,15 @@ VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
 
     ALOGV("getFrameAtTime: %lld us option: %d", timeUs, option);
 
+    return getScaledFrameAtTime(timeUs, option, 0, 0);
+}
+
+VideoFrame *StagefrightMetadataRetriever::getScaledFrameAtTime(
+        int64_t timeUs, int option, int32_t maxWidth, int32_t maxHeight) {
+
+    ALOGV("getScaledFrameAtTime: %lld us option: %d max: %dx%d",
+         timeUs, option, maxWidth, maxHeight);
+
     if (mExtractor.get() == NULL) {
         ALOGV("no extractor.");
         return NULL;
@@ -383,14 +446,14 @@ VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
     VideoFrame *frame =
         extractVideoFrameWithCodecFlags(
                 &mClient, trackMeta, source, OMXCodec::kPreferSoftwareCodecs,
-                timeUs, option);
+                timeUs, option, maxWidth, maxHeight);
 
     if (frame == NULL) {
         ALOGV("Software decoder failed to extract thumbnail, "
              "trying hardware decoder.");
 
         frame = extractVideoFrameWithCodecFlags(&mClient, trackMeta, source, 0,
-                        timeUs, option);
+                        timeUs, option, maxWidth, maxHeight);
     }
 
     return frame;
@@ -34,8 +34,27 @@
 
 namespace android {
 
+void TimedEventQueue::LatencyStats::add(int64_t latencyUs) {
+    if (mNumFired == 0 || latencyUs < mMinLatencyUs) {
+        mMinLatencyUs = latencyUs;
+    }
+
+    if (mNumFired == 0 || latencyUs > mMaxLatencyUs) {
+        mMaxLatencyUs = latencyUs;
+    }
+
+    if (latencyUs > kLateThresholdUs) {
+        ++mNumLate;
+    }
+
+    ++mNumFired;
+    mTotalLatencyUs += latencyUs;
+}
+
 TimedEventQueue::TimedEventQueue()
-    : mNextEventID(1),
+    : mNextSeq(0),
+      mNextEventID(1),
+      mWakeupTimeUs(-1),
       mRunning(false),
       mStopped(false) {
 }
@@ -76,7 +95,11 @@ void TimedEventQueue::stop(bool flush) {
     void *dummy;
     pthread_join(mThread, &dummy);
 
+    for (size_t i = 0; i < mQueue.size(); ++i) {
+        mQueue.itemAt(i).event->setEventID(0);
+    }
     mQueue.clear();
+    mEventsByID.clear();
 
     mRunning = false;
 }
@@ -102,40 +125,118 @@ TimedEventQueue::event_id TimedEventQueue::postTimedEvent(
         const sp<Event> &event, int64_t realtime_us) {
     Mutex::Autolock autoLock(mLock);
 
-    event->setEventID(mNextEventID++);
+    // The event must not be pending already.
+    CHECK_EQ(event->eventID(), 0);
 
-    List<QueueItem>::iterator it = mQueue.begin();
-    while (it != mQueue.end() && realtime_us >= (*it).realtime_us) {
-        ++it;
-    }
+    event->setEventID(mNextEventID++);
 
     QueueItem item;
     item.event = event;
     item.realtime_us = realtime_us;
+    item.seq = mNextSeq++;
 
-    if (it == mQueue.begin()) {
-        mQueueHeadChangedCondition.signal();
+    if (realtime_us < 0 || realtime_us == INT64_MAX) {
+        item.scheduled_us = ALooper::GetNowUs();
+    } else {
+        item.scheduled_us = realtime_us;
+    }
+
+    if (mQueue.isEmpty() || IsEarlier(item, mQueue.itemAt(0))) {
+        // Don't interrupt the queue thread if it is going to wake up
+        // close enough to the new event's time anyway.
+        if (mWakeupTimeUs < 0
+                || item.realtime_us < 0
+                || item.realtime_us
+                    < mWakeupTimeUs - kWakeupCoalescingWindowUs) {
+            mQueueHeadChangedCondition.signal();
+        }
     }
 
-    mQueue.insert(it, item);
+    mEventsByID.add(event->eventID(), event.get());
+
+    mQueue.push();
+    siftUp_l(mQueue.size() - 1, item);
 
     mQueueNotEmptyCondition.signal();
 
     return event->eventID();
 }
 
-static bool MatchesEventID(
-        void *cookie, const sp<TimedEventQueue::Event> &event) {
-    TimedEventQueue::event_id *id =
-        static_cast<TimedEventQueue::event_id *>(cookie);
+// static
+bool TimedEventQueue::IsEarlier(const QueueItem &a, const QueueItem &b) {
+    if (a.realtime_us != b.realtime_us) {
+        return a.realtime_us < b.realtime_us;
+    }
+
+    return (int32_t)(a.seq - b.seq) < 0;
+}
+
+void TimedEventQueue::setItem_l(size_t index, const QueueItem &item) {
+    mQueue.editItemAt(index) = item;
+    item.event->mQueueIndex = index;
+}
 
-    if (event->eventID() != *id) {
-        return false;
+void TimedEventQueue::siftUp_l(size_t index, const QueueItem &item) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+
+        if (!IsEarlier(item, mQueue.itemAt(parent))) {
+            break;
+        }
+
+        setItem_l(index, mQueue.itemAt(parent));
+        index = parent;
     }
 
-    *id = 0;
+    setItem_l(index, item);
+}
 
-    return true;
+void TimedEventQueue::siftDown_l(size_t index, const QueueItem &item) {
+    size_t n = mQueue.size();
+
+    for (;;) {
+        size_t child = 2 * index + 1;
+
+        if (child >= n) {
+            break;
+        }
+
+        if (child + 1 < n
+                && IsEarlier(mQueue.itemAt(child + 1), mQueue.itemAt(child))) {
+            ++child;
+        }
+
+        if (!IsEarlier(mQueue.itemAt(child), item)) {
+            break;
+        }
+
+        setItem_l(index, mQueue.itemAt(child));
+        index = child;
+    }
+
+    setItem_l(index, item);
+}
+
+sp<TimedEventQueue::Event> TimedEventQueue::removeItemAt_l(size_t index) {
+    sp<Event> event = mQueue.itemAt(index).event;
+
+    mEventsByID.removeItem(event->eventID());
+    event->setEventID(0);
+
+    QueueItem last = mQueue.top();
+    mQueue.pop();
+
+    if (index < mQueue.size()) {
+        // Move the last item into the hole, it may have to travel either
+        // direction from there.
+        if (index > 0 && IsEarlier(last, mQueue.itemAt((index - 1) / 2))) {
+            siftUp_l(index, last);
+        } else {
+            siftDown_l(index, last);
+        }
+    }
+
+    return event;
 }
 
 bool TimedEventQueue::cancelEvent(event_id id) {
@@ -143,12 +244,24 @@ bool TimedEventQueue::cancelEvent(event_id id) {
         return false;
     }
 
-    cancelEvents(&MatchesEventID, &id, true /* stopAfterFirstMatch */);
+    Mutex::Autolock autoLock(mLock);
 
-    // if MatchesEventID found a match, it will have set id to 0
-    // (which is not a valid event_id).
+    ssize_t index = mEventsByID.indexOfKey(id);
+    if (index < 0) {
+        return false;
+    }
 
-    return id == 0;
+    size_t queueIndex = mEventsByID.valueAt(index)->mQueueIndex;
+
+    if (queueIndex == 0) {
+        mQueueHeadChangedCondition.signal();
+    }
+
+    ALOGV("cancelling event %d", id);
+
+    removeItemAt_l(queueIndex);
+
+    return true;
 }
 
 void TimedEventQueue::cancelEvents(
@@ -157,28 +270,69 @@ void TimedEventQueue::cancelEvents(
         bool stopAfterFirstMatch) {
     Mutex::Autolock autoLock(mLock);
 
-    List<QueueItem>::iterator it = mQueue.begin();
-    while (it != mQueue.end()) {
-        if (!(*predicate)(cookie, (*it).event)) {
-            ++it;
+    if (stopAfterFirstMatch) {
+        // The heap isn't sorted, find the earliest matching event.
+        ssize_t match = -1;
+        for (size_t i = 0; i < mQueue.size(); ++i) {
+            const QueueItem &item = mQueue.itemAt(i);
+
+            if ((match < 0 || IsEarlier(item, mQueue.itemAt(match)))
+                    && (*predicate)(cookie, item.event)) {
+                match = i;
+            }
+        }
+
+        if (match >= 0) {
+            if (match == 0) {
+                mQueueHeadChangedCondition.signal();
+            }
+
+            ALOGV("cancelling event %d",
+                  mQueue.itemAt(match).event->eventID());
+
+            removeItemAt_l(match);
+        }
+        return;
+    }
+
+    size_t i = 0;
+    while (i < mQueue.size()) {
+        if (!(*predicate)(cookie, mQueue.itemAt(i).event)) {
+            ++i;
             continue;
         }
 
-        if (it == mQueue.begin()) {
+        if (i == 0) {
             mQueueHeadChangedCondition.signal();
         }
 
-        ALOGV("cancelling event %d", (*it).event->eventID());
+        ALOGV("cancelling event %d", mQueue.itemAt(i).event->eventID());
+
+        // Whatever item takes the place of the removed one has to be
+        // examined again. Items may move towards the root when sifted up,
+        // restart in that case.
+        const Event *replacement =
+            i + 1 < mQueue.size() ? mQueue.top().event.get() : NULL;
 
-        (*it).event->setEventID(0);
-        it = mQueue.erase(it);
+        removeItemAt_l(i);
 
-        if (stopAfterFirstMatch) {
-            return;
+        if (replacement != NULL && replacement->mQueueIndex < i) {
+            i = 0;
         }
     }
 }
 
+void TimedEventQueue::getLatencyStats(LatencyStats *stats) const {
+    Mutex::Autolock autoLock(mLock);
+    *stats = mLatencyStats;
+}
+
+void TimedEventQueue::getLatencyStats(
+        const sp<Event> &event, LatencyStats *stats) const {
+    Mutex::Autolock autoLock(mLock);
+    *stats = event->mLatencyStats;
+}
+
 // static
 void *TimedEventQueue::ThreadWrapper(void *me) {
 
@@ -203,23 +357,23 @@ void TimedEventQueue::threadEntry() {
                 break;
             }
 
-            while (mQueue.empty()) {
+            while (mQueue.isEmpty()) {
                 mQueueNotEmptyCondition.wait(mLock);
             }
 
             event_id eventID = 0;
             for (;;) {
-                if (mQueue.empty()) {
+                if (mQueue.isEmpty()) {
                     // The only event in the queue could have been cancelled
                     // while we were waiting for its scheduled time.
                     break;
                 }
 
-                List<QueueItem>::iterator it = mQueue.begin();
-                eventID = (*it).event->eventID();
+                const QueueItem &item = mQueue.itemAt(0);
+                eventID = item.event->eventID();
 
                 now_us = ALooper::GetNowUs();
-                int64_t when_us = (*it).realtime_us;
+                int64_t when_us = item.realtime_us;
 
                 int64_t delay_us;
                 if (when_us < 0 || when_us == INT64_MAX) {
@@ -228,7 +382,7 @@ void TimedEventQueue::threadEntry() {
                     delay_us = when_us - now_us;
                 }
 
-                if (delay_us <= 0) {
+                if (delay_us <= kWakeupCoalescingWindowUs) {
                     break;
                 }
 
@@ -245,9 +399,13 @@ void TimedEventQueue::threadEntry() {
                     timeoutCapped = true;
                 }
 
+                mWakeupTimeUs = now_us + delay_us;
+
                 status_t err = mQueueHeadChangedCondition.waitRelative(
                         mLock, delay_us * 1000ll);
 
+                mWakeupTimeUs = -1;
+
                 if (!timeoutCapped && err == -ETIMEDOUT) {
                     // We finally hit the time this event is supposed to
                     // trigger.
@@ -261,7 +419,7 @@ void TimedEventQueue::threadEntry() {
             // removeEventFromQueue_l will return NULL.
             // Otherwise, the QueueItem will be removed
             // from the queue and the referenced event returned.
-            event = removeEventFromQueue_l(eventID);
+            event = removeEventFromQueue_l(eventID, now_us);
         }
 
         if (event != NULL) {
@@ -272,22 +430,24 @@ void TimedEventQueue::threadEntry() {
 }
 
 sp<TimedEventQueue::Event> TimedEventQueue::removeEventFromQueue_l(
-        event_id id) {
-    for (List<QueueItem>::iterator it = mQueue.begin();
-         it != mQueue.end(); ++it) {
-        if ((*it).event->eventID() == id) {
-            sp<Event> event = (*it).event;
-            event->setEventID(0);
+        event_id id, int64_t now_us) {
+    ssize_t index = mEventsByID.indexOfKey(id);
 
-            mQueue.erase(it);
+    if (index < 0) {
+        ALOGW("Event %d was not found in the queue, already cancelled?", id);
 
-            return event;
-        }
+        return NULL;
     }
 
-    ALOGW("Event %d was not found in the queue, already cancelled?", id);
+    size_t queueIndex = mEventsByID.valueAt(index)->mQueueIndex;
+    int64_t latencyUs = now_us - mQueue.itemAt(queueIndex).scheduled_us;
 
-    return NULL;
+    sp<Event> event = removeItemAt_l(queueIndex);
+
+    event->mLatencyStats.add(latencyUs);
+    mLatencyStats.add(latencyUs);
+
+    return event;
 }
 
 }  // namespace android
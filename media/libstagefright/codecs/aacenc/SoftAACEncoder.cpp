@@ -551,6 +551,33 @@ void SoftAACEncoder::onQueueFilled(OMX_U32 portIndex) {
     }
 }
 
+void SoftAACEncoder::onReset() {
+    // The next stream starts on a fresh encoder instance, without the
+    // overlap of the last frames of this one.
+    if (mEncoderHandle) {
+        CHECK_EQ(VO_ERR_NONE, mApiHandle->Uninit(mEncoderHandle));
+        mEncoderHandle = NULL;
+    }
+
+    delete mApiHandle;
+    mApiHandle = NULL;
+
+    delete mMemOperator;
+    mMemOperator = NULL;
+
+    CHECK_EQ(initEncoder(), (status_t)OK);
+    setAudioParams();
+
+    delete[] mInputFrame;
+    mInputFrame = NULL;
+
+    mSentCodecSpecificData = false;
+    mInputSize = 0;
+    mInputTimeUs = -1ll;
+    mSawInputEOS = false;
+    mSignalledError = false;
+}
+
 }  // namespace android
 
 android::SoftOMXComponent *createSoftOMXComponent(
@@ -42,6 +42,7 @@ protected:
             OMX_INDEXTYPE index, const OMX_PTR params);
 
     virtual void onQueueFilled(OMX_U32 portIndex);
+    virtual void onReset();
 
 private:
     enum {
@@ -565,6 +565,24 @@ void SoftAACEncoder2::onQueueFilled(OMX_U32 portIndex) {
     }
 }
 
+void SoftAACEncoder2::onReset() {
+    // The next stream starts on a fresh encoder instance, without the
+    // overlap of the last frames of this one.
+    aacEncClose(&mAACEncoder);
+
+    CHECK_EQ(initEncoder(), (status_t)OK);
+    setAudioParams();
+
+    delete[] mInputFrame;
+    mInputFrame = NULL;
+
+    mSentCodecSpecificData = false;
+    mInputSize = 0;
+    mInputTimeUs = -1ll;
+    mSawInputEOS = false;
+    mSignalledError = false;
+}
+
 }  // namespace android
 
 android::SoftOMXComponent *createSoftOMXComponent(
@@ -33,6 +33,9 @@
 #include <ui/GraphicBufferMapper.h>
 
 #include "SoftAVCEncoder.h"
+#include "RateControlLookahead.h"
+
+#include <unistd.h>
 
 namespace android {
 
@@ -182,10 +185,15 @@ SoftAVCEncoder::SoftAVCEncoder(
       mIDRFrameRefreshIntervalInSec(1),
       mAVCEncProfile(AVC_BASELINE),
       mAVCEncLevel(AVC_LEVEL2),
+      mRCLookahead(false),
+      mRCLookaheadFrames(0),
+      mVBVSizeMs(0),
+      mAdaptiveQuant(false),
       mNumInputFrames(-1),
       mPrevTimestampUs(-1),
       mStarted(false),
       mSawInputEOS(false),
+      mSignalledOutputEOS(false),
       mSignalledError(false),
       mHandle(new tagAVCHandle),
       mEncParams(new tagAVCEncParam),
@@ -254,6 +262,15 @@ OMX_ERRORTYPE SoftAVCEncoder::initEncParams() {
 
     mEncParams->use_overrun_buffer = AVC_OFF;
 
+    // Each frame queued in the lookahead delays the output by one frame.
+    mEncParams->lookahead_rc = mRCLookahead ? AVC_ON : AVC_OFF;
+    mEncParams->lookahead_depth = mRCLookaheadFrames;
+    mEncParams->adaptive_quant = mAdaptiveQuant ? AVC_ON : AVC_OFF;
+
+    // Search motion on all cores, the bitstream does not depend on it.
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    mEncParams->num_threads = (numCpus > 1) ? numCpus : 1;
+
     if (mVideoColorFormat == OMX_COLOR_FormatYUV420SemiPlanar) {
         // Color conversion is needed.
         CHECK(mInputFrameData == NULL);
@@ -273,7 +290,12 @@ OMX_ERRORTYPE SoftAVCEncoder::initEncParams() {
     mEncParams->height = mVideoHeight;
     mEncParams->bitrate = mVideoBitRate;
     mEncParams->frame_rate = 1000 * mVideoFrameRate;  // In frames/ms!
-    mEncParams->CPB_size = (uint32_t) (mVideoBitRate >> 1);
+    if (mVBVSizeMs > 0) {
+        mEncParams->CPB_size =
+            (uint32_t) (((int64_t) mVideoBitRate * mVBVSizeMs) / 1000);
+    } else {
+        mEncParams->CPB_size = (uint32_t) (mVideoBitRate >> 1);
+    }
 
     int32_t nMacroBlocks = ((((mVideoWidth + 15) >> 4) << 4) *
             (((mVideoHeight + 15) >> 4) << 4)) >> 8;
@@ -359,6 +381,26 @@ OMX_ERRORTYPE SoftAVCEncoder::releaseEncoder() {
     return OMX_ErrorNone;
 }
 
+void SoftAVCEncoder::onReset() {
+    // The encoder is initialized again with the first frame of the next
+    // stream, releaseEncoder() frees the handle and parameters with it.
+    releaseEncoder();
+
+    if (mHandle == NULL) {
+        mHandle = new tagAVCHandle;
+    }
+    if (mEncParams == NULL) {
+        mEncParams = new tagAVCEncParam;
+    }
+
+    mInputBufferInfoVec.clear();
+    mNumInputFrames = -1;
+    mPrevTimestampUs = -1;
+    mSawInputEOS = false;
+    mSignalledOutputEOS = false;
+    mSignalledError = false;
+}
+
 void SoftAVCEncoder::releaseOutputBuffers() {
     for (size_t i = 0; i < mOutputBuffers.size(); ++i) {
         MediaBuffer *buffer = mOutputBuffers.editItemAt(i);
@@ -532,6 +574,24 @@ OMX_ERRORTYPE SoftAVCEncoder::internalGetParameter(
             return OMX_ErrorNone;
         }
 
+        case kRateControlLookaheadExtensionIndex:
+        {
+            RateControlLookaheadParams *lookaheadParams =
+                (RateControlLookaheadParams *)params;
+
+            if (lookaheadParams->nPortIndex != 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            lookaheadParams->bEnable = mRCLookahead ? OMX_TRUE : OMX_FALSE;
+            lookaheadParams->nLookaheadFrames = mRCLookaheadFrames;
+            lookaheadParams->nVBVSizeMs = mVBVSizeMs;
+            lookaheadParams->bAdaptiveQuantization =
+                mAdaptiveQuant ? OMX_TRUE : OMX_FALSE;
+
+            return OMX_ErrorNone;
+        }
+
         default:
             return SimpleSoftOMXComponent::internalGetParameter(index, params);
     }
@@ -706,13 +766,38 @@ OMX_ERRORTYPE SoftAVCEncoder::internalSetParameter(
             return OMX_ErrorNone;
         }
 
+        case kRateControlLookaheadExtensionIndex:
+        {
+            const RateControlLookaheadParams *lookaheadParams =
+                (const RateControlLookaheadParams *)params;
+
+            if (lookaheadParams->nPortIndex != 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            if (lookaheadParams->nLookaheadFrames > MAX_LOOKAHEAD_DEPTH) {
+                ALOGE("Lookahead of %lu frames is not supported (max %d)",
+                        lookaheadParams->nLookaheadFrames, MAX_LOOKAHEAD_DEPTH);
+                return OMX_ErrorUnsupportedSetting;
+            }
+
+            mRCLookahead = lookaheadParams->bEnable == OMX_TRUE;
+            mRCLookaheadFrames = lookaheadParams->nLookaheadFrames;
+            mVBVSizeMs = lookaheadParams->nVBVSizeMs;
+            mAdaptiveQuant = lookaheadParams->bAdaptiveQuantization == OMX_TRUE;
+
+            return OMX_ErrorNone;
+        }
+
         default:
             return SimpleSoftOMXComponent::internalSetParameter(index, params);
     }
 }
 
 void SoftAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
-    if (mSignalledError || mSawInputEOS) {
+    // After the input EOS, keep draining the lookahead as output buffers
+    // come back, it may hold more frames than there are output buffers.
+    if (mSignalledError || (mSawInputEOS && mSignalledOutputEOS)) {
         return;
     }
 
@@ -788,6 +873,19 @@ void SoftAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
 
         // Get next input video frame
         if (mReadyForNextFrame) {
+            if (inHeader->nFlags & OMX_BUFFERFLAG_EOS) {
+                mSawInputEOS = true;
+            }
+
+            if (inHeader->nFilledLen == 0 && !mInputBufferInfoVec.empty()) {
+                // Frames are still queued in the lookahead, the last
+                // of them carries the EOS flag once they are flushed.
+                inQueue.erase(inQueue.begin());
+                inInfo->mOwnedByUs = false;
+                notifyEmptyBufferDone(inHeader);
+                continue;
+            }
+
             // Save the input buffer info so that it can be
             // passed to an output buffer
             InputBufferInfo info;
@@ -796,10 +894,6 @@ void SoftAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
             mInputBufferInfoVec.push(info);
             mPrevTimestampUs = inHeader->nTimeStamp;
 
-            if (inHeader->nFlags & OMX_BUFFERFLAG_EOS) {
-                mSawInputEOS = true;
-            }
-
             if (inHeader->nFilledLen > 0) {
                 AVCFrameIO videoInput;
                 memset(&videoInput, 0, sizeof(videoInput));
@@ -857,11 +951,16 @@ void SoftAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
                         return;
                     } else {
                         ALOGV("encoderStatus = %d at line %d", encoderStatus, __LINE__);
+                        if (encoderStatus != AVCENC_PICTURE_QUEUED) {
+                            // A skipped frame has no output buffer.
+                            mInputBufferInfoVec.removeAt(
+                                    mInputBufferInfoVec.size() - 1);
+                        }
                         inQueue.erase(inQueue.begin());
                         inInfo->mOwnedByUs = false;
                         releaseGrallocData(srcBuffer);
                         notifyEmptyBufferDone(inHeader);
-                        return;
+                        continue;
                     }
                 }
             }
@@ -911,14 +1010,73 @@ void SoftAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
         InputBufferInfo *inputBufInfo = mInputBufferInfoVec.begin();
         outHeader->nTimeStamp = inputBufInfo->mTimeUs;
         outHeader->nFlags |= (inputBufInfo->mFlags | OMX_BUFFERFLAG_ENDOFFRAME);
-        if (mSawInputEOS) {
+        if (mSawInputEOS && mInputBufferInfoVec.size() == 1) {
             outHeader->nFlags |= OMX_BUFFERFLAG_EOS;
         }
+        if (outHeader->nFlags & OMX_BUFFERFLAG_EOS) {
+            mSignalledOutputEOS = true;
+        }
         outHeader->nFilledLen = dataLength;
         outInfo->mOwnedByUs = false;
         notifyFillBufferDone(outHeader);
         mInputBufferInfoVec.erase(mInputBufferInfoVec.begin());
     }
+
+    // Encode the frames still queued in the lookahead after the input EOS
+    while (mSawInputEOS && !mSignalledOutputEOS && !outQueue.empty()) {
+        BufferInfo *outInfo = *outQueue.begin();
+        OMX_BUFFERHEADERTYPE *outHeader = outInfo->mHeader;
+
+        outHeader->nTimeStamp = mPrevTimestampUs;
+        outHeader->nFlags = 0;
+        outHeader->nOffset = 0;
+        outHeader->nFilledLen = 0;
+
+        uint32_t dataLength = 0;
+        if (!mInputBufferInfoVec.empty()) {
+            int32_t type;
+            AVCEnc_Status encoderStatus = PVAVCEncSetInput(mHandle, NULL);
+            if (encoderStatus == AVCENC_NEW_IDR) {
+                outHeader->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
+            } else if (encoderStatus != AVCENC_SUCCESS) {
+                ALOGE("encoderStatus = %d at line %d", encoderStatus, __LINE__);
+                mSignalledError = true;
+                notify(OMX_EventError, OMX_ErrorUndefined, 0, 0);
+                return;
+            }
+
+            dataLength = outHeader->nAllocLen;
+            encoderStatus = PVAVCEncodeNAL(
+                    mHandle, (uint8_t *) outHeader->pBuffer, &dataLength, &type);
+            if (encoderStatus != AVCENC_PICTURE_READY) {
+                ALOGE("encoderStatus = %d at line %d", encoderStatus, __LINE__);
+                mSignalledError = true;
+                notify(OMX_EventError, OMX_ErrorUndefined, 0, 0);
+                return;
+            }
+            CHECK(NULL == PVAVCEncGetOverrunBuffer(mHandle));
+
+            AVCFrameIO recon;
+            if (PVAVCEncGetRecon(mHandle, &recon) == AVCENC_SUCCESS) {
+                PVAVCEncReleaseRecon(mHandle, &recon);
+            }
+
+            InputBufferInfo *inputBufInfo = mInputBufferInfoVec.begin();
+            outHeader->nTimeStamp = inputBufInfo->mTimeUs;
+            outHeader->nFlags |= (inputBufInfo->mFlags | OMX_BUFFERFLAG_ENDOFFRAME);
+            mInputBufferInfoVec.erase(mInputBufferInfoVec.begin());
+        }
+
+        if (mInputBufferInfoVec.empty()) {
+            outHeader->nFlags |= OMX_BUFFERFLAG_EOS;
+            mSignalledOutputEOS = true;
+        }
+
+        outQueue.erase(outQueue.begin());
+        outHeader->nFilledLen = dataLength;
+        outInfo->mOwnedByUs = false;
+        notifyFillBufferDone(outHeader);
+    }
 }
 
 int32_t SoftAVCEncoder::allocOutputBuffers(
@@ -956,6 +1114,10 @@ OMX_ERRORTYPE SoftAVCEncoder::getExtensionIndex(
         *(int32_t*)index = kStoreMetaDataExtensionIndex;
         return OMX_ErrorNone;
     }
+    if (!strcmp(name, "OMX.google.android.index.rateControlLookahead")) {
+        *(int32_t*)index = kRateControlLookaheadExtensionIndex;
+        return OMX_ErrorNone;
+    }
     return OMX_ErrorUndefined;
 }
 
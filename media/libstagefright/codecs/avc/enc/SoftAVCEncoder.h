@@ -44,6 +44,7 @@ struct SoftAVCEncoder : public MediaBufferObserver,
             OMX_INDEXTYPE index, const OMX_PTR params);
 
     virtual void onQueueFilled(OMX_U32 portIndex);
+    virtual void onReset();
 
     // Override SoftOMXComponent methods
 
@@ -68,7 +69,8 @@ private:
     };
 
     enum {
-        kStoreMetaDataExtensionIndex = OMX_IndexVendorStartUnused + 1
+        kStoreMetaDataExtensionIndex = OMX_IndexVendorStartUnused + 1,
+        kRateControlLookaheadExtensionIndex
     };
 
     // OMX input buffer's timestamp and flags
@@ -86,6 +88,10 @@ private:
     int32_t  mIDRFrameRefreshIntervalInSec;
     AVCProfile mAVCEncProfile;
     AVCLevel   mAVCEncLevel;
+    bool     mRCLookahead;
+    int32_t  mRCLookaheadFrames;
+    int32_t  mVBVSizeMs;
+    bool     mAdaptiveQuant;
 
     int64_t  mNumInputFrames;
     int64_t  mPrevTimestampUs;
@@ -93,6 +99,7 @@ private:
     bool     mSpsPpsHeaderReceived;
     bool     mReadyForNextFrame;
     bool     mSawInputEOS;
+    bool     mSignalledOutputEOS;
     bool     mSignalledError;
     bool     mIsIDRFrame;
 
@@ -211,6 +211,11 @@ OSCL_EXPORT_REF AVCEnc_Status PVAVCEncInitialize(AVCHandle *avcHandle, AVCEncPar
         return AVCENC_MEMORY_FAIL;
     }
 
+    if (AVCENC_SUCCESS != InitMotionSearchThreads(avcHandle, encParam->num_threads))
+    {
+        return AVCENC_MEMORY_FAIL;
+    }
+
     /* intialize function pointers */
     encvid->functionPointer = (AVCEncFuncPtr*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCEncFuncPtr), DEFAULT_ATTR);
     if (encvid->functionPointer == NULL)
@@ -281,6 +286,7 @@ OSCL_EXPORT_REF AVCEnc_Status PVAVCEncSetInput(AVCHandle *avcHandle, AVCFrameIO
 
     AVCEnc_Status status;
     uint frameNum;
+    bool queued;
 
     if (encvid == NULL)
     {
@@ -296,11 +302,26 @@ OSCL_EXPORT_REF AVCEnc_Status PVAVCEncSetInput(AVCHandle *avcHandle, AVCFrameIO
         return AVCENC_FAIL;
     }
 
-    if (input->pitch > 0xFFFF)
+    if (input != NULL && input->pitch > 0xFFFF)
     {
         return AVCENC_NOT_SUPPORTED; // we use 2-bytes for pitch
     }
 
+    /* with the lookahead rate control, encode the oldest queued frame */
+    if (encvid->lookahead)
+    {
+        queued = (input != NULL);
+        input = LookaheadAddFrame(encvid, input);
+        if (input == NULL)
+        {
+            return queued ? AVCENC_PICTURE_QUEUED : AVCENC_NO_PICTURE;
+        }
+    }
+    else if (input == NULL)
+    {
+        return AVCENC_NO_PICTURE;
+    }
+
     /***********************************/
 
     /* Let's rate control decide whether to encode this frame or not */
@@ -596,6 +617,8 @@ OSCL_EXPORT_REF void    PVAVCCleanUpEncoder(AVCHandle *avcHandle)
 
     if (encvid != NULL)
     {
+        CleanMotionSearchThreads(avcHandle);
+
         CleanMotionSearchModule(avcHandle);
 
         CleanupRateControlModule(avcHandle);
@@ -81,11 +81,14 @@ typedef enum
     AVCENC_SUCCESS = AVC_SUCCESS,
     AVCENC_PICTURE_READY = 2,
     AVCENC_NEW_IDR = 3, /* upon getting this, users have to call PVAVCEncodeSPS and PVAVCEncodePPS to get a new SPS and PPS*/
-    AVCENC_SKIPPED_PICTURE = 4 /* continuable error message */
+    AVCENC_SKIPPED_PICTURE = 4, /* continuable error message */
+    AVCENC_PICTURE_QUEUED = 5, /* input frame kept for the lookahead, there is nothing to encode yet */
+    AVCENC_NO_PICTURE = 6 /* no queued input frame left to encode */
 
 } AVCEnc_Status;
 
 #define MAX_NUM_SLICE_GROUP  8      /* maximum for all the profiles */
+#define MAX_LOOKAHEAD_DEPTH  16     /* maximum number of frames queued for the lookahead rate control */
 
 /**
 This structure contains the encoding parameters.
@@ -151,6 +154,15 @@ typedef struct tagAVCEncParam
     uint32 CPB_size;  /* coded picture buffer in number of bits */
     uint32 init_CBP_removal_delay; /* initial CBP removal delay in msec */
 
+    AVCFlag lookahead_rc; /* use the lookahead rate control instead of the default one. It chooses the
+                          frame QP from the estimated cost of the current and the queued frames and
+                          keeps the CPB_size buffer from underflowing, frames are only skipped with
+                          the QP at its maximum. With auto_scd, the scene changes are detected on
+                          the queued frames instead of during the motion estimation. */
+    int lookahead_depth; /* number of frames queued ahead of the encoded frame for lookahead_rc,
+                         0 for no delay. At most MAX_LOOKAHEAD_DEPTH, see PVAVCEncSetInput. */
+    AVCFlag adaptive_quant; /* adapt the QP of each MB to its activity, lower QP for flat MBs */
+
     uint32 frame_rate;  /* frame rate in the unit of frames per 1000 second */
     /* note, frame rate is only needed by the rate control, AVC is timestamp agnostic. */
 
@@ -158,6 +170,9 @@ typedef struct tagAVCEncParam
 
     AVCFlag use_overrun_buffer;  /* do not throw away the frame if output buffer is not big enough.
                                     copy excess bits to the overrun buffer */
+
+    int num_threads;    /* number of threads for motion estimation, including the calling thread.
+                        0 or 1 for single-threaded encoding. The bitstream is the same either way. */
 } AVCEncParams;
 
 
@@ -217,14 +232,21 @@ extern "C"
     calling PVAVCEncodeSlice. The encoder library will encode them according to the frame_num order.
     Users should not modify the content of a particular frame until this frame is encoded and
     returned thru CBAVCEnc_ReturnInput() callback function.
+    With lookahead_depth > 0, the encoder copies the input frame into its queue and encodes
+    the oldest queued frame instead, once lookahead_depth frames are queued ahead of it.
+    Until then it returns AVCENC_PICTURE_QUEUED and PVAVCEncodeNAL must not be called.
+    At the end of the input, users call this function with a NULL input to encode the queued
+    frames one by one until it returns AVCENC_NO_PICTURE.
     \param "avcHandle"  "Handle to the AVC encoder library object."
-    \param "input"      "Pointer to the input structure."
+    \param "input"      "Pointer to the input structure, NULL to flush the lookahead queue."
     \return "AVCENC_SUCCESS for success,
             AVCENC_FAIL if the encoder is not in the right state to take a new input frame.
             AVCENC_NEW_IDR for the detection or determination of a new IDR, with this status,
             the returned NAL is an SPS NAL,
-            AVCENC_NO_PICTURE if the input frame coding timestamp is too early, users must
-            get next frame or adjust the coding timestamp."
+            AVCENC_SKIPPED_PICTURE if the input frame coding timestamp is too early, users must
+            get next frame or adjust the coding timestamp,
+            AVCENC_PICTURE_QUEUED if the input frame has been queued for the lookahead,
+            AVCENC_NO_PICTURE if the input is NULL and no queued frame is left."
     */
     OSCL_IMPORT_REF AVCEnc_Status PVAVCEncSetInput(AVCHandle *avcHandle, AVCFrameIO *input);
 
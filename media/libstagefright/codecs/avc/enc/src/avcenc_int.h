@@ -31,6 +31,8 @@ and necessary type defitionitions and enumerations.
 #include "avcenc_api.h"
 #endif
 
+#include <pthread.h>
+
 typedef float OsclFloat;
 
 /* Definition for the structures below */
@@ -38,6 +40,7 @@ typedef float OsclFloat;
 #define MAX_INPUT_FRAME 30 /* some arbitrary number, it can be much higher than this. */
 #define MAX_REF_FRAME  16 /* max size of the RefPicList0 and RefPicList1 */
 #define MAX_REF_PIC_LIST 33
+#define MAX_ME_THREADS 8 /* max number of motion estimation threads */
 
 #define MIN_QP          0
 #define MAX_QP          51
@@ -316,6 +319,22 @@ typedef struct tagAVCRateControl
     int     VBV_fullness_offset;    /* offset of VBV_fullness, usually is zero, but can be changed in H.263 mode*/
     /* End BX */
 
+    /* lookahead rate control, see lookahead.cpp */
+    uint    laEnable;       /* lookahead rate control, only with rcEnable */
+    int     laDepth;        /* number of frames queued ahead of the encoded frame */
+    int     laFrameInc;     /* number of frame intervals since the previous encoded frame */
+    int     laFramesSinceIDR; /* number of frames encoded since the last IDR */
+    OsclFloat laPredCoef[2];  /* decayed sum of bits * Qstep / cost of P [0] and I [1] frames */
+    OsclFloat laPredCount[2]; /* decayed number of samples in laPredCoef */
+    OsclFloat laQstep;        /* Qstep of the current frame */
+    double  vbvBuffer;      /* decoder buffer fullness in bits before the current frame is removed */
+    double  wantedBits;     /* bits the target bit rate allows so far */
+    double  actualBits;     /* bits actually spent so far */
+
+    /* adaptive quantization */
+    uint    aqEnable;
+    int     *aqQP;          /* QP of each MB for the current frame */
+
 } AVCRateControl;
 
 
@@ -362,6 +381,89 @@ typedef struct tagHTFM_Stat
 #endif
 
 
+/**
+This structure contains the state of one motion estimation thread. Every thread searches
+with its own copy of the encoder and common objects so that the scratch memory (currYMB,
+subpel_pred, qpel_cand) and the current MB are not shared. The encoding thread is worker 0
+and uses the main objects.
+*/
+typedef struct tagMEWorker
+{
+    struct tagMEThreads *threads;
+    struct tagEncObject *encvid; /* private copy of the encoder object */
+    AVCCommonObj *video;        /* private copy of the common object */
+    pthread_t thread;
+
+    int totalSAD;       /* sum of MB SADs of the rows searched by this thread */
+    int NumIntraSearch; /* number of MBs to be intra searched in these rows */
+} AVCMEWorker;
+
+/**
+This structure contains the state shared by the motion estimation threads. MB rows are
+handed out top to bottom. Before searching a MB, a thread waits until the row above has
+finished the MB to the upper right, since candidate selection uses the MVs of the
+neighboring MBs. The resulting MVs are the same as for the single-threaded search.
+*/
+typedef struct tagMEThreads
+{
+    int numThreads;         /* number of threads including the encoding thread */
+    AVCMEWorker *worker;    /* array of numThreads workers */
+
+    pthread_mutex_t lock;
+    pthread_cond_t startCond;    /* a new pass has been started or the threads shall exit */
+    pthread_cond_t doneCond;     /* all workers have finished the current pass */
+    pthread_cond_t progressCond; /* a MB row has made progress */
+
+    /* protected by lock */
+    int quit;
+    int passId;         /* incremented for every pass */
+    int numBusy;        /* number of workers still busy with the current pass */
+    int numWaiting;     /* number of threads waiting for progressCond */
+    int nextRow;        /* next MB row to be handed out */
+    int *rowProgress;   /* per MB row, all MBs left of this column are done */
+
+    /* current pass, see AVCMotionEstimation */
+    int incr_i;
+    int type_pred;
+} AVCMEThreads;
+
+
+/**
+This structure contains one input frame queued for the lookahead rate control together
+with its estimated cost, see lookahead.cpp.
+*/
+typedef struct tagLookaheadFrame
+{
+    AVCFrameIO input;   /* the input frame, YCbCr points to buffer if the frame is queued */
+    uint8 *buffer;      /* copy of the input frame, NULL without delay */
+    int32 cost;         /* estimated cost as a P frame */
+    int32 intraCost;    /* estimated cost as an I frame */
+    int sceneCut;       /* the frame starts a new scene and is coded as an I frame */
+} AVCLookaheadFrame;
+
+/**
+This structure contains the lookahead queue. It is a ring of depth+1 frames, the frame
+being encoded is taken out of the ring and its slot is only reused by the next input.
+*/
+typedef struct tagLookahead
+{
+    int depth;
+    AVCLookaheadFrame *frame;
+    int head;           /* oldest queued frame */
+    int count;          /* number of queued frames */
+    AVCLookaheadFrame *curr; /* frame being encoded */
+
+    uint8 *lowres[2];   /* half resolution luma of the last two input frames */
+    int lowresIdx;      /* lowres[lowresIdx] is the latest one */
+    int lowresWidth;
+    int lowresHeight;
+    int numAnalyzed;    /* number of frames analyzed so far */
+    AVCMV *lowresMV;    /* MVs of the last analyzed frame, in lowres pixels */
+    int32 prevCost;     /* cost of the last analyzed frame */
+    int framesSinceCut; /* number of frames analyzed since the last scene cut */
+} AVCLookahead;
+
+
 /**
 This structure is the main object for AVC encoder library providing access to all
 global variables. It is allocated at PVAVCInitEncoder and freed at PVAVCCleanUpEncoder.
@@ -440,6 +542,8 @@ typedef struct tagEncObject
 
     /* encoding complexity control */
     uint fullsearch_enable; /* flag to enable full-pel full-search */
+    AVCMEThreads *meThreads; /* motion estimation threads, NULL if single-threaded */
+    AVCLookahead *lookahead; /* lookahead queue, NULL without lookahead rate control */
 
     /* misc.*/
     bool outOfBandParamSet; /* flag to enable out-of-band param set */
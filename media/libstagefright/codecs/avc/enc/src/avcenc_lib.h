@@ -398,6 +398,39 @@ extern "C"
 
     int SATDChroma(uint8 *orgCb, uint8 *orgCr, int org_pitch, uint8 *pred, int mincost);
 
+    /*-------------- lookahead.c ---------------*/
+
+    /**
+    Allocate the lookahead queue for the lookahead rate control.
+    \param "avcHandle" "Pointer to AVCHandle."
+    \param "depth" "Number of frames queued ahead of the encoded frame, 0 for no delay."
+    \return "AVCENC_SUCCESS or AVCENC_MEMORY_FAIL."
+    */
+    AVCEnc_Status InitLookahead(AVCHandle *avcHandle, int depth);
+
+    /**
+    Free the memory allocated in InitLookahead.
+    \param "avcHandle" "Pointer to AVCHandle."
+    \return "void."
+    */
+    void CleanupLookahead(AVCHandle *avcHandle);
+
+    /**
+    Estimate the cost of an input frame and add it to the lookahead queue.
+    \param "encvid" "Pointer to AVCEncObject."
+    \param "input" "Pointer to the input frame, NULL to flush the queue."
+    \return "The frame to be encoded next, NULL if there is none yet."
+    */
+    AVCFrameIO* LookaheadAddFrame(AVCEncObject *encvid, AVCFrameIO *input);
+
+    /**
+    Access the frames queued after the one being encoded.
+    \param "la" "Pointer to AVCLookahead."
+    \param "i" "Index in the queue, smaller than la->count."
+    \return "Pointer to the queued frame."
+    */
+    AVCLookaheadFrame* LookaheadGetQueued(AVCLookahead *la, int i);
+
     /*-------------- motion_comp.c ---------------*/
 
     /**
@@ -494,6 +527,13 @@ extern "C"
     */
     void CleanMotionSearchModule(AVCHandle *avcHandle);
 
+    /**
+    Set up the pointers to the half-pel and quarter-pel candidates in subpel_pred.
+    \param "encvid" "Pointer to AVCEncObject."
+    \return "void."
+    */
+    void InitSubPelCand(AVCEncObject *encvid);
+
 
     /**
     This function performs motion estimation of all macroblocks in a frame during the InitFrame.
@@ -504,6 +544,20 @@ extern "C"
     */
     void AVCMotionEstimation(AVCEncObject *encvid);
 
+    /**
+    This function performs motion estimation of one macroblock and decides whether it has
+    to be intra searched in the encoding loop.
+    \param "encvid" "Pointer to AVCEncObject."
+    \param "i"      "The MB index x-coordinate."
+    \param "j"      "The MB index y-coordinate."
+    \param "type_pred" "Type of the candidate selection."
+    \param "totalSAD"  "Pointer to the sum of SADs, accumulated for rate control."
+    \param "NumIntraSearch" "Pointer to the number of MBs to be intra searched, accumulated."
+    \return "void"
+    */
+    void AVCMBMotionEstimation(AVCEncObject *encvid, int i, int j, int type_pred,
+                               int *totalSAD, int *NumIntraSearch);
+
     /**
     This function performs repetitive edge padding to the reference picture by adding 16 pixels
     around the luma and 8 pixels around the chromas.
@@ -604,6 +658,37 @@ extern "C"
     int AVCFindMin(int dn[]);
 
 
+    /*-------------- motion_est_thread.c ---------------*/
+
+    /**
+    Start the motion estimation threads, nothing is done for less than two threads.
+    \param "avcHandle" "Pointer to AVCHandle."
+    \param "numThreads" "Number of threads including the encoding thread."
+    \return "AVCENC_SUCCESS or AVCENC_MEMORY_FAIL."
+    */
+    AVCEnc_Status InitMotionSearchThreads(AVCHandle *avcHandle, int numThreads);
+
+    /**
+    Stop the motion estimation threads and free the memory allocated in
+    InitMotionSearchThreads.
+    \param "avcHandle" "Pointer to AVCHandle."
+    \return "void."
+    */
+    void CleanMotionSearchThreads(AVCHandle *avcHandle);
+
+    /**
+    Perform one pass of the motion estimation of a frame on all threads, see
+    AVCMotionEstimation for the parameters of the pass.
+    \param "encvid" "Pointer to AVCEncObject."
+    \param "incr_i" "1 to search all MBs, 2 to search every other MB."
+    \param "type_pred" "Type of the candidate selection."
+    \param "totalSAD"  "Pointer to the sum of SADs, accumulated for rate control."
+    \param "NumIntraSearch" "Pointer to the number of MBs to be intra searched, accumulated."
+    \return "void."
+    */
+    void AVCMotionEstimationThreads(AVCEncObject *encvid, int incr_i, int type_pred,
+                                    int *totalSAD, int *NumIntraSearch);
+
     /*------------- findhalfpel.c -------------------*/
 
     /**
@@ -16,6 +16,10 @@
  * -------------------------------------------------------------------
  */
 #include "avcenc_lib.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 /* 3/29/01 fast half-pel search based on neighboring guess */
 /* value ranging from 0 to 4, high complexity (more accurate) to
    low complexity (less accurate) */
@@ -515,6 +519,79 @@ void VertInterpWClip(uint8 *dst, uint8 *ref)
 }
 
 
+#if defined(__SSE2__) /* x86 SSE2 version, one row of all eight candidates at a time */
+
+#define LOADU(p)        _mm_loadu_si128((__m128i*)(p))
+#define STOREU(p, x)    _mm_storeu_si128((__m128i*)(p), x)
+
+void GenerateQuartPelPred(uint8 **bilin_base, uint8 *qpel_cand, int hpel_pos)
+{
+    uint8 *c1 = qpel_cand;
+    uint8 *tl = bilin_base[0];
+    uint8 *tr = bilin_base[1];
+    uint8 *bl = bilin_base[2];
+    uint8 *br = bilin_base[3];
+    __m128i a, b, c, d, e;
+    int j;
+
+    if (!(hpel_pos&1)) // diamond pattern
+    {
+        for (j = 16; j > 0; j--)
+        {
+            a = LOADU(tr);
+            b = LOADU(bl + 1);
+            c = LOADU(br);
+            d = LOADU(tr + 24);
+            e = LOADU(bl);
+
+            STOREU(c1, _mm_avg_epu8(c, a));
+            STOREU(c1 + 384, _mm_avg_epu8(b, a));
+            STOREU(c1 + 384 * 2, _mm_avg_epu8(b, c));
+            STOREU(c1 + 384 * 3, _mm_avg_epu8(b, d));
+            STOREU(c1 + 384 * 4, _mm_avg_epu8(c, d));
+            STOREU(c1 + 384 * 5, _mm_avg_epu8(e, d));
+            STOREU(c1 + 384 * 6, _mm_avg_epu8(e, c));
+            STOREU(c1 + 384 * 7, _mm_avg_epu8(e, a));
+
+            // advance to the next line, pitch is 24
+            tr += 24;
+            bl += 24;
+            br += 24;
+            c1 += 24;
+        }
+    }
+    else // star pattern
+    {
+        for (j = 16; j > 0; j--)
+        {
+            a = LOADU(br);
+
+            STOREU(c1, _mm_avg_epu8(a, LOADU(tr)));
+            STOREU(c1 + 384, _mm_avg_epu8(a, LOADU(tl + 1)));
+            STOREU(c1 + 384 * 2, _mm_avg_epu8(a, LOADU(bl + 1)));
+            STOREU(c1 + 384 * 3, _mm_avg_epu8(a, LOADU(tl + 25)));
+            STOREU(c1 + 384 * 4, _mm_avg_epu8(a, LOADU(tr + 24)));
+            STOREU(c1 + 384 * 5, _mm_avg_epu8(a, LOADU(tl + 24)));
+            STOREU(c1 + 384 * 6, _mm_avg_epu8(a, LOADU(bl)));
+            STOREU(c1 + 384 * 7, _mm_avg_epu8(a, LOADU(tl)));
+
+            // advance to the next line, pitch is 24
+            tl += 24;
+            tr += 24;
+            bl += 24;
+            br += 24;
+            c1 += 24;
+        }
+    }
+
+    return ;
+}
+
+#undef LOADU
+#undef STOREU
+
+#else /* Generic C version */
+
 void GenerateQuartPelPred(uint8 **bilin_base, uint8 *qpel_cand, int hpel_pos)
 {
     // for even value of hpel_pos, start with pattern 1, otherwise, start with pattern 2
@@ -603,6 +680,7 @@ void GenerateQuartPelPred(uint8 **bilin_base, uint8 *qpel_cand, int hpel_pos)
     return ;
 }
 
+#endif /* __SSE2__ */
 
 /* assuming cand always has a pitch of 24 */
 int SATD_MB(uint8 *cand, uint8 *cur, int dmin)
@@ -518,7 +518,11 @@ AVCEnc_Status  SetEncodeParam(AVCHandle* avcHandle, AVCEncParams* encParam,
 
     rateCtrl->bitRate = encParam->bitrate;
     rateCtrl->cpbSize = encParam->CPB_size;
-    rateCtrl->initDelayOffset = (rateCtrl->bitRate * encParam->init_CBP_removal_delay / 1000);
+    rateCtrl->initDelayOffset = (int32)((double)rateCtrl->bitRate * encParam->init_CBP_removal_delay / 1000);
+
+    rateCtrl->laEnable = (rateCtrl->rcEnable == TRUE && encParam->lookahead_rc == AVC_ON) ? TRUE : FALSE;
+    rateCtrl->laDepth = AVC_CLIP3(0, MAX_LOOKAHEAD_DEPTH, encParam->lookahead_depth);
+    rateCtrl->aqEnable = (encParam->adaptive_quant == AVC_ON) ? TRUE : FALSE;
 
     if (encParam->frame_rate == 0)
     {
@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "avcenc_lib.h"
+
+/* The cost of a frame is estimated on a half resolution copy of the luma, every MB is
+   an 8x8 block there. The intra cost of a block is its mean absolute deviation, the
+   inter cost the SAD of a small search in the previous frame. */
+#define LA_SEARCH_RANGE 2   /* full search range around the best predictor, in lowres pixels */
+#define LA_MB_OVERHEAD  4   /* added to the cost of every MB for the header bits */
+
+/* A frame starts a new scene if inter prediction hardly saves anything over intra and
+   its cost jumped compared to the previous frame. Content with a lot of motion all along
+   only passes the first test, its frames stay P frames. Scene cuts are at least
+   LA_MIN_SCENECUT_DIST frames apart. */
+#define LA_SCENECUT         0.7     /* cost over intra cost */
+#define LA_SCENECUT_JUMP    1.5     /* cost over the cost of the previous frame */
+#define LA_MIN_SCENECUT_DIST 15
+
+static void LookaheadAnalyze(AVCEncObject *encvid, AVCLookahead *la, AVCLookaheadFrame *frame);
+static int LowresSAD(uint8 *cur, uint8 *ref, int pitch, int dmin);
+
+/* Allocate the queue of depth+1 frames and the lowres buffers */
+AVCEnc_Status InitLookahead(AVCHandle *avcHandle, int depth)
+{
+    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
+    AVCCommonObj *video = encvid->common;
+    void *userData = avcHandle->userData;
+    AVCLookahead *la;
+    int width = video->PicWidthInSamplesL;
+    int height = video->PicHeightInSamplesL;
+    int k;
+
+    la = (AVCLookahead*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCLookahead), DEFAULT_ATTR);
+    if (la == NULL)
+    {
+        return AVCENC_MEMORY_FAIL;
+    }
+    memset(la, 0, sizeof(AVCLookahead));
+    encvid->lookahead = la;
+
+    la->depth = depth;
+    la->lowresWidth = width >> 1;
+    la->lowresHeight = height >> 1;
+
+    la->frame = (AVCLookaheadFrame*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCLookaheadFrame) * (depth + 1), DEFAULT_ATTR);
+    if (la->frame == NULL)
+    {
+        return AVCENC_MEMORY_FAIL;
+    }
+    memset(la->frame, 0, sizeof(AVCLookaheadFrame) * (depth + 1));
+
+    /* without delay, the frame is encoded from the user's buffer */
+    if (depth > 0)
+    {
+        for (k = 0; k <= depth; k++)
+        {
+            la->frame[k].buffer = (uint8*) avcHandle->CBAVC_Malloc(userData, (width * height * 3) >> 1, DEFAULT_ATTR);
+            if (la->frame[k].buffer == NULL)
+            {
+                return AVCENC_MEMORY_FAIL;
+            }
+        }
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        la->lowres[k] = (uint8*) avcHandle->CBAVC_Malloc(userData, la->lowresWidth * la->lowresHeight, DEFAULT_ATTR);
+        if (la->lowres[k] == NULL)
+        {
+            return AVCENC_MEMORY_FAIL;
+        }
+    }
+
+    la->lowresMV = (AVCMV*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCMV) * video->PicSizeInMbs, DEFAULT_ATTR);
+    if (la->lowresMV == NULL)
+    {
+        return AVCENC_MEMORY_FAIL;
+    }
+
+    return AVCENC_SUCCESS;
+}
+
+void CleanupLookahead(AVCHandle *avcHandle)
+{
+    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
+    AVCLookahead *la = encvid->lookahead;
+    void *userData = avcHandle->userData;
+    int k;
+
+    if (la == NULL)
+    {
+        return ;
+    }
+
+    if (la->frame)
+    {
+        for (k = 0; k <= la->depth; k++)
+        {
+            if (la->frame[k].buffer)
+            {
+                avcHandle->CBAVC_Free(userData, la->frame[k].buffer);
+            }
+        }
+        avcHandle->CBAVC_Free(userData, la->frame);
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        if (la->lowres[k])
+        {
+            avcHandle->CBAVC_Free(userData, la->lowres[k]);
+        }
+    }
+
+    if (la->lowresMV)
+    {
+        avcHandle->CBAVC_Free(userData, la->lowresMV);
+    }
+
+    avcHandle->CBAVC_Free(userData, la);
+    encvid->lookahead = NULL;
+
+    return ;
+}
+
+/* Analyze and queue the input, NULL to flush. Returns the frame to be encoded next,
+   or NULL if the queue is still filling up or, when flushing, empty. */
+AVCFrameIO* LookaheadAddFrame(AVCEncObject *encvid, AVCFrameIO *input)
+{
+    AVCCommonObj *video = encvid->common;
+    AVCLookahead *la = encvid->lookahead;
+    AVCLookaheadFrame *frame;
+    int width = video->PicWidthInSamplesL;
+    int height = video->PicHeightInSamplesL;
+    uint8 *src, *dst;
+    int j;
+
+    if (la->depth == 0)
+    {
+        if (input == NULL)
+        {
+            return NULL;
+        }
+
+        la->curr = &la->frame[0];
+        la->curr->input = *input;
+        LookaheadAnalyze(encvid, la, la->curr);
+
+        return input;
+    }
+
+    if (input != NULL)
+    {
+        /* the slot of the previously encoded frame is free again by now */
+        frame = &la->frame[(la->head + la->count) % (la->depth + 1)];
+
+        frame->input = *input;
+        frame->input.pitch = width;
+        frame->input.height = height;
+        frame->input.YCbCr[0] = frame->buffer;
+        frame->input.YCbCr[1] = frame->buffer + width * height;
+        frame->input.YCbCr[2] = frame->input.YCbCr[1] + ((width * height) >> 2);
+
+        src = input->YCbCr[0];
+        dst = frame->input.YCbCr[0];
+        for (j = 0; j < height; j++)
+        {
+            memcpy(dst, src, width);
+            src += input->pitch;
+            dst += width;
+        }
+
+        src = input->YCbCr[1];
+        dst = frame->input.YCbCr[1];
+        for (j = 0; j < (height >> 1); j++)
+        {
+            memcpy(dst, src, width >> 1);
+            src += (input->pitch >> 1);
+            dst += (width >> 1);
+        }
+
+        src = input->YCbCr[2];
+        dst = frame->input.YCbCr[2];
+        for (j = 0; j < (height >> 1); j++)
+        {
+            memcpy(dst, src, width >> 1);
+            src += (input->pitch >> 1);
+            dst += (width >> 1);
+        }
+
+        LookaheadAnalyze(encvid, la, frame);
+
+        la->count++;
+        if (la->count <= la->depth)
+        {
+            return NULL;
+        }
+    }
+    else if (la->count == 0)
+    {
+        return NULL;
+    }
+
+    la->curr = &la->frame[la->head];
+    la->head = (la->head + 1) % (la->depth + 1);
+    la->count--;
+
+    return &la->curr->input;
+}
+
+/* Returns the i-th frame queued after the one being encoded */
+AVCLookaheadFrame* LookaheadGetQueued(AVCLookahead *la, int i)
+{
+    return &la->frame[(la->head + i) % (la->depth + 1)];
+}
+
+/* Estimate the intra and inter cost of a frame against the previously analyzed one */
+static void LookaheadAnalyze(AVCEncObject *encvid, AVCLookahead *la, AVCLookaheadFrame *frame)
+{
+    AVCCommonObj *video = encvid->common;
+    int lw = la->lowresWidth;
+    int lh = la->lowresHeight;
+    int mbwidth = video->PicWidthInMbs;
+    int mbheight = video->PicHeightInMbs;
+    int pitch = frame->input.pitch;
+    uint8 *org = frame->input.YCbCr[0];
+    uint8 *cur, *ref, *blk, *src0, *src1, *dst;
+    AVCMV *mv = la->lowresMV;
+    int i, j, k, l, x, y, mbnum;
+    int sum, mean, intra, inter, sad, bestx, besty, cx, cy;
+    int candx[3], candy[3];
+    int32 cost = 0, intraCost = 0;
+
+    la->lowresIdx ^= 1;
+    cur = la->lowres[la->lowresIdx];
+    ref = la->lowres[la->lowresIdx ^ 1];
+
+    /* downscale the luma by two in both directions */
+    dst = cur;
+    for (j = 0; j < lh; j++)
+    {
+        src0 = org + (j << 1) * pitch;
+        src1 = src0 + pitch;
+        for (i = 0; i < lw; i++)
+        {
+            *dst++ = (src0[0] + src0[1] + src1[0] + src1[1] + 2) >> 2;
+            src0 += 2;
+            src1 += 2;
+        }
+    }
+
+    for (j = 0; j < mbheight; j++)
+    {
+        for (i = 0; i < mbwidth; i++)
+        {
+            mbnum = j * mbwidth + i;
+            x = i << 3;
+            y = j << 3;
+            blk = cur + y * lw + x;
+
+            /* intra cost, deviation from the block mean */
+            sum = 0;
+            for (l = 0; l < 8; l++)
+            {
+                for (k = 0; k < 8; k++)
+                {
+                    sum += blk[l * lw + k];
+                }
+            }
+            mean = (sum + 32) >> 6;
+
+            intra = 0;
+            for (l = 0; l < 8; l++)
+            {
+                for (k = 0; k < 8; k++)
+                {
+                    intra += AVC_ABS(blk[l * lw + k] - mean);
+                }
+            }
+
+            intra += LA_MB_OVERHEAD;
+            intraCost += intra;
+
+            if (la->numAnalyzed == 0)
+            {
+                mv[mbnum].x = mv[mbnum].y = 0;
+                cost += intra;
+                continue;
+            }
+
+            /* inter cost, best of zero, left and top MV refined by a small full search */
+            candx[0] = candy[0] = 0;
+            candx[1] = (i > 0) ? mv[mbnum - 1].x : 0;
+            candy[1] = (i > 0) ? mv[mbnum - 1].y : 0;
+            candx[2] = (j > 0) ? mv[mbnum - mbwidth].x : 0;
+            candy[2] = (j > 0) ? mv[mbnum - mbwidth].y : 0;
+
+            inter = 65536;
+            bestx = besty = 0;
+            for (k = 0; k < 3; k++)
+            {
+                cx = AVC_CLIP3(-x, lw - 8 - x, candx[k]);
+                cy = AVC_CLIP3(-y, lh - 8 - y, candy[k]);
+                sad = LowresSAD(blk, ref + (y + cy) * lw + x + cx, lw, inter);
+                if (sad < inter)
+                {
+                    inter = sad;
+                    bestx = cx;
+                    besty = cy;
+                }
+            }
+
+            cx = bestx;
+            cy = besty;
+            for (l = cy - LA_SEARCH_RANGE; l <= cy + LA_SEARCH_RANGE; l++)
+            {
+                if (y + l < 0 || y + l > lh - 8)
+                {
+                    continue;
+                }
+                for (k = cx - LA_SEARCH_RANGE; k <= cx + LA_SEARCH_RANGE; k++)
+                {
+                    if (x + k < 0 || x + k > lw - 8)
+                    {
+                        continue;
+                    }
+                    sad = LowresSAD(blk, ref + (y + l) * lw + x + k, lw, inter);
+                    if (sad < inter)
+                    {
+                        inter = sad;
+                        bestx = k;
+                        besty = l;
+                    }
+                }
+            }
+
+            mv[mbnum].x = bestx;
+            mv[mbnum].y = besty;
+
+            inter += LA_MB_OVERHEAD;
+            cost += AVC_MIN(intra, inter);
+        }
+    }
+
+    frame->cost = cost;
+    frame->intraCost = intraCost;
+
+    frame->sceneCut = (la->numAnalyzed > 0 &&
+                       la->framesSinceCut >= LA_MIN_SCENECUT_DIST &&
+                       cost > intraCost * LA_SCENECUT &&
+                       cost > la->prevCost * LA_SCENECUT_JUMP);
+
+    if (la->numAnalyzed == 0 || frame->sceneCut)
+    {
+        la->framesSinceCut = 0;
+    }
+    else
+    {
+        la->framesSinceCut++;
+    }
+    la->prevCost = cost;
+
+    la->numAnalyzed++;
+
+    return ;
+}
+
+/* SAD of an 8x8 block, stops after the row where it exceeds dmin */
+static int LowresSAD(uint8 *cur, uint8 *ref, int pitch, int dmin)
+{
+    int sad = 0;
+    int k, l;
+
+    for (l = 0; l < 8; l++)
+    {
+        for (k = 0; k < 8; k++)
+        {
+            sad += AVC_ABS(cur[k] - ref[k]);
+        }
+        if (sad > dmin)
+        {
+            break;
+        }
+        cur += pitch;
+        ref += pitch;
+    }
+
+    return sad;
+}
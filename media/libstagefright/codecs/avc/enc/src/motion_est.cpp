@@ -75,7 +75,6 @@ AVCEnc_Status InitMotionSearchModule(AVCHandle *avcHandle)
     int temp_bits = 0;
     uint8 *mvbits;
     int bits, imax, imin, i;
-    uint8* subpel_pred = (uint8*) encvid->subpel_pred; // all 16 sub-pel positions
 
 
     while (number_of_subpel_positions > 0)
@@ -106,7 +105,30 @@ AVCEnc_Status InitMotionSearchModule(AVCHandle *avcHandle)
         for (i = imin; i < imax; i++)   mvbits[-i] = mvbits[i] = bits;
     }
 
-    /* initialize half-pel search */
+    InitSubPelCand(encvid);
+
+    return AVCENC_SUCCESS;
+}
+
+/* Clean-up memory */
+void CleanMotionSearchModule(AVCHandle *avcHandle)
+{
+    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
+
+    if (encvid->mvbits_array)
+    {
+        avcHandle->CBAVC_Free(avcHandle->userData, encvid->mvbits_array);
+        encvid->mvbits = NULL;
+    }
+
+    return ;
+}
+
+/* Set up the half-pel and quarter-pel candidate pointers into subpel_pred */
+void InitSubPelCand(AVCEncObject *encvid)
+{
+    uint8* subpel_pred = (uint8*) encvid->subpel_pred; // all 16 sub-pel positions
+
     encvid->hpel_cand[0] = subpel_pred + REF_CENTER;
     encvid->hpel_cand[1] = subpel_pred + V2Q_H0Q * SUBPEL_PRED_BLK_SIZE + 1 ;
     encvid->hpel_cand[2] = subpel_pred + V2Q_H2Q * SUBPEL_PRED_BLK_SIZE + 1;
@@ -165,21 +187,6 @@ AVCEnc_Status InitMotionSearchModule(AVCHandle *avcHandle)
     encvid->bilin_base[8][2] = subpel_pred + V2Q_H0Q * SUBPEL_PRED_BLK_SIZE;
     encvid->bilin_base[8][3] = subpel_pred + V2Q_H2Q * SUBPEL_PRED_BLK_SIZE;
 
-
-    return AVCENC_SUCCESS;
-}
-
-/* Clean-up memory */
-void CleanMotionSearchModule(AVCHandle *avcHandle)
-{
-    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
-
-    if (encvid->mvbits_array)
-    {
-        avcHandle->CBAVC_Free(avcHandle->userData, encvid->mvbits_array);
-        encvid->mvbits = NULL;
-    }
-
     return ;
 }
 
@@ -232,32 +239,49 @@ bool IntraDecisionABE(int *min_cost, uint8 *cur, int pitch, bool ave)
     return intra;
 }
 
+/* turn the current P frame into an I frame after a scene change */
+static void SetIntraFrame(AVCEncObject *encvid)
+{
+    AVCCommonObj *video = encvid->common;
+    AVCMacroblock *mblock = video->mblock;
+    int totalMB = video->PicSizeInMbs;
+    int i;
+
+    /* we can choose to just encode I_SLICE without IDR */
+    //video->nal_unit_type = AVC_NALTYPE_IDR;
+    video->nal_unit_type = AVC_NALTYPE_SLICE;
+    video->sliceHdr->slice_type = AVC_I_ALL_SLICE;
+    video->slice_type = AVC_I_SLICE;
+    memset(encvid->intraSearch, 1, sizeof(uint8)*totalMB);
+    i = totalMB;
+    while (i--)
+    {
+        mblock[i].mb_intra = 1;
+        encvid->min_cost[i] = 0x7FFFFFFF;  /* max value for int */
+    }
+
+    return ;
+}
+
 /******* main function for macroblock prediction for the entire frame ***/
 /* if turns out to be IDR frame, set video->nal_unit_type to AVC_NALTYPE_IDR */
 void AVCMotionEstimation(AVCEncObject *encvid)
 {
     AVCCommonObj *video = encvid->common;
     int slice_type = video->slice_type;
-    AVCFrameIO *currInput = encvid->currInput;
     AVCPictureData *refPic = video->RefPicList0[0];
-    int i, j, k;
+    int i, j;
     int mbwidth = video->PicWidthInMbs;
     int mbheight = video->PicHeightInMbs;
     int totalMB = video->PicSizeInMbs;
-    int pitch = currInput->pitch;
-    AVCMacroblock *currMB, *mblock = video->mblock;
-    AVCMV *mot_mb_16x16, *mot16x16 = encvid->mot16x16;
+    AVCMacroblock *mblock = video->mblock;
     // AVCMV *mot_mb_16x8, *mot_mb_8x16, *mot_mb_8x8, etc;
     AVCRateControl *rateCtrl = encvid->rateCtrl;
     uint8 *intraSearch = encvid->intraSearch;
-    uint FS_en = encvid->fullsearch_enable;
 
     int NumIntraSearch, start_i, numLoop, incr_i;
-    int mbnum, offset;
-    uint8 *cur, *best_cand[5];
     int totalSAD = 0;   /* average SAD for rate control */
     int type_pred;
-    int abe_cost;
 
 #ifdef HTFM
     /***** HYPOTHESIS TESTING ********/  /* 2/28/01 */
@@ -267,10 +291,6 @@ void AVCMotionEstimation(AVCEncObject *encvid)
     double exp_lamda[15];
     /*********************************/
 #endif
-    int hp_guess = 0;
-    uint32 mv_uint32;
-
-    offset = 0;
 
     if (slice_type == AVC_I_SLICE)
     {
@@ -313,8 +333,25 @@ void AVCMotionEstimation(AVCEncObject *encvid)
     /*********************************/
 #endif
 
-    if ((rateCtrl->scdEnable == 1)
-            && ((rateCtrl->frame_rate < 5.0) || (video->sliceHdr->frame_num > MIN_GOP)))
+    if (rateCtrl->laEnable == TRUE)
+    {
+        /* the lookahead detected the scene changes on the input frames already, on
+           content with a lot of motion the test below would turn most frames into I */
+        if (rateCtrl->scdEnable == 1 && encvid->lookahead->curr->sceneCut)
+        {
+            SetIntraFrame(encvid);
+            rateCtrl->totalSAD = 0;
+
+            return ;
+        }
+
+        incr_i = 1;
+        numLoop = 1;
+        start_i = 0;
+        type_pred = 2;
+    }
+    else if ((rateCtrl->scdEnable == 1)
+             && ((rateCtrl->frame_rate < 5.0) || (video->sliceHdr->frame_num > MIN_GOP)))
         /* do not try to detect a new scene if low frame rate and too close to previous I-frame */
     {
         incr_i = 2;
@@ -336,94 +373,25 @@ void AVCMotionEstimation(AVCEncObject *encvid)
     NumIntraSearch = 0; // to be intra searched in the encoding loop.
     while (numLoop--)
     {
-        for (j = 0; j < mbheight; j++)
+#ifndef HTFM
+        if (encvid->meThreads)
         {
-            if (incr_i > 1)
-                start_i = (start_i == 0 ? 1 : 0) ; /* toggle 0 and 1 */
-
-            offset = pitch * (j << 4) + (start_i << 4);
-
-            mbnum = j * mbwidth + start_i;
-
-            for (i = start_i; i < mbwidth; i += incr_i)
-            {
-                video->mbNum = mbnum;
-                video->currMB = currMB = mblock + mbnum;
-                mot_mb_16x16 = mot16x16 + mbnum;
-
-                cur = currInput->YCbCr[0] + offset;
-
-                if (currMB->mb_intra == 0) /* for INTER mode */
-                {
-#if defined(HTFM)
-                    HTFMPrepareCurMB_AVC(encvid, &htfm_stat, cur, pitch);
-#else
-                    AVCPrepareCurMB(encvid, cur, pitch);
+            AVCMotionEstimationThreads(encvid, incr_i, type_pred, &totalSAD, &NumIntraSearch);
+        }
+        else
 #endif
-                    /************************************************************/
-                    /******** full-pel 1MV search **********************/
-
-                    AVCMBMotionSearch(encvid, cur, best_cand, i << 4, j << 4, type_pred,
-                                      FS_en, &hp_guess);
-
-                    abe_cost = encvid->min_cost[mbnum] = mot_mb_16x16->sad;
-
-                    /* set mbMode and MVs */
-                    currMB->mbMode = AVC_P16;
-                    currMB->MBPartPredMode[0][0] = AVC_Pred_L0;
-                    mv_uint32 = ((mot_mb_16x16->y) << 16) | ((mot_mb_16x16->x) & 0xffff);
-                    for (k = 0; k < 32; k += 2)
-                    {
-                        currMB->mvL0[k>>1] = mv_uint32;
-                    }
-
-                    /* make a decision whether it should be tested for intra or not */
-                    if (i != mbwidth - 1 && j != mbheight - 1 && i != 0 && j != 0)
-                    {
-                        if (false == IntraDecisionABE(&abe_cost, cur, pitch, true))
-                        {
-                            intraSearch[mbnum] = 0;
-                        }
-                        else
-                        {
-                            NumIntraSearch++;
-                            rateCtrl->MADofMB[mbnum] = abe_cost;
-                        }
-                    }
-                    else // boundary MBs, always do intra search
-                    {
-                        NumIntraSearch++;
-                    }
+        {
+            for (j = 0; j < mbheight; j++)
+            {
+                if (incr_i > 1)
+                    start_i = (start_i == 0 ? 1 : 0) ; /* toggle 0 and 1 */
 
-                    totalSAD += (int) rateCtrl->MADofMB[mbnum];//mot_mb_16x16->sad;
-                }
-                else    /* INTRA update, use for prediction */
+                for (i = start_i; i < mbwidth; i += incr_i)
                 {
-                    mot_mb_16x16[0].x = mot_mb_16x16[0].y = 0;
-
-                    /* reset all other MVs to zero */
-                    /* mot_mb_16x8, mot_mb_8x16, mot_mb_8x8, etc. */
-                    abe_cost = encvid->min_cost[mbnum] = 0x7FFFFFFF;  /* max value for int */
-
-                    if (i != mbwidth - 1 && j != mbheight - 1 && i != 0 && j != 0)
-                    {
-                        IntraDecisionABE(&abe_cost, cur, pitch, false);
-
-                        rateCtrl->MADofMB[mbnum] = abe_cost;
-                        totalSAD += abe_cost;
-                    }
-
-                    NumIntraSearch++ ;
-                    /* cannot do I16 prediction here because it needs full decoding. */
-                    // intraSearch[mbnum] = 1;
-
-                }
-
-                mbnum += incr_i;
-                offset += (incr_i << 4);
-
-            } /* for i */
-        } /* for j */
+                    AVCMBMotionEstimation(encvid, i, j, type_pred, &totalSAD, &NumIntraSearch);
+                } /* for i */
+            } /* for j */
+        }
 
         /* since we cannot do intra/inter decision here, the SCD has to be
         based on other criteria such as motion vectors coherency or the SAD */
@@ -434,18 +402,7 @@ void AVCMotionEstimation(AVCEncObject *encvid)
                 /* need to do more investigation about this threshold since the NumIntraSearch
                 only show potential intra MBs, not the actual one */
             {
-                /* we can choose to just encode I_SLICE without IDR */
-                //video->nal_unit_type = AVC_NALTYPE_IDR;
-                video->nal_unit_type = AVC_NALTYPE_SLICE;
-                video->sliceHdr->slice_type = AVC_I_ALL_SLICE;
-                video->slice_type = AVC_I_SLICE;
-                memset(intraSearch, 1, sizeof(uint8)*totalMB);
-                i = totalMB;
-                while (i--)
-                {
-                    mblock[i].mb_intra = 1;
-                    encvid->min_cost[i] = 0x7FFFFFFF;  /* max value for int */
-                }
+                SetIntraFrame(encvid);
 
                 rateCtrl->totalSAD = totalSAD * 2;  /* SAD */
 
@@ -472,6 +429,104 @@ void AVCMotionEstimation(AVCEncObject *encvid)
     return ;
 }
 
+/* motion search and intra decision for the macroblock at (i,j), totalSAD and NumIntraSearch
+   are accumulated for rate control and scene change detection */
+void AVCMBMotionEstimation(AVCEncObject *encvid, int i, int j, int type_pred,
+                           int *totalSAD, int *NumIntraSearch)
+{
+    AVCCommonObj *video = encvid->common;
+    AVCFrameIO *currInput = encvid->currInput;
+    int k;
+    int mbwidth = video->PicWidthInMbs;
+    int mbheight = video->PicHeightInMbs;
+    int pitch = currInput->pitch;
+    AVCMacroblock *currMB;
+    AVCMV *mot_mb_16x16;
+    AVCRateControl *rateCtrl = encvid->rateCtrl;
+    uint8 *intraSearch = encvid->intraSearch;
+    uint FS_en = encvid->fullsearch_enable;
+    int mbnum = j * mbwidth + i;
+    int offset = pitch * (j << 4) + (i << 4);
+    uint8 *cur, *best_cand[5];
+    int abe_cost;
+    int hp_guess = 0;
+    uint32 mv_uint32;
+
+    video->mbNum = mbnum;
+    video->currMB = currMB = video->mblock + mbnum;
+    mot_mb_16x16 = encvid->mot16x16 + mbnum;
+
+    cur = currInput->YCbCr[0] + offset;
+
+    if (currMB->mb_intra == 0) /* for INTER mode */
+    {
+#if defined(HTFM)
+        HTFMPrepareCurMB_AVC(encvid, (HTFM_Stat*)encvid->sad_extra_info, cur, pitch);
+#else
+        AVCPrepareCurMB(encvid, cur, pitch);
+#endif
+        /************************************************************/
+        /******** full-pel 1MV search **********************/
+
+        AVCMBMotionSearch(encvid, cur, best_cand, i << 4, j << 4, type_pred,
+                          FS_en, &hp_guess);
+
+        abe_cost = encvid->min_cost[mbnum] = mot_mb_16x16->sad;
+
+        /* set mbMode and MVs */
+        currMB->mbMode = AVC_P16;
+        currMB->MBPartPredMode[0][0] = AVC_Pred_L0;
+        mv_uint32 = ((mot_mb_16x16->y) << 16) | ((mot_mb_16x16->x) & 0xffff);
+        for (k = 0; k < 32; k += 2)
+        {
+            currMB->mvL0[k>>1] = mv_uint32;
+        }
+
+        /* make a decision whether it should be tested for intra or not */
+        if (i != mbwidth - 1 && j != mbheight - 1 && i != 0 && j != 0)
+        {
+            if (false == IntraDecisionABE(&abe_cost, cur, pitch, true))
+            {
+                intraSearch[mbnum] = 0;
+            }
+            else
+            {
+                (*NumIntraSearch)++;
+                rateCtrl->MADofMB[mbnum] = abe_cost;
+            }
+        }
+        else // boundary MBs, always do intra search
+        {
+            (*NumIntraSearch)++;
+        }
+
+        *totalSAD += (int) rateCtrl->MADofMB[mbnum];//mot_mb_16x16->sad;
+    }
+    else    /* INTRA update, use for prediction */
+    {
+        mot_mb_16x16[0].x = mot_mb_16x16[0].y = 0;
+
+        /* reset all other MVs to zero */
+        /* mot_mb_16x8, mot_mb_8x16, mot_mb_8x8, etc. */
+        abe_cost = encvid->min_cost[mbnum] = 0x7FFFFFFF;  /* max value for int */
+
+        if (i != mbwidth - 1 && j != mbheight - 1 && i != 0 && j != 0)
+        {
+            IntraDecisionABE(&abe_cost, cur, pitch, false);
+
+            rateCtrl->MADofMB[mbnum] = abe_cost;
+            *totalSAD += abe_cost;
+        }
+
+        (*NumIntraSearch)++ ;
+        /* cannot do I16 prediction here because it needs full decoding. */
+        // intraSearch[mbnum] = 1;
+
+    }
+
+    return ;
+}
+
 /*=====================================================================
     Function:   PaddingEdge
     Date:       09/16/2000
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "avcenc_lib.h"
+
+static void *METhreadLoop(void *arg);
+static void MESearchRows(AVCMEWorker *worker);
+static int MEWaitForRow(AVCMEThreads *threads, int row, int col);
+static void MESetRowProgress(AVCMEThreads *threads, int row, int col);
+
+/* Start numThreads-1 worker threads, the encoding thread is worker 0 */
+AVCEnc_Status InitMotionSearchThreads(AVCHandle *avcHandle, int numThreads)
+{
+    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
+    AVCCommonObj *video = encvid->common;
+    void *userData = avcHandle->userData;
+    AVCMEThreads *threads;
+    AVCMEWorker *worker;
+    int k;
+
+    encvid->meThreads = NULL;
+
+#ifdef HTFM
+    /* HTFM collects its statistics over the whole frame */
+    numThreads = 1;
+#endif
+
+    if (numThreads > MAX_ME_THREADS)
+    {
+        numThreads = MAX_ME_THREADS;
+    }
+    if (numThreads > (int)video->PicHeightInMbs)
+    {
+        numThreads = video->PicHeightInMbs;
+    }
+    if (numThreads < 2)
+    {
+        return AVCENC_SUCCESS;
+    }
+
+    threads = (AVCMEThreads*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCMEThreads), DEFAULT_ATTR);
+    if (threads == NULL)
+    {
+        return AVCENC_MEMORY_FAIL;
+    }
+    memset(threads, 0, sizeof(AVCMEThreads));
+
+    threads->worker = (AVCMEWorker*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCMEWorker) * numThreads, DEFAULT_ATTR);
+    threads->rowProgress = (int*) avcHandle->CBAVC_Malloc(userData, sizeof(int) * video->PicHeightInMbs, DEFAULT_ATTR);
+    if (threads->worker == NULL || threads->rowProgress == NULL)
+    {
+        if (threads->worker)
+        {
+            avcHandle->CBAVC_Free(userData, threads->worker);
+        }
+        if (threads->rowProgress)
+        {
+            avcHandle->CBAVC_Free(userData, threads->rowProgress);
+        }
+        avcHandle->CBAVC_Free(userData, threads);
+        return AVCENC_MEMORY_FAIL;
+    }
+    memset(threads->worker, 0, sizeof(AVCMEWorker) * numThreads);
+
+    pthread_mutex_init(&threads->lock, NULL);
+    pthread_cond_init(&threads->startCond, NULL);
+    pthread_cond_init(&threads->doneCond, NULL);
+    pthread_cond_init(&threads->progressCond, NULL);
+
+    encvid->meThreads = threads;
+
+    worker = threads->worker;
+    worker[0].threads = threads;
+    worker[0].encvid = encvid;
+    worker[0].video = video;
+    threads->numThreads = 1;
+
+    for (k = 1; k < numThreads; k++)
+    {
+        worker[k].threads = threads;
+        worker[k].encvid = (AVCEncObject*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCEncObject), DEFAULT_ATTR);
+        worker[k].video = (AVCCommonObj*) avcHandle->CBAVC_Malloc(userData, sizeof(AVCCommonObj), DEFAULT_ATTR);
+        if (worker[k].encvid == NULL || worker[k].video == NULL)
+        {
+            break;
+        }
+
+        if (pthread_create(&worker[k].thread, NULL, METhreadLoop, &worker[k]) != 0)
+        {
+            break;
+        }
+
+        threads->numThreads++;
+    }
+
+    if (threads->numThreads < numThreads)
+    {
+        /* worker k was not started, numThreads has not been incremented for it */
+        if (worker[k].encvid)
+        {
+            avcHandle->CBAVC_Free(userData, worker[k].encvid);
+        }
+        if (worker[k].video)
+        {
+            avcHandle->CBAVC_Free(userData, worker[k].video);
+        }
+
+        CleanMotionSearchThreads(avcHandle);
+        return AVCENC_MEMORY_FAIL;
+    }
+
+    return AVCENC_SUCCESS;
+}
+
+/* Stop the worker threads and free their copies of the encoder object */
+void CleanMotionSearchThreads(AVCHandle *avcHandle)
+{
+    AVCEncObject *encvid = (AVCEncObject*) avcHandle->AVCObject;
+    AVCMEThreads *threads = encvid->meThreads;
+    void *userData = avcHandle->userData;
+    int k;
+
+    if (threads == NULL)
+    {
+        return ;
+    }
+
+    pthread_mutex_lock(&threads->lock);
+    threads->quit = 1;
+    pthread_cond_broadcast(&threads->startCond);
+    pthread_mutex_unlock(&threads->lock);
+
+    for (k = 1; k < threads->numThreads; k++)
+    {
+        pthread_join(threads->worker[k].thread, NULL);
+
+        avcHandle->CBAVC_Free(userData, threads->worker[k].encvid);
+        avcHandle->CBAVC_Free(userData, threads->worker[k].video);
+    }
+
+    pthread_cond_destroy(&threads->progressCond);
+    pthread_cond_destroy(&threads->doneCond);
+    pthread_cond_destroy(&threads->startCond);
+    pthread_mutex_destroy(&threads->lock);
+
+    avcHandle->CBAVC_Free(userData, threads->rowProgress);
+    avcHandle->CBAVC_Free(userData, threads->worker);
+    avcHandle->CBAVC_Free(userData, threads);
+
+    encvid->meThreads = NULL;
+
+    return ;
+}
+
+/* One pass of AVCMotionEstimation, the encoding thread searches rows as well */
+void AVCMotionEstimationThreads(AVCEncObject *encvid, int incr_i, int type_pred,
+                                int *totalSAD, int *NumIntraSearch)
+{
+    AVCMEThreads *threads = encvid->meThreads;
+    AVCMEWorker *worker = threads->worker;
+    int mbheight = encvid->common->PicHeightInMbs;
+    int k;
+
+    /* refresh the private copies, the reference picture, QP etc. change every frame */
+    for (k = 1; k < threads->numThreads; k++)
+    {
+        *worker[k].encvid = *encvid;
+        *worker[k].video = *encvid->common;
+        worker[k].encvid->common = worker[k].video;
+        InitSubPelCand(worker[k].encvid);
+    }
+
+    for (k = 0; k < threads->numThreads; k++)
+    {
+        worker[k].totalSAD = 0;
+        worker[k].NumIntraSearch = 0;
+    }
+
+    memset(threads->rowProgress, 0, sizeof(int) * mbheight);
+
+    pthread_mutex_lock(&threads->lock);
+    threads->incr_i = incr_i;
+    threads->type_pred = type_pred;
+    threads->nextRow = 0;
+    threads->numBusy = threads->numThreads - 1;
+    threads->passId++;
+    pthread_cond_broadcast(&threads->startCond);
+    pthread_mutex_unlock(&threads->lock);
+
+    MESearchRows(&worker[0]);
+
+    pthread_mutex_lock(&threads->lock);
+    while (threads->numBusy > 0)
+    {
+        pthread_cond_wait(&threads->doneCond, &threads->lock);
+    }
+    pthread_mutex_unlock(&threads->lock);
+
+    /* the sums do not depend on which thread searched which row */
+    for (k = 0; k < threads->numThreads; k++)
+    {
+        *totalSAD += worker[k].totalSAD;
+        *NumIntraSearch += worker[k].NumIntraSearch;
+    }
+
+    return ;
+}
+
+static void *METhreadLoop(void *arg)
+{
+    AVCMEWorker *worker = (AVCMEWorker*) arg;
+    AVCMEThreads *threads = worker->threads;
+    int passId = 0;
+
+    pthread_mutex_lock(&threads->lock);
+    while (!threads->quit)
+    {
+        if (threads->passId == passId)
+        {
+            pthread_cond_wait(&threads->startCond, &threads->lock);
+            continue;
+        }
+
+        passId = threads->passId;
+
+        pthread_mutex_unlock(&threads->lock);
+        MESearchRows(worker);
+        pthread_mutex_lock(&threads->lock);
+
+        if (--threads->numBusy == 0)
+        {
+            pthread_cond_signal(&threads->doneCond);
+        }
+    }
+    pthread_mutex_unlock(&threads->lock);
+
+    return NULL;
+}
+
+/* Take MB rows until all rows of the current pass are handed out */
+static void MESearchRows(AVCMEWorker *worker)
+{
+    AVCMEThreads *threads = worker->threads;
+    AVCEncObject *encvid = worker->encvid;
+    int mbwidth = encvid->common->PicWidthInMbs;
+    int mbheight = encvid->common->PicHeightInMbs;
+    int incr_i = threads->incr_i;
+    int type_pred = threads->type_pred;
+    int i, j, start_i, above, need;
+
+    while (1)
+    {
+        pthread_mutex_lock(&threads->lock);
+        j = threads->nextRow++;
+        pthread_mutex_unlock(&threads->lock);
+
+        if (j >= mbheight)
+        {
+            break;
+        }
+
+        /* with scene change detection, the first pass starts at MB 0 on even rows
+           and at MB 1 on odd rows, and the second pass searches the other MBs */
+        start_i = (incr_i > 1) ? ((j + type_pred) & 1) : 0;
+
+        above = (j == 0) ? mbwidth : 0; /* known progress of the row above */
+
+        for (i = start_i; i < mbwidth; i += incr_i)
+        {
+            need = (i + 2 < mbwidth) ? i + 2 : mbwidth;
+            if (above < need)
+            {
+                above = MEWaitForRow(threads, j - 1, need);
+            }
+
+            AVCMBMotionEstimation(encvid, i, j, type_pred,
+                                  &worker->totalSAD, &worker->NumIntraSearch);
+
+            /* MB i+1 is not searched in this pass if incr_i is 2 */
+            if (i + incr_i < mbwidth)
+            {
+                MESetRowProgress(threads, j, i + incr_i);
+            }
+        }
+
+        MESetRowProgress(threads, j, mbwidth);
+    }
+
+    return ;
+}
+
+/* Wait until all MBs left of col are done in the given row, returns the progress */
+static int MEWaitForRow(AVCMEThreads *threads, int row, int col)
+{
+    int progress;
+
+    pthread_mutex_lock(&threads->lock);
+    while (threads->rowProgress[row] < col)
+    {
+        threads->numWaiting++;
+        pthread_cond_wait(&threads->progressCond, &threads->lock);
+        threads->numWaiting--;
+    }
+    progress = threads->rowProgress[row];
+    pthread_mutex_unlock(&threads->lock);
+
+    return progress;
+}
+
+static void MESetRowProgress(AVCMEThreads *threads, int row, int col)
+{
+    pthread_mutex_lock(&threads->lock);
+    threads->rowProgress[row] = col;
+    if (threads->numWaiting)
+    {
+        pthread_cond_broadcast(&threads->progressCond);
+    }
+    pthread_mutex_unlock(&threads->lock);
+
+    return ;
+}
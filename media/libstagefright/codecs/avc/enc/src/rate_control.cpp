@@ -24,6 +24,16 @@
 
 #define MAD_MIN 1 /* handle the case of devision by zero in RC */
 
+/* lookahead rate control */
+#define LA_MIN_QUANT    10      /* the bits saved below are better spent on later frames */
+#define LA_PRED_DECAY   0.5     /* weight of the older samples in the bits predictor */
+#define LA_ABR_PERIOD   2.0     /* seconds over which the difference to the target bit rate is made up */
+#define LA_VBV_MARGIN   0.1     /* part of the buffer kept for the frames after the current one */
+
+/* adaptive quantization */
+#define AQ_STRENGTH     1.0     /* QP offset per doubling of the MB variance */
+#define AQ_MAX_OFFSET   6
+
 
 /* local functions */
 double QP2Qstep(int QP);
@@ -42,6 +52,12 @@ void AVCSaveRDSamples(MultiPass *pMP, int counter_samples);
 
 void updateRateControl(AVCRateControl *rateControl, int nal_type);
 
+int calculateQuantizer_Lookahead(AVCEncObject *encvid, AVCCommonObj *video, AVCRateControl *rateCtrl);
+
+void updateRateControl_Lookahead(AVCEncObject *encvid, AVCCommonObj *video, AVCRateControl *rateCtrl);
+
+void RCInitAdaptiveQuant(AVCEncObject *encvid);
+
 int GetAvgFrameQP(AVCRateControl *rateCtrl)
 {
     return rateCtrl->Qc;
@@ -144,7 +160,14 @@ void RCUpdateBuffer(AVCCommonObj *video, AVCRateControl *rateCtrl, int frameInc)
 
     OSCL_UNUSED_ARG(video);
 
-    if (rateCtrl->rcEnable == TRUE)
+    if (rateCtrl->laEnable == TRUE)
+    {
+        /* the buffer is refilled when the frame QP is calculated, frameInc does not
+           include the frames skipped on purpose but their intervals refill it too */
+        rateCtrl->laFrameInc = frameInc + rateCtrl->skip_next_frame;
+        rateCtrl->skip_next_frame = 0;
+    }
+    else if (rateCtrl->rcEnable == TRUE)
     {
         if (frameInc > 1)
         {
@@ -278,6 +301,36 @@ AVCEnc_Status InitRateControlModule(AVCHandle *avcHandle)
         }
 
         rateCtrl->Qc = rateCtrl->initQP;
+
+        if (rateCtrl->laEnable == TRUE)
+        {
+            /* rough start values, updated with every encoded frame */
+            rateCtrl->laPredCoef[0] = 2.0;
+            rateCtrl->laPredCoef[1] = 4.0;
+            rateCtrl->laPredCount[0] = rateCtrl->laPredCount[1] = 1.0;
+            rateCtrl->laFrameInc = 1;
+
+            rateCtrl->vbvBuffer = rateCtrl->cpbSize;
+            if (rateCtrl->initDelayOffset > 0 && rateCtrl->initDelayOffset < rateCtrl->cpbSize)
+            {
+                rateCtrl->vbvBuffer = rateCtrl->initDelayOffset;
+            }
+
+            if (AVCENC_SUCCESS != InitLookahead(avcHandle, rateCtrl->laDepth))
+            {
+                goto CLEANUP_RC;
+            }
+        }
+    }
+
+    if (rateCtrl->aqEnable == TRUE)
+    {
+        rateCtrl->aqQP = (int*) avcHandle->CBAVC_Malloc(encvid->avcHandle->userData,
+                         video->PicSizeInMbs * sizeof(int), DEFAULT_ATTR);
+        if (!rateCtrl->aqQP)
+        {
+            goto CLEANUP_RC;
+        }
     }
 
     return AVCENC_SUCCESS;
@@ -317,6 +370,13 @@ void CleanupRateControlModule(AVCHandle *avcHandle)
         avcHandle->CBAVC_Free(avcHandle->userData, rateCtrl->pMP);
     }
 
+    CleanupLookahead(avcHandle);
+
+    if (rateCtrl->aqQP)
+    {
+        avcHandle->CBAVC_Free(avcHandle->userData, rateCtrl->aqQP);
+    }
+
     return ;
 }
 
@@ -337,7 +397,16 @@ void RCInitFrameQP(AVCEncObject *encvid)
     AVCPicParamSet *picParam = video->currPicParams;
     MultiPass *pMP = rateCtrl->pMP;
 
-    if (rateCtrl->rcEnable == TRUE)
+    if (rateCtrl->laEnable == TRUE)
+    {
+        /* frame layer rate control, frames are never skipped */
+        video->QPy = rateCtrl->Qc = calculateQuantizer_Lookahead(encvid, video, rateCtrl);
+
+        rateCtrl->NumberofHeaderBits = 0;
+        rateCtrl->NumberofTextureBits = 0;
+        rateCtrl->numFrameBits = 0; // reset
+    }
+    else if (rateCtrl->rcEnable == TRUE)
     {
         /* frame layer rate control */
         if (rateCtrl->encoded_frames == 0)
@@ -389,6 +458,11 @@ void RCInitFrameQP(AVCEncObject *encvid)
 
 //  printf(" %d ",video->QPy);
 
+    if (rateCtrl->aqEnable == TRUE)
+    {
+        RCInitAdaptiveQuant(encvid);
+    }
+
     if (video->CurrPicNum == 0 && encvid->outOfBandParamSet == FALSE)
     {
         picParam->pic_init_qs_minus26 = 0;
@@ -736,7 +810,14 @@ void RCInitMBQP(AVCEncObject *encvid)
     AVCCommonObj *video =  encvid->common;
     AVCMacroblock *currMB = video->currMB;
 
-    currMB->QPy = video->QPy; /* set to previous value or picture level */
+    if (encvid->rateCtrl->aqEnable == TRUE)
+    {
+        currMB->QPy = encvid->rateCtrl->aqQP[video->mbNum];
+    }
+    else
+    {
+        currMB->QPy = video->QPy; /* set to previous value or picture level */
+    }
 
     RCInitChromaQP(encvid);
 
@@ -800,7 +881,14 @@ AVCEnc_Status RCUpdateFrame(AVCEncObject *encvid)
 
     /* update the complexity weight of I, P, B frame */
 
-    if (rateCtrl->rcEnable == TRUE)
+    if (rateCtrl->laEnable == TRUE)
+    {
+        updateRateControl_Lookahead(encvid, video, rateCtrl);
+
+        rateCtrl->Rc = rateCtrl->numFrameBits;  /* Total Bits for current frame */
+        rateCtrl->Hc = rateCtrl->NumberofHeaderBits;    /* Total Bits in Header and Motion Vector */
+    }
+    else if (rateCtrl->rcEnable == TRUE)
     {
         pMP->actual_bits = rateCtrl->numFrameBits;
         pMP->mad = (OsclFloat)rateCtrl->totalSAD / video->PicSizeInMbs; //ComputeFrameMAD(video, rateCtrl);
@@ -895,6 +983,189 @@ void updateRateControl(AVCRateControl *rateCtrl, int nal_type)
 }
 
 
+/* Frame QP from the predicted bits of the current and the queued frames. The bits of a
+   frame are predicted as laPredCoef * cost / Qstep, the Qstep is chosen to spend the bits
+   of the target bit rate over the window plus a part of the difference between the wanted
+   and the actual bits so far, and raised until the decoder buffer does not underflow. */
+int calculateQuantizer_Lookahead(AVCEncObject *encvid, AVCCommonObj *video, AVCRateControl *rateCtrl)
+{
+    AVCLookahead *la = encvid->lookahead;
+    AVCLookaheadFrame *frame;
+    OsclFloat complexity[MAX_LOOKAHEAD_DEPTH + 1]; /* predicted bits times Qstep */
+    OsclFloat bitsPerFrame, budget, total, buffer, bits, Qstep, maxQstep;
+    double size = rateCtrl->cpbSize;
+    int i, n, type, QP;
+
+    bitsPerFrame = rateCtrl->bitRate / rateCtrl->frame_rate;
+
+    /* refill the buffer for the frame intervals since the previous frame */
+    rateCtrl->vbvBuffer += bitsPerFrame * rateCtrl->laFrameInc;
+    if (rateCtrl->vbvBuffer > size)
+    {
+        rateCtrl->vbvBuffer = size;
+    }
+    rateCtrl->wantedBits += bitsPerFrame * rateCtrl->laFrameInc;
+    rateCtrl->laFrameInc = 1;
+
+    if (video->nal_unit_type == AVC_NALTYPE_IDR)
+    {
+        rateCtrl->laFramesSinceIDR = 0;
+    }
+
+    /* the current frame with its actual type, the queued ones as P frames unless an
+       IDR is due or they start a new scene */
+    n = la->count + 1;
+    total = 0;
+    for (i = 0; i < n; i++)
+    {
+        if (i == 0)
+        {
+            frame = la->curr;
+            type = (video->slice_type == AVC_I_SLICE);
+        }
+        else
+        {
+            frame = LookaheadGetQueued(la, i - 1);
+            type = ((rateCtrl->idrPeriod > 0 && (rateCtrl->laFramesSinceIDR + i) % rateCtrl->idrPeriod == 0) ||
+                    (rateCtrl->scdEnable == 1 && frame->sceneCut));
+        }
+
+        complexity[i] = rateCtrl->laPredCoef[type] / rateCtrl->laPredCount[type] *
+                        (type ? frame->intraCost : frame->cost);
+        total += complexity[i];
+    }
+
+    budget = n * bitsPerFrame + (rateCtrl->wantedBits - rateCtrl->actualBits) * n / (LA_ABR_PERIOD * rateCtrl->frame_rate);
+    budget = AVC_MAX(budget, n * bitsPerFrame * 0.5);
+    budget = AVC_MIN(budget, n * bitsPerFrame * 2.0);
+
+    if (rateCtrl->first_frame)
+    {
+        Qstep = QP2Qstep(rateCtrl->initQP);
+    }
+    else
+    {
+        Qstep = total / budget;
+    }
+
+    Qstep = AVC_MAX(Qstep, QP2Qstep(LA_MIN_QUANT));
+    maxQstep = QP2Qstep(RC_MAX_QUANT);
+
+    /* raise Qstep by one QP until no frame of the window underflows the buffer,
+       the current frame must leave some margin for the following ones */
+    if (size > 0)
+    {
+        while (Qstep < maxQstep)
+        {
+            buffer = rateCtrl->vbvBuffer;
+            for (i = 0; i < n; i++)
+            {
+                bits = complexity[i] / Qstep;
+                if (bits > buffer - ((i == 0) ? size * LA_VBV_MARGIN : 0))
+                {
+                    break;
+                }
+                buffer = AVC_MIN(buffer - bits + bitsPerFrame, size);
+            }
+
+            if (i == n)
+            {
+                break;
+            }
+
+            Qstep *= 1.122462; /* 2^(1/6) */
+        }
+    }
+
+    QP = Qstep2QP(AVC_MIN(Qstep, maxQstep));
+
+    rateCtrl->laQstep = QP2Qstep(QP);
+
+    return QP;
+}
+
+void updateRateControl_Lookahead(AVCEncObject *encvid, AVCCommonObj *video, AVCRateControl *rateCtrl)
+{
+    AVCLookaheadFrame *frame = encvid->lookahead->curr;
+    OsclFloat bits = rateCtrl->numFrameBits;
+    OsclFloat bitsPerFrame;
+    int type = (video->slice_type == AVC_I_SLICE);
+    int32 cost = type ? frame->intraCost : frame->cost;
+
+    rateCtrl->laPredCoef[type] = rateCtrl->laPredCoef[type] * LA_PRED_DECAY + bits * rateCtrl->laQstep / AVC_MAX(cost, 1);
+    rateCtrl->laPredCount[type] = rateCtrl->laPredCount[type] * LA_PRED_DECAY + 1;
+
+    rateCtrl->actualBits += bits;
+
+    /* with the QP at its maximum, the next frame will probably take as many bits, skip
+       as many of the following frames as it takes to refill the buffer for it like the
+       default rate control does */
+    rateCtrl->vbvBuffer -= bits;
+    if (rateCtrl->cpbSize > 0 && rateCtrl->laQstep >= QP2Qstep(RC_MAX_QUANT))
+    {
+        bitsPerFrame = rateCtrl->bitRate / rateCtrl->frame_rate;
+        if (rateCtrl->vbvBuffer + bitsPerFrame < bits)
+        {
+            rateCtrl->skip_next_frame = (int)ceil((bits - rateCtrl->vbvBuffer) / bitsPerFrame) - 1;
+        }
+    }
+
+    rateCtrl->laFramesSinceIDR++;
+
+    return ;
+}
+
+/* QP of each MB from the frame QP and the log of the MB luma variance relative to its
+   average over the frame, flat MBs where artifacts are more visible get a lower QP. */
+void RCInitAdaptiveQuant(AVCEncObject *encvid)
+{
+    AVCCommonObj *video = encvid->common;
+    AVCRateControl *rateCtrl = encvid->rateCtrl;
+    AVCFrameIO *currInput = encvid->currInput;
+    int pitch = currInput->pitch;
+    int mbwidth = video->PicWidthInMbs;
+    int mbheight = video->PicHeightInMbs;
+    int *aqQP = rateCtrl->aqQP;
+    double *energy = rateCtrl->MADofMB; /* scratch, overwritten while encoding */
+    double avg = 0;
+    uint8 *org;
+    int i, j, k, l, mbnum, offset;
+    int32 sum, sqr;
+
+    for (j = 0; j < mbheight; j++)
+    {
+        for (i = 0; i < mbwidth; i++)
+        {
+            org = currInput->YCbCr[0] + ((j * pitch + i) << 4);
+            sum = sqr = 0;
+            for (l = 0; l < 16; l++)
+            {
+                for (k = 0; k < 16; k++)
+                {
+                    sum += org[k];
+                    sqr += org[k] * org[k];
+                }
+                org += pitch;
+            }
+
+            mbnum = j * mbwidth + i;
+            energy[mbnum] = log((double)(sqr - (int32)(((uint32)sum * sum) >> 8)) + 1.0) / log(2.0);
+            avg += energy[mbnum];
+        }
+    }
+
+    avg /= video->PicSizeInMbs;
+
+    for (mbnum = 0; mbnum < (int)video->PicSizeInMbs; mbnum++)
+    {
+        offset = (int)floor(AQ_STRENGTH * (energy[mbnum] - avg) + 0.5);
+        offset = AVC_CLIP3(-AQ_MAX_OFFSET, AQ_MAX_OFFSET, offset);
+        aqQP[mbnum] = AVC_CLIP3(0, 51, video->QPy + offset);
+    }
+
+    return ;
+}
+
 double ComputeFrameMAD(AVCCommonObj *video, AVCRateControl *rateCtrl)
 {
     double TotalMAD;
@@ -69,6 +69,11 @@ int AVCSAD_MB_HalfPel_Cxhyh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_inf
 {
     (void)(extra_info);
 
+#if defined(__SSE2__)
+    NUM_SAD_HP_MB_CALL();
+
+    return simd_sad_mb_hp4(ref, blk, (uint32)dmin_rx >> 16, dmin_rx & 0xFFFF);
+#else
     int i, j;
     int sad = 0;
     uint8 *kk, *p1, *p2, *p3, *p4;
@@ -104,12 +109,18 @@ int AVCSAD_MB_HalfPel_Cxhyh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_inf
         p4 += rx;
     }
     return sad;
+#endif
 }
 
 int AVCSAD_MB_HalfPel_Cyh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_info)
 {
     (void)(extra_info);
 
+#if defined(__SSE2__)
+    NUM_SAD_HP_MB_CALL();
+
+    return simd_sad_mb_hp2(ref, blk, (uint32)dmin_rx >> 16, dmin_rx & 0xFFFF, dmin_rx & 0xFFFF);
+#else
     int i, j;
     int sad = 0;
     uint8 *kk, *p1, *p2;
@@ -140,12 +151,18 @@ int AVCSAD_MB_HalfPel_Cyh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_info)
         p2 += rx;
     }
     return sad;
+#endif
 }
 
 int AVCSAD_MB_HalfPel_Cxh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_info)
 {
     (void)(extra_info);
 
+#if defined(__SSE2__)
+    NUM_SAD_HP_MB_CALL();
+
+    return simd_sad_mb_hp2(ref, blk, (uint32)dmin_rx >> 16, dmin_rx & 0xFFFF, 1);
+#else
     int i, j;
     int sad = 0;
     uint8 *kk, *p1;
@@ -173,6 +190,7 @@ int AVCSAD_MB_HalfPel_Cxh(uint8 *ref, uint8 *blk, int dmin_rx, void *extra_info)
         p1 += rx;
     }
     return sad;
+#endif
 }
 
 #ifdef HTFM  /* HTFM with uniform subsampling implementation,  2/28/01 */
@@ -19,11 +19,91 @@
 #ifndef _SAD_HALFPEL_INLINE_H_
 #define _SAD_HALFPEL_INLINE_H_
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+#if defined(__SSE2__) /* x86 SSE2 version of the half-pel SAD */
+
+    /* SAD of a 16x16 block against the rounded average of ref and ref+offset,
+     * i.e. half-pel in x (offset 1) or in y (offset rx). Like the C version the
+     * partial SAD is returned after the first row that exceeds dmin. */
+    __inline int32 simd_sad_mb_hp2(uint8 *ref, uint8 *blk, int dmin, int rx, int offset)
+    {
+        __m128i sum = _mm_setzero_si128();
+        __m128i p;
+        int32 sad = 0;
+        int i;
+
+        for (i = 16; i > 0; i--)
+        {
+            p = _mm_avg_epu8(_mm_loadu_si128((__m128i*)ref),
+                             _mm_loadu_si128((__m128i*)(ref + offset)));
+            sum = _mm_add_epi32(sum, _mm_sad_epu8(p, _mm_loadu_si128((__m128i*)blk)));
+
+            sad = _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+            if (sad > dmin)
+            {
+                break;
+            }
+
+            ref += rx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+    /* SAD against (a + b + c + d + 2) >> 2 of the four neighbors, half-pel in x and y */
+    __inline int32 simd_sad_mb_hp4(uint8 *ref, uint8 *blk, int dmin, int rx)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i two = _mm_set1_epi16(2);
+        __m128i sum = zero;
+        __m128i a, b, c, d, lo, hi;
+        int32 sad = 0;
+        int i;
+
+        for (i = 16; i > 0; i--)
+        {
+            a = _mm_loadu_si128((__m128i*)ref);
+            b = _mm_loadu_si128((__m128i*)(ref + 1));
+            c = _mm_loadu_si128((__m128i*)(ref + rx));
+            d = _mm_loadu_si128((__m128i*)(ref + rx + 1));
+
+            lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(c, zero));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(d, zero));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+
+            hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(c, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(d, zero));
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+
+            sum = _mm_add_epi32(sum, _mm_sad_epu8(_mm_packus_epi16(lo, hi),
+                                                  _mm_loadu_si128((__m128i*)blk)));
+
+            sad = _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+            if (sad > dmin)
+            {
+                break;
+            }
+
+            ref += rx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+#endif /* __SSE2__ */
+
 /* Intentionally not using the gcc asm version, since it is
  * slightly slower than the plain C version on modern GCC versions. */
 #if !defined(__CC_ARM) /* Generic C version */
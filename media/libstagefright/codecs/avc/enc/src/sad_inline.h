@@ -18,6 +18,10 @@
 #ifndef _SAD_INLINE_H_
 #define _SAD_INLINE_H_
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -58,6 +62,40 @@ extern "C"
         return src1;
     }
 
+#if defined(__SSE2__) /* x86 SSE2 version */
+
+    /* Unaligned loads, so no special cases for the alignment of ref. The SAD is
+     * checked against dmin after every row and the partial SAD is returned, the
+     * same as the C version, because the caller keeps these values for the
+     * half-pel search. */
+    __inline int32 simd_sad_mb(uint8 *ref, uint8 *blk, int dmin, int lx)
+    {
+        __m128i sum = _mm_setzero_si128();
+        __m128i r, b;
+        int32 sad = 0;
+        int i;
+
+        for (i = 16; i > 0; i--)
+        {
+            r = _mm_loadu_si128((__m128i*)ref);
+            b = _mm_loadu_si128((__m128i*)blk);
+            sum = _mm_add_epi32(sum, _mm_sad_epu8(r, b));
+
+            sad = _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+            if (sad > dmin)
+            {
+                break;
+            }
+
+            ref += lx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+#else /* Generic C version */
+
 #define NUMBER 3
 #define SHIFT 24
 
@@ -169,6 +207,8 @@ SadMBOffset1:
 
     }
 
+#endif /* __SSE2__ */
+
 #elif defined(__CC_ARM)  /* only work with arm v5 */
 
     __inline int32 SUB_SAD(int32 sad, int32 tmp, int32 tmp2)
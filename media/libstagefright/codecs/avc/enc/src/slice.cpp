@@ -333,7 +333,7 @@ AVCEnc_Status EncodeMB(AVCEncObject *encvid)
     if (!currMB->mb_intra)
     {
         /* decide whether this MB (for inter MB) should be skipped if there's nothing left. */
-        if (!currMB->CBP && currMB->NumMbPart == 1 && currMB->QPy == video->QPy)
+        if (!currMB->CBP && currMB->NumMbPart == 1)
         {
             if (currMB->MBPartPredMode[0][0] == AVC_Pred_L0 && currMB->ref_idx_L0[0] == 0)
             {
@@ -372,6 +372,12 @@ AVCEnc_Status EncodeMB(AVCEncObject *encvid)
             {
                 video->mb_skip_run++;
 
+                /* no mb_qp_delta, with adaptive quantization the QP may differ */
+                if (currMB->QPy != video->QPy)
+                {
+                    RCRestoreQP(currMB, video, encvid);
+                }
+
                 /* set parameters */
                 /* not sure whether we need the followings */
                 if (slice_type == AVC_P_SLICE)
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encodes synthetic clips through the PVAVCEnc API and models the decoder
+// buffer the way test/AVCEncTestBench.cpp does, to check that the lookahead
+// rate control meets the target bit rate without underflows on content with
+// a lot of motion, and still codes real scene cuts as I frames.
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "avcenc_api.h"
+
+namespace android {
+
+class AVCEncRateControlTest : public ::testing::Test {
+protected:
+    enum {
+        kWidth = 352,
+        kHeight = 288,
+        kFrameRate = 30,
+        kNumFrames = 90,
+        kMaxDpbFrames = 17,
+        kOutputSize = 1 << 20,
+    };
+
+    struct Result {
+        int mNumEncoded;
+        int mNumSkipped;
+        int mNumIntra;
+        int mNumUnderflows;
+        double mBitrate;
+    };
+
+    AVCHandle mHandle;
+    uint8 *mDpb[kMaxDpbFrames];
+    int mNumDpb;
+    uint8 *mFrame;
+    uint8 *mOutput;
+    uint32 *mSliceGroup;
+
+    virtual void SetUp() {
+        memset(&mHandle, 0, sizeof(mHandle));
+        mHandle.userData = this;
+        mHandle.CBAVC_Malloc = Malloc;
+        mHandle.CBAVC_Free = Free;
+        mHandle.CBAVC_DPBAlloc = DPBAlloc;
+        mHandle.CBAVC_FrameBind = FrameBind;
+        mHandle.CBAVC_FrameUnbind = FrameUnbind;
+
+        mNumDpb = 0;
+        mFrame = new uint8[(kWidth * kHeight * 3) / 2];
+        mOutput = new uint8[kOutputSize];
+        mSliceGroup = new uint32[(kWidth * kHeight) >> 8];
+        memset(mSliceGroup, 0, sizeof(uint32) * ((kWidth * kHeight) >> 8));
+    }
+
+    virtual void TearDown() {
+        for (int i = 0; i < mNumDpb; ++i) {
+            free(mDpb[i]);
+        }
+        delete[] mFrame;
+        delete[] mOutput;
+        delete[] mSliceGroup;
+    }
+
+    static void *Malloc(void * /* userData */, int32 size, int32 /* attrs */) {
+        return calloc(1, size);
+    }
+
+    static void Free(void * /* userData */, void *ptr) {
+        free(ptr);
+    }
+
+    static int32 DPBAlloc(void *userData, uint frameSizeInMbs, uint numBuffers) {
+        AVCEncRateControlTest *me = static_cast<AVCEncRateControlTest *>(userData);
+
+        if (numBuffers > kMaxDpbFrames) {
+            return 0;
+        }
+        for (uint i = 0; i < numBuffers; ++i) {
+            me->mDpb[me->mNumDpb] = (uint8 *)malloc((frameSizeInMbs << 7) * 3);
+            if (me->mDpb[me->mNumDpb] == NULL) {
+                return 0;
+            }
+            ++me->mNumDpb;
+        }
+        return 1;
+    }
+
+    static int32 FrameBind(void *userData, int32 index, uint8 **yuv) {
+        AVCEncRateControlTest *me = static_cast<AVCEncRateControlTest *>(userData);
+
+        if (index >= me->mNumDpb) {
+            return 0;
+        }
+        *yuv = me->mDpb[index];
+        return 1;
+    }
+
+    static void FrameUnbind(void * /* userData */, int32 /* index */) {
+    }
+
+    static int hash(int x, int y) {
+        uint32 h = x * 374761393u + y * 668265263u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        return h >> 24;
+    }
+
+    // Smooth waves changing shape from frame to frame, which no motion
+    // vector predicts well, plus some noise. Every sceneLength frames if it is
+    // not 0, the waves are replaced by a blocky texture or back.
+    void makeFrame(int index, int sceneLength) {
+        int scene = (sceneLength > 0) ? index / sceneLength : 0;
+        uint8 *y = mFrame;
+        uint8 *cb = mFrame + kWidth * kHeight;
+        uint8 *cr = cb + (kWidth * kHeight) / 4;
+
+        for (int j = 0; j < kHeight; ++j) {
+            for (int i = 0; i < kWidth; ++i) {
+                int v;
+                if (scene & 1) {
+                    v = 32 + hash((i + index * 2) >> 3, j >> 3) * 3 / 4;
+                } else {
+                    v = 128 + (int)(50 * sin(i * 0.05 + index * 0.9) * cos(j * 0.04 - index * 0.7)
+                            + 30 * sin((i + j) * 0.03 + index * 1.3));
+                }
+                v += rand() % 5 - 2;
+                y[j * kWidth + i] = (v < 0) ? 0 : (v > 255) ? 255 : v;
+            }
+        }
+
+        for (int j = 0; j < kHeight / 2; ++j) {
+            for (int i = 0; i < kWidth / 2; ++i) {
+                cb[j * kWidth / 2 + i] = 112 + (hash((i + index * 4) >> 3, j >> 3) >> 3);
+                cr[j * kWidth / 2 + i] = 112 + (hash(i >> 2, (j + index * 2) >> 2) >> 3);
+            }
+        }
+    }
+
+    // Encodes kNumFrames frames with the lookahead rate control, the same
+    // settings as SoftAVCEncoder otherwise, and a decoder buffer of one second.
+    void encode(int bitrate, int depth, int sceneLength, Result *result) {
+        AVCEncParams params;
+        memset(&params, 0, sizeof(params));
+        params.rate_control = AVC_ON;
+        params.initQP = 0;
+        params.init_CBP_removal_delay = 1000;
+        params.auto_scd = AVC_ON;
+        params.out_of_band_param_set = AVC_ON;
+        params.poc_type = 2;
+        params.log2_max_poc_lsb_minus_4 = 12;
+        params.use_overrun_buffer = AVC_OFF;
+        params.num_ref_frame = 1;
+        params.num_slice_group = 1;
+        params.slice_group = mSliceGroup;
+        params.db_filter = AVC_ON;
+        params.constrained_intra_pred = AVC_OFF;
+        params.data_par = AVC_OFF;
+        params.fullsearch = AVC_OFF;
+        params.search_range = 16;
+        params.sub_pel = AVC_OFF;
+        params.submb_pred = AVC_OFF;
+        params.rdopt_mode = AVC_OFF;
+        params.bidir_pred = AVC_OFF;
+        params.num_threads = 1;
+        params.width = kWidth;
+        params.height = kHeight;
+        params.bitrate = bitrate;
+        params.frame_rate = 1000 * kFrameRate;
+        params.CPB_size = bitrate;
+        params.idr_period = -1;
+        params.profile = AVC_BASELINE;
+        params.level = AVC_LEVEL3_1;
+        params.lookahead_rc = AVC_ON;
+        params.lookahead_depth = depth;
+        params.adaptive_quant = AVC_OFF;
+
+        ASSERT_EQ(AVCENC_SUCCESS, PVAVCEncInitialize(&mHandle, &params, NULL, NULL));
+
+        // SPS and PPS
+        for (int k = 0; k < 2; ++k) {
+            uint size = kOutputSize;
+            int nalType;
+            ASSERT_EQ(AVCENC_SUCCESS, PVAVCEncodeNAL(&mHandle, mOutput, &size, &nalType));
+        }
+
+        // the encoder keeps a pointer to the input until the frame is encoded
+        AVCFrameIO input;
+        double bitsPerFrame = (double)bitrate / kFrameRate;
+        double buffer = bitrate;
+        double totalBits = 0;
+        int numRead = 0;
+
+        memset(result, 0, sizeof(*result));
+        srand(1);
+
+        for (;;) {
+            AVCEnc_Status status;
+
+            if (numRead < kNumFrames) {
+                memset(&input, 0, sizeof(input));
+
+                makeFrame(numRead, sceneLength);
+                input.id = numRead;
+                input.YCbCr[0] = mFrame;
+                input.YCbCr[1] = mFrame + kWidth * kHeight;
+                input.YCbCr[2] = input.YCbCr[1] + (kWidth * kHeight) / 4;
+                input.pitch = kWidth;
+                input.height = kHeight;
+                input.coding_timestamp = (uint32)(numRead * 1000 / kFrameRate);
+                input.disp_order = numRead;
+                ++numRead;
+
+                status = PVAVCEncSetInput(&mHandle, &input);
+                if (status == AVCENC_PICTURE_QUEUED) {
+                    continue;
+                }
+            } else {
+                status = PVAVCEncSetInput(&mHandle, NULL);
+                if (status == AVCENC_NO_PICTURE) {
+                    break;
+                }
+            }
+
+            double frameBits = 0;
+            bool intra = false;
+            if (status == AVCENC_SUCCESS || status == AVCENC_NEW_IDR) {
+                do {
+                    uint size = kOutputSize;
+                    int nalType;
+                    status = PVAVCEncodeNAL(&mHandle, mOutput, &size, &nalType);
+                    if (status == AVCENC_SUCCESS || status == AVCENC_PICTURE_READY) {
+                        frameBits += size * 8;
+                        // first_mb_in_slice is 0 and the slice type of an
+                        // I slice 2 or 7, the header starts with 1 011 or 1 0001000.
+                        intra = intra || nalType == AVC_NALTYPE_IDR
+                                || (mOutput[1] & 0xf0) == 0xb0 || mOutput[1] == 0x88;
+                    }
+                } while (status == AVCENC_SUCCESS);
+            }
+            ASSERT_TRUE(status == AVCENC_PICTURE_READY || status == AVCENC_SKIPPED_PICTURE)
+                    << "status " << status;
+
+            if (status == AVCENC_SKIPPED_PICTURE) {
+                ++result->mNumSkipped;
+            } else {
+                AVCFrameIO recon;
+                ASSERT_EQ(AVCENC_SUCCESS, PVAVCEncGetRecon(&mHandle, &recon));
+                PVAVCEncReleaseRecon(&mHandle, &recon);
+
+                ++result->mNumEncoded;
+                if (intra) {
+                    ++result->mNumIntra;
+                }
+                if (frameBits > buffer) {
+                    ++result->mNumUnderflows;
+                }
+                buffer -= frameBits;
+                totalBits += frameBits;
+            }
+
+            // the decoder buffer fills up during every frame interval
+            buffer += bitsPerFrame;
+            if (buffer > bitrate) {
+                buffer = bitrate;
+            }
+        }
+
+        PVAVCCleanUpEncoder(&mHandle);
+
+        result->mBitrate = totalBits * kFrameRate / kNumFrames;
+    }
+};
+
+TEST_F(AVCEncRateControlTest, HighMotionMeetsBitrate) {
+    Result result;
+    ASSERT_NO_FATAL_FAILURE(encode(500000, 8, 0, &result));
+
+    EXPECT_EQ(kNumFrames, result.mNumEncoded);
+    EXPECT_NEAR(500000, result.mBitrate, 500000 * 0.05);
+    EXPECT_EQ(0, result.mNumUnderflows);
+    // only the first frame, motion alone is no scene cut
+    EXPECT_EQ(1, result.mNumIntra);
+}
+
+TEST_F(AVCEncRateControlTest, HighMotionWithoutDelayMeetsBitrate) {
+    Result result;
+    ASSERT_NO_FATAL_FAILURE(encode(500000, 0, 0, &result));
+
+    EXPECT_EQ(kNumFrames, result.mNumEncoded);
+    EXPECT_NEAR(500000, result.mBitrate, 500000 * 0.05);
+    EXPECT_EQ(0, result.mNumUnderflows);
+    EXPECT_EQ(1, result.mNumIntra);
+}
+
+TEST_F(AVCEncRateControlTest, HighMotionAtMaximumQPSkipsFrames) {
+    Result result;
+    ASSERT_NO_FATAL_FAILURE(encode(120000, 8, 0, &result));
+
+    // even at the maximum QP a frame takes more than the bits of a frame
+    // interval, the following ones are skipped to refill the buffer
+    EXPECT_EQ(kNumFrames, result.mNumEncoded + result.mNumSkipped);
+    EXPECT_GT(result.mNumSkipped, 0);
+    EXPECT_LT(result.mNumUnderflows * 4, result.mNumEncoded);
+    EXPECT_EQ(1, result.mNumIntra);
+}
+
+TEST_F(AVCEncRateControlTest, SceneCutsAreIntra) {
+    Result result;
+    ASSERT_NO_FATAL_FAILURE(encode(500000, 8, 30, &result));
+
+    EXPECT_EQ(0, result.mNumUnderflows);
+    // the first frame and the frames 30 and 60
+    EXPECT_EQ(3, result.mNumIntra);
+}
+
+}  // namespace android
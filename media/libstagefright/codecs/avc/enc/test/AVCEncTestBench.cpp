@@ -0,0 +1,500 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Offline test bench for the rate control of the AVC encoder. Encodes a raw
+   YUV 4:2:0 sequence and reports the bit rate error, the PSNR of the
+   reconstructed frames and the number of frames that would underflow the
+   decoder buffer. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "avcenc_api.h"
+
+#define MAX_DPB_FRAMES  17
+#define MAX_PENDING     (MAX_LOOKAHEAD_DEPTH + 2)
+#define OUTPUT_SIZE     (1 << 21)
+
+typedef struct
+{
+    uint8 *dpb[MAX_DPB_FRAMES];
+    int numDpb;
+} TestBenchData;
+
+typedef struct
+{
+    double sse[3];
+    int numFrames;
+} PSNRStats;
+
+static void *CbMalloc(void *userData, int32 size, int32 attrs)
+{
+    void *ptr = malloc(size);
+
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+
+    return ptr;
+}
+
+static void CbFree(void *userData, void *ptr)
+{
+    free(ptr);
+}
+
+static int32 CbDPBAlloc(void *userData, uint frameSizeInMbs, uint numBuffers)
+{
+    TestBenchData *data = (TestBenchData*) userData;
+    uint i;
+
+    if (numBuffers > MAX_DPB_FRAMES)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < numBuffers; i++)
+    {
+        data->dpb[i] = (uint8*) malloc((frameSizeInMbs << 7) * 3);
+        if (data->dpb[i] == NULL)
+        {
+            return 0;
+        }
+        data->numDpb++;
+    }
+
+    return 1;
+}
+
+static int32 CbFrameBind(void *userData, int32 index, uint8 **yuv)
+{
+    TestBenchData *data = (TestBenchData*) userData;
+
+    if (index >= data->numDpb)
+    {
+        return 0;
+    }
+    *yuv = data->dpb[index];
+
+    return 1;
+}
+
+static void CbFrameUnbind(void *userData, int32 index)
+{
+}
+
+static double PlaneSSE(uint8 *a, int pitchA, uint8 *b, int pitchB, int width, int height)
+{
+    double sse = 0;
+    int i, j, d;
+
+    for (j = 0; j < height; j++)
+    {
+        for (i = 0; i < width; i++)
+        {
+            d = a[i] - b[i];
+            sse += d * d;
+        }
+        a += pitchA;
+        b += pitchB;
+    }
+
+    return sse;
+}
+
+static void AddPSNR(PSNRStats *stats, uint8 *orig, AVCFrameIO *recon, int width, int height)
+{
+    uint8 *origU = orig + width * height;
+    uint8 *origV = origU + (width * height >> 2);
+
+    stats->sse[0] += PlaneSSE(orig, width, recon->YCbCr[0], recon->pitch, width, height);
+    stats->sse[1] += PlaneSSE(origU, width >> 1, recon->YCbCr[1], recon->pitch >> 1, width >> 1, height >> 1);
+    stats->sse[2] += PlaneSSE(origV, width >> 1, recon->YCbCr[2], recon->pitch >> 1, width >> 1, height >> 1);
+    stats->numFrames++;
+}
+
+static double PSNR(double sse, int numSamples, int numFrames)
+{
+    double mse = sse / ((double)numSamples * numFrames);
+
+    if (mse <= 0)
+    {
+        return 99.99;
+    }
+
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+/* the decoder buffer fills up during every frame interval, skipped frames included */
+static double RefillBuffer(double buffer, double bitsPerFrame, double bufferSize)
+{
+    buffer += bitsPerFrame;
+
+    return (buffer > bufferSize) ? bufferSize : buffer;
+}
+
+static int ReadFrame(FILE *fp, int index, uint8 *frame, int frameSize)
+{
+    if (fseek(fp, (long)index * frameSize, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+
+    return fread(frame, 1, frameSize, fp) == (size_t)frameSize;
+}
+
+static void usage(const char *me)
+{
+    fprintf(stderr,
+            "usage: %s [options] input.yuv width height\n"
+            "  -o <file>   write the H.264 elementary stream\n"
+            "  -b <bps>    target bit rate (default 1000000)\n"
+            "  -f <fps>    frame rate (default 30)\n"
+            "  -n <count>  number of frames to encode (default all)\n"
+            "  -i <count>  IDR period in frames, 0 for only the first one (default 30)\n"
+            "  -v <ms>     decoder buffer size (default 1000)\n"
+            "  -l <depth>  lookahead rate control with depth queued frames\n"
+            "  -q          adaptive quantization\n"
+            "  -t <count>  number of threads\n",
+            me);
+}
+
+int main(int argc, char **argv)
+{
+    TestBenchData data;
+    AVCHandle handle;
+    AVCEncParams params;
+    AVCFrameIO input, recon;
+    AVCEnc_Status status;
+    PSNRStats stats;
+    FILE *in, *out = NULL;
+    const char *outName = NULL;
+    uint8 *frame, *orig, *lastRecon, *output;
+    uint32 *sliceGroup;
+    uint size;
+    int width, height, frameSize, numFrames = -1;
+    int bitrate = 1000000, idrPeriod = 30, vbvMs = 1000, depth = -1, aq = 0, numThreads = 1;
+    double fps = 30.0;
+    int pending[MAX_PENDING]; /* indices of the frames given to the encoder, in coding order */
+    int numPending = 0, numRead = 0, numEncoded = 0, numSkipped = 0, numUnderflows = 0;
+    int nalType, res, k, flushing = 0;
+    double totalBits = 0, frameBits, buffer, bufferSize, bitsPerFrame, seconds;
+
+    while ((res = getopt(argc, argv, "o:b:f:n:i:v:l:qt:")) >= 0)
+    {
+        switch (res)
+        {
+            case 'o': outName = optarg; break;
+            case 'b': bitrate = atoi(optarg); break;
+            case 'f': fps = atof(optarg); break;
+            case 'n': numFrames = atoi(optarg); break;
+            case 'i': idrPeriod = atoi(optarg); break;
+            case 'v': vbvMs = atoi(optarg); break;
+            case 'l': depth = atoi(optarg); break;
+            case 'q': aq = 1; break;
+            case 't': numThreads = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (argc - optind != 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    width = atoi(argv[optind + 1]);
+    height = atoi(argv[optind + 2]);
+    if (width <= 0 || height <= 0 || (width & 15) || (height & 15) || fps <= 0)
+    {
+        fprintf(stderr, "width and height must be multiples of 16\n");
+        return 1;
+    }
+
+    in = fopen(argv[optind], "rb");
+    if (in == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return 1;
+    }
+
+    if (outName != NULL)
+    {
+        out = fopen(outName, "wb");
+        if (out == NULL)
+        {
+            fprintf(stderr, "cannot open %s\n", outName);
+            return 1;
+        }
+    }
+
+    frameSize = (width * height * 3) >> 1;
+    frame = (uint8*) malloc(frameSize);
+    orig = (uint8*) malloc(frameSize);
+    lastRecon = (uint8*) calloc(1, frameSize);
+    output = (uint8*) malloc(OUTPUT_SIZE);
+    sliceGroup = (uint32*) calloc((width * height) >> 8, sizeof(uint32));
+
+    memset(&data, 0, sizeof(data));
+    memset(&stats, 0, sizeof(stats));
+
+    memset(&handle, 0, sizeof(handle));
+    handle.userData = &data;
+    handle.CBAVC_Malloc = CbMalloc;
+    handle.CBAVC_Free = CbFree;
+    handle.CBAVC_DPBAlloc = CbDPBAlloc;
+    handle.CBAVC_FrameBind = CbFrameBind;
+    handle.CBAVC_FrameUnbind = CbFrameUnbind;
+
+    /* same settings as SoftAVCEncoder */
+    memset(&params, 0, sizeof(params));
+    params.rate_control = AVC_ON;
+    params.initQP = 0;
+    params.init_CBP_removal_delay = vbvMs;
+    params.intramb_refresh = 0;
+    params.auto_scd = AVC_ON;
+    params.out_of_band_param_set = AVC_ON;
+    params.poc_type = 2;
+    params.log2_max_poc_lsb_minus_4 = 12;
+    params.delta_poc_zero_flag = 0;
+    params.use_overrun_buffer = AVC_OFF;
+    params.num_ref_frame = 1;
+    params.num_slice_group = 1;
+    params.slice_group = sliceGroup;
+    params.db_filter = AVC_ON;
+    params.disable_db_idc = 0;
+    params.alpha_offset = 0;
+    params.beta_offset = 0;
+    params.constrained_intra_pred = AVC_OFF;
+    params.data_par = AVC_OFF;
+    params.fullsearch = AVC_OFF;
+    params.search_range = 16;
+    params.sub_pel = AVC_OFF;
+    params.submb_pred = AVC_OFF;
+    params.rdopt_mode = AVC_OFF;
+    params.bidir_pred = AVC_OFF;
+    params.num_threads = numThreads;
+    params.width = width;
+    params.height = height;
+    params.bitrate = bitrate;
+    params.frame_rate = (uint32)(1000 * fps);
+    params.CPB_size = (uint32)((double)bitrate * vbvMs / 1000);
+    params.idr_period = (idrPeriod > 0) ? idrPeriod : -1;
+    params.profile = AVC_BASELINE;
+    params.level = AVC_LEVEL3_1;
+    params.lookahead_rc = (depth >= 0) ? AVC_ON : AVC_OFF;
+    params.lookahead_depth = (depth >= 0) ? depth : 0;
+    params.adaptive_quant = aq ? AVC_ON : AVC_OFF;
+
+    status = PVAVCEncInitialize(&handle, &params, NULL, NULL);
+    if (status != AVCENC_SUCCESS)
+    {
+        fprintf(stderr, "PVAVCEncInitialize failed: %d\n", status);
+        return 1;
+    }
+
+    /* SPS and PPS */
+    for (k = 0; k < 2; k++)
+    {
+        size = OUTPUT_SIZE;
+        status = PVAVCEncodeNAL(&handle, output, &size, &nalType);
+        if (status != AVCENC_SUCCESS)
+        {
+            fprintf(stderr, "failed to encode the parameter sets: %d\n", status);
+            return 1;
+        }
+        if (out != NULL)
+        {
+            fwrite("\0\0\0\1", 1, 4, out);
+            fwrite(output, 1, size, out);
+        }
+    }
+
+    /* decoder buffer, filled at the bit rate and starting with the initial removal delay */
+    bitsPerFrame = bitrate / fps;
+    bufferSize = params.CPB_size;
+    buffer = bufferSize;
+
+    while (1)
+    {
+        if (!flushing)
+        {
+            if ((numFrames >= 0 && numRead >= numFrames) || !ReadFrame(in, numRead, frame, frameSize))
+            {
+                flushing = 1;
+            }
+        }
+
+        if (flushing)
+        {
+            status = PVAVCEncSetInput(&handle, NULL);
+            if (status == AVCENC_NO_PICTURE)
+            {
+                break;
+            }
+        }
+        else
+        {
+            memset(&input, 0, sizeof(input));
+            input.id = numRead;
+            input.YCbCr[0] = frame;
+            input.YCbCr[1] = frame + width * height;
+            input.YCbCr[2] = input.YCbCr[1] + (width * height >> 2);
+            input.pitch = width;
+            input.height = height;
+            input.coding_timestamp = (uint32)(numRead * 1000 / fps + 0.5);
+            input.disp_order = numRead;
+
+            pending[numPending++] = numRead++;
+
+            status = PVAVCEncSetInput(&handle, &input);
+            if (status == AVCENC_PICTURE_QUEUED)
+            {
+                continue;
+            }
+        }
+
+        if (status == AVCENC_SKIPPED_PICTURE)
+        {
+            /* the decoder shows the previous frame again */
+            if (ReadFrame(in, pending[0], orig, frameSize))
+            {
+                recon.YCbCr[0] = lastRecon;
+                recon.YCbCr[1] = lastRecon + width * height;
+                recon.YCbCr[2] = recon.YCbCr[1] + (width * height >> 2);
+                recon.pitch = width;
+                AddPSNR(&stats, orig, &recon, width, height);
+            }
+            numSkipped++;
+            numPending--;
+            memmove(pending, pending + 1, numPending * sizeof(int));
+            buffer = RefillBuffer(buffer, bitsPerFrame, bufferSize);
+            continue;
+        }
+        else if (status != AVCENC_SUCCESS && status != AVCENC_NEW_IDR)
+        {
+            fprintf(stderr, "PVAVCEncSetInput failed: %d\n", status);
+            return 1;
+        }
+
+        frameBits = 0;
+        do
+        {
+            size = OUTPUT_SIZE;
+            status = PVAVCEncodeNAL(&handle, output, &size, &nalType);
+            if (status == AVCENC_SUCCESS || status == AVCENC_PICTURE_READY)
+            {
+                frameBits += size * 8;
+                if (out != NULL)
+                {
+                    fwrite("\0\0\0\1", 1, 4, out);
+                    fwrite(output, 1, size, out);
+                }
+            }
+            else if (status != AVCENC_SKIPPED_PICTURE)
+            {
+                fprintf(stderr, "PVAVCEncodeNAL failed: %d\n", status);
+                return 1;
+            }
+        }
+        while (status == AVCENC_SUCCESS);
+
+        if (!ReadFrame(in, pending[0], orig, frameSize))
+        {
+            fprintf(stderr, "cannot read back frame %d\n", pending[0]);
+            return 1;
+        }
+        numPending--;
+        memmove(pending, pending + 1, numPending * sizeof(int));
+
+        if (status == AVCENC_SKIPPED_PICTURE)
+        {
+            recon.YCbCr[0] = lastRecon;
+            recon.YCbCr[1] = lastRecon + width * height;
+            recon.YCbCr[2] = recon.YCbCr[1] + (width * height >> 2);
+            recon.pitch = width;
+            AddPSNR(&stats, orig, &recon, width, height);
+            numSkipped++;
+            buffer = RefillBuffer(buffer, bitsPerFrame, bufferSize);
+            continue;
+        }
+
+        PVAVCEncGetRecon(&handle, &recon);
+        AddPSNR(&stats, orig, &recon, width, height);
+        for (k = 0; k < height; k++)
+        {
+            memcpy(lastRecon + k * width, recon.YCbCr[0] + k * recon.pitch, width);
+        }
+        for (k = 0; k < (height >> 1); k++)
+        {
+            memcpy(lastRecon + width * height + k * (width >> 1),
+                   recon.YCbCr[1] + k * (recon.pitch >> 1), width >> 1);
+            memcpy(lastRecon + ((width * height * 5) >> 2) + k * (width >> 1),
+                   recon.YCbCr[2] + k * (recon.pitch >> 1), width >> 1);
+        }
+        PVAVCEncReleaseRecon(&handle, &recon);
+
+        /* the frame is removed from the buffer at once, the buffer fills up between frames */
+        if (frameBits > buffer)
+        {
+            numUnderflows++;
+        }
+        buffer = RefillBuffer(buffer - frameBits, bitsPerFrame, bufferSize);
+
+        totalBits += frameBits;
+        numEncoded++;
+    }
+
+    PVAVCCleanUpEncoder(&handle);
+
+    seconds = numRead / fps;
+    printf("frames        %d read, %d encoded, %d skipped\n", numRead, numEncoded, numSkipped);
+    if (seconds > 0)
+    {
+        printf("bitrate       %.0f bps, target %d bps, error %+.2f%%\n",
+               totalBits / seconds, bitrate, 100.0 * (totalBits / seconds - bitrate) / bitrate);
+    }
+    if (stats.numFrames > 0)
+    {
+        printf("psnr          Y %.2f U %.2f V %.2f dB\n",
+               PSNR(stats.sse[0], width * height, stats.numFrames),
+               PSNR(stats.sse[1], width * height >> 2, stats.numFrames),
+               PSNR(stats.sse[2], width * height >> 2, stats.numFrames));
+    }
+    printf("vbv underflow %d frames\n", numUnderflows);
+
+    for (k = 0; k < data.numDpb; k++)
+    {
+        free(data.dpb[k]);
+    }
+    free(sliceGroup);
+    free(output);
+    free(lastRecon);
+    free(orig);
+    free(frame);
+
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+    fclose(in);
+
+    return 0;
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drives the software AVC encoder through its OMX interface, the way ACodec
+// and OMXCodec do, to check that every frame comes out and the output EOS is
+// signalled whatever the rate control lookahead depth.
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <OMX_Component.h>
+#include <OMX_Core.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <utils/List.h>
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+#include "avcenc_api.h"
+#include "RateControlLookahead.h"
+#include "SoftOMXComponent.h"
+
+extern android::SoftOMXComponent *createSoftOMXComponent(
+        const char *name, const OMX_CALLBACKTYPE *callbacks,
+        OMX_PTR appData, OMX_COMPONENTTYPE **component);
+
+namespace android {
+
+template<class T>
+static void InitOMXParams(T *params) {
+    memset(params, 0, sizeof(T));
+    params->nSize = sizeof(T);
+    params->nVersion.s.nVersionMajor = 1;
+    params->nVersion.s.nVersionMinor = 0;
+    params->nVersion.s.nRevision = 0;
+    params->nVersion.s.nStep = 0;
+}
+
+class SoftAVCEncoderTest : public ::testing::Test {
+protected:
+    enum {
+        kNumFrames = 40,
+        kFrameDurationUs = 33333,
+    };
+
+    // Longest a callback may take to arrive before the component is
+    // considered hung.
+    static const int64_t kTimeoutNs = 5000000000ll;
+
+    struct Event {
+        enum Type {
+            EVENT,
+            EMPTY_BUFFER_DONE,
+            FILL_BUFFER_DONE,
+        };
+
+        Type mType;
+        OMX_EVENTTYPE mEvent;
+        OMX_U32 mData1;
+        OMX_U32 mData2;
+        OMX_BUFFERHEADERTYPE *mHeader;
+    };
+
+    sp<SoftOMXComponent> mComponent;
+    OMX_COMPONENTTYPE *mHandle;
+
+    Mutex mLock;
+    Condition mCondition;
+    List<Event> mEvents;
+
+    Vector<OMX_BUFFERHEADERTYPE *> mBuffers[2];
+
+    SoftAVCEncoderTest()
+        : mHandle(NULL) {
+    }
+
+    virtual void SetUp() {
+        static const OMX_CALLBACKTYPE kCallbacks = {
+            &OnEvent, &OnEmptyBufferDone, &OnFillBufferDone
+        };
+
+        mComponent = createSoftOMXComponent(
+                "OMX.google.h264.encoder", &kCallbacks, this, &mHandle);
+        ASSERT_TRUE(mComponent != NULL);
+    }
+
+    virtual void TearDown() {
+        if (mComponent != NULL) {
+            mComponent->prepareForDestruction();
+            mComponent.clear();
+        }
+    }
+
+    static OMX_ERRORTYPE OnEvent(
+            OMX_HANDLETYPE component, OMX_PTR appData,
+            OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2,
+            OMX_PTR eventData) {
+        Event e;
+        e.mType = Event::EVENT;
+        e.mEvent = event;
+        e.mData1 = data1;
+        e.mData2 = data2;
+        e.mHeader = NULL;
+        static_cast<SoftAVCEncoderTest *>(appData)->post(e);
+        return OMX_ErrorNone;
+    }
+
+    static OMX_ERRORTYPE OnEmptyBufferDone(
+            OMX_HANDLETYPE component, OMX_PTR appData,
+            OMX_BUFFERHEADERTYPE *header) {
+        Event e;
+        e.mType = Event::EMPTY_BUFFER_DONE;
+        e.mHeader = header;
+        static_cast<SoftAVCEncoderTest *>(appData)->post(e);
+        return OMX_ErrorNone;
+    }
+
+    static OMX_ERRORTYPE OnFillBufferDone(
+            OMX_HANDLETYPE component, OMX_PTR appData,
+            OMX_BUFFERHEADERTYPE *header) {
+        Event e;
+        e.mType = Event::FILL_BUFFER_DONE;
+        e.mHeader = header;
+        static_cast<SoftAVCEncoderTest *>(appData)->post(e);
+        return OMX_ErrorNone;
+    }
+
+    void post(const Event &e) {
+        Mutex::Autolock autoLock(mLock);
+        mEvents.push_back(e);
+        mCondition.signal();
+    }
+
+    bool dequeueEvent(Event *e) {
+        Mutex::Autolock autoLock(mLock);
+        while (mEvents.empty()) {
+            if (mCondition.waitRelative(mLock, kTimeoutNs) != OK) {
+                return false;
+            }
+        }
+        *e = *mEvents.begin();
+        mEvents.erase(mEvents.begin());
+        return true;
+    }
+
+    // Waits for a state transition to complete, buffers returned meanwhile
+    // are put aside in "returned".
+    bool waitForState(
+            OMX_STATETYPE state, Vector<OMX_BUFFERHEADERTYPE *> *returned) {
+        Event e;
+        while (dequeueEvent(&e)) {
+            if (e.mType != Event::EVENT) {
+                returned->push(e.mHeader);
+                continue;
+            }
+            if (e.mEvent == OMX_EventCmdComplete
+                    && e.mData1 == OMX_CommandStateSet
+                    && e.mData2 == (OMX_U32)state) {
+                return true;
+            }
+            if (e.mEvent == OMX_EventError) {
+                ADD_FAILURE() << "OMX error " << (int32_t)e.mData1;
+                return false;
+            }
+        }
+        ADD_FAILURE() << "timed out waiting for state " << state;
+        return false;
+    }
+
+    void setLookahead(OMX_U32 numFrames) {
+        OMX_INDEXTYPE index;
+        ASSERT_EQ(OMX_ErrorNone, OMX_GetExtensionIndex(
+                mHandle,
+                const_cast<OMX_STRING>(
+                    "OMX.google.android.index.rateControlLookahead"),
+                &index));
+
+        RateControlLookaheadParams params;
+        InitOMXParams(&params);
+        params.nPortIndex = 1;
+        params.bEnable = numFrames > 0 ? OMX_TRUE : OMX_FALSE;
+        params.nLookaheadFrames = numFrames;
+        params.nVBVSizeMs = 0;
+        params.bAdaptiveQuantization = OMX_FALSE;
+        ASSERT_EQ(OMX_ErrorNone, OMX_SetParameter(mHandle, index, &params));
+    }
+
+    void allocateBuffers(OMX_U32 portIndex) {
+        OMX_PARAM_PORTDEFINITIONTYPE def;
+        InitOMXParams(&def);
+        def.nPortIndex = portIndex;
+        ASSERT_EQ(OMX_ErrorNone, OMX_GetParameter(
+                mHandle, OMX_IndexParamPortDefinition, &def));
+
+        for (OMX_U32 i = 0; i < def.nBufferCountActual; ++i) {
+            OMX_BUFFERHEADERTYPE *header;
+            ASSERT_EQ(OMX_ErrorNone, OMX_AllocateBuffer(
+                    mHandle, &header, portIndex, NULL, def.nBufferSize));
+            mBuffers[portIndex].push(header);
+        }
+    }
+
+    void freeBuffers(OMX_U32 portIndex) {
+        for (size_t i = 0; i < mBuffers[portIndex].size(); ++i) {
+            EXPECT_EQ(OMX_ErrorNone, OMX_FreeBuffer(
+                    mHandle, portIndex, mBuffers[portIndex][i]));
+        }
+        mBuffers[portIndex].clear();
+    }
+
+    // A slowly moving gradient, cheap to encode so that the rate control
+    // never has to skip a frame.
+    static void fillFrame(OMX_BUFFERHEADERTYPE *header, int32_t index) {
+        const size_t kWidth = 176;
+        const size_t kHeight = 144;
+        uint8_t *data = header->pBuffer;
+
+        for (size_t y = 0; y < kHeight; ++y) {
+            for (size_t x = 0; x < kWidth; ++x) {
+                data[y * kWidth + x] = (uint8_t)(x + y + index);
+            }
+        }
+        memset(data + kWidth * kHeight, 128, kWidth * kHeight / 2);
+
+        header->nOffset = 0;
+        header->nFilledLen = kWidth * kHeight * 3 / 2;
+        header->nFlags = 0;
+        header->nTimeStamp = (OMX_TICKS)index * kFrameDurationUs;
+    }
+
+    // Encodes kNumFrames frames followed by an empty EOS buffer. Returns the
+    // number of coded frames, or -1 if the output EOS never came.
+    int32_t encode(OMX_U32 lookaheadFrames) {
+        setLookahead(lookaheadFrames);
+
+        Vector<OMX_BUFFERHEADERTYPE *> returned;
+
+        EXPECT_EQ(OMX_ErrorNone, OMX_SendCommand(
+                mHandle, OMX_CommandStateSet, OMX_StateIdle, NULL));
+        allocateBuffers(0);
+        allocateBuffers(1);
+        if (!waitForState(OMX_StateIdle, &returned)) {
+            return -1;
+        }
+
+        EXPECT_EQ(OMX_ErrorNone, OMX_SendCommand(
+                mHandle, OMX_CommandStateSet, OMX_StateExecuting, NULL));
+        if (!waitForState(OMX_StateExecuting, &returned)) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < mBuffers[1].size(); ++i) {
+            EXPECT_EQ(OMX_ErrorNone, OMX_FillThisBuffer(mHandle, mBuffers[1][i]));
+        }
+
+        int32_t numQueued = 0;
+        bool queuedEOS = false;
+        for (size_t i = 0; i < mBuffers[0].size(); ++i) {
+            fillFrame(mBuffers[0][i], numQueued++);
+            EXPECT_EQ(OMX_ErrorNone, OMX_EmptyThisBuffer(mHandle, mBuffers[0][i]));
+        }
+
+        int32_t numCoded = 0;
+        int64_t lastTimeUs = -1;
+        bool sawOutputEOS = false;
+        while (!sawOutputEOS) {
+            Event e;
+            if (!dequeueEvent(&e)) {
+                ADD_FAILURE() << "no output EOS, " << numCoded << " of "
+                        << (int32_t)kNumFrames << " frames coded with a "
+                        << lookaheadFrames << " frames lookahead";
+                break;
+            }
+
+            if (e.mType == Event::EVENT) {
+                EXPECT_NE(OMX_EventError, e.mEvent)
+                        << "OMX error " << (int32_t)e.mData1;
+                if (e.mEvent == OMX_EventError) {
+                    break;
+                }
+                continue;
+            }
+
+            OMX_BUFFERHEADERTYPE *header = e.mHeader;
+            if (e.mType == Event::EMPTY_BUFFER_DONE) {
+                if (numQueued < kNumFrames) {
+                    fillFrame(header, numQueued++);
+                } else if (!queuedEOS) {
+                    header->nOffset = 0;
+                    header->nFilledLen = 0;
+                    header->nFlags = OMX_BUFFERFLAG_EOS;
+                    header->nTimeStamp = 0;
+                    queuedEOS = true;
+                } else {
+                    continue;
+                }
+                EXPECT_EQ(OMX_ErrorNone, OMX_EmptyThisBuffer(mHandle, header));
+                continue;
+            }
+
+            if (header->nFlags & OMX_BUFFERFLAG_EOS) {
+                sawOutputEOS = true;
+            }
+            if (!(header->nFlags & OMX_BUFFERFLAG_CODECCONFIG)
+                    && header->nFilledLen > 0) {
+                EXPECT_GT(header->nTimeStamp, lastTimeUs);
+                lastTimeUs = header->nTimeStamp;
+                ++numCoded;
+            }
+            if (!sawOutputEOS) {
+                EXPECT_EQ(OMX_ErrorNone, OMX_FillThisBuffer(mHandle, header));
+            }
+        }
+
+        EXPECT_EQ(OMX_ErrorNone, OMX_SendCommand(
+                mHandle, OMX_CommandStateSet, OMX_StateIdle, NULL));
+        waitForState(OMX_StateIdle, &returned);
+
+        EXPECT_EQ(OMX_ErrorNone, OMX_SendCommand(
+                mHandle, OMX_CommandStateSet, OMX_StateLoaded, NULL));
+        freeBuffers(0);
+        freeBuffers(1);
+        waitForState(OMX_StateLoaded, &returned);
+
+        return sawOutputEOS ? numCoded : -1;
+    }
+};
+
+TEST_F(SoftAVCEncoderTest, EOSWithoutLookahead) {
+    EXPECT_EQ((int32_t)kNumFrames, encode(0));
+}
+
+TEST_F(SoftAVCEncoderTest, EOSWithLookaheadOfOutputBufferCount) {
+    EXPECT_EQ((int32_t)kNumFrames, encode(2));
+}
+
+// The lookahead holds more frames than there are output buffers, so they
+// are drained over several output buffer round trips after the input EOS.
+TEST_F(SoftAVCEncoderTest, EOSWithLookaheadDeeperThanOutputBuffers) {
+    EXPECT_EQ((int32_t)kNumFrames, encode(8));
+}
+
+TEST_F(SoftAVCEncoderTest, EOSWithMaximumLookahead) {
+    EXPECT_EQ((int32_t)kNumFrames, encode(MAX_LOOKAHEAD_DEPTH));
+}
+
+}  // namespace android
@@ -46,6 +46,12 @@ LOCAL_C_INCLUDES := \
 
 LOCAL_CFLAGS := -DOSCL_EXPORT_REF= -DOSCL_IMPORT_REF=
 
+# SSE2 versions of the IDCT, motion compensation and post-filters,
+# used when the CPU supports SSE2
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DM4VH263DEC_SSE2
+endif
+
 include $(BUILD_STATIC_LIBRARY)
 
 ################################################################################
@@ -73,3 +79,7 @@ LOCAL_MODULE := libstagefright_soft_mpeg4dec
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
+
+################################################################################
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
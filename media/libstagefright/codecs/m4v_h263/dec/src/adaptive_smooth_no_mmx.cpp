@@ -171,6 +171,9 @@
 #include    "mp4dec_lib.h"
 #include    "post_proc.h"
 #include    "mp4def.h"
+#ifdef M4VH263DEC_SSE2
+#include    <emmintrin.h>
+#endif
 
 #define OSCL_DISABLE_WARNING_CONV_POSSIBLE_LOSS_OF_DATA
 
@@ -418,4 +421,83 @@ void AdaptiveSmooth_NoMMX(
     ----------------------------------------------------------------------------*/
     return;
 }
+
+#ifdef M4VH263DEC_SSE2
+/*----------------------------------------------------------------------------
+; SSE2 version of AdaptiveSmooth_NoMMX(img, 0, 0, 1, 1, thres, incr, mxdf):
+; img points to the top-left pixel of the 10x10 region around the 8x8 block
+; that is smoothed, incr is the width of the picture. Like the C version it
+; filters from the unmodified pixels, so each row of 8 is done at once.
+----------------------------------------------------------------------------*/
+void DeringAdaptiveSmoothMMX(
+    uint8 *img,     /* i/o  */
+    int incr,       /* i    */
+    int thres,      /* i    */
+    int mxdf        /* i    */
+)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thr = _mm_set1_epi16(thres - 1);
+    const __m128i diff = _mm_set1_epi16(mxdf);
+    __m128i pel[3][3];  /* rows above/at/below, columns left/center/right */
+    __m128i sum[3], idx[3], cnt, avg, orig, res, mask;
+    uint8 *ptr;
+    int row, k;
+
+    if (!PVCpuHasSSE2)
+    {
+        AdaptiveSmooth_NoMMX(img, 0, 0, 1, 1, thres, incr, mxdf);
+        return;
+    }
+
+    for (k = 0; k < 3; k++)
+    {
+        pel[0][k] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(img + k)), zero);
+        pel[1][k] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(img + incr + k)), zero);
+    }
+
+    ptr = img + incr;
+    for (row = BLKSIZE; row > 0; row--)
+    {
+        for (k = 0; k < 3; k++)
+        {
+            pel[2][k] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(ptr + incr + k)), zero);
+
+            /* weighted column sums and number of pixels at or above thres,
+               counted as -1 per pixel */
+            sum[k] = _mm_add_epi16(_mm_add_epi16(pel[0][k], pel[2][k]),
+                                   _mm_slli_epi16(pel[1][k], 1));
+            idx[k] = _mm_add_epi16(_mm_add_epi16(_mm_cmpgt_epi16(pel[0][k], thr),
+                                                 _mm_cmpgt_epi16(pel[2][k], thr)),
+                                   _mm_cmpgt_epi16(pel[1][k], thr));
+        }
+
+        avg = _mm_add_epi16(_mm_add_epi16(sum[0], sum[2]), _mm_slli_epi16(sum[1], 1));
+        avg = _mm_srli_epi16(_mm_add_epi16(avg, _mm_set1_epi16(8)), 4);
+
+        /* change the pixel by at most mxdf */
+        orig = pel[1][1];
+        avg = _mm_max_epi16(_mm_min_epi16(avg, _mm_add_epi16(orig, diff)),
+                            _mm_sub_epi16(orig, diff));
+
+        /* only where all 9 pixels are on the same side of thres */
+        cnt = _mm_add_epi16(_mm_add_epi16(idx[0], idx[1]), idx[2]);
+        mask = _mm_or_si128(_mm_cmpeq_epi16(cnt, zero),
+                            _mm_cmpeq_epi16(cnt, _mm_set1_epi16(-9)));
+        res = _mm_or_si128(_mm_and_si128(mask, avg), _mm_andnot_si128(mask, orig));
+
+        _mm_storel_epi64((__m128i*)(ptr + 1), _mm_packus_epi16(res, res));
+
+        /* move down, the row just filtered is used unmodified */
+        for (k = 0; k < 3; k++)
+        {
+            pel[0][k] = pel[1][k];
+            pel[1][k] = pel[2][k];
+        }
+        ptr += incr;
+    }
+
+    return;
+}
+#endif /* M4VH263DEC_SSE2 */
 #endif
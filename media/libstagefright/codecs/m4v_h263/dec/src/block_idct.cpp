@@ -102,6 +102,9 @@
 #include "mp4dec_lib.h"
 #include "idct.h"
 #include "motion_comp.h"
+#ifdef M4VH263DEC_SSE2
+#include <emmintrin.h>
+#endif
 
 #define OSCL_DISABLE_WARNING_CONV_POSSIBLE_LOSS_OF_DATA
 /*----------------------------------------------------------------------------
@@ -123,6 +126,9 @@
 static void idctrow(int16 *blk, uint8 *pred, uint8 *dst, int width);
 static void idctrow_intra(int16 *blk, PIXEL *, int width);
 static void idctcol(int16 *blk);
+#ifdef M4VH263DEC_SSE2
+static void idct_sse2(int16 *blk, uint8 *pred, uint8 *dst, int width);
+#endif
 
 #ifdef FAST_IDCT
 // mapping from nz_coefs to functions to be used
@@ -277,6 +283,13 @@ void BlockIDCT_intra(
     }
     else
     {
+#ifdef M4VH263DEC_SSE2
+        if (PVCpuHasSSE2)
+        {
+            idct_sse2(coeff_in, NULL, c_comp, width);
+            return;
+        }
+#endif
         i = 8;
         while (i--)
         {
@@ -374,6 +387,13 @@ void BlockIDCT(
     }
     else
     {
+#ifdef M4VH263DEC_SSE2
+        if (PVCpuHasSSE2)
+        {
+            idct_sse2(coeff_in, pred, dst, width);
+            return ;
+        }
+#endif
         i = 8;
 
         while (i--)
@@ -909,3 +929,178 @@ void idctcol(
 ;  End Function: idctcol
 ----------------------------------------------------------------------------*/
 
+#ifdef M4VH263DEC_SSE2
+/*----------------------------------------------------------------------------
+; SSE2 version of the full 8x8 IDCT, idctcol() on all columns followed by
+; idctrow() or idctrow_intra(). Both passes run 8 columns or rows at a time
+; with the same arithmetic as the C code, the products are formed with
+; pmaddwd on interleaved coefficient pairs, so the output is bit-exact.
+----------------------------------------------------------------------------*/
+#define IDCT_PAIR(a, b)     _mm_set_epi16((b), (a), (b), (a), (b), (a), (b), (a))
+
+/* 181*x in 32 bits, SSE2 has no 32-bit multiply, 181 = 128+32+16+4+1 */
+static inline __m128i idct_mul181(__m128i x)
+{
+    __m128i y = _mm_add_epi32(_mm_slli_epi32(x, 7), _mm_slli_epi32(x, 5));
+    y = _mm_add_epi32(y, _mm_slli_epi32(x, 4));
+    y = _mm_add_epi32(y, _mm_slli_epi32(x, 2));
+    return _mm_add_epi32(y, x);
+}
+
+/* one 1-D pass on 4 lanes, p04, p26, p17 and p53 hold the interleaved
+   inputs (b0,b4), (b2,b6), (b1,b7) and (b5,b3), out[k] gets output k
+   before the final shift. row selects the idctrow() scaling. */
+static inline void idct_1d_sse2(__m128i p04, __m128i p26, __m128i p17, __m128i p53,
+                                int row, __m128i *out)
+{
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    if (row)
+    {
+        const __m128i rnd = _mm_set1_epi32(4);
+
+        x8 = _mm_add_epi32(_mm_madd_epi16(p04, IDCT_PAIR(256, 256)), _mm_set1_epi32(8192));
+        x0 = _mm_add_epi32(_mm_madd_epi16(p04, IDCT_PAIR(256, -256)), _mm_set1_epi32(8192));
+        x4 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p17, IDCT_PAIR(W1, W7)), rnd), 3);
+        x5 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p17, IDCT_PAIR(W7, -W1)), rnd), 3);
+        x6 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p53, IDCT_PAIR(W5, W3)), rnd), 3);
+        x7 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p53, IDCT_PAIR(W3, -W5)), rnd), 3);
+        x2 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p26, IDCT_PAIR(W6, -W2)), rnd), 3);
+        x3 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p26, IDCT_PAIR(W2, W6)), rnd), 3);
+    }
+    else
+    {
+        x8 = _mm_add_epi32(_mm_madd_epi16(p04, IDCT_PAIR(2048, 2048)), _mm_set1_epi32(128));
+        x0 = _mm_add_epi32(_mm_madd_epi16(p04, IDCT_PAIR(2048, -2048)), _mm_set1_epi32(128));
+        x4 = _mm_madd_epi16(p17, IDCT_PAIR(W1, W7));
+        x5 = _mm_madd_epi16(p17, IDCT_PAIR(W7, -W1));
+        x6 = _mm_madd_epi16(p53, IDCT_PAIR(W5, W3));
+        x7 = _mm_madd_epi16(p53, IDCT_PAIR(W3, -W5));
+        x2 = _mm_madd_epi16(p26, IDCT_PAIR(W6, -W2));
+        x3 = _mm_madd_epi16(p26, IDCT_PAIR(W2, W6));
+    }
+
+    /* second stage */
+    x1 = _mm_add_epi32(x4, x6);
+    x4 = _mm_sub_epi32(x4, x6);
+    x6 = _mm_add_epi32(x5, x7);
+    x5 = _mm_sub_epi32(x5, x7);
+
+    /* third stage */
+    x7 = _mm_add_epi32(x8, x3);
+    x8 = _mm_sub_epi32(x8, x3);
+    x3 = _mm_add_epi32(x0, x2);
+    x0 = _mm_sub_epi32(x0, x2);
+    x2 = _mm_srai_epi32(_mm_add_epi32(idct_mul181(_mm_add_epi32(x4, x5)), _mm_set1_epi32(128)), 8);
+    x4 = _mm_srai_epi32(_mm_add_epi32(idct_mul181(_mm_sub_epi32(x4, x5)), _mm_set1_epi32(128)), 8);
+
+    /* fourth stage */
+    out[0] = _mm_add_epi32(x7, x1);
+    out[1] = _mm_add_epi32(x3, x2);
+    out[2] = _mm_add_epi32(x0, x4);
+    out[3] = _mm_add_epi32(x8, x6);
+    out[4] = _mm_sub_epi32(x8, x6);
+    out[5] = _mm_sub_epi32(x0, x4);
+    out[6] = _mm_sub_epi32(x3, x2);
+    out[7] = _mm_sub_epi32(x7, x1);
+}
+
+/* 1-D pass on 8 lanes of 16 bits, v[k] holds input and output k. idctcol()
+   stores its result in int16, so the column pass wraps to 16 bits, the row
+   pass saturates which does not change the clipped pixel. */
+static void idct_pass_sse2(__m128i *v, int row)
+{
+    __m128i lo[8], hi[8];
+    int k;
+
+    idct_1d_sse2(_mm_unpacklo_epi16(v[0], v[4]), _mm_unpacklo_epi16(v[2], v[6]),
+                 _mm_unpacklo_epi16(v[1], v[7]), _mm_unpacklo_epi16(v[5], v[3]), row, lo);
+    idct_1d_sse2(_mm_unpackhi_epi16(v[0], v[4]), _mm_unpackhi_epi16(v[2], v[6]),
+                 _mm_unpackhi_epi16(v[1], v[7]), _mm_unpackhi_epi16(v[5], v[3]), row, hi);
+
+    for (k = 0; k < 8; k++)
+    {
+        if (row)
+        {
+            lo[k] = _mm_srai_epi32(lo[k], 14);
+            hi[k] = _mm_srai_epi32(hi[k], 14);
+        }
+        else
+        {
+            lo[k] = _mm_srai_epi32(_mm_slli_epi32(lo[k], 8), 16);
+            hi[k] = _mm_srai_epi32(_mm_slli_epi32(hi[k], 8), 16);
+        }
+        v[k] = _mm_packs_epi32(lo[k], hi[k]);
+    }
+}
+
+static void idct_transpose_sse2(__m128i *v)
+{
+    __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+    a0 = _mm_unpacklo_epi16(v[0], v[1]);
+    a1 = _mm_unpackhi_epi16(v[0], v[1]);
+    a2 = _mm_unpacklo_epi16(v[2], v[3]);
+    a3 = _mm_unpackhi_epi16(v[2], v[3]);
+    a4 = _mm_unpacklo_epi16(v[4], v[5]);
+    a5 = _mm_unpackhi_epi16(v[4], v[5]);
+    a6 = _mm_unpacklo_epi16(v[6], v[7]);
+    a7 = _mm_unpackhi_epi16(v[6], v[7]);
+
+    b0 = _mm_unpacklo_epi32(a0, a2);
+    b1 = _mm_unpackhi_epi32(a0, a2);
+    b2 = _mm_unpacklo_epi32(a1, a3);
+    b3 = _mm_unpackhi_epi32(a1, a3);
+    b4 = _mm_unpacklo_epi32(a4, a6);
+    b5 = _mm_unpackhi_epi32(a4, a6);
+    b6 = _mm_unpacklo_epi32(a5, a7);
+    b7 = _mm_unpackhi_epi32(a5, a7);
+
+    v[0] = _mm_unpacklo_epi64(b0, b4);
+    v[1] = _mm_unpackhi_epi64(b0, b4);
+    v[2] = _mm_unpacklo_epi64(b1, b5);
+    v[3] = _mm_unpackhi_epi64(b1, b5);
+    v[4] = _mm_unpacklo_epi64(b2, b6);
+    v[5] = _mm_unpackhi_epi64(b2, b6);
+    v[6] = _mm_unpacklo_epi64(b3, b7);
+    v[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/* pred has a pitch of 16, NULL for intra blocks. blk is cleared on return
+   like the C row functions do. */
+void idct_sse2(int16 *blk, uint8 *pred, uint8 *dst, int width)
+{
+    __m128i v[8], p;
+    const __m128i zero = _mm_setzero_si128();
+    int k;
+
+    for (k = 0; k < 8; k++)
+    {
+        v[k] = _mm_loadu_si128((__m128i*)(blk + (k << 3)));
+    }
+
+    /* columns, lanes are the 8 columns */
+    idct_pass_sse2(v, 0);
+
+    /* rows, after the transpose lanes are the 8 rows and v[k] is column k */
+    idct_transpose_sse2(v);
+    idct_pass_sse2(v, 1);
+    idct_transpose_sse2(v);
+
+    for (k = 0; k < 8; k++)
+    {
+        if (pred)
+        {
+            p = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)pred), zero);
+            v[k] = _mm_adds_epi16(v[k], p);
+            pred += 16;
+        }
+        _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(v[k], v[k]));
+        _mm_storeu_si128((__m128i*)(blk + (k << 3)), zero);
+        dst += width;
+    }
+
+    return ;
+}
+#endif /* M4VH263DEC_SSE2 */
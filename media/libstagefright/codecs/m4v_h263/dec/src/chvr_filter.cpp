@@ -454,8 +454,9 @@ void CombinedHorzVertRingFilter(
                                     if ((max_blk - min_blk) >= DERING_THR) /*smooth 8x8 region*/
 #ifndef NoMMX
                                     {
-                                        /* smooth all pixels in the block*/
-                                        DeringAdaptiveSmoothMMX(ptr, width, thres, max_diff);
+                                        /* smooth all pixels in the block, the region
+                                           starts one row above and one pixel left of it */
+                                        DeringAdaptiveSmoothMMX(ptr - width - 1, width, thres, max_diff);
                                     }
 #else
                                     {
@@ -93,6 +93,9 @@ found and the location pointed to by max_ptr contains the maximum value found.
 ----------------------------------------------------------------------------*/
 #include    "mp4dec_lib.h"
 #include    "post_proc.h"
+#ifdef M4VH263DEC_SSE2
+#include    <emmintrin.h>
+#endif
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -144,6 +147,33 @@ void  FindMaxMin(
     /*----------------------------------------------------------------------------
     ; Function body here
     ----------------------------------------------------------------------------*/
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        __m128i vmin, vmax, row;
+
+        vmin = vmax = _mm_loadl_epi64((__m128i*)input_ptr);
+        for (i = BLKSIZE - 1; i > 0; i--)
+        {
+            input_ptr += (incr + BLKSIZE);
+            row = _mm_loadl_epi64((__m128i*)input_ptr);
+            vmin = _mm_min_epu8(vmin, row);
+            vmax = _mm_max_epu8(vmax, row);
+        }
+
+        /* fold the 8 bytes */
+        vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 4));
+        vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 2));
+        vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 1));
+        vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 4));
+        vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 2));
+        vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 1));
+
+        *max_ptr = _mm_cvtsi128_si32(vmax) & 0xFF;
+        *min_ptr = _mm_cvtsi128_si32(vmin) & 0xFF;
+        return;
+    }
+#endif
     max = min = *input_ptr;
     /*  incr = incr - BLKSIZE; */   /*  09/06/2001, already passed in as width - BLKSIZE */
 
@@ -76,9 +76,19 @@
 ----------------------------------------------------------------------------*/
 #include "mp4dec_lib.h"
 #include "motion_comp.h"
+#ifdef M4VH263DEC_SSE2
+#include <emmintrin.h>
+#endif
 
 #define OSCL_DISABLE_WARNING_CONV_POSSIBLE_LOSS_OF_DATA
 
+#ifdef M4VH263DEC_SSE2
+static int GetPredAdvancedBy0x0_SSE2(uint8 *prev, uint8 *pred_block, int width, int pred_width_rnd);
+static int GetPredAdvancedBy0x1_SSE2(uint8 *prev, uint8 *pred_block, int width, int pred_width_rnd);
+static int GetPredAdvancedBy1x0_SSE2(uint8 *prev, uint8 *pred_block, int width, int pred_width_rnd);
+static int GetPredAdvancedBy1x1_SSE2(uint8 *prev, uint8 *pred_block, int width, int pred_width_rnd);
+#endif
+
 int GetPredAdvancedBy0x0(
     uint8 *prev,        /* i */
     uint8 *pred_block,      /* i */
@@ -91,6 +101,13 @@ int GetPredAdvancedBy0x0(
     uint32  pred_word, word1, word2;
     int tmp;
 
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        return GetPredAdvancedBy0x0_SSE2(prev, pred_block, width, pred_width_rnd);
+    }
+#endif
+
     /* initialize offset to adjust pixel counter */
     /*    the next row; full-pel resolution      */
     offset = width - B_SIZE; /* offset for prev */
@@ -193,6 +210,13 @@ int GetPredAdvancedBy0x1(
     int rnd1;
     uint32 mask;
 
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        return GetPredAdvancedBy0x1_SSE2(prev, pred_block, width, pred_width_rnd);
+    }
+#endif
+
     /* initialize offset to adjust pixel counter */
     /*    the next row; full-pel resolution      */
     offset = width - B_SIZE; /* offset for prev */
@@ -522,6 +546,13 @@ int GetPredAdvancedBy1x0(
     int rnd1;
     uint32 mask;
 
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        return GetPredAdvancedBy1x0_SSE2(prev, pred_block, width, pred_width_rnd);
+    }
+#endif
+
     /* initialize offset to adjust pixel counter */
     /*    the next row; full-pel resolution      */
     offset = width - B_SIZE; /* offset for prev */
@@ -869,6 +900,13 @@ int GetPredAdvancedBy1x1(
     int rnd1, rnd2;
     uint32 mask;
 
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        return GetPredAdvancedBy1x1_SSE2(prev, pred_block, width, pred_width_rnd);
+    }
+#endif
+
     /* initialize offset to adjust pixel counter */
     /*    the next row; full-pel resolution      */
     offset = width - B_SIZE; /* offset for prev */
@@ -1187,4 +1225,126 @@ int GetPredAdvancedBy1x1(
     }
 }
 
+#ifdef M4VH263DEC_SSE2
+/**************************************************************************/
+/* SSE2 versions, 8 pixels of a row at a time. The half-pel average with  */
+/* rounding is pavgb, without rounding pavgb minus the carry bit.         */
 
+static inline __m128i AvgNoRnd_SSE2(__m128i a, __m128i b)
+{
+    __m128i carry = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), carry);
+}
+
+static int GetPredAdvancedBy0x0_SSE2(
+    uint8 *prev,        /* i */
+    uint8 *pred_block,      /* i */
+    int width,      /* i */
+    int pred_width_rnd /* i */
+)
+{
+    int i;
+    int pitch = pred_width_rnd >> 1;
+
+    for (i = B_SIZE; i > 0; i--)
+    {
+        _mm_storel_epi64((__m128i*)pred_block, _mm_loadl_epi64((__m128i*)prev));
+        prev += width;
+        pred_block += pitch;
+    }
+
+    return 1;
+}
+
+static int GetPredAdvancedBy0x1_SSE2(
+    uint8 *prev,        /* i */
+    uint8 *pred_block,      /* i */
+    int width,      /* i */
+    int pred_width_rnd /* i */
+)
+{
+    int i;
+    int pitch = pred_width_rnd >> 1;
+    __m128i a, b;
+
+    for (i = B_SIZE; i > 0; i--)
+    {
+        a = _mm_loadl_epi64((__m128i*)prev);
+        b = _mm_loadl_epi64((__m128i*)(prev + 1));
+        if (pred_width_rnd & 1)
+        {
+            a = _mm_avg_epu8(a, b);
+        }
+        else
+        {
+            a = AvgNoRnd_SSE2(a, b);
+        }
+        _mm_storel_epi64((__m128i*)pred_block, a);
+        prev += width;
+        pred_block += pitch;
+    }
+
+    return 1;
+}
+
+static int GetPredAdvancedBy1x0_SSE2(
+    uint8 *prev,        /* i */
+    uint8 *pred_block,      /* i */
+    int width,      /* i */
+    int pred_width_rnd /* i */
+)
+{
+    int i;
+    int pitch = pred_width_rnd >> 1;
+    __m128i a, b;
+
+    a = _mm_loadl_epi64((__m128i*)prev);
+    for (i = B_SIZE; i > 0; i--)
+    {
+        prev += width;
+        b = _mm_loadl_epi64((__m128i*)prev);
+        if (pred_width_rnd & 1)
+        {
+            _mm_storel_epi64((__m128i*)pred_block, _mm_avg_epu8(a, b));
+        }
+        else
+        {
+            _mm_storel_epi64((__m128i*)pred_block, AvgNoRnd_SSE2(a, b));
+        }
+        a = b;
+        pred_block += pitch;
+    }
+
+    return 1;
+}
+
+static int GetPredAdvancedBy1x1_SSE2(
+    uint8 *prev,        /* i */
+    uint8 *pred_block,      /* i */
+    int width,      /* i */
+    int pred_width_rnd /* i */
+)
+{
+    int i;
+    int pitch = pred_width_rnd >> 1;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rnd = _mm_set1_epi16((pred_width_rnd & 1) + 1);
+    __m128i top, bot;
+
+    /* horizontal pair sums of the first row, 16 bits */
+    top = _mm_add_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)prev), zero),
+                        _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(prev + 1)), zero));
+    for (i = B_SIZE; i > 0; i--)
+    {
+        prev += width;
+        bot = _mm_add_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)prev), zero),
+                            _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(prev + 1)), zero));
+        top = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top, bot), rnd), 2);
+        _mm_storel_epi64((__m128i*)pred_block, _mm_packus_epi16(top, top));
+        top = bot;
+        pred_block += pitch;
+    }
+
+    return 1;
+}
+#endif /* M4VH263DEC_SSE2 */
@@ -64,6 +64,13 @@ extern "C"
     /* exposed to programmers outside PacketVideo.  08/15/2000.    */
     uint VideoDecoderErrorDetected(VideoDecData *video);
 
+#ifdef M4VH263DEC_SSE2
+    /* non-zero if the SSE2 versions of the IDCT, motion compensation and */
+    /* post-filters may be used, set once by PVInitCpuFeatures.           */
+    extern int PVCpuHasSSE2;
+    void PVInitCpuFeatures(void);
+#endif
+
 #ifdef ENABLE_LOG
     void m4vdec_dprintf(char *format, ...);
 #define mp4dec_log(message) m4vdec_dprintf(message)
@@ -22,6 +22,11 @@
 #include    "motion_comp.h"
 #include "mbtype_mode.h"
 const static int STRENGTH_tab[] = {0, 1, 1, 2, 2, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 10, 11, 11, 11, 12, 12, 12};
+#ifdef M4VH263DEC_SSE2
+#include <emmintrin.h>
+static void H263_Deblock_SSE2(uint8 *rec, int width, int height, int16 *QP_store,
+                              uint8 *mode, int chr, int annex_T);
+#endif
 #endif
 
 #ifdef PV_POSTPROC_ON
@@ -188,6 +193,15 @@ void H263_Deblock(uint8 *rec,
     int tmpvar;
     int mbnum, strength, A_D, d1_2, d1, d2, A, B, C, D, b_size;
     int d, offset, nMBPerRow, nMBPerCol, width2 = (width << 1);
+
+#ifdef M4VH263DEC_SSE2
+    if (PVCpuHasSSE2)
+    {
+        H263_Deblock_SSE2(rec, width, height, QP_store, mode, chr, annex_T);
+        return;
+    }
+#endif
+
     /* MAKE SURE I-VOP INTRA MACROBLOCKS ARE SET TO NON-SKIPPED MODE*/
     mbnum = 0;
 
@@ -581,5 +595,271 @@ void H263_Deblock(uint8 *rec,
 
     return;
 }
-#endif
 
+#ifdef M4VH263DEC_SSE2
+/* Annex J filter of 8 pixel positions in 16 bits, same arithmetic as the
+   C code above with the branches turned into min/max and sign selects. */
+static void H263_DeblockFilter8_SSE2(__m128i *A, __m128i *B, __m128i *C, __m128i *D,
+                                     __m128i strength2)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i A_D, d, sign, mag, d1, d2;
+
+    A_D = _mm_sub_epi16(*A, *D);
+    d = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(*C, *B), 2), A_D);
+
+    /* |d1| = |d|/8, folded back above strength and zero above 2*strength */
+    sign = _mm_srai_epi16(d, 15);
+    mag = _mm_srli_epi16(_mm_sub_epi16(_mm_xor_si128(d, sign), sign), 3);
+    mag = _mm_min_epi16(mag, _mm_max_epi16(_mm_sub_epi16(strength2, mag), zero));
+    d1 = _mm_sub_epi16(_mm_xor_si128(mag, sign), sign);
+
+    /* |d2| = min(|A-D|/4, |d1|/2) with the sign of A-D */
+    sign = _mm_srai_epi16(A_D, 15);
+    d2 = _mm_srli_epi16(_mm_sub_epi16(_mm_xor_si128(A_D, sign), sign), 2);
+    d2 = _mm_min_epi16(d2, _mm_srli_epi16(mag, 1));
+    d2 = _mm_sub_epi16(_mm_xor_si128(d2, sign), sign);
+
+    *A = _mm_sub_epi16(*A, d2);
+    *B = _mm_add_epi16(*B, d1);
+    *C = _mm_sub_epi16(*C, d1);
+    *D = _mm_add_epi16(*D, d2);
+}
+
+/* filter 16 positions, the bytes of A and B are before the edge, C and D after it */
+static void H263_DeblockFilter_SSE2(__m128i *A, __m128i *B, __m128i *C, __m128i *D, int strength)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i s2 = _mm_set1_epi16(strength << 1);
+    __m128i a[2], b[2], c[2], d[2];
+    int k;
+
+    a[0] = _mm_unpacklo_epi8(*A, zero);
+    a[1] = _mm_unpackhi_epi8(*A, zero);
+    b[0] = _mm_unpacklo_epi8(*B, zero);
+    b[1] = _mm_unpackhi_epi8(*B, zero);
+    c[0] = _mm_unpacklo_epi8(*C, zero);
+    c[1] = _mm_unpackhi_epi8(*C, zero);
+    d[0] = _mm_unpacklo_epi8(*D, zero);
+    d[1] = _mm_unpackhi_epi8(*D, zero);
+
+    for (k = 0; k < 2; k++)
+    {
+        H263_DeblockFilter8_SSE2(&a[k], &b[k], &c[k], &d[k], s2);
+    }
+
+    /* A and D move towards each other and stay in range, B and C are clipped */
+    *A = _mm_packus_epi16(a[0], a[1]);
+    *B = _mm_packus_epi16(b[0], b[1]);
+    *C = _mm_packus_epi16(c[0], c[1]);
+    *D = _mm_packus_epi16(d[0], d[1]);
+}
+
+/* horizontal edge above rec_y, n is 16 or 8 pixels */
+static void H263_DeblockRow_SSE2(uint8 *rec_y, int width, int n, int strength)
+{
+    __m128i A, B, C, D;
+
+    if (n == 16)
+    {
+        A = _mm_loadu_si128((__m128i*)(rec_y - (width << 1)));
+        B = _mm_loadu_si128((__m128i*)(rec_y - width));
+        C = _mm_loadu_si128((__m128i*)rec_y);
+        D = _mm_loadu_si128((__m128i*)(rec_y + width));
+    }
+    else
+    {
+        A = _mm_loadl_epi64((__m128i*)(rec_y - (width << 1)));
+        B = _mm_loadl_epi64((__m128i*)(rec_y - width));
+        C = _mm_loadl_epi64((__m128i*)rec_y);
+        D = _mm_loadl_epi64((__m128i*)(rec_y + width));
+    }
+
+    H263_DeblockFilter_SSE2(&A, &B, &C, &D, strength);
+
+    if (n == 16)
+    {
+        _mm_storeu_si128((__m128i*)(rec_y - (width << 1)), A);
+        _mm_storeu_si128((__m128i*)(rec_y - width), B);
+        _mm_storeu_si128((__m128i*)rec_y, C);
+        _mm_storeu_si128((__m128i*)(rec_y + width), D);
+    }
+    else
+    {
+        _mm_storel_epi64((__m128i*)(rec_y - (width << 1)), A);
+        _mm_storel_epi64((__m128i*)(rec_y - width), B);
+        _mm_storel_epi64((__m128i*)rec_y, C);
+        _mm_storel_epi64((__m128i*)(rec_y + width), D);
+    }
+}
+
+/* vertical edge left of rec_y, n is 16 or 8 rows. The 4 pixels across the
+   edge of every row are transposed into A, B, C and D and back. */
+static void H263_DeblockCol_SSE2(uint8 *rec_y, int width, int n, int strength)
+{
+    __m128i v[4], t0, t1, t2, t3, A, B, C, D;
+    uint8 *p = rec_y - 2;
+    int k;
+
+    for (k = 0; k < 4; k++)
+    {
+        if ((k << 2) < n)
+        {
+            v[k] = _mm_set_epi32(*((int32*)(p + 3 * width)), *((int32*)(p + 2 * width)),
+                                 *((int32*)(p + width)), *((int32*)p));
+            p += (width << 2);
+        }
+        else
+        {
+            v[k] = _mm_setzero_si128();
+        }
+    }
+
+    /* rows are A B C D, 4 rows per register */
+    t0 = _mm_unpacklo_epi8(v[0], v[1]);
+    t1 = _mm_unpackhi_epi8(v[0], v[1]);
+    t2 = _mm_unpacklo_epi8(v[2], v[3]);
+    t3 = _mm_unpackhi_epi8(v[2], v[3]);
+    v[0] = _mm_unpacklo_epi8(t0, t1);
+    v[1] = _mm_unpackhi_epi8(t0, t1);
+    v[2] = _mm_unpacklo_epi8(t2, t3);
+    v[3] = _mm_unpackhi_epi8(t2, t3);
+    t0 = _mm_unpacklo_epi8(v[0], v[1]);    /* A0..A7 B0..B7 */
+    t1 = _mm_unpackhi_epi8(v[0], v[1]);    /* C0..C7 D0..D7 */
+    t2 = _mm_unpacklo_epi8(v[2], v[3]);    /* A8..A15 B8..B15 */
+    t3 = _mm_unpackhi_epi8(v[2], v[3]);    /* C8..C15 D8..D15 */
+    A = _mm_unpacklo_epi64(t0, t2);
+    B = _mm_unpackhi_epi64(t0, t2);
+    C = _mm_unpacklo_epi64(t1, t3);
+    D = _mm_unpackhi_epi64(t1, t3);
+
+    H263_DeblockFilter_SSE2(&A, &B, &C, &D, strength);
+
+    t0 = _mm_unpacklo_epi8(A, B);
+    t1 = _mm_unpackhi_epi8(A, B);
+    t2 = _mm_unpacklo_epi8(C, D);
+    t3 = _mm_unpackhi_epi8(C, D);
+    v[0] = _mm_unpacklo_epi16(t0, t2);
+    v[1] = _mm_unpackhi_epi16(t0, t2);
+    v[2] = _mm_unpacklo_epi16(t1, t3);
+    v[3] = _mm_unpackhi_epi16(t1, t3);
+
+    p = rec_y - 2;
+    for (k = 0; (k << 2) < n; k++)
+    {
+        *((int32*)p) = _mm_cvtsi128_si32(v[k]);
+        *((int32*)(p + width)) = _mm_cvtsi128_si32(_mm_srli_si128(v[k], 4));
+        *((int32*)(p + 2 * width)) = _mm_cvtsi128_si32(_mm_srli_si128(v[k], 8));
+        *((int32*)(p + 3 * width)) = _mm_cvtsi128_si32(_mm_srli_si128(v[k], 12));
+        p += (width << 2);
+    }
+}
+
+/* same edges and order as H263_Deblock, one block edge per call */
+static void H263_Deblock_SSE2(uint8 *rec,
+                              int width,
+                              int height,
+                              int16 *QP_store,
+                              uint8 *mode,
+                              int chr, int annex_T)
+{
+    int i, j, mbnum, QP, b_size, nMBPerRow, nMBPerCol;
+    uint8 *rec_y;
+
+    if (chr)
+    {
+        nMBPerRow = width >> 3;
+        nMBPerCol = height >> 3;
+        b_size = 8;
+    }
+    else
+    {
+        nMBPerRow = width >> 4;
+        nMBPerCol = height >> 4;
+        b_size = 16;
+    }
+
+    /* horizontal edges in the middle of the luma macroblocks */
+    if (!chr)
+    {
+        mbnum = 0;
+        for (i = 0; i < nMBPerCol; i++)
+        {
+            rec_y = rec + (int32)((i << 4) + 8) * width;
+            for (j = 0; j < nMBPerRow; j++)
+            {
+                if (mode[mbnum] != MODE_SKIPPED)
+                {
+                    H263_DeblockRow_SSE2(rec_y, width, 16, STRENGTH_tab[QP_store[mbnum]]);
+                }
+                rec_y += 16;
+                mbnum++;
+            }
+        }
+    }
+
+    /* horizontal macroblock boundaries */
+    mbnum = nMBPerRow;
+    for (i = 1; i < nMBPerCol; i++)
+    {
+        rec_y = rec + (int32)i * b_size * width;
+        for (j = 0; j < nMBPerRow; j++)
+        {
+            if (mode[mbnum] != MODE_SKIPPED || mode[mbnum - nMBPerRow] != MODE_SKIPPED)
+            {
+                QP = (mode[mbnum] != MODE_SKIPPED) ? QP_store[mbnum] : QP_store[mbnum - nMBPerRow];
+                if (annex_T)
+                {
+                    QP = MQ_chroma_QP_table[QP];
+                }
+                H263_DeblockRow_SSE2(rec_y, width, b_size, STRENGTH_tab[QP]);
+            }
+            rec_y += b_size;
+            mbnum++;
+        }
+    }
+
+    /* vertical edges in the middle of the luma macroblocks */
+    if (!chr)
+    {
+        mbnum = 0;
+        for (i = 0; i < nMBPerCol; i++)
+        {
+            rec_y = rec + (int32)(i << 4) * width + 8;
+            for (j = 0; j < nMBPerRow; j++)
+            {
+                if (mode[mbnum] != MODE_SKIPPED)
+                {
+                    H263_DeblockCol_SSE2(rec_y, width, 16, STRENGTH_tab[QP_store[mbnum]]);
+                }
+                rec_y += 16;
+                mbnum++;
+            }
+        }
+    }
+
+    /* vertical macroblock boundaries */
+    for (i = 0; i < nMBPerCol; i++)
+    {
+        rec_y = rec + (int32)i * b_size * width + b_size;
+        mbnum = i * nMBPerRow + 1;
+        for (j = 1; j < nMBPerRow; j++)
+        {
+            if (mode[mbnum] != MODE_SKIPPED || mode[mbnum - 1] != MODE_SKIPPED)
+            {
+                QP = (mode[mbnum] != MODE_SKIPPED) ? QP_store[mbnum] : QP_store[mbnum - 1];
+                if (annex_T)
+                {
+                    QP = MQ_chroma_QP_table[QP];
+                }
+                H263_DeblockCol_SSE2(rec_y, width, b_size, STRENGTH_tab[QP]);
+            }
+            rec_y += b_size;
+            mbnum++;
+        }
+    }
+
+    return;
+}
+#endif /* M4VH263DEC_SSE2 */
+#endif
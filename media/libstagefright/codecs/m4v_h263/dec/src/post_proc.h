@@ -43,7 +43,10 @@
 #define     KTh     4  /*threshold for soft filtering*/
 #define     KThH    4  /*threshold for hard filtering */
 
+/* the SSE2 build has a vector DeringAdaptiveSmoothMMX */
+#ifndef M4VH263DEC_SSE2
 #define     NoMMX
+#endif
 
 /*----------------------------------------------------------------------------
 ; EXTERNAL VARIABLES REFERENCES
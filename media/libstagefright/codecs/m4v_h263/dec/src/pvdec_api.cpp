@@ -21,6 +21,37 @@
 
 #define OSCL_DISABLE_WARNING_CONDITIONAL_IS_CONSTANT
 
+#ifdef M4VH263DEC_SSE2
+#include <pthread.h>
+#include <cpuid.h>
+
+int PVCpuHasSSE2 = 0;
+
+static pthread_once_t cpuFeaturesOnce = PTHREAD_ONCE_INIT;
+
+static void DetectCpuFeatures(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2))
+    {
+        PVCpuHasSSE2 = 1;
+    }
+}
+
+/* ======================================================================== */
+/*  Function : PVInitCpuFeatures()                                          */
+/*  Purpose  : Check once per process whether the CPU supports SSE2.        */
+/*  In/out   :                                                              */
+/*  Return   :                                                              */
+/*  Modified :                                                              */
+/* ======================================================================== */
+void PVInitCpuFeatures(void)
+{
+    pthread_once(&cpuFeaturesOnce, DetectCpuFeatures);
+}
+#endif
+
 #ifdef DEC_INTERNAL_MEMORY_OPT
 #define QCIF_MBS 99
 #define QCIF_BS (4*QCIF_MBS)
@@ -72,6 +103,9 @@ OSCL_EXPORT_REF Bool PVInitVideoDecoder(VideoDecControls *decCtrl, uint8 *volbuf
     int idx;
     BitstreamDecVideo *stream;
 
+#ifdef M4VH263DEC_SSE2
+    PVInitCpuFeatures();
+#endif
 
     oscl_memset(decCtrl, 0, sizeof(VideoDecControls)); /* fix a size bug.   03/28/2001 */
     decCtrl->nLayers = nLayers;
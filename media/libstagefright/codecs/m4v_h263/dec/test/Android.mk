@@ -0,0 +1,34 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ================================================================
+# Unit tests for libstagefright_m4vh263dec
+# ================================================================
+
+# ================================================================
+# Compares the SSE2 kernels with their C versions
+# ================================================================
+ifeq ($(TARGET_ARCH),x86)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := M4vH263DecSimd_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := M4vH263DecSimd_test.cpp
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../src \
+	$(LOCAL_PATH)/../include \
+	$(TOP)/frameworks/av/media/libstagefright/include \
+	$(TOP)/frameworks/native/include/media/openmax
+
+LOCAL_CFLAGS := -DOSCL_EXPORT_REF= -DOSCL_IMPORT_REF= -DM4VH263DEC_SSE2
+
+LOCAL_STATIC_LIBRARIES := \
+	libstagefright_m4vh263dec
+
+LOCAL_SHARED_LIBRARIES := \
+	libutils
+
+include $(BUILD_NATIVE_TEST)
+endif
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "M4vH263DecSimd_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp4dec_lib.h"
+#include "motion_comp.h"
+
+// Checks the SSE2 kernels of the MPEG-4/H.263 decoder against their C
+// versions. Each kernel is called through the entry point the decoder uses,
+// with PVCpuHasSSE2 cleared and then set, on the same random input. The
+// pictures given to the post-filters are surrounded by guard bytes, to catch
+// a kernel storing a whole register past the edge of the picture.
+
+namespace android {
+namespace test {
+
+static const int kWidth = 64;
+static const int kHeight = 48;
+static const int kIterations = 2000;
+static const int kGuardSize = 32;
+static const uint8 kGuardByte = 0xa5;
+
+class M4vH263DecSimdTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        // the decoder reads the flag at every call, it is switched by the
+        // tests and restored for the other tests of the process
+        PVInitCpuFeatures();
+        mHasSSE2 = PVCpuHasSSE2;
+
+        // 0 unless --gtest_shuffle and --gtest_random_seed ask for other
+        // inputs, so that a failing iteration can be reproduced
+        srand(::testing::UnitTest::GetInstance()->random_seed());
+
+        for (int k = 0; k < 2; k++) {
+            memset(mPicBuffer[k], kGuardByte, sizeof(mPicBuffer[k]));
+            mPic[k] = mPicBuffer[k] + kGuardSize;
+        }
+    }
+
+    virtual void TearDown() {
+        PVCpuHasSSE2 = mHasSSE2;
+
+        for (int k = 0; k < 2; k++) {
+            EXPECT_TRUE(isGuardIntact(mPicBuffer[k]))
+                    << (k ? "SSE2" : "C") << " version wrote before the picture";
+            EXPECT_TRUE(isGuardIntact(mPic[k] + kWidth * kHeight))
+                    << (k ? "SSE2" : "C") << " version wrote after the picture";
+        }
+    }
+
+    static bool isGuardIntact(const uint8 *guard) {
+        for (int i = 0; i < kGuardSize; i++) {
+            if (guard[i] != kGuardByte) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static int random(int lo, int hi) {
+        return lo + rand() % (hi - lo + 1);
+    }
+
+    // A picture of flat 8x8 blocks with some noise, so that the edge
+    // filters and the deringing smoother have something to do.
+    static void fillBlocky(uint8 *pic, int width, int height, int noise) {
+        for (int y = 0; y < height; y += 8) {
+            for (int x = 0; x < width; x += 8) {
+                int base = random(noise, 255 - noise);
+                for (int j = 0; j < 8 && y + j < height; j++) {
+                    for (int i = 0; i < 8 && x + i < width; i++) {
+                        pic[(y + j) * width + x + i] = base + random(-noise, noise);
+                    }
+                }
+            }
+        }
+    }
+
+    // Random coefficients with the bitmaps as VlcDequant*Block sets them,
+    // more than 10 of them so that the full IDCT is used.
+    static int fillCoefficients(int16 *blk, uint8 *bitmapcol, uint8 *bitmaprow) {
+        static const uint8 mask[8] = {128, 64, 32, 16, 8, 4, 2, 1};
+        int rows = random(1, 8), cols = random(1, 8), nz;
+
+        do {
+            nz = 0;
+            memset(blk, 0, 64 * sizeof(int16));
+            memset(bitmapcol, 0, 8);
+            *bitmaprow = 0;
+            for (int k = 0; k < 64; k++) {
+                if ((k >> 3) < rows && (k & 7) < cols && random(0, 2) == 0) {
+                    blk[k] = random(-2048, 2047) >> random(0, 8);
+                }
+                if (blk[k] != 0) {
+                    bitmapcol[k & 7] |= mask[k >> 3];
+                    nz++;
+                }
+            }
+            for (int k = 1; k < 4; k++) {
+                if (bitmapcol[k] != 0) {
+                    *bitmaprow |= mask[k];
+                }
+            }
+            rows = 8;
+            cols = 8;
+        } while (nz <= 10);
+
+        return nz;
+    }
+
+    int mHasSSE2;
+    uint8 mPicBuffer[2][kGuardSize + kWidth * kHeight + kGuardSize];
+    uint8 *mPic[2]; // picture of kWidth x kHeight inside mPicBuffer
+};
+
+TEST_F(M4vH263DecSimdTest, BlockIDCT) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    for (int n = 0; n < kIterations; n++) {
+        int16 coeff[2][64];
+        uint8 bitmapcol[8], bitmaprow;
+        uint8 pred[16 * 8], dst[2][kWidth * 8];
+
+        int nz = fillCoefficients(coeff[0], bitmapcol, &bitmaprow);
+        memcpy(coeff[1], coeff[0], sizeof(coeff[0]));
+        for (size_t i = 0; i < sizeof(pred); i++) {
+            pred[i] = random(0, 255);
+        }
+        memset(dst, 0, sizeof(dst));
+
+        PVCpuHasSSE2 = 0;
+        BlockIDCT(dst[0], pred, coeff[0], kWidth, nz, bitmapcol, bitmaprow);
+        PVCpuHasSSE2 = 1;
+        BlockIDCT(dst[1], pred, coeff[1], kWidth, nz, bitmapcol, bitmaprow);
+
+        ASSERT_EQ(0, memcmp(dst[0], dst[1], sizeof(dst[0]))) << "iteration " << n;
+        ASSERT_EQ(0, memcmp(coeff[0], coeff[1], sizeof(coeff[0]))) << "iteration " << n;
+    }
+}
+
+TEST_F(M4vH263DecSimdTest, BlockIDCTIntra) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    static MacroBlock mblock[2];
+    for (int n = 0; n < kIterations; n++) {
+        uint8 dst[2][kWidth * 8];
+
+        memset(mblock, 0, sizeof(mblock));
+        mblock[0].no_coeff[0] = fillCoefficients(mblock[0].block[0],
+                mblock[0].bitmapcol[0], &mblock[0].bitmaprow[0]);
+        memcpy(&mblock[1], &mblock[0], sizeof(MacroBlock));
+        memset(dst, 0, sizeof(dst));
+
+        PVCpuHasSSE2 = 0;
+        BlockIDCT_intra(&mblock[0], dst[0], 0, kWidth);
+        PVCpuHasSSE2 = 1;
+        BlockIDCT_intra(&mblock[1], dst[1], 0, kWidth);
+
+        ASSERT_EQ(0, memcmp(dst[0], dst[1], sizeof(dst[0]))) << "iteration " << n;
+        ASSERT_EQ(0, memcmp(mblock[0].block[0], mblock[1].block[0],
+                sizeof(mblock[0].block[0]))) << "iteration " << n;
+    }
+}
+
+TEST_F(M4vH263DecSimdTest, MotionCompensation) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    uint8 *prev = mPic[0];
+    for (int n = 0; n < kIterations; n++) {
+        uint8 pred[2][16 * 8];
+        int x = random(0, kWidth - 9), y = random(0, kHeight - 9);
+        int xh = random(0, 1), yh = random(0, 1), rnd = random(0, 1);
+
+        for (int i = 0; i < kWidth * kHeight; i++) {
+            prev[i] = random(0, 255);
+        }
+
+        for (int k = 0; k < 2; k++) {
+            memset(pred[k], 0, sizeof(pred[k]));
+            PVCpuHasSSE2 = k;
+            GetPredAdvBTable[yh][xh](prev + y * kWidth + x, pred[k], kWidth, (16 << 1) | rnd);
+        }
+
+        ASSERT_EQ(0, memcmp(pred[0], pred[1], sizeof(pred[0])))
+                << "x " << x << " y " << y << " half-pel " << xh << yh << " rnd " << rnd;
+    }
+}
+
+TEST_F(M4vH263DecSimdTest, H263Deblock) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    uint8 **pic = mPic;
+    int16 QP_store[(kWidth / 8) * (kHeight / 8)];
+    uint8 mode[(kWidth / 8) * (kHeight / 8)];
+
+    for (int n = 0; n < kIterations / 10; n++) {
+        int chr = random(0, 1), annex_T = random(0, 1);
+        int width = chr ? kWidth / 2 : kWidth, height = chr ? kHeight / 2 : kHeight;
+        int nMBs = chr ? (width / 8) * (height / 8) : (width / 16) * (height / 16);
+
+        fillBlocky(pic[0], width, height, random(0, 20));
+        memcpy(pic[1], pic[0], width * height);
+        for (int i = 0; i < nMBs; i++) {
+            QP_store[i] = random(1, 31);
+            mode[i] = random(0, 2) ? MODE_INTER : MODE_SKIPPED;
+        }
+
+        PVCpuHasSSE2 = 0;
+        H263_Deblock(pic[0], width, height, QP_store, mode, chr, annex_T);
+        PVCpuHasSSE2 = 1;
+        H263_Deblock(pic[1], width, height, QP_store, mode, chr, annex_T);
+
+        ASSERT_EQ(0, memcmp(pic[0], pic[1], width * height))
+                << "iteration " << n << " chr " << chr << " annex_T " << annex_T;
+    }
+}
+
+TEST_F(M4vH263DecSimdTest, DeringAdaptiveSmooth) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    uint8 **pic = mPic;
+    for (int n = 0; n < kIterations; n++) {
+        int x = random(0, kWidth - 10), y = random(0, kHeight - 10);
+        int thres = random(0, 255), mxdf = random(4, 11);
+
+        fillBlocky(pic[0], kWidth, kHeight, random(0, 10));
+        memcpy(pic[1], pic[0], kWidth * kHeight);
+
+        PVCpuHasSSE2 = 0;
+        DeringAdaptiveSmoothMMX(pic[0] + y * kWidth + x, kWidth, thres, mxdf);
+        PVCpuHasSSE2 = 1;
+        DeringAdaptiveSmoothMMX(pic[1] + y * kWidth + x, kWidth, thres, mxdf);
+
+        ASSERT_EQ(0, memcmp(pic[0], pic[1], kWidth * kHeight)) << "iteration " << n;
+    }
+}
+
+TEST_F(M4vH263DecSimdTest, FindMaxMin) {
+    if (!mHasSSE2) {
+        return;
+    }
+
+    uint8 *pic = mPic[0];
+    for (int n = 0; n < kIterations; n++) {
+        // the callers pass the offset to the next row, width - 8 and in one
+        // place width
+        int incr = random(0, 1) ? kWidth - 8 : kWidth;
+        int x = random(0, kWidth - 8), y = random(0, 3);
+        int min[2], max[2];
+
+        fillBlocky(pic, kWidth, kHeight, random(0, 127));
+
+        for (int k = 0; k < 2; k++) {
+            PVCpuHasSSE2 = k;
+            FindMaxMin(pic + y * kWidth + x, &min[k], &max[k], incr);
+        }
+
+        ASSERT_EQ(min[0], min[1]) << "iteration " << n;
+        ASSERT_EQ(max[0], max[1]) << "iteration " << n;
+    }
+}
+
+}  // namespace test
+}  // namespace android
@@ -27,6 +27,8 @@ LOCAL_SRC_FILES := \
  	src/pvmp3_seek_synch.cpp \
  	src/pvmp3_stereo_proc.cpp \
  	src/pvmp3_reorder.cpp \
+ 	src/pvmp3_polyphase_filter_window_simd.cpp \
+ 	src/pvmp3_mdct_18_simd.cpp \
 
 ifeq ($(TARGET_ARCH),arm)
 LOCAL_SRC_FILES += \
@@ -50,6 +52,16 @@ LOCAL_C_INCLUDES := \
 LOCAL_CFLAGS := \
         -DOSCL_UNUSED_ARG=
 
+# NEON and SSE2 versions of the polyphase synthesis window and of the
+# long block IMDCT, SSE2 is used when the CPU supports it
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+    LOCAL_ARM_NEON := true
+    LOCAL_CFLAGS += -DPV_MP3DEC_NEON
+endif
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DPV_MP3DEC_SSE2
+endif
+
 LOCAL_MODULE := libstagefright_mp3dec
 
 LOCAL_ARM_MODE := arm
@@ -79,3 +91,7 @@ LOCAL_MODULE := libstagefright_soft_mp3dec
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
+
+################################################################################
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
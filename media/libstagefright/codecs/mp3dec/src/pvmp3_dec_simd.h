@@ -0,0 +1,252 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+/*
+------------------------------------------------------------------------------
+   PacketVideo Corp.
+   MP3 Decoder Library
+
+   Filename: pvmp3_dec_simd.h
+
+------------------------------------------------------------------------------
+ INCLUDE DESCRIPTION
+
+ Four lane versions of the fixed point operations of pv_mp3dec_fxd_op.h for
+ ARM NEON (PV_MP3DEC_NEON) and x86 SSE2 (PV_MP3DEC_SSE2), and the filterbank
+ functions built on them. Every lane gives the same result as the scalar
+ operation, so the SIMD paths are bit exact with the C code.
+
+ NEON is selected at build time, SSE2 is used when pvmp3_cpu_has_simd is set
+ by pvmp3_init_cpu_features().
+
+------------------------------------------------------------------------------
+*/
+
+/*----------------------------------------------------------------------------
+; CONTINUE ONLY IF NOT ALREADY DEFINED
+----------------------------------------------------------------------------*/
+#ifndef PVMP3_DEC_SIMD_H
+#define PVMP3_DEC_SIMD_H
+
+/*----------------------------------------------------------------------------
+; INCLUDES
+----------------------------------------------------------------------------*/
+#include "pvmp3_audio_type_defs.h"
+
+#if defined(PV_MP3DEC_NEON)
+#include <arm_neon.h>
+#define PV_MP3DEC_SIMD
+#elif defined(PV_MP3DEC_SSE2)
+#include <emmintrin.h>
+#define PV_MP3DEC_SIMD
+#endif
+
+/*----------------------------------------------------------------------------
+; SIMPLE TYPEDEF'S
+----------------------------------------------------------------------------*/
+#if defined(PV_MP3DEC_NEON)
+
+typedef int32x4_t vint32;
+
+#define vload(p)        vld1q_s32(p)
+#define vstore(p, a)    vst1q_s32(p, a)
+#define vdup(c)         vdupq_n_s32(c)
+#define vadd(a, b)      vaddq_s32(a, b)
+#define vsub(a, b)      vsubq_s32(a, b)
+#define vneg(a)         vnegq_s32(a)
+#define vshl(a, n)      vshlq_n_s32(a, n)
+#define vsra(a, n)      vshrq_n_s32(a, n)
+
+/* (int32)((int64)a*b >> n) in every lane, n must be a constant */
+#define VFXP_MUL32_QN(a, b, n)                                               \
+    vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), n),  \
+                 vshrn_n_s64(vmull_s32(vget_high_s32(a), vget_high_s32(b)), n))
+
+#elif defined(PV_MP3DEC_SSE2)
+
+typedef __m128i vint32;
+
+#define vload(p)        _mm_loadu_si128((const __m128i *)(p))
+#define vstore(p, a)    _mm_storeu_si128((__m128i *)(p), a)
+#define vdup(c)         _mm_set1_epi32(c)
+#define vadd(a, b)      _mm_add_epi32(a, b)
+#define vsub(a, b)      _mm_sub_epi32(a, b)
+#define vneg(a)         _mm_sub_epi32(_mm_setzero_si128(), a)
+#define vshl(a, n)      _mm_slli_epi32(a, n)
+#define vsra(a, n)      _mm_srai_epi32(a, n)
+
+#endif
+
+/*----------------------------------------------------------------------------
+; GLOBAL FUNCTION DEFINITIONS
+; Function Prototype declaration
+----------------------------------------------------------------------------*/
+#ifdef PV_MP3DEC_SIMD
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    extern int32 pvmp3_cpu_has_simd;
+
+    void pvmp3_init_cpu_features(void);
+
+    void pvmp3_polyphase_filter_window_simd_init(void);
+
+    void pvmp3_polyphase_filter_window_simd(int32 *synth_buffer,
+                                            int16 *outPcm,
+                                            int32 numChannels);
+
+    /* pvmp3_mdct_18() of four consecutive subbands using the same window */
+    void pvmp3_mdct_18_x4(int32 vec[], int32 *history, const int32 *window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(PV_MP3DEC_NEON)
+
+static inline vint32 vfxp_mul32_Q32(vint32 a, vint32 b)
+{
+    return VFXP_MUL32_QN(a, b, 32);
+}
+
+static inline vint32 vfxp_mul32_Q28(vint32 a, vint32 b)
+{
+    return VFXP_MUL32_QN(a, b, 28);
+}
+
+static inline vint32 vfxp_mul32_Q27(vint32 a, vint32 b)
+{
+    return VFXP_MUL32_QN(a, b, 27);
+}
+
+/* lanes 3,2,1,0 */
+static inline vint32 vreverse(vint32 a)
+{
+    a = vrev64q_s32(a);
+    return vcombine_s32(vget_high_s32(a), vget_low_s32(a));
+}
+
+static inline void vtranspose(vint32 &r0, vint32 &r1, vint32 &r2, vint32 &r3)
+{
+    int32x4x2_t t0 = vtrnq_s32(r0, r1);
+    int32x4x2_t t1 = vtrnq_s32(r2, r3);
+
+    r0 = vcombine_s32(vget_low_s32(t0.val[0]), vget_low_s32(t1.val[0]));
+    r1 = vcombine_s32(vget_low_s32(t0.val[1]), vget_low_s32(t1.val[1]));
+    r2 = vcombine_s32(vget_high_s32(t0.val[0]), vget_high_s32(t1.val[0]));
+    r3 = vcombine_s32(vget_high_s32(t0.val[1]), vget_high_s32(t1.val[1]));
+}
+
+/* saturate16() of a and b, packed into 8 lanes */
+static inline void vsaturate16_store(int16 *p, vint32 a, vint32 b)
+{
+    vst1q_s16(p, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+}
+
+#elif defined(PV_MP3DEC_SSE2)
+
+/*
+ *  SSE2 only has an unsigned 32x32->64 multiply of the even lanes. The high
+ *  word of the signed product is the unsigned one minus b where a < 0 and
+ *  minus a where b < 0.
+ */
+static inline void vfxp_mul32_64(vint32 a, vint32 b, vint32 *lo, vint32 *hi)
+{
+    const vint32 mask = _mm_set_epi32(-1, 0, -1, 0);
+    vint32 even = _mm_mul_epu32(a, b);
+    vint32 odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    vint32 corr = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b),
+                                _mm_and_si128(_mm_srai_epi32(b, 31), a));
+
+    *hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_and_si128(odd, mask));
+    *hi = _mm_sub_epi32(*hi, corr);
+    if (lo != NULL)
+    {
+        *lo = _mm_or_si128(_mm_andnot_si128(mask, even), _mm_slli_epi64(odd, 32));
+    }
+}
+
+static inline vint32 vfxp_mul32_Q32(vint32 a, vint32 b)
+{
+    vint32 hi;
+
+    vfxp_mul32_64(a, b, NULL, &hi);
+    return hi;
+}
+
+static inline vint32 vfxp_mul32_Q28(vint32 a, vint32 b)
+{
+    vint32 lo, hi;
+
+    vfxp_mul32_64(a, b, &lo, &hi);
+    return _mm_or_si128(_mm_srli_epi32(lo, 28), _mm_slli_epi32(hi, 4));
+}
+
+static inline vint32 vfxp_mul32_Q27(vint32 a, vint32 b)
+{
+    vint32 lo, hi;
+
+    vfxp_mul32_64(a, b, &lo, &hi);
+    return _mm_or_si128(_mm_srli_epi32(lo, 27), _mm_slli_epi32(hi, 5));
+}
+
+/* lanes 3,2,1,0 */
+static inline vint32 vreverse(vint32 a)
+{
+    return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static inline void vtranspose(vint32 &r0, vint32 &r1, vint32 &r2, vint32 &r3)
+{
+    vint32 t0 = _mm_unpacklo_epi32(r0, r1);
+    vint32 t1 = _mm_unpacklo_epi32(r2, r3);
+    vint32 t2 = _mm_unpackhi_epi32(r0, r1);
+    vint32 t3 = _mm_unpackhi_epi32(r2, r3);
+
+    r0 = _mm_unpacklo_epi64(t0, t1);
+    r1 = _mm_unpackhi_epi64(t0, t1);
+    r2 = _mm_unpacklo_epi64(t2, t3);
+    r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* saturate16() of a and b, packed into 8 lanes */
+static inline void vsaturate16_store(int16 *p, vint32 a, vint32 b)
+{
+    _mm_storeu_si128((__m128i *)p, _mm_packs_epi32(a, b));
+}
+
+#endif
+
+static inline vint32 vfxp_mac32_Q32(vint32 L_add, vint32 a, vint32 b)
+{
+    return vadd(L_add, vfxp_mul32_Q32(a, b));
+}
+
+static inline vint32 vfxp_msb32_Q32(vint32 L_sub, vint32 a, vint32 b)
+{
+    return vsub(L_sub, vfxp_mul32_Q32(a, b));
+}
+
+#endif  /* PV_MP3DEC_SIMD */
+
+/*----------------------------------------------------------------------------
+; END
+----------------------------------------------------------------------------*/
+#endif
@@ -116,6 +116,14 @@ Input
 #include "s_tmp3dec_file.h"
 #include "pvmp3_getbits.h"
 #include "mp3_mem_funcs.h"
+#include "pvmp3_dec_simd.h"
+
+#if defined(PV_MP3DEC_SSE2)
+#include <cpuid.h>
+#endif
+#ifdef PV_MP3DEC_SIMD
+#include <pthread.h>
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -140,6 +148,36 @@ Input
 ; Variable declaration - defined here and used outside this module
 ----------------------------------------------------------------------------*/
 
+#ifdef PV_MP3DEC_SIMD
+/* set when the NEON/SSE2 filterbank can be used */
+int32 pvmp3_cpu_has_simd = 0;
+
+static pthread_once_t cpu_features_once = PTHREAD_ONCE_INIT;
+
+static void detect_cpu_features(void)
+{
+#if defined(PV_MP3DEC_SSE2)
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2))
+    {
+        return;
+    }
+#endif
+
+    pvmp3_polyphase_filter_window_simd_init();
+    pvmp3_cpu_has_simd = 1;
+}
+
+/*
+ *  Check once per process whether the SIMD filterbank can be used
+ */
+void pvmp3_init_cpu_features(void)
+{
+    pthread_once(&cpu_features_once, detect_cpu_features);
+}
+#endif
+
 /*----------------------------------------------------------------------------
 ; EXTERNAL FUNCTION REFERENCES
 ; Declare functions defined elsewhere and referenced in this module
@@ -654,6 +692,10 @@ void pvmp3_InitDecoder(tPVMP3DecoderExternal *pExt,
     tmp3dec_file      *pVars;
     huffcodetab       *pHuff;
 
+#ifdef PV_MP3DEC_SIMD
+    pvmp3_init_cpu_features();
+#endif
+
     pVars = (tmp3dec_file *)pMem;
 
     pVars->num_channels = 0;
@@ -101,6 +101,7 @@ Overlapping and adding with previous block
 #include "pvmp3_mdct_18.h"
 #include "pvmp3_mdct_6.h"
 #include "mp3_mem_funcs.h"
+#include "pvmp3_dec_simd.h"
 
 
 
@@ -213,6 +214,24 @@ const int32 short_win[12] =
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
 
+static inline void mdct_18_bands(int32 *out,
+                                 int32 *history,
+                                 const int32 *window,
+                                 int32 num_bands)
+{
+#ifdef PV_MP3DEC_SIMD
+    if (num_bands == 4)
+    {
+        pvmp3_mdct_18_x4(out, history, window);
+        return;
+    }
+#endif
+    OSCL_UNUSED_ARG(num_bands);
+
+    pvmp3_mdct_18(out, history, window);
+}
+
+
 void pvmp3_imdct_synth(int32  in[SUBBANDS_NUMBER*FILTERBANK_BANDS],
                        int32  overlap[SUBBANDS_NUMBER*FILTERBANK_BANDS],
                        uint32 blk_type,
@@ -239,27 +258,40 @@ void pvmp3_imdct_synth(int32  in[SUBBANDS_NUMBER*FILTERBANK_BANDS],
     for (band = 0; band < bands2process; band++)
     {
         uint32 current_blk_type = (band < mx_band) ? LONG : blk_type;
+        int32  num_bands = 1;
 
         int32 * out     = in      + (band * FILTERBANK_BANDS);
         int32 * history = overlap + (band * FILTERBANK_BANDS);
 
+#ifdef PV_MP3DEC_SIMD
+        /*
+         *  four subbands at once when they use the same long window
+         */
+        if (pvmp3_cpu_has_simd && (band + 4 <= bands2process) &&
+                (current_blk_type != SHORT) &&
+                (current_blk_type == ((band + 3 < mx_band) ? LONG : blk_type)))
+        {
+            num_bands = 4;
+        }
+#endif
+
         switch (current_blk_type)
         {
             case LONG:
 
-                pvmp3_mdct_18(out, history, normal_win);
+                mdct_18_bands(out, history, normal_win, num_bands);
 
                 break;
 
             case START:
 
-                pvmp3_mdct_18(out, history, start_win);
+                mdct_18_bands(out, history, start_win, num_bands);
 
                 break;
 
             case STOP:
 
-                pvmp3_mdct_18(out, history, stop_win);
+                mdct_18_bands(out, history, stop_win, num_bands);
 
                 break;
 
@@ -314,18 +346,25 @@ void pvmp3_imdct_synth(int32  in[SUBBANDS_NUMBER*FILTERBANK_BANDS],
          *     processing by the polyphase filter
          */
 
-        if (band & 1)
+        for (int32 i = 0; i < num_bands; i++)
         {
-            for (int32 slot = 1; slot < FILTERBANK_BANDS; slot += 6)
+            if ((band + i) & 1)
             {
-                int32 temp1 = out[slot  ];
-                int32 temp2 = out[slot+2];
-                int32 temp3 = out[slot+4];
-                out[slot  ] = -temp1;
-                out[slot+2] = -temp2;
-                out[slot+4] = -temp3;
+                int32 *pt_out = out + (i * FILTERBANK_BANDS);
+
+                for (int32 slot = 1; slot < FILTERBANK_BANDS; slot += 6)
+                {
+                    int32 temp1 = pt_out[slot  ];
+                    int32 temp2 = pt_out[slot+2];
+                    int32 temp3 = pt_out[slot+4];
+                    pt_out[slot  ] = -temp1;
+                    pt_out[slot+2] = -temp2;
+                    pt_out[slot+4] = -temp3;
+                }
             }
         }
+
+        band += num_bands - 1;
     }
 
 
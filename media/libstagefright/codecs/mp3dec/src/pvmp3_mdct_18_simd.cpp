@@ -0,0 +1,372 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+/*
+------------------------------------------------------------------------------
+
+   PacketVideo Corp.
+   MP3 Decoder Library
+
+   Filename: pvmp3_mdct_18_simd.cpp
+
+------------------------------------------------------------------------------
+ INPUT AND OUTPUT DEFINITIONS
+
+Input
+    int32 vec[],            input vector of length 4*18, four subbands
+    int32 *history          input for overlap and add, vector updated with
+                            next overlap and add values, length 4*18
+    const int32 *window     sine window used by the four subbands
+ Returns
+    none                    mdct computation in-place
+
+
+------------------------------------------------------------------------------
+ FUNCTION DESCRIPTION
+
+    NEON/SSE2 version of pvmp3_mdct_18() transforming four subbands at once,
+    one subband per lane. The subbands are transposed on load and store, the
+    arithmetic is the one of pvmp3_mdct_18() and pvmp3_dct_9().
+
+------------------------------------------------------------------------------
+*/
+
+
+/*----------------------------------------------------------------------------
+; INCLUDES
+----------------------------------------------------------------------------*/
+
+#include "pvmp3_dec_simd.h"
+
+#ifdef PV_MP3DEC_SIMD
+
+#include "pv_mp3dec_fxd_op.h"
+#include "pvmp3_dec_defs.h"
+#include "pvmp3_mdct_18.h"
+
+/*----------------------------------------------------------------------------
+; DEFINES
+----------------------------------------------------------------------------*/
+#define Qfmt31(a)   (int32)(a*(0x7FFFFFFF))
+
+#define cos_pi_9    Qfmt31( 0.93969262078591f)
+#define cos_2pi_9   Qfmt31( 0.76604444311898f)
+#define cos_4pi_9   Qfmt31( 0.17364817766693f)
+#define cos_5pi_9   Qfmt31(-0.17364817766693f)
+#define cos_7pi_9   Qfmt31(-0.76604444311898f)
+#define cos_8pi_9   Qfmt31(-0.93969262078591f)
+#define cos_pi_6    Qfmt31( 0.86602540378444f)
+#define cos_5pi_6   Qfmt31(-0.86602540378444f)
+#define cos_5pi_18  Qfmt31( 0.64278760968654f)
+#define cos_7pi_18  Qfmt31( 0.34202014332567f)
+#define cos_11pi_18 Qfmt31(-0.34202014332567f)
+#define cos_13pi_18 Qfmt31(-0.64278760968654f)
+#define cos_17pi_18 Qfmt31(-0.98480775301221f)
+
+/*----------------------------------------------------------------------------
+; LOCAL STORE/BUFFER/POINTER DEFINITIONS
+----------------------------------------------------------------------------*/
+
+/*
+ *  Same as cosTerms_dct18[] and cosTerms_1_ov_cos_phi[] of pvmp3_mdct_18.cpp,
+ *  which is not built when the assembly version is used
+ */
+static const int32 cosTerms_dct18_simd[9] =
+{
+    Qfmt(0.50190991877167f),   Qfmt(0.51763809020504f),   Qfmt(0.55168895948125f),
+    Qfmt(0.61038729438073f),   Qfmt(0.70710678118655f),   Qfmt(0.87172339781055f),
+    Qfmt(1.18310079157625f),   Qfmt(1.93185165257814f),   Qfmt(5.73685662283493f)
+};
+
+
+static const int32 cosTerms_1_ov_cos_phi_simd[18] =
+{
+
+    Qfmt1(0.50047634258166f),  Qfmt1(0.50431448029008f),  Qfmt1(0.51213975715725f),
+    Qfmt1(0.52426456257041f),  Qfmt1(0.54119610014620f),  Qfmt1(0.56369097343317f),
+    Qfmt1(0.59284452371708f),  Qfmt1(0.63023620700513f),  Qfmt1(0.67817085245463f),
+
+    Qfmt2(0.74009361646113f),  Qfmt2(0.82133981585229f),  Qfmt2(0.93057949835179f),
+    Qfmt2(1.08284028510010f),  Qfmt2(1.30656296487638f),  Qfmt2(1.66275476171152f),
+    Qfmt2(2.31011315767265f),  Qfmt2(3.83064878777019f),  Qfmt2(11.46279281302667f)
+};
+
+/*----------------------------------------------------------------------------
+; FUNCTION CODE
+----------------------------------------------------------------------------*/
+
+/* v[k] = lane b holds x[b*FILTERBANK_BANDS + k] */
+static inline void load_transposed(vint32 v[FILTERBANK_BANDS], const int32 *x)
+{
+    for (int32 k = 0; k < 16; k += 4)
+    {
+        v[k    ] = vload(&x[k]);
+        v[k + 1] = vload(&x[k +   FILTERBANK_BANDS]);
+        v[k + 2] = vload(&x[k + 2*FILTERBANK_BANDS]);
+        v[k + 3] = vload(&x[k + 3*FILTERBANK_BANDS]);
+        vtranspose(v[k], v[k + 1], v[k + 2], v[k + 3]);
+    }
+
+    for (int32 k = 16; k < FILTERBANK_BANDS; k++)
+    {
+        int32 tmp[4];
+
+        tmp[0] = x[k];
+        tmp[1] = x[k +   FILTERBANK_BANDS];
+        tmp[2] = x[k + 2*FILTERBANK_BANDS];
+        tmp[3] = x[k + 3*FILTERBANK_BANDS];
+        v[k] = vload(tmp);
+    }
+}
+
+
+static inline void store_transposed(int32 *x, vint32 v[FILTERBANK_BANDS])
+{
+    for (int32 k = 0; k < 16; k += 4)
+    {
+        vint32 r0 = v[k];
+        vint32 r1 = v[k + 1];
+        vint32 r2 = v[k + 2];
+        vint32 r3 = v[k + 3];
+
+        vtranspose(r0, r1, r2, r3);
+        vstore(&x[k], r0);
+        vstore(&x[k +   FILTERBANK_BANDS], r1);
+        vstore(&x[k + 2*FILTERBANK_BANDS], r2);
+        vstore(&x[k + 3*FILTERBANK_BANDS], r3);
+    }
+
+    for (int32 k = 16; k < FILTERBANK_BANDS; k++)
+    {
+        int32 tmp[4];
+
+        vstore(tmp, v[k]);
+        x[k                     ] = tmp[0];
+        x[k +   FILTERBANK_BANDS] = tmp[1];
+        x[k + 2*FILTERBANK_BANDS] = tmp[2];
+        x[k + 3*FILTERBANK_BANDS] = tmp[3];
+    }
+}
+
+
+static inline void dct_9_x4(vint32 vec[])
+{
+
+    /*  split input vector */
+
+    vint32 tmp0 = vadd(vec[8], vec[0]);
+    vint32 tmp8 = vsub(vec[8], vec[0]);
+    vint32 tmp1 = vadd(vec[7], vec[1]);
+    vint32 tmp7 = vsub(vec[7], vec[1]);
+    vint32 tmp2 = vadd(vec[6], vec[2]);
+    vint32 tmp6 = vsub(vec[6], vec[2]);
+    vint32 tmp3 = vadd(vec[5], vec[3]);
+    vint32 tmp5 = vsub(vec[5], vec[3]);
+    vint32 tmp023 = vadd(vadd(tmp0, tmp2), tmp3);
+    vint32 tmp14  = vadd(tmp1, vec[4]);
+
+    vec[0]  = vadd(tmp023, tmp14);
+    vec[6]  = vsub(vsra(tmp023, 1), tmp14);
+    vec[2]  = vsub(vsra(tmp1, 1), vec[4]);
+    vec[4]  = vneg(vec[2]);
+    vec[8]  = vec[4];
+
+    tmp0 = vshl(tmp0, 1);
+    tmp2 = vshl(tmp2, 1);
+    tmp3 = vshl(tmp3, 1);
+
+    vec[4]  = vfxp_mac32_Q32(vec[4], tmp0, vdup(cos_2pi_9));
+    vec[8]  = vfxp_mac32_Q32(vec[8], tmp0, vdup(cos_4pi_9));
+    vec[2]  = vfxp_mac32_Q32(vec[2], tmp0, vdup(cos_pi_9));
+    vec[2]  = vfxp_mac32_Q32(vec[2], tmp2, vdup(cos_5pi_9));
+    vec[4]  = vfxp_mac32_Q32(vec[4], tmp2, vdup(cos_8pi_9));
+    vec[8]  = vfxp_mac32_Q32(vec[8], tmp2, vdup(cos_2pi_9));
+    vec[8]  = vfxp_mac32_Q32(vec[8], tmp3, vdup(cos_8pi_9));
+    vec[4]  = vfxp_mac32_Q32(vec[4], tmp3, vdup(cos_4pi_9));
+    vec[2]  = vfxp_mac32_Q32(vec[2], tmp3, vdup(cos_7pi_9));
+
+    vint32 tmp3_ = vshl(vsub(vadd(tmp5, tmp6), tmp8), 1);
+
+    tmp5 = vshl(tmp5, 1);
+    tmp6 = vshl(tmp6, 1);
+    tmp7 = vshl(tmp7, 1);
+    tmp8 = vshl(tmp8, 1);
+
+    vec[1]  = vfxp_mul32_Q32(tmp5, vdup(cos_11pi_18));
+    vec[1]  = vfxp_mac32_Q32(vec[1], tmp6, vdup(cos_13pi_18));
+    vec[1]  = vfxp_mac32_Q32(vec[1], tmp7, vdup(cos_5pi_6));
+    vec[1]  = vfxp_mac32_Q32(vec[1], tmp8, vdup(cos_17pi_18));
+    vec[3]  = vfxp_mul32_Q32(tmp3_, vdup(cos_pi_6));
+    vec[5]  = vfxp_mul32_Q32(tmp5, vdup(cos_17pi_18));
+    vec[5]  = vfxp_mac32_Q32(vec[5], tmp6, vdup(cos_7pi_18));
+    vec[5]  = vfxp_mac32_Q32(vec[5], tmp7, vdup(cos_pi_6));
+    vec[5]  = vfxp_mac32_Q32(vec[5], tmp8, vdup(cos_13pi_18));
+    vec[7]  = vfxp_mul32_Q32(tmp5, vdup(cos_5pi_18));
+    vec[7]  = vfxp_mac32_Q32(vec[7], tmp6, vdup(cos_17pi_18));
+    vec[7]  = vfxp_mac32_Q32(vec[7], tmp7, vdup(cos_pi_6));
+    vec[7]  = vfxp_mac32_Q32(vec[7], tmp8, vdup(cos_11pi_18));
+}
+
+
+void pvmp3_mdct_18_x4(int32 vec[], int32 *history, const int32 *window)
+{
+    int32 i;
+    vint32 v[FILTERBANK_BANDS];
+    vint32 h[FILTERBANK_BANDS];
+    vint32 tmp;
+    vint32 tmp1;
+    vint32 tmp2;
+    vint32 tmp3;
+    vint32 tmp4;
+
+    load_transposed(v, vec);
+
+
+    for (i = 0; i < 9; i++)
+    {
+        tmp  = vfxp_mul32_Q32(vshl(v[i], 1), vdup(cosTerms_1_ov_cos_phi_simd[i]));
+        tmp1 = vfxp_mul32_Q27(v[17 - i], vdup(cosTerms_1_ov_cos_phi_simd[17 - i]));
+        v[i]      = vadd(tmp, tmp1);
+        v[17 - i] = vfxp_mul32_Q28(vsub(tmp, tmp1), vdup(cosTerms_dct18_simd[i]));
+    }
+
+
+    dct_9_x4(v);          // Even terms
+    dct_9_x4(&v[9]);      // Odd  terms
+
+
+    tmp3   = v[16];
+    v[16]  = v[ 8];
+    tmp4   = v[14];
+    v[14]  = v[ 7];
+    tmp    = v[12];
+    v[12]  = v[ 6];
+    tmp2   = v[10];
+    v[10]  = v[ 5];
+    v[ 8]  = v[ 4];
+    v[ 6]  = v[ 3];
+    v[ 4]  = v[ 2];
+    v[ 2]  = v[ 1];
+    v[ 1]  = vsub(v[ 9], tmp2);
+    v[ 3]  = vsub(v[11], tmp2);
+    v[ 5]  = vsub(v[11], tmp);
+    v[ 7]  = vsub(v[13], tmp);
+    v[ 9]  = vsub(v[13], tmp4);
+    v[11]  = vsub(v[15], tmp4);
+    v[13]  = vsub(v[15], tmp3);
+    v[15]  = vsub(v[17], tmp3);
+
+
+    /* overlap and add */
+
+    load_transposed(h, history);
+
+    tmp2 = v[0];
+    tmp3 = v[9];
+
+    for (i = 0; i < 6; i++)
+    {
+        tmp  = h[i];
+        tmp4 = v[i + 10];
+        v[i + 10] = vadd(tmp3, tmp4);
+        tmp1 = v[i + 1];
+        v[i] = vfxp_mac32_Q32(tmp, v[i + 10], vdup(window[i]));
+        tmp3 = tmp4;
+        h[i] = vneg(vadd(tmp2, tmp1));
+        tmp2 = tmp1;
+    }
+
+    tmp  = h[6];
+    tmp4 = v[16];
+    v[16] = vadd(tmp3, tmp4);
+    tmp1 = v[7];
+    v[ 6] = vfxp_mac32_Q32(tmp, vshl(v[16], 1), vdup(window[6]));
+    tmp  = h[7];
+    h[6] = vneg(vadd(tmp2, tmp1));
+    h[7] = vneg(vadd(tmp1, v[8]));
+
+    tmp1  = h[8];
+    tmp4  = vadd(v[17], tmp4);
+    v[ 7] = vfxp_mac32_Q32(tmp, vshl(tmp4, 1), vdup(window[7]));
+    h[8]  = vneg(vadd(v[8], v[9]));
+    v[ 8] = vfxp_mac32_Q32(tmp1, vshl(v[17], 1), vdup(window[8]));
+
+    tmp  = h[9];
+    tmp1 = h[17];
+    tmp2 = h[16];
+    v[ 9] = vfxp_mac32_Q32(tmp,  vshl(v[17], 1), vdup(window[9]));
+
+    v[17] = vfxp_mac32_Q32(tmp1, vshl(v[10], 1), vdup(window[17]));
+    v[10] = vneg(v[16]);
+    v[16] = vfxp_mac32_Q32(tmp2, vshl(v[11], 1), vdup(window[16]));
+    tmp1 = h[15];
+    tmp2 = h[14];
+    v[11] = vneg(v[15]);
+    v[15] = vfxp_mac32_Q32(tmp1, vshl(v[12], 1), vdup(window[15]));
+    v[12] = vneg(v[14]);
+    v[14] = vfxp_mac32_Q32(tmp2, vshl(v[13], 1), vdup(window[14]));
+
+    tmp  = h[13];
+    tmp1 = h[12];
+    tmp2 = h[11];
+    tmp3 = h[10];
+    v[13] = vfxp_mac32_Q32(tmp,  vshl(v[12], 1), vdup(window[13]));
+    v[12] = vfxp_mac32_Q32(tmp1, vshl(v[11], 1), vdup(window[12]));
+    v[11] = vfxp_mac32_Q32(tmp2, vshl(v[10], 1), vdup(window[11]));
+    v[10] = vfxp_mac32_Q32(tmp3, vshl(tmp4, 1),  vdup(window[10]));
+
+    store_transposed(vec, v);
+
+
+    /* next iteration overlap */
+
+    tmp1 = vshl(h[8], 1);
+    tmp3 = vshl(h[7], 1);
+    tmp2 = vshl(h[1], 1);
+    tmp  = vshl(h[0], 1);
+
+    h[ 0] = vfxp_mul32_Q32(tmp1, vdup(window[18]));
+    h[17] = vfxp_mul32_Q32(tmp1, vdup(window[35]));
+    h[ 1] = vfxp_mul32_Q32(tmp3, vdup(window[19]));
+    h[16] = vfxp_mul32_Q32(tmp3, vdup(window[34]));
+
+    h[ 7] = vfxp_mul32_Q32(tmp2, vdup(window[25]));
+    h[10] = vfxp_mul32_Q32(tmp2, vdup(window[28]));
+    h[ 8] = vfxp_mul32_Q32(tmp,  vdup(window[26]));
+    h[ 9] = vfxp_mul32_Q32(tmp,  vdup(window[27]));
+
+    tmp1 = vshl(h[6], 1);
+    tmp3 = vshl(h[5], 1);
+    tmp4 = vshl(h[4], 1);
+    tmp2 = vshl(h[3], 1);
+    tmp  = vshl(h[2], 1);
+
+    h[ 2] = vfxp_mul32_Q32(tmp1, vdup(window[20]));
+    h[15] = vfxp_mul32_Q32(tmp1, vdup(window[33]));
+    h[ 3] = vfxp_mul32_Q32(tmp3, vdup(window[21]));
+    h[14] = vfxp_mul32_Q32(tmp3, vdup(window[32]));
+    h[ 4] = vfxp_mul32_Q32(tmp4, vdup(window[22]));
+    h[13] = vfxp_mul32_Q32(tmp4, vdup(window[31]));
+    h[ 5] = vfxp_mul32_Q32(tmp2, vdup(window[23]));
+    h[12] = vfxp_mul32_Q32(tmp2, vdup(window[30]));
+    h[ 6] = vfxp_mul32_Q32(tmp,  vdup(window[24]));
+    h[11] = vfxp_mul32_Q32(tmp,  vdup(window[29]));
+
+    store_transposed(history, h);
+}
+
+#endif  /* PV_MP3DEC_SIMD */
@@ -80,6 +80,7 @@
 #include "pvmp3_dct_16.h"
 #include "pvmp3_equalizer.h"
 #include "mp3_mem_funcs.h"
+#include "pvmp3_dec_simd.h"
 
 
 /*----------------------------------------------------------------------------
@@ -119,6 +120,22 @@
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
 
+static inline void filter_window(int32 *synth_buffer,
+                                 int16 *outPcm,
+                                 int32 numChannels)
+{
+#ifdef PV_MP3DEC_SIMD
+    if (pvmp3_cpu_has_simd)
+    {
+        pvmp3_polyphase_filter_window_simd(synth_buffer, outPcm, numChannels);
+        return;
+    }
+#endif
+
+    pvmp3_polyphase_filter_window(synth_buffer, outPcm, numChannels);
+}
+
+
 void pvmp3_poly_phase_synthesis(tmp3dec_chan   *pChVars,
                                 int32          numChannels,
                                 e_equalization equalizerType,
@@ -150,9 +167,9 @@ void pvmp3_poly_phase_synthesis(tmp3dec_chan   *pChVars,
 
         pvmp3_merge_in_place_N32(inData);
 
-        pvmp3_polyphase_filter_window(inData,
-                                      ptr_out,
-                                      numChannels);
+        filter_window(inData,
+                      ptr_out,
+                      numChannels);
 
         inData  -= SUBBANDS_NUMBER;
 
@@ -167,9 +184,9 @@ void pvmp3_poly_phase_synthesis(tmp3dec_chan   *pChVars,
 
         pvmp3_merge_in_place_N32(inData);
 
-        pvmp3_polyphase_filter_window(inData,
-                                      ptr_out + (numChannels << 5),
-                                      numChannels);
+        filter_window(inData,
+                      ptr_out + (numChannels << 5),
+                      numChannels);
 
         ptr_out += (numChannels << 6);
 
@@ -0,0 +1,195 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+
+/*
+------------------------------------------------------------------------------
+
+   PacketVideo Corp.
+   MP3 Decoder Library
+
+   Filename: pvmp3_polyphase_filter_window_simd.cpp
+
+------------------------------------------------------------------------------
+ INPUT AND OUTPUT DEFINITIONS
+
+Input
+    int32 *synth_buffer,    synthesis input buffer
+    int16 *outPcm,          generated output ( 32 values)
+    int32 numChannels       number of channels
+ Returns
+
+    int16 *outPcm
+
+------------------------------------------------------------------------------
+ FUNCTION DESCRIPTION
+
+    NEON/SSE2 version of pvmp3_polyphase_filter_window(). The output samples
+    j and 32-j, j = 1..15, are computed for four values of j at a time, the
+    lanes reading neighbouring entries of the synthesis buffer. The window
+    coefficients are reordered once by pvmp3_polyphase_filter_window_simd_init()
+    so that they can be loaded in the same way. Samples 0 and 16 are computed
+    as in the C version.
+
+------------------------------------------------------------------------------
+*/
+
+
+/*----------------------------------------------------------------------------
+; INCLUDES
+----------------------------------------------------------------------------*/
+
+#include "pvmp3_dec_simd.h"
+
+#ifdef PV_MP3DEC_SIMD
+
+#include "pvmp3_polyphase_filter_window.h"
+#include "pv_mp3dec_fxd_op.h"
+#include "pvmp3_dec_defs.h"
+#include "pvmp3_tables.h"
+
+/*----------------------------------------------------------------------------
+; DEFINES
+----------------------------------------------------------------------------*/
+#define WIN_GROUPS  4           /* j = 1..16, four at a time */
+
+/*----------------------------------------------------------------------------
+; LOCAL STORE/BUFFER/POINTER DEFINITIONS
+----------------------------------------------------------------------------*/
+
+/*
+ *  pqmfSynthWin[16*(j-1) + m] at pqmfSynthWinT[group][m][j-1-4*group],
+ *  zero for j = 16
+ */
+static int32 pqmfSynthWinT[WIN_GROUPS][16][4];
+
+/*----------------------------------------------------------------------------
+; FUNCTION CODE
+----------------------------------------------------------------------------*/
+
+void pvmp3_polyphase_filter_window_simd_init(void)
+{
+    for (int32 group = 0; group < WIN_GROUPS; group++)
+    {
+        for (int32 m = 0; m < 16; m++)
+        {
+            for (int32 lane = 0; lane < 4; lane++)
+            {
+                int32 j = 1 + (group << 2) + lane;
+
+                pqmfSynthWinT[group][m][lane] =
+                    (j < SUBBANDS_NUMBER / 2) ? pqmfSynthWin[((j - 1) << 4) + m] : 0;
+            }
+        }
+    }
+}
+
+
+void pvmp3_polyphase_filter_window_simd(int32 *synth_buffer,
+                                        int16 *outPcm,
+                                        int32 numChannels)
+{
+    int32 sum1;
+    int32 sum2;
+    const int32 *winPtr;
+    int32 i;
+    int16 out[8];
+
+
+    for (int32 group = 0; group < WIN_GROUPS; group++)
+    {
+        int32 j0 = 1 + (group << 2);
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j0];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j0 - 3];
+        vint32 vsum1 = vdup(0x00000020);
+        vint32 vsum2 = vdup(0x00000020);
+
+        winPtr = pqmfSynthWinT[group][0];
+
+        for (i = 0; i < 4; i++)
+        {
+            vint32 temp1 = vload(&pt_1[SUBBANDS_NUMBER*(2*i)]);
+            vint32 temp3 = vreverse(vload(&pt_2[SUBBANDS_NUMBER*(15 - 2*i)]));
+            vint32 temp2 = vreverse(vload(&pt_2[SUBBANDS_NUMBER*(2*i + 1)]));
+            vint32 temp4 = vload(&pt_1[SUBBANDS_NUMBER*(14 - 2*i)]);
+            vint32 win0  = vload(&winPtr[ 0]);
+            vint32 win1  = vload(&winPtr[ 4]);
+            vint32 win2  = vload(&winPtr[ 8]);
+            vint32 win3  = vload(&winPtr[12]);
+
+            vsum1 = vfxp_mac32_Q32(vsum1, temp1, win0);
+            vsum2 = vfxp_mac32_Q32(vsum2, temp3, win0);
+            vsum2 = vfxp_mac32_Q32(vsum2, temp1, win1);
+            vsum1 = vfxp_msb32_Q32(vsum1, temp3, win1);
+            vsum1 = vfxp_mac32_Q32(vsum1, temp2, win2);
+            vsum2 = vfxp_msb32_Q32(vsum2, temp4, win2);
+            vsum2 = vfxp_mac32_Q32(vsum2, temp2, win3);
+            vsum1 = vfxp_mac32_Q32(vsum1, temp4, win3);
+
+            winPtr += 16;
+        }
+
+        vsaturate16_store(out, vsra(vsum1, 6), vsra(vsum2, 6));
+
+        for (i = 0; i < 4; i++)
+        {
+            int32 j = j0 + i;
+
+            if (j < SUBBANDS_NUMBER / 2)
+            {
+                int32 k = j << (numChannels - 1);
+                outPcm[k] = out[i];
+                outPcm[(numChannels<<5) - k] = out[4 + i];
+            }
+        }
+    }
+
+
+    winPtr = &pqmfSynthWin[((SUBBANDS_NUMBER / 2) - 1) << 4];
+
+    sum1 = 0x00000020;
+    sum2 = 0x00000020;
+
+
+    for (i = 16; i < HAN_SIZE + 16; i += (SUBBANDS_NUMBER << 2))
+    {
+        int32 *pt_synth = &synth_buffer[i];
+        int32 temp1 = pt_synth[ 0                ];
+        int32 temp2 = pt_synth[ SUBBANDS_NUMBER  ];
+        int32 temp3 = pt_synth[ SUBBANDS_NUMBER/2];
+
+        sum1 = fxp_mac32_Q32(sum1, temp1, winPtr[0]) ;
+        sum1 = fxp_mac32_Q32(sum1, temp2, winPtr[1]) ;
+        sum2 = fxp_mac32_Q32(sum2, temp3, winPtr[2]) ;
+
+        temp1 = pt_synth[ SUBBANDS_NUMBER<<1 ];
+        temp2 = pt_synth[ 3*SUBBANDS_NUMBER  ];
+        temp3 = pt_synth[ SUBBANDS_NUMBER*5/2];
+
+        sum1 = fxp_mac32_Q32(sum1, temp1, winPtr[3]) ;
+        sum1 = fxp_mac32_Q32(sum1, temp2, winPtr[4]) ;
+        sum2 = fxp_mac32_Q32(sum2, temp3, winPtr[5]) ;
+
+        winPtr += 6;
+    }
+
+
+    outPcm[0] = saturate16(sum1 >> 6);
+    outPcm[(SUBBANDS_NUMBER/2)<<(numChannels-1)] = saturate16(sum2 >> 6);
+}
+
+#endif  /* PV_MP3DEC_SIMD */
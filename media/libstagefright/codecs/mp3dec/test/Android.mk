@@ -0,0 +1,41 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ================================================================
+# Unit tests for libstagefright_mp3dec
+# ================================================================
+
+# ================================================================
+# Compares the NEON/SSE2 filterbank with the C version
+# ================================================================
+ifneq ($(filter true,$(ARCH_ARM_HAVE_NEON))$(filter x86,$(TARGET_ARCH)),)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := Mp3DecSimd_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := Mp3DecSimd_test.cpp
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../src \
+	$(LOCAL_PATH)/../include \
+	$(TOP)/frameworks/av/media/libstagefright/include
+
+LOCAL_CFLAGS := -DOSCL_UNUSED_ARG=
+
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+    LOCAL_ARM_NEON := true
+    LOCAL_CFLAGS += -DPV_MP3DEC_NEON
+endif
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DPV_MP3DEC_SSE2
+endif
+
+LOCAL_STATIC_LIBRARIES := \
+	libstagefright_mp3dec
+
+LOCAL_SHARED_LIBRARIES := \
+	libutils
+
+include $(BUILD_NATIVE_TEST)
+endif
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Mp3DecSimd_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pvmp3decoder_api.h"
+#include "pvmp3_dec_simd.h"
+#include "pvmp3_mdct_18.h"
+#include "pvmp3_polyphase_filter_window.h"
+
+// Checks the NEON/SSE2 filterbank of the MP3 decoder bit for bit. The 4-band
+// IMDCT and the polyphase window are called next to their C versions, the
+// whole frame decoder is run by two decoder instances, one with
+// pvmp3_cpu_has_simd cleared and one with it set.
+
+namespace android {
+namespace test {
+
+static const int kIterations = 20000;
+
+class Mp3DecSimdTest : public ::testing::Test {
+protected:
+    Mp3DecSimdTest()
+        : mRandom(0x2545f491) {
+        mDecoderMem[0] = mDecoderMem[1] = NULL;
+    }
+
+    virtual void SetUp() {
+        pvmp3_init_cpu_features();
+        mHasSimd = pvmp3_cpu_has_simd;
+    }
+
+    virtual void TearDown() {
+        // FrameDecoder switches the flag between the two decoders
+        pvmp3_cpu_has_simd = mHasSimd;
+
+        free(mDecoderMem[0]);
+        free(mDecoderMem[1]);
+    }
+
+    // xorshift32, rand() does not give the 32 bits the fixed point
+    // arithmetic needs to be tested up to its limits
+    uint32 next() {
+        mRandom ^= mRandom << 13;
+        mRandom ^= mRandom >> 17;
+        mRandom ^= mRandom << 5;
+        return mRandom;
+    }
+
+    // Full range values half of the time, so that the fixed point
+    // arithmetic wraps around, smaller ones otherwise.
+    int32 random32(bool fullRange) {
+        int32 value = (int32)next();
+        return fullRange ? value : value >> (next() % 31);
+    }
+
+    // Decoder k, the C version for 0 and the SIMD one for 1
+    void initDecoder(int k) {
+        mDecoderMem[k] = malloc(pvmp3_decoderMemRequirements());
+        memset(&mConfig[k], 0, sizeof(mConfig[k]));
+        mConfig[k].equalizerType = flat;
+        mConfig[k].crcEnabled = false;
+        pvmp3_InitDecoder(&mConfig[k], mDecoderMem[k]);
+    }
+
+    ERROR_CODE decode(int k, uint8 *frame, int32 size, int16 *pcm) {
+        mConfig[k].pInputBuffer = frame;
+        mConfig[k].inputBufferCurrentLength = size;
+        mConfig[k].inputBufferUsedLength = 0;
+        mConfig[k].inputBufferMaxLength = 0;
+        mConfig[k].outputFrameSize = 4608;
+        mConfig[k].pOutputBuffer = pcm;
+
+        pvmp3_cpu_has_simd = k;
+        return pvmp3_framedecoder(&mConfig[k], mDecoderMem[k]);
+    }
+
+    int32 mHasSimd;
+    uint32 mRandom;
+    void *mDecoderMem[2];
+    tPVMP3DecoderExternal mConfig[2];
+};
+
+TEST_F(Mp3DecSimdTest, Mdct18) {
+    if (!mHasSimd) {
+        return;
+    }
+
+    for (int n = 0; n < kIterations; n++) {
+        int32 vec[2][4 * 18], history[2][4 * 18], window[36];
+        bool fullRange = n & 1;
+
+        for (int i = 0; i < 4 * 18; i++) {
+            vec[0][i] = vec[1][i] = random32(fullRange);
+            history[0][i] = history[1][i] = random32(fullRange);
+        }
+        for (int i = 0; i < 36; i++) {
+            window[i] = random32(fullRange);
+        }
+
+        for (int band = 0; band < 4; band++) {
+            pvmp3_mdct_18(vec[0] + band * 18, history[0] + band * 18, window);
+        }
+        pvmp3_mdct_18_x4(vec[1], history[1], window);
+
+        ASSERT_EQ(0, memcmp(vec[0], vec[1], sizeof(vec[0]))) << "iteration " << n;
+        ASSERT_EQ(0, memcmp(history[0], history[1], sizeof(history[0]))) << "iteration " << n;
+    }
+}
+
+TEST_F(Mp3DecSimdTest, PolyphaseFilterWindow) {
+    if (!mHasSimd) {
+        return;
+    }
+
+    for (int n = 0; n < kIterations; n++) {
+        int32 synth[544];
+        int16 pcm[2][64];
+        int32 numChannels = 1 + (n & 1);
+        bool fullRange = n & 2;
+
+        for (int i = 0; i < 544; i++) {
+            synth[i] = random32(fullRange);
+        }
+        memset(pcm, 0, sizeof(pcm));
+
+        pvmp3_polyphase_filter_window(synth, pcm[0], numChannels);
+        pvmp3_polyphase_filter_window_simd(synth, pcm[1], numChannels);
+
+        ASSERT_EQ(0, memcmp(pcm[0], pcm[1], sizeof(pcm[0])))
+                << "iteration " << n << " channels " << numChannels;
+    }
+}
+
+// Decodes random MPEG-1 layer III frames, so that every block type and
+// number of used subbands goes through the IMDCT, and compares the PCM.
+TEST_F(Mp3DecSimdTest, FrameDecoder) {
+    if (!mHasSimd) {
+        return;
+    }
+
+    uint8 frame[417];
+    int16 pcm[2][4608];
+
+    initDecoder(0);
+    initDecoder(1);
+
+    for (int n = 0; n < kIterations / 10; n++) {
+        // 128 kbit/s, 44.1 kHz, stereo or joint stereo, main_data_begin 0
+        frame[0] = 0xff;
+        frame[1] = 0xfb;
+        frame[2] = 0x90;
+        frame[3] = (next() & 1) ? 0x60 : 0x00;
+        for (size_t i = 4; i < sizeof(frame); i++) {
+            frame[i] = next();
+        }
+        frame[4] = 0;
+        frame[5] &= 0x7f;
+
+        ERROR_CODE status[2];
+        for (int k = 0; k < 2; k++) {
+            memset(pcm[k], 0, sizeof(pcm[k]));
+            status[k] = decode(k, frame, sizeof(frame), pcm[k]);
+        }
+
+        ASSERT_EQ(status[0], status[1]) << "frame " << n;
+        ASSERT_EQ(mConfig[0].outputFrameSize, mConfig[1].outputFrameSize) << "frame " << n;
+        ASSERT_EQ(0, memcmp(pcm[0], pcm[1], mConfig[0].outputFrameSize * sizeof(int16)))
+                << "frame " << n;
+    }
+}
+
+}  // namespace test
+}  // namespace android
@@ -25,6 +25,8 @@
 #include <media/stagefright/MediaErrors.h>
 #include <media/IOMX.h>
 
+#include <unistd.h>
+
 
 namespace android {
 
@@ -161,10 +163,19 @@ void SoftAVC::initPorts() {
 
 status_t SoftAVC::initDecoder() {
     // Force decoder to output buffers in display order.
-    if (H264SwDecInit(&mHandle, 0) == H264SWDEC_OK) {
-        return OK;
+    if (H264SwDecInit(&mHandle, 0) != H264SWDEC_OK) {
+        return UNKNOWN_ERROR;
+    }
+
+    // On multi-core devices let the decoder deblock in parallel with
+    // decoding, the output is identical to single threaded decoding.
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numCpus > 1
+            && H264SwDecSetNumThreads(mHandle, numCpus) != H264SWDEC_OK) {
+        ALOGW("Failed to enable multithreaded decoding.");
     }
-    return UNKNOWN_ERROR;
+
+    return OK;
 }
 
 OMX_ERRORTYPE SoftAVC::internalGetParameter(
@@ -534,6 +545,32 @@ void SoftAVC::onPortEnableCompleted(OMX_U32 portIndex, bool enabled) {
     }
 }
 
+void SoftAVC::onReset() {
+    // The next stream starts with a decoder that has no reference
+    // pictures or parameter sets of this one.
+    H264SwDecRelease(mHandle);
+    mHandle = NULL;
+    CHECK_EQ(initDecoder(), (status_t)OK);
+
+    while (mPicToHeaderMap.size() != 0) {
+        OMX_BUFFERHEADERTYPE *header = mPicToHeaderMap.editValueAt(0);
+        mPicToHeaderMap.removeItemsAt(0);
+        delete header;
+        header = NULL;
+    }
+
+    delete[] mFirstPicture;
+    mFirstPicture = NULL;
+    mFirstPictureId = -1;
+
+    mInputBufferCount = 0;
+    mPicId = 0;
+    mHeadersDecoded = false;
+    mEOSStatus = INPUT_DATA_AVAILABLE;
+    mOutputPortSettingsChange = NONE;
+    mSignalledError = false;
+}
+
 void SoftAVC::updatePortDefinitions() {
     OMX_PARAM_PORTDEFINITIONTYPE *def = &editPortInfo(0)->mDef;
     def->format.video.nFrameWidth = mWidth;
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 /*------------------------------------------------------------------------------
     Module defines
@@ -102,6 +103,9 @@ int main(int argc, char **argv)
     u32 numErrors = 0;
     u32 cropDisplay = 0;
     u32 disableOutputReordering = 0;
+    u32 numThreads = 1;
+    struct timeval startTime, endTime;
+    double decodeTime;
 
     FILE *finput;
 
@@ -123,7 +127,7 @@ int main(int argc, char **argv)
     if (argc < 2)
     {
         DEBUG((
-            "Usage: %s [-Nn] [-Ooutfile] [-P] [-U] [-C] [-R] [-T] file.h264\n",
+            "Usage: %s [-Nn] [-Ooutfile] [-P] [-U] [-C] [-R] [-Mn] [-T] file.h264\n",
             argv[0]));
         DEBUG(("\t-Nn forces decoding to stop after n pictures\n"));
 #if defined(_NO_OUT)
@@ -136,6 +140,8 @@ int main(int argc, char **argv)
         DEBUG(("\t-U NAL unit stream mode\n"));
         DEBUG(("\t-C display cropped image (default decoded image)\n"));
         DEBUG(("\t-R disable DPB output reordering\n"));
+        DEBUG(("\t-Mn decode using n threads (default 1), output shall be\n"
+               "\t    identical to the output of a single threaded decoder\n"));
         DEBUG(("\t-T to print tag name and exit\n"));
         return 0;
     }
@@ -167,6 +173,10 @@ int main(int argc, char **argv)
         {
             disableOutputReordering = 1;
         }
+        else if ( strncmp(argv[i], "-M", 2) == 0 )
+        {
+            numThreads = (u32)atoi(argv[i]+2);
+        }
     }
 
     /* open input file for reading, file name given by user. If file open
@@ -204,6 +214,15 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    ret = H264SwDecSetNumThreads(decInst, numThreads);
+    if (ret != H264SWDEC_OK)
+    {
+        DEBUG(("SETTING NUMBER OF THREADS FAILED\n"));
+        H264SwDecRelease(decInst);
+        free(byteStrmStart);
+        return -1;
+    }
+
     /* initialize H264SwDecDecode() input structure */
     streamStop = byteStrmStart + strmLen;
     decInput.pStream = byteStrmStart;
@@ -216,6 +235,7 @@ int main(int argc, char **argv)
         decInput.dataLen = tmp;
 
     picDecodeNumber = picDisplayNumber = 1;
+    gettimeofday(&startTime, NULL);
     /* main decoding loop */
     do
     {
@@ -408,6 +428,8 @@ int main(int argc, char **argv)
         }
     }
 
+    gettimeofday(&endTime, NULL);
+
     /* release decoder instance */
     H264SwDecRelease(decInst);
 
@@ -420,6 +442,15 @@ int main(int argc, char **argv)
 
     DEBUG(("Output file: %s\n", outFileName));
 
+    /* decoding time includes writing of the output, use -Onone to
+     * measure decoding performance only */
+    decodeTime = (endTime.tv_sec - startTime.tv_sec) +
+        (endTime.tv_usec - startTime.tv_usec) / 1000000.0;
+    DEBUG(("%d pictures decoded in %.3f s (%.2f fps, %d threads)\n",
+        picDecodeNumber - 1, decodeTime,
+        decodeTime > 0 ? (picDecodeNumber - 1) / decodeTime : 0.0,
+        numThreads));
+
     DEBUG(("DECODING DONE\n"));
     if (numErrors || picDecodeNumber == 1)
     {
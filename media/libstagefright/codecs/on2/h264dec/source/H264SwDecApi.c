@@ -24,6 +24,7 @@
      4. Local function prototypes
      5. Functions
           H264SwDecInit
+          H264SwDecSetNumThreads
           H264SwDecGetInfo
           H264SwDecRelease
           H264SwDecDecode
@@ -175,6 +176,84 @@ H264SwDecRet H264SwDecInit(H264SwDecInst *decInst, u32 noOutputReordering)
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSetNumThreads()
+
+        Functional description:
+            Set number of threads the decoder may use. With more than one
+            thread deblocking filtering is pipelined with decoding of the
+            picture, see h264bsdSetNumThreads. Output is bit exact with
+            single threaded decoding for error free streams. Shall be called
+            between pictures, e.g. right after H264SwDecInit.
+
+        Inputs:
+            decInst     decoder instance
+            numThreads  number of threads, values above
+                        MAX_NUM_DECODER_THREADS are clamped
+
+        Outputs:
+            none
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters or picture being
+                                    decoded
+            H264SWDEC_MEMFAIL       failed to allocate memory or to create
+                                    the thread
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSetNumThreads(H264SwDecInst decInst, u32 numThreads)
+{
+
+    u32 rv;
+    decContainer_t *pDecCont;
+
+    DEC_API_TRC("H264SwDecSetNumThreads#");
+
+    if (decInst == NULL)
+    {
+        DEC_API_TRC("H264SwDecSetNumThreads# ERROR: decInst == NULL");
+        return(H264SWDEC_PARAM_ERR);
+    }
+
+    pDecCont = (decContainer_t *)decInst;
+
+    if (pDecCont->decStat == UNINITIALIZED)
+    {
+        DEC_API_TRC("H264SwDecSetNumThreads# ERROR: Decoder not initialized");
+        return(H264SWDEC_NOT_INITIALIZED);
+    }
+
+#ifdef H264DEC_TRACE
+    sprintf(pDecCont->str, "H264SwDecSetNumThreads# decInst %p numThreads %d",
+            decInst, numThreads);
+    DEC_API_TRC(pDecCont->str);
+#endif
+
+    if (pDecCont->storage.picStarted)
+    {
+        DEC_API_TRC("H264SwDecSetNumThreads# ERROR: Picture being decoded");
+        return(H264SWDEC_PARAM_ERR);
+    }
+
+    if (numThreads > MAX_NUM_DECODER_THREADS)
+        numThreads = MAX_NUM_DECODER_THREADS;
+
+    rv = h264bsdSetNumThreads(&pDecCont->storage, numThreads);
+    if (rv != HANTRO_OK)
+    {
+        DEC_API_TRC("H264SwDecSetNumThreads# ERROR: Thread creation failed");
+        return(H264SWDEC_MEMFAIL);
+    }
+
+    DEC_API_TRC("H264SwDecSetNumThreads# OK");
+
+    return(H264SWDEC_OK);
+
+}
+
 /*------------------------------------------------------------------------------
 
     Function: H264SwDecGetInfo()
@@ -24,6 +24,7 @@
      4. Local function prototypes
      5. Functions
           h264bsdFilterPicture
+          h264bsdFilterRows
           FilterVerLumaEdge
           FilterHorLumaEdge
           FilterHorLuma
@@ -40,6 +41,8 @@
           GetChromaEdgeThresholds
           FilterLuma
           FilterChroma
+          FilterLumaSse2
+          FilterChromaSse2
 
 ------------------------------------------------------------------------------*/
 
@@ -53,6 +56,10 @@
 #include "h264bsd_deblocking.h"
 #include "h264bsd_dpb.h"
 
+#ifdef H264DEC_SSE2
+#include <emmintrin.h>
+#endif /* H264DEC_SSE2 */
+
 #ifdef H264DEC_OMXDL
 #include "omxtypes.h"
 #include "omxVC.h"
@@ -201,6 +208,13 @@ static void GetChromaEdgeThresholds(
   u32 filteringFlags,
   i32 chromaQpIndexOffset);
 
+#ifdef H264DEC_SSE2
+static void FilterLumaSse2(u8 *data, bS_t *bS, edgeThreshold_t *thresholds,
+        u32 imageWidth);
+static void FilterChromaSse2(u8 *cb, u8 *cr, bS_t *bS,
+        edgeThreshold_t *thresholds, u32 imageWidth);
+#endif /* H264DEC_SSE2 */
+
 #else /* H264DEC_OMXDL */
 
 static u32 GetBoundaryStrengths(mbStorage_t *mb, u8 (*bs)[16], u32 flags);
@@ -548,20 +562,26 @@ u32 EdgeBoundaryStrengthLeft(mbStorage_t *mb1, mbStorage_t *mb2)
 #endif /* H264DEC_OMXDL */
 /*------------------------------------------------------------------------------
 
-    Function: h264bsdFilterPicture
+    Function: h264bsdFilterRows
 
         Functional description:
-          Perform deblocking filtering for a picture. Filter does not copy
-          the original picture anywhere but filtering is performed directly
-          on the original image. Parameters controlling the filtering process
-          are computed based on information in macroblock structures of the
-          filtered macroblock, macroblock above and macroblock on the left of
-          the filtered one.
+          Perform deblocking filtering for a range of macroblock rows of a
+          picture. Filter does not copy the original picture anywhere but
+          filtering is performed directly on the original image. Parameters
+          controlling the filtering process are computed based on
+          information in macroblock structures of the filtered macroblock,
+          macroblock above and macroblock on the left of the filtered one.
+
+          Rows have to be filtered in order, i.e. row above firstRow shall
+          already be filtered. Filtering of a row modifies the row and three
+          bottom pixel rows of the row above.
 
         Inputs:
           image         pointer to image to be filtered
           mb            pointer to macroblock data structure of the top-left
                         macroblock of the picture
+          firstRow      first macroblock row to be filtered
+          numRows       number of macroblock rows to be filtered
 
         Outputs:
           image         filtered image stored here
@@ -571,9 +591,11 @@ u32 EdgeBoundaryStrengthLeft(mbStorage_t *mb1, mbStorage_t *mb2)
 
 ------------------------------------------------------------------------------*/
 #ifndef H264DEC_OMXDL
-void h264bsdFilterPicture(
+void h264bsdFilterRows(
   image_t *image,
-  mbStorage_t *mb)
+  mbStorage_t *mb,
+  u32 firstRow,
+  u32 numRows)
 {
 
 /* Variables */
@@ -593,14 +615,15 @@ void h264bsdFilterPicture(
     ASSERT(image->data);
     ASSERT(image->width);
     ASSERT(image->height);
+    ASSERT(firstRow + numRows <= image->height);
 
     picWidthInMbs = image->width;
     data = image->data;
     picSizeInMbs = picWidthInMbs * image->height;
 
-    pMb = mb;
+    pMb = mb + firstRow * picWidthInMbs;
 
-    for (mbRow = 0, mbCol = 0; mbRow < image->height; pMb++)
+    for (mbRow = firstRow, mbCol = 0; mbRow < firstRow + numRows; pMb++)
     {
         flags = GetMbFilteringFlags(pMb);
 
@@ -614,6 +637,12 @@ void h264bsdFilterPicture(
                 GetLumaEdgeThresholds(thresholds, pMb, flags);
                 data = image->data + mbRow * picWidthInMbs * 256 + mbCol * 16;
 
+#ifdef H264DEC_SSE2
+                if (h264bsdCpuHasSse2)
+                    FilterLumaSse2((u8*)data, bS, thresholds,
+                        picWidthInMbs*16);
+                else
+#endif /* H264DEC_SSE2 */
                 FilterLuma((u8*)data, bS, thresholds, picWidthInMbs*16);
 
                 /* chroma */
@@ -622,6 +651,12 @@ void h264bsdFilterPicture(
                 data = image->data + picSizeInMbs * 256 +
                     mbRow * picWidthInMbs * 64 + mbCol * 8;
 
+#ifdef H264DEC_SSE2
+                if (h264bsdCpuHasSse2)
+                    FilterChromaSse2((u8*)data, data + 64*picSizeInMbs, bS,
+                        thresholds, picWidthInMbs*8);
+                else
+#endif /* H264DEC_SSE2 */
                 FilterChroma((u8*)data, data + 64*picSizeInMbs, bS,
                         thresholds, picWidthInMbs*8);
 
@@ -1735,24 +1770,580 @@ void FilterChroma(
     }
 }
 
+#ifdef H264DEC_SSE2
+/*------------------------------------------------------------------------------
+
+    Function: LoadColumnsSse2
+
+        Functional description:
+            Load 16 rows of 8 pixels and transpose them so that each
+            register holds one pixel column, i.e. p3, p2, p1, p0, q0, q1, q2
+            and q3 of a vertical edge in the middle of the rows. The first
+            eight rows are read from ptr1, the rest from ptr2.
+
+------------------------------------------------------------------------------*/
+
+static void LoadColumnsSse2(u8 *ptr1, u8 *ptr2, u32 width, __m128i *pix)
+{
+
+/* Variables */
+
+    u32 i;
+    __m128i rows[16];
+    __m128i a[8], b[8], c[8];
+
+/* Code */
+
+    for (i = 0; i < 8; i++)
+    {
+        rows[i] = _mm_loadl_epi64((__m128i*)(ptr1 + i*width));
+        rows[i+8] = _mm_loadl_epi64((__m128i*)(ptr2 + i*width));
+    }
+
+    for (i = 0; i < 8; i++)
+        a[i] = _mm_unpacklo_epi8(rows[2*i], rows[2*i+1]);
+
+    for (i = 0; i < 4; i++)
+    {
+        b[2*i]   = _mm_unpacklo_epi16(a[2*i], a[2*i+1]);
+        b[2*i+1] = _mm_unpackhi_epi16(a[2*i], a[2*i+1]);
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        c[4*i]   = _mm_unpacklo_epi32(b[4*i], b[4*i+2]);
+        c[4*i+1] = _mm_unpackhi_epi32(b[4*i], b[4*i+2]);
+        c[4*i+2] = _mm_unpacklo_epi32(b[4*i+1], b[4*i+3]);
+        c[4*i+3] = _mm_unpackhi_epi32(b[4*i+1], b[4*i+3]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        pix[2*i]   = _mm_unpacklo_epi64(c[i], c[i+4]);
+        pix[2*i+1] = _mm_unpackhi_epi64(c[i], c[i+4]);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: StoreColumnsSse2
+
+        Functional description:
+            Inverse of LoadColumnsSse2, transpose pixel columns back to rows
+            and store them.
+
+------------------------------------------------------------------------------*/
+
+static void StoreColumnsSse2(u8 *ptr1, u8 *ptr2, u32 width, __m128i *pix)
+{
+
+/* Variables */
+
+    u32 i;
+    __m128i a[8], b[8], c[8];
+
+/* Code */
+
+    for (i = 0; i < 4; i++)
+    {
+        a[2*i]   = _mm_unpacklo_epi8(pix[2*i], pix[2*i+1]);
+        a[2*i+1] = _mm_unpackhi_epi8(pix[2*i], pix[2*i+1]);
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        b[4*i]   = _mm_unpacklo_epi16(a[4*i], a[4*i+2]);
+        b[4*i+1] = _mm_unpackhi_epi16(a[4*i], a[4*i+2]);
+        b[4*i+2] = _mm_unpacklo_epi16(a[4*i+1], a[4*i+3]);
+        b[4*i+3] = _mm_unpackhi_epi16(a[4*i+1], a[4*i+3]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        c[2*i]   = _mm_unpacklo_epi32(b[i], b[i+4]);
+        c[2*i+1] = _mm_unpackhi_epi32(b[i], b[i+4]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        _mm_storel_epi64((__m128i*)(ptr1 + 2*i*width), c[i]);
+        _mm_storel_epi64((__m128i*)(ptr1 + (2*i+1)*width),
+            _mm_unpackhi_epi64(c[i], c[i]));
+        _mm_storel_epi64((__m128i*)(ptr2 + 2*i*width), c[i+4]);
+        _mm_storel_epi64((__m128i*)(ptr2 + (2*i+1)*width),
+            _mm_unpackhi_epi64(c[i+4], c[i+4]));
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LessThanSse2
+
+        Functional description:
+            Absolute difference of unsigned 8-bit lanes compared against a
+            threshold, returns 0xFF in lanes where |a-b| < threshold.
+
+------------------------------------------------------------------------------*/
+
+static __m128i LessThanSse2(__m128i a, __m128i b, u32 threshold)
+{
+    __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+
+    diff = _mm_subs_epu8(_mm_set1_epi8((i8)threshold), diff);
+    return _mm_andnot_si128(_mm_cmpeq_epi8(diff, _mm_setzero_si128()),
+        _mm_set1_epi8(-1));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: SelectSse2
+
+        Functional description:
+            Pick lanes of a where mask is set and lanes of b elsewhere.
+
+------------------------------------------------------------------------------*/
+
+static __m128i SelectSse2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: WidenSse2
+
+        Functional description:
+            Zero extend low (half = 0) or high (half = 1) eight 8-bit lanes to
+            16 bits.
+
+------------------------------------------------------------------------------*/
+
+static __m128i WidenSse2(__m128i a, u32 half)
+{
+    if (half)
+        return _mm_unpackhi_epi8(a, _mm_setzero_si128());
+    else
+        return _mm_unpacklo_epi8(a, _mm_setzero_si128());
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterLumaPixelsSse2
+
+        Functional description:
+            Filter 16 lines of luma pixels across an edge, pix contains
+            p3...q3 of each line and bS the boundary strength of each line.
+            Lines with bS 4 use the strong filter, others the normal one,
+            exactly as FilterVerLumaEdge and FilterHorLuma do.
+
+------------------------------------------------------------------------------*/
+
+static void FilterLumaPixelsSse2(
+  __m128i *pix,
+  const u8 *bS,
+  edgeThreshold_t *thresholds)
+{
+
+/* Variables */
+
+    u32 i, half;
+    u8 tc0Lanes[16];
+    __m128i p3, p2, p1, p0, q0, q1, q2, q3;
+    __m128i bsLanes, filter, strong, normal, ap, aq, tc0, tc;
+    __m128i P3, P2, P1, P0, Q0, Q1, Q2, Q3, TC0, TC, delta, tmp, tmp2;
+    __m128i out[8][2];
+    __m128i two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+
+/* Code */
+
+    p3 = pix[0]; p2 = pix[1]; p1 = pix[2]; p0 = pix[3];
+    q0 = pix[4]; q1 = pix[5]; q2 = pix[6]; q3 = pix[7];
+
+    bsLanes = _mm_loadu_si128((const __m128i*)bS);
+
+    filter = _mm_and_si128(LessThanSse2(p0, q0, thresholds->alpha),
+        _mm_and_si128(LessThanSse2(p1, p0, thresholds->beta),
+                      LessThanSse2(q1, q0, thresholds->beta)));
+    filter = _mm_andnot_si128(
+        _mm_cmpeq_epi8(bsLanes, _mm_setzero_si128()), filter);
+
+    strong = _mm_cmpeq_epi8(bsLanes, _mm_set1_epi8(4));
+    normal = _mm_andnot_si128(strong, filter);
+    strong = _mm_and_si128(strong, filter);
+
+    if (_mm_movemask_epi8(normal))
+    {
+        for (i = 0; i < 16; i++)
+            tc0Lanes[i] = (bS[i] && bS[i] < 4) ? thresholds->tc0[bS[i]-1] : 0;
+        tc0 = _mm_loadu_si128((const __m128i*)tc0Lanes);
+
+        ap = _mm_and_si128(LessThanSse2(p2, p0, thresholds->beta), normal);
+        aq = _mm_and_si128(LessThanSse2(q2, q0, thresholds->beta), normal);
+        /* masks are -1 where set, tc = tc0 + ap + aq */
+        tc = _mm_sub_epi8(_mm_sub_epi8(tc0, ap), aq);
+
+        for (half = 0; half < 2; half++)
+        {
+            P2 = WidenSse2(p2, half); P1 = WidenSse2(p1, half);
+            P0 = WidenSse2(p0, half); Q0 = WidenSse2(q0, half);
+            Q1 = WidenSse2(q1, half); Q2 = WidenSse2(q2, half);
+            TC0 = WidenSse2(tc0, half); TC = WidenSse2(tc, half);
+
+            /* (p0 + q0 + 1) >> 1 */
+            tmp = _mm_avg_epu16(P0, Q0);
+
+            /* p1 + CLIP3(-tc0, tc0, (p2 + tmp - (p1 << 1)) >> 1) */
+            delta = _mm_srai_epi16(
+                _mm_sub_epi16(_mm_add_epi16(P2, tmp), _mm_slli_epi16(P1, 1)),
+                1);
+            delta = _mm_max_epi16(_mm_min_epi16(delta, TC0),
+                _mm_sub_epi16(_mm_setzero_si128(), TC0));
+            out[0][half] = _mm_add_epi16(P1, delta);
+
+            delta = _mm_srai_epi16(
+                _mm_sub_epi16(_mm_add_epi16(Q2, tmp), _mm_slli_epi16(Q1, 1)),
+                1);
+            delta = _mm_max_epi16(_mm_min_epi16(delta, TC0),
+                _mm_sub_epi16(_mm_setzero_si128(), TC0));
+            out[1][half] = _mm_add_epi16(Q1, delta);
+
+            /* CLIP3(-tc, tc, (((q0 - p0) << 2) + (p1 - q1) + 4) >> 3) */
+            delta = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(Q0, P0), 2),
+                _mm_sub_epi16(P1, Q1));
+            delta = _mm_srai_epi16(_mm_add_epi16(delta, four), 3);
+            delta = _mm_max_epi16(_mm_min_epi16(delta, TC),
+                _mm_sub_epi16(_mm_setzero_si128(), TC));
+            out[2][half] = _mm_add_epi16(P0, delta);
+            out[3][half] = _mm_sub_epi16(Q0, delta);
+        }
+
+        p1 = SelectSse2(ap, _mm_packus_epi16(out[0][0], out[0][1]), p1);
+        q1 = SelectSse2(aq, _mm_packus_epi16(out[1][0], out[1][1]), q1);
+        p0 = SelectSse2(normal, _mm_packus_epi16(out[2][0], out[2][1]), p0);
+        q0 = SelectSse2(normal, _mm_packus_epi16(out[3][0], out[3][1]), q0);
+    }
+
+    if (_mm_movemask_epi8(strong))
+    {
+        tmp = LessThanSse2(p0, q0, (thresholds->alpha >> 2) + 2);
+        ap = _mm_and_si128(_mm_and_si128(tmp, strong),
+            LessThanSse2(p2, p0, thresholds->beta));
+        aq = _mm_and_si128(_mm_and_si128(tmp, strong),
+            LessThanSse2(q2, q0, thresholds->beta));
+
+        for (half = 0; half < 2; half++)
+        {
+            P3 = WidenSse2(p3, half); P2 = WidenSse2(p2, half);
+            P1 = WidenSse2(p1, half); P0 = WidenSse2(p0, half);
+            Q0 = WidenSse2(q0, half); Q1 = WidenSse2(q1, half);
+            Q2 = WidenSse2(q2, half); Q3 = WidenSse2(q3, half);
+
+            /* strong filtering of p side, tmp = p1 + p0 + q0 */
+            tmp = _mm_add_epi16(_mm_add_epi16(P1, P0), Q0);
+            tmp2 = _mm_add_epi16(_mm_add_epi16(P2, Q1),
+                _mm_slli_epi16(tmp, 1));
+            out[0][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, four), 3);
+            tmp2 = _mm_add_epi16(P2, tmp);
+            out[1][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, two), 2);
+            tmp2 = _mm_add_epi16(_mm_slli_epi16(P3, 1),
+                _mm_add_epi16(_mm_add_epi16(P2, _mm_slli_epi16(P2, 1)), tmp));
+            out[2][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, four), 3);
+
+            /* strong filtering of q side, tmp = p0 + q0 + q1 */
+            tmp = _mm_add_epi16(_mm_add_epi16(P0, Q0), Q1);
+            tmp2 = _mm_add_epi16(_mm_add_epi16(P1, Q2),
+                _mm_slli_epi16(tmp, 1));
+            out[3][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, four), 3);
+            tmp2 = _mm_add_epi16(Q2, tmp);
+            out[4][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, two), 2);
+            tmp2 = _mm_add_epi16(_mm_slli_epi16(Q3, 1),
+                _mm_add_epi16(_mm_add_epi16(Q2, _mm_slli_epi16(Q2, 1)), tmp));
+            out[5][half] = _mm_srli_epi16(_mm_add_epi16(tmp2, four), 3);
+
+            /* weak filtering of p0 and q0 */
+            tmp = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(P1, 1), P0), Q1);
+            out[6][half] = _mm_srli_epi16(_mm_add_epi16(tmp, two), 2);
+            tmp = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(Q1, 1), Q0), P1);
+            out[7][half] = _mm_srli_epi16(_mm_add_epi16(tmp, two), 2);
+        }
+
+        p0 = SelectSse2(strong, _mm_packus_epi16(out[6][0], out[6][1]), p0);
+        q0 = SelectSse2(strong, _mm_packus_epi16(out[7][0], out[7][1]), q0);
+        p0 = SelectSse2(ap, _mm_packus_epi16(out[0][0], out[0][1]), p0);
+        p1 = SelectSse2(ap, _mm_packus_epi16(out[1][0], out[1][1]), p1);
+        p2 = SelectSse2(ap, _mm_packus_epi16(out[2][0], out[2][1]), p2);
+        q0 = SelectSse2(aq, _mm_packus_epi16(out[3][0], out[3][1]), q0);
+        q1 = SelectSse2(aq, _mm_packus_epi16(out[4][0], out[4][1]), q1);
+        q2 = SelectSse2(aq, _mm_packus_epi16(out[5][0], out[5][1]), q2);
+    }
+
+    pix[1] = p2; pix[2] = p1; pix[3] = p0;
+    pix[4] = q0; pix[5] = q1; pix[6] = q2;
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterChromaPixelsSse2
+
+        Functional description:
+            Filter 16 lines of chroma pixels across an edge, pix contains
+            p3...q3 of each line (only p1...q1 are used) and bS the boundary
+            strength of each line.
+
+------------------------------------------------------------------------------*/
+
+static void FilterChromaPixelsSse2(
+  __m128i *pix,
+  const u8 *bS,
+  edgeThreshold_t *thresholds)
+{
+
+/* Variables */
+
+    u32 i, half;
+    u8 tcLanes[16];
+    __m128i p1, p0, q0, q1;
+    __m128i bsLanes, filter, strong, normal, tc;
+    __m128i P1, P0, Q0, Q1, TC, delta, tmp;
+    __m128i out[4][2];
+    __m128i two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+
+/* Code */
+
+    p1 = pix[2]; p0 = pix[3]; q0 = pix[4]; q1 = pix[5];
+
+    bsLanes = _mm_loadu_si128((const __m128i*)bS);
+
+    filter = _mm_and_si128(LessThanSse2(p0, q0, thresholds->alpha),
+        _mm_and_si128(LessThanSse2(p1, p0, thresholds->beta),
+                      LessThanSse2(q1, q0, thresholds->beta)));
+    filter = _mm_andnot_si128(
+        _mm_cmpeq_epi8(bsLanes, _mm_setzero_si128()), filter);
+
+    if (!_mm_movemask_epi8(filter))
+        return;
+
+    strong = _mm_cmpeq_epi8(bsLanes, _mm_set1_epi8(4));
+    normal = _mm_andnot_si128(strong, filter);
+    strong = _mm_and_si128(strong, filter);
+
+    for (i = 0; i < 16; i++)
+        tcLanes[i] = (bS[i] && bS[i] < 4) ? thresholds->tc0[bS[i]-1] + 1 : 0;
+    tc = _mm_loadu_si128((const __m128i*)tcLanes);
+
+    for (half = 0; half < 2; half++)
+    {
+        P1 = WidenSse2(p1, half); P0 = WidenSse2(p0, half);
+        Q0 = WidenSse2(q0, half); Q1 = WidenSse2(q1, half);
+        TC = WidenSse2(tc, half);
+
+        /* CLIP3(-tc, tc, (((q0 - p0) << 2) + (p1 - q1) + 4) >> 3) */
+        delta = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(Q0, P0), 2),
+            _mm_sub_epi16(P1, Q1));
+        delta = _mm_srai_epi16(_mm_add_epi16(delta, four), 3);
+        delta = _mm_max_epi16(_mm_min_epi16(delta, TC),
+            _mm_sub_epi16(_mm_setzero_si128(), TC));
+        out[0][half] = _mm_add_epi16(P0, delta);
+        out[1][half] = _mm_sub_epi16(Q0, delta);
+
+        /* bS 4 */
+        tmp = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(P1, 1), P0), Q1);
+        out[2][half] = _mm_srli_epi16(_mm_add_epi16(tmp, two), 2);
+        tmp = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(Q1, 1), Q0), P1);
+        out[3][half] = _mm_srli_epi16(_mm_add_epi16(tmp, two), 2);
+    }
+
+    p0 = SelectSse2(normal, _mm_packus_epi16(out[0][0], out[0][1]), p0);
+    q0 = SelectSse2(normal, _mm_packus_epi16(out[1][0], out[1][1]), q0);
+    pix[3] = SelectSse2(strong, _mm_packus_epi16(out[2][0], out[2][1]), p0);
+    pix[4] = SelectSse2(strong, _mm_packus_epi16(out[3][0], out[3][1]), q0);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterLumaSse2
+
+        Functional description:
+            SSE2 version of FilterLuma. All vertical edges of the macroblock
+            are filtered first, 16 pixel rows at a time, and then the
+            horizontal edges 16 pixels at a time. This gives the same result
+            as filtering the vertical edges of each block row before the
+            horizontal edge above it because horizontal filtering of an edge
+            does not touch the pixels the vertical edges of the next block row
+            depend on.
+
+------------------------------------------------------------------------------*/
+
+static void FilterLumaSse2(
+  u8 *data,
+  bS_t *bS,
+  edgeThreshold_t *thresholds,
+  u32 width)
+{
+
+/* Variables */
+
+    u32 edge, i;
+    u8 bsLanes[16];
+    u8 *ptr;
+    __m128i pix[8];
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(bS);
+    ASSERT(thresholds);
+
+    for (edge = 0; edge < 4; edge++)
+    {
+        if (!(bS[edge].left | bS[edge+4].left | bS[edge+8].left |
+              bS[edge+12].left))
+            continue;
+
+        for (i = 0; i < 16; i++)
+            bsLanes[i] = (u8)bS[(i >> 2)*4 + edge].left;
+
+        ptr = data + 4*edge - 4;
+        LoadColumnsSse2(ptr, ptr + 8*width, width, pix);
+        FilterLumaPixelsSse2(pix, bsLanes,
+            thresholds + (edge ? INNER : LEFT));
+        StoreColumnsSse2(ptr, ptr + 8*width, width, pix);
+    }
+
+    for (edge = 0; edge < 4; edge++)
+    {
+        if (!(bS[4*edge].top | bS[4*edge+1].top | bS[4*edge+2].top |
+              bS[4*edge+3].top))
+            continue;
+
+        for (i = 0; i < 16; i++)
+            bsLanes[i] = (u8)bS[4*edge + (i >> 2)].top;
+
+        ptr = data + 4*edge*width;
+        for (i = 0; i < 8; i++)
+            pix[i] = _mm_loadu_si128((__m128i*)(ptr + ((i32)i-4)*(i32)width));
+
+        FilterLumaPixelsSse2(pix, bsLanes,
+            thresholds + (edge ? INNER : TOP));
+
+        for (i = 1; i < 7; i++)
+            _mm_storeu_si128((__m128i*)(ptr + ((i32)i-4)*(i32)width), pix[i]);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterChromaSse2
+
+        Functional description:
+            SSE2 version of FilterChroma. Corresponding edges of both chroma
+            components are filtered together, Cb in the first eight lanes and
+            Cr in the rest.
+
+------------------------------------------------------------------------------*/
+
+static void FilterChromaSse2(
+  u8 *dataCb,
+  u8 *dataCr,
+  bS_t *bS,
+  edgeThreshold_t *thresholds,
+  u32 width)
+{
+
+/* Variables */
+
+    u32 edge, i;
+    u8 bsLanes[16];
+    u8 *cb, *cr;
+    __m128i pix[8];
+
+/* Code */
+
+    ASSERT(dataCb);
+    ASSERT(dataCr);
+    ASSERT(bS);
+    ASSERT(thresholds);
+
+    /* chroma edges use bS of every other luma edge, each bS for two pixel
+     * rows/columns */
+    for (edge = 0; edge < 2; edge++)
+    {
+        if (!(bS[2*edge].left | bS[2*edge+4].left | bS[2*edge+8].left |
+              bS[2*edge+12].left))
+            continue;
+
+        for (i = 0; i < 16; i++)
+            bsLanes[i] = (u8)bS[((i & 7) >> 1)*4 + 2*edge].left;
+
+        cb = dataCb + 4*edge - 4;
+        cr = dataCr + 4*edge - 4;
+        LoadColumnsSse2(cb, cr, width, pix);
+        FilterChromaPixelsSse2(pix, bsLanes,
+            thresholds + (edge ? INNER : LEFT));
+        StoreColumnsSse2(cb, cr, width, pix);
+    }
+
+    for (edge = 0; edge < 2; edge++)
+    {
+        if (!(bS[8*edge].top | bS[8*edge+1].top | bS[8*edge+2].top |
+              bS[8*edge+3].top))
+            continue;
+
+        for (i = 0; i < 16; i++)
+            bsLanes[i] = (u8)bS[8*edge + ((i & 7) >> 1)].top;
+
+        cb = dataCb + 4*edge*width;
+        cr = dataCr + 4*edge*width;
+        for (i = 2; i < 6; i++)
+        {
+            pix[i] = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((__m128i*)(cb + ((i32)i-4)*(i32)width)),
+                _mm_loadl_epi64((__m128i*)(cr + ((i32)i-4)*(i32)width)));
+        }
+
+        FilterChromaPixelsSse2(pix, bsLanes,
+            thresholds + (edge ? INNER : TOP));
+
+        for (i = 3; i < 5; i++)
+        {
+            _mm_storel_epi64((__m128i*)(cb + ((i32)i-4)*(i32)width), pix[i]);
+            _mm_storel_epi64((__m128i*)(cr + ((i32)i-4)*(i32)width),
+                _mm_unpackhi_epi64(pix[i], pix[i]));
+        }
+    }
+
+}
+#endif /* H264DEC_SSE2 */
+
 #else /* H264DEC_OMXDL */
 
 /*------------------------------------------------------------------------------
 
-    Function: h264bsdFilterPicture
+    Function: h264bsdFilterRows
 
         Functional description:
-          Perform deblocking filtering for a picture. Filter does not copy
-          the original picture anywhere but filtering is performed directly
-          on the original image. Parameters controlling the filtering process
-          are computed based on information in macroblock structures of the
-          filtered macroblock, macroblock above and macroblock on the left of
-          the filtered one.
+          Perform deblocking filtering for a range of macroblock rows of a
+          picture. Filter does not copy the original picture anywhere but
+          filtering is performed directly on the original image. Parameters
+          controlling the filtering process are computed based on
+          information in macroblock structures of the filtered macroblock,
+          macroblock above and macroblock on the left of the filtered one.
+
+          Rows have to be filtered in order, i.e. row above firstRow shall
+          already be filtered. Filtering of a row modifies the row and three
+          bottom pixel rows of the row above.
 
         Inputs:
           image         pointer to image to be filtered
           mb            pointer to macroblock data structure of the top-left
                         macroblock of the picture
+          firstRow      first macroblock row to be filtered
+          numRows       number of macroblock rows to be filtered
 
         Outputs:
           image         filtered image stored here
@@ -1763,9 +2354,11 @@ void FilterChroma(
 ------------------------------------------------------------------------------*/
 
 /*lint --e{550} Symbol not accessed */
-void h264bsdFilterPicture(
+void h264bsdFilterRows(
   image_t *image,
-  mbStorage_t *mb)
+  mbStorage_t *mb,
+  u32 firstRow,
+  u32 numRows)
 {
 
 /* Variables */
@@ -1789,14 +2382,15 @@ void h264bsdFilterPicture(
     ASSERT(image->data);
     ASSERT(image->width);
     ASSERT(image->height);
+    ASSERT(firstRow + numRows <= image->height);
 
     picWidthInMbs = image->width;
     data = image->data;
     picSizeInMbs = picWidthInMbs * image->height;
 
-    pMb = mb;
+    pMb = mb + firstRow * picWidthInMbs;
 
-    for (mbRow = 0, mbCol = 0; mbRow < image->height; pMb++)
+    for (mbRow = firstRow, mbCol = 0; mbRow < firstRow + numRows; pMb++)
     {
         flags = GetMbFilteringFlags(pMb);
 
@@ -2413,5 +3007,38 @@ void GetChromaEdgeThresholds(
 
 #endif /* H264DEC_OMXDL */
 
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFilterPicture
+
+        Functional description:
+          Perform deblocking filtering for a picture, see h264bsdFilterRows.
+
+        Inputs:
+          image         pointer to image to be filtered
+          mb            pointer to macroblock data structure of the top-left
+                        macroblock of the picture
+
+        Outputs:
+          image         filtered image stored here
+
+        Returns:
+          none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdFilterPicture(
+  image_t *image,
+  mbStorage_t *mb)
+{
+
+/* Code */
+
+    ASSERT(image);
+
+    h264bsdFilterRows(image, mb, 0, image->height);
+
+}
+
 /*lint +e701 +e702 */
 
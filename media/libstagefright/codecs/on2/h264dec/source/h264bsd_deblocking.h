@@ -52,5 +52,11 @@ void h264bsdFilterPicture(
   image_t *image,
   mbStorage_t *mb);
 
+void h264bsdFilterRows(
+  image_t *image,
+  mbStorage_t *mb,
+  u32 firstRow,
+  u32 numRows);
+
 #endif /* #ifdef H264SWDEC_DEBLOCKING_H */
 
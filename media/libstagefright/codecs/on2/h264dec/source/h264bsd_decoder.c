@@ -24,6 +24,7 @@
      4. Local function prototypes
      5. Functions
           h264bsdInit
+          h264bsdSetNumThreads
           h264bsdDecode
           h264bsdShutdown
           h264bsdCurrentImage
@@ -54,6 +55,7 @@
 #include "h264bsd_dpb.h"
 #include "h264bsd_deblocking.h"
 #include "h264bsd_conceal.h"
+#include "h264bsd_filter_thread.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -95,6 +97,10 @@ u32 h264bsdInit(storage_t *pStorage, u32 noOutputReordering)
 
     ASSERT(pStorage);
 
+#ifdef H264DEC_SSE2
+    h264bsdInitCpuFeatures();
+#endif /* H264DEC_SSE2 */
+
     h264bsdInitStorage(pStorage);
 
     /* allocate mbLayer to be next multiple of 64 to enable use of
@@ -111,6 +117,67 @@ u32 h264bsdInit(storage_t *pStorage, u32 noOutputReordering)
     return HANTRO_OK;
 }
 
+/*------------------------------------------------------------------------------
+
+    Function name: h264bsdSetNumThreads
+
+        Functional description:
+            Set number of threads used for decoding. With more than one
+            thread deblocking filtering of a picture is performed by a
+            separate thread, in parallel with decoding of the macroblock
+            rows below the filtered ones. Output is identical to single
+            threaded decoding except for pictures containing errors that
+            are concealed. Shall not be called while a picture is being
+            decoded.
+
+        Inputs:
+            pStorage            pointer to storage structure
+            numThreads          number of threads, 0 and 1 both mean that
+                                no additional threads are used
+
+        Outputs:
+            pStorage            filter thread created or destroyed
+
+        Returns:
+            HANTRO_OK           success
+            HANTRO_NOK          picture being decoded or failed to create
+                                the thread
+            MEMORY_ALLOCATION_ERROR
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdSetNumThreads(storage_t *pStorage, u32 numThreads)
+{
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    if (pStorage->picStarted)
+        return(HANTRO_NOK);
+
+    if (numThreads > 1 && pStorage->filterThread == NULL)
+    {
+        ALLOCATE(pStorage->filterThread, 1, filterThread_t);
+        if (pStorage->filterThread == NULL)
+            return(MEMORY_ALLOCATION_ERROR);
+
+        if (h264bsdInitFilterThread(pStorage->filterThread) != HANTRO_OK)
+        {
+            FREE(pStorage->filterThread);
+            return(HANTRO_NOK);
+        }
+    }
+    else if (numThreads <= 1 && pStorage->filterThread != NULL)
+    {
+        h264bsdShutdownFilterThread(pStorage->filterThread);
+        FREE(pStorage->filterThread);
+    }
+
+    return(HANTRO_OK);
+
+}
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdDecode
@@ -242,12 +309,21 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
             {
                 pStorage->currImage->data =
                     h264bsdAllocateDpbImage(pStorage->dpb);
+                if (pStorage->filterThread)
+                    h264bsdFilterThreadStartPicture(pStorage->filterThread,
+                        pStorage->currImage, pStorage->mb);
                 h264bsdInitRefPicList(pStorage->dpb);
                 tmp = h264bsdConceal(pStorage, pStorage->currImage, P_SLICE);
             }
             else
+            {
+                /* concealment shall not modify rows being filtered */
+                if (pStorage->filterThread)
+                    (void)h264bsdFilterThreadFinishPicture(
+                        pStorage->filterThread);
                 tmp = h264bsdConceal(pStorage, pStorage->currImage,
                     pStorage->sliceHeader->sliceType);
+            }
 
             picReady = HANTRO_TRUE;
 
@@ -420,6 +496,10 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     }
                     pStorage->currImage->data =
                         h264bsdAllocateDpbImage(pStorage->dpb);
+                    if (pStorage->filterThread)
+                        h264bsdFilterThreadStartPicture(
+                            pStorage->filterThread, pStorage->currImage,
+                            pStorage->mb);
                 }
 
                 /* store slice header to storage if successfully decoded */
@@ -450,6 +530,8 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     EPRINT("SLICE_DATA");
                     h264bsdMarkSliceCorrupted(pStorage,
                         pStorage->sliceHeader->firstMbInSlice);
+                    if (pStorage->filterThread)
+                        h264bsdFilterThreadStall(pStorage->filterThread);
                     return(H264BSD_ERROR);
                 }
 
@@ -471,7 +553,15 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
 
     if (picReady)
     {
-        h264bsdFilterPicture(pStorage->currImage, pStorage->mb);
+        if (pStorage->filterThread)
+        {
+            /* filter rows the thread did not get to */
+            tmp = h264bsdFilterThreadFinishPicture(pStorage->filterThread);
+            h264bsdFilterRows(pStorage->currImage, pStorage->mb, tmp,
+                pStorage->currImage->height - tmp);
+        }
+        else
+            h264bsdFilterPicture(pStorage->currImage, pStorage->mb);
 
         h264bsdResetStorage(pStorage);
 
@@ -563,6 +653,12 @@ void h264bsdShutdown(storage_t *pStorage)
         }
     }
 
+    if (pStorage->filterThread)
+    {
+        h264bsdShutdownFilterThread(pStorage->filterThread);
+        FREE(pStorage->filterThread);
+    }
+
     FREE(pStorage->mbLayer);
     FREE(pStorage->mb);
     FREE(pStorage->sliceGroupMap);
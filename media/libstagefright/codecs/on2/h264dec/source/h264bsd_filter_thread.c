@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+     1. Include headers
+     2. External compiler flags
+     3. Module defines
+     4. Local function prototypes
+     5. Functions
+          h264bsdInitFilterThread
+          h264bsdShutdownFilterThread
+          h264bsdFilterThreadStartPicture
+          h264bsdFilterThreadMbDecoded
+          h264bsdFilterThreadStall
+          h264bsdFilterThreadFinishPicture
+          FilterThreadLoop
+          WaitRowsFiltered
+
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include "h264bsd_filter_thread.h"
+#include "h264bsd_deblocking.h"
+#include "h264bsd_util.h"
+
+/*------------------------------------------------------------------------------
+    2. External compiler flags
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+    3. Module defines
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    4. Local function prototypes
+------------------------------------------------------------------------------*/
+
+static void *FilterThreadLoop(void *arg);
+static u32 WaitRowsFiltered(filterThread_t *pFilterThread);
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdInitFilterThread
+
+        Functional description:
+            Initialize filter thread structure and start the thread. No rows
+            are handed over to the thread before
+            h264bsdFilterThreadStartPicture is called.
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+
+        Outputs:
+            pFilterThread   initialized structure
+
+        Returns:
+            HANTRO_OK       success
+            HANTRO_NOK      failed to create the thread
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdInitFilterThread(filterThread_t *pFilterThread)
+{
+
+/* Code */
+
+    ASSERT(pFilterThread);
+
+    H264SwDecMemset(pFilterThread, 0, sizeof(filterThread_t));
+
+    pFilterThread->stalled = HANTRO_TRUE;
+
+    pthread_mutex_init(&pFilterThread->lock, NULL);
+    pthread_cond_init(&pFilterThread->rowsReadyCond, NULL);
+    pthread_cond_init(&pFilterThread->rowsFilteredCond, NULL);
+
+    if (pthread_create(&pFilterThread->thread, NULL, FilterThreadLoop,
+            pFilterThread) != 0)
+    {
+        pthread_cond_destroy(&pFilterThread->rowsFilteredCond);
+        pthread_cond_destroy(&pFilterThread->rowsReadyCond);
+        pthread_mutex_destroy(&pFilterThread->lock);
+        return(HANTRO_NOK);
+    }
+
+    return(HANTRO_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdShutdownFilterThread
+
+        Functional description:
+            Wait for the thread to finish rows already handed over to it and
+            stop the thread.
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdShutdownFilterThread(filterThread_t *pFilterThread)
+{
+
+/* Code */
+
+    ASSERT(pFilterThread);
+
+    pthread_mutex_lock(&pFilterThread->lock);
+    pFilterThread->quit = HANTRO_TRUE;
+    pthread_cond_signal(&pFilterThread->rowsReadyCond);
+    pthread_mutex_unlock(&pFilterThread->lock);
+
+    pthread_join(pFilterThread->thread, NULL);
+
+    pthread_cond_destroy(&pFilterThread->rowsFilteredCond);
+    pthread_cond_destroy(&pFilterThread->rowsReadyCond);
+    pthread_mutex_destroy(&pFilterThread->lock);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFilterThreadStartPicture
+
+        Functional description:
+            Start filtering of a new picture. Macroblock rows are handed
+            over to the thread as they get decoded, see
+            h264bsdFilterThreadMbDecoded.
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+            image           image to be filtered
+            mb              macroblock storage of the image
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdFilterThreadStartPicture(filterThread_t *pFilterThread,
+    image_t *image, mbStorage_t *mb)
+{
+
+/* Code */
+
+    ASSERT(pFilterThread);
+    ASSERT(image);
+    ASSERT(mb);
+
+    /* previous picture may have been abandoned without finishing it */
+    (void)WaitRowsFiltered(pFilterThread);
+
+    pthread_mutex_lock(&pFilterThread->lock);
+    pFilterThread->image = image;
+    pFilterThread->mb = mb;
+    pFilterThread->rowsReady = 0;
+    pFilterThread->rowsFiltered = 0;
+    pthread_mutex_unlock(&pFilterThread->lock);
+
+    pFilterThread->nextMbAddr = 0;
+    pFilterThread->stalled = HANTRO_FALSE;
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFilterThreadMbDecoded
+
+        Functional description:
+            Inform the filter thread that a macroblock of the current
+            picture has been decoded for the first time. Rows are only handed
+            over as long as macroblocks are decoded in raster scan order,
+            pictures using arbitrary slice order or slice groups other than
+            raster scan are filtered by h264bsdFilterRows after
+            h264bsdFilterThreadFinishPicture.
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+            mbAddr          address of the decoded macroblock
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdFilterThreadMbDecoded(filterThread_t *pFilterThread, u32 mbAddr)
+{
+
+/* Variables */
+
+    u32 picWidthInMbs;
+
+/* Code */
+
+    ASSERT(pFilterThread);
+
+    if (pFilterThread->stalled)
+        return;
+
+    if (mbAddr != pFilterThread->nextMbAddr)
+    {
+        pFilterThread->stalled = HANTRO_TRUE;
+        return;
+    }
+
+    pFilterThread->nextMbAddr++;
+
+    picWidthInMbs = pFilterThread->image->width;
+
+    /* row above the last completed row can be filtered now */
+    if ((pFilterThread->nextMbAddr % picWidthInMbs) == 0 &&
+        pFilterThread->nextMbAddr >= 2 * picWidthInMbs)
+    {
+        pthread_mutex_lock(&pFilterThread->lock);
+        pFilterThread->rowsReady =
+            pFilterThread->nextMbAddr / picWidthInMbs - 1;
+        pthread_cond_signal(&pFilterThread->rowsReadyCond);
+        pthread_mutex_unlock(&pFilterThread->lock);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFilterThreadStall
+
+        Functional description:
+            Stop handing over rows of the current picture, used when decoded
+            macroblocks may still be concealed (e.g. corrupted slice).
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdFilterThreadStall(filterThread_t *pFilterThread)
+{
+
+/* Code */
+
+    ASSERT(pFilterThread);
+
+    pFilterThread->stalled = HANTRO_TRUE;
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFilterThreadFinishPicture
+
+        Functional description:
+            Stop handing over rows of the current picture and wait for the
+            thread to filter the rows it already got. The caller is
+            responsible for filtering the remaining rows. May be called more
+            than once for a picture.
+
+        Inputs:
+            pFilterThread   pointer to filter thread structure
+
+        Outputs:
+            none
+
+        Returns:
+            number of macroblock rows filtered by the thread
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdFilterThreadFinishPicture(filterThread_t *pFilterThread)
+{
+
+/* Code */
+
+    ASSERT(pFilterThread);
+
+    pFilterThread->stalled = HANTRO_TRUE;
+
+    return(WaitRowsFiltered(pFilterThread));
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: WaitRowsFiltered
+
+        Functional description:
+            Wait until the thread has filtered all rows handed over to it.
+            Returns number of filtered rows.
+
+------------------------------------------------------------------------------*/
+
+u32 WaitRowsFiltered(filterThread_t *pFilterThread)
+{
+
+/* Variables */
+
+    u32 rowsFiltered;
+
+/* Code */
+
+    pthread_mutex_lock(&pFilterThread->lock);
+    while (pFilterThread->rowsFiltered < pFilterThread->rowsReady)
+    {
+        pthread_cond_wait(&pFilterThread->rowsFilteredCond,
+            &pFilterThread->lock);
+    }
+    rowsFiltered = pFilterThread->rowsFiltered;
+    pthread_mutex_unlock(&pFilterThread->lock);
+
+    return(rowsFiltered);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterThreadLoop
+
+        Functional description:
+            Main loop of the filter thread. Filters all rows that are ready
+            at once, the lock is not held while filtering.
+
+------------------------------------------------------------------------------*/
+
+void *FilterThreadLoop(void *arg)
+{
+
+/* Variables */
+
+    filterThread_t *pFilterThread = (filterThread_t *)arg;
+    u32 firstRow, numRows;
+
+/* Code */
+
+    pthread_mutex_lock(&pFilterThread->lock);
+    while (!pFilterThread->quit)
+    {
+        if (pFilterThread->rowsFiltered == pFilterThread->rowsReady)
+        {
+            pthread_cond_wait(&pFilterThread->rowsReadyCond,
+                &pFilterThread->lock);
+            continue;
+        }
+
+        firstRow = pFilterThread->rowsFiltered;
+        numRows = pFilterThread->rowsReady - firstRow;
+
+        pthread_mutex_unlock(&pFilterThread->lock);
+        h264bsdFilterRows(pFilterThread->image, pFilterThread->mb,
+            firstRow, numRows);
+        pthread_mutex_lock(&pFilterThread->lock);
+
+        pFilterThread->rowsFiltered = firstRow + numRows;
+        pthread_cond_signal(&pFilterThread->rowsFilteredCond);
+    }
+    pthread_mutex_unlock(&pFilterThread->lock);
+
+    return NULL;
+
+}
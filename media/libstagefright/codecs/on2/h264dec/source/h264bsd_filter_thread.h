@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+    1. Include headers
+    2. Module defines
+    3. Data types
+    4. Function prototypes
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDEC_FILTER_THREAD_H
+#define H264SWDEC_FILTER_THREAD_H
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+
+#include "basetype.h"
+#include "h264bsd_image.h"
+#include "h264bsd_macroblock_layer.h"
+
+/*------------------------------------------------------------------------------
+    2. Module defines
+------------------------------------------------------------------------------*/
+
+/* maximum number of threads the application may request, decoding itself
+ * and deblocking filtering are currently the only stages run in parallel */
+#define MAX_NUM_DECODER_THREADS 2
+
+/*------------------------------------------------------------------------------
+    3. Data types
+------------------------------------------------------------------------------*/
+
+/* Deblocking filter thread. Filters macroblock rows of the current picture
+ * while the rest of the picture is still being decoded. Row n is handed
+ * over to the thread after row n+1 has been completely decoded, because
+ * intra prediction of row n+1 uses unfiltered pixels of row n. */
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    /* signalled when more rows are ready or the thread shall exit */
+    pthread_cond_t rowsReadyCond;
+    /* signalled when the thread has filtered all ready rows */
+    pthread_cond_t rowsFilteredCond;
+
+    /* current picture, protected by lock */
+    image_t *image;
+    mbStorage_t *mb;
+    u32 rowsReady;
+    u32 rowsFiltered;
+    u32 quit;
+
+    /* only accessed by the decoding thread: address of the next macroblock
+     * expected in raster scan order and a flag to indicate that no more
+     * rows shall be handed over for the current picture */
+    u32 nextMbAddr;
+    u32 stalled;
+} filterThread_t;
+
+/*------------------------------------------------------------------------------
+    4. Function prototypes
+------------------------------------------------------------------------------*/
+
+u32 h264bsdInitFilterThread(filterThread_t *pFilterThread);
+void h264bsdShutdownFilterThread(filterThread_t *pFilterThread);
+
+void h264bsdFilterThreadStartPicture(filterThread_t *pFilterThread,
+    image_t *image, mbStorage_t *mb);
+void h264bsdFilterThreadMbDecoded(filterThread_t *pFilterThread,
+    u32 mbAddr);
+void h264bsdFilterThreadStall(filterThread_t *pFilterThread);
+u32 h264bsdFilterThreadFinishPicture(filterThread_t *pFilterThread);
+
+#endif /* #ifdef H264SWDEC_FILTER_THREAD_H */
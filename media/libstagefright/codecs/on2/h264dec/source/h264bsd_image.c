@@ -25,6 +25,7 @@
      5. Functions
           h264bsdWriteMacroblock
           h264bsdWriteOutputBlocks
+          AddResidualSse2
 
 ------------------------------------------------------------------------------*/
 
@@ -36,6 +37,10 @@
 #include "h264bsd_util.h"
 #include "h264bsd_neighbour.h"
 
+#ifdef H264DEC_SSE2
+#include <emmintrin.h>
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     2. External compiler flags
 --------------------------------------------------------------------------------
@@ -55,6 +60,11 @@ extern const u8 h264bsdClip[];
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#if defined(H264DEC_SSE2) && !defined(H264DEC_OMXDL)
+static void AddResidualSse2(u8 *pred, u32 predWidth, u8 *out, u32 outWidth,
+    i32 *residual);
+#endif
+
 
 
 /*------------------------------------------------------------------------------
@@ -242,6 +252,14 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
 
             RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
 
+#ifdef H264DEC_SSE2
+            if (h264bsdCpuHasSse2)
+            {
+                AddResidualSse2(tmp, 16, imageBlock, picWidth, pRes);
+                continue;
+            }
+#endif /* H264DEC_SSE2 */
+
             /* Calculate image = prediction + residual
              * Process four pixels in a loop */
             for (i = 4; i; i--)
@@ -316,6 +334,14 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
 
             RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
 
+#ifdef H264DEC_SSE2
+            if (h264bsdCpuHasSse2)
+            {
+                AddResidualSse2(tmp, 8, imageBlock, picWidth, pRes);
+                continue;
+            }
+#endif /* H264DEC_SSE2 */
+
             for (i = 4; i; i--)
             {
                 tmp1 = tmp[0];
@@ -341,5 +367,56 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
     }
 
 }
+
+#ifdef H264DEC_SSE2
+/*------------------------------------------------------------------------------
+
+    Function: AddResidualSse2
+
+        Functional description:
+            Add residual to a 4x4 block of prediction and write the result
+            into the image, two rows at a time. Saturating packs clip the
+            result exactly like the clipping table.
+
+------------------------------------------------------------------------------*/
+
+void AddResidualSse2(u8 *pred, u32 predWidth, u8 *out, u32 outWidth,
+    i32 *residual)
+{
+
+/* Variables */
+
+    u32 i;
+    __m128i zero = _mm_setzero_si128();
+    __m128i res, p;
+
+/* Code */
+
+    ASSERT(pred);
+    ASSERT(out);
+    ASSERT(residual);
+
+    for (i = 2; i; i--)
+    {
+        res = _mm_packs_epi32(
+            _mm_loadu_si128((__m128i*)residual),
+            _mm_loadu_si128((__m128i*)(residual + 4)));
+        p = _mm_unpacklo_epi32(
+            _mm_cvtsi32_si128(*(i32*)pred),
+            _mm_cvtsi32_si128(*(i32*)(pred + predWidth)));
+        p = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), res);
+        p = _mm_packus_epi16(p, p);
+
+        *(i32*)out = _mm_cvtsi128_si32(p);
+        *(i32*)(out + outWidth) = _mm_cvtsi128_si32(_mm_srli_si128(p, 4));
+
+        residual += 8;
+        pred += 2*predWidth;
+        out += 2*outWidth;
+    }
+
+}
+#endif /* H264DEC_SSE2 */
+
 #endif /* H264DEC_OMXDL */
 
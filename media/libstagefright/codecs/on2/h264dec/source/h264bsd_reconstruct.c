@@ -42,6 +42,10 @@
 #include "armVC.h"
 #endif /* H264DEC_OMXDL */
 
+#ifdef H264DEC_SSE2
+#include <emmintrin.h>
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     2. External compiler flags
 --------------------------------------------------------------------------------
@@ -80,6 +84,14 @@ extern const u8 h264bsdClip[];
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#if defined(H264DEC_SSE2) && !defined(H264DEC_OMXDL)
+static void PredictLumaSse2(u8 *ref, u8 *mb, i32 xInt, i32 yInt, u32 width,
+    u32 height, u32 partWidth, u32 partHeight, u32 xFrac, u32 yFrac);
+static void PredictChromaSse2(u8 *ref, u8 *predPartChroma, i32 x0, i32 y0,
+    u32 width, u32 height, u32 xFrac, u32 yFrac, u32 chromaPartWidth,
+    u32 chromaPartHeight);
+#endif
+
 #ifndef H264DEC_OMXDL
 
 /*------------------------------------------------------------------------------
@@ -447,6 +459,15 @@ static void PredictChroma(
     chromaPartHeight = partHeight >> 1;
     ref = refPic->data + 256 * refPic->width * refPic->height;
 
+#ifdef H264DEC_SSE2
+    if (h264bsdCpuHasSse2 && (xFrac || yFrac))
+    {
+        PredictChromaSse2(ref, mbPartChroma, xInt, yInt, width, height,
+            xFrac, yFrac, chromaPartWidth, chromaPartHeight);
+        return;
+    }
+#endif /* H264DEC_SSE2 */
+
     if (xFrac && yFrac)
     {
         h264bsdInterpolateChromaHorVer(ref, mbPartChroma, xInt, yInt, width,
@@ -1789,6 +1810,497 @@ void h264bsdInterpolateMidHorQuarter(
 }
 
 
+#ifdef H264DEC_SSE2
+/*------------------------------------------------------------------------------
+
+    Function: LoadRowSse2
+
+        Functional description:
+          Load a row of 4, 8 or 16 pixels into the lowest bytes of an SSE2
+          register. Rows narrower than 8 pixels are read 8 bytes wide, the
+          extra bytes are ignored by the caller.
+
+------------------------------------------------------------------------------*/
+
+static __m128i LoadRowSse2(const u8 *ptr, u32 width)
+{
+    if (width == 16)
+        return _mm_loadu_si128((const __m128i*)ptr);
+    else
+        return _mm_loadl_epi64((const __m128i*)ptr);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: StoreRowSse2
+
+        Functional description:
+          Store the lowest 2, 4, 8 or 16 pixels of an SSE2 register.
+
+------------------------------------------------------------------------------*/
+
+static void StoreRowSse2(u8 *ptr, __m128i pixels, u32 width)
+{
+    if (width == 16)
+        _mm_storeu_si128((__m128i*)ptr, pixels);
+    else if (width == 8)
+        _mm_storel_epi64((__m128i*)ptr, pixels);
+    else if (width == 4)
+        *(i32*)ptr = _mm_cvtsi128_si32(pixels);
+    else
+        *(u16*)ptr = (u16)_mm_cvtsi128_si32(pixels);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: SixTapSse2
+
+        Functional description:
+          Apply the 6-tap filter (1,-5,20,20,-5,1) to eight 16-bit lanes, no
+          rounding or scaling. Result fits in 16 bits when the inputs are
+          8-bit samples.
+
+------------------------------------------------------------------------------*/
+
+static __m128i SixTapSse2(__m128i a, __m128i b, __m128i c, __m128i d,
+    __m128i e, __m128i f)
+{
+    __m128i tmp;
+
+    tmp = _mm_mullo_epi16(_mm_add_epi16(c, d), _mm_set1_epi16(20));
+    tmp = _mm_sub_epi16(tmp,
+        _mm_mullo_epi16(_mm_add_epi16(b, e), _mm_set1_epi16(5)));
+    return _mm_add_epi16(tmp, _mm_add_epi16(a, f));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: HorTapsSse2
+
+        Functional description:
+          Unscaled horizontal 6-tap filter for eight horizontally adjacent
+          pixels, ref points two pixels left of the first one. Reads 16
+          bytes starting at ref.
+
+------------------------------------------------------------------------------*/
+
+static __m128i HorTapsSse2(const u8 *ref)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i row = _mm_loadu_si128((const __m128i*)ref);
+
+    return SixTapSse2(
+        _mm_unpacklo_epi8(row, zero),
+        _mm_unpacklo_epi8(_mm_srli_si128(row, 1), zero),
+        _mm_unpacklo_epi8(_mm_srli_si128(row, 2), zero),
+        _mm_unpacklo_epi8(_mm_srli_si128(row, 3), zero),
+        _mm_unpacklo_epi8(_mm_srli_si128(row, 4), zero),
+        _mm_unpacklo_epi8(_mm_srli_si128(row, 5), zero));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: InterpolateHorHalfSse2
+
+        Functional description:
+          SSE2 interpolation of pixel position 'b' for a block, the block is
+          processed in columns of (at most) 8 pixels. ref points two pixels
+          left of the top-left pixel of the block and has to contain enough
+          pixels for reading 16 bytes per column.
+
+------------------------------------------------------------------------------*/
+
+static void InterpolateHorHalfSse2(
+  const u8 *ref,
+  u32 refWidth,
+  u8 *mb,
+  u32 partWidth,
+  u32 partHeight)
+{
+    u32 x, y;
+    u32 colWidth = MIN(partWidth, 8);
+    __m128i tmp;
+
+    for (x = 0; x < partWidth; x += 8)
+    {
+        for (y = 0; y < partHeight; y++)
+        {
+            tmp = HorTapsSse2(ref + y*refWidth + x);
+            tmp = _mm_srai_epi16(_mm_add_epi16(tmp, _mm_set1_epi16(16)), 5);
+            StoreRowSse2(mb + y*16 + x, _mm_packus_epi16(tmp, tmp), colWidth);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: InterpolateVerHalfSse2
+
+        Functional description:
+          SSE2 interpolation of pixel position 'h' for a block. ref points
+          two rows above the top-left pixel of the block, 8 bytes are read
+          per row and column.
+
+------------------------------------------------------------------------------*/
+
+static void InterpolateVerHalfSse2(
+  const u8 *ref,
+  u32 refWidth,
+  u8 *mb,
+  u32 partWidth,
+  u32 partHeight)
+{
+    u32 x, y;
+    u32 colWidth = MIN(partWidth, 8);
+    const u8 *ptr;
+    __m128i zero = _mm_setzero_si128();
+    __m128i r0, r1, r2, r3, r4, r5, tmp;
+
+    for (x = 0; x < partWidth; x += 8)
+    {
+        ptr = ref + x;
+        r0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), zero);
+        ptr += refWidth;
+        r1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), zero);
+        ptr += refWidth;
+        r2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), zero);
+        ptr += refWidth;
+        r3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), zero);
+        ptr += refWidth;
+        r4 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), zero);
+        ptr += refWidth;
+
+        for (y = 0; y < partHeight; y++)
+        {
+            r5 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr),
+                zero);
+            ptr += refWidth;
+
+            tmp = SixTapSse2(r0, r1, r2, r3, r4, r5);
+            tmp = _mm_srai_epi16(_mm_add_epi16(tmp, _mm_set1_epi16(16)), 5);
+            StoreRowSse2(mb + y*16 + x, _mm_packus_epi16(tmp, tmp), colWidth);
+
+            r0 = r1; r1 = r2; r2 = r3; r3 = r4; r4 = r5;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: InterpolateMidHalfSse2
+
+        Functional description:
+          SSE2 interpolation of pixel position 'j' for a block. Unscaled
+          horizontal filter results are filtered vertically using 32-bit
+          intermediates. ref points two rows above and two pixels left of
+          the top-left pixel of the block.
+
+------------------------------------------------------------------------------*/
+
+static void InterpolateMidHalfSse2(
+  const u8 *ref,
+  u32 refWidth,
+  u8 *mb,
+  u32 partWidth,
+  u32 partHeight)
+{
+    u32 x, y;
+    u32 colWidth = MIN(partWidth, 8);
+    __m128i hor[16+5];
+    __m128i coeff1 = _mm_set1_epi16(1);
+    __m128i coeff5 = _mm_set1_epi16(-5);
+    __m128i coeff20 = _mm_set1_epi16(20);
+    __m128i round = _mm_set1_epi32(512);
+    __m128i lo, hi, tmp;
+
+    for (x = 0; x < partWidth; x += 8)
+    {
+        for (y = 0; y < partHeight + 5; y++)
+            hor[y] = HorTapsSse2(ref + y*refWidth + x);
+
+        for (y = 0; y < partHeight; y++)
+        {
+            lo = _mm_madd_epi16(_mm_unpacklo_epi16(hor[y], hor[y+5]), coeff1);
+            hi = _mm_madd_epi16(_mm_unpackhi_epi16(hor[y], hor[y+5]), coeff1);
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(
+                _mm_unpacklo_epi16(hor[y+1], hor[y+4]), coeff5));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(
+                _mm_unpackhi_epi16(hor[y+1], hor[y+4]), coeff5));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(
+                _mm_unpacklo_epi16(hor[y+2], hor[y+3]), coeff20));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(
+                _mm_unpackhi_epi16(hor[y+2], hor[y+3]), coeff20));
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 10);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 10);
+            tmp = _mm_packs_epi32(lo, hi);
+            StoreRowSse2(mb + y*16 + x, _mm_packus_epi16(tmp, tmp), colWidth);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: AverageSse2
+
+        Functional description:
+          Compute quarter sample positions as rounded average of two
+          predictions, the second one is in a temporary block with line
+          length of 16.
+
+------------------------------------------------------------------------------*/
+
+static void AverageSse2(
+  u8 *mb,
+  const u8 *pred1,
+  u32 pred1Width,
+  const u8 *pred2,
+  u32 partWidth,
+  u32 partHeight)
+{
+    u32 y;
+
+    for (y = partHeight; y; y--)
+    {
+        StoreRowSse2(mb, _mm_avg_epu8(LoadRowSse2(pred1, partWidth),
+            LoadRowSse2(pred2, partWidth)), partWidth);
+        mb += 16;
+        pred1 += pred1Width;
+        pred2 += 16;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PredictLumaSse2
+
+        Functional description:
+          SSE2 luma interpolation for all fractional sample positions. Half
+          sample positions b, h and j are interpolated with the 6-tap filter
+          and quarter sample positions are averages of two half or integer
+          sample positions, exactly as in the C implementation. The
+          reference block is read directly from the reference picture when
+          it is completely inside the picture (including the pixels read by
+          the 16-byte loads), otherwise it is first copied with overfilling.
+
+------------------------------------------------------------------------------*/
+
+static void PredictLumaSse2(
+  u8 *ref,
+  u8 *mb,
+  i32 xInt,
+  i32 yInt,
+  u32 width,
+  u32 height,
+  u32 partWidth,
+  u32 partHeight,
+  u32 xFrac,
+  u32 yFrac)
+{
+
+/* Variables */
+
+    u32 fill[(16+5)*32/4];
+    u32 block[16*16/4];
+    u8 *tmp = (u8*)block;
+    u8 *full;
+    i32 x0, y0;
+
+/* Code */
+
+    ASSERT(partWidth == 4 || partWidth == 8 || partWidth == 16);
+
+    x0 = xInt - 2;
+    y0 = yInt - 2;
+
+    if (x0 < 0 || y0 < 0 ||
+        (u32)x0 + MAX(partWidth, 8) + 8 > width ||
+        (u32)y0 + partHeight + 5 > height)
+    {
+        h264bsdFillBlock(ref, (u8*)fill, x0, y0, width, height,
+            partWidth + 5, partHeight + 5, 32);
+        ref = (u8*)fill;
+        width = 32;
+    }
+    else
+        ref += y0 * (i32)width + x0;
+
+    /* integer sample position G */
+    full = ref + 2*width + 2;
+
+    switch (lumaFracPos[xFrac][yFrac])
+    {
+        case 1: /* d */
+            InterpolateVerHalfSse2(ref + 2, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, full, width, tmp, partWidth, partHeight);
+            break;
+        case 2: /* h */
+            InterpolateVerHalfSse2(ref + 2, width, mb, partWidth, partHeight);
+            break;
+        case 3: /* n */
+            InterpolateVerHalfSse2(ref + 2, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, full + width, width, tmp, partWidth, partHeight);
+            break;
+        case 4: /* a */
+            InterpolateHorHalfSse2(ref + 2*width, width, tmp, partWidth,
+                partHeight);
+            AverageSse2(mb, full, width, tmp, partWidth, partHeight);
+            break;
+        case 5: /* e */
+            InterpolateHorHalfSse2(ref + 2*width, width, mb, partWidth,
+                partHeight);
+            InterpolateVerHalfSse2(ref + 2, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 6: /* i */
+            InterpolateVerHalfSse2(ref + 2, width, mb, partWidth, partHeight);
+            InterpolateMidHalfSse2(ref, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 7: /* p */
+            InterpolateVerHalfSse2(ref + 2, width, mb, partWidth, partHeight);
+            InterpolateHorHalfSse2(ref + 3*width, width, tmp, partWidth,
+                partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 8: /* b */
+            InterpolateHorHalfSse2(ref + 2*width, width, mb, partWidth,
+                partHeight);
+            break;
+        case 9: /* f */
+            InterpolateHorHalfSse2(ref + 2*width, width, mb, partWidth,
+                partHeight);
+            InterpolateMidHalfSse2(ref, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 10: /* j */
+            InterpolateMidHalfSse2(ref, width, mb, partWidth, partHeight);
+            break;
+        case 11: /* q */
+            InterpolateHorHalfSse2(ref + 3*width, width, mb, partWidth,
+                partHeight);
+            InterpolateMidHalfSse2(ref, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 12: /* c */
+            InterpolateHorHalfSse2(ref + 2*width, width, tmp, partWidth,
+                partHeight);
+            AverageSse2(mb, full + 1, width, tmp, partWidth, partHeight);
+            break;
+        case 13: /* g */
+            InterpolateHorHalfSse2(ref + 2*width, width, mb, partWidth,
+                partHeight);
+            InterpolateVerHalfSse2(ref + 3, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 14: /* k */
+            InterpolateVerHalfSse2(ref + 3, width, mb, partWidth, partHeight);
+            InterpolateMidHalfSse2(ref, width, tmp, partWidth, partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        case 15: /* r */
+            InterpolateVerHalfSse2(ref + 3, width, mb, partWidth, partHeight);
+            InterpolateHorHalfSse2(ref + 3*width, width, tmp, partWidth,
+                partHeight);
+            AverageSse2(mb, mb, 16, tmp, partWidth, partHeight);
+            break;
+        default: /* case 0, G */
+            AverageSse2(mb, full, width, full, partWidth, partHeight);
+            break;
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PredictChromaSse2
+
+        Functional description:
+          SSE2 chroma interpolation for both chroma components, all
+          fractional positions are handled with the same bilinear filter.
+          Reference blocks that are not completely inside the picture
+          (including the pixels read by the 8-byte loads) are first copied
+          with overfilling.
+
+------------------------------------------------------------------------------*/
+
+static void PredictChromaSse2(
+  u8 *ref,
+  u8 *predPartChroma,
+  i32 x0,
+  i32 y0,
+  u32 width,
+  u32 height,
+  u32 xFrac,
+  u32 yFrac,
+  u32 chromaPartWidth,
+  u32 chromaPartHeight)
+{
+
+/* Variables */
+
+    u32 fill[(8+1)*16/4];
+    u32 comp, y;
+    u32 refWidth;
+    u8 *ptr, *out;
+    __m128i zero = _mm_setzero_si128();
+    __m128i coeffA, coeffB, coeffC, coeffD;
+    __m128i a, b, c, d, tmp;
+
+/* Code */
+
+    ASSERT(xFrac < 8 && yFrac < 8);
+
+    coeffA = _mm_set1_epi16((i16)((8 - xFrac) * (8 - yFrac)));
+    coeffB = _mm_set1_epi16((i16)(xFrac * (8 - yFrac)));
+    coeffC = _mm_set1_epi16((i16)((8 - xFrac) * yFrac));
+    coeffD = _mm_set1_epi16((i16)(xFrac * yFrac));
+
+    for (comp = 0; comp < 2; comp++)
+    {
+        if (x0 < 0 || y0 < 0 ||
+            (u32)x0 + 8 + 1 > width ||
+            (u32)y0 + chromaPartHeight + 1 > height)
+        {
+            h264bsdFillBlock(ref, (u8*)fill, x0, y0, width, height,
+                chromaPartWidth + 1, chromaPartHeight + 1, 16);
+            ptr = (u8*)fill;
+            refWidth = 16;
+        }
+        else
+        {
+            ptr = ref + y0 * (i32)width + x0;
+            refWidth = width;
+        }
+
+        out = predPartChroma + comp*8*8;
+
+        a = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)ptr), zero);
+        b = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(ptr + 1)), zero);
+
+        for (y = chromaPartHeight; y; y--)
+        {
+            ptr += refWidth;
+            c = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)ptr), zero);
+            d = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(ptr + 1)), zero);
+
+            tmp = _mm_add_epi16(_mm_mullo_epi16(a, coeffA),
+                _mm_mullo_epi16(b, coeffB));
+            tmp = _mm_add_epi16(tmp, _mm_mullo_epi16(c, coeffC));
+            tmp = _mm_add_epi16(tmp, _mm_mullo_epi16(d, coeffD));
+            tmp = _mm_srli_epi16(_mm_add_epi16(tmp, _mm_set1_epi16(32)), 6);
+            StoreRowSse2(out, _mm_packus_epi16(tmp, tmp), chromaPartWidth);
+
+            out += 8;
+            a = c;
+            b = d;
+        }
+
+        ref += width * height;
+    }
+
+}
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdPredictSamples
@@ -1858,6 +2370,12 @@ void h264bsdPredictSamples(
 
     ASSERT(lumaFracPos[xFrac][yFrac] < 16);
 
+#ifdef H264DEC_SSE2
+    if (h264bsdCpuHasSse2 && (xFrac || yFrac))
+        PredictLumaSse2(refPic->data, lumaPartData, xInt, yInt, width, height,
+            partWidth, partHeight, xFrac, yFrac);
+    else
+#endif /* H264DEC_SSE2 */
     switch (lumaFracPos[xFrac][yFrac])
     {
         case 0: /* G */
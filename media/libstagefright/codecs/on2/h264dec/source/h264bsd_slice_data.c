@@ -36,6 +36,7 @@
 #include "h264bsd_slice_data.h"
 #include "h264bsd_util.h"
 #include "h264bsd_vlc.h"
+#include "h264bsd_filter_thread.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -193,7 +194,12 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
         /* increment macroblock count only for macroblocks that were decoded
          * for the first time (redundant slices) */
         if (pStorage->mb[currMbAddr].decoded == 1)
+        {
             mbCount++;
+            if (pStorage->filterThread)
+                h264bsdFilterThreadMbDecoded(pStorage->filterThread,
+                    currMbAddr);
+        }
 
         /* keep on processing as long as there is stream data left or
          * processing of macroblocks to be skipped based on the last skipRun is
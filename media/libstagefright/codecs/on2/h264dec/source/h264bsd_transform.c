@@ -26,6 +26,7 @@
           h264bsdProcessBlock
           h264bsdProcessLumaDc
           h264bsdProcessChromaDc
+          InverseTransformSse2
 
 ------------------------------------------------------------------------------*/
 
@@ -37,6 +38,10 @@
 #include "h264bsd_transform.h"
 #include "h264bsd_util.h"
 
+#ifdef H264DEC_SSE2
+#include <emmintrin.h>
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     2. External compiler flags
 --------------------------------------------------------------------------------
@@ -67,6 +72,10 @@ static const u8 qpDiv6[52] = {0,0,0,0,0,0,1,1,1,1,1,1,2,2,2,2,2,2,3,3,3,3,3,3,
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#ifdef H264DEC_SSE2
+static u32 InverseTransformSse2(i32 *data);
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdProcessBlock
@@ -152,6 +161,11 @@ u32 h264bsdProcessBlock(i32 *data, u32 qp, u32 skip, u32 coeffMap)
         data[10] = (d2 * tmp1);
         data[11] = (d3 * tmp2);
 
+#ifdef H264DEC_SSE2
+        if (h264bsdCpuHasSse2)
+            return(InverseTransformSse2(data));
+#endif /* H264DEC_SSE2 */
+
         /* horizontal transform */
         for (row = 4, ptr = data; row--; ptr += 4)
         {
@@ -400,3 +414,110 @@ void h264bsdProcessChromaDc(i32 *data, u32 qp)
 /*lint +e701 +e702 */
 
 
+
+#ifdef H264DEC_SSE2
+/*------------------------------------------------------------------------------
+
+    Function: InverseTransformSse2
+
+        Functional description:
+            SSE2 version of the inverse transform of h264bsdProcessBlock,
+            data is expected to be inverse scanned and scaled. The block is
+            transposed so that the horizontal transform processes all rows
+            at once, the result is bit-exact with the C implementation.
+
+        Inputs:
+            data            pointer to data to be processed
+
+        Outputs:
+            data            processed data
+
+        Returns:
+            HANTRO_OK       success
+            HANTRO_NOK      processed data not in valid range [-512, 511]
+
+------------------------------------------------------------------------------*/
+
+u32 InverseTransformSse2(i32 *data)
+{
+
+/* Variables */
+
+    __m128i row0, row1, row2, row3;
+    __m128i tmp0, tmp1, tmp2, tmp3;
+    __m128i outOfRange;
+
+/* Code */
+
+    ASSERT(data);
+
+    row0 = _mm_loadu_si128((__m128i*)(data + 0));
+    row1 = _mm_loadu_si128((__m128i*)(data + 4));
+    row2 = _mm_loadu_si128((__m128i*)(data + 8));
+    row3 = _mm_loadu_si128((__m128i*)(data + 12));
+
+    /* transpose, rowN holds coefficient N of each row after this */
+    tmp0 = _mm_unpacklo_epi32(row0, row1);
+    tmp1 = _mm_unpacklo_epi32(row2, row3);
+    tmp2 = _mm_unpackhi_epi32(row0, row1);
+    tmp3 = _mm_unpackhi_epi32(row2, row3);
+    row0 = _mm_unpacklo_epi64(tmp0, tmp1);
+    row1 = _mm_unpackhi_epi64(tmp0, tmp1);
+    row2 = _mm_unpacklo_epi64(tmp2, tmp3);
+    row3 = _mm_unpackhi_epi64(tmp2, tmp3);
+
+    /* horizontal transform */
+    tmp0 = _mm_add_epi32(row0, row2);
+    tmp1 = _mm_sub_epi32(row0, row2);
+    tmp2 = _mm_sub_epi32(_mm_srai_epi32(row1, 1), row3);
+    tmp3 = _mm_add_epi32(row1, _mm_srai_epi32(row3, 1));
+    row0 = _mm_add_epi32(tmp0, tmp3);
+    row1 = _mm_add_epi32(tmp1, tmp2);
+    row2 = _mm_sub_epi32(tmp1, tmp2);
+    row3 = _mm_sub_epi32(tmp0, tmp3);
+
+    /* transpose back */
+    tmp0 = _mm_unpacklo_epi32(row0, row1);
+    tmp1 = _mm_unpacklo_epi32(row2, row3);
+    tmp2 = _mm_unpackhi_epi32(row0, row1);
+    tmp3 = _mm_unpackhi_epi32(row2, row3);
+    row0 = _mm_unpacklo_epi64(tmp0, tmp1);
+    row1 = _mm_unpackhi_epi64(tmp0, tmp1);
+    row2 = _mm_unpacklo_epi64(tmp2, tmp3);
+    row3 = _mm_unpackhi_epi64(tmp2, tmp3);
+
+    /* vertical transform */
+    tmp0 = _mm_add_epi32(row0, row2);
+    tmp1 = _mm_sub_epi32(row0, row2);
+    tmp2 = _mm_sub_epi32(_mm_srai_epi32(row1, 1), row3);
+    tmp3 = _mm_add_epi32(row1, _mm_srai_epi32(row3, 1));
+    tmp0 = _mm_add_epi32(tmp0, _mm_set1_epi32(32));
+    tmp1 = _mm_add_epi32(tmp1, _mm_set1_epi32(32));
+    row0 = _mm_srai_epi32(_mm_add_epi32(tmp0, tmp3), 6);
+    row1 = _mm_srai_epi32(_mm_add_epi32(tmp1, tmp2), 6);
+    row2 = _mm_srai_epi32(_mm_sub_epi32(tmp1, tmp2), 6);
+    row3 = _mm_srai_epi32(_mm_sub_epi32(tmp0, tmp3), 6);
+
+    _mm_storeu_si128((__m128i*)(data + 0), row0);
+    _mm_storeu_si128((__m128i*)(data + 4), row1);
+    _mm_storeu_si128((__m128i*)(data + 8), row2);
+    _mm_storeu_si128((__m128i*)(data + 12), row3);
+
+    /* check that each value is in the range [-512,511] */
+    tmp0 = _mm_set1_epi32(511);
+    tmp1 = _mm_set1_epi32(-512);
+    outOfRange = _mm_or_si128(
+        _mm_or_si128(_mm_cmpgt_epi32(row0, tmp0), _mm_cmplt_epi32(row0, tmp1)),
+        _mm_or_si128(_mm_cmpgt_epi32(row1, tmp0), _mm_cmplt_epi32(row1, tmp1)));
+    outOfRange = _mm_or_si128(outOfRange,
+        _mm_or_si128(_mm_cmpgt_epi32(row2, tmp0), _mm_cmplt_epi32(row2, tmp1)));
+    outOfRange = _mm_or_si128(outOfRange,
+        _mm_or_si128(_mm_cmpgt_epi32(row3, tmp0), _mm_cmplt_epi32(row3, tmp1)));
+
+    if (_mm_movemask_epi8(outOfRange))
+        return(HANTRO_NOK);
+
+    return(HANTRO_OK);
+
+}
+#endif /* H264DEC_SSE2 */
@@ -28,6 +28,7 @@
           h264bsdMoreRbspData
           h264bsdNextMbAddress
           h264bsdSetCurrImageMbPointers
+          h264bsdInitCpuFeatures
 
 ------------------------------------------------------------------------------*/
 
@@ -37,6 +38,11 @@
 
 #include "h264bsd_util.h"
 
+#ifdef H264DEC_SSE2
+#include <pthread.h>
+#include <cpuid.h>
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     2. External compiler flags
 --------------------------------------------------------------------------------
@@ -53,10 +59,22 @@ const u32 h264bsdQpC[52] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,
     20,21,22,23,24,25,26,27,28,29,29,30,31,32,32,33,34,34,35,35,36,36,37,37,37,
     38,38,38,39,39,39,39};
 
+#ifdef H264DEC_SSE2
+/* non-zero if the SSE2 versions of the time critical functions may be used,
+ * set by h264bsdInitCpuFeatures */
+u32 h264bsdCpuHasSse2 = 0;
+
+static pthread_once_t cpuFeaturesOnce = PTHREAD_ONCE_INIT;
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#ifdef H264DEC_SSE2
+static void DetectCpuFeatures(void);
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
 
    5.1  Function: h264bsdCountLeadingZeros
@@ -284,3 +302,44 @@ void h264bsdSetCurrImageMbPointers(image_t *image, u32 mbNum)
 }
 
 
+
+#ifdef H264DEC_SSE2
+/*------------------------------------------------------------------------------
+
+   5.6  Function: h264bsdInitCpuFeatures
+
+        Functional description:
+            Detect the instruction set extensions supported by the CPU and
+            set h264bsdCpuHasSse2 accordingly. Detection is performed only
+            once per process, later calls return immediately.
+
+        Inputs:
+            none
+
+        Outputs:
+            none
+
+        Returns:
+            none
+------------------------------------------------------------------------------*/
+void h264bsdInitCpuFeatures(void)
+{
+    pthread_once(&cpuFeaturesOnce, DetectCpuFeatures);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: DetectCpuFeatures
+
+        Functional description:
+            Query SSE2 support with the cpuid instruction.
+
+------------------------------------------------------------------------------*/
+void DetectCpuFeatures(void)
+{
+    u32 eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2))
+        h264bsdCpuHasSse2 = 1;
+}
+#endif /* H264DEC_SSE2 */
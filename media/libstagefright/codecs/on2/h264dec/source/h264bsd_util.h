@@ -154,6 +154,10 @@
 
 extern const u32 h264bsdQpC[52];
 
+#ifdef H264DEC_SSE2
+extern u32 h264bsdCpuHasSse2;
+#endif /* H264DEC_SSE2 */
+
 /*------------------------------------------------------------------------------
     3. Data types
 ------------------------------------------------------------------------------*/
@@ -174,5 +178,9 @@ u32 h264bsdNextMbAddress(u32 *pSliceGroupMap, u32 picSizeInMbs, u32 currMbAddr);
 
 void h264bsdSetCurrImageMbPointers(image_t *image, u32 mbNum);
 
+#ifdef H264DEC_SSE2
+void h264bsdInitCpuFeatures(void);
+#endif /* H264DEC_SSE2 */
+
 #endif /* #ifdef H264SWDEC_UTIL_H */
 
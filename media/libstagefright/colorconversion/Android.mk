@@ -3,6 +3,7 @@ include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES:=                     \
         ColorConverter.cpp            \
+        FrameScaler.cpp               \
         SoftwareRenderer.cpp
 
 LOCAL_C_INCLUDES := \
@@ -13,6 +14,20 @@ ifeq ($(TARGET_HAS_MULTIPLE_DISPLAY),true)
     LOCAL_CFLAGS += -DTARGET_HAS_MULTIPLE_DISPLAY
 endif
 
+# NEON and SSE2 row kernels for ColorConverter and FrameScaler, SSE2 is used
+# when the CPU supports it
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+    LOCAL_ARM_NEON := true
+    LOCAL_CFLAGS += -DCOLOR_CONVERTER_NEON
+endif
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DCOLOR_CONVERTER_SSE2
+endif
+
 LOCAL_MODULE:= libstagefright_color_conversion
 
 include $(BUILD_STATIC_LIBRARY)
+
+################################################################################
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -19,10 +19,19 @@
 #define LOG_TAG "ColorConverter"
 #include <utils/Log.h>
 
+#include <pthread.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/ColorConverter.h>
 #include <media/stagefright/MediaErrors.h>
 
+#if defined(COLOR_CONVERTER_NEON)
+#include <arm_neon.h>
+#elif defined(COLOR_CONVERTER_SSE2)
+#include <cpuid.h>
+#include <emmintrin.h>
+#endif
+
 namespace android {
 
 enum {
@@ -34,35 +43,623 @@ static const size_t NV12TILE_BLOCK_HEIGHT = 32;
 static const size_t NV12TILE_BLOCK_SIZE = NV12TILE_BLOCK_WIDTH* NV12TILE_BLOCK_HEIGHT;
 static const size_t NV12TILE_BLOCK_GROUP_SIZE =  NV12TILE_BLOCK_SIZE*4;
 
+// Frames are only split into bands of at least this many rows, and only if
+// they have at least this many pixels. Below that, waking up the workers
+// costs about as much as converting on the calling thread.
+static const size_t kMinRowsPerBand = 64;
+static const size_t kMinPixelsForBands = 320 * 240;
+static const size_t kMaxThreads = 16;
+
+struct ColorConverter::Conversion {
+    OMX_COLOR_FORMATTYPE mSrcFormat;
+    OMX_COLOR_FORMATTYPE mDstFormat;
+
+    // NULL for the tiled format, which is converted block by block.
+    GetSrcRowFunc mGetSrcRow;
+
+    // GetSrcRow needs 2 bytes of scratch space per pixel.
+    bool mNeedsScratch;
+
+    // Exchange red and blue in the output.
+    bool mSwapRB;
+};
+
+struct ColorConverter::Band {
+    ConvertRowsFunc mFunc;
+    const BitmapParams *mSrc;
+    const BitmapParams *mDst;
+    size_t mFirstRow;
+    size_t mLastRow;
+};
+
+// The RGB565 output of the semi-planar formats swaps the chroma planes and
+// red and blue, as it always has, RGBA8888 output follows the chroma order
+// of the source format.
+const ColorConverter::Conversion ColorConverter::kConversions[] = {
+    { OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format16bitRGB565,
+      GetYUV420PlanarRow, false, false },
+    { OMX_COLOR_FormatYUV420Planar,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      GetYUV420PlanarRow, false, false },
+
+    { OMX_COLOR_FormatCbYCrY, OMX_COLOR_Format16bitRGB565,
+      GetCbYCrYRow, true, false },
+    { OMX_COLOR_FormatCbYCrY,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      GetCbYCrYRow, true, false },
+
+    { OMX_QCOM_COLOR_FormatYVU420SemiPlanar, OMX_COLOR_Format16bitRGB565,
+      GetSemiPlanarRow, false, true },
+    { OMX_QCOM_COLOR_FormatYVU420SemiPlanar,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      GetSemiPlanarVURow, false, false },
+
+    { OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format16bitRGB565,
+      GetSemiPlanarVURow, false, true },
+    { OMX_COLOR_FormatYUV420SemiPlanar,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      GetSemiPlanarRow, false, false },
+
+    { OMX_TI_COLOR_FormatYUV420PackedSemiPlanar, OMX_COLOR_Format16bitRGB565,
+      GetTIPackedSemiPlanarRow, false, false },
+    { OMX_TI_COLOR_FormatYUV420PackedSemiPlanar,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      GetTIPackedSemiPlanarRow, false, false },
+
+    { (OMX_COLOR_FORMATTYPE)QOMX_COLOR_FormatYUV420PackedSemiPlanar64x32Tile2m8ka,
+      OMX_COLOR_Format16bitRGB565,
+      NULL, false, false },
+    { (OMX_COLOR_FORMATTYPE)QOMX_COLOR_FormatYUV420PackedSemiPlanar64x32Tile2m8ka,
+      (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal,
+      NULL, false, false },
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Covers the range of the B, G and R values computed by convertRowC().
+static const signed kClipMin = -278;
+static const signed kClipMax = 535;
+
+static uint8_t gClip[kClipMax - kClipMin + 1];
+static pthread_once_t gClipOnce = PTHREAD_ONCE_INIT;
+
+static void initClip() {
+    for (signed i = kClipMin; i <= kClipMax; ++i) {
+        gClip[i - kClipMin] = (i < 0) ? 0 : (i > 255) ? 255 : (uint8_t)i;
+    }
+}
+
+static inline uint8_t clip(signed x) {
+    return gClip[x - kClipMin];
+}
+
+// Calls put(x, r, g, b) for pixels x (even) up to width of a row.
+template<class PutPixel>
+static inline void convertRowC(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t x, size_t width, PutPixel put) {
+    // B = 1.164 * (Y - 16) + 2.018 * (U - 128)
+    // G = 1.164 * (Y - 16) - 0.813 * (V - 128) - 0.391 * (U - 128)
+    // R = 1.164 * (Y - 16) + 1.596 * (V - 128)
+
+    // B = 298/256 * (Y - 16) + 517/256 * (U - 128)
+    // G = .................. - 208/256 * (V - 128) - 100/256 * (U - 128)
+    // R = .................. + 409/256 * (V - 128)
+
+    // min_B = (298 * (- 16) + 517 * (- 128)) / 256 = -277
+    // min_G = (298 * (- 16) - 208 * (255 - 128) - 100 * (255 - 128)) / 256 = -172
+    // min_R = (298 * (- 16) + 409 * (- 128)) / 256 = -223
+
+    // max_B = (298 * (255 - 16) + 517 * (255 - 128)) / 256 = 534
+    // max_G = (298 * (255 - 16) - 208 * (- 128) - 100 * (- 128)) / 256 = 432
+    // max_R = (298 * (255 - 16) + 409 * (255 - 128)) / 256 = 481
+
+    // clip range -278 .. 535
+
+    for (; x < width; x += 2) {
+        size_t i = (x / 2) * chromaStep;
+
+        signed u = (signed)srcU[i] - 128;
+        signed v = (signed)srcV[i] - 128;
+
+        signed u_b = u * 517;
+        signed u_g = -u * 100;
+        signed v_g = -v * 208;
+        signed v_r = v * 409;
+
+        signed tmp1 = ((signed)srcY[x] - 16) * 298;
+        put(x, clip((tmp1 + v_r) / 256),
+               clip((tmp1 + v_g + u_g) / 256),
+               clip((tmp1 + u_b) / 256));
+
+        if (x + 1 < width) {
+            signed tmp2 = ((signed)srcY[x + 1] - 16) * 298;
+            put(x + 1, clip((tmp2 + v_r) / 256),
+                       clip((tmp2 + v_g + u_g) / 256),
+                       clip((tmp2 + u_b) / 256));
+        }
+    }
+}
+
+template<bool kSwapRB>
+struct PutRGB565 {
+    PutRGB565(void *dst) : mDst((uint16_t *)dst) {}
+
+    void operator()(size_t x, uint8_t r, uint8_t g, uint8_t b) const {
+        if (kSwapRB) {
+            mDst[x] = ((b >> 3) << 11) | ((g >> 2) << 5) | (r >> 3);
+        } else {
+            mDst[x] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        }
+    }
+
+    uint16_t *mDst;
+};
+
+template<bool kSwapRB>
+struct PutRGBA8888 {
+    PutRGBA8888(void *dst) : mDst((uint8_t *)dst) {}
+
+    void operator()(size_t x, uint8_t r, uint8_t g, uint8_t b) const {
+        uint8_t *pixel = &mDst[x * 4];
+        pixel[0] = kSwapRB ? b : r;
+        pixel[1] = g;
+        pixel[2] = kSwapRB ? r : b;
+        pixel[3] = 0xff;
+    }
+
+    uint8_t *mDst;
+};
+
+static void convertRowToRGB565C(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t x, size_t width, bool swapRB,
+        void *dst) {
+    if (swapRB) {
+        convertRowC(
+                srcY, srcU, srcV, chromaStep, x, width, PutRGB565<true>(dst));
+    } else {
+        convertRowC(
+                srcY, srcU, srcV, chromaStep, x, width, PutRGB565<false>(dst));
+    }
+}
+
+static void convertRowToRGBA8888C(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t x, size_t width, bool swapRB,
+        void *dst) {
+    if (swapRB) {
+        convertRowC(
+                srcY, srcU, srcV, chromaStep, x, width,
+                PutRGBA8888<true>(dst));
+    } else {
+        convertRowC(
+                srcY, srcU, srcV, chromaStep, x, width,
+                PutRGBA8888<false>(dst));
+    }
+}
+
+#if defined(COLOR_CONVERTER_NEON)
+
+// NEON converts 16 pixels at a time with the same integer math as
+// convertRowC(), (x >> 8) and (x / 256) only differ for negative x, which is
+// clipped to 0 either way.
+
+static inline uint8x8_t convert8NEON(
+        int16x8_t y, int16x8_t u, int16x8_t v,
+        int16_t yCoeff, int16_t uCoeff, int16_t vCoeff) {
+    int32x4_t lo = vmull_n_s16(vget_low_s16(y), yCoeff);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(y), yCoeff);
+
+    if (uCoeff != 0) {
+        lo = vmlal_n_s16(lo, vget_low_s16(u), uCoeff);
+        hi = vmlal_n_s16(hi, vget_high_s16(u), uCoeff);
+    }
+
+    if (vCoeff != 0) {
+        lo = vmlal_n_s16(lo, vget_low_s16(v), vCoeff);
+        hi = vmlal_n_s16(hi, vget_high_s16(v), vCoeff);
+    }
+
+    return vqmovun_s16(vcombine_s16(vshrn_n_s32(lo, 8), vshrn_n_s32(hi, 8)));
+}
+
+// Returns the red, green and blue values of 16 pixels.
+static inline void convert16NEON(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, bool swapRB, uint8x16_t *r, uint8x16_t *g,
+        uint8x16_t *b) {
+    uint8x8_t u, v;
+
+    if (chromaStep == 1) {
+        u = vld1_u8(srcU);
+        v = vld1_u8(srcV);
+    } else if (srcU < srcV) {
+        uint8x8x2_t uv = vld2_u8(srcU);
+        u = uv.val[0];
+        v = uv.val[1];
+    } else {
+        uint8x8x2_t vu = vld2_u8(srcV);
+        u = vu.val[1];
+        v = vu.val[0];
+    }
+
+    uint8x8x2_t uu = vzip_u8(u, u);
+    uint8x8x2_t vv = vzip_u8(v, v);
+
+    uint8x16_t y = vld1q_u8(srcY);
+
+    uint8x8_t r8[2], g8[2], b8[2];
+    for (size_t i = 0; i < 2; ++i) {
+        uint8x8_t y8 = (i == 0) ? vget_low_u8(y) : vget_high_u8(y);
+
+        int16x8_t y16 = vreinterpretq_s16_u16(vsubl_u8(y8, vdup_n_u8(16)));
+        int16x8_t u16 =
+            vreinterpretq_s16_u16(vsubl_u8(uu.val[i], vdup_n_u8(128)));
+        int16x8_t v16 =
+            vreinterpretq_s16_u16(vsubl_u8(vv.val[i], vdup_n_u8(128)));
+
+        b8[i] = convert8NEON(y16, u16, v16, 298, 517, 0);
+        g8[i] = convert8NEON(y16, u16, v16, 298, -100, -208);
+        r8[i] = convert8NEON(y16, u16, v16, 298, 0, 409);
+    }
+
+    *g = vcombine_u8(g8[0], g8[1]);
+    *r = vcombine_u8(r8[0], r8[1]);
+    *b = vcombine_u8(b8[0], b8[1]);
+
+    if (swapRB) {
+        uint8x16_t tmp = *r;
+        *r = *b;
+        *b = tmp;
+    }
+}
+
+static void convertRowToRGB565(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    uint16_t *dst_ptr = (uint16_t *)dst;
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        size_t i = (x / 2) * chromaStep;
+
+        uint8x16_t r, g, b;
+        convert16NEON(
+                &srcY[x], &srcU[i], &srcV[i], chromaStep, swapRB, &r, &g, &b);
+
+        for (size_t j = 0; j < 2; ++j) {
+            uint8x8_t r8 = (j == 0) ? vget_low_u8(r) : vget_high_u8(r);
+            uint8x8_t g8 = (j == 0) ? vget_low_u8(g) : vget_high_u8(g);
+            uint8x8_t b8 = (j == 0) ? vget_low_u8(b) : vget_high_u8(b);
+
+            uint16x8_t rgb = vshll_n_u8(r8, 8);
+            rgb = vsriq_n_u16(rgb, vshll_n_u8(g8, 8), 5);
+            rgb = vsriq_n_u16(rgb, vshll_n_u8(b8, 8), 11);
+
+            vst1q_u16(&dst_ptr[x + j * 8], rgb);
+        }
+    }
+
+    convertRowToRGB565C(
+            srcY, srcU, srcV, chromaStep, x, width, swapRB, dst);
+}
+
+static void convertRowToRGBA8888(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    uint8_t *dst_ptr = (uint8_t *)dst;
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        size_t i = (x / 2) * chromaStep;
+
+        uint8x16_t r, g, b;
+        convert16NEON(
+                &srcY[x], &srcU[i], &srcV[i], chromaStep, swapRB, &r, &g, &b);
+
+        uint8x8x4_t rgba;
+        rgba.val[3] = vdup_n_u8(0xff);
+
+        rgba.val[0] = vget_low_u8(r);
+        rgba.val[1] = vget_low_u8(g);
+        rgba.val[2] = vget_low_u8(b);
+        vst4_u8(&dst_ptr[x * 4], rgba);
+
+        rgba.val[0] = vget_high_u8(r);
+        rgba.val[1] = vget_high_u8(g);
+        rgba.val[2] = vget_high_u8(b);
+        vst4_u8(&dst_ptr[x * 4 + 32], rgba);
+    }
+
+    convertRowToRGBA8888C(
+            srcY, srcU, srcV, chromaStep, x, width, swapRB, dst);
+}
+
+#elif defined(COLOR_CONVERTER_SSE2)
+
+// SSE2 converts 16 pixels at a time with the same integer math as
+// convertRowC(), (x >> 8) and (x / 256) only differ for negative x, which is
+// clipped to 0 either way. It is only used if the CPU supports it.
+
+static bool gCpuHasSSE2;
+static pthread_once_t gCpuFeaturesOnce = PTHREAD_ONCE_INIT;
+
+static void detectCpuFeatures() {
+    unsigned eax, ebx, ecx, edx;
+    gCpuHasSSE2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+}
+
+// Two 16 bit coefficients for _mm_madd_epi16().
+static inline __m128i coeffPair(int16_t a, int16_t b) {
+    return _mm_set1_epi32((int)((uint16_t)a | ((uint32_t)(uint16_t)b << 16)));
+}
+
+// Returns (a * aCoeff + b * bCoeff) >> 8 for 8 pairs of 16 bit values.
+static inline __m128i madd8SSE2(__m128i a, __m128i b, __m128i coeffs) {
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), coeffs);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), coeffs);
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+
+// Returns the red, green and blue values of 16 pixels.
+static inline void convert16SSE2(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, bool swapRB, __m128i *r, __m128i *g, __m128i *b) {
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i u, v;
+    if (chromaStep == 1) {
+        u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)srcU), zero);
+        v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)srcV), zero);
+    } else {
+        __m128i uv = _mm_loadu_si128(
+                (const __m128i *)((srcU < srcV) ? srcU : srcV));
+        __m128i even = _mm_and_si128(uv, _mm_set1_epi16(0xff));
+        __m128i odd = _mm_srli_epi16(uv, 8);
+
+        u = (srcU < srcV) ? even : odd;
+        v = (srcU < srcV) ? odd : even;
+    }
+
+    u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+    __m128i y = _mm_loadu_si128((const __m128i *)srcY);
+
+    __m128i r16[2], g16[2], b16[2];
+    for (size_t i = 0; i < 2; ++i) {
+        __m128i y16 = (i == 0)
+            ? _mm_unpacklo_epi8(y, zero) : _mm_unpackhi_epi8(y, zero);
+        y16 = _mm_sub_epi16(y16, _mm_set1_epi16(16));
+
+        __m128i u16 = (i == 0)
+            ? _mm_unpacklo_epi16(u, u) : _mm_unpackhi_epi16(u, u);
+        __m128i v16 = (i == 0)
+            ? _mm_unpacklo_epi16(v, v) : _mm_unpackhi_epi16(v, v);
+
+        b16[i] = madd8SSE2(y16, u16, coeffPair(298, 517));
+        r16[i] = madd8SSE2(y16, v16, coeffPair(298, 409));
+
+        // The green sum needs all three terms before the shift.
+        __m128i yu = _mm_unpacklo_epi16(y16, u16);
+        __m128i vv = _mm_unpacklo_epi16(v16, zero);
+        __m128i lo = _mm_add_epi32(
+                _mm_madd_epi16(yu, coeffPair(298, -100)),
+                _mm_madd_epi16(vv, coeffPair(-208, 0)));
+
+        yu = _mm_unpackhi_epi16(y16, u16);
+        vv = _mm_unpackhi_epi16(v16, zero);
+        __m128i hi = _mm_add_epi32(
+                _mm_madd_epi16(yu, coeffPair(298, -100)),
+                _mm_madd_epi16(vv, coeffPair(-208, 0)));
+
+        g16[i] = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    }
+
+    // Saturating to unsigned 8 bit is the clip.
+    *g = _mm_packus_epi16(g16[0], g16[1]);
+    *r = _mm_packus_epi16(r16[0], r16[1]);
+    *b = _mm_packus_epi16(b16[0], b16[1]);
+
+    if (swapRB) {
+        __m128i tmp = *r;
+        *r = *b;
+        *b = tmp;
+    }
+}
+
+static void convertRowToRGB565(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    uint16_t *dst_ptr = (uint16_t *)dst;
+
+    size_t x = 0;
+    if (gCpuHasSSE2) {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; x + 16 <= width; x += 16) {
+            size_t i = (x / 2) * chromaStep;
+
+            __m128i r, g, b;
+            convert16SSE2(
+                    &srcY[x], &srcU[i], &srcV[i], chromaStep, swapRB,
+                    &r, &g, &b);
+
+            for (size_t j = 0; j < 2; ++j) {
+                __m128i r16 = (j == 0)
+                    ? _mm_unpacklo_epi8(r, zero) : _mm_unpackhi_epi8(r, zero);
+                __m128i g16 = (j == 0)
+                    ? _mm_unpacklo_epi8(g, zero) : _mm_unpackhi_epi8(g, zero);
+                __m128i b16 = (j == 0)
+                    ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+
+                __m128i rgb = _mm_or_si128(
+                        _mm_slli_epi16(
+                            _mm_and_si128(r16, _mm_set1_epi16(0xf8)), 8),
+                        _mm_slli_epi16(
+                            _mm_and_si128(g16, _mm_set1_epi16(0xfc)), 3));
+                rgb = _mm_or_si128(rgb, _mm_srli_epi16(b16, 3));
+
+                _mm_storeu_si128((__m128i *)&dst_ptr[x + j * 8], rgb);
+            }
+        }
+    }
+
+    convertRowToRGB565C(
+            srcY, srcU, srcV, chromaStep, x, width, swapRB, dst);
+}
+
+static void convertRowToRGBA8888(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    uint8_t *dst_ptr = (uint8_t *)dst;
+
+    size_t x = 0;
+    if (gCpuHasSSE2) {
+        const __m128i alpha = _mm_set1_epi8((char)0xff);
+
+        for (; x + 16 <= width; x += 16) {
+            size_t i = (x / 2) * chromaStep;
+
+            __m128i r, g, b;
+            convert16SSE2(
+                    &srcY[x], &srcU[i], &srcV[i], chromaStep, swapRB,
+                    &r, &g, &b);
+
+            __m128i rg = _mm_unpacklo_epi8(r, g);
+            __m128i ba = _mm_unpacklo_epi8(b, alpha);
+
+            __m128i *out = (__m128i *)&dst_ptr[x * 4];
+            _mm_storeu_si128(&out[0], _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128(&out[1], _mm_unpackhi_epi16(rg, ba));
+
+            rg = _mm_unpackhi_epi8(r, g);
+            ba = _mm_unpackhi_epi8(b, alpha);
+
+            _mm_storeu_si128(&out[2], _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128(&out[3], _mm_unpackhi_epi16(rg, ba));
+        }
+    }
+
+    convertRowToRGBA8888C(
+            srcY, srcU, srcV, chromaStep, x, width, swapRB, dst);
+}
+
+#else
+
+static void convertRowToRGB565(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    convertRowToRGB565C(
+            srcY, srcU, srcV, chromaStep, 0, width, swapRB, dst);
+}
+
+static void convertRowToRGBA8888(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        size_t chromaStep, size_t width, bool swapRB, void *dst) {
+    convertRowToRGBA8888C(
+            srcY, srcU, srcV, chromaStep, 0, width, swapRB, dst);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
 ColorConverter::ColorConverter(
         OMX_COLOR_FORMATTYPE from, OMX_COLOR_FORMATTYPE to)
     : mSrcFormat(from),
       mDstFormat(to),
-      mClip(NULL) {
+      mConversion(NULL),
+      mConvertRow(NULL),
+      mWorkers(NULL),
+      mNumWorkers(0),
+      mBands(NULL),
+      mNumBands(0),
+      mNextBand(0),
+      mNumBandsDone(0),
+      mExiting(false) {
+    pthread_once(&gClipOnce, initClip);
+
+#if defined(COLOR_CONVERTER_SSE2)
+    pthread_once(&gCpuFeaturesOnce, detectCpuFeatures);
+#endif
+
+    static const size_t kNumConversions =
+        sizeof(kConversions) / sizeof(kConversions[0]);
+
+    for (size_t i = 0; i < kNumConversions; ++i) {
+        if (kConversions[i].mSrcFormat == from
+                && kConversions[i].mDstFormat == to) {
+            mConversion = &kConversions[i];
+            break;
+        }
+    }
+
+    if (to == OMX_COLOR_Format16bitRGB565) {
+        mConvertRow = convertRowToRGB565;
+    } else {
+        mConvertRow = convertRowToRGBA8888;
+    }
 }
 
 ColorConverter::~ColorConverter() {
-    delete[] mClip;
-    mClip = NULL;
+    stopWorkers();
 }
 
 bool ColorConverter::isValid() const {
-    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
-        return false;
+    return mConversion != NULL;
+}
+
+void ColorConverter::setNumThreads(size_t numThreads) {
+    if (numThreads < 1) {
+        numThreads = 1;
+    } else if (numThreads > kMaxThreads) {
+        numThreads = kMaxThreads;
+    }
+
+    if (numThreads - 1 != mNumWorkers) {
+        stopWorkers();
+        startWorkers(numThreads - 1);
+    }
+}
+
+void ColorConverter::startWorkers(size_t numWorkers) {
+    if (numWorkers == 0) {
+        return;
+    }
+
+    mWorkers = new pthread_t[numWorkers];
+    mBands = new Band[numWorkers];
+    mExiting = false;
+
+    for (mNumWorkers = 0; mNumWorkers < numWorkers; ++mNumWorkers) {
+        if (pthread_create(
+                    &mWorkers[mNumWorkers], NULL, WorkerWrapper, this) != 0) {
+            ALOGW("unable to start a color conversion thread");
+            break;
+        }
     }
+}
 
-    switch (mSrcFormat) {
-        case OMX_COLOR_FormatYUV420Planar:
-        case OMX_COLOR_FormatCbYCrY:
-        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
-        case OMX_COLOR_FormatYUV420SemiPlanar:
-        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
-        case QOMX_COLOR_FormatYUV420PackedSemiPlanar64x32Tile2m8ka:
-            return true;
+void ColorConverter::stopWorkers() {
+    {
+        Mutex::Autolock autoLock(mLock);
+        mExiting = true;
+        mBandsQueued.broadcast();
+    }
 
-        default:
-            return false;
+    for (size_t i = 0; i < mNumWorkers; ++i) {
+        pthread_join(mWorkers[i], NULL);
     }
+    mNumWorkers = 0;
+
+    delete[] mWorkers;
+    mWorkers = NULL;
+
+    delete[] mBands;
+    mBands = NULL;
 }
 
 ColorConverter::BitmapParams::BitmapParams(
@@ -96,7 +693,7 @@ status_t ColorConverter::convert(
         size_t dstWidth, size_t dstHeight,
         size_t dstCropLeft, size_t dstCropTop,
         size_t dstCropRight, size_t dstCropBottom) {
-    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
+    if (mConversion == NULL) {
         return ERROR_UNSUPPORTED;
     }
 
@@ -110,432 +707,244 @@ status_t ColorConverter::convert(
             dstWidth, dstHeight,
             dstCropLeft, dstCropTop, dstCropRight, dstCropBottom);
 
-    status_t err;
+    if (mConversion->mGetSrcRow == NULL) {
+        // The tiled format is always converted in full, into a bitmap
+        // as wide as the source.
+        size_t numBlockRows =
+            (srcHeight - 1) / NV12TILE_BLOCK_HEIGHT + 1;
 
-    switch (mSrcFormat) {
-        case OMX_COLOR_FormatYUV420Planar:
-            err = convertYUV420Planar(src, dst);
-            break;
+        return runBands(
+                &ColorConverter::convertNV12TileRows, src, dst,
+                numBlockRows, srcWidth * NV12TILE_BLOCK_HEIGHT,
+                1, kMinRowsPerBand / NV12TILE_BLOCK_HEIGHT);
+    }
 
-        case OMX_COLOR_FormatCbYCrY:
-            err = convertCbYCrY(src, dst);
-            break;
+    if (!((src.mCropLeft & 1) == 0
+            && src.cropWidth() == dst.cropWidth()
+            && src.cropHeight() == dst.cropHeight())) {
+        return ERROR_UNSUPPORTED;
+    }
 
-        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
-            err = convertQCOMYUV420SemiPlanar(src, dst);
-            break;
+    // Bands start on even rows, which begin a new row of chroma samples.
+    return runBands(
+            &ColorConverter::convertRows, src, dst,
+            src.cropHeight(), src.cropWidth(), 2, kMinRowsPerBand);
+}
 
-        case OMX_COLOR_FormatYUV420SemiPlanar:
-            err = convertYUV420SemiPlanar(src, dst);
-            break;
+// static
+void *ColorConverter::WorkerWrapper(void *me) {
+    static_cast<ColorConverter *>(me)->workerLoop();
 
-        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
-            err = convertTIYUV420PackedSemiPlanar(src, dst);
-            break;
+    return NULL;
+}
 
-        case QOMX_COLOR_FormatYUV420PackedSemiPlanar64x32Tile2m8ka:
-            err =convertNV12Tile(
-                    srcWidth, srcHeight, srcBits, 0 /* srcSkip */,
-                    dstBits, srcWidth*2 /* dstSkip */);
-            break;
+void ColorConverter::workerLoop() {
+    Mutex::Autolock autoLock(mLock);
+
+    for (;;) {
+        while (!mExiting && mNextBand >= mNumBands) {
+            mBandsQueued.wait(mLock);
+        }
 
-        default:
-        {
-            CHECK(!"Should not be here. Unknown color conversion.");
+        if (mExiting) {
             break;
         }
-    }
 
-    return err;
+        runNextBand_l();
+    }
 }
 
-status_t ColorConverter::convertCbYCrY(
-        const BitmapParams &src, const BitmapParams &dst) {
-    // XXX Untested
+// Called with mLock held, which is released during the conversion.
+void ColorConverter::runNextBand_l() {
+    Band band = mBands[mNextBand++];
 
-    uint8_t *kAdjustedClip = initClip();
+    mLock.unlock();
+    (this->*band.mFunc)(*band.mSrc, *band.mDst, band.mFirstRow, band.mLastRow);
+    mLock.lock();
 
-    if (!((src.mCropLeft & 1) == 0
-        && src.cropWidth() == dst.cropWidth()
-        && src.cropHeight() == dst.cropHeight())) {
-        return ERROR_UNSUPPORTED;
+    if (++mNumBandsDone == mNumBands) {
+        mBandsDone.signal();
     }
+}
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
-
-    const uint8_t *src_ptr = (const uint8_t *)src.mBits
-        + (src.mCropTop * dst.mWidth + src.mCropLeft) * 2;
-
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1 = (signed)src_ptr[2 * x + 1] - 16;
-            signed y2 = (signed)src_ptr[2 * x + 3] - 16;
-            signed u = (signed)src_ptr[2 * x] - 128;
-            signed v = (signed)src_ptr[2 * x + 2] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[r1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[b1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[r2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[b2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
-        }
-
-        src_ptr += src.mWidth * 2;
-        dst_ptr += dst.mWidth;
+status_t ColorConverter::runBands(
+        ConvertRowsFunc func,
+        const BitmapParams &src, const BitmapParams &dst,
+        size_t numRows, size_t pixelsPerRow,
+        size_t rowAlignment, size_t minRowsPerBand) {
+    size_t numBands = numRows / minRowsPerBand;
+    if (numBands > mNumWorkers + 1) {
+        numBands = mNumWorkers + 1;
     }
 
-    return OK;
-}
+    if (numBands <= 1 || numRows * pixelsPerRow < kMinPixelsForBands) {
+        (this->*func)(src, dst, 0, numRows);
+        return OK;
+    }
 
-status_t ColorConverter::convertYUV420Planar(
-        const BitmapParams &src, const BitmapParams &dst) {
-    if (!((src.mCropLeft & 1) == 0
-            && src.cropWidth() == dst.cropWidth()
-            && src.cropHeight() == dst.cropHeight())) {
-        return ERROR_UNSUPPORTED;
+    size_t rowsPerBand = numRows / numBands;
+    rowsPerBand = (rowsPerBand + rowAlignment - 1) / rowAlignment * rowAlignment;
+
+    Mutex::Autolock autoLock(mLock);
+
+    // The first band is converted on the calling thread.
+    mNumBands = 0;
+    for (size_t i = 1; i < numBands && i * rowsPerBand < numRows; ++i) {
+        Band *band = &mBands[mNumBands++];
+        band->mFunc = func;
+        band->mSrc = &src;
+        band->mDst = &dst;
+        band->mFirstRow = i * rowsPerBand;
+        band->mLastRow = band->mFirstRow + rowsPerBand;
+        if (band->mLastRow > numRows || i + 1 == numBands) {
+            band->mLastRow = numRows;
+        }
     }
 
-    uint8_t *kAdjustedClip = initClip();
+    mNextBand = 0;
+    mNumBandsDone = 0;
+    mBandsQueued.broadcast();
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    mLock.unlock();
+    (this->*func)(src, dst, 0, rowsPerBand);
+    mLock.lock();
 
-    const uint8_t *src_y =
-        (const uint8_t *)src.mBits + src.mCropTop * src.mWidth + src.mCropLeft;
+    // Bands no worker has picked up yet are not waited for.
+    while (mNextBand < mNumBands) {
+        runNextBand_l();
+    }
 
-    const uint8_t *src_u =
-        (const uint8_t *)src_y + src.mWidth * src.mHeight
-        + src.mCropTop * (src.mWidth / 2) + src.mCropLeft / 2;
+    while (mNumBandsDone < mNumBands) {
+        mBandsDone.wait(mLock);
+    }
 
-    const uint8_t *src_v =
-        src_u + (src.mWidth / 2) * (src.mHeight / 2);
+    mNumBands = 0;
+    mNextBand = 0;
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            // B = 1.164 * (Y - 16) + 2.018 * (U - 128)
-            // G = 1.164 * (Y - 16) - 0.813 * (V - 128) - 0.391 * (U - 128)
-            // R = 1.164 * (Y - 16) + 1.596 * (V - 128)
-
-            // B = 298/256 * (Y - 16) + 517/256 * (U - 128)
-            // G = .................. - 208/256 * (V - 128) - 100/256 * (U - 128)
-            // R = .................. + 409/256 * (V - 128)
-
-            // min_B = (298 * (- 16) + 517 * (- 128)) / 256 = -277
-            // min_G = (298 * (- 16) - 208 * (255 - 128) - 100 * (255 - 128)) / 256 = -172
-            // min_R = (298 * (- 16) + 409 * (- 128)) / 256 = -223
-
-            // max_B = (298 * (255 - 16) + 517 * (255 - 128)) / 256 = 534
-            // max_G = (298 * (255 - 16) - 208 * (- 128) - 100 * (- 128)) / 256 = 432
-            // max_R = (298 * (255 - 16) + 409 * (255 - 128)) / 256 = 481
-
-            // clip range -278 .. 535
-
-            signed y1 = (signed)src_y[x] - 16;
-            signed y2 = (signed)src_y[x + 1] - 16;
-
-            signed u = (signed)src_u[x / 2] - 128;
-            signed v = (signed)src_v[x / 2] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[r1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[b1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[r2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[b2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
-        }
+    return OK;
+}
 
-        src_y += src.mWidth;
+void ColorConverter::convertRows(
+        const BitmapParams &src, const BitmapParams &dst,
+        size_t firstRow, size_t lastRow) {
+    size_t bytesPerPixel =
+        (mDstFormat == OMX_COLOR_Format16bitRGB565) ? 2 : 4;
 
-        if (y & 1) {
-            src_u += src.mWidth / 2;
-            src_v += src.mWidth / 2;
-        }
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + ((dst.mCropTop + firstRow) * dst.mWidth + dst.mCropLeft)
+            * bytesPerPixel;
 
-        dst_ptr += dst.mWidth;
+    uint8_t *scratch = NULL;
+    if (mConversion->mNeedsScratch) {
+        scratch = new uint8_t[src.cropWidth() * 2 + 2];
     }
 
-    return OK;
-}
+    for (size_t y = firstRow; y < lastRow; ++y) {
+        SrcRow row;
+        mConversion->mGetSrcRow(src, y, scratch, &row);
 
-status_t ColorConverter::convertQCOMYUV420SemiPlanar(
-        const BitmapParams &src, const BitmapParams &dst) {
-    uint8_t *kAdjustedClip = initClip();
+        mConvertRow(
+                row.mY, row.mU, row.mV, row.mChromaStep,
+                src.cropWidth(), mConversion->mSwapRB, dst_ptr);
 
-    if (!((src.mCropLeft & 1) == 0
-            && src.cropWidth() == dst.cropWidth()
-            && src.cropHeight() == dst.cropHeight())) {
-        return ERROR_UNSUPPORTED;
+        dst_ptr += dst.mWidth * bytesPerPixel;
     }
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    delete[] scratch;
+    scratch = NULL;
+}
 
+// static
+void ColorConverter::GetYUV420PlanarRow(
+        const BitmapParams &src, size_t row, uint8_t * /* scratch */,
+        SrcRow *out) {
     const uint8_t *src_y =
         (const uint8_t *)src.mBits + src.mCropTop * src.mWidth + src.mCropLeft;
 
     const uint8_t *src_u =
         (const uint8_t *)src_y + src.mWidth * src.mHeight
-        + src.mCropTop * src.mWidth + src.mCropLeft;
-
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1 = (signed)src_y[x] - 16;
-            signed y2 = (signed)src_y[x + 1] - 16;
-
-            signed u = (signed)src_u[x & ~1] - 128;
-            signed v = (signed)src_u[(x & ~1) + 1] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[b1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[r1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[b2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[r2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
-        }
+        + src.mCropTop * (src.mWidth / 2) + src.mCropLeft / 2;
 
-        src_y += src.mWidth;
+    const uint8_t *src_v =
+        src_u + (src.mWidth / 2) * (src.mHeight / 2);
 
-        if (y & 1) {
-            src_u += src.mWidth;
-        }
+    out->mY = src_y + row * src.mWidth;
+    out->mU = src_u + (row / 2) * (src.mWidth / 2);
+    out->mV = src_v + (row / 2) * (src.mWidth / 2);
+    out->mChromaStep = 1;
+}
 
-        dst_ptr += dst.mWidth;
-    }
+// static
+void ColorConverter::GetCbYCrYRow(
+        const BitmapParams &src, size_t row, uint8_t *scratch,
+        SrcRow *out) {
+    const uint8_t *src_ptr = (const uint8_t *)src.mBits
+        + ((src.mCropTop + row) * src.mWidth + src.mCropLeft) * 2;
 
-    return OK;
-}
+    size_t width = src.cropWidth();
 
-status_t ColorConverter::convertYUV420SemiPlanar(
-        const BitmapParams &src, const BitmapParams &dst) {
-    // XXX Untested
+    // Split the row into planes for the row converters.
+    uint8_t *y = scratch;
+    uint8_t *u = y + width;
+    uint8_t *v = u + (width + 1) / 2;
 
-    uint8_t *kAdjustedClip = initClip();
+    for (size_t x = 0; x < width; x += 2) {
+        u[x / 2] = src_ptr[2 * x];
+        y[x] = src_ptr[2 * x + 1];
+        v[x / 2] = src_ptr[2 * x + 2];
 
-    if (!((src.mCropLeft & 1) == 0
-            && src.cropWidth() == dst.cropWidth()
-            && src.cropHeight() == dst.cropHeight())) {
-        return ERROR_UNSUPPORTED;
+        if (x + 1 < width) {
+            y[x + 1] = src_ptr[2 * x + 3];
+        }
     }
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    out->mY = y;
+    out->mU = u;
+    out->mV = v;
+    out->mChromaStep = 1;
+}
 
+// static
+void ColorConverter::GetSemiPlanarRow(
+        const BitmapParams &src, size_t row, uint8_t * /* scratch */,
+        SrcRow *out) {
     const uint8_t *src_y =
         (const uint8_t *)src.mBits + src.mCropTop * src.mWidth + src.mCropLeft;
 
-    const uint8_t *src_u =
+    const uint8_t *src_uv =
         (const uint8_t *)src_y + src.mWidth * src.mHeight
         + src.mCropTop * src.mWidth + src.mCropLeft;
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1 = (signed)src_y[x] - 16;
-            signed y2 = (signed)src_y[x + 1] - 16;
-
-            signed v = (signed)src_u[x & ~1] - 128;
-            signed u = (signed)src_u[(x & ~1) + 1] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[b1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[r1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[b2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[r2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
-        }
-
-        src_y += src.mWidth;
-
-        if (y & 1) {
-            src_u += src.mWidth;
-        }
-
-        dst_ptr += dst.mWidth;
-    }
-
-    return OK;
+    out->mY = src_y + row * src.mWidth;
+    out->mU = src_uv + (row / 2) * src.mWidth;
+    out->mV = out->mU + 1;
+    out->mChromaStep = 2;
 }
 
-status_t ColorConverter::convertTIYUV420PackedSemiPlanar(
-        const BitmapParams &src, const BitmapParams &dst) {
-    uint8_t *kAdjustedClip = initClip();
+// static
+void ColorConverter::GetSemiPlanarVURow(
+        const BitmapParams &src, size_t row, uint8_t *scratch,
+        SrcRow *out) {
+    GetSemiPlanarRow(src, row, scratch, out);
 
-    if (!((src.mCropLeft & 1) == 0
-            && src.cropWidth() == dst.cropWidth()
-            && src.cropHeight() == dst.cropHeight())) {
-        return ERROR_UNSUPPORTED;
-    }
-
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    const uint8_t *tmp = out->mU;
+    out->mU = out->mV;
+    out->mV = tmp;
+}
 
+// static
+void ColorConverter::GetTIPackedSemiPlanarRow(
+        const BitmapParams &src, size_t row, uint8_t * /* scratch */,
+        SrcRow *out) {
     const uint8_t *src_y = (const uint8_t *)src.mBits;
 
-    const uint8_t *src_u =
+    const uint8_t *src_uv =
         (const uint8_t *)src_y + src.mWidth * (src.mHeight - src.mCropTop / 2);
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1 = (signed)src_y[x] - 16;
-            signed y2 = (signed)src_y[x + 1] - 16;
-
-            signed u = (signed)src_u[x & ~1] - 128;
-            signed v = (signed)src_u[(x & ~1) + 1] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[r1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[b1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[r2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[b2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
-        }
-
-        src_y += src.mWidth;
-
-        if (y & 1) {
-            src_u += src.mWidth;
-        }
-
-        dst_ptr += dst.mWidth;
-    }
-
-    return OK;
-}
-
-uint8_t *ColorConverter::initClip() {
-    static const signed kClipMin = -278;
-    static const signed kClipMax = 535;
-
-    if (mClip == NULL) {
-        mClip = new uint8_t[kClipMax - kClipMin + 1];
-
-        for (signed i = kClipMin; i <= kClipMax; ++i) {
-            mClip[i - kClipMin] = (i < 0) ? 0 : (i > 255) ? 255 : (uint8_t)i;
-        }
-    }
-
-    return &mClip[-kClipMin];
+    out->mY = src_y + row * src.mWidth;
+    out->mU = src_uv + (row / 2) * src.mWidth;
+    out->mV = out->mU + 1;
+    out->mChromaStep = 2;
 }
 
 // GetTiledMemBlockNum
@@ -605,46 +1014,10 @@ size_t ColorConverter::nv12TileGetTiledMemBlockNum(
     return base + offs;
 }
 
-//Compute the RGB 565 values from the Y ,Cb Cr values
-void ColorConverter::nv12TileComputeRGB(
-        uint8_t **dstPtr, const uint8_t *blockUV,
-        const uint8_t *blockY, size_t blockWidth,
-        size_t dstSkip) {
-
-    uint8_t *dest_ptr = *dstPtr;
-
-    uint8_t *kAdjustedClip = initClip();
-
-    for(size_t i = 0; i < blockWidth; i++) {
-        signed y1 = (signed)blockY[i] - 16;;
-        signed u = (signed)blockUV[i & ~1] - 128;
-        signed v = (signed)blockUV[(i & ~1)+1]- 128;
-
-        signed u_b = u * 517;
-        signed u_g = -u * 100;
-        signed v_g = -v * 208;
-        signed v_r = v * 409;
-
-        signed tmp1 = y1 * 298;
-        signed b1 = (tmp1 + u_b) / 256;
-        signed g1 = (tmp1 + v_g + u_g) / 256;
-        signed r1 = (tmp1 + v_r) / 256;
-        uint32_t rgb1 =
-            ((kAdjustedClip[r1] >> 3) << 11)
-            | ((kAdjustedClip[g1] >> 2) << 5)
-            | (kAdjustedClip[b1] >> 3);
-
-        dest_ptr[i * 2] =  rgb1 & 0xFF;
-        dest_ptr[(i * 2) + 1] = (rgb1 >> 8) & 0xFF;
-    }
-
-    dest_ptr += dstSkip;
-    *dstPtr = dest_ptr;
-}
 
 //  TraverseBlock
 //  Function that iterates through the rows of Luma and Chroma blocks
-//  simultaneously, passing pointers to the rows to compute RGB565 values.
+//  simultaneously, passing pointers to the rows to the row converter.
 //  Since there is twice as much data for Luma, Chroma row pointers are provided
 //  only when passing an even Luma row pointer.Since the same values apply for
 //  the next Luma (odd) row the  can save the pointer if needed.
@@ -657,28 +1030,30 @@ void ColorConverter::nv12TileTraverseBlock(
     for(size_t row = 0; row < blockHeight; row++) {
         if(row & 1) {
             // Only Luma, the converter can use the previous values if needed
-            nv12TileComputeRGB(dstPtr, block_UV, blockY, blockWidth, dstSkip);
             blockUV += NV12TILE_BLOCK_WIDTH;
         }
         else {
             block_UV = blockUV;
-            nv12TileComputeRGB(dstPtr, block_UV, blockY, blockWidth, dstSkip);
         }
+        mConvertRow(blockY, block_UV, block_UV + 1, 2, blockWidth,
+                false /* swapRB */, *dstPtr);
+        *dstPtr += dstSkip;
         blockY += NV12TILE_BLOCK_WIDTH;
     }
 }
 
-//Conversion from NV12 tiled to 16 bit RGB565
-status_t ColorConverter::convertNV12Tile(
-        size_t width, size_t height,
-        const void *srcBits, size_t srcSkip,
-        void *dstBits, size_t dstSkip) {
+//Conversion of block rows [firstBlockRow, lastBlockRow) from NV12 tiled
+void ColorConverter::convertNV12TileRows(
+        const BitmapParams &src, const BitmapParams &dst,
+        size_t firstBlockRow, size_t lastBlockRow) {
+    size_t width = src.mWidth;
+    size_t height = src.mHeight;
 
-    CHECK_EQ(srcSkip, 0);  // Doesn't really make sense for YUV formats.
-    CHECK(dstSkip >= width * 2);
-    CHECK((dstSkip & 3) == 0);
+    size_t bytesPerPixel =
+        (mDstFormat == OMX_COLOR_Format16bitRGB565) ? 2 : 4;
+    size_t dstSkip = width * bytesPerPixel;
 
-    uint8_t *base_ptr = (uint8_t *)dstBits;
+    uint8_t *base_ptr = (uint8_t *)dst.mBits;
     uint8_t *dst_ptr = NULL;
 
     // Absolute number of columns of blocks in the Luma and Chroma spaces
@@ -703,11 +1078,13 @@ status_t ColorConverter::convertNV12Tile(
     }
 
     // Pointers to the start of the Luma and Chroma spaces
-    const uint8_t *src_y   = (const uint8_t*)srcBits;
+    const uint8_t *src_y   = (const uint8_t*)src.mBits;
     const uint8_t *src_uv = src_y + size_y;
 
     // Iterate
-    for(size_t by = 0, rows_left = height; by < nby_y;
+    for(size_t by = firstBlockRow,
+            rows_left = height - firstBlockRow * NV12TILE_BLOCK_HEIGHT;
+            by < lastBlockRow;
             by++, rows_left -= NV12TILE_BLOCK_HEIGHT) {
         for(size_t bx = 0, cols_left = width; bx < abx;
                 bx++, cols_left -= NV12TILE_BLOCK_WIDTH) {
@@ -732,79 +1109,13 @@ status_t ColorConverter::convertNV12Tile(
 
             // We have started a new block, calculate the destination pointer
             dst_ptr = base_ptr +
-            by * NV12TILE_BLOCK_HEIGHT*width*2 +
-            bx * NV12TILE_BLOCK_WIDTH*2;
+            by * NV12TILE_BLOCK_HEIGHT*dstSkip +
+            bx * NV12TILE_BLOCK_WIDTH*bytesPerPixel;
             nv12TileTraverseBlock(&dst_ptr, block_y,
                     block_uv, block_width,
                     block_height, dstSkip);
         }
     }
-    return OK;
-}
-
-void ColorConverter::convertYUV420SemiPlanar32Aligned(
-            size_t width, size_t height,
-            const void *srcBits, size_t srcSkip,
-            void *dstBits, size_t dstSkip,
-            size_t alignedWidth) {
-    CHECK_EQ(srcSkip, 0);  // Doesn't really make sense for YUV formats.
-    CHECK(dstSkip >= alignedWidth * 2);
-    CHECK((dstSkip & 3) == 0);
-
-    uint8_t *kAdjustedClip = initClip();
-
-    uint32_t *dst_ptr = (uint32_t *)dstBits;
-    const uint8_t *src_y = (const uint8_t *)srcBits;
-
-    const uint8_t *src_u =
-        (const uint8_t *)src_y + width * height;
-
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < alignedWidth; x += 2) {
-            if(x > width)
-                continue;
-            signed y1 = (signed)src_y[x] - 16;
-            signed y2 = (signed)src_y[x + 1] - 16;
-
-            signed v = (signed)src_u[x & ~1] - 128;
-            signed u = (signed)src_u[(x & ~1) + 1] - 128;
-
-            signed u_b = u * 517;
-            signed u_g = -u * 100;
-            signed v_g = -v * 208;
-            signed v_r = v * 409;
-
-            signed tmp1 = y1 * 298;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * 298;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            uint32_t rgb1 =
-                ((kAdjustedClip[b1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[r1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[b2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[r2] >> 3);
-
-            dst_ptr[x / 2] = (rgb2 << 16) | rgb1;
-        }
-
-        src_y += width;
-
-        if (y & 1) {
-            src_u += width;
-        }
-
-        dst_ptr += dstSkip / 4;
-    }
 }
 
 }  // namespace android
@@ -0,0 +1,562 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameScaler"
+#include <utils/Log.h>
+
+#include <math.h>
+#include <pthread.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/FrameScaler.h>
+#include <media/stagefright/MediaErrors.h>
+
+#if defined(COLOR_CONVERTER_NEON)
+#include <arm_neon.h>
+#elif defined(COLOR_CONVERTER_SSE2)
+#include <cpuid.h>
+#include <emmintrin.h>
+#endif
+
+namespace android {
+
+static const int kWeightBits = 14;
+
+static inline uint8_t clipWeighted(int32_t sum) {
+    sum = (sum + (1 << (kWeightBits - 1))) >> kWeightBits;
+    return (sum < 0) ? 0 : (sum > 255) ? 255 : (uint8_t)sum;
+}
+
+// Weighted sum of numTaps RGBA pixels starting at src.
+static inline void sumPixelsC(
+        const uint8_t *src, const int16_t *weights, size_t numTaps,
+        uint8_t *dst) {
+    for (size_t c = 0; c < 4; ++c) {
+        int32_t sum = 0;
+        for (size_t k = 0; k < numTaps; ++k) {
+            sum += weights[k] * src[k * 4 + c];
+        }
+        dst[c] = clipWeighted(sum);
+    }
+}
+
+// Weighted sum of numTaps rows, srcStride bytes apart, for the bytes
+// [offset, numBytes) of a row.
+static inline void sumRowsC(
+        const uint8_t *src, size_t srcStride, const int16_t *weights,
+        size_t numTaps, size_t offset, size_t numBytes, uint8_t *dst) {
+    for (size_t i = offset; i < numBytes; ++i) {
+        int32_t sum = 0;
+        for (size_t k = 0; k < numTaps; ++k) {
+            sum += weights[k] * src[k * srcStride + i];
+        }
+        dst[i] = clipWeighted(sum);
+    }
+}
+
+#if defined(COLOR_CONVERTER_NEON)
+
+static void sumPixels(
+        const uint8_t *src, const int16_t *weights, size_t numTaps,
+        uint8_t *dst) {
+    int32x4_t acc = vdupq_n_s32(0);
+
+    size_t k = 0;
+    for (; k + 2 <= numTaps; k += 2) {
+        int16x8_t px =
+            vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&src[k * 4])));
+
+        acc = vmlal_n_s16(acc, vget_low_s16(px), weights[k]);
+        acc = vmlal_n_s16(acc, vget_high_s16(px), weights[k + 1]);
+    }
+
+    if (k < numTaps) {
+        uint8x8_t px8 = vreinterpret_u8_u32(
+                vdup_n_u32(*(const uint32_t *)&src[k * 4]));
+        int16x8_t px = vreinterpretq_s16_u16(vmovl_u8(px8));
+
+        acc = vmlal_n_s16(acc, vget_low_s16(px), weights[k]);
+    }
+
+    uint8x8_t out = vqmovn_u16(
+            vcombine_u16(vqrshrun_n_s32(acc, kWeightBits), vdup_n_u16(0)));
+
+    vst1_lane_u32((uint32_t *)dst, vreinterpret_u32_u8(out), 0);
+}
+
+static void sumRows(
+        const uint8_t *src, size_t srcStride, const int16_t *weights,
+        size_t numTaps, size_t numBytes, uint8_t *dst) {
+    size_t i = 0;
+    for (; i + 8 <= numBytes; i += 8) {
+        int32x4_t lo = vdupq_n_s32(0);
+        int32x4_t hi = vdupq_n_s32(0);
+
+        for (size_t k = 0; k < numTaps; ++k) {
+            int16x8_t row = vreinterpretq_s16_u16(
+                    vmovl_u8(vld1_u8(&src[k * srcStride + i])));
+
+            lo = vmlal_n_s16(lo, vget_low_s16(row), weights[k]);
+            hi = vmlal_n_s16(hi, vget_high_s16(row), weights[k]);
+        }
+
+        vst1_u8(&dst[i], vqmovn_u16(vcombine_u16(
+                        vqrshrun_n_s32(lo, kWeightBits),
+                        vqrshrun_n_s32(hi, kWeightBits))));
+    }
+
+    sumRowsC(src, srcStride, weights, numTaps, i, numBytes, dst);
+}
+
+#elif defined(COLOR_CONVERTER_SSE2)
+
+static bool gCpuHasSSE2;
+static pthread_once_t gCpuFeaturesOnce = PTHREAD_ONCE_INIT;
+
+static void detectCpuFeatures() {
+    unsigned eax, ebx, ecx, edx;
+    gCpuHasSSE2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+}
+
+// Two 16 bit weights for _mm_madd_epi16().
+static inline __m128i weightPair(int16_t a, int16_t b) {
+    return _mm_set1_epi32((int)((uint16_t)a | ((uint32_t)(uint16_t)b << 16)));
+}
+
+// Rounds and clips four 32 bit sums, returned in the low 4 bytes.
+static inline __m128i packWeighted(__m128i acc) {
+    acc = _mm_add_epi32(acc, _mm_set1_epi32(1 << (kWeightBits - 1)));
+    acc = _mm_srai_epi32(acc, kWeightBits);
+    acc = _mm_packs_epi32(acc, acc);
+    return _mm_packus_epi16(acc, acc);
+}
+
+static void sumPixels(
+        const uint8_t *src, const int16_t *weights, size_t numTaps,
+        uint8_t *dst) {
+    if (!gCpuHasSSE2) {
+        sumPixelsC(src, weights, numTaps, dst);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+
+    size_t k = 0;
+    for (; k + 2 <= numTaps; k += 2) {
+        // r0 g0 b0 a0 r1 g1 b1 a1 -> r0 r1 g0 g1 b0 b1 a0 a1
+        __m128i px = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)&src[k * 4]), zero);
+        px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+
+        acc = _mm_add_epi32(
+                acc,
+                _mm_madd_epi16(px, weightPair(weights[k], weights[k + 1])));
+    }
+
+    if (k < numTaps) {
+        __m128i px = _mm_unpacklo_epi8(
+                _mm_cvtsi32_si128(*(const int32_t *)&src[k * 4]), zero);
+        px = _mm_unpacklo_epi16(px, zero);
+
+        acc = _mm_add_epi32(
+                acc, _mm_madd_epi16(px, weightPair(weights[k], 0)));
+    }
+
+    *(int32_t *)dst = _mm_cvtsi128_si32(packWeighted(acc));
+}
+
+static void sumRows(
+        const uint8_t *src, size_t srcStride, const int16_t *weights,
+        size_t numTaps, size_t numBytes, uint8_t *dst) {
+    size_t i = 0;
+
+    if (gCpuHasSSE2) {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 <= numBytes; i += 16) {
+            __m128i acc[4] = { zero, zero, zero, zero };
+
+            for (size_t k = 0; k < numTaps; k += 2) {
+                __m128i a = _mm_loadu_si128(
+                        (const __m128i *)&src[k * srcStride + i]);
+
+                // An odd last row is paired with zero weight.
+                __m128i b = zero;
+                __m128i w;
+                if (k + 1 < numTaps) {
+                    b = _mm_loadu_si128(
+                            (const __m128i *)&src[(k + 1) * srcStride + i]);
+                    w = weightPair(weights[k], weights[k + 1]);
+                } else {
+                    w = weightPair(weights[k], 0);
+                }
+
+                __m128i aLo = _mm_unpacklo_epi8(a, zero);
+                __m128i aHi = _mm_unpackhi_epi8(a, zero);
+                __m128i bLo = _mm_unpacklo_epi8(b, zero);
+                __m128i bHi = _mm_unpackhi_epi8(b, zero);
+
+                acc[0] = _mm_add_epi32(acc[0],
+                        _mm_madd_epi16(_mm_unpacklo_epi16(aLo, bLo), w));
+                acc[1] = _mm_add_epi32(acc[1],
+                        _mm_madd_epi16(_mm_unpackhi_epi16(aLo, bLo), w));
+                acc[2] = _mm_add_epi32(acc[2],
+                        _mm_madd_epi16(_mm_unpacklo_epi16(aHi, bHi), w));
+                acc[3] = _mm_add_epi32(acc[3],
+                        _mm_madd_epi16(_mm_unpackhi_epi16(aHi, bHi), w));
+            }
+
+            const __m128i round = _mm_set1_epi32(1 << (kWeightBits - 1));
+            for (size_t j = 0; j < 4; ++j) {
+                acc[j] = _mm_srai_epi32(
+                        _mm_add_epi32(acc[j], round), kWeightBits);
+            }
+
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(
+                        _mm_packs_epi32(acc[0], acc[1]),
+                        _mm_packs_epi32(acc[2], acc[3])));
+        }
+    }
+
+    sumRowsC(src, srcStride, weights, numTaps, i, numBytes, dst);
+}
+
+#else
+
+static void sumPixels(
+        const uint8_t *src, const int16_t *weights, size_t numTaps,
+        uint8_t *dst) {
+    sumPixelsC(src, weights, numTaps, dst);
+}
+
+static void sumRows(
+        const uint8_t *src, size_t srcStride, const int16_t *weights,
+        size_t numTaps, size_t numBytes, uint8_t *dst) {
+    sumRowsC(src, srcStride, weights, numTaps, 0, numBytes, dst);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+FrameScaler::Taps::Taps()
+    : mSrcSize(0),
+      mDstSize(0),
+      mNumTaps(0),
+      mStart(NULL),
+      mWeights(NULL) {
+}
+
+FrameScaler::Taps::~Taps() {
+    clear();
+}
+
+void FrameScaler::Taps::clear() {
+    delete[] mStart;
+    mStart = NULL;
+
+    delete[] mWeights;
+    mWeights = NULL;
+
+    mSrcSize = mDstSize = mNumTaps = 0;
+}
+
+FrameScaler::FrameScaler(Filter filter, OMX_COLOR_FORMATTYPE dstFormat)
+    : mFilter(filter),
+      mDstFormat(dstFormat),
+      mTmp(NULL),
+      mTmpSize(0),
+      mRow(NULL),
+      mRowSize(0) {
+#if defined(COLOR_CONVERTER_SSE2)
+    pthread_once(&gCpuFeaturesOnce, detectCpuFeatures);
+#endif
+}
+
+FrameScaler::~FrameScaler() {
+    delete[] mTmp;
+    mTmp = NULL;
+
+    delete[] mRow;
+    mRow = NULL;
+}
+
+bool FrameScaler::isValid() const {
+    switch (mFilter) {
+        case FILTER_BOX:
+        case FILTER_BILINEAR:
+        case FILTER_LANCZOS3:
+            break;
+
+        default:
+            return false;
+    }
+
+    return mDstFormat == OMX_COLOR_Format16bitRGB565
+        || mDstFormat == (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal;
+}
+
+// static
+void FrameScaler::ComputeScaledSize(
+        int32_t displayWidth, int32_t displayHeight,
+        int32_t maxWidth, int32_t maxHeight, int32_t rotationAngle,
+        int32_t *width, int32_t *height) {
+    if (rotationAngle == 90 || rotationAngle == 270) {
+        int32_t tmp = maxWidth;
+        maxWidth = maxHeight;
+        maxHeight = tmp;
+    }
+
+    *width = displayWidth;
+    *height = displayHeight;
+
+    if (maxWidth > 0 && *width > maxWidth) {
+        *height = ((int64_t)*height * maxWidth + *width / 2) / *width;
+        *width = maxWidth;
+    }
+    if (maxHeight > 0 && *height > maxHeight) {
+        *width = ((int64_t)*width * maxHeight + *height / 2) / *height;
+        *height = maxHeight;
+    }
+
+    if (*width < 1) {
+        *width = 1;
+    }
+    if (*height < 1) {
+        *height = 1;
+    }
+}
+
+static double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+void FrameScaler::computeTaps(size_t srcSize, size_t dstSize, Taps *taps) {
+    taps->clear();
+
+    double scale = (double)srcSize / dstSize;
+
+    // Filters are stretched by the scale factor when shrinking.
+    double filterScale = (scale > 1.0) ? scale : 1.0;
+
+    // Distance from the center of a destination pixel, in source pixels,
+    // beyond which source pixels do not contribute.
+    double support;
+    switch (mFilter) {
+        case FILTER_BOX:
+            support = (filterScale + 1.0) / 2.0;
+            break;
+
+        case FILTER_BILINEAR:
+            support = filterScale;
+            break;
+
+        default:
+            support = 3.0 * filterScale;
+            break;
+    }
+
+    size_t numTaps = (size_t)floor(2.0 * support) + 1;
+    size_t windowTaps = (numTaps < srcSize) ? numTaps : srcSize;
+
+    taps->mSrcSize = srcSize;
+    taps->mDstSize = dstSize;
+    taps->mNumTaps = windowTaps;
+    taps->mStart = new int32_t[dstSize];
+    taps->mWeights = new int16_t[dstSize * windowTaps];
+
+    double *weights = new double[windowTaps];
+
+    for (size_t i = 0; i < dstSize; ++i) {
+        double center = (i + 0.5) * scale - 0.5;
+        int32_t first = (int32_t)ceil(center - support);
+
+        // Samples beyond the edges repeat the edge pixels, the window of
+        // taps is moved so that it covers all source pixels used.
+        int32_t start = (first < 0) ? 0 : first;
+        if (start > (int32_t)(srcSize - windowTaps)) {
+            start = srcSize - windowTaps;
+        }
+
+        for (size_t k = 0; k < windowTaps; ++k) {
+            weights[k] = 0.0;
+        }
+
+        double sum = 0.0;
+        for (size_t k = 0; k < numTaps; ++k) {
+            int32_t x = first + (int32_t)k;
+            double d = x - center;
+
+            double w;
+            switch (mFilter) {
+                case FILTER_BOX:
+                {
+                    // Overlap of source pixel x with the destination pixel.
+                    double lo = d - 0.5;
+                    double hi = d + 0.5;
+                    if (lo < -filterScale / 2) {
+                        lo = -filterScale / 2;
+                    }
+                    if (hi > filterScale / 2) {
+                        hi = filterScale / 2;
+                    }
+                    w = (hi > lo) ? hi - lo : 0.0;
+                    break;
+                }
+
+                case FILTER_BILINEAR:
+                {
+                    double t = fabs(d) / filterScale;
+                    w = (t < 1.0) ? 1.0 - t : 0.0;
+                    break;
+                }
+
+                default:
+                {
+                    double t = d / filterScale;
+                    w = (fabs(t) < 3.0) ? sinc(t) * sinc(t / 3.0) : 0.0;
+                    break;
+                }
+            }
+
+            if (x < 0) {
+                x = 0;
+            } else if (x >= (int32_t)srcSize) {
+                x = srcSize - 1;
+            }
+
+            weights[x - start] += w;
+            sum += w;
+        }
+
+        // Fixed point weights that add up to exactly 1.
+        int16_t *out = &taps->mWeights[i * windowTaps];
+        int32_t total = 0;
+        size_t largest = 0;
+        for (size_t k = 0; k < windowTaps; ++k) {
+            out[k] = (int16_t)floor(
+                    weights[k] / sum * (1 << kWeightBits) + 0.5);
+            total += out[k];
+
+            if (weights[k] > weights[largest]) {
+                largest = k;
+            }
+        }
+        out[largest] += (1 << kWeightBits) - total;
+
+        taps->mStart[i] = start;
+    }
+
+    delete[] weights;
+    weights = NULL;
+}
+
+// static
+void FrameScaler::ScaleRowHorizontally(
+        const Taps &taps, const uint8_t *src, uint8_t *dst) {
+    for (size_t i = 0; i < taps.mDstSize; ++i) {
+        sumPixels(
+                &src[taps.mStart[i] * 4],
+                &taps.mWeights[i * taps.mNumTaps], taps.mNumTaps,
+                &dst[i * 4]);
+    }
+}
+
+// static
+void FrameScaler::ScaleColumns(
+        const Taps &taps, size_t y,
+        const uint8_t *src, size_t srcStride, size_t numBytes,
+        uint8_t *dst) {
+    sumRows(&src[taps.mStart[y] * srcStride], srcStride,
+            &taps.mWeights[y * taps.mNumTaps], taps.mNumTaps,
+            numBytes, dst);
+}
+
+status_t FrameScaler::scale(
+        const void *srcBits,
+        size_t srcWidth, size_t srcHeight, size_t srcStride,
+        void *dstBits,
+        size_t dstWidth, size_t dstHeight, size_t dstStride) {
+    if (!isValid()) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    if (srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0) {
+        return BAD_VALUE;
+    }
+
+    if (mHorizontal.mSrcSize != srcWidth || mHorizontal.mDstSize != dstWidth) {
+        computeTaps(srcWidth, dstWidth, &mHorizontal);
+    }
+
+    if (mVertical.mSrcSize != srcHeight || mVertical.mDstSize != dstHeight) {
+        computeTaps(srcHeight, dstHeight, &mVertical);
+    }
+
+    size_t tmpStride = dstWidth * 4;
+    if (mTmpSize < tmpStride * srcHeight) {
+        delete[] mTmp;
+        mTmpSize = tmpStride * srcHeight;
+        mTmp = new uint8_t[mTmpSize];
+    }
+
+    for (size_t y = 0; y < srcHeight; ++y) {
+        ScaleRowHorizontally(
+                mHorizontal,
+                (const uint8_t *)srcBits + y * srcStride,
+                mTmp + y * tmpStride);
+    }
+
+    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
+        for (size_t y = 0; y < dstHeight; ++y) {
+            ScaleColumns(
+                    mVertical, y, mTmp, tmpStride, tmpStride,
+                    (uint8_t *)dstBits + y * dstStride);
+        }
+
+        return OK;
+    }
+
+    if (mRowSize < tmpStride) {
+        delete[] mRow;
+        mRowSize = tmpStride;
+        mRow = new uint8_t[mRowSize];
+    }
+
+    for (size_t y = 0; y < dstHeight; ++y) {
+        ScaleColumns(mVertical, y, mTmp, tmpStride, tmpStride, mRow);
+
+        uint16_t *dst_ptr = (uint16_t *)((uint8_t *)dstBits + y * dstStride);
+        for (size_t x = 0; x < dstWidth; ++x) {
+            const uint8_t *pixel = &mRow[x * 4];
+            dst_ptr[x] = ((pixel[0] >> 3) << 11)
+                | ((pixel[1] >> 2) << 5)
+                | (pixel[2] >> 3);
+        }
+    }
+
+    return OK;
+}
+
+}  // namespace android
@@ -20,6 +20,8 @@
 #include "../include/SoftwareRenderer.h"
 #include "../include/AwesomePlayer.h"
 
+#include <unistd.h>
+
 #include <cutils/properties.h> // for property_get
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MetaData.h>
@@ -87,6 +89,12 @@ SoftwareRenderer::SoftwareRenderer(
             mConverter = new ColorConverter(
                     mColorFormat, OMX_COLOR_Format16bitRGB565);
             CHECK(mConverter->isValid());
+
+            // Large frames are converted in bands on all cores.
+            long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+            if (numCpus > 1) {
+                mConverter->setNumThreads(numCpus);
+            }
             break;
     }
 
@@ -0,0 +1,53 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ================================================================
+# Unit tests for libstagefright_color_conversion
+# ================================================================
+
+# ================================================================
+# Compares ColorConverter with a per pixel reference conversion
+# ================================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := ColorConverter_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := ColorConverter_test.cpp
+
+LOCAL_C_INCLUDES := \
+	$(TOP)/frameworks/av/include \
+	$(TOP)/frameworks/native/include/media/openmax
+
+LOCAL_STATIC_LIBRARIES := \
+	libstagefright_color_conversion
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_foundation \
+	libutils
+
+include $(BUILD_NATIVE_TEST)
+
+# ================================================================
+# Compares FrameScaler with a floating point reference filter
+# ================================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := FrameScaler_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := FrameScaler_test.cpp
+
+LOCAL_C_INCLUDES := \
+	$(TOP)/frameworks/av/include \
+	$(TOP)/frameworks/native/include/media/openmax
+
+LOCAL_STATIC_LIBRARIES := \
+	libstagefright_color_conversion
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_foundation \
+	libutils
+
+include $(BUILD_NATIVE_TEST)
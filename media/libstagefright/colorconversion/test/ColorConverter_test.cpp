@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaErrors.h>
+
+namespace android {
+
+enum {
+    kFormatNV12Tile = 0x7FA30C03,
+};
+
+static const OMX_COLOR_FORMATTYPE kRGBA =
+    (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal;
+
+static uint8_t clip(signed x) {
+    return (x < 0) ? 0 : (x > 255) ? 255 : x;
+}
+
+// The per pixel math ColorConverter always used.
+static void referenceRGB(
+        uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b) {
+    signed y1 = (signed)y - 16;
+    signed u1 = (signed)u - 128;
+    signed v1 = (signed)v - 128;
+
+    *b = clip((y1 * 298 + u1 * 517) / 256);
+    *g = clip((y1 * 298 - v1 * 208 - u1 * 100) / 256);
+    *r = clip((y1 * 298 + v1 * 409) / 256);
+}
+
+static uint16_t pack565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+struct Frame {
+    size_t mWidth, mHeight;
+    size_t mCropLeft, mCropTop, mCropRight, mCropBottom;
+
+    size_t cropWidth() const { return mCropRight - mCropLeft + 1; }
+    size_t cropHeight() const { return mCropBottom - mCropTop + 1; }
+};
+
+// Returns the samples of pixel (x, y) of the crop rectangle, addressed as
+// the original per format conversion loops did.
+static void getSamples(
+        OMX_COLOR_FORMATTYPE format, const uint8_t *bits, const Frame &f,
+        size_t x, size_t y, uint8_t *Y, uint8_t *U, uint8_t *V) {
+    size_t W = f.mWidth;
+    size_t H = f.mHeight;
+    const uint8_t *src_y = bits + f.mCropTop * W + f.mCropLeft;
+
+    switch (format) {
+        case OMX_COLOR_FormatYUV420Planar:
+        {
+            const uint8_t *src_u = src_y + W * H
+                + f.mCropTop * (W / 2) + f.mCropLeft / 2;
+            const uint8_t *src_v = src_u + (W / 2) * (H / 2);
+
+            *Y = src_y[y * W + x];
+            *U = src_u[(y / 2) * (W / 2) + x / 2];
+            *V = src_v[(y / 2) * (W / 2) + x / 2];
+            break;
+        }
+
+        case OMX_COLOR_FormatCbYCrY:
+        {
+            const uint8_t *src_ptr =
+                bits + ((f.mCropTop + y) * W + f.mCropLeft) * 2;
+
+            *Y = src_ptr[2 * x + 1];
+            *U = src_ptr[2 * (x & ~1)];
+            *V = src_ptr[2 * (x & ~1) + 2];
+            break;
+        }
+
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        {
+            const uint8_t *src_uv = src_y + W * H
+                + f.mCropTop * W + f.mCropLeft + (y / 2) * W;
+
+            *Y = src_y[y * W + x];
+            *U = src_uv[x & ~1];
+            *V = src_uv[(x & ~1) + 1];
+            break;
+        }
+
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+        {
+            const uint8_t *src_uv =
+                bits + W * (H - f.mCropTop / 2) + (y / 2) * W;
+
+            *Y = bits[y * W + x];
+            *U = src_uv[x & ~1];
+            *V = src_uv[(x & ~1) + 1];
+            break;
+        }
+
+        default:
+            FAIL();
+    }
+}
+
+static size_t frameSize(OMX_COLOR_FORMATTYPE format, const Frame &f) {
+    if (format == OMX_COLOR_FormatCbYCrY) {
+        return f.mWidth * f.mHeight * 2;
+    }
+
+    // Generous for the pointer arithmetic of the TI format.
+    return f.mWidth * f.mHeight * 2 + 64;
+}
+
+static void fillRandom(uint8_t *data, size_t size, unsigned seed) {
+    srand(seed);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = rand() & 0xff;
+    }
+}
+
+static void testConversion(
+        OMX_COLOR_FORMATTYPE srcFormat, OMX_COLOR_FORMATTYPE dstFormat,
+        const Frame &f, size_t numThreads) {
+    SCOPED_TRACE(testing::Message()
+            << "format 0x" << std::hex << srcFormat << std::dec
+            << " to " << (dstFormat == kRGBA ? "RGBA" : "RGB565")
+            << " " << f.mWidth << "x" << f.mHeight
+            << " crop " << f.mCropLeft << "," << f.mCropTop
+            << " " << f.cropWidth() << "x" << f.cropHeight()
+            << " threads " << numThreads);
+
+    size_t srcSize = frameSize(srcFormat, f);
+    uint8_t *src = new uint8_t[srcSize];
+    fillRandom(src, srcSize, f.mWidth * 31 + f.mHeight);
+
+    size_t bytesPerPixel = (dstFormat == kRGBA) ? 4 : 2;
+    size_t dstWidth = f.cropWidth() + 3;
+    size_t dstHeight = f.cropHeight() + 2;
+    size_t dstSize = dstWidth * dstHeight * bytesPerPixel;
+    uint8_t *dst = new uint8_t[dstSize];
+    memset(dst, 0x5a, dstSize);
+
+    ColorConverter converter(srcFormat, dstFormat);
+    ASSERT_TRUE(converter.isValid());
+    converter.setNumThreads(numThreads);
+
+    ASSERT_EQ(OK, converter.convert(
+                src, f.mWidth, f.mHeight,
+                f.mCropLeft, f.mCropTop, f.mCropRight, f.mCropBottom,
+                dst, dstWidth, dstHeight,
+                1, 2, f.cropWidth(), f.cropHeight() + 1));
+
+    // RGB565 output of the semi-planar formats has always treated the
+    // chroma samples as swapped and swapped red and blue.
+    bool legacySwap = dstFormat != kRGBA
+        && (srcFormat == OMX_QCOM_COLOR_FormatYVU420SemiPlanar
+            || srcFormat == OMX_COLOR_FormatYUV420SemiPlanar);
+
+    // The QCOM format stores V before U, the RGB565 output of both
+    // semi-planar formats has always read them the other way around.
+    bool swapUV = false;
+    if (srcFormat == OMX_QCOM_COLOR_FormatYVU420SemiPlanar) {
+        swapUV = !legacySwap;
+    } else if (srcFormat == OMX_COLOR_FormatYUV420SemiPlanar) {
+        swapUV = legacySwap;
+    }
+
+    for (size_t y = 0; y < dstHeight; ++y) {
+        for (size_t x = 0; x < dstWidth; ++x) {
+            const uint8_t *out =
+                &dst[(y * dstWidth + x) * bytesPerPixel];
+
+            if (x < 1 || x > f.cropWidth() || y < 2 || y > f.cropHeight() + 1) {
+                for (size_t i = 0; i < bytesPerPixel; ++i) {
+                    ASSERT_EQ(0x5a, out[i]) << "at " << x << "," << y;
+                }
+                continue;
+            }
+
+            uint8_t Y = 0, U = 0, V = 0;
+            getSamples(srcFormat, src, f, x - 1, y - 2, &Y, &U, &V);
+            if (swapUV) {
+                uint8_t tmp = U;
+                U = V;
+                V = tmp;
+            }
+
+            uint8_t r, g, b;
+            referenceRGB(Y, U, V, &r, &g, &b);
+            if (legacySwap) {
+                uint8_t tmp = r;
+                r = b;
+                b = tmp;
+            }
+
+            if (dstFormat == kRGBA) {
+                ASSERT_EQ(r, out[0]) << "at " << x << "," << y;
+                ASSERT_EQ(g, out[1]) << "at " << x << "," << y;
+                ASSERT_EQ(b, out[2]) << "at " << x << "," << y;
+                ASSERT_EQ(0xff, out[3]) << "at " << x << "," << y;
+            } else {
+                ASSERT_EQ(pack565(r, g, b), *(const uint16_t *)out)
+                    << "at " << x << "," << y;
+            }
+        }
+    }
+
+    delete[] dst;
+    delete[] src;
+}
+
+static const OMX_COLOR_FORMATTYPE kRowFormats[] = {
+    OMX_COLOR_FormatYUV420Planar,
+    OMX_COLOR_FormatCbYCrY,
+    OMX_QCOM_COLOR_FormatYVU420SemiPlanar,
+    OMX_COLOR_FormatYUV420SemiPlanar,
+    OMX_TI_COLOR_FormatYUV420PackedSemiPlanar,
+};
+
+static const Frame kFrames[] = {
+    { 2, 2, 0, 0, 1, 1 },
+    { 16, 4, 0, 0, 15, 3 },
+    { 48, 20, 2, 2, 44, 17 },
+    { 176, 144, 0, 0, 175, 143 },
+    { 320, 256, 6, 4, 316, 253 },
+    { 640, 480, 0, 0, 639, 479 },
+};
+
+TEST(ColorConverterTest, RowFormats) {
+    for (size_t i = 0; i < sizeof(kRowFormats) / sizeof(kRowFormats[0]); ++i) {
+        for (size_t j = 0; j < sizeof(kFrames) / sizeof(kFrames[0]); ++j) {
+            testConversion(
+                    kRowFormats[i], OMX_COLOR_Format16bitRGB565, kFrames[j], 1);
+            testConversion(kRowFormats[i], kRGBA, kFrames[j], 1);
+        }
+    }
+}
+
+TEST(ColorConverterTest, RowBands) {
+    for (size_t i = 0; i < sizeof(kRowFormats) / sizeof(kRowFormats[0]); ++i) {
+        for (size_t j = 0; j < sizeof(kFrames) / sizeof(kFrames[0]); ++j) {
+            testConversion(
+                    kRowFormats[i], OMX_COLOR_Format16bitRGB565, kFrames[j], 3);
+            testConversion(kRowFormats[i], kRGBA, kFrames[j], 4);
+        }
+    }
+}
+
+// The band workers outlive a conversion, a converter used for many frames
+// and whose thread count changes in between must keep producing the same
+// output as a single threaded one.
+TEST(ColorConverterTest, RowBandsReused) {
+    static const size_t kWidth = 1280;
+    static const size_t kHeight = 720;
+    static const size_t kNumThreads[] = { 4, 4, 2, 16, 1, 3, 3 };
+
+    size_t srcSize = kWidth * kHeight * 3 / 2;
+    uint8_t *src = new uint8_t[srcSize];
+    fillRandom(src, srcSize, 7);
+
+    size_t dstSize = kWidth * kHeight * 4;
+    uint8_t *expected = new uint8_t[dstSize];
+    uint8_t *dst = new uint8_t[dstSize];
+
+    ColorConverter reference(OMX_COLOR_FormatYUV420Planar, kRGBA);
+    ASSERT_EQ(OK, reference.convert(
+                src, kWidth, kHeight, 0, 0, kWidth - 1, kHeight - 1,
+                expected, kWidth, kHeight, 0, 0, kWidth - 1, kHeight - 1));
+
+    ColorConverter converter(OMX_COLOR_FormatYUV420Planar, kRGBA);
+    for (size_t i = 0; i < sizeof(kNumThreads) / sizeof(kNumThreads[0]); ++i) {
+        SCOPED_TRACE(testing::Message() << "threads " << kNumThreads[i]);
+
+        converter.setNumThreads(kNumThreads[i]);
+        for (size_t j = 0; j < 8; ++j) {
+            memset(dst, 0x5a, dstSize);
+            ASSERT_EQ(OK, converter.convert(
+                        src, kWidth, kHeight, 0, 0, kWidth - 1, kHeight - 1,
+                        dst, kWidth, kHeight, 0, 0, kWidth - 1, kHeight - 1));
+            ASSERT_EQ(0, memcmp(expected, dst, dstSize));
+        }
+    }
+
+    delete[] dst;
+    delete[] expected;
+    delete[] src;
+}
+
+// The tiled conversion as it was before it moved to the row converters.
+static void referenceNV12Tile(
+        size_t width, size_t height, const uint8_t *src, uint16_t *dst) {
+    static const size_t kBlockWidth = 64;
+    static const size_t kBlockHeight = 32;
+    static const size_t kBlockSize = kBlockWidth * kBlockHeight;
+    static const size_t kBlockGroupSize = kBlockSize * 4;
+
+    size_t abx = (width - 1) / kBlockWidth + 1;
+    size_t nbx = (abx + 1) & ~1;
+    size_t nby_y = (height - 1) / kBlockHeight + 1;
+    size_t nby_uv = (height / 2 - 1) / kBlockHeight + 1;
+
+    size_t size_y = nbx * nby_y * kBlockSize;
+    if ((size_y % kBlockGroupSize) != 0) {
+        size_y = ((size_y - 1) / kBlockGroupSize + 1) * kBlockGroupSize;
+    }
+
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            size_t bx = x / kBlockWidth;
+            size_t by = y / kBlockHeight;
+
+            size_t blockNum[2];
+            for (size_t k = 0; k < 2; ++k) {
+                size_t row = (k == 0) ? by : by / 2;
+                size_t nby = (k == 0) ? nby_y : nby_uv;
+                size_t base, offs;
+
+                if ((row & 1) == 0) {
+                    base = row * nbx;
+                    offs = ((nby & 1) && row == nby - 1)
+                        ? bx : bx + ((bx + 2) & ~3);
+                } else {
+                    base = (row & ~1) * nbx + 2;
+                    offs = bx + (bx & ~3);
+                }
+                blockNum[k] = base + offs;
+            }
+
+            size_t bxOffset = x % kBlockWidth;
+            size_t byOffset = y % kBlockHeight;
+
+            const uint8_t *blockY = src + blockNum[0] * kBlockSize;
+            const uint8_t *blockUV = src + size_y + blockNum[1] * kBlockSize
+                + ((by & 1) ? kBlockSize / 2 : 0);
+
+            uint8_t Y = blockY[byOffset * kBlockWidth + bxOffset];
+            const uint8_t *uv =
+                blockUV + (byOffset / 2) * kBlockWidth + (bxOffset & ~1);
+
+            uint8_t r, g, b;
+            referenceRGB(Y, uv[0], uv[1], &r, &g, &b);
+            dst[y * width + x] = pack565(r, g, b);
+        }
+    }
+}
+
+TEST(ColorConverterTest, NV12Tile) {
+    static const size_t kSizes[][2] = {
+        { 64, 32 }, { 176, 144 }, { 320, 240 }, { 1280, 720 },
+    };
+
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+        size_t width = kSizes[i][0];
+        size_t height = kSizes[i][1];
+
+        size_t srcSize = ((width + 127) & ~127) * ((height + 63) & ~63) * 2
+            + 64 * 32 * 8;
+        uint8_t *src = new uint8_t[srcSize];
+        fillRandom(src, srcSize, width + height);
+
+        uint16_t *expected = new uint16_t[width * height];
+        referenceNV12Tile(width, height, src, expected);
+
+        uint16_t *rgb565 = new uint16_t[width * height];
+        uint8_t *rgba = new uint8_t[width * height * 4];
+
+        for (size_t numThreads = 1; numThreads <= 4; numThreads += 3) {
+            SCOPED_TRACE(testing::Message()
+                    << width << "x" << height << " threads " << numThreads);
+
+            ColorConverter converter565(
+                    (OMX_COLOR_FORMATTYPE)kFormatNV12Tile,
+                    OMX_COLOR_Format16bitRGB565);
+            ASSERT_TRUE(converter565.isValid());
+            converter565.setNumThreads(numThreads);
+
+            ASSERT_EQ(OK, converter565.convert(
+                        src, width, height, 0, 0, width - 1, height - 1,
+                        rgb565, width, height, 0, 0, width - 1, height - 1));
+            ASSERT_EQ(0, memcmp(expected, rgb565, width * height * 2));
+
+            ColorConverter converterRGBA(
+                    (OMX_COLOR_FORMATTYPE)kFormatNV12Tile, kRGBA);
+            ASSERT_TRUE(converterRGBA.isValid());
+            converterRGBA.setNumThreads(numThreads);
+
+            ASSERT_EQ(OK, converterRGBA.convert(
+                        src, width, height, 0, 0, width - 1, height - 1,
+                        rgba, width, height, 0, 0, width - 1, height - 1));
+
+            for (size_t j = 0; j < width * height; ++j) {
+                ASSERT_EQ(expected[j],
+                          pack565(rgba[j * 4], rgba[j * 4 + 1], rgba[j * 4 + 2]))
+                    << "at " << j;
+            }
+        }
+
+        delete[] rgba;
+        delete[] rgb565;
+        delete[] expected;
+        delete[] src;
+    }
+}
+
+TEST(ColorConverterTest, Unsupported) {
+    EXPECT_FALSE(ColorConverter(
+                OMX_COLOR_FormatYUV420Planar,
+                OMX_COLOR_Format24bitRGB888).isValid());
+    EXPECT_FALSE(ColorConverter(
+                OMX_COLOR_FormatL8, OMX_COLOR_Format16bitRGB565).isValid());
+
+    // Odd crop offsets split chroma pairs.
+    ColorConverter converter(
+            OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format16bitRGB565);
+    uint8_t src[16 * 16 * 2];
+    uint16_t dst[16 * 16];
+    EXPECT_EQ(ERROR_UNSUPPORTED, converter.convert(
+                src, 16, 16, 1, 0, 14, 15, dst, 14, 16, 0, 0, 13, 15));
+}
+
+}  // namespace android
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/FrameScaler.h>
+
+namespace android {
+
+static const OMX_COLOR_FORMATTYPE kRGBA =
+    (OMX_COLOR_FORMATTYPE)kColorFormatRGBA8888_Internal;
+
+static const FrameScaler::Filter kFilters[] = {
+    FrameScaler::FILTER_BOX,
+    FrameScaler::FILTER_BILINEAR,
+    FrameScaler::FILTER_LANCZOS3,
+};
+
+static double sinc(double x) {
+    return (x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+}
+
+// Floating point weights of all source pixels for destination pixel i.
+static void referenceWeights(
+        FrameScaler::Filter filter, size_t srcSize, size_t dstSize, size_t i,
+        double *weights) {
+    double scale = (double)srcSize / dstSize;
+    double s = (scale > 1.0) ? scale : 1.0;
+    double center = (i + 0.5) * scale - 0.5;
+
+    for (size_t x = 0; x < srcSize; ++x) {
+        weights[x] = 0.0;
+    }
+
+    double sum = 0.0;
+    for (int x = -200; x < (int)srcSize + 200; ++x) {
+        double d = x - center;
+        double w;
+
+        if (filter == FrameScaler::FILTER_BOX) {
+            double lo = fmax(d - 0.5, -s / 2);
+            double hi = fmin(d + 0.5, s / 2);
+            w = (hi > lo) ? hi - lo : 0.0;
+        } else if (filter == FrameScaler::FILTER_BILINEAR) {
+            w = fmax(0.0, 1.0 - fabs(d) / s);
+        } else {
+            double t = d / s;
+            w = (fabs(t) < 3.0) ? sinc(t) * sinc(t / 3.0) : 0.0;
+        }
+
+        int clamped = (x < 0) ? 0 : (x >= (int)srcSize) ? srcSize - 1 : x;
+        weights[clamped] += w;
+        sum += w;
+    }
+
+    for (size_t x = 0; x < srcSize; ++x) {
+        weights[x] /= sum;
+    }
+}
+
+static double clamp255(double x) {
+    return (x < 0.0) ? 0.0 : (x > 255.0) ? 255.0 : x;
+}
+
+static void testScale(
+        FrameScaler::Filter filter, OMX_COLOR_FORMATTYPE dstFormat,
+        size_t srcWidth, size_t srcHeight,
+        size_t dstWidth, size_t dstHeight) {
+    SCOPED_TRACE(testing::Message()
+            << "filter " << filter
+            << " " << (dstFormat == kRGBA ? "RGBA" : "RGB565")
+            << " " << srcWidth << "x" << srcHeight
+            << " -> " << dstWidth << "x" << dstHeight);
+
+    size_t srcStride = srcWidth * 4 + 12;
+    uint8_t *src = new uint8_t[srcStride * srcHeight];
+    srand(srcWidth * 7 + dstWidth);
+    for (size_t i = 0; i < srcStride * srcHeight; ++i) {
+        // Smooth content with some noise, like a video frame.
+        src[i] = (uint8_t)((i / 4 % srcWidth) * 3 + (rand() & 31));
+    }
+
+    size_t bytesPerPixel = (dstFormat == kRGBA) ? 4 : 2;
+    size_t dstStride = dstWidth * bytesPerPixel + 6;
+    uint8_t *dst = new uint8_t[dstStride * dstHeight];
+
+    FrameScaler scaler(filter, dstFormat);
+    ASSERT_TRUE(scaler.isValid());
+
+    // Twice, the second time with the taps already computed.
+    for (size_t pass = 0; pass < 2; ++pass) {
+        memset(dst, 0, dstStride * dstHeight);
+        ASSERT_EQ(OK, scaler.scale(
+                    src, srcWidth, srcHeight, srcStride,
+                    dst, dstWidth, dstHeight, dstStride));
+    }
+
+    // Reference in floating point, clipped after each pass like the
+    // 8 bit intermediate rows.
+    double *wx = new double[srcWidth];
+    double *wy = new double[srcHeight];
+    double *tmp = new double[dstWidth * 4 * srcHeight];
+
+    for (size_t x = 0; x < dstWidth; ++x) {
+        referenceWeights(filter, srcWidth, dstWidth, x, wx);
+        for (size_t y = 0; y < srcHeight; ++y) {
+            for (size_t c = 0; c < 4; ++c) {
+                double sum = 0.0;
+                for (size_t i = 0; i < srcWidth; ++i) {
+                    sum += wx[i] * src[y * srcStride + i * 4 + c];
+                }
+                tmp[(y * dstWidth + x) * 4 + c] = clamp255(sum);
+            }
+        }
+    }
+
+    int maxError = 0;
+    for (size_t y = 0; y < dstHeight; ++y) {
+        referenceWeights(filter, srcHeight, dstHeight, y, wy);
+        for (size_t x = 0; x < dstWidth; ++x) {
+            double rgba[4];
+            for (size_t c = 0; c < 4; ++c) {
+                double sum = 0.0;
+                for (size_t j = 0; j < srcHeight; ++j) {
+                    sum += wy[j] * tmp[(j * dstWidth + x) * 4 + c];
+                }
+                rgba[c] = clamp255(sum);
+            }
+
+            const uint8_t *out = &dst[y * dstStride + x * bytesPerPixel];
+            if (dstFormat == kRGBA) {
+                for (size_t c = 0; c < 4; ++c) {
+                    int error = abs((int)out[c] - (int)floor(rgba[c] + 0.5));
+                    maxError = (error > maxError) ? error : maxError;
+                }
+            } else {
+                uint16_t pixel = *(const uint16_t *)out;
+                int r = (pixel >> 11) << 3;
+                int g = ((pixel >> 5) & 0x3f) << 2;
+                int b = (pixel & 0x1f) << 3;
+
+                // Truncation to 5 and 6 bits on top of the rounding.
+                EXPECT_NEAR(rgba[0], r + 4, 6.0) << "at " << x << "," << y;
+                EXPECT_NEAR(rgba[1], g + 2, 4.0) << "at " << x << "," << y;
+                EXPECT_NEAR(rgba[2], b + 4, 6.0) << "at " << x << "," << y;
+            }
+        }
+    }
+
+    EXPECT_LE(maxError, 2);
+
+    delete[] tmp;
+    delete[] wy;
+    delete[] wx;
+    delete[] dst;
+    delete[] src;
+}
+
+TEST(FrameScalerTest, MatchesReference) {
+    static const size_t kSizes[][4] = {
+        { 64, 48, 32, 24 },
+        { 176, 144, 96, 80 },
+        { 320, 240, 97, 61 },
+        { 33, 17, 70, 40 },
+        { 5, 3, 1, 1 },
+        { 1, 1, 7, 5 },
+        { 640, 360, 160, 90 },
+    };
+
+    for (size_t i = 0; i < sizeof(kFilters) / sizeof(kFilters[0]); ++i) {
+        for (size_t j = 0; j < sizeof(kSizes) / sizeof(kSizes[0]); ++j) {
+            testScale(kFilters[i], kRGBA,
+                      kSizes[j][0], kSizes[j][1], kSizes[j][2], kSizes[j][3]);
+        }
+
+        testScale(kFilters[i], OMX_COLOR_Format16bitRGB565, 320, 240, 80, 60);
+    }
+}
+
+TEST(FrameScalerTest, SameSizeCopies) {
+    static const size_t kWidth = 37;
+    static const size_t kHeight = 23;
+
+    uint8_t src[kWidth * kHeight * 4];
+    for (size_t i = 0; i < sizeof(src); ++i) {
+        src[i] = rand() & 0xff;
+    }
+
+    for (size_t i = 0; i < sizeof(kFilters) / sizeof(kFilters[0]); ++i) {
+        uint8_t dst[kWidth * kHeight * 4];
+
+        FrameScaler scaler(kFilters[i], kRGBA);
+        ASSERT_EQ(OK, scaler.scale(
+                    src, kWidth, kHeight, kWidth * 4,
+                    dst, kWidth, kHeight, kWidth * 4));
+
+        EXPECT_EQ(0, memcmp(src, dst, sizeof(src))) << "filter " << kFilters[i];
+    }
+}
+
+TEST(FrameScalerTest, Invalid) {
+    EXPECT_FALSE(FrameScaler(
+                FrameScaler::FILTER_BOX, OMX_COLOR_Format24bitRGB888).isValid());
+
+    uint8_t pixel[4];
+    FrameScaler scaler(FrameScaler::FILTER_BILINEAR, kRGBA);
+    EXPECT_EQ(BAD_VALUE, scaler.scale(pixel, 0, 1, 4, pixel, 1, 1, 4));
+}
+
+TEST(FrameScalerTest, ScaledSize) {
+    int32_t width, height;
+
+    FrameScaler::ComputeScaledSize(1280, 720, 320, 320, 0, &width, &height);
+    EXPECT_EQ(320, width);
+    EXPECT_EQ(180, height);
+
+    // Never enlarged, a bound <= 0 is no bound.
+    FrameScaler::ComputeScaledSize(176, 144, 320, 0, 0, &width, &height);
+    EXPECT_EQ(176, width);
+    EXPECT_EQ(144, height);
+
+    // The bounds apply to the rotated frame, which is shown 135x240.
+    FrameScaler::ComputeScaledSize(1280, 720, 320, 240, 90, &width, &height);
+    EXPECT_EQ(240, width);
+    EXPECT_EQ(135, height);
+
+    FrameScaler::ComputeScaledSize(1280, 720, 320, 240, 180, &width, &height);
+    EXPECT_EQ(320, width);
+    EXPECT_EQ(180, height);
+}
+
+}  // namespace android
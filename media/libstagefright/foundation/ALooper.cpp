@@ -67,7 +67,8 @@ int64_t ALooper::GetNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextSeqNo(0),
+      mRunningLocally(false) {
 }
 
 ALooper::~ALooper() {
@@ -164,20 +165,83 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = GetNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
-    }
-
     Event event;
     event.mWhenUs = whenUs;
+    event.mSeqNo = mNextSeqNo++;
     event.mMessage = msg;
 
-    if (it == mEventQueue.begin()) {
+    // Only wake up the looper thread if the new event is now the
+    // earliest one, otherwise it will be woken up in time anyway.
+    if (mEventQueue.isEmpty() || IsEarlier(event, mEventQueue.itemAt(0))) {
         mQueueChangedCondition.signal();
     }
 
-    mEventQueue.insert(it, event);
+    pushEvent_l(event);
+}
+
+// static
+bool ALooper::IsEarlier(const Event &a, const Event &b) {
+    if (a.mWhenUs != b.mWhenUs) {
+        return a.mWhenUs < b.mWhenUs;
+    }
+
+    // Sequence numbers are compared modulo 2^32 to survive wraparound.
+    return (int32_t)(a.mSeqNo - b.mSeqNo) < 0;
+}
+
+void ALooper::pushEvent_l(const Event &event) {
+    size_t i = mEventQueue.size();
+    mEventQueue.push();
+
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+
+        if (!IsEarlier(event, mEventQueue.itemAt(parent))) {
+            break;
+        }
+
+        mEventQueue.editItemAt(i) = mEventQueue.itemAt(parent);
+        i = parent;
+    }
+
+    mEventQueue.editItemAt(i) = event;
+}
+
+void ALooper::popEvent_l(Event *event) {
+    *event = mEventQueue.itemAt(0);
+
+    Event last = mEventQueue.top();
+    mEventQueue.pop();
+
+    size_t n = mEventQueue.size();
+    if (n == 0) {
+        return;
+    }
+
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+
+        if (child >= n) {
+            break;
+        }
+
+        if (child + 1 < n
+                && IsEarlier(
+                    mEventQueue.itemAt(child + 1),
+                    mEventQueue.itemAt(child))) {
+            ++child;
+        }
+
+        if (!IsEarlier(mEventQueue.itemAt(child), last)) {
+            break;
+        }
+
+        mEventQueue.editItemAt(i) = mEventQueue.itemAt(child);
+        i = child;
+    }
+
+    mEventQueue.editItemAt(i) = last;
 }
 
 bool ALooper::loop() {
@@ -188,11 +252,11 @@ bool ALooper::loop() {
         if (mThread == NULL && !mRunningLocally) {
             return false;
         }
-        if (mEventQueue.empty()) {
+        if (mEventQueue.isEmpty()) {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.itemAt(0).mWhenUs;
         int64_t nowUs = GetNowUs();
 
         if (whenUs > nowUs) {
@@ -202,8 +266,7 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        popEvent_l(&event);
     }
 
     gLooperRoster.deliverMessage(event.mMessage);
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ALooperPool"
+#include <utils/Log.h>
+
+#include <unistd.h>
+
+#include "ALooperPool.h"
+
+#include "ADebug.h"
+#include "AHandler.h"
+#include "AMessage.h"
+#include "AString.h"
+
+namespace android {
+
+// Replies to every message it receives. Since a looper delivers its messages
+// one at a time and in order, the reply to a message posted now means that
+// all messages queued or being delivered before it have been handled.
+struct ALooperPool::BarrierHandler : public AHandler {
+    BarrierHandler() {}
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        uint32_t replyID;
+        CHECK(msg->senderAwaitsResponse(&replyID));
+
+        (new AMessage)->postReply(replyID);
+    }
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(BarrierHandler);
+};
+
+// static
+pthread_once_t ALooperPool::gLooperPoolOnce = PTHREAD_ONCE_INIT;
+
+// static
+ALooperPool *ALooperPool::gLooperPool;
+
+// static
+void ALooperPool::InitLooperPool() {
+    gLooperPool = new ALooperPool;
+}
+
+// static
+ALooperPool *ALooperPool::Get() {
+    pthread_once(&gLooperPoolOnce, InitLooperPool);
+    return gLooperPool;
+}
+
+// static
+sp<ALooper> ALooperPool::RegisterHandler(const sp<AHandler> &handler) {
+    return Get()->registerHandler(handler);
+}
+
+// static
+void ALooperPool::UnregisterHandler(ALooper::handler_id handlerID) {
+    Get()->unregisterHandler(handlerID, false /* wait */);
+}
+
+// static
+void ALooperPool::UnregisterHandlerAndWait(ALooper::handler_id handlerID) {
+    Get()->unregisterHandler(handlerID, true /* wait */);
+}
+
+ALooperPool::ALooperPool() {
+}
+
+sp<ALooper> ALooperPool::registerHandler(const sp<AHandler> &handler) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (mLoopers.isEmpty()) {
+        long numCores = sysconf(_SC_NPROCESSORS_CONF);
+        if (numCores < 1) {
+            numCores = 1;
+        }
+
+        ALOGV("starting %ld shared loopers", numCores);
+
+        for (long i = 0; i < numCores; ++i) {
+            LooperInfo info;
+            info.mLooper = new ALooper;
+            info.mLooper->setName(StringPrintf("ALooperPool%ld", i).c_str());
+            info.mBarrier = new BarrierHandler;
+            info.mNumHandlers = 0;
+
+            info.mLooper->registerHandler(info.mBarrier);
+
+            // The software codecs and OMX callback dispatchers sharing these
+            // loopers ran at this priority on threads of their own.
+            CHECK_EQ(info.mLooper->start(
+                        false /* runOnCallingThread */,
+                        false /* canCallJava */,
+                        ANDROID_PRIORITY_FOREGROUND),
+                     (status_t)OK);
+
+            mLoopers.push(info);
+        }
+    }
+
+    size_t index = 0;
+    for (size_t i = 1; i < mLoopers.size(); ++i) {
+        if (mLoopers.itemAt(i).mNumHandlers
+                < mLoopers.itemAt(index).mNumHandlers) {
+            index = i;
+        }
+    }
+
+    LooperInfo *info = &mLoopers.editItemAt(index);
+
+    ALooper::handler_id handlerID = info->mLooper->registerHandler(handler);
+    ++info->mNumHandlers;
+
+    mHandlers.add(handlerID, index);
+
+    return info->mLooper;
+}
+
+void ALooperPool::unregisterHandler(
+        ALooper::handler_id handlerID, bool wait) {
+    sp<BarrierHandler> barrier;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        ssize_t index = mHandlers.indexOfKey(handlerID);
+        if (index < 0) {
+            return;
+        }
+
+        LooperInfo *info = &mLoopers.editItemAt(mHandlers.valueAt(index));
+        info->mLooper->unregisterHandler(handlerID);
+        --info->mNumHandlers;
+
+        mHandlers.removeItemsAt(index);
+
+        barrier = info->mBarrier;
+    }
+
+    if (wait) {
+        sp<AMessage> response;
+        CHECK_EQ((new AMessage(0, barrier->id()))->postAndAwaitResponse(&response),
+                 (status_t)OK);
+    }
+}
+
+}  // namespace android
@@ -17,6 +17,7 @@
 #include "AMessage.h"
 
 #include <ctype.h>
+#include <pthread.h>
 
 #include "AAtomizer.h"
 #include "ABuffer.h"
@@ -31,6 +32,77 @@ namespace android {
 
 extern ALooperRoster gLooperRoster;
 
+// Storage of destroyed messages is kept on this free list (linked through
+// the first word of each block) for reuse by subsequently created messages.
+struct MessagePool {
+    MessagePool()
+        : mFreeList(NULL),
+          mNumFree(0) {
+    }
+
+    Mutex mLock;
+    void *mFreeList;
+    size_t mNumFree;
+};
+
+// Created on first use and never destroyed, messages may be created and
+// destroyed by static constructors and destructors of other libraries.
+static pthread_once_t gMessagePoolOnce = PTHREAD_ONCE_INIT;
+static MessagePool *gMessagePool;
+
+static void InitMessagePool() {
+    gMessagePool = new MessagePool;
+}
+
+static MessagePool *GetMessagePool() {
+    pthread_once(&gMessagePoolOnce, InitMessagePool);
+    return gMessagePool;
+}
+
+enum {
+    kMaxNumPooledMessages = 32
+};
+
+// static
+void *AMessage::operator new(size_t size) {
+    if (size == sizeof(AMessage)) {
+        MessagePool *pool = GetMessagePool();
+        Mutex::Autolock autoLock(pool->mLock);
+
+        void *ptr = pool->mFreeList;
+        if (ptr != NULL) {
+            pool->mFreeList = *static_cast<void **>(ptr);
+            --pool->mNumFree;
+
+            return ptr;
+        }
+    }
+
+    return ::operator new(size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (size == sizeof(AMessage)) {
+        MessagePool *pool = GetMessagePool();
+        Mutex::Autolock autoLock(pool->mLock);
+
+        if (pool->mNumFree < kMaxNumPooledMessages) {
+            *static_cast<void **>(ptr) = pool->mFreeList;
+            pool->mFreeList = ptr;
+            ++pool->mNumFree;
+
+            return;
+        }
+    }
+
+    ::operator delete(ptr);
+}
+
 AMessage::AMessage(uint32_t what, ALooper::handler_id target)
     : mWhat(what),
       mTarget(target),
@@ -69,7 +141,9 @@ void AMessage::freeItem(Item *item) {
     switch (item->mType) {
         case kTypeString:
         {
-            delete item->u.stringValue;
+            if (!item->mIsInlineString) {
+                delete item->u.stringValue;
+            }
             break;
         }
 
@@ -88,17 +162,27 @@ void AMessage::freeItem(Item *item) {
     }
 }
 
-AMessage::Item *AMessage::allocateItem(const char *name) {
-    name = AAtomizer::Atomize(name);
+// Item names are compared by content so that lookups don't have to go
+// through the (locked) atomizer, only names of newly added items are
+// atomized.
+ssize_t AMessage::findItemIndex(const char *name) const {
+    for (size_t i = 0; i < mNumItems; ++i) {
+        const char *itemName = mItems[i].mName;
 
-    size_t i = 0;
-    while (i < mNumItems && mItems[i].mName != name) {
-        ++i;
+        if (itemName == name || !strcmp(itemName, name)) {
+            return i;
+        }
     }
 
+    return -1;
+}
+
+AMessage::Item *AMessage::allocateItem(const char *name) {
+    ssize_t i = findItemIndex(name);
+
     Item *item;
 
-    if (i < mNumItems) {
+    if (i >= 0) {
         item = &mItems[i];
         freeItem(item);
     } else {
@@ -106,7 +190,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         i = mNumItems++;
         item = &mItems[i];
 
-        item->mName = name;
+        item->mName = AAtomizer::Atomize(name);
     }
 
     return item;
@@ -114,17 +198,21 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
 
 const AMessage::Item *AMessage::findItem(
         const char *name, Type type) const {
-    name = AAtomizer::Atomize(name);
-
-    for (size_t i = 0; i < mNumItems; ++i) {
-        const Item *item = &mItems[i];
+    ssize_t i = findItemIndex(name);
 
-        if (item->mName == name) {
-            return item->mType == type ? item : NULL;
-        }
+    if (i < 0) {
+        return NULL;
     }
 
-    return NULL;
+    const Item *item = &mItems[i];
+
+    return item->mType == type ? item : NULL;
+}
+
+// static
+const char *AMessage::StringValue(const Item &item) {
+    return item.mIsInlineString
+        ? item.u.inlineStringValue : item.u.stringValue->c_str();
 }
 
 #define BASIC_TYPE(NAME,FIELDNAME,TYPENAME)                             \
@@ -155,9 +243,22 @@ BASIC_TYPE(Pointer,ptrValue,void *)
 
 void AMessage::setString(
         const char *name, const char *s, ssize_t len) {
+    size_t size = len < 0 ? strlen(s) : len;
+
     Item *item = allocateItem(name);
     item->mType = kTypeString;
-    item->u.stringValue = new AString(s, len < 0 ? strlen(s) : len);
+
+    // Strings containing embedded NULs always go through AString to
+    // preserve their length.
+    item->mIsInlineString =
+        size <= kMaxInlineStringLength && memchr(s, '\0', size) == NULL;
+
+    if (item->mIsInlineString) {
+        memcpy(item->u.inlineStringValue, s, size);
+        item->u.inlineStringValue[size] = '\0';
+    } else {
+        item->u.stringValue = new AString(s, size);
+    }
 }
 
 void AMessage::setObjectInternal(
@@ -200,7 +301,11 @@ void AMessage::setRect(
 bool AMessage::findString(const char *name, AString *value) const {
     const Item *item = findItem(name, kTypeString);
     if (item) {
-        *value = *item->u.stringValue;
+        if (item->mIsInlineString) {
+            value->setTo(item->u.inlineStringValue);
+        } else {
+            *value = *item->u.stringValue;
+        }
         return true;
     }
     return false;
@@ -288,8 +393,13 @@ sp<AMessage> AMessage::dup() const {
         switch (from->mType) {
             case kTypeString:
             {
-                to->u.stringValue =
-                    new AString(*from->u.stringValue);
+                to->mIsInlineString = from->mIsInlineString;
+
+                if (from->mIsInlineString) {
+                    to->u = from->u;
+                } else {
+                    to->u.stringValue = new AString(*from->u.stringValue);
+                }
                 break;
             }
 
@@ -393,7 +503,7 @@ AString AMessage::debugString(int32_t indent) const {
                 tmp = StringPrintf(
                         "string %s = \"%s\"",
                         item.mName,
-                        item.u.stringValue->c_str());
+                        StringValue(item));
                 break;
             case kTypeObject:
                 tmp = StringPrintf(
@@ -493,6 +603,7 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel) {
 
             case kTypeString:
             {
+                item->mIsInlineString = false;
                 item->u.stringValue = new AString(parcel.readCString());
                 break;
             }
@@ -560,7 +671,7 @@ void AMessage::writeToParcel(Parcel *parcel) const {
 
             case kTypeString:
             {
-                parcel->writeCString(item.u.stringValue->c_str());
+                parcel->writeCString(StringValue(item));
                 break;
             }
 
@@ -8,6 +8,7 @@ LOCAL_SRC_FILES:=                 \
     AHandler.cpp                  \
     AHierarchicalStateMachine.cpp \
     ALooper.cpp                   \
+    ALooperPool.cpp               \
     ALooperRoster.cpp             \
     AMessage.cpp                  \
     AString.cpp                   \
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RATE_CONTROL_LOOKAHEAD_H_
+
+#define RATE_CONTROL_LOOKAHEAD_H_
+
+#include <OMX_Types.h>
+
+namespace android {
+
+// A pointer to this struct is passed to OMX_SetParameter when the extension
+// index for the 'OMX.google.android.index.rateControlLookahead' extension
+// is given.
+//
+// nLookaheadFrames is the number of frames the encoder analyzes before
+// choosing the QP of a frame; the output is delayed by that many frames.
+// nVBVSizeMs is the size of the coded picture buffer in milliseconds at the
+// target bitrate, 0 keeps the encoder's default. bAdaptiveQuantization
+// enables a per macroblock QP offset based on the activity of the block.
+struct RateControlLookaheadParams {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_BOOL bEnable;
+    OMX_U32 nLookaheadFrames;
+    OMX_U32 nVBVSizeMs;
+    OMX_BOOL bAdaptiveQuantization;
+};
+
+}  // namespace android
+
+#endif  // RATE_CONTROL_LOOKAHEAD_H_
@@ -40,6 +40,11 @@ struct SimpleSoftOMXComponent : public SoftOMXComponent {
 
     void onMessageReceived(const sp<AMessage> &msg);
 
+    // Whether the software components, and the OMX callback dispatchers,
+    // are run on the shared threads of ALooperPool instead of on a thread
+    // each. Enabled by the "media.stagefright.omx-shared-threads" property.
+    static bool UseSharedThreads();
+
 protected:
     struct BufferInfo {
         OMX_BUFFERHEADERTYPE *mHeader;
@@ -72,6 +77,11 @@ protected:
     virtual void onPortFlushCompleted(OMX_U32 portIndex);
     virtual void onPortEnableCompleted(OMX_U32 portIndex, bool enabled);
 
+    // Called when the component is back in the loaded state, where it may
+    // be started again on a new stream. MediaCodecPool only reuses the
+    // components it knows to implement this.
+    virtual void onReset();
+
     PortInfo *editPortInfo(OMX_U32 portIndex);
 
 private:
@@ -85,6 +95,7 @@ private:
 
     sp<ALooper> mLooper;
     sp<AHandlerReflector<SimpleSoftOMXComponent> > mHandler;
+    bool mUsesSharedLooper;
 
     OMX_STATETYPE mState;
     OMX_STATETYPE mTargetState;
@@ -20,8 +20,9 @@
 
 #include <pthread.h>
 
-#include <utils/List.h>
+#include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
+#include <utils/Vector.h>
 #include <utils/threads.h>
 
 namespace android {
@@ -30,9 +31,38 @@ struct TimedEventQueue {
 
     typedef int32_t event_id;
 
+    // Distribution of the delay between the time events were scheduled
+    // to fire at and the time they actually fired. Events posted without
+    // a specific time count as scheduled at the time they were posted.
+    struct LatencyStats {
+        LatencyStats()
+            : mNumFired(0),
+              mTotalLatencyUs(0),
+              mMinLatencyUs(0),
+              mMaxLatencyUs(0),
+              mNumLate(0) {
+        }
+
+        void add(int64_t latencyUs);
+
+        int64_t mNumFired;
+        int64_t mTotalLatencyUs;
+        int64_t mMinLatencyUs;
+        int64_t mMaxLatencyUs;
+
+        // Number of events fired more than kLateThresholdUs after their
+        // scheduled time.
+        int64_t mNumLate;
+
+        enum {
+            kLateThresholdUs = 10000
+        };
+    };
+
     struct Event : public RefBase {
         Event()
-            : mEventID(0) {
+            : mEventID(0),
+              mQueueIndex(0) {
         }
 
         virtual ~Event() {}
@@ -49,6 +79,11 @@ struct TimedEventQueue {
 
         event_id mEventID;
 
+        // Position in the queue's heap while the event is pending.
+        size_t mQueueIndex;
+
+        LatencyStats mLatencyStats;
+
         void setEventID(event_id id) {
             mEventID = id;
         }
@@ -78,7 +113,8 @@ struct TimedEventQueue {
     event_id postEventWithDelay(const sp<Event> &event, int64_t delay_us);
 
     // If the event is to be posted at a time that has already passed,
-    // it will fire as soon as possible.
+    // it will fire as soon as possible. An event object must not be posted
+    // again while it is still pending.
     event_id postTimedEvent(const sp<Event> &event, int64_t realtime_us);
 
     // Returns true iff event is currently in the queue and has been
@@ -96,10 +132,30 @@ struct TimedEventQueue {
 
     static int64_t getRealTimeUs();
 
+    // Latency statistics accumulated over all events fired so far.
+    void getLatencyStats(LatencyStats *stats) const;
+
+    // Latency statistics for all past firings of the given event object.
+    void getLatencyStats(const sp<Event> &event, LatencyStats *stats) const;
+
 private:
+    // Events due within this window fire right away instead of costing
+    // another wakeup of the queue thread, for the same reason posting an
+    // event only interrupts the thread's wait if the new event is due
+    // more than this much earlier than what the thread is waiting for.
+    enum {
+        kWakeupCoalescingWindowUs = 1000
+    };
+
     struct QueueItem {
         sp<Event> event;
         int64_t realtime_us;
+
+        // The time the event counts as scheduled at for latency purposes.
+        int64_t scheduled_us;
+
+        // Orders events posted for the same time by posting order.
+        uint32_t seq;
     };
 
     struct StopEvent : public TimedEventQueue::Event {
@@ -109,19 +165,37 @@ private:
     };
 
     pthread_t mThread;
-    List<QueueItem> mQueue;
-    Mutex mLock;
+
+    // Binary min-heap ordered by (realtime_us, seq), each pending event
+    // knows its own index into it so that it can be removed in O(log n).
+    Vector<QueueItem> mQueue;
+    KeyedVector<event_id, Event *> mEventsByID;
+    uint32_t mNextSeq;
+
+    mutable Mutex mLock;
     Condition mQueueNotEmptyCondition;
     Condition mQueueHeadChangedCondition;
     event_id mNextEventID;
 
+    // The time the queue thread is currently waiting for or -1 if it isn't
+    // waiting for any particular time.
+    int64_t mWakeupTimeUs;
+
+    LatencyStats mLatencyStats;
+
     bool mRunning;
     bool mStopped;
 
     static void *ThreadWrapper(void *me);
     void threadEntry();
 
-    sp<Event> removeEventFromQueue_l(event_id id);
+    sp<Event> removeEventFromQueue_l(event_id id, int64_t now_us);
+
+    static bool IsEarlier(const QueueItem &a, const QueueItem &b);
+    void setItem_l(size_t index, const QueueItem &item);
+    void siftUp_l(size_t index, const QueueItem &item);
+    void siftDown_l(size_t index, const QueueItem &item);
+    sp<Event> removeItemAt_l(size_t index);
 
     TimedEventQueue(const TimedEventQueue &);
     TimedEventQueue &operator=(const TimedEventQueue &);
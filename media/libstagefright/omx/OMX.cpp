@@ -23,9 +23,13 @@
 #include "../include/OMX.h"
 
 #include "../include/OMXNodeInstance.h"
+#include "../include/SimpleSoftOMXComponent.h"
 
 #include <binder/IMemory.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandlerReflector.h>
+#include <media/stagefright/foundation/ALooperPool.h>
+#include <media/stagefright/foundation/AMessage.h>
 #include <utils/threads.h>
 
 #include "OMXMaster.h"
@@ -62,20 +66,33 @@ struct OMX::CallbackDispatcher : public RefBase {
 
     bool loop();
 
+    void onMessageReceived(const sp<AMessage> &msg);
+
 protected:
     virtual ~CallbackDispatcher();
 
 private:
+    enum {
+        kWhatDrain,
+    };
+
     Mutex mLock;
 
     OMXNodeInstance *mOwner;
     bool mDone;
     Condition mQueueChanged;
-    List<omx_message> mQueue;
+
+    // Taken as a whole by the dispatching thread, the lock is only held
+    // to hand over the buffer, not while the messages are dispatched.
+    Vector<omx_message> mQueue;
 
     sp<CallbackDispatcherThread> mThread;
 
-    void dispatch(const omx_message &msg);
+    // Used instead of mThread if the dispatcher runs on ALooperPool.
+    sp<AHandlerReflector<CallbackDispatcher> > mHandler;
+    bool mDrainPending;
+
+    void dispatch(const Vector<omx_message> &messages);
 
     CallbackDispatcher(const CallbackDispatcher &);
     CallbackDispatcher &operator=(const CallbackDispatcher &);
@@ -83,12 +100,27 @@ private:
 
 OMX::CallbackDispatcher::CallbackDispatcher(OMXNodeInstance *owner)
     : mOwner(owner),
-      mDone(false) {
+      mDone(false),
+      mDrainPending(false) {
+    if (SimpleSoftOMXComponent::UseSharedThreads()) {
+        // The shared loopers run at ANDROID_PRIORITY_FOREGROUND as well.
+        mHandler = new AHandlerReflector<CallbackDispatcher>(this);
+        ALooperPool::RegisterHandler(mHandler);
+        return;
+    }
+
     mThread = new CallbackDispatcherThread(this);
     mThread->run("OMXCallbackDisp", ANDROID_PRIORITY_FOREGROUND);
 }
 
 OMX::CallbackDispatcher::~CallbackDispatcher() {
+    if (mHandler != NULL) {
+        // A drain message that is being handled holds a strong reference,
+        // later ones can no longer reach us.
+        ALooperPool::UnregisterHandler(mHandler->id());
+        return;
+    }
+
     {
         Mutex::Autolock autoLock(mLock);
 
@@ -109,25 +141,43 @@ OMX::CallbackDispatcher::~CallbackDispatcher() {
 void OMX::CallbackDispatcher::post(const omx_message &msg) {
     Mutex::Autolock autoLock(mLock);
 
-    mQueue.push_back(msg);
-    mQueueChanged.signal();
+    bool wasEmpty = mQueue.isEmpty();
+    mQueue.push(msg);
+
+    if (!wasEmpty) {
+        // Whoever consumes the queue has already been woken up and will
+        // pick this message up along with the earlier ones.
+        return;
+    }
+
+    if (mHandler == NULL) {
+        mQueueChanged.signal();
+    } else if (!mDrainPending) {
+        mDrainPending = true;
+        (new AMessage(kWhatDrain, mHandler->id()))->post();
+    }
 }
 
-void OMX::CallbackDispatcher::dispatch(const omx_message &msg) {
+void OMX::CallbackDispatcher::dispatch(const Vector<omx_message> &messages) {
     if (mOwner == NULL) {
         ALOGV("Would have dispatched a message to a node that's already gone.");
         return;
     }
-    mOwner->onMessage(msg);
+
+    if (messages.size() == 1) {
+        mOwner->onMessage(messages.itemAt(0));
+    } else {
+        mOwner->onMessages(messages);
+    }
 }
 
 bool OMX::CallbackDispatcher::loop() {
     for (;;) {
-        omx_message msg;
+        Vector<omx_message> messages;
 
         {
             Mutex::Autolock autoLock(mLock);
-            while (!mDone && mQueue.empty()) {
+            while (!mDone && mQueue.isEmpty()) {
                 mQueueChanged.wait(mLock);
             }
 
@@ -135,16 +185,35 @@ bool OMX::CallbackDispatcher::loop() {
                 break;
             }
 
-            msg = *mQueue.begin();
-            mQueue.erase(mQueue.begin());
+            // Shares the buffer instead of copying it.
+            messages = mQueue;
+            mQueue.clear();
         }
 
-        dispatch(msg);
+        dispatch(messages);
     }
 
     return false;
 }
 
+void OMX::CallbackDispatcher::onMessageReceived(const sp<AMessage> &msg) {
+    CHECK_EQ(msg->what(), (uint32_t)kWhatDrain);
+
+    Vector<omx_message> messages;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        messages = mQueue;
+        mQueue.clear();
+        mDrainPending = false;
+    }
+
+    if (!messages.isEmpty()) {
+        dispatch(messages);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool OMX::CallbackDispatcherThread::threadLoop() {
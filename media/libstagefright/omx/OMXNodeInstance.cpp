@@ -656,7 +656,7 @@ status_t OMXNodeInstance::getExtensionIndex(
     return StatusFromOMXError(err);
 }
 
-void OMXNodeInstance::onMessage(const omx_message &msg) {
+static void CopyFilledBufferFromOMX(const omx_message &msg) {
     if (msg.type == omx_message::FILL_BUFFER_DONE) {
         OMX_BUFFERHEADERTYPE *buffer =
             static_cast<OMX_BUFFERHEADERTYPE *>(
@@ -667,10 +667,22 @@ void OMXNodeInstance::onMessage(const omx_message &msg) {
 
         buffer_meta->CopyFromOMX(buffer);
     }
+}
+
+void OMXNodeInstance::onMessage(const omx_message &msg) {
+    CopyFilledBufferFromOMX(msg);
 
     mObserver->onMessage(msg);
 }
 
+void OMXNodeInstance::onMessages(const Vector<omx_message> &messages) {
+    for (size_t i = 0; i < messages.size(); ++i) {
+        CopyFilledBufferFromOMX(messages.itemAt(i));
+    }
+
+    mObserver->onMessages(messages);
+}
+
 void OMXNodeInstance::onObserverDied(OMXMaster *master) {
     ALOGE("!!! Observer died. Quickly, do something, ... anything...");
 
@@ -20,22 +20,50 @@
 
 #include "include/SimpleSoftOMXComponent.h"
 
+#include <cutils/properties.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/ALooperPool.h>
 #include <media/stagefright/foundation/AMessage.h>
 
 namespace android {
 
+static pthread_once_t gSharedThreadsOnce = PTHREAD_ONCE_INIT;
+static bool gUseSharedThreads = false;
+
+static void ReadSharedThreadsProperty() {
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get("media.stagefright.omx-shared-threads", value, NULL)
+            && (!strcmp(value, "1") || !strcasecmp(value, "true"))) {
+        gUseSharedThreads = true;
+    }
+}
+
+// static
+bool SimpleSoftOMXComponent::UseSharedThreads() {
+    pthread_once(&gSharedThreadsOnce, ReadSharedThreadsProperty);
+    return gUseSharedThreads;
+}
+
 SimpleSoftOMXComponent::SimpleSoftOMXComponent(
         const char *name,
         const OMX_CALLBACKTYPE *callbacks,
         OMX_PTR appData,
         OMX_COMPONENTTYPE **component)
     : SoftOMXComponent(name, callbacks, appData, component),
-      mLooper(new ALooper),
       mHandler(new AHandlerReflector<SimpleSoftOMXComponent>(this)),
+      mUsesSharedLooper(UseSharedThreads()),
       mState(OMX_StateLoaded),
       mTargetState(OMX_StateLoaded) {
+    if (mUsesSharedLooper) {
+        // Messages of this component are still handled one at a time and in
+        // order, interleaved with those of the other components on the same
+        // looper.
+        mLooper = ALooperPool::RegisterHandler(mHandler);
+        return;
+    }
+
+    mLooper = new ALooper;
     mLooper->setName(name);
     mLooper->registerHandler(mHandler);
 
@@ -50,6 +78,11 @@ void SimpleSoftOMXComponent::prepareForDestruction() {
     // object. Make sure those are flushed before returning so that
     // a subsequent dlunload() does not pull out the rug from under us.
 
+    if (mUsesSharedLooper) {
+        ALooperPool::UnregisterHandlerAndWait(mHandler->id());
+        return;
+    }
+
     mLooper->unregisterHandler(mHandler->id());
     mLooper->stop();
 }
@@ -581,6 +614,10 @@ void SimpleSoftOMXComponent::checkTransitions() {
         if (transitionComplete) {
             mState = mTargetState;
 
+            if (mState == OMX_StateLoaded) {
+                onReset();
+            }
+
             notify(OMX_EventCmdComplete, OMX_CommandStateSet, mState, NULL);
         }
     }
@@ -630,6 +667,9 @@ void SimpleSoftOMXComponent::onPortEnableCompleted(
         OMX_U32 portIndex, bool enabled) {
 }
 
+void SimpleSoftOMXComponent::onReset() {
+}
+
 List<SimpleSoftOMXComponent::BufferInfo *> &
 SimpleSoftOMXComponent::getPortQueue(OMX_U32 portIndex) {
     CHECK_LT(portIndex, mPorts.size());
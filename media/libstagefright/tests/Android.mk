@@ -44,6 +44,23 @@ include $(BUILD_EXECUTABLE)
 
 endif
 
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := StagefrightMediaScanner_test
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := \
+	StagefrightMediaScanner_test.cpp \
+
+LOCAL_SHARED_LIBRARIES := \
+	libmedia \
+	libstagefright \
+	libstagefright_foundation \
+	libutils \
+
+include $(BUILD_NATIVE_TEST)
+
 # Include subdirectory makefiles
 # ============================================================
 
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "StagefrightMediaScanner_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <media/stagefright/foundation/AString.h>
+#include <media/stagefright/StagefrightMediaScanner.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// Records the mime type and duration reported for every file.
+struct RecordingClient : public MediaScannerClient {
+    RecordingClient()
+        : mFailMimeTypeAt(-1) {
+    }
+
+    virtual status_t scanFile(
+            const char *path, long long lastModified,
+            long long fileSize, bool isDirectory, bool noMedia) {
+        return OK;
+    }
+
+    virtual status_t handleStringTag(const char *name, const char *value) {
+        if (!strcmp(name, "duration") && !mMimeTypes.isEmpty()) {
+            mDurations.editItemAt(mDurations.size() - 1) = value;
+        }
+        return OK;
+    }
+
+    virtual status_t setMimeType(const char *mimeType) {
+        if ((ssize_t)mMimeTypes.size() == mFailMimeTypeAt) {
+            return UNKNOWN_ERROR;
+        }
+        mMimeTypes.push(AString(mimeType));
+        mDurations.push(AString());
+        return OK;
+    }
+
+    // The client fails on the mime type of that file, -1 never fails.
+    ssize_t mFailMimeTypeAt;
+
+    Vector<AString> mMimeTypes;
+    Vector<AString> mDurations;
+};
+
+class StagefrightMediaScannerTest : public ::testing::Test {
+protected:
+    Vector<AString> mPaths;
+
+    virtual void TearDown() {
+        for (size_t i = 0; i < mPaths.size(); ++i) {
+            unlink(mPaths[i].c_str());
+        }
+    }
+
+    AString makePath(const char *name) {
+        AString path = "/data/local/tmp/StagefrightMediaScanner_test_";
+        path.append((int32_t)getpid());
+        path.append("_");
+        path.append(name);
+        mPaths.push(path);
+        return path;
+    }
+
+    // One second of 8 kHz mono silence.
+    AString writeWAV(const char *name) {
+        static const uint32_t kSampleRate = 8000;
+        static const uint32_t kDataSize = kSampleRate * 2;
+
+        uint8_t header[44];
+        memcpy(header, "RIFF", 4);
+        writeLE32(&header[4], 36 + kDataSize);
+        memcpy(&header[8], "WAVEfmt ", 8);
+        writeLE32(&header[16], 16);
+        writeLE16(&header[20], 1);              // PCM
+        writeLE16(&header[22], 1);              // channels
+        writeLE32(&header[24], kSampleRate);
+        writeLE32(&header[28], kSampleRate * 2);
+        writeLE16(&header[32], 2);              // block align
+        writeLE16(&header[34], 16);             // bits per sample
+        memcpy(&header[36], "data", 4);
+        writeLE32(&header[40], kDataSize);
+
+        AString path = makePath(name);
+        FILE *file = fopen(path.c_str(), "wb");
+        EXPECT_TRUE(file != NULL);
+        if (file != NULL) {
+            fwrite(header, 1, sizeof(header), file);
+            static const uint8_t kSilence[1024] = { 0 };
+            for (uint32_t i = 0; i < kDataSize; i += sizeof(kSilence)) {
+                fwrite(kSilence, 1, sizeof(kSilence), file);
+            }
+            fclose(file);
+        }
+        return path;
+    }
+
+    // Has a supported extension, but none of the extractors recognizes it.
+    AString writeGarbage(const char *name) {
+        AString path = makePath(name);
+        FILE *file = fopen(path.c_str(), "wb");
+        EXPECT_TRUE(file != NULL);
+        if (file != NULL) {
+            for (int i = 0; i < 4096; ++i) {
+                fputc((i * 7) & 0x7f, file);
+            }
+            fclose(file);
+        }
+        return path;
+    }
+
+    static void writeLE16(uint8_t *ptr, uint16_t x) {
+        ptr[0] = x & 0xff;
+        ptr[1] = x >> 8;
+    }
+
+    static void writeLE32(uint8_t *ptr, uint32_t x) {
+        writeLE16(ptr, x & 0xffff);
+        writeLE16(ptr + 2, x >> 16);
+    }
+};
+
+// A file that cannot be parsed in the middle of a batch is skipped, the
+// files after it are still reported.
+TEST_F(StagefrightMediaScannerTest, BadFileInBatchIsSkipped) {
+    AString good1 = writeWAV("good1.wav");
+    AString bad = writeGarbage("bad.mp3");
+    AString good2 = writeWAV("good2.wav");
+
+    const char *paths[] = { good1.c_str(), bad.c_str(), good2.c_str() };
+
+    StagefrightMediaScanner scanner;
+    RecordingClient client;
+    EXPECT_EQ(MEDIA_SCAN_RESULT_OK, scanner.processFiles(paths, 3, client));
+
+    ASSERT_EQ(2u, client.mMimeTypes.size());
+    for (size_t i = 0; i < client.mMimeTypes.size(); ++i) {
+        EXPECT_STREQ("audio/x-wav", client.mMimeTypes[i].c_str());
+        EXPECT_STREQ("1000", client.mDurations[i].c_str());
+    }
+
+    EXPECT_EQ(MEDIA_SCAN_RESULT_SKIPPED, scanner.processFile(bad.c_str(), NULL, client));
+}
+
+// A failing client still aborts the batch.
+TEST_F(StagefrightMediaScannerTest, ClientErrorAbortsBatch) {
+    AString good1 = writeWAV("good1.wav");
+    AString good2 = writeWAV("good2.wav");
+    AString good3 = writeWAV("good3.wav");
+
+    const char *paths[] = { good1.c_str(), good2.c_str(), good3.c_str() };
+
+    StagefrightMediaScanner scanner;
+    RecordingClient client;
+    client.mFailMimeTypeAt = 1;
+    EXPECT_EQ(MEDIA_SCAN_RESULT_ERROR, scanner.processFiles(paths, 3, client));
+    EXPECT_EQ(1u, client.mMimeTypes.size());
+}
+
+}  // namespace android
@@ -8,8 +8,21 @@ LOCAL_SRC_FILES:=               \
 LOCAL_SHARED_LIBRARIES :=       \
         libcutils
 
+# NEON and SSE2 row loops for YUVImage, SSE2 is used when the CPU supports it
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+    LOCAL_ARM_NEON := true
+    LOCAL_CFLAGS += -DYUV_IMAGE_NEON
+endif
+ifeq ($(TARGET_ARCH),x86)
+    LOCAL_CFLAGS += -DYUV_IMAGE_SSE2
+endif
+
 LOCAL_MODULE:= libstagefright_yuv
 
 
 
 include $(BUILD_SHARED_LIBRARY)
+
+################################################################################
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
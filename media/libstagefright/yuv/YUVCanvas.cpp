@@ -32,20 +32,14 @@ YUVCanvas::~YUVCanvas() {
 }
 
 void YUVCanvas::FillYUV(uint8_t yValue, uint8_t uValue, uint8_t vValue) {
-    for (int32_t y = 0; y < mYUVImage.height(); ++y) {
-        for (int32_t x = 0; x < mYUVImage.width(); ++x) {
-            mYUVImage.setPixelValue(x, y, yValue, uValue, vValue);
-        }
-    }
+    mYUVImage.fillRectangle(
+            Rect(mYUVImage.width(), mYUVImage.height()),
+            yValue, uValue, vValue);
 }
 
 void YUVCanvas::FillYUVRectangle(const Rect& rect,
         uint8_t yValue, uint8_t uValue, uint8_t vValue) {
-    for (int32_t y = rect.top; y < rect.bottom; ++y) {
-        for (int32_t x = rect.left; x < rect.right; ++x) {
-            mYUVImage.setPixelValue(x, y, yValue, uValue, vValue);
-        }
-    }
+    mYUVImage.fillRectangle(rect, yValue, uValue, vValue);
 }
 
 void YUVCanvas::CopyImageRect(
@@ -61,24 +55,21 @@ void YUVCanvas::CopyImageRect(
         return;
     }
 
-    int32_t srcStartX = srcRect.left;
-    int32_t srcStartY = srcRect.top;
-    for (int32_t offsetY = 0; offsetY < srcRect.height(); ++offsetY) {
-        for (int32_t offsetX = 0; offsetX < srcRect.width(); ++offsetX) {
-            int32_t srcX = srcStartX + offsetX;
-            int32_t srcY = srcStartY + offsetY;
-
-            int32_t destX = destStartX + offsetX;
-            int32_t destY = destStartY + offsetY;
-
-            uint8_t yValue;
-            uint8_t uValue;
-            uint8_t vValue;
+    // Different formats, convert a row at a time.
+    YUVImage::copyRectangle(
+            srcRect,
+            destStartX, destStartY,
+            srcImage, mYUVImage);
+}
 
-            srcImage.getPixelValue(srcX, srcY, &yValue, &uValue, &vValue);
-            mYUVImage.setPixelValue(destX, destY, yValue, uValue, vValue);
-        }
-    }
+void YUVCanvas::BlendImageRect(
+        const Rect& srcRect,
+        int32_t destStartX, int32_t destStartY,
+        const YUVImage &srcImage, uint8_t alpha) {
+    CHECK(YUVImage::blendRectangle(
+                srcRect,
+                destStartX, destStartY,
+                srcImage, mYUVImage, alpha));
 }
 
 void YUVCanvas::downsample(
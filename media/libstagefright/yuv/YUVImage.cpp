@@ -17,13 +17,190 @@
 #define LOG_NDEBUG 0
 #define LOG_TAG "YUVImage"
 
+#include <pthread.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/YUVImage.h>
 #include <ui/Rect.h>
 
+#if defined(YUV_IMAGE_NEON)
+#include <arm_neon.h>
+#elif defined(YUV_IMAGE_SSE2)
+#include <cpuid.h>
+#include <emmintrin.h>
+#endif
+
 namespace android {
 
+#if defined(YUV_IMAGE_SSE2)
+
+// The SSE2 loops are only used if the CPU supports it.
+
+static bool gCpuHasSSE2;
+static pthread_once_t gCpuFeaturesOnce = PTHREAD_ONCE_INIT;
+
+static void detectCpuFeatures() {
+    unsigned eax, ebx, ecx, edx;
+    gCpuHasSSE2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+}
+
+#endif
+
+// Row kernels used by the rectangle operations. The semi planar U/V rows
+// hold n V/U pairs starting with V.
+
+static void fillVURow(uint8_t *dst, size_t n, uint8_t vValue, uint8_t uValue) {
+    size_t i = 0;
+
+#if defined(YUV_IMAGE_NEON)
+    uint8x16x2_t vu;
+    vu.val[0] = vdupq_n_u8(vValue);
+    vu.val[1] = vdupq_n_u8(uValue);
+    for (; i + 16 <= n; i += 16) {
+        vst2q_u8(&dst[2 * i], vu);
+    }
+#elif defined(YUV_IMAGE_SSE2)
+    if (gCpuHasSSE2) {
+        __m128i vu = _mm_set1_epi16((int16_t)(vValue | (uValue << 8)));
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128((__m128i *)&dst[2 * i], vu);
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[2 * i] = vValue;
+        dst[2 * i + 1] = uValue;
+    }
+}
+
+static void interleaveVURow(
+        const uint8_t *vSrc, const uint8_t *uSrc, uint8_t *dst, size_t n) {
+    size_t i = 0;
+
+#if defined(YUV_IMAGE_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t vu;
+        vu.val[0] = vld1q_u8(&vSrc[i]);
+        vu.val[1] = vld1q_u8(&uSrc[i]);
+        vst2q_u8(&dst[2 * i], vu);
+    }
+#elif defined(YUV_IMAGE_SSE2)
+    if (gCpuHasSSE2) {
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)&vSrc[i]);
+            __m128i u = _mm_loadu_si128((const __m128i *)&uSrc[i]);
+            _mm_storeu_si128(
+                    (__m128i *)&dst[2 * i], _mm_unpacklo_epi8(v, u));
+            _mm_storeu_si128(
+                    (__m128i *)&dst[2 * i + 16], _mm_unpackhi_epi8(v, u));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[2 * i] = vSrc[i];
+        dst[2 * i + 1] = uSrc[i];
+    }
+}
+
+static void deinterleaveVURow(
+        const uint8_t *src, uint8_t *vDst, uint8_t *uDst, size_t n) {
+    size_t i = 0;
+
+#if defined(YUV_IMAGE_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t vu = vld2q_u8(&src[2 * i]);
+        vst1q_u8(&vDst[i], vu.val[0]);
+        vst1q_u8(&uDst[i], vu.val[1]);
+    }
+#elif defined(YUV_IMAGE_SSE2)
+    if (gCpuHasSSE2) {
+        const __m128i lowBytes = _mm_set1_epi16(0xff);
+        for (; i + 16 <= n; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+            __m128i b = _mm_loadu_si128((const __m128i *)&src[2 * i + 16]);
+            _mm_storeu_si128((__m128i *)&vDst[i],
+                    _mm_packus_epi16(
+                        _mm_and_si128(a, lowBytes),
+                        _mm_and_si128(b, lowBytes)));
+            _mm_storeu_si128((__m128i *)&uDst[i],
+                    _mm_packus_epi16(
+                        _mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        vDst[i] = src[2 * i];
+        uDst[i] = src[2 * i + 1];
+    }
+}
+
+// dst = (src * alpha + dst * (255 - alpha)) / 255, where x / 255 is computed
+// as (x + 128 + ((x + 128) >> 8)) >> 8, exact for 0 <= x <= 255 * 255.
+static void blendRow(
+        const uint8_t *src, uint8_t *dst, size_t n, uint8_t alpha) {
+    size_t i = 0;
+
+#if defined(YUV_IMAGE_NEON)
+    const uint8x8_t srcWeight = vdup_n_u8(alpha);
+    const uint8x8_t dstWeight = vdup_n_u8(255 - alpha);
+    const uint16x8_t half = vdupq_n_u16(128);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vld1q_u8(&src[i]);
+        uint8x16_t d = vld1q_u8(&dst[i]);
+
+        uint16x8_t lo = vmull_u8(vget_low_u8(s), srcWeight);
+        lo = vmlal_u8(lo, vget_low_u8(d), dstWeight);
+        lo = vaddq_u16(lo, half);
+
+        uint16x8_t hi = vmull_u8(vget_high_u8(s), srcWeight);
+        hi = vmlal_u8(hi, vget_high_u8(d), dstWeight);
+        hi = vaddq_u16(hi, half);
+
+        vst1q_u8(&dst[i], vcombine_u8(
+                    vaddhn_u16(lo, vshrq_n_u16(lo, 8)),
+                    vaddhn_u16(hi, vshrq_n_u16(hi, 8))));
+    }
+#elif defined(YUV_IMAGE_SSE2)
+    if (gCpuHasSSE2) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i srcWeight = _mm_set1_epi16(alpha);
+        const __m128i dstWeight = _mm_set1_epi16(255 - alpha);
+        const __m128i half = _mm_set1_epi16(128);
+        for (; i + 16 <= n; i += 16) {
+            __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+            __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+
+            __m128i lo = _mm_add_epi16(
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), srcWeight),
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), dstWeight));
+            lo = _mm_add_epi16(lo, half);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+
+            __m128i hi = _mm_add_epi16(
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), srcWeight),
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), dstWeight));
+            hi = _mm_add_epi16(hi, half);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        uint32_t x = src[i] * alpha + dst[i] * (255 - alpha) + 128;
+        dst[i] = (x + (x >> 8)) >> 8;
+    }
+}
+
 YUVImage::YUVImage(YUVFormat yuvFormat, int32_t width, int32_t height) {
+#if defined(YUV_IMAGE_SSE2)
+    pthread_once(&gCpuFeaturesOnce, detectCpuFeatures);
+#endif
+
     mYUVFormat = yuvFormat;
     mWidth = width;
     mHeight = height;
@@ -37,6 +214,10 @@ YUVImage::YUVImage(YUVFormat yuvFormat, int32_t width, int32_t height) {
 }
 
 YUVImage::YUVImage(YUVFormat yuvFormat, int32_t width, int32_t height, uint8_t *buffer) {
+#if defined(YUV_IMAGE_SSE2)
+    pthread_once(&gCpuFeaturesOnce, detectCpuFeatures);
+#endif
+
     mYUVFormat = yuvFormat;
     mWidth = width;
     mHeight = height;
@@ -364,6 +545,247 @@ bool YUVImage::fastCopyRectangle(
     return false;
 }
 
+// static
+void YUVImage::getChromaExtent(int32_t x, int32_t y,
+        int32_t width, int32_t height,
+        int32_t *chromaWidth, int32_t *chromaHeight) {
+    *chromaWidth = ((x + width - 1) >> 1) - (x >> 1) + 1;
+    *chromaHeight = ((y + height - 1) >> 1) - (y >> 1) + 1;
+}
+
+// static
+int32_t YUVImage::getSourceChromaIndex(int32_t srcStart, int32_t destStart,
+        int32_t length, int32_t chromaIndex) {
+    // The last pixel of the rectangle in this destination U/V column.
+    int32_t dest = 2 * ((destStart >> 1) + chromaIndex) + 1;
+    if (dest > destStart + length - 1) {
+        dest = destStart + length - 1;
+    }
+    return ((srcStart + dest - destStart) >> 1) - (srcStart >> 1);
+}
+
+void YUVImage::fillRectangle(const Rect& rect,
+        uint8_t yValue, uint8_t uValue, uint8_t vValue) {
+    int32_t width = rect.width();
+    int32_t height = rect.height();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    CHECK(validPixel(rect.left, rect.top));
+    CHECK(validPixel(rect.right - 1, rect.bottom - 1));
+
+    uint8_t *yAddr;
+    uint8_t *uAddr;
+    uint8_t *vAddr;
+    getYUVAddresses(rect.left, rect.top, &yAddr, &uAddr, &vAddr);
+
+    int32_t yOffsetIncrement;
+    int32_t uOffsetIncrement;
+    int32_t vOffsetIncrement;
+    getOffsetIncrementsPerDataRow(
+            &yOffsetIncrement, &uOffsetIncrement, &vOffsetIncrement);
+
+    for (int32_t offsetY = 0; offsetY < height; ++offsetY) {
+        memset(yAddr, yValue, width);
+        yAddr += yOffsetIncrement;
+    }
+
+    int32_t chromaWidth;
+    int32_t chromaHeight;
+    getChromaExtent(rect.left, rect.top, width, height,
+            &chromaWidth, &chromaHeight);
+
+    for (int32_t offsetY = 0; offsetY < chromaHeight; ++offsetY) {
+        if (mYUVFormat == YUV420Planar) {
+            memset(uAddr, uValue, chromaWidth);
+            memset(vAddr, vValue, chromaWidth);
+        } else {
+            fillVURow(vAddr, chromaWidth, vValue, uValue);
+        }
+        uAddr += uOffsetIncrement;
+        vAddr += vOffsetIncrement;
+    }
+}
+
+// static
+void YUVImage::copyRectangle(
+        const Rect& srcRect,
+        int32_t destStartX, int32_t destStartY,
+        const YUVImage &srcImage, YUVImage &destImage) {
+    int32_t width = srcRect.width();
+    int32_t height = srcRect.height();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    CHECK(srcImage.validPixel(srcRect.left, srcRect.top));
+    CHECK(srcImage.validPixel(srcRect.right - 1, srcRect.bottom - 1));
+    CHECK(destImage.validPixel(destStartX, destStartY));
+    CHECK(destImage.validPixel(
+                destStartX + width - 1, destStartY + height - 1));
+
+    uint8_t *ySrcAddr;
+    uint8_t *uSrcAddr;
+    uint8_t *vSrcAddr;
+    srcImage.getYUVAddresses(srcRect.left, srcRect.top,
+            &ySrcAddr, &uSrcAddr, &vSrcAddr);
+
+    uint8_t *yDestAddr;
+    uint8_t *uDestAddr;
+    uint8_t *vDestAddr;
+    destImage.getYUVAddresses(destStartX, destStartY,
+            &yDestAddr, &uDestAddr, &vDestAddr);
+
+    int32_t ySrcOffsetIncrement;
+    int32_t uSrcOffsetIncrement;
+    int32_t vSrcOffsetIncrement;
+    srcImage.getOffsetIncrementsPerDataRow(
+            &ySrcOffsetIncrement, &uSrcOffsetIncrement, &vSrcOffsetIncrement);
+
+    int32_t yDestOffsetIncrement;
+    int32_t uDestOffsetIncrement;
+    int32_t vDestOffsetIncrement;
+    destImage.getOffsetIncrementsPerDataRow(
+            &yDestOffsetIncrement, &uDestOffsetIncrement, &vDestOffsetIncrement);
+
+    for (int32_t offsetY = 0; offsetY < height; ++offsetY) {
+        memcpy(yDestAddr, ySrcAddr, width);
+        ySrcAddr += ySrcOffsetIncrement;
+        yDestAddr += yDestOffsetIncrement;
+    }
+
+    // Every destination U/V sample gets the value of the last pixel copied
+    // into it, like a setPixelValue() loop. If the source and destination
+    // columns have the same parity, that is the source U/V sample at the
+    // same offset and whole rows can be copied.
+    int32_t chromaWidth;
+    int32_t chromaHeight;
+    getChromaExtent(destStartX, destStartY, width, height,
+            &chromaWidth, &chromaHeight);
+
+    bool sameColumnParity = ((srcRect.left ^ destStartX) & 1) == 0;
+    int32_t uSrcStep = (srcImage.mYUVFormat == YUV420Planar) ? 1 : 2;
+    int32_t uDestStep = (destImage.mYUVFormat == YUV420Planar) ? 1 : 2;
+
+    for (int32_t offsetY = 0; offsetY < chromaHeight; ++offsetY) {
+        int32_t srcRow = getSourceChromaIndex(
+                srcRect.top, destStartY, height, offsetY);
+        const uint8_t *uSrcRow = uSrcAddr + srcRow * uSrcOffsetIncrement;
+        const uint8_t *vSrcRow = vSrcAddr + srcRow * vSrcOffsetIncrement;
+
+        if (!sameColumnParity) {
+            for (int32_t offsetX = 0; offsetX < chromaWidth; ++offsetX) {
+                int32_t srcColumn = uSrcStep * getSourceChromaIndex(
+                        srcRect.left, destStartX, width, offsetX);
+                uDestAddr[uDestStep * offsetX] = uSrcRow[srcColumn];
+                vDestAddr[uDestStep * offsetX] = vSrcRow[srcColumn];
+            }
+        } else if (srcImage.mYUVFormat == YUV420Planar) {
+            if (destImage.mYUVFormat == YUV420Planar) {
+                memcpy(uDestAddr, uSrcRow, chromaWidth);
+                memcpy(vDestAddr, vSrcRow, chromaWidth);
+            } else {
+                interleaveVURow(vSrcRow, uSrcRow, vDestAddr, chromaWidth);
+            }
+        } else {
+            if (destImage.mYUVFormat == YUV420Planar) {
+                deinterleaveVURow(vSrcRow, vDestAddr, uDestAddr, chromaWidth);
+            } else {
+                memcpy(vDestAddr, vSrcRow, 2 * chromaWidth);
+            }
+        }
+        uDestAddr += uDestOffsetIncrement;
+        vDestAddr += vDestOffsetIncrement;
+    }
+}
+
+// static
+bool YUVImage::blendRectangle(
+        const Rect& srcRect,
+        int32_t destStartX, int32_t destStartY,
+        const YUVImage &srcImage, YUVImage &destImage,
+        uint8_t alpha) {
+    if (srcImage.mYUVFormat != destImage.mYUVFormat) {
+        return false;
+    }
+
+    int32_t width = srcRect.width();
+    int32_t height = srcRect.height();
+    if (width <= 0 || height <= 0) {
+        return true;
+    }
+    CHECK(srcImage.validPixel(srcRect.left, srcRect.top));
+    CHECK(srcImage.validPixel(srcRect.right - 1, srcRect.bottom - 1));
+    CHECK(destImage.validPixel(destStartX, destStartY));
+    CHECK(destImage.validPixel(
+                destStartX + width - 1, destStartY + height - 1));
+
+    uint8_t *ySrcAddr;
+    uint8_t *uSrcAddr;
+    uint8_t *vSrcAddr;
+    srcImage.getYUVAddresses(srcRect.left, srcRect.top,
+            &ySrcAddr, &uSrcAddr, &vSrcAddr);
+
+    uint8_t *yDestAddr;
+    uint8_t *uDestAddr;
+    uint8_t *vDestAddr;
+    destImage.getYUVAddresses(destStartX, destStartY,
+            &yDestAddr, &uDestAddr, &vDestAddr);
+
+    int32_t ySrcOffsetIncrement;
+    int32_t uSrcOffsetIncrement;
+    int32_t vSrcOffsetIncrement;
+    srcImage.getOffsetIncrementsPerDataRow(
+            &ySrcOffsetIncrement, &uSrcOffsetIncrement, &vSrcOffsetIncrement);
+
+    int32_t yDestOffsetIncrement;
+    int32_t uDestOffsetIncrement;
+    int32_t vDestOffsetIncrement;
+    destImage.getOffsetIncrementsPerDataRow(
+            &yDestOffsetIncrement, &uDestOffsetIncrement, &vDestOffsetIncrement);
+
+    for (int32_t offsetY = 0; offsetY < height; ++offsetY) {
+        blendRow(ySrcAddr, yDestAddr, width, alpha);
+        ySrcAddr += ySrcOffsetIncrement;
+        yDestAddr += yDestOffsetIncrement;
+    }
+
+    // The source U/V samples are picked as in copyRectangle().
+    int32_t chromaWidth;
+    int32_t chromaHeight;
+    getChromaExtent(destStartX, destStartY, width, height,
+            &chromaWidth, &chromaHeight);
+
+    bool sameColumnParity = ((srcRect.left ^ destStartX) & 1) == 0;
+    int32_t uStep = (srcImage.mYUVFormat == YUV420Planar) ? 1 : 2;
+
+    for (int32_t offsetY = 0; offsetY < chromaHeight; ++offsetY) {
+        int32_t srcRow = getSourceChromaIndex(
+                srcRect.top, destStartY, height, offsetY);
+        const uint8_t *uSrcRow = uSrcAddr + srcRow * uSrcOffsetIncrement;
+        const uint8_t *vSrcRow = vSrcAddr + srcRow * vSrcOffsetIncrement;
+
+        if (!sameColumnParity) {
+            for (int32_t offsetX = 0; offsetX < chromaWidth; ++offsetX) {
+                int32_t srcColumn = uStep * getSourceChromaIndex(
+                        srcRect.left, destStartX, width, offsetX);
+                blendRow(&uSrcRow[srcColumn], &uDestAddr[uStep * offsetX],
+                        1, alpha);
+                blendRow(&vSrcRow[srcColumn], &vDestAddr[uStep * offsetX],
+                        1, alpha);
+            }
+        } else if (srcImage.mYUVFormat == YUV420Planar) {
+            blendRow(uSrcRow, uDestAddr, chromaWidth, alpha);
+            blendRow(vSrcRow, vDestAddr, chromaWidth, alpha);
+        } else {
+            blendRow(vSrcRow, vDestAddr, 2 * chromaWidth, alpha);
+        }
+        uDestAddr += uDestOffsetIncrement;
+        vDestAddr += vDestOffsetIncrement;
+    }
+
+    return true;
+}
+
 uint8_t clamp(uint8_t v, uint8_t minValue, uint8_t maxValue) {
     CHECK(maxValue >= minValue);
 
@@ -0,0 +1,25 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ================================================================
+# Unit tests for libstagefright_yuv
+# ================================================================
+
+# ================================================================
+# Compares the YUVImage rectangle operations with per pixel loops
+# ================================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := YUVImage_test
+
+LOCAL_MODULE_TAGS := eng tests
+
+LOCAL_SRC_FILES := YUVImage_test.cpp
+
+LOCAL_C_INCLUDES := \
+	$(TOP)/frameworks/av/include
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_yuv \
+	libutils
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <media/stagefright/YUVCanvas.h>
+#include <media/stagefright/YUVImage.h>
+#include <ui/Rect.h>
+
+namespace android {
+
+static const int32_t kWidth = 176;
+static const int32_t kHeight = 144;
+
+static const YUVImage::YUVFormat kFormats[] = {
+    YUVImage::YUV420Planar,
+    YUVImage::YUV420SemiPlanar,
+};
+
+// Rectangles wide enough for the vector loops and their tails, at even and
+// odd coordinates.
+static const Rect kRects[] = {
+    Rect(0, 0, kWidth, kHeight),
+    Rect(2, 4, 98, 70),
+    Rect(1, 3, 70, 100),
+    Rect(16, 8, 51, 9),
+    Rect(5, 7, 6, 8),
+};
+
+// Destination offsets keeping and changing the parity of the source
+// coordinates, a destination U/V sample then covers pixels of two source
+// U/V samples.
+static const int32_t kDestOffsets[][2] = {
+    { 6, 10 },
+    { 7, 10 },
+    { 6, 11 },
+    { 7, 11 },
+};
+
+static void randomize(YUVImage *image) {
+    for (int32_t y = 0; y < image->height(); ++y) {
+        for (int32_t x = 0; x < image->width(); ++x) {
+            image->setPixelValue(x, y, rand(), rand(), rand());
+        }
+    }
+}
+
+static void expectSamePixels(const YUVImage &a, const YUVImage &b) {
+    for (int32_t y = 0; y < a.height(); ++y) {
+        for (int32_t x = 0; x < a.width(); ++x) {
+            uint8_t aY, aU, aV, bY, bU, bV;
+            a.getPixelValue(x, y, &aY, &aU, &aV);
+            b.getPixelValue(x, y, &bY, &bU, &bV);
+            ASSERT_EQ(aY, bY) << "at " << x << ", " << y;
+            ASSERT_EQ(aU, bU) << "at " << x << ", " << y;
+            ASSERT_EQ(aV, bV) << "at " << x << ", " << y;
+        }
+    }
+}
+
+static uint8_t blend(uint8_t src, uint8_t dest, uint8_t alpha) {
+    return (src * alpha + dest * (255 - alpha) + 127) / 255;
+}
+
+TEST(YUVImageTest, FillMatchesSetPixelValue) {
+    for (size_t f = 0; f < sizeof(kFormats) / sizeof(kFormats[0]); ++f) {
+        for (size_t r = 0; r < sizeof(kRects) / sizeof(kRects[0]); ++r) {
+            const Rect &rect = kRects[r];
+
+            YUVImage image(kFormats[f], kWidth, kHeight);
+            randomize(&image);
+
+            YUVImage expected(kFormats[f], kWidth, kHeight);
+            YUVImage::copyRectangle(
+                    Rect(kWidth, kHeight), 0, 0, image, expected);
+
+            for (int32_t y = rect.top; y < rect.bottom; ++y) {
+                for (int32_t x = rect.left; x < rect.right; ++x) {
+                    expected.setPixelValue(x, y, 16, 200, 40);
+                }
+            }
+
+            YUVCanvas(image).FillYUVRectangle(rect, 16, 200, 40);
+
+            expectSamePixels(expected, image);
+        }
+    }
+}
+
+TEST(YUVImageTest, CopyMatchesPerPixelCopy) {
+    static const size_t kNumFormats = sizeof(kFormats) / sizeof(kFormats[0]);
+    static const size_t kNumRects = sizeof(kRects) / sizeof(kRects[0]);
+    static const size_t kNumOffsets =
+        sizeof(kDestOffsets) / sizeof(kDestOffsets[0]);
+
+    for (size_t i = 0; i < kNumFormats * kNumFormats * kNumOffsets; ++i) {
+        YUVImage::YUVFormat srcFormat = kFormats[i % kNumFormats];
+        YUVImage::YUVFormat destFormat =
+            kFormats[i / kNumFormats % kNumFormats];
+        const int32_t *offset = kDestOffsets[i / kNumFormats / kNumFormats];
+
+        for (size_t r = 1; r < kNumRects; ++r) {
+            const Rect &rect = kRects[r];
+            int32_t destX = rect.left + offset[0];
+            int32_t destY = rect.top + offset[1];
+
+            YUVImage src(srcFormat, kWidth, kHeight);
+            randomize(&src);
+
+            YUVImage dest(destFormat, kWidth, kHeight);
+            randomize(&dest);
+
+            YUVImage expected(destFormat, kWidth, kHeight);
+            YUVImage::copyRectangle(
+                    Rect(kWidth, kHeight), 0, 0, dest, expected);
+
+            for (int32_t y = 0; y < rect.height(); ++y) {
+                for (int32_t x = 0; x < rect.width(); ++x) {
+                    uint8_t Y, U, V;
+                    src.getPixelValue(rect.left + x, rect.top + y, &Y, &U, &V);
+                    expected.setPixelValue(destX + x, destY + y, Y, U, V);
+                }
+            }
+
+            YUVImage::copyRectangle(rect, destX, destY, src, dest);
+
+            expectSamePixels(expected, dest);
+        }
+    }
+}
+
+TEST(YUVImageTest, BlendMatchesPerPixelBlend) {
+    static const uint8_t kAlphas[] = { 0, 1, 77, 128, 254, 255 };
+    static const size_t kNumFormats = sizeof(kFormats) / sizeof(kFormats[0]);
+    static const size_t kNumRects = sizeof(kRects) / sizeof(kRects[0]);
+    static const size_t kNumOffsets =
+        sizeof(kDestOffsets) / sizeof(kDestOffsets[0]);
+
+    for (size_t i = 0; i < kNumFormats * kNumOffsets; ++i) {
+        YUVImage::YUVFormat format = kFormats[i % kNumFormats];
+        const int32_t *offset = kDestOffsets[i / kNumFormats];
+
+        for (size_t a = 0; a < sizeof(kAlphas) / sizeof(kAlphas[0]); ++a) {
+            for (size_t r = 1; r < kNumRects; ++r) {
+                const Rect &rect = kRects[r];
+                int32_t destX = rect.left + offset[0];
+                int32_t destY = rect.top + offset[1];
+                uint8_t alpha = kAlphas[a];
+
+                YUVImage src(format, kWidth, kHeight);
+                randomize(&src);
+
+                YUVImage dest(format, kWidth, kHeight);
+                randomize(&dest);
+
+                YUVImage expected(format, kWidth, kHeight);
+                YUVImage::copyRectangle(
+                        Rect(kWidth, kHeight), 0, 0, dest, expected);
+
+                // Blend every U/V sample once, against the original target.
+                for (int32_t y = 0; y < rect.height(); ++y) {
+                    for (int32_t x = 0; x < rect.width(); ++x) {
+                        uint8_t sY, sU, sV, dY, dU, dV;
+                        src.getPixelValue(
+                                rect.left + x, rect.top + y, &sY, &sU, &sV);
+                        dest.getPixelValue(
+                                destX + x, destY + y, &dY, &dU, &dV);
+                        expected.setPixelValue(destX + x, destY + y,
+                                blend(sY, dY, alpha),
+                                blend(sU, dU, alpha),
+                                blend(sV, dV, alpha));
+                    }
+                }
+
+                YUVCanvas(dest).BlendImageRect(
+                        rect, destX, destY, src, alpha);
+
+                expectSamePixels(expected, dest);
+            }
+        }
+    }
+}
+
+TEST(YUVImageTest, ConversionRoundTrips) {
+    YUVImage planar(YUVImage::YUV420Planar, kWidth, kHeight);
+    randomize(&planar);
+
+    YUVImage semiPlanar(YUVImage::YUV420SemiPlanar, kWidth, kHeight);
+    YUVCanvas(semiPlanar).CopyImageRect(
+            Rect(kWidth, kHeight), 0, 0, planar);
+
+    YUVImage result(YUVImage::YUV420Planar, kWidth, kHeight);
+    YUVCanvas(result).CopyImageRect(
+            Rect(kWidth, kHeight), 0, 0, semiPlanar);
+
+    expectSamePixels(planar, semiPlanar);
+    expectSamePixels(planar, result);
+}
+
+}  // namespace android